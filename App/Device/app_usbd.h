@@ -107,6 +107,26 @@
 #define  APP_CFG_USBD_VENDOR_ECHO_ASYNC_EN      DEF_DISABLED
 #endif
 
+#ifndef  APP_CFG_USBD_VENDOR_BENCH_EN
+#define  APP_CFG_USBD_VENDOR_BENCH_EN           DEF_DISABLED
+#endif
+
+#ifndef  APP_CFG_USBD_VENDOR_BENCH_BUF_LEN
+#define  APP_CFG_USBD_VENDOR_BENCH_BUF_LEN             16384u
+#endif
+
+#ifndef  APP_CFG_USBD_VENDOR_BENCH_QUEUE_MAX
+#define  APP_CFG_USBD_VENDOR_BENCH_QUEUE_MAX               4u
+#endif
+
+#ifndef  APP_CFG_USBD_VENDOR_CAPTURE_EN
+#define  APP_CFG_USBD_VENDOR_CAPTURE_EN         DEF_DISABLED
+#endif
+
+#ifndef  APP_CFG_USBD_VENDOR_CAPTURE_BUF_LEN
+#define  APP_CFG_USBD_VENDOR_CAPTURE_BUF_LEN             512u
+#endif
+
 #ifndef  APP_CFG_USBD_PHDC_EN
 #define  APP_CFG_USBD_PHDC_EN                   DEF_DISABLED
 #endif
@@ -214,6 +234,20 @@ CPU_BOOLEAN  App_USBD_Vendor_Init (CPU_INT08U  dev_nbr,
                                    CPU_INT08U  cfg_fs);
 #endif
 
+#if ((APP_CFG_USBD_VENDOR_EN       == DEF_ENABLED) && \
+     (APP_CFG_USBD_VENDOR_BENCH_EN == DEF_ENABLED))
+CPU_BOOLEAN  App_USBD_VendorBench_Init(CPU_INT08U  dev_nbr,
+                                       CPU_INT08U  cfg_hs,
+                                       CPU_INT08U  cfg_fs);
+#endif
+
+#if ((APP_CFG_USBD_VENDOR_EN         == DEF_ENABLED) && \
+     (APP_CFG_USBD_VENDOR_CAPTURE_EN == DEF_ENABLED))
+CPU_BOOLEAN  App_USBD_VendorCapture_Init(CPU_INT08U  dev_nbr,
+                                         CPU_INT08U  cfg_hs,
+                                         CPU_INT08U  cfg_fs);
+#endif
+
 #if (APP_CFG_USBD_PHDC_EN == DEF_ENABLED)
 CPU_BOOLEAN  App_USBD_PHDC_Init   (CPU_INT08U  dev_nbr,
                                    CPU_INT08U  cfg_hs,
@@ -360,12 +394,22 @@ CPU_BOOLEAN  App_USBD_Audio_Init  (CPU_INT08U  dev_nbr,
         (APP_CFG_USBD_VENDOR_ECHO_ASYNC_EN != DEF_DISABLED))
 #error  "APP_CFG_USBD_VENDOR_ECHO_ASYNC_EN    illegally #defined in 'app_cfg.h'  "
 #error  "                              [MUST be DEF_ENABLED or DEF_DISABLED]     "
+#elif  ((APP_CFG_USBD_VENDOR_BENCH_EN != DEF_ENABLED ) && \
+        (APP_CFG_USBD_VENDOR_BENCH_EN != DEF_DISABLED))
+#error  "APP_CFG_USBD_VENDOR_BENCH_EN         illegally #defined in 'app_cfg.h'  "
+#error  "                              [MUST be DEF_ENABLED or DEF_DISABLED]     "
+#elif  ((APP_CFG_USBD_VENDOR_CAPTURE_EN != DEF_ENABLED ) && \
+        (APP_CFG_USBD_VENDOR_CAPTURE_EN != DEF_DISABLED))
+#error  "APP_CFG_USBD_VENDOR_CAPTURE_EN       illegally #defined in 'app_cfg.h'  "
+#error  "                              [MUST be DEF_ENABLED or DEF_DISABLED]     "
 #endif
 
 #if     (APP_CFG_USBD_VENDOR_EN == DEF_ENABLED)
 
 #if    ((APP_CFG_USBD_VENDOR_ECHO_SYNC_EN  == DEF_ENABLED) || \
-        (APP_CFG_USBD_VENDOR_ECHO_ASYNC_EN == DEF_ENABLED))
+        (APP_CFG_USBD_VENDOR_ECHO_ASYNC_EN == DEF_ENABLED) || \
+        (APP_CFG_USBD_VENDOR_BENCH_EN      == DEF_ENABLED) || \
+        (APP_CFG_USBD_VENDOR_CAPTURE_EN    == DEF_ENABLED))
 #ifndef  APP_CFG_USBD_VENDOR_TASK_STK_SIZE
 #error  "APP_CFG_USBD_VENDOR_TASK_STK_SIZE          not #defined in 'app_cfg.h'  "
 #error  "                              [MUST be > 0u ]                           "
@@ -386,6 +430,20 @@ CPU_BOOLEAN  App_USBD_Audio_Init  (CPU_INT08U  dev_nbr,
 #endif
 #endif
 
+#if     (APP_CFG_USBD_VENDOR_BENCH_EN == DEF_ENABLED)
+#ifndef  APP_CFG_USBD_VENDOR_BENCH_TASK_PRIO
+#error  "APP_CFG_USBD_VENDOR_BENCH_TASK_PRIO        not #defined in 'app_cfg.h'  "
+#error  "                              [MUST be > 0u ]                           "
+#endif
+#endif
+
+#if     (APP_CFG_USBD_VENDOR_CAPTURE_EN == DEF_ENABLED)
+#ifndef  APP_CFG_USBD_VENDOR_CAPTURE_TASK_PRIO
+#error  "APP_CFG_USBD_VENDOR_CAPTURE_TASK_PRIO      not #defined in 'app_cfg.h'  "
+#error  "                              [MUST be > 0u ]                           "
+#endif
+#endif
+
 #endif
 
 
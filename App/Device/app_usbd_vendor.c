@@ -202,6 +202,10 @@ CPU_BOOLEAN  App_USBD_Vendor_Init (CPU_INT08U  dev_nbr,
     USBD_ERR    err_hs;
     USBD_ERR    err_fs;
     CPU_INT08U  class_nbr_0;
+#if ((APP_CFG_USBD_VENDOR_BENCH_EN   == DEF_ENABLED) || \
+     (APP_CFG_USBD_VENDOR_CAPTURE_EN == DEF_ENABLED))
+    CPU_BOOLEAN ok;
+#endif
 #if ((APP_CFG_USBD_VENDOR_ECHO_SYNC_EN  == DEF_ENABLED) || \
      (APP_CFG_USBD_VENDOR_ECHO_ASYNC_EN == DEF_ENABLED))
     OS_ERR      os_err;
@@ -449,6 +453,26 @@ CPU_BOOLEAN  App_USBD_Vendor_Init (CPU_INT08U  dev_nbr,
 #endif
 #endif
 
+#if (APP_CFG_USBD_VENDOR_BENCH_EN == DEF_ENABLED)
+    ok = App_USBD_VendorBench_Init(dev_nbr,                     /* Add benchmark interface.                             */
+                                   cfg_hs,
+                                   cfg_fs);
+    if (ok != DEF_OK) {
+        APP_TRACE_DBG(("        ... could not initialize Vendor benchmark\r\n\r\n"));
+        return (DEF_FAIL);
+    }
+#endif
+
+#if (APP_CFG_USBD_VENDOR_CAPTURE_EN == DEF_ENABLED)
+    ok = App_USBD_VendorCapture_Init(dev_nbr,                   /* Add traffic capture interface.                       */
+                                     cfg_hs,
+                                     cfg_fs);
+    if (ok != DEF_OK) {
+        APP_TRACE_DBG(("        ... could not initialize Vendor traffic capture\r\n\r\n"));
+        return (DEF_FAIL);
+    }
+#endif
+
     return (DEF_OK);
 }
 
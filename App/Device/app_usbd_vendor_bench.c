@@ -0,0 +1,1106 @@
+/*
+*********************************************************************************************************
+*                                            EXAMPLE CODE
+*
+*               This file is provided as an example on how to use Micrium products.
+*
+*               Please feel free to use any application code labeled as 'EXAMPLE CODE' in
+*               your application products.  Example code may be used as is, in whole or in
+*               part, or may be used as a reference only. This file can be modified as
+*               required to meet the end-product requirements.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*
+*                               USB DEVICE VENDOR CLASS BENCHMARK APPLICATION
+*
+*                                              TEMPLATE
+*
+* Filename : app_usbd_vendor_bench.c
+* Version  : V4.06.01
+*********************************************************************************************************
+* Note(s)  : (1) This application adds a Vendor class interface, with bulk and interrupt endpoints, that
+*                sinks, sources or loops back data on request of the host benchmark program
+*                'App/Host/app_vendor_bench_host.c'.
+*
+*            (2) The host drives each benchmark run with the following vendor requests, sent to the
+*                benchmark interface (all multi-octet fields are little-endian) :
+*
+*                (a) BENCH_INFO   (IN,  12 octets) : 'U', 'B', protocol version, USBD_CFG_MAX_NBR_URB_EXTRA,
+*                                                    maximum queue depth, interrupt endpoints flag,
+*                                                    2 reserved octets, maximum transfer length (4).
+*
+*                (b) BENCH_START  (OUT, 12 octets) : API (0 = sync, 1 = async), endpoint type (0 = bulk,
+*                                                    1 = interrupt), direction (0 = OUT sink, 1 = IN
+*                                                    source, 2 = loopback), queue depth, transfer
+*                                                    length (4), number of transfers (4, 0 = until
+*                                                    BENCH_STOP).
+*
+*                (c) BENCH_STOP   (no data)        : End the run after the transfers in progress.
+*
+*                (d) BENCH_RESULT (IN,  16 octets) : Run in progress flag, 3 reserved octets, number of
+*                                                    completed transfers (4), number of errors (4),
+*                                                    number of payload octets moved (4, modulo 2^32).
+*
+*            (3) The host measures throughput and completion latency. The device only counts transfers
+*                and errors, so that the measurement does not disturb the stack under test.
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#include  <app_usbd.h>
+
+#if (APP_CFG_USBD_EN              == DEF_ENABLED) && \
+    (APP_CFG_USBD_VENDOR_EN       == DEF_ENABLED) && \
+    (APP_CFG_USBD_VENDOR_BENCH_EN == DEF_ENABLED)
+
+#include  <Class/Vendor/usbd_vendor.h>
+#include  <Source/os.h>
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#ifndef OS_VERSION
+#error "OS_VERSION must be #define'd."
+#endif
+
+#if    (OS_VERSION > 30000u)
+#define  APP_USBD_VENDOR_BENCH_OS_III_EN            DEF_ENABLED
+#else
+#define  APP_USBD_VENDOR_BENCH_OS_III_EN            DEF_DISABLED
+#endif
+
+#define  APP_USBD_VENDOR_BENCH_TIMEOUT_MS                5000u
+#define  APP_USBD_VENDOR_BENCH_INTR_INTERVAL                1u
+
+#define  APP_USBD_VENDOR_BENCH_PROTOCOL_VER                 1u
+
+                                                                /* ------------ VENDOR REQUESTS (see Note #2) --------- */
+#define  APP_USBD_VENDOR_BENCH_REQ_INFO                  0x10u
+#define  APP_USBD_VENDOR_BENCH_REQ_START                 0x11u
+#define  APP_USBD_VENDOR_BENCH_REQ_STOP                  0x12u
+#define  APP_USBD_VENDOR_BENCH_REQ_RESULT                0x13u
+
+#define  APP_USBD_VENDOR_BENCH_INFO_LEN                    12u
+#define  APP_USBD_VENDOR_BENCH_START_LEN                   12u
+#define  APP_USBD_VENDOR_BENCH_RESULT_LEN                  16u
+#define  APP_USBD_VENDOR_BENCH_REQ_BUF_LEN                 16u
+
+#define  APP_USBD_VENDOR_BENCH_API_SYNC                     0u
+#define  APP_USBD_VENDOR_BENCH_API_ASYNC                    1u
+
+#define  APP_USBD_VENDOR_BENCH_EP_BULK                      0u
+#define  APP_USBD_VENDOR_BENCH_EP_INTR                      1u
+
+#define  APP_USBD_VENDOR_BENCH_DIR_OUT                      0u  /* Host to dev, dev sinks data.                         */
+#define  APP_USBD_VENDOR_BENCH_DIR_IN                       1u  /* Dev to host, dev sources data.                       */
+#define  APP_USBD_VENDOR_BENCH_DIR_LOOP                     2u  /* Dev sends back each OUT xfer.                        */
+
+
+/*
+*********************************************************************************************************
+*                                           LOCAL CONSTANTS
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_MS_OS_DESC_EN == DEF_ENABLED)
+static  const  CPU_INT08U  App_USBD_VendorBench_MS_PropertyNameGUID[] = {
+    'D', 0u, 'e', 0u, 'v', 0u, 'i', 0u, 'c', 0u, 'e', 0u,
+    'I', 0u, 'n', 0u, 't', 0u, 'e', 0u, 'r', 0u, 'f', 0u, 'a', 0u, 'c', 0u, 'e', 0u,
+    'G', 0u, 'U', 0u, 'I', 0u, 'D', 0u, 0u,  0u
+};
+
+static  const  CPU_INT08U  App_USBD_VendorBench_MS_GUID[] = {
+    '{', 0u, '5', 0u, 'A', 0u, '8', 0u, 'C', 0u, '3', 0u, 'E', 0u, '1', 0u, '7', 0u,
+    '-', 0u, '2', 0u, 'F', 0u, '4', 0u, 'B', 0u, '-', 0u, '4', 0u, '9', 0u, 'D', 0u, '0', 0u,
+    '-', 0u, '8', 0u, 'B', 0u, '6', 0u, '1', 0u,
+    '-', 0u, '3', 0u, 'C', 0u, '7', 0u, 'E', 0u, '9', 0u, 'A', 0u, '0', 0u, '4', 0u, 'D', 0u, '2', 0u, '5', 0u, 'B', 0u,  '}', 0u, 0u, 0u
+};
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+typedef  struct  app_usbd_vendor_bench {
+    CPU_INT08U    ClassNbr;                                     /* Vendor class instance nbr.                           */
+
+    CPU_INT08U    API;                                          /* Parameters of current run.                           */
+    CPU_INT08U    EP_Type;
+    CPU_INT08U    Dir;
+    CPU_INT08U    QueueDepth;
+    CPU_INT32U    XferLen;
+    CPU_INT32U    XferNbr;                                      /* Nbr of xfers to run, 0 if until stop req.            */
+
+    CPU_BOOLEAN   Run;                                          /* Run in progress.                                     */
+    CPU_BOOLEAN   StopReq;                                      /* Host requested end of run.                           */
+    CPU_INT32U    XferStartCnt;                                 /* Nbr of xfers started.                                */
+    CPU_INT32U    XferCmplCnt;                                  /* Nbr of xfers completed.                              */
+    CPU_INT32U    ErrCnt;                                       /* Nbr of failed xfers.                                 */
+    CPU_INT32U    OctetCnt;                                     /* Nbr of payload octets moved.                         */
+    CPU_INT08U    PendNbr;                                      /* Nbr of async xfers in progress.                      */
+
+    CPU_INT08U   *BufTbl[APP_CFG_USBD_VENDOR_BENCH_QUEUE_MAX];  /* One buf per queued xfer.                             */
+    CPU_INT08U   *ReqBufPtr;                                    /* Buf for vendor req data stage.                       */
+} APP_USBD_VENDOR_BENCH;
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL TABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                       LOCAL GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+static  APP_USBD_VENDOR_BENCH   App_USBD_VendorBench;
+
+#if (APP_USBD_VENDOR_BENCH_OS_III_EN == DEF_ENABLED)
+static  OS_TCB                  App_USBD_VendorBench_TaskTCB;
+static  OS_SEM                  App_USBD_VendorBench_StartSem;
+static  OS_SEM                  App_USBD_VendorBench_DoneSem;
+#else
+static  OS_EVENT               *App_USBD_VendorBench_StartSemPtr;
+static  OS_EVENT               *App_USBD_VendorBench_DoneSemPtr;
+#endif
+static  CPU_STK                 App_USBD_VendorBench_TaskStk[APP_CFG_USBD_VENDOR_TASK_STK_SIZE];
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  CPU_BOOLEAN  App_USBD_VendorBench_VendorReq(       CPU_INT08U              class_nbr,
+                                                           CPU_INT08U              dev_nbr,
+                                                    const  USBD_SETUP_REQ         *p_setup_req);
+
+static  void         App_USBD_VendorBench_Task     (       void                   *p_arg);
+
+static  void         App_USBD_VendorBench_SyncRun  (       APP_USBD_VENDOR_BENCH  *p_bench);
+
+static  void         App_USBD_VendorBench_AsyncRun (       APP_USBD_VENDOR_BENCH  *p_bench);
+
+static  CPU_BOOLEAN  App_USBD_VendorBench_XferNext (       APP_USBD_VENDOR_BENCH  *p_bench);
+
+static  void         App_USBD_VendorBench_RxSubmit (       APP_USBD_VENDOR_BENCH  *p_bench,
+                                                           CPU_INT08U              buf_ix);
+
+static  void         App_USBD_VendorBench_TxSubmit (       APP_USBD_VENDOR_BENCH  *p_bench,
+                                                           CPU_INT08U              buf_ix,
+                                                           CPU_INT32U              xfer_len);
+
+static  void         App_USBD_VendorBench_RxCmpl   (       CPU_INT08U              class_nbr,
+                                                           void                   *p_buf,
+                                                           CPU_INT32U              buf_len,
+                                                           CPU_INT32U              xfer_len,
+                                                           void                   *p_callback_arg,
+                                                           USBD_ERR                err);
+
+static  void         App_USBD_VendorBench_TxCmpl   (       CPU_INT08U              class_nbr,
+                                                           void                   *p_buf,
+                                                           CPU_INT32U              buf_len,
+                                                           CPU_INT32U              xfer_len,
+                                                           void                   *p_callback_arg,
+                                                           USBD_ERR                err);
+
+static  void         App_USBD_VendorBench_SlotEnd  (       APP_USBD_VENDOR_BENCH  *p_bench);
+
+
+/*
+*********************************************************************************************************
+*                                     LOCAL CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+#if ((APP_CFG_USBD_VENDOR_BENCH_QUEUE_MAX < 1u) || \
+     (APP_CFG_USBD_VENDOR_BENCH_QUEUE_MAX > 255u))
+#error  "APP_CFG_USBD_VENDOR_BENCH_QUEUE_MAX  illegally #define'd in 'app_cfg.h' "
+#error  "                              [MUST be >= 1 and <= 255]                 "
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                     App_USBD_VendorBench_Init()
+*
+* Description : Add the benchmark Vendor interface to the USB device stack.
+*
+* Argument(s) : dev_nbr    Device number.
+*
+*               cfg_hs     Index of high-speed configuration to which this interface will be added to.
+*
+*               cfg_fs     Index of full-speed configuration to which this interface will be added to.
+*
+* Return(s)   : DEF_OK,    if benchmark interface successfully added.
+*
+*               DEF_FAIL,  otherwise.
+*
+* Note(s)     : (1) The Vendor class must have been initialized with USBD_Vendor_Init().
+*
+*               (2) Transfer buffers are allocated from the heap so that they follow the buffer alignment
+*                   required by the device controller.
+*********************************************************************************************************
+*/
+
+CPU_BOOLEAN  App_USBD_VendorBench_Init (CPU_INT08U  dev_nbr,
+                                        CPU_INT08U  cfg_hs,
+                                        CPU_INT08U  cfg_fs)
+{
+    APP_USBD_VENDOR_BENCH  *p_bench;
+    CPU_INT08U              buf_ix;
+    CPU_SIZE_T              reqd_octets;
+    LIB_ERR                 lib_mem_err;
+    USBD_ERR                err;
+    USBD_ERR                err_hs;
+    USBD_ERR                err_fs;
+    OS_ERR                  os_err;
+
+
+    p_bench = &App_USBD_VendorBench;
+    err_hs  =  USBD_ERR_NONE;
+    err_fs  =  USBD_ERR_NONE;
+
+    APP_TRACE_DBG(("        Initializing Vendor benchmark ... \r\n"));
+
+    Mem_Clr((void *)p_bench, sizeof(APP_USBD_VENDOR_BENCH));
+                                                                /* Alloc xfer and req bufs (see Note #2).               */
+    for (buf_ix = 0u; buf_ix < APP_CFG_USBD_VENDOR_BENCH_QUEUE_MAX; buf_ix++) {
+        p_bench->BufTbl[buf_ix] = (CPU_INT08U *)Mem_HeapAlloc(APP_CFG_USBD_VENDOR_BENCH_BUF_LEN,
+                                                              USBD_CFG_BUF_ALIGN_OCTETS,
+                                                             &reqd_octets,
+                                                             &lib_mem_err);
+        if (lib_mem_err != LIB_MEM_ERR_NONE) {
+            APP_TRACE_DBG(("        ... could not allocate Vendor benchmark buffers w/err = %d\r\n\r\n", lib_mem_err));
+            return (DEF_FAIL);
+        }
+    }
+
+    p_bench->ReqBufPtr = (CPU_INT08U *)Mem_HeapAlloc(APP_USBD_VENDOR_BENCH_REQ_BUF_LEN,
+                                                     USBD_CFG_BUF_ALIGN_OCTETS,
+                                                    &reqd_octets,
+                                                    &lib_mem_err);
+    if (lib_mem_err != LIB_MEM_ERR_NONE) {
+        APP_TRACE_DBG(("        ... could not allocate Vendor benchmark buffers w/err = %d\r\n\r\n", lib_mem_err));
+        return (DEF_FAIL);
+    }
+                                                                /* Create a Vendor class instance with intr EPs.        */
+    p_bench->ClassNbr = USBD_Vendor_Add(DEF_TRUE,
+                                        APP_USBD_VENDOR_BENCH_INTR_INTERVAL,
+                                        App_USBD_VendorBench_VendorReq,
+                                       &err);
+    if (err != USBD_ERR_NONE) {
+        APP_TRACE_DBG(("        ... could not instantiate a Vendor benchmark class w/err = %d\r\n\r\n", err));
+        return (DEF_FAIL);
+    }
+
+    if (cfg_hs != USBD_CFG_NBR_NONE) {
+                                                                /* Add vendor class to HS dflt cfg.                     */
+        USBD_Vendor_CfgAdd(p_bench->ClassNbr, dev_nbr, cfg_hs, &err_hs);
+        if (err_hs != USBD_ERR_NONE) {
+            APP_TRACE_DBG(("        ... could not add Vendor benchmark instance #%d to HS configuration w/err = %d\r\n\r\n", p_bench->ClassNbr, err_hs));
+        }
+    }
+
+    if (cfg_fs != USBD_CFG_NBR_NONE) {
+                                                                /* Add vendor class to FS dflt cfg.                     */
+        USBD_Vendor_CfgAdd(p_bench->ClassNbr, dev_nbr, cfg_fs, &err_fs);
+        if (err_fs != USBD_ERR_NONE) {
+            APP_TRACE_DBG(("        ... could not add Vendor benchmark instance #%d to FS configuration w/err = %d\r\n\r\n", p_bench->ClassNbr, err_fs));
+        }
+    }
+
+    if ((err_hs != USBD_ERR_NONE) &&                            /* If HS and FS cfg fail, stop class init.              */
+        (err_fs != USBD_ERR_NONE)) {
+        return (DEF_FAIL);
+    }
+
+#if (USBD_CFG_MS_OS_DESC_EN == DEF_ENABLED)
+    USBD_Vendor_MS_ExtPropertyAdd(p_bench->ClassNbr,
+                                  USBD_MS_OS_PROPERTY_TYPE_REG_SZ,
+                                  App_USBD_VendorBench_MS_PropertyNameGUID,
+                                  sizeof(App_USBD_VendorBench_MS_PropertyNameGUID),
+                                  App_USBD_VendorBench_MS_GUID,
+                                  sizeof(App_USBD_VendorBench_MS_GUID),
+                                 &err);
+    if (err != USBD_ERR_NONE) {
+        APP_TRACE_DBG(("        ... could not set MS vendor GUID w/err = %d\r\n\r\n", err));
+        return (DEF_FAIL);
+    }
+#endif
+
+#if (APP_USBD_VENDOR_BENCH_OS_III_EN == DEF_ENABLED)            /* ---------------------- OS-III ---------------------- */
+    OSSemCreate(&App_USBD_VendorBench_StartSem,
+                "Vendor bench start sem",
+                 0u,
+                &os_err);
+    if (os_err != OS_ERR_NONE) {
+        APP_TRACE_DBG(("        ... could not create Vendor benchmark semaphore w/err = %d\r\n\r\n", os_err));
+        return (DEF_FAIL);
+    }
+
+    OSSemCreate(&App_USBD_VendorBench_DoneSem,
+                "Vendor bench done sem",
+                 0u,
+                &os_err);
+    if (os_err != OS_ERR_NONE) {
+        APP_TRACE_DBG(("        ... could not create Vendor benchmark semaphore w/err = %d\r\n\r\n", os_err));
+        return (DEF_FAIL);
+    }
+
+    OSTaskCreate(                 &App_USBD_VendorBench_TaskTCB,
+                                  "USB Device Vendor Benchmark",
+                                   App_USBD_VendorBench_Task,
+                 (void *)          p_bench,
+                                   APP_CFG_USBD_VENDOR_BENCH_TASK_PRIO,
+                                  &App_USBD_VendorBench_TaskStk[0],
+                                   APP_CFG_USBD_VENDOR_TASK_STK_SIZE / 10u,
+                                   APP_CFG_USBD_VENDOR_TASK_STK_SIZE,
+                                   0u,
+                                   0u,
+                 (void *)          0,
+                                   OS_OPT_TASK_STK_CHK | OS_OPT_TASK_STK_CLR,
+                                  &os_err);
+    if (os_err != OS_ERR_NONE) {
+        APP_TRACE_DBG(("        ... could not add Vendor benchmark task w/err = %d\r\n\r\n", os_err));
+        return (DEF_FAIL);
+    }
+#else                                                           /* ---------------------- OS-II ----------------------- */
+    App_USBD_VendorBench_StartSemPtr = OSSemCreate(0u);
+    App_USBD_VendorBench_DoneSemPtr  = OSSemCreate(0u);
+    if ((App_USBD_VendorBench_StartSemPtr == (OS_EVENT *)0) ||
+        (App_USBD_VendorBench_DoneSemPtr  == (OS_EVENT *)0)) {
+        APP_TRACE_DBG(("        ... could not create Vendor benchmark semaphore\r\n\r\n"));
+        return (DEF_FAIL);
+    }
+
+#if (OS_STK_GROWTH == 1u)
+    os_err = OSTaskCreateExt(                  App_USBD_VendorBench_Task,
+                             (void *)          p_bench,
+                                              &App_USBD_VendorBench_TaskStk[APP_CFG_USBD_VENDOR_TASK_STK_SIZE - 1],
+                                               APP_CFG_USBD_VENDOR_BENCH_TASK_PRIO,
+                                               APP_CFG_USBD_VENDOR_BENCH_TASK_PRIO,
+                                              &App_USBD_VendorBench_TaskStk[0],
+                                               APP_CFG_USBD_VENDOR_TASK_STK_SIZE,
+                             (void *)          0,
+                                               OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
+#else
+    os_err = OSTaskCreateExt(                  App_USBD_VendorBench_Task,
+                             (void *)          p_bench,
+                                              &App_USBD_VendorBench_TaskStk[0],
+                                               APP_CFG_USBD_VENDOR_BENCH_TASK_PRIO,
+                                               APP_CFG_USBD_VENDOR_BENCH_TASK_PRIO,
+                                              &App_USBD_VendorBench_TaskStk[APP_CFG_USBD_VENDOR_TASK_STK_SIZE - 1],
+                                               APP_CFG_USBD_VENDOR_TASK_STK_SIZE,
+                             (void *)          0,
+                                               OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
+#endif
+    if (os_err != OS_ERR_NONE) {
+        APP_TRACE_DBG(("        ... could not add Vendor benchmark task w/err = %d\r\n\r\n", os_err));
+        return (DEF_FAIL);
+    }
+#if (OS_TASK_NAME_EN > 0u)
+    OSTaskNameSet(APP_CFG_USBD_VENDOR_BENCH_TASK_PRIO, (INT8U *)"USB Device Vendor Benchmark", &os_err);
+#endif
+#endif
+
+    return (DEF_OK);
+}
+
+
+/*
+*********************************************************************************************************
+*                                  App_USBD_VendorBench_VendorReq()
+*
+* Description : Process the benchmark vendor requests (see 'app_usbd_vendor_bench.c  Note #2').
+*
+* Argument(s) : class_nbr      Class instance number.
+*
+*               dev_nbr        Device number.
+*
+*               p_setup_req    Pointer to setup request structure.
+*
+* Return(s)   : DEF_OK,        if NO error(s) occurred and request is supported.
+*
+*               DEF_FAIL,      otherwise.
+*
+* Note(s)     : (1) This callback is called from the core task. A new run is only signaled to the
+*                   benchmark task, which performs the transfers.
+*********************************************************************************************************
+*/
+
+static  CPU_BOOLEAN  App_USBD_VendorBench_VendorReq (       CPU_INT08U       class_nbr,
+                                                            CPU_INT08U       dev_nbr,
+                                                     const  USBD_SETUP_REQ  *p_setup_req)
+{
+    APP_USBD_VENDOR_BENCH  *p_bench;
+    CPU_INT08U             *p_req_buf;
+    CPU_INT32U              xfer_len;
+    CPU_INT32U              xfer_nbr;
+    CPU_BOOLEAN             valid;
+    USBD_ERR                err;
+#if (APP_USBD_VENDOR_BENCH_OS_III_EN == DEF_ENABLED)
+    OS_ERR                  os_err;
+#endif
+    CPU_SR_ALLOC();
+
+
+    (void)class_nbr;
+
+    p_bench   = &App_USBD_VendorBench;
+    p_req_buf =  p_bench->ReqBufPtr;
+    valid     =  DEF_FAIL;
+
+    switch (p_setup_req->bRequest) {
+        case APP_USBD_VENDOR_BENCH_REQ_INFO:
+             Mem_Clr((void *)p_req_buf, APP_USBD_VENDOR_BENCH_INFO_LEN);
+             p_req_buf[0u] = (CPU_INT08U)'U';
+             p_req_buf[1u] = (CPU_INT08U)'B';
+             p_req_buf[2u] =  APP_USBD_VENDOR_BENCH_PROTOCOL_VER;
+             p_req_buf[3u] =  USBD_CFG_MAX_NBR_URB_EXTRA;
+             p_req_buf[4u] =  APP_CFG_USBD_VENDOR_BENCH_QUEUE_MAX;
+             p_req_buf[5u] =  DEF_YES;                          /* Intr EPs are always present.                         */
+             MEM_VAL_SET_INT32U_LITTLE(&p_req_buf[8u], APP_CFG_USBD_VENDOR_BENCH_BUF_LEN);
+
+             (void)USBD_CtrlTx(         dev_nbr,
+                               (void *) p_req_buf,
+                                        DEF_MIN(p_setup_req->wLength, APP_USBD_VENDOR_BENCH_INFO_LEN),
+                                        APP_USBD_VENDOR_BENCH_TIMEOUT_MS,
+                                        DEF_NO,
+                                       &err);
+             if (err == USBD_ERR_NONE) {
+                 valid = DEF_OK;
+             }
+             break;
+
+
+        case APP_USBD_VENDOR_BENCH_REQ_START:
+             if (p_setup_req->wLength != APP_USBD_VENDOR_BENCH_START_LEN) {
+                 break;
+             }
+
+             (void)USBD_CtrlRx(         dev_nbr,
+                               (void *) p_req_buf,
+                                        APP_USBD_VENDOR_BENCH_START_LEN,
+                                        APP_USBD_VENDOR_BENCH_TIMEOUT_MS,
+                                       &err);
+             if (err != USBD_ERR_NONE) {
+                 break;
+             }
+
+             xfer_len = MEM_VAL_GET_INT32U_LITTLE(&p_req_buf[4u]);
+             xfer_nbr = MEM_VAL_GET_INT32U_LITTLE(&p_req_buf[8u]);
+             if ((p_req_buf[0u] >  APP_USBD_VENDOR_BENCH_API_ASYNC)     ||
+                 (p_req_buf[1u] >  APP_USBD_VENDOR_BENCH_EP_INTR)       ||
+                 (p_req_buf[2u] >  APP_USBD_VENDOR_BENCH_DIR_LOOP)      ||
+                 (p_req_buf[3u] == 0u)                                  ||
+                 (p_req_buf[3u] >  APP_CFG_USBD_VENDOR_BENCH_QUEUE_MAX) ||
+                 (xfer_len      == 0u)                                  ||
+                 (xfer_len      >  APP_CFG_USBD_VENDOR_BENCH_BUF_LEN)) {
+                 break;
+             }
+
+             CPU_CRITICAL_ENTER();
+             if (p_bench->Run == DEF_YES) {                     /* Only one run at a time.                              */
+                 CPU_CRITICAL_EXIT();
+                 break;
+             }
+             p_bench->API          = p_req_buf[0u];
+             p_bench->EP_Type      = p_req_buf[1u];
+             p_bench->Dir          = p_req_buf[2u];
+             p_bench->QueueDepth   = (p_req_buf[0u] == APP_USBD_VENDOR_BENCH_API_SYNC) ? 1u : p_req_buf[3u];
+             p_bench->XferLen      = xfer_len;
+             p_bench->XferNbr      = xfer_nbr;
+             p_bench->XferStartCnt = 0u;
+             p_bench->XferCmplCnt  = 0u;
+             p_bench->ErrCnt       = 0u;
+             p_bench->OctetCnt     = 0u;
+             p_bench->PendNbr      = 0u;
+             p_bench->StopReq      = DEF_NO;
+             p_bench->Run          = DEF_YES;
+             CPU_CRITICAL_EXIT();
+                                                                /* Signal new run to bench task (see Note #1).          */
+#if (APP_USBD_VENDOR_BENCH_OS_III_EN == DEF_ENABLED)
+             OSSemPost(&App_USBD_VendorBench_StartSem, OS_OPT_POST_1, &os_err);
+#else
+             (void)OSSemPost(App_USBD_VendorBench_StartSemPtr);
+#endif
+             valid = DEF_OK;
+             break;
+
+
+        case APP_USBD_VENDOR_BENCH_REQ_STOP:
+             CPU_CRITICAL_ENTER();
+             p_bench->StopReq = DEF_YES;
+             CPU_CRITICAL_EXIT();
+             valid = DEF_OK;
+             break;
+
+
+        case APP_USBD_VENDOR_BENCH_REQ_RESULT:
+             Mem_Clr((void *)p_req_buf, APP_USBD_VENDOR_BENCH_RESULT_LEN);
+             CPU_CRITICAL_ENTER();
+             p_req_buf[0u] = p_bench->Run;
+             MEM_VAL_SET_INT32U_LITTLE(&p_req_buf[4u],  p_bench->XferCmplCnt);
+             MEM_VAL_SET_INT32U_LITTLE(&p_req_buf[8u],  p_bench->ErrCnt);
+             MEM_VAL_SET_INT32U_LITTLE(&p_req_buf[12u], p_bench->OctetCnt);
+             CPU_CRITICAL_EXIT();
+
+             (void)USBD_CtrlTx(         dev_nbr,
+                               (void *) p_req_buf,
+                                        DEF_MIN(p_setup_req->wLength, APP_USBD_VENDOR_BENCH_RESULT_LEN),
+                                        APP_USBD_VENDOR_BENCH_TIMEOUT_MS,
+                                        DEF_NO,
+                                       &err);
+             if (err == USBD_ERR_NONE) {
+                 valid = DEF_OK;
+             }
+             break;
+
+
+        default:
+             break;
+    }
+
+    return (valid);
+}
+
+
+/*
+*********************************************************************************************************
+*                                     App_USBD_VendorBench_Task()
+*
+* Description : Execute the benchmark runs requested by the host.
+*
+* Argument(s) : p_arg    Pointer to benchmark data.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) In async mode, the task only queues the first transfers. The completion callbacks keep
+*                   the queue full until the run ends.
+*********************************************************************************************************
+*/
+
+static  void  App_USBD_VendorBench_Task (void  *p_arg)
+{
+    APP_USBD_VENDOR_BENCH  *p_bench;
+    OS_ERR                  os_err;
+    CPU_SR_ALLOC();
+
+
+    p_bench = (APP_USBD_VENDOR_BENCH *)p_arg;
+
+    APP_TRACE_DBG(("        Executing Vendor benchmark...\r\n"));
+
+    while (DEF_TRUE) {
+                                                                /* Wait for a run to be requested by host.              */
+#if (APP_USBD_VENDOR_BENCH_OS_III_EN == DEF_ENABLED)            /* ---------------------- OS-III ---------------------- */
+        (void)OSSemPend(          &App_USBD_VendorBench_StartSem,
+                                  0,
+                                  OS_OPT_PEND_BLOCKING,
+                        (CPU_TS *)0,
+                                 &os_err);
+#else                                                           /* ---------------------- OS-II ----------------------- */
+        OSSemPend(App_USBD_VendorBench_StartSemPtr, 0, &os_err);
+#endif
+
+        if (p_bench->API == APP_USBD_VENDOR_BENCH_API_SYNC) {
+            App_USBD_VendorBench_SyncRun(p_bench);
+        } else {
+            App_USBD_VendorBench_AsyncRun(p_bench);             /* See Note #1.                                         */
+        }
+
+        APP_TRACE_DBG(("        Vendor benchmark run done: %u xfers, %u errors\r\n",
+                       (unsigned int)p_bench->XferCmplCnt,
+                       (unsigned int)p_bench->ErrCnt));
+
+        CPU_CRITICAL_ENTER();
+        p_bench->Run = DEF_NO;
+        CPU_CRITICAL_EXIT();
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                   App_USBD_VendorBench_SyncRun()
+*
+* Description : Execute a run with the synchronous Vendor class API.
+*
+* Argument(s) : p_bench    Pointer to benchmark data.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) The run ends on the first error, as the host and the device no longer agree on the
+*                   number of transfers left.
+*********************************************************************************************************
+*/
+
+static  void  App_USBD_VendorBench_SyncRun (APP_USBD_VENDOR_BENCH  *p_bench)
+{
+    CPU_INT08U  *p_buf;
+    CPU_INT32U   xfer_len;
+    USBD_ERR     err;
+    CPU_SR_ALLOC();
+
+
+    p_buf = p_bench->BufTbl[0u];
+    err   = USBD_ERR_NONE;
+
+    while (App_USBD_VendorBench_XferNext(p_bench) == DEF_YES) {
+        xfer_len = p_bench->XferLen;
+                                                                /* ---------------------- OUT XFER -------------------- */
+        if (p_bench->Dir != APP_USBD_VENDOR_BENCH_DIR_IN) {
+            if (p_bench->EP_Type == APP_USBD_VENDOR_BENCH_EP_BULK) {
+                xfer_len = USBD_Vendor_Rd(        p_bench->ClassNbr,
+                                          (void *)p_buf,
+                                                  p_bench->XferLen,
+                                                  APP_USBD_VENDOR_BENCH_TIMEOUT_MS,
+                                                 &err);
+            } else {
+                xfer_len = USBD_Vendor_IntrRd(        p_bench->ClassNbr,
+                                              (void *)p_buf,
+                                                      p_bench->XferLen,
+                                                      APP_USBD_VENDOR_BENCH_TIMEOUT_MS,
+                                                     &err);
+            }
+            if (err != USBD_ERR_NONE) {
+                break;
+            }
+            CPU_CRITICAL_ENTER();
+            p_bench->OctetCnt += xfer_len;
+            CPU_CRITICAL_EXIT();
+        }
+                                                                /* ---------------------- IN XFER --------------------- */
+        if (p_bench->Dir != APP_USBD_VENDOR_BENCH_DIR_OUT) {
+            if (p_bench->EP_Type == APP_USBD_VENDOR_BENCH_EP_BULK) {
+                xfer_len = USBD_Vendor_Wr(        p_bench->ClassNbr,
+                                          (void *)p_buf,
+                                                  xfer_len,
+                                                  APP_USBD_VENDOR_BENCH_TIMEOUT_MS,
+                                                  DEF_NO,
+                                                 &err);
+            } else {
+                xfer_len = USBD_Vendor_IntrWr(        p_bench->ClassNbr,
+                                              (void *)p_buf,
+                                                      xfer_len,
+                                                      APP_USBD_VENDOR_BENCH_TIMEOUT_MS,
+                                                      DEF_NO,
+                                                     &err);
+            }
+            if (err != USBD_ERR_NONE) {
+                break;
+            }
+            CPU_CRITICAL_ENTER();
+            p_bench->OctetCnt += xfer_len;
+            CPU_CRITICAL_EXIT();
+        }
+
+        CPU_CRITICAL_ENTER();
+        p_bench->XferCmplCnt++;
+        CPU_CRITICAL_EXIT();
+    }
+
+    if (err != USBD_ERR_NONE) {                                 /* See Note #1.                                         */
+        APP_TRACE_DBG(("        ... Vendor benchmark sync run failed w/err = %d\r\n", err));
+        CPU_CRITICAL_ENTER();
+        p_bench->ErrCnt++;
+        CPU_CRITICAL_EXIT();
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                   App_USBD_VendorBench_AsyncRun()
+*
+* Description : Execute a run with the asynchronous Vendor class API.
+*
+* Argument(s) : p_bench    Pointer to benchmark data.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) The task holds one reference on the run while it queues the first transfers, so that
+*                   a transfer completing before the queue is full does not end the run early.
+*
+*               (2) A queue depth greater than USBD_CFG_MAX_NBR_URB_EXTRA + 1 may fail to be queued. Such
+*                   failures are counted as errors, and the run continues with the transfers queued.
+*********************************************************************************************************
+*/
+
+static  void  App_USBD_VendorBench_AsyncRun (APP_USBD_VENDOR_BENCH  *p_bench)
+{
+    CPU_INT08U  buf_ix;
+    OS_ERR      os_err;
+    CPU_SR_ALLOC();
+
+
+    CPU_CRITICAL_ENTER();
+    p_bench->PendNbr = 1u;                                      /* See Note #1.                                         */
+    CPU_CRITICAL_EXIT();
+
+    for (buf_ix = 0u; buf_ix < p_bench->QueueDepth; buf_ix++) {
+        if (App_USBD_VendorBench_XferNext(p_bench) == DEF_NO) {
+            break;
+        }
+
+        CPU_CRITICAL_ENTER();
+        p_bench->PendNbr++;
+        CPU_CRITICAL_EXIT();
+
+        if (p_bench->Dir == APP_USBD_VENDOR_BENCH_DIR_IN) {
+            App_USBD_VendorBench_TxSubmit(p_bench, buf_ix, p_bench->XferLen);
+        } else {
+            App_USBD_VendorBench_RxSubmit(p_bench, buf_ix);
+        }
+    }
+
+    App_USBD_VendorBench_SlotEnd(p_bench);                      /* Release task ref.                                    */
+
+                                                                /* Wait for all xfers to complete.                      */
+#if (APP_USBD_VENDOR_BENCH_OS_III_EN == DEF_ENABLED)            /* ---------------------- OS-III ---------------------- */
+    (void)OSSemPend(          &App_USBD_VendorBench_DoneSem,
+                              0,
+                              OS_OPT_PEND_BLOCKING,
+                    (CPU_TS *)0,
+                             &os_err);
+#else                                                           /* ---------------------- OS-II ----------------------- */
+    OSSemPend(App_USBD_VendorBench_DoneSemPtr, 0, &os_err);
+#endif
+}
+
+
+/*
+*********************************************************************************************************
+*                                   App_USBD_VendorBench_XferNext()
+*
+* Description : Account for the start of a new transfer, if the run is not over.
+*
+* Argument(s) : p_bench    Pointer to benchmark data.
+*
+* Return(s)   : DEF_YES, if a new transfer must be started.
+*
+*               DEF_NO,  otherwise.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  CPU_BOOLEAN  App_USBD_VendorBench_XferNext (APP_USBD_VENDOR_BENCH  *p_bench)
+{
+    CPU_BOOLEAN  next;
+    CPU_SR_ALLOC();
+
+
+    CPU_CRITICAL_ENTER();
+    next = DEF_NO;
+    if ((p_bench->StopReq == DEF_NO) &&
+        ((p_bench->XferNbr      == 0u) ||
+         (p_bench->XferStartCnt <  p_bench->XferNbr))) {
+        p_bench->XferStartCnt++;
+        next = DEF_YES;
+    }
+    CPU_CRITICAL_EXIT();
+
+    return (next);
+}
+
+
+/*
+*********************************************************************************************************
+*                                   App_USBD_VendorBench_RxSubmit()
+*
+* Description : Queue an asynchronous OUT transfer.
+*
+* Argument(s) : p_bench    Pointer to benchmark data.
+*
+*               buf_ix     Index of the buffer to receive into.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  void  App_USBD_VendorBench_RxSubmit (APP_USBD_VENDOR_BENCH  *p_bench,
+                                             CPU_INT08U              buf_ix)
+{
+    USBD_ERR  err;
+
+
+    if (p_bench->EP_Type == APP_USBD_VENDOR_BENCH_EP_BULK) {
+        USBD_Vendor_RdAsync(                  p_bench->ClassNbr,
+                            (void *)          p_bench->BufTbl[buf_ix],
+                                              p_bench->XferLen,
+                                              App_USBD_VendorBench_RxCmpl,
+                            (void *)(CPU_ADDR)buf_ix,
+                                             &err);
+    } else {
+        USBD_Vendor_IntrRdAsync(                  p_bench->ClassNbr,
+                                (void *)          p_bench->BufTbl[buf_ix],
+                                                  p_bench->XferLen,
+                                                  App_USBD_VendorBench_RxCmpl,
+                                (void *)(CPU_ADDR)buf_ix,
+                                                 &err);
+    }
+
+    if (err != USBD_ERR_NONE) {
+        App_USBD_VendorBench_SlotEnd(p_bench);
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                   App_USBD_VendorBench_TxSubmit()
+*
+* Description : Queue an asynchronous IN transfer.
+*
+* Argument(s) : p_bench    Pointer to benchmark data.
+*
+*               buf_ix     Index of the buffer to transmit.
+*
+*               xfer_len   Number of octets to transmit.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  void  App_USBD_VendorBench_TxSubmit (APP_USBD_VENDOR_BENCH  *p_bench,
+                                             CPU_INT08U              buf_ix,
+                                             CPU_INT32U              xfer_len)
+{
+    USBD_ERR  err;
+
+
+    if (p_bench->EP_Type == APP_USBD_VENDOR_BENCH_EP_BULK) {
+        USBD_Vendor_WrAsync(                  p_bench->ClassNbr,
+                            (void *)          p_bench->BufTbl[buf_ix],
+                                              xfer_len,
+                                              App_USBD_VendorBench_TxCmpl,
+                            (void *)(CPU_ADDR)buf_ix,
+                                              DEF_NO,
+                                             &err);
+    } else {
+        USBD_Vendor_IntrWrAsync(                  p_bench->ClassNbr,
+                                (void *)          p_bench->BufTbl[buf_ix],
+                                                  xfer_len,
+                                                  App_USBD_VendorBench_TxCmpl,
+                                (void *)(CPU_ADDR)buf_ix,
+                                                  DEF_NO,
+                                                 &err);
+    }
+
+    if (err != USBD_ERR_NONE) {
+        App_USBD_VendorBench_SlotEnd(p_bench);
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                    App_USBD_VendorBench_RxCmpl()
+*
+* Description : Callback called upon OUT transfer completion.
+*
+* Argument(s) : class_nbr         Class instance number.
+*
+*               p_buf             Pointer to receive buffer.
+*
+*               buf_len           Receive buffer length.
+*
+*               xfer_len          Number of octets received.
+*
+*               p_callback_arg    Index of the buffer.
+*
+*               err               Transfer error status.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) In loopback mode, the received data is sent back from the same buffer. The transfer is
+*                   complete once the IN transfer completes.
+*********************************************************************************************************
+*/
+
+static  void  App_USBD_VendorBench_RxCmpl (CPU_INT08U   class_nbr,
+                                           void        *p_buf,
+                                           CPU_INT32U   buf_len,
+                                           CPU_INT32U   xfer_len,
+                                           void        *p_callback_arg,
+                                           USBD_ERR     err)
+{
+    APP_USBD_VENDOR_BENCH  *p_bench;
+    CPU_INT08U              buf_ix;
+    CPU_SR_ALLOC();
+
+
+    (void)class_nbr;
+    (void)p_buf;
+    (void)buf_len;
+
+    p_bench = &App_USBD_VendorBench;
+    buf_ix  = (CPU_INT08U)(CPU_ADDR)p_callback_arg;
+
+    if (err != USBD_ERR_NONE) {
+        CPU_CRITICAL_ENTER();
+        p_bench->ErrCnt++;
+        CPU_CRITICAL_EXIT();
+        App_USBD_VendorBench_SlotEnd(p_bench);
+        return;
+    }
+
+    CPU_CRITICAL_ENTER();
+    p_bench->OctetCnt += xfer_len;
+    CPU_CRITICAL_EXIT();
+
+    if (p_bench->Dir == APP_USBD_VENDOR_BENCH_DIR_LOOP) {       /* See Note #1.                                         */
+        App_USBD_VendorBench_TxSubmit(p_bench, buf_ix, xfer_len);
+        return;
+    }
+
+    CPU_CRITICAL_ENTER();
+    p_bench->XferCmplCnt++;
+    CPU_CRITICAL_EXIT();
+
+    if (App_USBD_VendorBench_XferNext(p_bench) == DEF_YES) {
+        App_USBD_VendorBench_RxSubmit(p_bench, buf_ix);
+    } else {
+        App_USBD_VendorBench_SlotEnd(p_bench);
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                    App_USBD_VendorBench_TxCmpl()
+*
+* Description : Callback called upon IN transfer completion.
+*
+* Argument(s) : class_nbr         Class instance number.
+*
+*               p_buf             Pointer to transmit buffer.
+*
+*               buf_len           Transmit buffer length.
+*
+*               xfer_len          Number of octets transmitted.
+*
+*               p_callback_arg    Index of the buffer.
+*
+*               err               Transfer error status.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  void  App_USBD_VendorBench_TxCmpl (CPU_INT08U   class_nbr,
+                                           void        *p_buf,
+                                           CPU_INT32U   buf_len,
+                                           CPU_INT32U   xfer_len,
+                                           void        *p_callback_arg,
+                                           USBD_ERR     err)
+{
+    APP_USBD_VENDOR_BENCH  *p_bench;
+    CPU_INT08U              buf_ix;
+    CPU_SR_ALLOC();
+
+
+    (void)class_nbr;
+    (void)p_buf;
+    (void)buf_len;
+
+    p_bench = &App_USBD_VendorBench;
+    buf_ix  = (CPU_INT08U)(CPU_ADDR)p_callback_arg;
+
+    CPU_CRITICAL_ENTER();
+    if (err != USBD_ERR_NONE) {
+        p_bench->ErrCnt++;
+    } else {
+        p_bench->OctetCnt += xfer_len;
+        p_bench->XferCmplCnt++;
+    }
+    CPU_CRITICAL_EXIT();
+
+    if ((err                                   == USBD_ERR_NONE) &&
+        (App_USBD_VendorBench_XferNext(p_bench) == DEF_YES)) {
+        if (p_bench->Dir == APP_USBD_VENDOR_BENCH_DIR_IN) {
+            App_USBD_VendorBench_TxSubmit(p_bench, buf_ix, p_bench->XferLen);
+        } else {
+            App_USBD_VendorBench_RxSubmit(p_bench, buf_ix);
+        }
+    } else {
+        App_USBD_VendorBench_SlotEnd(p_bench);
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                   App_USBD_VendorBench_SlotEnd()
+*
+* Description : Release one reference on the asynchronous run, and signal its end to the benchmark task
+*               once no transfer is in progress.
+*
+* Argument(s) : p_bench    Pointer to benchmark data.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  void  App_USBD_VendorBench_SlotEnd (APP_USBD_VENDOR_BENCH  *p_bench)
+{
+    CPU_BOOLEAN  done;
+#if (APP_USBD_VENDOR_BENCH_OS_III_EN == DEF_ENABLED)
+    OS_ERR       os_err;
+#endif
+    CPU_SR_ALLOC();
+
+
+    CPU_CRITICAL_ENTER();
+    p_bench->PendNbr--;
+    done = (p_bench->PendNbr == 0u) ? DEF_YES : DEF_NO;
+    CPU_CRITICAL_EXIT();
+
+    if (done == DEF_YES) {
+#if (APP_USBD_VENDOR_BENCH_OS_III_EN == DEF_ENABLED)            /* ---------------------- OS-III ---------------------- */
+        OSSemPost(&App_USBD_VendorBench_DoneSem, OS_OPT_POST_1, &os_err);
+#else                                                           /* ---------------------- OS-II ----------------------- */
+        (void)OSSemPost(App_USBD_VendorBench_DoneSemPtr);
+#endif
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                             MODULE END
+*********************************************************************************************************
+*/
+
+#endif
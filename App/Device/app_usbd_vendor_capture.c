@@ -0,0 +1,354 @@
+/*
+*********************************************************************************************************
+*                                            EXAMPLE CODE
+*
+*               This file is provided as an example on how to use Micrium products.
+*
+*               Please feel free to use any application code labeled as 'EXAMPLE CODE' in
+*               your application products.  Example code may be used as is, in whole or in
+*               part, or may be used as a reference only. This file can be modified as
+*               required to meet the end-product requirements.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*
+*                             USB DEVICE VENDOR CLASS TRAFFIC CAPTURE APPLICATION
+*
+*                                              TEMPLATE
+*
+* Filename : app_usbd_vendor_capture.c
+* Version  : V4.06.01
+*********************************************************************************************************
+* Note(s)  : (1) This application adds a Vendor class interface whose bulk IN endpoint streams the content
+*                of the stack's traffic capture ring (see 'usbd_core.h  TRAFFIC CAPTURE'). The stack must
+*                be built with USBD_CFG_CAPTURE_EN set to DEF_ENABLED.
+*
+*            (2) Each time the device is configured, the pcap file header is sent first, followed by the
+*                records read from the ring. The data read by the host on the bulk IN endpoint, from the
+*                moment the device is configured, forms a pcap file that Wireshark opens directly.
+*
+*            (3) The capture interface also records its own transfers. To keep them from filling the
+*                ring, the task waits APP_USBD_VENDOR_CAPTURE_DLY_MS between reads and always sends as
+*                much data as possible at once.
+*
+*            (4) The capture interface is an additional Vendor class instance. USBD_VENDOR_CFG_MAX_NBR_DEV
+*                and the endpoint configuration of the device must account for it.
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#include  <app_usbd.h>
+
+#if (APP_CFG_USBD_EN                == DEF_ENABLED) && \
+    (APP_CFG_USBD_VENDOR_EN         == DEF_ENABLED) && \
+    (APP_CFG_USBD_VENDOR_CAPTURE_EN == DEF_ENABLED)
+
+#include  <Class/Vendor/usbd_vendor.h>
+#include  <Source/os.h>
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#ifndef OS_VERSION
+#error "OS_VERSION must be #define'd."
+#endif
+
+#if    (OS_VERSION > 30000u)
+#define  APP_USBD_VENDOR_CAPTURE_OS_III_EN          DEF_ENABLED
+#else
+#define  APP_USBD_VENDOR_CAPTURE_OS_III_EN          DEF_DISABLED
+#endif
+
+#define  APP_USBD_VENDOR_CAPTURE_TIMEOUT_MS              1000u
+#define  APP_USBD_VENDOR_CAPTURE_DLY_MS                    50u  /* See Note #3.                                         */
+
+
+/*
+*********************************************************************************************************
+*                                       LOCAL GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+static  CPU_INT08U   App_USBD_VendorCapture_ClassNbr;
+static  CPU_INT08U  *App_USBD_VendorCapture_BufPtr;
+
+#if (APP_USBD_VENDOR_CAPTURE_OS_III_EN == DEF_ENABLED)
+static  OS_TCB       App_USBD_VendorCapture_TaskTCB;
+#endif
+static  CPU_STK      App_USBD_VendorCapture_TaskStk[APP_CFG_USBD_VENDOR_TASK_STK_SIZE];
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  void  App_USBD_VendorCapture_Task(void  *p_arg);
+
+static  void  App_USBD_VendorCapture_Dly (void);
+
+
+/*
+*********************************************************************************************************
+*                                     LOCAL CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_CAPTURE_EN != DEF_ENABLED)
+#error  "USBD_CFG_CAPTURE_EN                  illegally #define'd in 'usbd_cfg.h'"
+#error  "                              [MUST be DEF_ENABLED]                     "
+#endif
+
+#if (APP_CFG_USBD_VENDOR_CAPTURE_BUF_LEN < USBD_CAPTURE_FILE_HDR_LEN)
+#error  "APP_CFG_USBD_VENDOR_CAPTURE_BUF_LEN  illegally #define'd in 'app_cfg.h' "
+#error  "                              [MUST be >= USBD_CAPTURE_FILE_HDR_LEN]    "
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                    App_USBD_VendorCapture_Init()
+*
+* Description : Add the traffic capture Vendor interface to the USB device stack.
+*
+* Argument(s) : dev_nbr    Device number.
+*
+*               cfg_hs     Index of high-speed configuration to which this interface will be added to.
+*
+*               cfg_fs     Index of full-speed configuration to which this interface will be added to.
+*
+* Return(s)   : DEF_OK,    if capture interface successfully added.
+*
+*               DEF_FAIL,  otherwise.
+*
+* Note(s)     : (1) The Vendor class must have been initialized with USBD_Vendor_Init().
+*
+*               (2) The transfer buffer is allocated from the heap so that it follows the buffer alignment
+*                   required by the device controller.
+*********************************************************************************************************
+*/
+
+CPU_BOOLEAN  App_USBD_VendorCapture_Init (CPU_INT08U  dev_nbr,
+                                          CPU_INT08U  cfg_hs,
+                                          CPU_INT08U  cfg_fs)
+{
+    CPU_SIZE_T  reqd_octets;
+    LIB_ERR     lib_mem_err;
+    USBD_ERR    err;
+    USBD_ERR    err_hs;
+    USBD_ERR    err_fs;
+    OS_ERR      os_err;
+
+
+    err_hs = USBD_ERR_NONE;
+    err_fs = USBD_ERR_NONE;
+
+    APP_TRACE_DBG(("        Initializing Vendor traffic capture ... \r\n"));
+                                                                /* Alloc xfer buf (see Note #2).                        */
+    App_USBD_VendorCapture_BufPtr = (CPU_INT08U *)Mem_HeapAlloc(APP_CFG_USBD_VENDOR_CAPTURE_BUF_LEN,
+                                                                USBD_CFG_BUF_ALIGN_OCTETS,
+                                                               &reqd_octets,
+                                                               &lib_mem_err);
+    if (lib_mem_err != LIB_MEM_ERR_NONE) {
+        APP_TRACE_DBG(("        ... could not allocate Vendor capture buffer w/err = %d\r\n\r\n", lib_mem_err));
+        return (DEF_FAIL);
+    }
+                                                                /* Create a Vendor class instance without intr EPs.     */
+    App_USBD_VendorCapture_ClassNbr = USBD_Vendor_Add(DEF_FALSE,
+                                                      0u,
+                                                      (USBD_VENDOR_REQ_FNCT)0,
+                                                     &err);
+    if (err != USBD_ERR_NONE) {
+        APP_TRACE_DBG(("        ... could not instantiate a Vendor capture class w/err = %d\r\n\r\n", err));
+        return (DEF_FAIL);
+    }
+
+    if (cfg_hs != USBD_CFG_NBR_NONE) {
+                                                                /* Add vendor class to HS dflt cfg.                     */
+        USBD_Vendor_CfgAdd(App_USBD_VendorCapture_ClassNbr, dev_nbr, cfg_hs, &err_hs);
+        if (err_hs != USBD_ERR_NONE) {
+            APP_TRACE_DBG(("        ... could not add Vendor capture instance #%d to HS configuration w/err = %d\r\n\r\n", App_USBD_VendorCapture_ClassNbr, err_hs));
+        }
+    }
+
+    if (cfg_fs != USBD_CFG_NBR_NONE) {
+                                                                /* Add vendor class to FS dflt cfg.                     */
+        USBD_Vendor_CfgAdd(App_USBD_VendorCapture_ClassNbr, dev_nbr, cfg_fs, &err_fs);
+        if (err_fs != USBD_ERR_NONE) {
+            APP_TRACE_DBG(("        ... could not add Vendor capture instance #%d to FS configuration w/err = %d\r\n\r\n", App_USBD_VendorCapture_ClassNbr, err_fs));
+        }
+    }
+
+    if ((err_hs != USBD_ERR_NONE) &&                            /* If HS and FS cfg fail, stop class init.              */
+        (err_fs != USBD_ERR_NONE)) {
+        return (DEF_FAIL);
+    }
+
+#if (APP_USBD_VENDOR_CAPTURE_OS_III_EN == DEF_ENABLED)          /* ---------------------- OS-III ---------------------- */
+    OSTaskCreate(                 &App_USBD_VendorCapture_TaskTCB,
+                                  "USB Device Vendor Capture",
+                                   App_USBD_VendorCapture_Task,
+                 (void *)          0,
+                                   APP_CFG_USBD_VENDOR_CAPTURE_TASK_PRIO,
+                                  &App_USBD_VendorCapture_TaskStk[0],
+                                   APP_CFG_USBD_VENDOR_TASK_STK_SIZE / 10u,
+                                   APP_CFG_USBD_VENDOR_TASK_STK_SIZE,
+                                   0u,
+                                   0u,
+                 (void *)          0,
+                                   OS_OPT_TASK_STK_CHK | OS_OPT_TASK_STK_CLR,
+                                  &os_err);
+#else                                                           /* ---------------------- OS-II ----------------------- */
+#if (OS_STK_GROWTH == 1u)
+    os_err = OSTaskCreateExt(                  App_USBD_VendorCapture_Task,
+                             (void *)          0,
+                                              &App_USBD_VendorCapture_TaskStk[APP_CFG_USBD_VENDOR_TASK_STK_SIZE - 1],
+                                               APP_CFG_USBD_VENDOR_CAPTURE_TASK_PRIO,
+                                               APP_CFG_USBD_VENDOR_CAPTURE_TASK_PRIO,
+                                              &App_USBD_VendorCapture_TaskStk[0],
+                                               APP_CFG_USBD_VENDOR_TASK_STK_SIZE,
+                             (void *)          0,
+                                               OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
+#else
+    os_err = OSTaskCreateExt(                  App_USBD_VendorCapture_Task,
+                             (void *)          0,
+                                              &App_USBD_VendorCapture_TaskStk[0],
+                                               APP_CFG_USBD_VENDOR_CAPTURE_TASK_PRIO,
+                                               APP_CFG_USBD_VENDOR_CAPTURE_TASK_PRIO,
+                                              &App_USBD_VendorCapture_TaskStk[APP_CFG_USBD_VENDOR_TASK_STK_SIZE - 1],
+                                               APP_CFG_USBD_VENDOR_TASK_STK_SIZE,
+                             (void *)          0,
+                                               OS_TASK_OPT_STK_CHK | OS_TASK_OPT_STK_CLR);
+#endif
+#endif
+    if (os_err != OS_ERR_NONE) {
+        APP_TRACE_DBG(("        ... could not add Vendor capture task w/err = %d\r\n\r\n", os_err));
+        return (DEF_FAIL);
+    }
+#if (APP_USBD_VENDOR_CAPTURE_OS_III_EN == DEF_DISABLED) && (OS_TASK_NAME_EN > 0u)
+    OSTaskNameSet(APP_CFG_USBD_VENDOR_CAPTURE_TASK_PRIO, (INT8U *)"USB Device Vendor Capture", &os_err);
+#endif
+
+    return (DEF_OK);
+}
+
+
+/*
+*********************************************************************************************************
+*********************************************************************************************************
+*                                           LOCAL FUNCTIONS
+*********************************************************************************************************
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                    App_USBD_VendorCapture_Task()
+*
+* Description : Stream the capture ring on the bulk IN endpoint of the capture interface.
+*
+* Argument(s) : p_arg      Argument passed to the task (ignored).
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Data read from the ring is lost if its transmission fails. The host sees a truncated
+*                   record and must restart the capture by re-configuring the device.
+*********************************************************************************************************
+*/
+
+static  void  App_USBD_VendorCapture_Task (void  *p_arg)
+{
+    CPU_BOOLEAN  hdr_sent;
+    CPU_INT32U   len;
+    USBD_ERR     err;
+
+
+    (void)p_arg;
+
+    hdr_sent = DEF_NO;
+
+    while (DEF_TRUE) {
+        if (USBD_Vendor_IsConn(App_USBD_VendorCapture_ClassNbr) == DEF_NO) {
+            hdr_sent = DEF_NO;                                  /* Send file hdr on next cfg (see 'Note #2').           */
+            App_USBD_VendorCapture_Dly();
+            continue;
+        }
+
+        if (hdr_sent == DEF_NO) {
+            len = USBD_CaptureFileHdrGet(App_USBD_VendorCapture_BufPtr,
+                                         APP_CFG_USBD_VENDOR_CAPTURE_BUF_LEN,
+                                        &err);
+            hdr_sent = DEF_YES;
+        } else {
+            len = USBD_CaptureRd(App_USBD_VendorCapture_BufPtr,
+                                 APP_CFG_USBD_VENDOR_CAPTURE_BUF_LEN,
+                                &err);
+        }
+
+        if (len == 0u) {
+            App_USBD_VendorCapture_Dly();
+            continue;
+        }
+
+        (void)USBD_Vendor_Wr(App_USBD_VendorCapture_ClassNbr,
+                             App_USBD_VendorCapture_BufPtr,
+                             len,
+                             APP_USBD_VENDOR_CAPTURE_TIMEOUT_MS,
+                             DEF_NO,
+                            &err);
+        if (err != USBD_ERR_NONE) {                             /* See Note #1.                                         */
+            APP_TRACE_DBG(("        Vendor capture: %u octets lost w/err = %d\r\n", (unsigned int)len, err));
+        }
+
+        App_USBD_VendorCapture_Dly();
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                    App_USBD_VendorCapture_Dly()
+*
+* Description : Wait before the next read of the capture ring.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  void  App_USBD_VendorCapture_Dly (void)
+{
+#if (APP_USBD_VENDOR_CAPTURE_OS_III_EN == DEF_ENABLED)
+    OS_ERR  os_err;
+
+
+    OSTimeDlyHMSM(0u, 0u, 0u, APP_USBD_VENDOR_CAPTURE_DLY_MS, OS_OPT_TIME_HMSM_NON_STRICT, &os_err);
+#else
+    OSTimeDlyHMSM(0u, 0u, 0u, APP_USBD_VENDOR_CAPTURE_DLY_MS);
+#endif
+}
+
+
+/*
+*********************************************************************************************************
+*                                             MODULE END
+*********************************************************************************************************
+*/
+
+#endif
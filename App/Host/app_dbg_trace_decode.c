@@ -0,0 +1,548 @@
+/*
+*********************************************************************************************************
+*                                            EXAMPLE CODE
+*
+*               This file is provided as an example on how to use Micrium products.
+*
+*               Please feel free to use any application code labeled as 'EXAMPLE CODE' in
+*               your application products.  Example code may be used as is, in whole or in
+*               part, or may be used as a reference only. This file can be modified as
+*               required to meet the end-product requirements.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*
+*                                USB DEVICE BINARY TRACE DECODER PROGRAM
+*
+* Filename : app_dbg_trace_decode.c
+* Version  : V4.06.01
+*********************************************************************************************************
+* Note(s)  : (1) This program runs on the development host. It formats the binary trace ring filled by the
+*                device stack when USBD_CFG_DBG_TRACE_BIN_EN is DEF_ENABLED (see 'usbd_core.h  BINARY
+*                TRACE RING').
+*
+*            (2) The input is a raw memory dump of the 'USBD_DbgTraceRing' variable, e.g. with GDB :
+*
+*                    dump binary value trace.bin USBD_DbgTraceRing
+*
+*            (3) Each record identifies its message by the address of the message string. If the ELF
+*                image of the firmware is given, the address is resolved to the string. Otherwise, the
+*                address is printed.
+*
+*            (4) The output uses the layout of the formatted trace :
+*
+*                    USB  <timestamp us>  <ep addr>  <if nbr>  <message><error>  <argument>
+*
+*            (5) This program only depends on the standard C library :
+*
+*                    cc -O2 -o usbd_trace_decode app_dbg_trace_decode.c
+*
+*                    usbd_trace_decode trace.bin [firmware.elf]
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <stdint.h>
+#include  <string.h>
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#define  TRACE_MAGIC                           0x54425355u     /* See 'usbd_core.h' USBD_DBG_TRACE_MAGIC.              */
+#define  TRACE_VER                                      1u
+#define  TRACE_FLAG_ARG                              0x01u
+
+#define  TRACE_HDR_LEN                                 20u     /* Len of ring hdr, before rec tbl.                     */
+
+#define  TRACE_EP_ADDR_NONE                          0xFFu     /* See 'usbd_core.h' USBD_EP_ADDR_NONE.                 */
+#define  TRACE_IF_NBR_NONE                           0xFFu     /* See 'usbd_core.h' USBD_IF_NBR_NONE.                  */
+
+#define  TRACE_MSG_LEN_MAX                            256u
+
+#define  ELF_SHF_ALLOC                               0x02u
+#define  ELF_SHT_NOBITS                                 8u
+
+
+/*
+*********************************************************************************************************
+*                                          LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+typedef  struct  trace_rec {                                    /* ------------------ DECODED RECORD ------------------ */
+    uint32_t  Seq;
+    uint32_t  Ts;
+    uint64_t  MsgAddr;
+    uint32_t  Arg;
+    uint16_t  Err;
+    uint8_t   EP_Addr;
+    uint8_t   IF_Nbr;
+    uint8_t   Flags;
+} TRACE_REC;
+
+
+typedef  struct  buf {                                          /* ------------------- FILE CONTENT ------------------- */
+    uint8_t  *DataPtr;
+    size_t    Len;
+    int       BigEndian;
+} BUF;
+
+
+/*
+*********************************************************************************************************
+*                                        LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  int       Trace_FileRd   (const  char       *p_name,
+                                          BUF        *p_buf);
+
+static  uint64_t  Trace_Rd       (const  BUF        *p_buf,
+                                         size_t      offset,
+                                         size_t      len);
+
+static  int       Trace_RecCmp   (const  void       *p_rec1,
+                                  const  void       *p_rec2);
+
+static  int       Trace_MsgGet   (const  BUF        *p_elf,
+                                         uint64_t    addr,
+                                         char       *p_msg,
+                                         size_t      msg_len);
+
+
+/*
+*********************************************************************************************************
+*                                               main()
+*
+* Description : Read the trace ring dump, sort its records and print them.
+*
+* Argument(s) : argc        Number of command line arguments.
+*
+*               argv        Command line arguments.
+*
+* Return(s)   : 0, if the dump was decoded.
+*
+*               1, otherwise.
+*
+* Note(s)     : (1) The record layout is computed from the pointer size stored in the ring header, using
+*                   the natural alignment of the target ABI :
+*
+*                   Seq (4), Ts (4), MsgPtr (PtrSize), Arg (4), Err (2), EP_Addr (1), IF_Nbr (1), Flags (1).
+*
+*               (2) Records that are empty, incomplete or stored at an index that does not match their
+*                   sequence number are skipped.
+*
+*               (3) Gaps in the sequence numbers are events overwritten before the dump was taken.
+*********************************************************************************************************
+*/
+
+int  main (int    argc,
+           char  *argv[])
+{
+    BUF         ring;
+    BUF         elf;
+    TRACE_REC  *p_rec_tbl;
+    TRACE_REC  *p_rec;
+    uint32_t    rec_nbr;
+    uint32_t    rec_size;
+    uint32_t    ptr_size;
+    uint32_t    ts_freq;
+    uint32_t    rec_cnt;
+    uint32_t    ix;
+    uint32_t    seq_prev;
+    size_t      tbl_offset;
+    size_t      rec_offset;
+    size_t      align;
+    double      ts_us;
+    char        msg[TRACE_MSG_LEN_MAX];
+
+
+    if ((argc < 2) || (argc > 3)) {
+        fprintf(stderr, "usage: %s <trace dump> [firmware elf]\n", argv[0]);
+        return (1);
+    }
+
+    if (Trace_FileRd(argv[1], &ring) != 0) {
+        return (1);
+    }
+
+    elf.DataPtr = NULL;
+    elf.Len     = 0u;
+    if ((argc == 3) &&
+        (Trace_FileRd(argv[2], &elf) != 0)) {
+        return (1);
+    }
+
+    if (ring.Len < TRACE_HDR_LEN) {
+        fprintf(stderr, "trace dump too short\n");
+        return (1);
+    }
+                                                                /* ------------------- RD RING HDR -------------------- */
+    ring.BigEndian = 0;
+    if (Trace_Rd(&ring, 0u, 4u) != TRACE_MAGIC) {
+        ring.BigEndian = 1;
+        if (Trace_Rd(&ring, 0u, 4u) != TRACE_MAGIC) {
+            fprintf(stderr, "invalid trace magic\n");
+            return (1);
+        }
+    }
+
+    if (ring.DataPtr[4u] != TRACE_VER) {
+        fprintf(stderr, "unsupported trace version %u\n", (unsigned)ring.DataPtr[4u]);
+        return (1);
+    }
+
+    rec_size = ring.DataPtr[5u];
+    ptr_size = ring.DataPtr[6u];
+    rec_nbr  = (uint32_t)Trace_Rd(&ring,  8u, 4u);
+    ts_freq  = (uint32_t)Trace_Rd(&ring, 12u, 4u);
+
+    if ((ptr_size != 2u) && (ptr_size != 4u) && (ptr_size != 8u)) {
+        fprintf(stderr, "unsupported pointer size %u\n", (unsigned)ptr_size);
+        return (1);
+    }
+    if ((rec_nbr == 0u) ||
+        (rec_size < (8u + ptr_size + 9u))) {
+        fprintf(stderr, "invalid trace header\n");
+        return (1);
+    }
+
+    align      = (ptr_size > 4u) ? ptr_size : 4u;               /* See Note #1.                                         */
+    tbl_offset = (TRACE_HDR_LEN + align - 1u) & ~(align - 1u);
+    if (ring.Len < tbl_offset + (size_t)rec_nbr * rec_size) {
+        fprintf(stderr, "trace dump too short for %u records\n", (unsigned)rec_nbr);
+        return (1);
+    }
+                                                                /* ---------------------- RD RECS --------------------- */
+    p_rec_tbl = (TRACE_REC *)calloc(rec_nbr, sizeof(TRACE_REC));
+    if (p_rec_tbl == NULL) {
+        return (1);
+    }
+
+    rec_cnt = 0u;
+    for (ix = 0u; ix < rec_nbr; ix++) {
+        rec_offset     = tbl_offset + (size_t)ix * rec_size;
+        p_rec          = &p_rec_tbl[rec_cnt];
+        p_rec->Seq     = (uint32_t)Trace_Rd(&ring, rec_offset,      4u);
+        p_rec->Ts      = (uint32_t)Trace_Rd(&ring, rec_offset + 4u, 4u);
+
+        rec_offset    += (8u + ptr_size - 1u) & ~(size_t)(ptr_size - 1u);
+        p_rec->MsgAddr =           Trace_Rd(&ring, rec_offset,      ptr_size);
+        rec_offset    +=  ptr_size;
+        p_rec->Arg     = (uint32_t)Trace_Rd(&ring, rec_offset,      4u);
+        p_rec->Err     = (uint16_t)Trace_Rd(&ring, rec_offset + 4u, 2u);
+        p_rec->EP_Addr =  ring.DataPtr[rec_offset + 6u];
+        p_rec->IF_Nbr  =  ring.DataPtr[rec_offset + 7u];
+        p_rec->Flags   =  ring.DataPtr[rec_offset + 8u];
+
+        if ((p_rec->Seq            != 0u) &&                    /* See Note #2.                                         */
+            ((p_rec->Seq % rec_nbr) == ix)) {
+            rec_cnt++;
+        }
+    }
+
+    qsort(p_rec_tbl, rec_cnt, sizeof(TRACE_REC), Trace_RecCmp);
+
+                                                                /* --------------------- PRINT RECS ------------------- */
+    seq_prev = 0u;
+    for (ix = 0u; ix < rec_cnt; ix++) {
+        p_rec = &p_rec_tbl[ix];
+
+        if (p_rec->Seq > seq_prev + 1u) {                       /* See Note #3.                                         */
+            printf("USB  %u  Skipped event(s) \n", (unsigned)(p_rec->Seq - seq_prev - 1u));
+        }
+        seq_prev = p_rec->Seq;
+
+        ts_us = (ts_freq != 0u) ? ((double)p_rec->Ts * 1000000.0 / (double)ts_freq)
+                                :  (double)p_rec->Ts;
+        printf("USB  %10.0f  ", ts_us);
+
+        if (p_rec->EP_Addr != TRACE_EP_ADDR_NONE) {
+            printf("%2X  ", (unsigned)p_rec->EP_Addr);
+        } else {
+            printf("    ");
+        }
+
+        if (p_rec->IF_Nbr != TRACE_IF_NBR_NONE) {
+            printf("%u  ", (unsigned)p_rec->IF_Nbr);
+        } else {
+            printf("     ");
+        }
+
+        if (Trace_MsgGet(&elf, p_rec->MsgAddr, &msg[0u], sizeof(msg)) == 0) {
+            printf("%s", msg);
+        } else {
+            printf("<msg 0x%llx> ", (unsigned long long)p_rec->MsgAddr);
+        }
+
+        if (p_rec->Err != 0u) {
+            printf("%u  ", (unsigned)p_rec->Err);
+        }
+
+        if ((p_rec->Flags & TRACE_FLAG_ARG) != 0u) {
+            printf("  %u  ", (unsigned)p_rec->Arg);
+        }
+        printf("\n");
+    }
+
+    free(p_rec_tbl);
+    free(ring.DataPtr);
+    free(elf.DataPtr);
+
+    return (0);
+}
+
+
+/*
+*********************************************************************************************************
+*********************************************************************************************************
+*                                           LOCAL FUNCTIONS
+*********************************************************************************************************
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                           Trace_FileRd()
+*
+* Description : Read a whole file in memory.
+*
+* Argument(s) : p_name      File name.
+*
+*               p_buf       Pointer to buffer that receives the file content.
+*
+* Return(s)   : 0, if the file was read.
+*
+*               1, otherwise.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  int  Trace_FileRd (const  char  *p_name,
+                                  BUF   *p_buf)
+{
+    FILE  *p_file;
+    long   len;
+
+
+    p_file = fopen(p_name, "rb");
+    if (p_file == NULL) {
+        fprintf(stderr, "cannot open '%s'\n", p_name);
+        return (1);
+    }
+
+    if ((fseek(p_file, 0L, SEEK_END) != 0) ||
+        ((len = ftell(p_file)) < 0L)       ||
+        (fseek(p_file, 0L, SEEK_SET) != 0)) {
+        fprintf(stderr, "cannot read '%s'\n", p_name);
+        fclose(p_file);
+        return (1);
+    }
+
+    p_buf->DataPtr   = (uint8_t *)malloc((size_t)len + 1u);
+    p_buf->Len       = (size_t)len;
+    p_buf->BigEndian = 0;
+    if ((p_buf->DataPtr == NULL) ||
+        (fread(p_buf->DataPtr, 1u, p_buf->Len, p_file) != p_buf->Len)) {
+        fprintf(stderr, "cannot read '%s'\n", p_name);
+        fclose(p_file);
+        return (1);
+    }
+
+    fclose(p_file);
+
+    return (0);
+}
+
+
+/*
+*********************************************************************************************************
+*                                             Trace_Rd()
+*
+* Description : Read an unsigned integer from a buffer, in the buffer's endianness.
+*
+* Argument(s) : p_buf       Pointer to buffer.
+*
+*               offset      Offset of the integer, in octets.
+*
+*               len         Length of the integer, in octets (1 to 8).
+*
+* Return(s)   : Integer value, 0 if out of the buffer.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  uint64_t  Trace_Rd (const  BUF     *p_buf,
+                                   size_t   offset,
+                                   size_t   len)
+{
+    uint64_t  val;
+    size_t    ix;
+
+
+    if ((offset > p_buf->Len) ||
+        (len    > p_buf->Len - offset)) {
+        return (0u);
+    }
+
+    val = 0u;
+    for (ix = 0u; ix < len; ix++) {
+        if (p_buf->BigEndian != 0) {
+            val = (val << 8u) | p_buf->DataPtr[offset + ix];
+        } else {
+            val = (val << 8u) | p_buf->DataPtr[offset + len - 1u - ix];
+        }
+    }
+
+    return (val);
+}
+
+
+/*
+*********************************************************************************************************
+*                                           Trace_RecCmp()
+*
+* Description : Compare two records by sequence number (qsort() callback).
+*
+* Argument(s) : p_rec1      Pointer to first  record.
+*
+*               p_rec2      Pointer to second record.
+*
+* Return(s)   : < 0, = 0 or > 0 if first record is older, same or newer than the second.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  int  Trace_RecCmp (const  void  *p_rec1,
+                           const  void  *p_rec2)
+{
+    uint32_t  seq1;
+    uint32_t  seq2;
+
+
+    seq1 = ((const TRACE_REC *)p_rec1)->Seq;
+    seq2 = ((const TRACE_REC *)p_rec2)->Seq;
+
+    return ((seq1 > seq2) - (seq1 < seq2));
+}
+
+
+/*
+*********************************************************************************************************
+*                                           Trace_MsgGet()
+*
+* Description : Resolve a message address to the message string, using the firmware ELF image.
+*
+* Argument(s) : p_elf       Pointer to ELF image buffer, empty if none given.
+*
+*               addr        Address of the message in the target's memory.
+*
+*               p_msg       Pointer to buffer that receives the message.
+*
+*               msg_len     Size of message buffer, in octets.
+*
+* Return(s)   : 0, if the message was found.
+*
+*               1, otherwise.
+*
+* Note(s)     : (1) The message is looked up in the allocated sections that have content in the file (code
+*                   and read-only data), using the section headers of the ELF32 or ELF64 image.
+*********************************************************************************************************
+*/
+
+static  int  Trace_MsgGet (const  BUF       *p_elf,
+                                  uint64_t   addr,
+                                  char      *p_msg,
+                                  size_t     msg_len)
+{
+    BUF       elf;
+    int       elf64;
+    uint64_t  sh_offset;
+    uint32_t  sh_size;
+    uint32_t  sh_nbr;
+    uint32_t  ix;
+    size_t    hdr;
+    uint64_t  sec_flags;
+    uint64_t  sec_addr;
+    uint64_t  sec_offset;
+    uint64_t  sec_size;
+    uint32_t  sec_type;
+    size_t    pos;
+    size_t    len;
+
+
+    if ((p_elf->DataPtr == NULL) ||
+        (p_elf->Len     <  0x40u) ||
+        (memcmp(p_elf->DataPtr, "\177ELF", 4u) != 0)) {
+        return (1);
+    }
+
+    elf           = *p_elf;
+    elf64         = (elf.DataPtr[4u] == 2u);
+    elf.BigEndian = (elf.DataPtr[5u] == 2u);
+
+    if (elf64 != 0) {
+        sh_offset =           Trace_Rd(&elf, 0x28u, 8u);
+        sh_size   = (uint32_t)Trace_Rd(&elf, 0x3Au, 2u);
+        sh_nbr    = (uint32_t)Trace_Rd(&elf, 0x3Cu, 2u);
+    } else {
+        sh_offset =           Trace_Rd(&elf, 0x20u, 4u);
+        sh_size   = (uint32_t)Trace_Rd(&elf, 0x2Eu, 2u);
+        sh_nbr    = (uint32_t)Trace_Rd(&elf, 0x30u, 2u);
+    }
+                                                                /* See Note #1.                                         */
+    for (ix = 0u; ix < sh_nbr; ix++) {
+        hdr      = (size_t)(sh_offset + (uint64_t)ix * sh_size);
+        sec_type = (uint32_t)Trace_Rd(&elf, hdr + 4u, 4u);
+        if (elf64 != 0) {
+            sec_flags  = Trace_Rd(&elf, hdr + 0x08u, 8u);
+            sec_addr   = Trace_Rd(&elf, hdr + 0x10u, 8u);
+            sec_offset = Trace_Rd(&elf, hdr + 0x18u, 8u);
+            sec_size   = Trace_Rd(&elf, hdr + 0x20u, 8u);
+        } else {
+            sec_flags  = Trace_Rd(&elf, hdr + 0x08u, 4u);
+            sec_addr   = Trace_Rd(&elf, hdr + 0x0Cu, 4u);
+            sec_offset = Trace_Rd(&elf, hdr + 0x10u, 4u);
+            sec_size   = Trace_Rd(&elf, hdr + 0x14u, 4u);
+        }
+
+        if (((sec_flags & ELF_SHF_ALLOC) == 0u) ||
+             (sec_type == ELF_SHT_NOBITS)        ||
+             (addr     <  sec_addr)              ||
+             (addr     >= sec_addr + sec_size)   ||
+             (sec_offset + sec_size > elf.Len)) {
+            continue;
+        }
+
+        pos = (size_t)(sec_offset + (addr - sec_addr));
+        len = 0u;
+        while ((pos + len < sec_offset + sec_size) &&
+               (elf.DataPtr[pos + len] != '\0')    &&
+               (len < msg_len - 1u)) {
+            p_msg[len] = (char)elf.DataPtr[pos + len];
+            len++;
+        }
+        p_msg[len] = '\0';
+
+        return (0);
+    }
+
+    return (1);
+}
@@ -0,0 +1,1155 @@
+/*
+*********************************************************************************************************
+*                                            EXAMPLE CODE
+*
+*               This file is provided as an example on how to use Micrium products.
+*
+*               Please feel free to use any application code labeled as 'EXAMPLE CODE' in
+*               your application products.  Example code may be used as is, in whole or in
+*               part, or may be used as a reference only. This file can be modified as
+*               required to meet the end-product requirements.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*
+*                               USB DEVICE VENDOR CLASS BENCHMARK HOST PROGRAM
+*
+* Filename : app_vendor_bench_host.c
+* Version  : V4.06.01
+*********************************************************************************************************
+* Note(s)  : (1) This program runs on the USB host. It drives the benchmark interface added by
+*                'App/Device/app_usbd_vendor_bench.c' and sweeps :
+*
+*                (a) The transfer length.
+*                (b) The queue depth, i.e. the number of transfers kept in flight on both sides.
+*                (c) The device API : synchronous or asynchronous Vendor class functions.
+*                (d) The endpoint type : bulk or interrupt.
+*                (e) The direction : OUT (device sinks), IN (device sources) or loopback.
+*
+*            (2) USBD_CFG_MAX_NBR_URB_EXTRA is a build option of the device. It is reported by the device
+*                and copied into each result, so that runs of several device builds can be compared.
+*
+*            (3) Each run prints one JSON object per line on the standard output, e.g. :
+*
+*                {"api":"async","ep":"bulk","dir":"in","xfer_len":16384,"depth":4,"urb_extra":4,
+*                 "xfer_nbr":2000,"xfer_cmpl":2000,"err":0,"dev_xfer_cmpl":2000,"dev_err":0,
+*                 "elapsed_us":812345,"mb_s":40.34,"xfer_s":2462.0,
+*                 "lat_p50_us":1602.1,"lat_p99_us":1790.3,"lat_p999_us":2102.8}
+*
+*                Latency is measured from the submission of a transfer to its completion. In loopback
+*                mode, it spans the OUT transfer and the IN transfer that returns the data.
+*
+*            (4) This program requires libusb-1.0 :
+*
+*                    cc -O2 -o vendor_bench app_vendor_bench_host.c -lusb-1.0
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#define  _POSIX_C_SOURCE  200809L
+
+#include  <stdio.h>
+#include  <stdlib.h>
+#include  <stdint.h>
+#include  <string.h>
+#include  <time.h>
+#include  <unistd.h>
+#include  <libusb-1.0/libusb.h>
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#define  BENCH_VID_DFLT                            0xFFFEu     /* See 'usbd_dev_cfg.c'.                                */
+#define  BENCH_PID_DFLT                            0x1234u
+
+#define  BENCH_XFER_NBR_DFLT                         1000u
+#define  BENCH_TIMEOUT_MS                            5000u
+#define  BENCH_CTRL_TIMEOUT_MS                       1000u
+#define  BENCH_STOP_WAIT_MS                          6000u
+#define  BENCH_DEPTH_MAX                               64u
+#define  BENCH_LIST_MAX                                32u
+
+                                                                /* ------ VENDOR REQUESTS (see device Note #2) ------- */
+#define  BENCH_REQ_INFO                              0x10u
+#define  BENCH_REQ_START                             0x11u
+#define  BENCH_REQ_STOP                              0x12u
+#define  BENCH_REQ_RESULT                            0x13u
+
+#define  BENCH_INFO_LEN                                12u
+#define  BENCH_START_LEN                               12u
+#define  BENCH_RESULT_LEN                              16u
+#define  BENCH_PROTOCOL_VER                             1u
+
+#define  BENCH_REQ_TYPE_OUT        (LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_INTERFACE)
+#define  BENCH_REQ_TYPE_IN         (LIBUSB_ENDPOINT_IN  | LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_INTERFACE)
+
+#define  BENCH_API_SYNC                                 0u
+#define  BENCH_API_ASYNC                                1u
+
+#define  BENCH_EP_BULK                                  0u
+#define  BENCH_EP_INTR                                  1u
+
+#define  BENCH_DIR_OUT                                  0u
+#define  BENCH_DIR_IN                                   1u
+#define  BENCH_DIR_LOOP                                 2u
+
+
+/*
+*********************************************************************************************************
+*                                          LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+typedef  struct  bench_dev {                                    /* ---------------- BENCHMARK INTERFACE -------------- */
+    libusb_device_handle  *HandlePtr;
+    uint8_t                IF_Nbr;
+    uint8_t                EP_Tbl[2u][2u];                      /* EP addr, indexed by [ep type][dir in].               */
+    uint8_t                URB_Extra;                           /* USBD_CFG_MAX_NBR_URB_EXTRA of device.                */
+    uint8_t                QueueMax;                            /* Max queue depth of device.                           */
+    uint32_t               XferLenMax;                          /* Max xfer len of device.                              */
+} BENCH_DEV;
+
+
+typedef  struct  bench_run  BENCH_RUN;
+
+typedef  struct  bench_slot {                                   /* ------------------ TRANSFER SLOT ------------------- */
+    BENCH_RUN                *RunPtr;
+    struct  libusb_transfer  *XferOutPtr;
+    struct  libusb_transfer  *XferInPtr;
+    uint8_t                  *BufPtr;
+    struct  timespec          TimeStart;                        /* Submission time of current xfer.                     */
+} BENCH_SLOT;
+
+
+struct  bench_run {                                             /* --------------------- ONE RUN ---------------------- */
+    BENCH_DEV     *DevPtr;
+    uint8_t        API;
+    uint8_t        EP_Type;
+    uint8_t        Dir;
+    uint8_t        Depth;
+    uint32_t       XferLen;
+    uint32_t       XferNbr;
+
+    uint32_t       XferStartCnt;
+    uint32_t       XferCmplCnt;
+    uint32_t       ErrCnt;
+    uint32_t       PendNbr;                                     /* Nbr of slots with a xfer in flight.                  */
+    double        *LatTbl;                                      /* Latency of each completed xfer, in us.               */
+
+    BENCH_SLOT     SlotTbl[BENCH_DEPTH_MAX];
+};
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL TABLES
+*********************************************************************************************************
+*/
+
+static  const  char  *Bench_API_NameTbl[] = { "sync", "async"        };
+static  const  char  *Bench_EP_NameTbl[]  = { "bulk", "intr"         };
+static  const  char  *Bench_DirNameTbl[]  = { "out",  "in",   "loop" };
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  int       Bench_DevOpen     (libusb_context   *p_ctx,
+                                     uint16_t          vid,
+                                     uint16_t          pid,
+                                     BENCH_DEV        *p_dev);
+
+static  int       Bench_DevInfoGet  (BENCH_DEV        *p_dev);
+
+static  int       Bench_Run         (BENCH_RUN        *p_run);
+
+static  int       Bench_SlotStart   (BENCH_SLOT       *p_slot);
+
+static  void      Bench_XferCmpl    (struct  libusb_transfer  *p_xfer);
+
+static  void      Bench_Report      (BENCH_RUN        *p_run,
+                                     double            elapsed_us,
+                                     uint32_t          dev_xfer_cmpl,
+                                     uint32_t          dev_err);
+
+static  int       Bench_CtrlStop    (BENCH_DEV        *p_dev,
+                                     uint32_t         *p_dev_xfer_cmpl,
+                                     uint32_t         *p_dev_err);
+
+static  size_t    Bench_ListParse   (const  char      *p_str,
+                                     uint32_t         *p_list,
+                                     size_t            list_max);
+
+static  size_t    Bench_NameParse   (const  char      *p_str,
+                                     const  char     **p_name_tbl,
+                                     size_t            name_nbr,
+                                     uint32_t         *p_list);
+
+static  double    Bench_TimeDiffUs  (const  struct  timespec  *p_start,
+                                     const  struct  timespec  *p_end);
+
+static  double    Bench_Percentile  (const  double    *p_sorted,
+                                     uint32_t          nbr,
+                                     double            pct);
+
+static  int       Bench_DblCmp      (const  void      *p_a,
+                                     const  void      *p_b);
+
+static  void      Bench_Usage       (const  char      *p_prog);
+
+
+/*
+*********************************************************************************************************
+*                                               main()
+*
+* Description : Parse the command line, open the benchmark interface and execute the sweep.
+*
+* Argument(s) : argc        Number of command line arguments.
+*
+*               argv        Command line arguments.
+*
+* Return(s)   : 0, if every run completed without error.
+*
+*               1, otherwise.
+*
+* Note(s)     : (1) Combinations that the device cannot run (transfer longer than its buffers, queue deeper
+*                   than its limit, interrupt endpoints not present) are skipped. The synchronous API
+*                   always runs at depth 1.
+*********************************************************************************************************
+*/
+
+int  main (int    argc,
+           char  *argv[])
+{
+    libusb_context  *p_ctx;
+    BENCH_DEV        dev;
+    BENCH_RUN        run;
+    uint32_t         len_tbl[BENCH_LIST_MAX];
+    uint32_t         depth_tbl[BENCH_LIST_MAX];
+    uint32_t         api_tbl[2u];
+    uint32_t         ep_tbl[2u];
+    uint32_t         dir_tbl[3u];
+    size_t           len_nbr;
+    size_t           depth_nbr;
+    size_t           api_nbr;
+    size_t           ep_nbr;
+    size_t           dir_nbr;
+    size_t           len_ix;
+    size_t           depth_ix;
+    size_t           api_ix;
+    size_t           ep_ix;
+    size_t           dir_ix;
+    uint16_t         vid;
+    uint16_t         pid;
+    uint32_t         xfer_nbr;
+    int              opt;
+    int              rtn;
+
+
+    vid       = BENCH_VID_DFLT;
+    pid       = BENCH_PID_DFLT;
+    xfer_nbr  = BENCH_XFER_NBR_DFLT;
+    len_nbr   = Bench_ListParse("64,512,4096,16384", len_tbl, BENCH_LIST_MAX);
+    depth_nbr = Bench_ListParse("1,2,4",             depth_tbl, BENCH_LIST_MAX);
+    api_nbr   = Bench_NameParse("sync,async",    Bench_API_NameTbl, 2u, api_tbl);
+    ep_nbr    = Bench_NameParse("bulk,intr",     Bench_EP_NameTbl,  2u, ep_tbl);
+    dir_nbr   = Bench_NameParse("out,in,loop",   Bench_DirNameTbl,  3u, dir_tbl);
+
+    while ((opt = getopt(argc, argv, "d:n:l:q:a:e:m:h")) != -1) {
+        switch (opt) {
+            case 'd':
+                 if (sscanf(optarg, "%hx:%hx", &vid, &pid) != 2) {
+                     Bench_Usage(argv[0]);
+                     return (1);
+                 }
+                 break;
+
+            case 'n':
+                 xfer_nbr = (uint32_t)strtoul(optarg, NULL, 0);
+                 break;
+
+            case 'l':
+                 len_nbr = Bench_ListParse(optarg, len_tbl, BENCH_LIST_MAX);
+                 break;
+
+            case 'q':
+                 depth_nbr = Bench_ListParse(optarg, depth_tbl, BENCH_LIST_MAX);
+                 break;
+
+            case 'a':
+                 api_nbr = Bench_NameParse(optarg, Bench_API_NameTbl, 2u, api_tbl);
+                 break;
+
+            case 'e':
+                 ep_nbr = Bench_NameParse(optarg, Bench_EP_NameTbl, 2u, ep_tbl);
+                 break;
+
+            case 'm':
+                 dir_nbr = Bench_NameParse(optarg, Bench_DirNameTbl, 3u, dir_tbl);
+                 break;
+
+            case 'h':
+            default:
+                 Bench_Usage(argv[0]);
+                 return (1);
+        }
+    }
+
+    if ((xfer_nbr  == 0u) ||
+        (len_nbr   == 0u) ||
+        (depth_nbr == 0u) ||
+        (api_nbr   == 0u) ||
+        (ep_nbr    == 0u) ||
+        (dir_nbr   == 0u)) {
+        Bench_Usage(argv[0]);
+        return (1);
+    }
+
+    if (libusb_init(&p_ctx) != 0) {
+        fprintf(stderr, "vendor_bench: libusb init failed\n");
+        return (1);
+    }
+
+    if (Bench_DevOpen(p_ctx, vid, pid, &dev) != 0) {
+        libusb_exit(p_ctx);
+        return (1);
+    }
+
+    rtn = 0;
+    for (api_ix = 0u; api_ix < api_nbr; api_ix++) {
+        for (ep_ix = 0u; ep_ix < ep_nbr; ep_ix++) {
+            for (dir_ix = 0u; dir_ix < dir_nbr; dir_ix++) {
+                for (len_ix = 0u; len_ix < len_nbr; len_ix++) {
+                    for (depth_ix = 0u; depth_ix < depth_nbr; depth_ix++) {
+                                                                /* Skip unsupported combinations (see Note #1).         */
+                        if ((len_tbl[len_ix]     == 0u)              ||
+                            (len_tbl[len_ix]     >  dev.XferLenMax)  ||
+                            (depth_tbl[depth_ix] == 0u)              ||
+                            (depth_tbl[depth_ix] >  dev.QueueMax)    ||
+                            (depth_tbl[depth_ix] >  BENCH_DEPTH_MAX)  ||
+                            (dev.EP_Tbl[ep_tbl[ep_ix]][0u] == 0u)) {
+                            continue;
+                        }
+                        if ((api_tbl[api_ix]     == BENCH_API_SYNC) &&
+                            (depth_tbl[depth_ix] != 1u)) {
+                            continue;
+                        }
+
+                        memset(&run, 0, sizeof(run));
+                        run.DevPtr  = &dev;
+                        run.API     = (uint8_t)api_tbl[api_ix];
+                        run.EP_Type = (uint8_t)ep_tbl[ep_ix];
+                        run.Dir     = (uint8_t)dir_tbl[dir_ix];
+                        run.Depth   = (uint8_t)depth_tbl[depth_ix];
+                        run.XferLen = len_tbl[len_ix];
+                        run.XferNbr = xfer_nbr;
+
+                        if (Bench_Run(&run) != 0) {
+                            rtn = 1;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    libusb_release_interface(dev.HandlePtr, dev.IF_Nbr);
+    libusb_close(dev.HandlePtr);
+    libusb_exit(p_ctx);
+
+    return (rtn);
+}
+
+
+/*
+*********************************************************************************************************
+*********************************************************************************************************
+*                                           LOCAL FUNCTIONS
+*********************************************************************************************************
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                          Bench_DevOpen()
+*
+* Description : Open the device and find its benchmark interface.
+*
+* Argument(s) : p_ctx       Pointer to libusb context.
+*
+*               vid         Vendor  ID of the device.
+*
+*               pid         Product ID of the device.
+*
+*               p_dev       Pointer to variable that will receive the benchmark interface.
+*
+* Return(s)   : 0, if the benchmark interface was found and claimed.
+*
+*              -1, otherwise.
+*
+* Note(s)     : (1) The device may expose several vendor-specific interfaces (e.g. the echo demos). The
+*                   benchmark interface is the first one with bulk endpoints that answers the BENCH_INFO
+*                   request. Its interrupt endpoints are optional.
+*********************************************************************************************************
+*/
+
+static  int  Bench_DevOpen (libusb_context  *p_ctx,
+                            uint16_t         vid,
+                            uint16_t         pid,
+                            BENCH_DEV       *p_dev)
+{
+    struct  libusb_config_descriptor           *p_cfg;
+    const  struct  libusb_interface_descriptor  *p_if;
+    const  struct  libusb_endpoint_descriptor   *p_ep;
+    uint8_t                                      if_ix;
+    uint8_t                                      ep_ix;
+    uint8_t                                      ep_type;
+    uint8_t                                      dir_in;
+    int                                          found;
+
+
+    memset(p_dev, 0, sizeof(BENCH_DEV));
+
+    p_dev->HandlePtr = libusb_open_device_with_vid_pid(p_ctx, vid, pid);
+    if (p_dev->HandlePtr == NULL) {
+        fprintf(stderr, "vendor_bench: device %04x:%04x not found\n", vid, pid);
+        return (-1);
+    }
+
+    (void)libusb_set_auto_detach_kernel_driver(p_dev->HandlePtr, 1);
+
+    if (libusb_get_active_config_descriptor(libusb_get_device(p_dev->HandlePtr), &p_cfg) != 0) {
+        fprintf(stderr, "vendor_bench: cannot read configuration descriptor\n");
+        libusb_close(p_dev->HandlePtr);
+        return (-1);
+    }
+
+    found = 0;
+    for (if_ix = 0u; (if_ix < p_cfg->bNumInterfaces) && (found == 0); if_ix++) {
+        p_if = &p_cfg->interface[if_ix].altsetting[0];
+        if ((p_if->bInterfaceClass != LIBUSB_CLASS_VENDOR_SPEC) ||
+            (p_if->bNumEndpoints   <  2u)) {
+            continue;
+        }
+
+        memset(p_dev->EP_Tbl, 0, sizeof(p_dev->EP_Tbl));
+        for (ep_ix = 0u; ep_ix < p_if->bNumEndpoints; ep_ix++) {
+            p_ep    = &p_if->endpoint[ep_ix];
+            ep_type =  p_ep->bmAttributes & LIBUSB_TRANSFER_TYPE_MASK;
+            dir_in  = ((p_ep->bEndpointAddress & LIBUSB_ENDPOINT_IN) != 0u) ? 1u : 0u;
+            if (ep_type == LIBUSB_TRANSFER_TYPE_BULK) {
+                p_dev->EP_Tbl[BENCH_EP_BULK][dir_in] = p_ep->bEndpointAddress;
+            } else if (ep_type == LIBUSB_TRANSFER_TYPE_INTERRUPT) {
+                p_dev->EP_Tbl[BENCH_EP_INTR][dir_in] = p_ep->bEndpointAddress;
+            }
+        }
+
+        if ((p_dev->EP_Tbl[BENCH_EP_BULK][0u] == 0u) ||
+            (p_dev->EP_Tbl[BENCH_EP_BULK][1u] == 0u)) {
+            continue;
+        }
+
+        p_dev->IF_Nbr = p_if->bInterfaceNumber;
+        if (libusb_claim_interface(p_dev->HandlePtr, p_dev->IF_Nbr) != 0) {
+            continue;
+        }
+
+        if (Bench_DevInfoGet(p_dev) == 0) {                     /* See Note #1.                                         */
+            found = 1;
+        } else {
+            libusb_release_interface(p_dev->HandlePtr, p_dev->IF_Nbr);
+        }
+    }
+
+    libusb_free_config_descriptor(p_cfg);
+
+    if (found == 0) {
+        fprintf(stderr, "vendor_bench: no benchmark interface on device %04x:%04x\n", vid, pid);
+        libusb_close(p_dev->HandlePtr);
+        return (-1);
+    }
+
+    return (0);
+}
+
+
+/*
+*********************************************************************************************************
+*                                         Bench_DevInfoGet()
+*
+* Description : Issue the BENCH_INFO request on the candidate interface.
+*
+* Argument(s) : p_dev       Pointer to benchmark interface.
+*
+* Return(s)   : 0, if the interface is a benchmark interface of a supported protocol version.
+*
+*              -1, otherwise.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  int  Bench_DevInfoGet (BENCH_DEV  *p_dev)
+{
+    uint8_t  buf[BENCH_INFO_LEN];
+    int      len;
+
+
+    len = libusb_control_transfer(p_dev->HandlePtr,
+                                  BENCH_REQ_TYPE_IN,
+                                  BENCH_REQ_INFO,
+                                  0u,
+                                  p_dev->IF_Nbr,
+                                  buf,
+                                  BENCH_INFO_LEN,
+                                  BENCH_CTRL_TIMEOUT_MS);
+    if ((len    != BENCH_INFO_LEN) ||
+        (buf[0] != 'U')            ||
+        (buf[1] != 'B')            ||
+        (buf[2] != BENCH_PROTOCOL_VER)) {
+        return (-1);
+    }
+
+    p_dev->URB_Extra  = buf[3];
+    p_dev->QueueMax   = buf[4];
+    p_dev->XferLenMax = (uint32_t)buf[8]
+                      | ((uint32_t)buf[9]  <<  8u)
+                      | ((uint32_t)buf[10] << 16u)
+                      | ((uint32_t)buf[11] << 24u);
+
+    return (0);
+}
+
+
+/*
+*********************************************************************************************************
+*                                            Bench_Run()
+*
+* Description : Execute one benchmark run and report its result.
+*
+* Argument(s) : p_run       Pointer to run parameters.
+*
+* Return(s)   : 0, if every transfer completed without error.
+*
+*              -1, otherwise.
+*
+* Note(s)     : (1) The host keeps 'Depth' transfers in flight. Each completion immediately starts the next
+*                   transfer on the same slot, until 'XferNbr' transfers were started.
+*
+*               (2) A transfer that fails or times out ends its slot. The device is then told to stop, and
+*                   the run is reported with its error count.
+*********************************************************************************************************
+*/
+
+static  int  Bench_Run (BENCH_RUN  *p_run)
+{
+    BENCH_DEV       *p_dev;
+    BENCH_SLOT      *p_slot;
+    uint8_t          start[BENCH_START_LEN];
+    struct  timespec time_start;
+    struct  timespec time_end;
+    struct  timeval  tv;
+    uint32_t         dev_xfer_cmpl;
+    uint32_t         dev_err;
+    uint32_t         slot_ix;
+    int              rtn;
+
+
+    p_dev         = p_run->DevPtr;
+    rtn           = 0;
+    dev_xfer_cmpl = 0u;
+    dev_err       = 0u;
+
+    p_run->LatTbl = (double *)calloc(p_run->XferNbr, sizeof(double));
+    if (p_run->LatTbl == NULL) {
+        return (-1);
+    }
+
+    for (slot_ix = 0u; slot_ix < p_run->Depth; slot_ix++) {
+        p_slot             = &p_run->SlotTbl[slot_ix];
+        p_slot->RunPtr     =  p_run;
+        p_slot->BufPtr     = (uint8_t *)malloc(p_run->XferLen);
+        p_slot->XferOutPtr =  libusb_alloc_transfer(0);
+        p_slot->XferInPtr  =  libusb_alloc_transfer(0);
+        if ((p_slot->BufPtr     == NULL) ||
+            (p_slot->XferOutPtr == NULL) ||
+            (p_slot->XferInPtr  == NULL)) {
+            rtn = -1;
+        } else {
+            memset(p_slot->BufPtr, (int)slot_ix, p_run->XferLen);
+        }
+    }
+                                                                /* --------------- START DEVICE SIDE ------------------ */
+    start[0] = p_run->API;
+    start[1] = p_run->EP_Type;
+    start[2] = p_run->Dir;
+    start[3] = p_run->Depth;
+    start[4] = (uint8_t)(p_run->XferLen);
+    start[5] = (uint8_t)(p_run->XferLen >>  8u);
+    start[6] = (uint8_t)(p_run->XferLen >> 16u);
+    start[7] = (uint8_t)(p_run->XferLen >> 24u);
+    start[8] = (uint8_t)(p_run->XferNbr);
+    start[9] = (uint8_t)(p_run->XferNbr >>  8u);
+    start[10] = (uint8_t)(p_run->XferNbr >> 16u);
+    start[11] = (uint8_t)(p_run->XferNbr >> 24u);
+
+    if ((rtn == 0) &&
+        (libusb_control_transfer(p_dev->HandlePtr,
+                                 BENCH_REQ_TYPE_OUT,
+                                 BENCH_REQ_START,
+                                 0u,
+                                 p_dev->IF_Nbr,
+                                 start,
+                                 BENCH_START_LEN,
+                                 BENCH_CTRL_TIMEOUT_MS) != BENCH_START_LEN)) {
+        fprintf(stderr, "vendor_bench: device refused run %s/%s/%s len %u depth %u\n",
+                Bench_API_NameTbl[p_run->API],
+                Bench_EP_NameTbl[p_run->EP_Type],
+                Bench_DirNameTbl[p_run->Dir],
+                (unsigned)p_run->XferLen,
+                (unsigned)p_run->Depth);
+        rtn = -1;
+    }
+                                                                /* ------------------ RUN TRANSFERS ------------------- */
+    if (rtn == 0) {
+        clock_gettime(CLOCK_MONOTONIC, &time_start);
+
+        for (slot_ix = 0u; slot_ix < p_run->Depth; slot_ix++) {
+            if (p_run->XferStartCnt < p_run->XferNbr) {         /* See Note #1.                                         */
+                if (Bench_SlotStart(&p_run->SlotTbl[slot_ix]) == 0) {
+                    p_run->PendNbr++;
+                } else {
+                    p_run->ErrCnt++;
+                }
+            }
+        }
+
+        while (p_run->PendNbr > 0u) {
+            tv.tv_sec  = 1;
+            tv.tv_usec = 0;
+            (void)libusb_handle_events_timeout(NULL, &tv);
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &time_end);
+                                                                /* ------------------ DEVICE RESULT ------------------- */
+        if (Bench_CtrlStop(p_dev, &dev_xfer_cmpl, &dev_err) != 0) {
+            rtn = -1;
+        }
+
+        Bench_Report(p_run, Bench_TimeDiffUs(&time_start, &time_end), dev_xfer_cmpl, dev_err);
+
+        if ((p_run->ErrCnt      != 0u)             ||           /* See Note #2.                                         */
+            (dev_err            != 0u)             ||
+            (p_run->XferCmplCnt != p_run->XferNbr)) {
+            rtn = -1;
+        }
+    }
+
+    for (slot_ix = 0u; slot_ix < p_run->Depth; slot_ix++) {
+        p_slot = &p_run->SlotTbl[slot_ix];
+        libusb_free_transfer(p_slot->XferOutPtr);
+        libusb_free_transfer(p_slot->XferInPtr);
+        free(p_slot->BufPtr);
+    }
+    free(p_run->LatTbl);
+
+    return (rtn);
+}
+
+
+/*
+*********************************************************************************************************
+*                                         Bench_SlotStart()
+*
+* Description : Start the next transfer on a slot.
+*
+* Argument(s) : p_slot      Pointer to transfer slot.
+*
+* Return(s)   : 0, if the transfer was submitted.
+*
+*              -1, otherwise.
+*
+* Note(s)     : (1) An OUT transfer starts the OUT and loopback transfers. An IN transfer starts the IN
+*                   transfers.
+*********************************************************************************************************
+*/
+
+static  int  Bench_SlotStart (BENCH_SLOT  *p_slot)
+{
+    BENCH_RUN                *p_run;
+    BENCH_DEV                *p_dev;
+    struct  libusb_transfer  *p_xfer;
+    uint8_t                   dir_in;
+    uint8_t                   ep_addr;
+
+
+    p_run  = p_slot->RunPtr;
+    p_dev  = p_run->DevPtr;
+    dir_in = (p_run->Dir == BENCH_DIR_IN) ? 1u : 0u;            /* See Note #1.                                         */
+    p_xfer = (dir_in == 1u) ? p_slot->XferInPtr : p_slot->XferOutPtr;
+    ep_addr = p_dev->EP_Tbl[p_run->EP_Type][dir_in];
+
+    if (p_run->EP_Type == BENCH_EP_BULK) {
+        libusb_fill_bulk_transfer(p_xfer, p_dev->HandlePtr, ep_addr, p_slot->BufPtr, (int)p_run->XferLen,
+                                  Bench_XferCmpl, p_slot, BENCH_TIMEOUT_MS);
+    } else {
+        libusb_fill_interrupt_transfer(p_xfer, p_dev->HandlePtr, ep_addr, p_slot->BufPtr, (int)p_run->XferLen,
+                                       Bench_XferCmpl, p_slot, BENCH_TIMEOUT_MS);
+    }
+
+    p_run->XferStartCnt++;
+    clock_gettime(CLOCK_MONOTONIC, &p_slot->TimeStart);
+
+    return ((libusb_submit_transfer(p_xfer) == 0) ? 0 : -1);
+}
+
+
+/*
+*********************************************************************************************************
+*                                          Bench_XferCmpl()
+*
+* Description : Callback called by libusb upon transfer completion.
+*
+* Argument(s) : p_xfer      Pointer to completed transfer.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) In loopback mode, the completion of the OUT transfer starts the IN transfer that
+*                   returns the data. The latency is recorded once the IN transfer completes.
+*********************************************************************************************************
+*/
+
+static  void  Bench_XferCmpl (struct  libusb_transfer  *p_xfer)
+{
+    BENCH_SLOT        *p_slot;
+    BENCH_RUN         *p_run;
+    BENCH_DEV         *p_dev;
+    struct  timespec   time_end;
+    uint8_t            ep_addr;
+
+
+    p_slot = (BENCH_SLOT *)p_xfer->user_data;
+    p_run  =  p_slot->RunPtr;
+    p_dev  =  p_run->DevPtr;
+
+    clock_gettime(CLOCK_MONOTONIC, &time_end);
+
+    if ((p_xfer->status        != LIBUSB_TRANSFER_COMPLETED) ||
+        (p_xfer->actual_length != (int)p_run->XferLen)) {
+        p_run->ErrCnt++;
+        p_run->PendNbr--;
+        return;
+    }
+
+    if ((p_run->Dir  == BENCH_DIR_LOOP) &&                      /* See Note #1.                                         */
+        (p_xfer      == p_slot->XferOutPtr)) {
+        ep_addr = p_dev->EP_Tbl[p_run->EP_Type][1u];
+        if (p_run->EP_Type == BENCH_EP_BULK) {
+            libusb_fill_bulk_transfer(p_slot->XferInPtr, p_dev->HandlePtr, ep_addr, p_slot->BufPtr,
+                                      (int)p_run->XferLen, Bench_XferCmpl, p_slot, BENCH_TIMEOUT_MS);
+        } else {
+            libusb_fill_interrupt_transfer(p_slot->XferInPtr, p_dev->HandlePtr, ep_addr, p_slot->BufPtr,
+                                           (int)p_run->XferLen, Bench_XferCmpl, p_slot, BENCH_TIMEOUT_MS);
+        }
+        if (libusb_submit_transfer(p_slot->XferInPtr) != 0) {
+            p_run->ErrCnt++;
+            p_run->PendNbr--;
+        }
+        return;
+    }
+
+    p_run->LatTbl[p_run->XferCmplCnt] = Bench_TimeDiffUs(&p_slot->TimeStart, &time_end);
+    p_run->XferCmplCnt++;
+
+    if (p_run->XferStartCnt >= p_run->XferNbr) {
+        p_run->PendNbr--;
+        return;
+    }
+
+    if (Bench_SlotStart(p_slot) != 0) {
+        p_run->ErrCnt++;
+        p_run->PendNbr--;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                          Bench_CtrlStop()
+*
+* Description : End the run on the device side and get the device counters.
+*
+* Argument(s) : p_dev               Pointer to benchmark interface.
+*
+*               p_dev_xfer_cmpl     Pointer to variable that will receive the number of transfers completed
+*                                   by the device.
+*
+*               p_dev_err           Pointer to variable that will receive the number of device errors.
+*
+* Return(s)   : 0, if the device ended the run.
+*
+*              -1, otherwise.
+*
+* Note(s)     : (1) A device blocked in a synchronous transfer only ends the run once its transfer times
+*                   out. The run in progress flag is polled until then.
+*********************************************************************************************************
+*/
+
+static  int  Bench_CtrlStop (BENCH_DEV  *p_dev,
+                             uint32_t   *p_dev_xfer_cmpl,
+                             uint32_t   *p_dev_err)
+{
+    uint8_t           buf[BENCH_RESULT_LEN];
+    struct  timespec  dly;
+    uint32_t          wait_ms;
+    int               len;
+
+
+    (void)libusb_control_transfer(p_dev->HandlePtr,
+                                  BENCH_REQ_TYPE_OUT,
+                                  BENCH_REQ_STOP,
+                                  0u,
+                                  p_dev->IF_Nbr,
+                                  NULL,
+                                  0u,
+                                  BENCH_CTRL_TIMEOUT_MS);
+
+    dly.tv_sec  = 0;
+    dly.tv_nsec = 10000000L;                                    /* Poll every 10 ms.                                    */
+    for (wait_ms = 0u; wait_ms <= BENCH_STOP_WAIT_MS; wait_ms += 10u) {
+        len = libusb_control_transfer(p_dev->HandlePtr,
+                                      BENCH_REQ_TYPE_IN,
+                                      BENCH_REQ_RESULT,
+                                      0u,
+                                      p_dev->IF_Nbr,
+                                      buf,
+                                      BENCH_RESULT_LEN,
+                                      BENCH_CTRL_TIMEOUT_MS);
+        if (len != BENCH_RESULT_LEN) {
+            return (-1);
+        }
+
+        if (buf[0] == 0u) {                                     /* See Note #1.                                         */
+           *p_dev_xfer_cmpl = (uint32_t)buf[4]
+                            | ((uint32_t)buf[5]  <<  8u)
+                            | ((uint32_t)buf[6]  << 16u)
+                            | ((uint32_t)buf[7]  << 24u);
+           *p_dev_err       = (uint32_t)buf[8]
+                            | ((uint32_t)buf[9]  <<  8u)
+                            | ((uint32_t)buf[10] << 16u)
+                            | ((uint32_t)buf[11] << 24u);
+            return (0);
+        }
+
+        nanosleep(&dly, NULL);
+    }
+
+    fprintf(stderr, "vendor_bench: device did not end the run\n");
+
+    return (-1);
+}
+
+
+/*
+*********************************************************************************************************
+*                                           Bench_Report()
+*
+* Description : Print the result of a run (see 'app_vendor_bench_host.c  Note #3').
+*
+* Argument(s) : p_run           Pointer to completed run.
+*
+*               elapsed_us      Duration of the run, in microseconds.
+*
+*               dev_xfer_cmpl   Number of transfers completed by the device.
+*
+*               dev_err         Number of device errors.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Throughput counts the payload moved in both directions in loopback mode.
+*********************************************************************************************************
+*/
+
+static  void  Bench_Report (BENCH_RUN  *p_run,
+                            double      elapsed_us,
+                            uint32_t    dev_xfer_cmpl,
+                            uint32_t    dev_err)
+{
+    double  octets;
+    double  mb_s;
+    double  xfer_s;
+
+
+    qsort(p_run->LatTbl, p_run->XferCmplCnt, sizeof(double), Bench_DblCmp);
+
+    octets = (double)p_run->XferCmplCnt * (double)p_run->XferLen;
+    if (p_run->Dir == BENCH_DIR_LOOP) {                         /* See Note #1.                                         */
+        octets *= 2.0;
+    }
+
+    mb_s   = 0.0;
+    xfer_s = 0.0;
+    if (elapsed_us > 0.0) {
+        mb_s   =  octets                      / elapsed_us;     /* Octets per us is MB/s.                               */
+        xfer_s = (double)p_run->XferCmplCnt   / elapsed_us * 1e6;
+    }
+
+    printf("{\"api\":\"%s\",\"ep\":\"%s\",\"dir\":\"%s\",\"xfer_len\":%u,\"depth\":%u,\"urb_extra\":%u,"
+           "\"xfer_nbr\":%u,\"xfer_cmpl\":%u,\"err\":%u,\"dev_xfer_cmpl\":%u,\"dev_err\":%u,"
+           "\"elapsed_us\":%.0f,\"mb_s\":%.3f,\"xfer_s\":%.1f,"
+           "\"lat_p50_us\":%.1f,\"lat_p99_us\":%.1f,\"lat_p999_us\":%.1f}\n",
+           Bench_API_NameTbl[p_run->API],
+           Bench_EP_NameTbl[p_run->EP_Type],
+           Bench_DirNameTbl[p_run->Dir],
+           (unsigned)p_run->XferLen,
+           (unsigned)p_run->Depth,
+           (unsigned)p_run->DevPtr->URB_Extra,
+           (unsigned)p_run->XferNbr,
+           (unsigned)p_run->XferCmplCnt,
+           (unsigned)p_run->ErrCnt,
+           (unsigned)dev_xfer_cmpl,
+           (unsigned)dev_err,
+           elapsed_us,
+           mb_s,
+           xfer_s,
+           Bench_Percentile(p_run->LatTbl, p_run->XferCmplCnt, 0.50),
+           Bench_Percentile(p_run->LatTbl, p_run->XferCmplCnt, 0.99),
+           Bench_Percentile(p_run->LatTbl, p_run->XferCmplCnt, 0.999));
+    fflush(stdout);
+}
+
+
+/*
+*********************************************************************************************************
+*                                          Bench_ListParse()
+*
+* Description : Parse a comma-separated list of numbers.
+*
+* Argument(s) : p_str       Pointer to string to parse.
+*
+*               p_list      Pointer to table that will receive the numbers.
+*
+*               list_max    Size of the table.
+*
+* Return(s)   : Number of entries parsed.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  size_t  Bench_ListParse (const  char      *p_str,
+                                        uint32_t  *p_list,
+                                        size_t     list_max)
+{
+    char    *p_end;
+    size_t   nbr;
+
+
+    nbr = 0u;
+    while ((*p_str != '\0') &&
+           (nbr    <  list_max)) {
+        p_list[nbr] = (uint32_t)strtoul(p_str, &p_end, 0);
+        if (p_end == p_str) {
+            return (0u);
+        }
+        nbr++;
+        p_str = (*p_end == ',') ? (p_end + 1) : p_end;
+    }
+
+    return (nbr);
+}
+
+
+/*
+*********************************************************************************************************
+*                                          Bench_NameParse()
+*
+* Description : Parse a comma-separated list of names into their index in a name table.
+*
+* Argument(s) : p_str       Pointer to string to parse.
+*
+*               p_name_tbl  Pointer to table of valid names.
+*
+*               name_nbr    Number of valid names.
+*
+*               p_list      Pointer to table that will receive the indexes. Must hold 'name_nbr' entries.
+*
+* Return(s)   : Number of entries parsed, or 0 if a name is unknown.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  size_t  Bench_NameParse (const  char       *p_str,
+                                 const  char      **p_name_tbl,
+                                        size_t      name_nbr,
+                                        uint32_t   *p_list)
+{
+    size_t  nbr;
+    size_t  name_ix;
+    size_t  len;
+
+
+    nbr = 0u;
+    while (*p_str != '\0') {
+        len = strcspn(p_str, ",");
+        for (name_ix = 0u; name_ix < name_nbr; name_ix++) {
+            if ((strlen(p_name_tbl[name_ix])                 == len) &&
+                (strncmp(p_str, p_name_tbl[name_ix], len) == 0)) {
+                break;
+            }
+        }
+        if ((name_ix == name_nbr) ||
+            (nbr     >= name_nbr)) {
+            return (0u);
+        }
+        p_list[nbr++] = (uint32_t)name_ix;
+        p_str        += (p_str[len] == ',') ? (len + 1u) : len;
+    }
+
+    return (nbr);
+}
+
+
+/*
+*********************************************************************************************************
+*                                         Bench_TimeDiffUs()
+*
+* Description : Compute the time elapsed between two timestamps.
+*
+* Argument(s) : p_start     Pointer to start timestamp.
+*
+*               p_end       Pointer to end timestamp.
+*
+* Return(s)   : Elapsed time, in microseconds.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  double  Bench_TimeDiffUs (const  struct  timespec  *p_start,
+                                  const  struct  timespec  *p_end)
+{
+    return (((double)(p_end->tv_sec  - p_start->tv_sec)  * 1e6) +
+            ((double)(p_end->tv_nsec - p_start->tv_nsec) / 1e3));
+}
+
+
+/*
+*********************************************************************************************************
+*                                         Bench_Percentile()
+*
+* Description : Get a percentile of a sorted table, with the nearest-rank method.
+*
+* Argument(s) : p_sorted    Pointer to sorted table.
+*
+*               nbr         Number of entries in table.
+*
+*               pct         Percentile, between 0 and 1.
+*
+* Return(s)   : Value of the percentile, or 0 if the table is empty.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  double  Bench_Percentile (const  double    *p_sorted,
+                                         uint32_t   nbr,
+                                         double     pct)
+{
+    uint32_t  rank;
+
+
+    if (nbr == 0u) {
+        return (0.0);
+    }
+
+    rank = (uint32_t)(pct * (double)nbr + 0.999999);            /* Ceil of pct * nbr.                                   */
+    if (rank == 0u) {
+        rank = 1u;
+    }
+    if (rank > nbr) {
+        rank = nbr;
+    }
+
+    return (p_sorted[rank - 1u]);
+}
+
+
+/*
+*********************************************************************************************************
+*                                           Bench_DblCmp()
+*
+* Description : Compare two doubles for qsort().
+*
+* Argument(s) : p_a         Pointer to first value.
+*
+*               p_b         Pointer to second value.
+*
+* Return(s)   : Negative, zero or positive value, as 'p_a' is lower, equal or greater than 'p_b'.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  int  Bench_DblCmp (const  void  *p_a,
+                           const  void  *p_b)
+{
+    double  a;
+    double  b;
+
+
+    a = *(const double *)p_a;
+    b = *(const double *)p_b;
+
+    return ((a > b) - (a < b));
+}
+
+
+/*
+*********************************************************************************************************
+*                                           Bench_Usage()
+*
+* Description : Print the command line syntax.
+*
+* Argument(s) : p_prog      Name of the program.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  void  Bench_Usage (const  char  *p_prog)
+{
+    fprintf(stderr,
+            "usage: %s [-d vid:pid] [-n xfer_nbr] [-l len,...] [-q depth,...]\n"
+            "          [-a sync,async] [-e bulk,intr] [-m out,in,loop]\n"
+            "\n"
+            "  -d  device to open              (default fffe:1234)\n"
+            "  -n  transfers per run           (default %u)\n"
+            "  -l  transfer lengths, in octets (default 64,512,4096,16384)\n"
+            "  -q  queue depths                (default 1,2,4)\n"
+            "  -a  device API                  (default sync,async)\n"
+            "  -e  endpoint types              (default bulk,intr)\n"
+            "  -m  directions                  (default out,in,loop)\n"
+            "\n"
+            "Results are printed as one JSON object per run on the standard output.\n",
+            p_prog,
+            (unsigned)BENCH_XFER_NBR_DFLT);
+}
@@ -55,6 +55,11 @@
 #define  USBD_CFG_MAX_NBR_DEV                              1u
                                                                 /* Must be between 1u and 255u.                         */
 
+                                                                /* Core Task per Device.                                */
+#define  USBD_CFG_CORE_TASK_PER_DEV_EN          DEF_DISABLED
+                                                                /* DEF_ENABLED  One core task & event q per device.     */
+                                                                /* DEF_DISABLED One core task shared by all devices.    */
+
                                                                 /* Buffer Alignment in uC/USB-Device.                   */
 #define  USBD_CFG_BUF_ALIGN_OCTETS                         4u
                                                                 /* Must be between 1u and 2^(CPU_CFG_DATA_SIZE * 8).    */
@@ -94,6 +99,35 @@
                                                                 /* See Note #1.                                         */
 
 
+/*
+*********************************************************************************************************
+*                     USB DEVICE CONFIGURATION DESCRIPTOR CACHE CONFIGURATION
+*
+* Note(s) : (1) Configure USBD_CFG_DESC_CACHE_EN to enable or disable the configuration descriptor cache.
+*
+*               (a) When DEF_ENABLED,  each configuration descriptor is built once, on the first Get
+*                   Descriptor request received after USBD_DevStart(), and kept in a buffer allocated
+*                   from the heap. Subsequent requests are answered from this buffer with a single
+*                   control transfer. The cached descriptor is discarded whenever the device topology
+*                   changes (interface, alternate setting, endpoint or string added).
+*               (b) When DEF_DISABLED, the configuration descriptor is rebuilt on every request.
+*
+*           (2) USBD_CFG_DESC_CACHE_BUF_LEN is the size of the cache buffer allocated for each
+*               configuration. It should be set to the length of the largest configuration descriptor
+*               of the application. A configuration descriptor that does not fit is rebuilt on every
+*               request, without trying the cache again until the cache is discarded (see Note #1a).
+*********************************************************************************************************
+*/
+
+                                                                /* Configuration Descriptor Cache.                      */
+#define  USBD_CFG_DESC_CACHE_EN                 DEF_DISABLED
+                                                                /* See Note #1.                                         */
+
+                                                                /* Size of Configuration Descriptor Cache Buffer.       */
+#define  USBD_CFG_DESC_CACHE_BUF_LEN                     256u
+                                                                /* Must be between 9u and 65534u (see Note #2).         */
+
+
 /*
 *********************************************************************************************************
 *                                      USB DEVICE CONFIGURATIONS
@@ -124,6 +158,58 @@
 /*
 *********************************************************************************************************
 *                                 USB DEVICE INTERFACES CONFIGURATION
+*
+* Note(s) : (1) Configure USBD_CFG_EP_PRE_QUEUE_EN to let the core keep several asynchronous URBs
+*               submitted to the device controller on the same endpoint.
+*
+*               (a) When DEF_ENABLED, the number of URBs submitted at once on an endpoint is bounded by
+*                   the depth reported by the driver's optional 'EP_QueueDepthGet()' function. Drivers
+*                   that do NOT implement it are given one URB at a time; the others are held by the
+*                   core and submitted as soon as the previous one completes.
+*
+*               (b) When DEF_DISABLED, every asynchronous URB is submitted to the driver when queued.
+*
+*               (c) Enough URBs MUST be available to fill the controller's queue. To keep N URBs
+*                   outstanding on an endpoint, USBD_CFG_MAX_NBR_URB_EXTRA should be at least (N - 1).
+*
+*           (2) Configure USBD_CFG_EP_DIRECT_CMPL_EN to allow endpoints to complete asynchronous
+*               transfers directly from the driver's ISR, without going through the core task.
+*
+*               (a) When DEF_ENABLED, the direct completion is enabled per endpoint by the application
+*                   or class with USBD_EP_DirectCmplSet(). The callbacks of these endpoints are then
+*                   executed from the ISR context and MUST NOT block.
+*
+*               (b) When DEF_DISABLED, every asynchronous completion is processed by the core task.
+*
+*               (c) The driver's ISR MUST never run at the same time as a task. Direct completion can
+*                   only be enabled with single-core ports whose drivers notify completions from a
+*                   hardware interrupt. It is NOT supported by the POSIX OS port nor by the simulation
+*                   driver, which notify completions from threads.
+*
+*           (3) Each opened endpoint owns one URB. The additional URBs configured by
+*               USBD_CFG_MAX_NBR_URB_EXTRA are shared by all the endpoints of a device. By default, any
+*               endpoint can use all of them; USBD_EP_URB_QuotaSet() reserves extra URBs for an endpoint
+*               and limits the number of extra URBs it can use at once.
+*
+*           (4) Configure USBD_CFG_EP_VEC_XFER_EN to enable the vectored asynchronous transfer functions
+*               (USBD_BulkRxVecAsync(), USBD_BulkTxVecAsync(), USBD_IntrRxVecAsync() and
+*               USBD_IntrTxVecAsync()).
+*
+*               (a) A packet that straddles two segments is transferred through a per-endpoint packet
+*                   buffer of USBD_CFG_EP_VEC_BUF_LEN octets, allocated from the heap the first time a
+*                   vectored transfer is queued on the endpoint.
+*
+*               (b) USBD_CFG_EP_VEC_BUF_LEN MUST be greater than or equal to the maximum packet size of
+*                   every endpoint used for vectored transfers.
+*
+*           (5) Configure USBD_CFG_EP_CMPL_COALESCE_EN to merge the asynchronous completions of a device
+*               that are waiting for the core task.
+*
+*               (a) When DEF_ENABLED, the driver's ISR marks the endpoint as pending instead of queuing a
+*                   core event for each completion. A single core event is queued until the core task
+*                   processes every pending completion of the device.
+*
+*               (b) When DEF_DISABLED, each completion queues its own core event.
 *********************************************************************************************************
 */
 
@@ -150,7 +236,27 @@
                                                                 /* Maximum Number of Additional URBs.                   */
                                                                 /* These URBs are used for async queueing.              */
 #define  USBD_CFG_MAX_NBR_URB_EXTRA                        0u
-                                                                /* Must be between 0u and 255u.                         */
+                                                                /* Must be between 0u and 255u (see Note #3).           */
+
+                                                                /* Configure Async URB Pre-Queuing in Controller.       */
+#define  USBD_CFG_EP_PRE_QUEUE_EN               DEF_DISABLED
+                                                                /* See Note #1.                                         */
+
+                                                                /* Configure Async Xfer Completion from ISR.            */
+#define  USBD_CFG_EP_DIRECT_CMPL_EN             DEF_DISABLED
+                                                                /* See Note #2.                                         */
+
+                                                                /* Configure Vectored Async Xfer Functions.             */
+#define  USBD_CFG_EP_VEC_XFER_EN                DEF_DISABLED
+                                                                /* See Note #4.                                         */
+
+                                                                /* Vectored Xfer Straddle Packet Buffer Length.         */
+#define  USBD_CFG_EP_VEC_BUF_LEN                         512u
+                                                                /* See Note #4b.                                        */
+
+                                                                /* Configure Async Xfer Completion Coalescing.          */
+#define  USBD_CFG_EP_CMPL_COALESCE_EN           DEF_DISABLED
+                                                                /* See Note #5.                                         */
 
 
 /*
@@ -179,6 +285,12 @@
 #define  USBD_CFG_DBG_TRACE_NBR_EVENTS                    10u
                                                                 /* Must be between 1u and 255u.                         */
 
+                                                                /* Debug Module Binary Trace Support.                   */
+#define  USBD_CFG_DBG_TRACE_BIN_EN              DEF_DISABLED
+                                                                /* DEF_ENABLED  Events stored in binary ring, ...       */
+                                                                /* ...          decoded offline.                        */
+                                                                /* DEF_DISABLED Events formatted by debug task.         */
+
                                                                 /* Debug Module Built-In Statistics Support.            */
 #define  USBD_CFG_DBG_STATS_EN                  DEF_DISABLED
                                                                 /* DEF_ENABLED  Built-in statistics are     available.  */
@@ -188,6 +300,53 @@
 #define  USBD_CFG_DBG_STATS_CNT_TYPE            CPU_INT08U
                                                                 /* CPU_INT08U, CPU_INT16U or CPU_INT32U.                */
 
+                                                                /* Debug Module EP Latency Histograms Support.          */
+#define  USBD_CFG_DBG_STATS_LAT_EN              DEF_DISABLED
+                                                                /* DEF_ENABLED  EP latency histograms are     avail.    */
+                                                                /* DEF_DISABLED EP latency histograms are not avail.    */
+                                                                /* Requires USBD_CFG_DBG_STATS_EN and CPU_CFG_TS_32_EN. */
+
+                                                                /* Number of Bins per Latency Histogram.                */
+#define  USBD_CFG_DBG_STATS_LAT_NBR_BIN                   24u
+                                                                /* Must be between 1u and 32u.                          */
+
+                                                                /* Debug Module Pool Usage Statistics Support.          */
+#define  USBD_CFG_DBG_STATS_POOL_EN             DEF_DISABLED
+                                                                /* DEF_ENABLED  Pool usage stats are     available.     */
+                                                                /* DEF_DISABLED Pool usage stats are not available.     */
+
+
+/*
+*********************************************************************************************************
+*                                USB DEVICE TRAFFIC CAPTURE CONFIGURATION
+*
+* Note(s) : (1) Configure USBD_CFG_CAPTURE_EN to enable or disable the traffic capture.
+*
+*               (a) When DEF_ENABLED,  setup packets, transfer submissions to the driver and transfer
+*                   completions are recorded in a RAM ring buffer, in pcap format. The ring is drained
+*                   with USBD_CaptureRd() (see 'usbd_core.h  TRAFFIC CAPTURE').
+*               (b) When DEF_DISABLED, no traffic is recorded.
+*
+*           (2) USBD_CFG_CAPTURE_BUF_LEN is the size of the ring buffer. A record that does not fit in the
+*               free space of the ring is dropped.
+*
+*           (3) USBD_CFG_CAPTURE_SNAP_LEN is the maximum number of payload octets recorded per transfer.
+*               The payload is copied with interrupts disabled and should be kept small.
+*********************************************************************************************************
+*/
+
+                                                                /* Traffic Capture Support.                             */
+#define  USBD_CFG_CAPTURE_EN                    DEF_DISABLED
+                                                                /* See Note #1.                                         */
+
+                                                                /* Size of Capture Ring Buffer, in Octets.              */
+#define  USBD_CFG_CAPTURE_BUF_LEN                       4096u
+                                                                /* Must be at least 128u (see Note #2).                 */
+
+                                                                /* Maximum Payload Octets Captured per Transfer.        */
+#define  USBD_CFG_CAPTURE_SNAP_LEN                        32u
+                                                                /* Must be between 0u and 1024u (see Note #3).          */
+
 
 /*
 *********************************************************************************************************
@@ -384,6 +543,109 @@
 *               defined with a value other than 0, the RAM disk data area will be set from this base
 *               address directly. Conversely, if it is equal to 0, the RAM disk data area will be
 *               represented as a table from the program's data area.
+*
+*           (4) USBD_MSC_CFG_ZERO_COPY_EN allows READ and WRITE data to be transferred directly from/to
+*               a buffer owned by the storage layer (see USBD_StorageRdPtrGet() and
+*               USBD_StorageWrPtrGet()), bypassing the MSC data buffer. Storage layers that cannot
+*               expose their medium, or return a buffer not aligned on USBD_CFG_BUF_ALIGN_OCTETS, fall
+*               back to the MSC data buffer.
+*
+*               DEF_ENABLED      Use storage-owned buffers when the storage layer provides them.
+*               DEF_DISABLED     Always copy through the MSC data buffer.
+*
+*           (5) USBD_MSC_CFG_DATA_BUF_NBR sets the number of data buffers of USBD_MSC_CFG_DATA_LEN octets
+*               allocated per MSC instance. With a single buffer, the data stage alternates between
+*               storage accesses and bulk transfers. With two or more buffers, the data stage is
+*               pipelined with asynchronous bulk transfers so that the storage accesses of one buffer
+*               overlap the USB transfer of the others. Up to (USBD_MSC_CFG_DATA_BUF_NBR - 1) transfers
+*               are queued on a bulk endpoint; queuing more than one requires extra URBs (see
+*               USBD_CFG_MAX_NBR_URB_EXTRA).
+*
+*           (6) USBD_MSC_CFG_CACHE_EN enables a write-back block cache between the SCSI layer and the
+*               storage layer. Each logical unit caches up to USBD_MSC_CFG_CACHE_NBR_BLK blocks, replaced
+*               in least recently used order. Written blocks stay in the cache until they are evicted or
+*               until the host sends SYNCHRONIZE CACHE or ejects the medium with START STOP UNIT. READ and
+*               WRITE commands longer than USBD_MSC_CFG_CACHE_NBR_BLK blocks only use blocks that are
+*               already cached and otherwise access the storage layer directly. Logical units whose block
+*               size exceeds USBD_MSC_CFG_CACHE_BLK_SIZE are not cached. Written data still held in the
+*               cache is lost if the device loses power.
+*
+*               DEF_ENABLED      Cache the blocks of each logical unit.
+*               DEF_DISABLED     Always access the storage layer directly.
+*
+*           (7) USBD_MSC_CFG_UNMAP_EN enables logical block provisioning. The host can then release the
+*               blocks it no longer uses with UNMAP, or WRITE SAME with the UNMAP bit set. Released blocks
+*               are passed to the storage layer with USBD_StorageUnmap(), which flash based storage layers
+*               can use to reclaim them. The data read from a released block is undefined until the block
+*               is written again.
+*
+*               DEF_ENABLED      Report logical block provisioning & pass released blocks to the storage.
+*               DEF_DISABLED     UNMAP is not supported.
+*
+*           (8) USBD_MSC_CFG_STORAGE_ASYNC_EN lets the pipelined data stage (see Note #5) start READ and
+*               WRITE storage accesses with USBD_StorageRdAsync() and USBD_StorageWrAsync(). The storage
+*               layer reports the end of each access with a completion callback, so that a DMA driven
+*               medium transfers data while the MSC task keeps the bulk endpoint busy. Logical units whose
+*               storage layer returns a queue depth of 0 from USBD_StorageAsyncQDepthGet(), and cached
+*               logical units, use the blocking USBD_StorageRd() and USBD_StorageWr(). Requires
+*               USBD_MSC_CFG_DATA_BUF_NBR to be at least 2u.
+*
+*               DEF_ENABLED      Use asynchronous storage accesses when the storage layer provides them.
+*               DEF_DISABLED     Always use blocking storage accesses.
+*
+*           (9) USBD_MSC_CFG_RD_AHEAD_EN enables a read-ahead window per logical unit. When a READ command
+*               starts at the block following the previous READ command of the same logical unit, the
+*               read is considered sequential and, once its CSW is sent, the next
+*               USBD_MSC_CFG_RD_AHEAD_NBR_BLK blocks are read into the window with a single storage access.
+*               The following READ commands are served from the window without accessing the storage
+*               layer. Written or released blocks are dropped from the window. Logical units whose block
+*               size exceeds USBD_MSC_CFG_RD_AHEAD_BLK_SIZE do not use read-ahead. Cannot be used with the
+*               block cache (see Note #6), which already keeps the blocks read.
+*
+*               DEF_ENABLED      Prefetch the blocks following sequential reads.
+*               DEF_DISABLED     Only read the blocks requested by the host.
+*
+*          (10) USBD_MSC_CFG_UAS_EN adds a USB Attached SCSI (UAS) alternate setting to each MSC interface,
+*               next to the Bulk-Only Transport of the default setting. UAS uses a command, a status, a
+*               data-IN and a data-OUT bulk endpoint (USB 2.0 protocol, without streams). Up to
+*               USBD_MSC_CFG_UAS_Q_DEPTH commands are queued by the host, each identified by its tag; the
+*               command pipe is NAKed while the queue is full. Queued commands are executed in order of
+*               arrival. Each MSC interface then needs 2 interface alternate settings, and the UAS setting
+*               opens 4 bulk endpoints (see USBD_CFG_MAX_NBR_IF_ALT & USBD_CFG_MAX_NBR_EP_OPEN).
+*
+*               DEF_ENABLED      Offer UAS as alternate setting 1 of the MSC interface.
+*               DEF_DISABLED     Only Bulk-Only Transport is offered.
+*
+*          (11) USBD_MSC_CFG_DATA_POOL_EN replaces the data buffers allocated per MSC instance (see Note #5)
+*               with a pool of USBD_MSC_CFG_DATA_POOL_LEN octets shared by all MSC instances and logical
+*               units. The pool is divided in segments of USBD_MSC_CFG_DATA_LEN octets, rounded up to
+*               USBD_CFG_BUF_ALIGN_OCTETS. At the start of each data stage, every data buffer is taken as a
+*               run of contiguous segments covering the data length of the command, as far as the free
+*               segments allow, and is returned to the pool at the end of the data stage. Large transfers
+*               then need fewer storage accesses and bulk transfers. USBD_MSC_CFG_DATA_BUF_NBR segments
+*               stay guaranteed to each MSC instance, so the pool must hold at least
+*               (USBD_MSC_CFG_MAX_NBR_DEV * USBD_MSC_CFG_DATA_BUF_NBR) segments.
+*
+*               DEF_ENABLED      Size the data buffers of each data stage from a shared pool.
+*               DEF_DISABLED     Use fixed data buffers of USBD_MSC_CFG_DATA_LEN octets per MSC instance.
+*
+*          (12) USBD_RAMDISK_CFG_SPARSE_EN makes the RAMDisk sparse. Each logical block of each unit is
+*               mapped to a block of a pool of USBD_RAMDISK_CFG_POOL_NBR_BLKS blocks shared by all units.
+*               Blocks holding only zeros are not mapped and take no space in the pool. Blocks with the
+*               same content are found through a content hash and share one pool block. The logical
+*               size of the units (USBD_RAMDISK_CFG_NBR_BLKS) may then exceed the size of the pool, which
+*               is placed at USBD_RAMDISK_CFG_BASE_ADDR if it is not 0 (see Note #3). A write for which
+*               the pool has no free block fails, and the host is told that space allocation failed.
+*               The blocks are not contiguous in memory, so USBD_StorageRdPtrGet() and
+*               USBD_StorageWrPtrGet() are not available (see Note #4). USBD_RAMDISK_UsageGet() reports
+*               the pool usage against the logical capacity.
+*
+*               DEF_ENABLED      Store the RAMDisk blocks in a shared, deduplicated block pool.
+*               DEF_DISABLED     Reserve the whole data area of each RAMDisk unit.
+*
+*          (13) USBD_RAMDISK_CFG_NBR_UNITS is the total number of RAMDisk units for all MSC class
+*               instances. A unit is assigned to each logical unit in the order the logical units are
+*               added. Adding a logical unit fails once all the units are assigned.
 *********************************************************************************************************
 */
 
@@ -403,6 +665,18 @@
 #define  USBD_MSC_CFG_DATA_LEN                          2048u
                                                                 /* Must be between 1u and DEF_INT_32U_MAX_VAL.          */
 
+                                                                /* Number of Data Buffers.                              */
+#define  USBD_MSC_CFG_DATA_BUF_NBR                         1u
+                                                                /* See Note #5. Must be between 1u and 255u.            */
+
+                                                                /* Shared Data Buffer Pool.                             */
+#define  USBD_MSC_CFG_DATA_POOL_EN              DEF_DISABLED
+                                                                /* See Note #11.                                        */
+
+                                                                /* Data Buffer Pool Length, in octets.                  */
+#define  USBD_MSC_CFG_DATA_POOL_LEN                    16384u
+                                                                /* See Note #11.                                        */
+
                                                                 /* Use uC/FS MSC class interface.                       */
 #define  USBD_MSC_CFG_MICRIUM_FS                DEF_DISABLED
                                                                 /* See Note #1.                                         */
@@ -415,9 +689,53 @@
 #define  USBD_MSC_CFG_DEV_POLL_DLY_mS                    100u
                                                                 /* Must be between 1u and DEF_INT_32U_MAX_VAL.          */
 
+                                                                /* Zero-Copy Data Transfers.                            */
+#define  USBD_MSC_CFG_ZERO_COPY_EN              DEF_DISABLED
+                                                                /* See Note #4.                                         */
+
+                                                                /* Write-Back Block Cache.                              */
+#define  USBD_MSC_CFG_CACHE_EN                  DEF_DISABLED
+                                                                /* See Note #6.                                         */
+
+                                                                /* Number of Cached Blocks per Logical Unit.            */
+#define  USBD_MSC_CFG_CACHE_NBR_BLK                       16u
+                                                                /* See Note #6. Must be between 1u and 255u.            */
+
+                                                                /* Maximum Cached Block Size, in octets.                */
+#define  USBD_MSC_CFG_CACHE_BLK_SIZE                     512u
+                                                                /* See Note #6. Must be at least 1u.                    */
+
+                                                                /* Logical Block Provisioning (UNMAP).                  */
+#define  USBD_MSC_CFG_UNMAP_EN                  DEF_DISABLED
+                                                                /* See Note #7.                                         */
+
+                                                                /* Asynchronous Storage Accesses.                       */
+#define  USBD_MSC_CFG_STORAGE_ASYNC_EN          DEF_DISABLED
+                                                                /* See Note #8.                                         */
+
+                                                                /* Sequential Read-Ahead.                               */
+#define  USBD_MSC_CFG_RD_AHEAD_EN               DEF_DISABLED
+                                                                /* See Note #9.                                         */
+
+                                                                /* Number of Read-Ahead Blocks per Logical Unit.        */
+#define  USBD_MSC_CFG_RD_AHEAD_NBR_BLK                    64u
+                                                                /* See Note #9. Must be at least 1u.                    */
+
+                                                                /* Maximum Read-Ahead Block Size, in octets.            */
+#define  USBD_MSC_CFG_RD_AHEAD_BLK_SIZE                  512u
+                                                                /* See Note #9. Must be at least 1u.                    */
+
+                                                                /* USB Attached SCSI (UAS).                             */
+#define  USBD_MSC_CFG_UAS_EN                    DEF_DISABLED
+                                                                /* See Note #10.                                        */
+
+                                                                /* Number of Queued UAS Commands.                       */
+#define  USBD_MSC_CFG_UAS_Q_DEPTH                          4u
+                                                                /* See Note #10. Must be between 1u and 255u.           */
+
                                                                 /* Number of RAMDisk units.                             */
 #define  USBD_RAMDISK_CFG_NBR_UNITS                        1u
-                                                                /* Must be at least 1.                                  */
+                                                                /* See Note #13. Must be between 1u and 254u.           */
 
                                                                 /* RAMDisk block size.                                  */
 #define  USBD_RAMDISK_CFG_BLK_SIZE                       512u
@@ -431,6 +749,14 @@
 #define  USBD_RAMDISK_CFG_BASE_ADDR                        0u
                                                                 /* See Note #3.                                         */
 
+                                                                /* Sparse, deduplicated RAMDisk.                        */
+#define  USBD_RAMDISK_CFG_SPARSE_EN             DEF_DISABLED
+                                                                /* See Note #12.                                        */
+
+                                                                /* Number of blocks in the sparse RAMDisk block pool.   */
+#define  USBD_RAMDISK_CFG_POOL_NBR_BLKS                   44u
+                                                                /* See Note #12. Must be between 1u and 65535u.         */
+
 
 /*
 *********************************************************************************************************
@@ -280,6 +280,11 @@ static  CPU_INT08U                 USBD_Audio_CtrlNbrNext;
                                                                 /* Audio class comm tbl.                                */
 static  USBD_AUDIO_COMM            USBD_Audio_CommTbl[USBD_AUDIO_MAX_NBR_COMM];
 static  CPU_INT08U                 USBD_Audio_CommNbrNext;
+#if (USBD_CFG_DBG_STATS_POOL_EN == DEF_ENABLED)
+                                                                /* Usage stats of class instances & comm tbl.           */
+static  USBD_DBG_STATS_POOL        USBD_Audio_DbgStatsPoolCtrl;
+static  USBD_DBG_STATS_POOL        USBD_Audio_DbgStatsPoolComm;
+#endif
                                                                 /* Input Terminal tbl.                                  */
 static  USBD_AUDIO_IT              USBD_Audio_IT_Tbl[USBD_AUDIO_CFG_MAX_NBR_IT];
 static  CPU_INT08U                 USBD_Audio_IT_NbrNext;
@@ -572,6 +577,9 @@ void  USBD_Audio_Init (CPU_INT16U   msg_qty,
 
     USBD_Audio_CtrlNbrNext = 0u;
     USBD_Audio_CommNbrNext = 0u;
+
+    USBD_DBG_STATS_POOL_REG(&USBD_Audio_DbgStatsPoolCtrl, "Audio ctrl", USBD_AUDIO_CFG_MAX_NBR_AIC);
+    USBD_DBG_STATS_POOL_REG(&USBD_Audio_DbgStatsPoolComm, "Audio comm", USBD_AUDIO_MAX_NBR_COMM);
     USBD_Audio_IT_NbrNext  = 0u;
     USBD_Audio_OT_NbrNext  = 0u;
     USBD_Audio_FU_NbrNext  = 0u;
@@ -651,12 +659,15 @@ CPU_INT08U  USBD_Audio_Add (       CPU_INT08U                  entity_cnt,
 
     if (class_nbr >= USBD_AUDIO_CFG_MAX_NBR_AIC) {
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FAIL(&USBD_Audio_DbgStatsPoolCtrl);
        *p_err = USBD_ERR_AUDIO_INSTANCE_ALLOC;
         return (USBD_CLASS_NBR_NONE);
     }
 
     USBD_Audio_CtrlNbrNext++;                                   /* Next avail audio class instance nbr.                 */
     CPU_CRITICAL_EXIT();
+
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_Audio_DbgStatsPoolCtrl);
                                                                 /* ------------- STORE CLASS INSTANCE INFO ------------ */
     p_ctrl            = &USBD_Audio_CtrlTbl[class_nbr];         /* Get audio class instance.                            */
     p_ctrl->ClassNbr  =  class_nbr;
@@ -811,6 +822,7 @@ void  USBD_Audio_CfgAdd (CPU_INT08U   class_nbr,
 
     if (comm_ix >= USBD_AUDIO_MAX_NBR_COMM) {                   /* Check that comm index is within max range.           */
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FAIL(&USBD_Audio_DbgStatsPoolComm);
        *p_err = USBD_ERR_AUDIO_INSTANCE_ALLOC;
         return;
     }
@@ -818,6 +830,8 @@ void  USBD_Audio_CfgAdd (CPU_INT08U   class_nbr,
     USBD_Audio_CommNbrNext++;
     CPU_CRITICAL_EXIT();
 
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_Audio_DbgStatsPoolComm);
+
     p_comm         = &USBD_Audio_CommTbl[comm_ix];
     p_comm->CfgNbr =  cfg_nbr;
                                                                 /* ------- CFG DESC CONSTRUCTION (see Note #2) -------- */
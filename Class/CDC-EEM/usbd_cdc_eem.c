@@ -311,6 +311,11 @@ static  CPU_INT08U         USBD_CDC_EEM_CtrlNbrNext;
                                                                 /* CDC EEM class comm array.                             */
 static  USBD_CDC_EEM_COMM  USBD_CDC_EEM_CommTbl[USBD_CDC_EEM_COMM_NBR_MAX];
 static  CPU_INT08U         USBD_CDC_EEM_CommNbrNext;
+#if (USBD_CFG_DBG_STATS_POOL_EN == DEF_ENABLED)
+                                                                /* Usage stats of CDC EEM arrays.                       */
+static  USBD_DBG_STATS_POOL  USBD_CDC_EEM_DbgStatsPoolCtrl;
+static  USBD_DBG_STATS_POOL  USBD_CDC_EEM_DbgStatsPoolComm;
+#endif
 
 
 /*
@@ -469,6 +474,9 @@ void  USBD_CDC_EEM_Init (USBD_ERR  *p_err)
     USBD_CDC_EEM_CtrlNbrNext = 0u;
     USBD_CDC_EEM_CommNbrNext = 0u;
 
+    USBD_DBG_STATS_POOL_REG(&USBD_CDC_EEM_DbgStatsPoolCtrl, "CDC EEM ctrl", USBD_CDC_EEM_CFG_MAX_NBR_DEV);
+    USBD_DBG_STATS_POOL_REG(&USBD_CDC_EEM_DbgStatsPoolComm, "CDC EEM comm", USBD_CDC_EEM_COMM_NBR_MAX);
+
    *p_err = USBD_ERR_NONE;
 }
 
@@ -512,6 +520,7 @@ CPU_INT08U  USBD_CDC_EEM_Add (USBD_ERR  *p_err)
     class_nbr = USBD_CDC_EEM_CtrlNbrNext;
     if (class_nbr >= USBD_CDC_EEM_CFG_MAX_NBR_DEV) {
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FAIL(&USBD_CDC_EEM_DbgStatsPoolCtrl);
 
        *p_err = USBD_ERR_ALLOC;
         return (USBD_CLASS_NBR_NONE);
@@ -519,6 +528,8 @@ CPU_INT08U  USBD_CDC_EEM_Add (USBD_ERR  *p_err)
     USBD_CDC_EEM_CtrlNbrNext++;
     CPU_CRITICAL_EXIT();
 
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_CDC_EEM_DbgStatsPoolCtrl);
+
     p_ctrl = &USBD_CDC_EEM_CtrlTbl[class_nbr];
 
                                                                 /* Alloc buffer used by echo response command.          */
@@ -621,12 +632,15 @@ void  USBD_CDC_EEM_CfgAdd (       CPU_INT08U   class_nbr,
     comm_nbr = USBD_CDC_EEM_CommNbrNext;
     if (comm_nbr >= USBD_CDC_EEM_COMM_NBR_MAX) {
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FAIL(&USBD_CDC_EEM_DbgStatsPoolComm);
        *p_err = USBD_ERR_ALLOC;
         return;
     }
     USBD_CDC_EEM_CommNbrNext++;
     CPU_CRITICAL_EXIT();
 
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_CDC_EEM_DbgStatsPoolComm);
+
     p_comm = &USBD_CDC_EEM_CommTbl[comm_nbr];
 
                                                                 /* ------------------ BUILD USB FNCT ------------------ */
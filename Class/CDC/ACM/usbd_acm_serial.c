@@ -238,6 +238,9 @@ typedef  struct  usbd_acm_serial_ctrl {                         /* --------- ACM
 
 static  USBD_ACM_SERIAL_CTRL  USBD_ACM_SerialCtrlTbl[USBD_ACM_SERIAL_CFG_MAX_NBR_DEV];
 static  CPU_INT08U            USBD_ACM_SerialCtrlNbrNext;
+#if (USBD_CFG_DBG_STATS_POOL_EN == DEF_ENABLED)
+static  USBD_DBG_STATS_POOL   USBD_ACM_SerialDbgStatsPoolCtrl;
+#endif
 
 
 /*
@@ -372,6 +375,8 @@ void  USBD_ACM_SerialInit (USBD_ERR  *p_err)
 
     USBD_ACM_SerialCtrlNbrNext = 0u;
 
+    USBD_DBG_STATS_POOL_REG(&USBD_ACM_SerialDbgStatsPoolCtrl, "ACM serial ctrl", USBD_ACM_SERIAL_CFG_MAX_NBR_DEV);
+
    *p_err = USBD_ERR_NONE;
 }
 
@@ -438,12 +443,15 @@ CPU_INT08U  USBD_ACM_SerialAdd (CPU_INT16U   line_state_interval,
 
     if (subclass_nbr >= USBD_ACM_SERIAL_CFG_MAX_NBR_DEV) {
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FAIL(&USBD_ACM_SerialDbgStatsPoolCtrl);
        *p_err = USBD_ERR_CDC_SUBCLASS_INSTANCE_ALLOC;
         return (USBD_ACM_SERIAL_NBR_NONE);
     }
 
     USBD_ACM_SerialCtrlNbrNext++;
     CPU_CRITICAL_EXIT();
+
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_ACM_SerialDbgStatsPoolCtrl);
                                                                 /* Init control struct.                                 */
     p_ctrl = &USBD_ACM_SerialCtrlTbl[subclass_nbr];
                                                                 /* Create new CDC device.                               */
@@ -226,6 +226,11 @@ static  CPU_INT08U           USBD_CDC_CtrlNbrNext;
 static  USBD_CDC_COMM        USBD_CDC_CommTbl[USBD_CDC_COMM_NBR_MAX];
 static  CPU_INT16U           USBD_CDC_CommNbrNext;
 
+#if (USBD_CFG_DBG_STATS_POOL_EN == DEF_ENABLED)
+static  USBD_DBG_STATS_POOL  USBD_CDC_DbgStatsPoolCtrl;
+static  USBD_DBG_STATS_POOL  USBD_CDC_DbgStatsPoolComm;
+#endif
+
 static  USBD_CDC_DATA_IF     USBD_CDC_DataIF_Tbl[USBD_CDC_CFG_MAX_NBR_DATA_IF];
 static  CPU_INT08U           USBD_CDC_DataIF_NbrNext;
 
@@ -419,6 +424,9 @@ void  USBD_CDC_Init (USBD_ERR  *p_err)
 
     USBD_CDC_CtrlNbrNext       = 0u;
     USBD_CDC_CommNbrNext       = 0u;
+
+    USBD_DBG_STATS_POOL_REG(&USBD_CDC_DbgStatsPoolCtrl, "CDC ctrl", USBD_CDC_CFG_MAX_NBR_DEV);
+    USBD_DBG_STATS_POOL_REG(&USBD_CDC_DbgStatsPoolComm, "CDC comm", USBD_CDC_COMM_NBR_MAX);
     USBD_CDC_DataIF_NbrNext    = 0u;
     USBD_CDC_DataIF_EP_NbrNext = 0u;
 
@@ -491,6 +499,7 @@ CPU_INT08U  USBD_CDC_Add (CPU_INT08U              subclass,
 
     if (cdc_nbr >= USBD_CDC_CFG_MAX_NBR_DEV) {
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FAIL(&USBD_CDC_DbgStatsPoolCtrl);
        *p_err = USBD_ERR_CDC_INSTANCE_ALLOC;
         return (USBD_CDC_NBR_NONE);
     }
@@ -498,6 +507,8 @@ CPU_INT08U  USBD_CDC_Add (CPU_INT08U              subclass,
     USBD_CDC_CtrlNbrNext++;
     CPU_CRITICAL_EXIT();
 
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_CDC_DbgStatsPoolCtrl);
+
     p_ctrl = &USBD_CDC_CtrlTbl[cdc_nbr];                        /* Get & init CDC struct.                               */
 
     p_ctrl->SubClassCode     = subclass;
@@ -610,6 +621,7 @@ CPU_BOOLEAN  USBD_CDC_CfgAdd (CPU_INT08U   class_nbr,
     comm_nbr = USBD_CDC_CommNbrNext;                            /* Alloc CDC class comm info.                           */
     if (comm_nbr >= USBD_CDC_COMM_NBR_MAX) {
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FAIL(&USBD_CDC_DbgStatsPoolComm);
        *p_err = USBD_ERR_CDC_INSTANCE_ALLOC;
         return (DEF_NO);
     }
@@ -630,6 +642,8 @@ CPU_BOOLEAN  USBD_CDC_CfgAdd (CPU_INT08U   class_nbr,
     }
     CPU_CRITICAL_EXIT();
 
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_CDC_DbgStatsPoolComm);
+
     if_nbr = USBD_IF_Add(        dev_nbr,                       /* Add CDC comm IF to cfg.                              */
                                  cfg_nbr,
                                 &USBD_CDC_CommDrv,
@@ -0,0 +1,562 @@
+/*
+*********************************************************************************************************
+*                                            uC/USB-Device
+*                                    The Embedded USB Device Stack
+*
+*                    Copyright 2004-2021 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*
+*                                   USB DEVICE OPERATING SYSTEM LAYER
+*                                                POSIX
+*
+* Filename : usbd_hid_os.c
+* Version  : V4.06.01
+*********************************************************************************************************
+* Note(s)  : (1) This port relies on the primitives of the POSIX core OS port ('OS/POSIX/usbd_os.c').
+*
+*            (2) Task priorities #define'd in 'app_cfg.h' are NOT used : see 'OS/POSIX/usbd_os.c  Note #2'.
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#ifndef  _POSIX_C_SOURCE
+#define  _POSIX_C_SOURCE                              200809L   /* Required for clock_nanosleep().                      */
+#endif
+
+#define    MICRIUM_SOURCE
+#include  <app_cfg.h>
+#include  "../../../../Source/usbd_core.h"
+#include  "../../usbd_hid_report.h"
+#include  "../../usbd_hid_os.h"
+#include  "../../../../OS/POSIX/usbd_os_posix.h"
+#include  <errno.h>
+#include  <time.h>
+
+
+
+/*
+*********************************************************************************************************
+*                                        CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+#ifndef  USBD_HID_OS_CFG_TMR_TASK_STK_SIZE
+#error  "USBD_HID_OS_CFG_TMR_TASK_STK_SIZE not #define'd in 'app_cfg.h' [MUST be > 0]"
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#define  USBD_HID_OS_TMR_PERIOD_NSEC                 4000000L   /* HID report tmr task period (4 ms).                   */
+#define  USBD_HID_OS_NSEC_PER_SEC                 1000000000L
+
+
+/*
+*********************************************************************************************************
+*                                           LOCAL CONSTANTS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                          LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL TABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                       LOCAL GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+                                                                /* ---------------- USB HID SEM OBJECTS --------------- */
+static  USBD_OS_POSIX_SEM  USBD_HID_OS_InputDataSem_Tbl[USBD_HID_CFG_MAX_NBR_DEV];
+
+static  USBD_OS_POSIX_SEM  USBD_HID_OS_InputLockSem_Tbl[USBD_HID_CFG_MAX_NBR_DEV];
+
+static  USBD_OS_POSIX_SEM  USBD_HID_OS_TxSem_Tbl[USBD_HID_CFG_MAX_NBR_DEV];
+
+static  USBD_OS_POSIX_SEM  USBD_HID_OS_OutputLockSem_Tbl[USBD_HID_CFG_MAX_NBR_DEV];
+static  USBD_OS_POSIX_SEM  USBD_HID_OS_OutputDataSem_Tbl[USBD_HID_CFG_MAX_NBR_DEV];
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL MACRO'S
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  void  USBD_HID_OS_TmrTask(void  *p_arg);
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_HID_OS_Init()
+*
+* Description : Initialize HID OS interface.
+*
+* Argument(s) : p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE               HID OS initialization successful.
+*                               USBD_ERR_OS_SIGNAL_CREATE   HID OS objects NOT successfully initialized.
+*                               USBD_ERR_OS_INIT_FAIL       HID OS task    NOT successfully initialized.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_HID_OS_Init (USBD_ERR  *p_err)
+{
+    USBD_ERR     err;
+    CPU_INT08U   class_nbr;
+
+
+    for (class_nbr = 0; class_nbr < USBD_HID_CFG_MAX_NBR_DEV; class_nbr++) {
+        USBD_OS_POSIX_SemCreate(&USBD_HID_OS_TxSem_Tbl[class_nbr], 1u, &err);
+        if (err != USBD_ERR_NONE) {
+           *p_err = USBD_ERR_OS_SIGNAL_CREATE;
+            return;
+        }
+
+        USBD_OS_POSIX_SemCreate(&USBD_HID_OS_OutputLockSem_Tbl[class_nbr], 1u, &err);
+        if (err != USBD_ERR_NONE) {
+           *p_err = USBD_ERR_OS_SIGNAL_CREATE;
+            return;
+        }
+
+        USBD_OS_POSIX_SemCreate(&USBD_HID_OS_OutputDataSem_Tbl[class_nbr], 0u, &err);
+        if (err != USBD_ERR_NONE) {
+           *p_err = USBD_ERR_OS_SIGNAL_CREATE;
+            return;
+        }
+
+        USBD_OS_POSIX_SemCreate(&USBD_HID_OS_InputLockSem_Tbl[class_nbr], 1u, &err);
+        if (err != USBD_ERR_NONE) {
+           *p_err = USBD_ERR_OS_SIGNAL_CREATE;
+            return;
+        }
+
+        USBD_OS_POSIX_SemCreate(&USBD_HID_OS_InputDataSem_Tbl[class_nbr], 0u, &err);
+        if (err != USBD_ERR_NONE) {
+           *p_err = USBD_ERR_OS_SIGNAL_CREATE;
+            return;
+        }
+    }
+
+    USBD_OS_POSIX_TaskCreate(        "USB-Device HID Timer Task",
+                                      USBD_HID_OS_TmrTask,
+                             (void *) 0,
+                                      USBD_HID_OS_CFG_TMR_TASK_STK_SIZE,
+                                     &err);
+    if (err != USBD_ERR_NONE) {
+       *p_err = USBD_ERR_OS_INIT_FAIL;
+        return;
+    }
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_HID_OS_TmrTask()
+*
+* Description : OS-dependent shell task to process periodic HID input reports.
+*
+* Argument(s) : p_arg       Pointer to task initialization argument.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) The task runs every 4 milliseconds. Wake-up times are absolute CLOCK_MONOTONIC times
+*                   advanced by one period at each iteration, so that the processing time of the report
+*                   handler does not accumulate as drift.
+*
+*               (2) If the task falls behind by more than one period (e.g. the process was suspended), the
+*                   next wake-up time is re-synchronized on the current time rather than running the
+*                   handler back-to-back to catch up.
+*********************************************************************************************************
+*/
+
+static  void  USBD_HID_OS_TmrTask (void  *p_arg)
+{
+    struct  timespec  ts_next;
+    struct  timespec  ts_now;
+    int               res;
+
+
+   (void)p_arg;                                                 /* Prevent 'variable unused' compiler warning.          */
+
+   (void)clock_gettime(CLOCK_MONOTONIC, &ts_next);
+
+    while (DEF_ON) {
+        ts_next.tv_nsec += USBD_HID_OS_TMR_PERIOD_NSEC;         /* See Note #1.                                         */
+        if (ts_next.tv_nsec >= USBD_HID_OS_NSEC_PER_SEC) {
+            ts_next.tv_sec++;
+            ts_next.tv_nsec -= USBD_HID_OS_NSEC_PER_SEC;
+        }
+
+        (void)clock_gettime(CLOCK_MONOTONIC, &ts_now);
+        if ((ts_now.tv_sec  >  ts_next.tv_sec) ||               /* See Note #2.                                         */
+           ((ts_now.tv_sec  == ts_next.tv_sec) &&
+            (ts_now.tv_nsec >  ts_next.tv_nsec))) {
+            ts_next = ts_now;
+        }
+
+        do {
+            res = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts_next, DEF_NULL);
+        } while (res == EINTR);
+
+        USBD_HID_Report_TmrTaskHandler();
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_HID_OS_InputLock()
+*
+* Description : Lock class input report.
+*
+* Argument(s) : class_nbr   Class instance number.
+*               ---------   Argument validated by the caller(s).
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE       Class input report successfully locked.
+*                               USBD_ERR_OS_ABORT   Class input report aborted.
+*                               USBD_ERR_OS_FAIL    OS signal not acquired because another error.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_HID_OS_InputLock (CPU_INT08U   class_nbr,
+                             USBD_ERR    *p_err)
+{
+    USBD_OS_POSIX_SemPend(&USBD_HID_OS_InputLockSem_Tbl[class_nbr], 0u, p_err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_HID_OS_InputUnlock()
+*
+* Description : Unlock class input report.
+*
+* Argument(s) : class_nbr   Class instance number.
+*               ---------   Argument validated by the caller(s).
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_HID_OS_InputUnlock (CPU_INT08U  class_nbr)
+{
+    USBD_ERR  err;
+
+
+    USBD_OS_POSIX_SemPost(&USBD_HID_OS_InputLockSem_Tbl[class_nbr], &err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                    USBD_HID_OS_OutputDataPendAbort()
+*
+* Description : Abort class output report.
+*
+* Argument(s) : class_nbr   Class instance number.
+*               ---------   Argument validated by the caller(s).
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_HID_OS_OutputDataPendAbort (CPU_INT08U  class_nbr)
+{
+    USBD_OS_POSIX_SemPendAbort(&USBD_HID_OS_OutputDataSem_Tbl[class_nbr]);
+}
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_HID_OS_OutputDataPend()
+*
+* Description : Wait for output report data transfer to complete.
+*
+* Argument(s) : class_nbr   Class instance number.
+*               ---------   Argument validated by the caller(s).
+*
+*               timeout_ms  Signal wait timeout, in milliseconds.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE       Class output successfully locked.
+*                               USBD_ERR_OS_ABORT   Class output aborted.
+*                               USBD_ERR_OS_FAIL    OS signal not acquired because another error.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) A timeout is reported as USBD_ERR_OS_FAIL, as for the other OS ports.
+*********************************************************************************************************
+*/
+
+void  USBD_HID_OS_OutputDataPend (CPU_INT08U   class_nbr,
+                                  CPU_INT16U   timeout_ms,
+                                  USBD_ERR    *p_err)
+{
+    USBD_OS_POSIX_SemPend(&USBD_HID_OS_OutputDataSem_Tbl[class_nbr], timeout_ms, p_err);
+    if (*p_err == USBD_ERR_OS_TIMEOUT) {                        /* See Note #1.                                         */
+        *p_err = USBD_ERR_OS_FAIL;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_HID_OS_OutputDataPost()
+*
+* Description : Signal that output report data is available.
+*
+* Argument(s) : class_nbr   Class instance number.
+*               ---------   Argument validated by the caller(s).
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_HID_OS_OutputDataPost (CPU_INT08U  class_nbr)
+{
+    USBD_ERR  err;
+
+
+    USBD_OS_POSIX_SemPost(&USBD_HID_OS_OutputDataSem_Tbl[class_nbr], &err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_HID_OS_OutputLock()
+*
+* Description : Lock class output report.
+*
+* Argument(s) : class_nbr   Class instance number.
+*               ---------   Argument validated by the caller(s).
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE       Class output successfully locked.
+*                               USBD_ERR_OS_ABORT   Class output aborted.
+*                               USBD_ERR_OS_FAIL    OS signal not acquired because another error.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_HID_OS_OutputLock (CPU_INT08U   class_nbr,
+                              USBD_ERR    *p_err)
+{
+    USBD_OS_POSIX_SemPend(&USBD_HID_OS_OutputLockSem_Tbl[class_nbr], 0u, p_err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_HID_OS_OutputUnlock()
+*
+* Description : Unlock class output report.
+*
+* Argument(s) : class_nbr   Class instance number.
+*               ---------   Argument validated by the caller(s).
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_HID_OS_OutputUnlock (CPU_INT08U  class_nbr)
+{
+    USBD_ERR  err;
+
+
+    USBD_OS_POSIX_SemPost(&USBD_HID_OS_OutputLockSem_Tbl[class_nbr], &err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_HID_OS_TxLock()
+*
+* Description : Lock class transmit.
+*
+* Argument(s) : class_nbr   Class instance number.
+*               ---------   Argument validated by the caller(s).
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE       Class feature report successfully locked.
+*                               USBD_ERR_OS_ABORT   Class feature report aborted.
+*                               USBD_ERR_OS_FAIL    OS signal not acquired because another error.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_HID_OS_TxLock (CPU_INT08U   class_nbr,
+                          USBD_ERR    *p_err)
+{
+    USBD_OS_POSIX_SemPend(&USBD_HID_OS_TxSem_Tbl[class_nbr], 0u, p_err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_HID_OS_TxUnlock()
+*
+* Description : Unlock class transmit.
+*
+* Argument(s) : class_nbr   Class instance number.
+*               ---------   Argument validated by the caller(s).
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_HID_OS_TxUnlock (CPU_INT08U  class_nbr)
+{
+    USBD_ERR  err;
+
+
+    USBD_OS_POSIX_SemPost(&USBD_HID_OS_TxSem_Tbl[class_nbr], &err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_HID_OS_InputDataPend()
+*
+* Description : Wait for input report data transfer to complete.
+*
+* Argument(s) : class_nbr   Class instance number.
+*               ---------   Argument validated by the caller(s).
+*
+*               timeout_ms  Signal wait timeout in milliseconds.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE           OS signal     successfully acquired.
+*                               USBD_ERR_OS_TIMEOUT     OS signal NOT successfully acquired in the time
+*                                                           specified by 'timeout_ms'.
+*                               USBD_ERR_OS_ABORT       OS signal aborted.
+*                               USBD_ERR_OS_FAIL        OS signal not acquired because another error.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_HID_OS_InputDataPend (CPU_INT08U   class_nbr,
+                                 CPU_INT16U   timeout_ms,
+                                 USBD_ERR    *p_err)
+{
+    USBD_OS_POSIX_SemPend(&USBD_HID_OS_InputDataSem_Tbl[class_nbr], timeout_ms, p_err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                  USBD_HID_OS_InputDataPendAbort()
+*
+* Description : Abort any operation on input report.
+*
+* Argument(s) : class_nbr   Class instance number.
+*               ---------   Argument validated by the caller(s).
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_HID_OS_InputDataPendAbort (CPU_INT08U  class_nbr)
+{
+    USBD_OS_POSIX_SemPendAbort(&USBD_HID_OS_InputDataSem_Tbl[class_nbr]);
+}
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_HID_OS_InputDataPost()
+*
+* Description : Signal that input report data transfer has completed.
+*
+* Argument(s) : class_nbr   Class instance number.
+*               ---------   Argument validated by the caller(s).
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_HID_OS_InputDataPost (CPU_INT08U  class_nbr)
+{
+    USBD_ERR  err;
+
+
+    USBD_OS_POSIX_SemPost(&USBD_HID_OS_InputDataSem_Tbl[class_nbr], &err);
+}
@@ -186,6 +186,11 @@ static  CPU_INT08U     USBD_HID_CtrlNbrNext;
                                                                 /* HID class comm array.                                */
 static  USBD_HID_COMM  USBD_HID_CommTbl[USBD_HID_MAX_NBR_COMM];
 static  CPU_INT08U     USBD_HID_CommNbrNext;
+#if (USBD_CFG_DBG_STATS_POOL_EN == DEF_ENABLED)
+                                                                /* Usage stats of HID arrays.                           */
+static  USBD_DBG_STATS_POOL  USBD_HID_DbgStatsPoolCtrl;
+static  USBD_DBG_STATS_POOL  USBD_HID_DbgStatsPoolComm;
+#endif
 
 
 /*
@@ -399,6 +404,9 @@ void  USBD_HID_Init (USBD_ERR  *p_err)
 
     USBD_HID_CtrlNbrNext = 0u;
     USBD_HID_CommNbrNext = 0u;
+
+    USBD_DBG_STATS_POOL_REG(&USBD_HID_DbgStatsPoolCtrl, "HID ctrl", USBD_HID_CFG_MAX_NBR_DEV);
+    USBD_DBG_STATS_POOL_REG(&USBD_HID_DbgStatsPoolComm, "HID comm", USBD_HID_MAX_NBR_COMM);
 }
 
 
@@ -516,6 +524,7 @@ CPU_INT08U  USBD_HID_Add (CPU_INT08U              subclass,
 
     if (class_nbr >= USBD_HID_CFG_MAX_NBR_DEV) {
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FAIL(&USBD_HID_DbgStatsPoolCtrl);
        *p_err = USBD_ERR_HID_INSTANCE_ALLOC;
         return (USBD_CLASS_NBR_NONE);
     }
@@ -523,6 +532,8 @@ CPU_INT08U  USBD_HID_Add (CPU_INT08U              subclass,
     USBD_HID_CtrlNbrNext++;
     CPU_CRITICAL_EXIT();
 
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_HID_DbgStatsPoolCtrl);
+
     p_ctrl = &USBD_HID_CtrlTbl[class_nbr];
 
     p_ctrl->SubClassCode  = subclass;
@@ -662,12 +673,15 @@ CPU_BOOLEAN  USBD_HID_CfgAdd (CPU_INT08U   class_nbr,
     comm_nbr = USBD_HID_CommNbrNext;                            /* Alloc new HID class comm info.                       */
     if (comm_nbr >= USBD_HID_MAX_NBR_COMM) {
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FAIL(&USBD_HID_DbgStatsPoolComm);
        *p_err = USBD_ERR_HID_INSTANCE_ALLOC;
         return (DEF_NO);
     }
     USBD_HID_CommNbrNext++;
     CPU_CRITICAL_EXIT();
 
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_HID_DbgStatsPoolComm);
+
     p_comm = &USBD_HID_CommTbl[comm_nbr];
 
                                                                 /* -------------- CFG DESC CONSTRUCTION --------------- */
@@ -0,0 +1,474 @@
+/*
+*********************************************************************************************************
+*                                            uC/USB-Device
+*                                    The Embedded USB Device Stack
+*
+*                    Copyright 2004-2021 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*
+*                                   USB DEVICE OPERATING SYSTEM LAYER
+*                                                POSIX
+*
+* Filename : usbd_msc_os.c
+* Version  : V4.06.01
+*********************************************************************************************************
+* Note(s)  : (1) This port relies on the primitives of the POSIX core OS port ('OS/POSIX/usbd_os.c').
+*
+*            (2) Task priorities #define'd in 'app_cfg.h' are NOT used : see 'OS/POSIX/usbd_os.c  Note #2'.
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#define    MICRIUM_SOURCE
+#include  <app_cfg.h>
+#include  "../../usbd_msc.h"
+#include  "../../usbd_msc_os.h"
+#if (USBD_MSC_CFG_FS_REFRESH_TASK_EN == DEF_ENABLED)
+#include  "../../Storage/uC-FS/V4/usbd_storage.h"
+#endif
+#include  "../../../../OS/POSIX/usbd_os_posix.h"
+
+
+/*
+*********************************************************************************************************
+*                                        CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+#ifndef USBD_MSC_OS_CFG_TASK_STK_SIZE
+#error  "USBD_MSC_OS_CFG_TASK_STK_SIZE not #define'd in 'app_cfg.h' [MUST be > 0]"
+#endif
+
+#if (USBD_MSC_CFG_FS_REFRESH_TASK_EN == DEF_ENABLED)
+#ifndef USBD_MSC_OS_CFG_REFRESH_TASK_STK_SIZE
+#error  "USBD_MSC_OS_CFG_REFRESH_TASK_STK_SIZE not #define'd in 'app_cfg.h' [MUST be > 0]"
+#endif
+
+#ifndef  USBD_MSC_CFG_DEV_POLL_DLY_mS
+#error  "USBD_MSC_CFG_DEV_POLL_DLY_mS not #defined'd in 'usbd_cfg.h' [MUST be > 0]"
+#elif   (USBD_MSC_CFG_DEV_POLL_DLY_mS == 0)
+#error  "USBD_MSC_CFG_DEV_POLL_DLY_mS illegally #define'd in 'usbd_cfg.h' [MUST be > 0]"
+#endif
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                           LOCAL CONSTANTS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                          LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL TABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                       LOCAL GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+static  USBD_OS_POSIX_SEM  USBD_MSC_OS_TASK_SemTbl[USBD_MSC_CFG_MAX_NBR_DEV];
+
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+static  USBD_OS_POSIX_SEM  USBD_MSC_OS_DataSemTbl[USBD_MSC_CFG_MAX_NBR_DEV];
+#endif
+
+static  USBD_OS_POSIX_SEM  USBD_MSC_OS_EnumSignalTbl[USBD_MSC_CFG_MAX_NBR_DEV];
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL MACRO'S
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  void  USBD_MSC_OS_Task        (void  *p_arg);
+
+#if (USBD_MSC_CFG_FS_REFRESH_TASK_EN == DEF_ENABLED)
+static  void  USBD_MSC_OS_RefreshTask(void  *p_arg);
+#endif
+
+
+/*
+*********************************************************************************************************
+*********************************************************************************************************
+*                                          GLOBAL FUNCTIONS
+*********************************************************************************************************
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                           USBD_MSC_OS_Init()
+*
+* Description : Initialize MSC OS interface.
+*
+* Argument(s) : p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE       OS initialization successful.
+*                               USBD_ERR_OS_FAIL    OS objects NOT successfully initialized.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) One MSC task is created for each class instance, so that the instances service their
+*                   logical units in parallel.
+*********************************************************************************************************
+*/
+
+void  USBD_MSC_OS_Init (USBD_ERR  *p_err)
+{
+    CPU_INT08U  class_nbr;
+    USBD_ERR    err;
+
+
+                                                                /* Create sem for signal used for MSC comm.             */
+    for (class_nbr = 0u; class_nbr < USBD_MSC_CFG_MAX_NBR_DEV; class_nbr++) {
+        USBD_OS_POSIX_SemCreate(&USBD_MSC_OS_TASK_SemTbl[class_nbr], 0u, &err);
+        if (err != USBD_ERR_NONE) {
+           *p_err = USBD_ERR_OS_SIGNAL_CREATE;
+            return;
+        }
+    }
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+                                                                /* Create sem for signal used for MSC data xfers.       */
+    for (class_nbr = 0u; class_nbr < USBD_MSC_CFG_MAX_NBR_DEV; class_nbr++) {
+        USBD_OS_POSIX_SemCreate(&USBD_MSC_OS_DataSemTbl[class_nbr], 0u, &err);
+        if (err != USBD_ERR_NONE) {
+           *p_err = USBD_ERR_OS_SIGNAL_CREATE;
+            return;
+        }
+    }
+#endif
+                                                                /* Create sem for signal used for MSC enum.             */
+    for (class_nbr = 0u; class_nbr < USBD_MSC_CFG_MAX_NBR_DEV; class_nbr++) {
+        USBD_OS_POSIX_SemCreate(&USBD_MSC_OS_EnumSignalTbl[class_nbr], 0u, &err);
+        if (err != USBD_ERR_NONE) {
+           *p_err = USBD_ERR_OS_SIGNAL_CREATE;
+            return;
+        }
+    }
+                                                                /* Create one MSC task per class instance (see Note #1).*/
+    for (class_nbr = 0u; class_nbr < USBD_MSC_CFG_MAX_NBR_DEV; class_nbr++) {
+        USBD_OS_POSIX_TaskCreate(                   "USB MSC Task",
+                                                     USBD_MSC_OS_Task,
+                                 (void *)(CPU_ADDR)  class_nbr,
+                                                     USBD_MSC_OS_CFG_TASK_STK_SIZE,
+                                                    &err);
+        if (err != USBD_ERR_NONE) {
+           *p_err = USBD_ERR_OS_INIT_FAIL;
+            return;
+        }
+    }
+
+#if (USBD_MSC_CFG_FS_REFRESH_TASK_EN == DEF_ENABLED)
+    USBD_OS_POSIX_TaskCreate(        "Storage Refresh",         /* Create the refresh task                              */
+                                      USBD_MSC_OS_RefreshTask,
+                             (void *) 0,
+                                      USBD_MSC_OS_CFG_REFRESH_TASK_STK_SIZE,
+                                     &err);
+    if (err != USBD_ERR_NONE) {
+       *p_err = USBD_ERR_OS_INIT_FAIL;
+        return;
+    }
+#endif
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_MSC_OS_Task()
+*
+* Description : OS-dependent shell task to process MSC task
+*
+* Argument(s) : p_arg       Pointer to task initialization argument.
+*
+* Return(s)   : None.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+static  void  USBD_MSC_OS_Task (void  *p_arg)
+{
+    CPU_INT08U  class_nbr;
+
+
+    class_nbr = (CPU_INT08U)(CPU_ADDR)p_arg;
+
+    USBD_MSC_TaskHandler(class_nbr);
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_MSC_OS_RefreshTask()
+*
+* Description : OS-dependent shell task to process Device Refresh task
+*
+* Argument(s) : p_arg       Pointer to task initialization argument.
+*
+* Return(s)   : None.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_FS_REFRESH_TASK_EN == DEF_ENABLED)
+static  void  USBD_MSC_OS_RefreshTask (void  *p_arg)
+{
+    while (DEF_TRUE) {
+        USBD_StorageRefreshTaskHandler(p_arg);
+
+        USBD_OS_DlyMs((CPU_INT32U)USBD_MSC_CFG_DEV_POLL_DLY_mS);
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_MSC_OS_CommSignalPost()
+*
+* Description : Post a semaphore used for MSC communication.
+*
+* Argument(s) : class_nbr   MSC instance class number
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE       OS signal     successfully posted.
+*                               USBD_ERR_OS_FAIL    OS signal NOT successfully posted.
+*
+* Return(s)   : None.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+void  USBD_MSC_OS_CommSignalPost (CPU_INT08U   class_nbr,
+                                  USBD_ERR    *p_err)
+{
+    USBD_OS_POSIX_SemPost(&USBD_MSC_OS_TASK_SemTbl[class_nbr], p_err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_MSC_OS_CommSignalPend()
+*
+* Description : Wait on a semaphore to become available for MSC communication.
+*
+* Argument(s) : class_nbr   MSC instance class number
+*
+*               timeout     Timeout in milliseconds.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*                               USBD_ERR_NONE          The call was successful and your task owns the resource
+*                                                       or, the event you are waiting for occurred.
+*                               USBD_ERR_OS_TIMEOUT    The semaphore was not received within the specified timeout.
+*                               USBD_ERR_OS_FAIL       otherwise.
+*
+* Return(s)   : None.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+void  USBD_MSC_OS_CommSignalPend (CPU_INT08U   class_nbr,
+                                  CPU_INT32U   timeout,
+                                  USBD_ERR    *p_err)
+{
+    USBD_OS_POSIX_SemPend(&USBD_MSC_OS_TASK_SemTbl[class_nbr],
+                           timeout,
+                           p_err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_MSC_OS_CommSignalDel()
+*
+* Description : Delete a semaphore used for MSC communication.
+*
+* Argument(s) : class_nbr   MSC instance class number
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*                               USBD_ERR_NONE          The call was successful and the semaphore was destroyed
+*                               USBD_ERR_OS_FAIL       otherwise.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Tasks pending on the semaphore are aborted. See 'usbd_os.c  USBD_OS_POSIX_SemDel()'.
+*********************************************************************************************************
+*/
+
+void  USBD_MSC_OS_CommSignalDel (CPU_INT08U   class_nbr,
+                                 USBD_ERR    *p_err)
+{
+    USBD_OS_POSIX_SemDel(&USBD_MSC_OS_TASK_SemTbl[class_nbr]);
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_MSC_OS_DataSignalPost()
+*
+* Description : Post a semaphore used to signal the completion of an MSC data transfer.
+*
+* Argument(s) : class_nbr   MSC instance class number
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE       OS signal     successfully posted.
+*                               USBD_ERR_OS_FAIL    OS signal NOT successfully posted.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) This function may be called from an ISR.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+void  USBD_MSC_OS_DataSignalPost (CPU_INT08U   class_nbr,
+                                  USBD_ERR    *p_err)
+{
+    USBD_OS_POSIX_SemPost(&USBD_MSC_OS_DataSemTbl[class_nbr], p_err);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_MSC_OS_DataSignalPend()
+*
+* Description : Wait on a semaphore signaling the completion of an MSC data transfer.
+*
+* Argument(s) : class_nbr   MSC instance class number
+*
+*               timeout     Timeout in milliseconds.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*                               USBD_ERR_NONE          The call was successful and your task owns the resource
+*                                                       or, the event you are waiting for occurred.
+*                               USBD_ERR_OS_TIMEOUT    The semaphore was not received within the specified timeout.
+*                               USBD_ERR_OS_FAIL       otherwise.
+*
+* Return(s)   : None.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+void  USBD_MSC_OS_DataSignalPend (CPU_INT08U   class_nbr,
+                                  CPU_INT32U   timeout,
+                                  USBD_ERR    *p_err)
+{
+    USBD_OS_POSIX_SemPend(&USBD_MSC_OS_DataSemTbl[class_nbr],
+                           timeout,
+                           p_err);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_MSC_OS_EnumSignalPost()
+*
+* Description : Post a semaphore for MSC enumeration process.
+*
+* Argument(s) : class_nbr   MSC instance class number
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE       OS signal     successfully posted.
+*                               USBD_ERR_OS_FAIL    OS signal NOT successfully posted.
+*
+* Return(s)   : None.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+void  USBD_MSC_OS_EnumSignalPost (CPU_INT08U   class_nbr,
+                                  USBD_ERR    *p_err)
+{
+    USBD_OS_POSIX_SemPost(&USBD_MSC_OS_EnumSignalTbl[class_nbr], p_err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_MSC_OS_EnumSignalPend()
+*
+* Description : Wait on a semaphore to become available for MSC enumeration process.
+*
+* Argument(s) : class_nbr   MSC instance class number
+*
+*               timeout     Timeout in milliseconds.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*                               USBD_ERR_NONE          The call was successful and your task owns the resource
+*                                                       or, the event you are waiting for occurred.
+*                               USBD_ERR_OS_TIMEOUT    The semaphore was not received within the specified timeout.
+*                               USBD_ERR_OS_FAIL       otherwise.
+*
+* Return(s)   : None.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+void  USBD_MSC_OS_EnumSignalPend (CPU_INT08U   class_nbr,
+                                  CPU_INT32U   timeout,
+                                  USBD_ERR    *p_err)
+{
+    USBD_OS_POSIX_SemPend(&USBD_MSC_OS_EnumSignalTbl[class_nbr],
+                           timeout,
+                           p_err);
+}
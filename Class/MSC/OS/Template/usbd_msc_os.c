@@ -86,13 +86,17 @@
 *********************************************************************************************************
 */
 
-static  OS_TCB   USBD_MSC_OS_TaskTCB;
+static  OS_TCB   USBD_MSC_OS_TaskTCB[USBD_MSC_CFG_MAX_NBR_DEV];
 
-static  CPU_STK  USBD_MSC_OS_TaskStk[USBD_MSC_OS_CFG_TASK_STK_SIZE];
+static  CPU_STK  USBD_MSC_OS_TaskStk[USBD_MSC_CFG_MAX_NBR_DEV][USBD_MSC_OS_CFG_TASK_STK_SIZE];
 
 static  OS_SEM   USBD_MSC_OS_TASK_SemTbl[USBD_MSC_CFG_MAX_NBR_DEV];
 
-static  OS_SEM   USBD_MSC_OS_EnumSignal;
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+static  OS_SEM   USBD_MSC_OS_DataSemTbl[USBD_MSC_CFG_MAX_NBR_DEV];
+#endif
+
+static  OS_SEM   USBD_MSC_OS_EnumSignalTbl[USBD_MSC_CFG_MAX_NBR_DEV];
 
 
 /*
@@ -132,7 +136,8 @@ static  void  USBD_MSC_OS_Task(void  *p_arg);
 *
 * Return(s)   : None.
 *
-* Note(s)     : None.
+* Note(s)     : (1) One MSC task must be created for each class instance, with the class instance number
+*                   as argument, so that the instances service their logical units in parallel.
 *********************************************************************************************************
 */
 
@@ -140,7 +145,7 @@ void  USBD_MSC_OS_Init (USBD_ERR  *p_err)
 {
     /* $$$$ Insert code to create all the required semaphores. */
 
-    /* $$$$ Insert code to create the MSC task, USBD_MSC_OS_Task(). */
+    /* $$$$ Insert code to create one MSC task, USBD_MSC_OS_Task(), per class instance (see Note #1). */
 
    *p_err = USBD_ERR_NONE;
 }
@@ -257,13 +262,79 @@ void  USBD_MSC_OS_CommSignalDel (CPU_INT08U   class_nbr,
 }
 
 
+/*
+*********************************************************************************************************
+*                                          USBD_MSC_OS_DataSignalPost()
+*
+* Description : Post a semaphore used to signal the completion of an MSC data transfer.
+*
+* Argument(s) : class_nbr   MSC instance class number
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE       OS signal     successfully posted.
+*                               USBD_ERR_OS_FAIL    OS signal NOT successfully posted.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) This function may be called from an ISR.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+void  USBD_MSC_OS_DataSignalPost (CPU_INT08U   class_nbr,
+                                  USBD_ERR    *p_err)
+{
+    /* $$$$ Insert code to post a semaphore used for MSC data transfers. */
+   *p_err = USBD_ERR_NONE;
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_MSC_OS_DataSignalPend()
+*
+* Description : Wait on a semaphore signaling the completion of an MSC data transfer.
+*
+* Argument(s) : class_nbr   MSC instance class number
+*
+*               timeout     Timeout in milliseconds.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*                               USBD_ERR_NONE          The call was successful and your task owns the resource
+*                                                       or, the event you are waiting for occurred.
+*                               USBD_ERR_OS_TIMEOUT    The semaphore was not received within the specified timeout.
+*                               USBD_ERR_OS_FAIL       otherwise.
+*
+* Return(s)   : None.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+void  USBD_MSC_OS_DataSignalPend (CPU_INT08U   class_nbr,
+                                  CPU_INT32U   timeout,
+                                  USBD_ERR    *p_err)
+{
+    /* $$$$ Insert code to wait on a semaphore used for MSC data transfers.               */
+    /* A timeout parameter is available to implement a wait forever or with a timeout.    */
+
+   *p_err = USBD_ERR_NONE;
+}
+#endif
+
+
 /*
 *********************************************************************************************************
 *                                          USBD_MSC_OS_EnumSignalPost()
 *
 * Description : Post a semaphore for MSC enumeration process.
 *
-* Argument(s) : p_err       Pointer to variable that will receive the return error code from this function :
+* Argument(s) : class_nbr   MSC instance class number
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
 *
 *                               USBD_ERR_NONE       OS signal     successfully posted.
 *                               USBD_ERR_OS_FAIL    OS signal NOT successfully posted.
@@ -274,7 +345,8 @@ void  USBD_MSC_OS_CommSignalDel (CPU_INT08U   class_nbr,
 *********************************************************************************************************
 */
 
-void  USBD_MSC_OS_EnumSignalPost (USBD_ERR  *p_err)
+void  USBD_MSC_OS_EnumSignalPost (CPU_INT08U   class_nbr,
+                                  USBD_ERR    *p_err)
 {
     /* $$$$ Insert code to post a semaphore for MSC enumeration process. */
    *p_err = USBD_ERR_NONE;
@@ -288,7 +360,9 @@ void  USBD_MSC_OS_EnumSignalPost (USBD_ERR  *p_err)
 *
 * Description : Wait on a semaphore to become available for MSC enumeration process.
 *
-* Argument(s) : timeout     Timeout in milliseconds.
+* Argument(s) : class_nbr   MSC instance class number
+*
+*               timeout     Timeout in milliseconds.
 *
 *               p_err       Pointer to variable that will receive the return error code from this function :
 *                               USBD_ERR_NONE          The call was successful and your task owns the resource
@@ -302,8 +376,9 @@ void  USBD_MSC_OS_EnumSignalPost (USBD_ERR  *p_err)
 *********************************************************************************************************
 */
 
-void  USBD_MSC_OS_EnumSignalPend (CPU_INT32U  timeout,
-                                  USBD_ERR   *p_err)
+void  USBD_MSC_OS_EnumSignalPend (CPU_INT08U   class_nbr,
+                                  CPU_INT32U   timeout,
+                                  USBD_ERR    *p_err)
 {
     /* $$$$ Insert code to wait on a semaphore to become available for MSC enumeration process. */
    *p_err = USBD_ERR_NONE;
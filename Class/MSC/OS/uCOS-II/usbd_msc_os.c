@@ -107,14 +107,17 @@
 */
 
 
-static  OS_STK     USBD_MSC_OS_TaskStk[USBD_MSC_OS_CFG_TASK_STK_SIZE];
+static  OS_STK     USBD_MSC_OS_TaskStk[USBD_MSC_CFG_MAX_NBR_DEV][USBD_MSC_OS_CFG_TASK_STK_SIZE];
 
 #if (USBD_MSC_CFG_FS_REFRESH_TASK_EN == DEF_ENABLED)
 static  OS_STK     USBD_MSC_OS_RefreshTaskStk[USBD_MSC_OS_CFG_REFRESH_TASK_STK_SIZE];
 #endif
 
 static  OS_EVENT  *USBD_MSC_OS_TaskSemTbl[USBD_MSC_CFG_MAX_NBR_DEV];
-static  OS_EVENT  *USBD_MSC_OS_EnumSignal;
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+static  OS_EVENT  *USBD_MSC_OS_DataSemTbl[USBD_MSC_CFG_MAX_NBR_DEV];
+#endif
+static  OS_EVENT  *USBD_MSC_OS_EnumSignalTbl[USBD_MSC_CFG_MAX_NBR_DEV];
 
 
 /*
@@ -157,7 +160,9 @@ static  void  USBD_MSC_OS_RefreshTask(void  *p_arg);
 *
 * Return(s)   : None.
 *
-* Note(s)     : None.
+* Note(s)     : (1) One MSC task is created for each class instance, so that the instances service their
+*                   logical units in parallel. uC/OS-II requires a unique priority per task: the task of
+*                   class instance 'n' runs at priority (USBD_MSC_OS_CFG_TASK_PRIO + n).
 *********************************************************************************************************
 */
 
@@ -165,7 +170,11 @@ void  USBD_MSC_OS_Init (USBD_ERR  *p_err)
 {
     OS_EVENT    **p_comm_sem;
     OS_EVENT    **p_enum_sem;
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+    OS_EVENT    **p_data_sem;
+#endif
     INT8U         os_err;
+    INT8U         prio;
     CPU_INT08U    class_nbr;
 
 
@@ -178,60 +187,76 @@ void  USBD_MSC_OS_Init (USBD_ERR  *p_err)
             return;
         }
     }
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+                                                                /* Create sem for signal used for MSC data xfers.       */
+    for (class_nbr = 0; class_nbr < USBD_MSC_CFG_MAX_NBR_DEV; class_nbr++) {
+        p_data_sem = &USBD_MSC_OS_DataSemTbl[class_nbr];
+       *p_data_sem = OSSemCreate(0u);
+        if (*p_data_sem == (OS_EVENT *)0) {
+           *p_err = USBD_ERR_OS_SIGNAL_CREATE;
+            return;
+        }
+    }
+#endif
                                                                 /* Create sem for signal used for MSC enum.             */
-    p_enum_sem = &USBD_MSC_OS_EnumSignal;
-   *p_enum_sem = OSSemCreate(0u);
-    if (*p_enum_sem == (OS_EVENT *)0) {
-       *p_err = USBD_ERR_OS_SIGNAL_CREATE;
-        return;
+    for (class_nbr = 0; class_nbr < USBD_MSC_CFG_MAX_NBR_DEV; class_nbr++) {
+        p_enum_sem = &USBD_MSC_OS_EnumSignalTbl[class_nbr];
+       *p_enum_sem = OSSemCreate(0u);
+        if (*p_enum_sem == (OS_EVENT *)0) {
+           *p_err = USBD_ERR_OS_SIGNAL_CREATE;
+            return;
+        }
     }
-
+                                                                /* Create one MSC task per class instance (see Note #1).*/
+    for (class_nbr = 0; class_nbr < USBD_MSC_CFG_MAX_NBR_DEV; class_nbr++) {
+        prio = USBD_MSC_OS_CFG_TASK_PRIO + class_nbr;
 #if (OS_TASK_CREATE_EXT_EN == 1u)
 #if (OS_STK_GROWTH == 1u)
-    os_err = OSTaskCreateExt(        USBD_MSC_OS_Task,
-                             (void *)0,
-                                    &USBD_MSC_OS_TaskStk[USBD_MSC_OS_CFG_TASK_STK_SIZE - 1u],
-                                     USBD_MSC_OS_CFG_TASK_PRIO,
-                                     USBD_MSC_OS_CFG_TASK_PRIO,
-                                    &USBD_MSC_OS_TaskStk[0],
-                                     USBD_MSC_OS_CFG_TASK_STK_SIZE,
-                             (void *)0,
-                                     OS_TASK_OPT_STK_CLR | OS_TASK_OPT_STK_CHK);
+        os_err = OSTaskCreateExt(                  USBD_MSC_OS_Task,
+                                 (void *)(CPU_ADDR)class_nbr,
+                                                  &USBD_MSC_OS_TaskStk[class_nbr][USBD_MSC_OS_CFG_TASK_STK_SIZE - 1u],
+                                                   prio,
+                                                   prio,
+                                                  &USBD_MSC_OS_TaskStk[class_nbr][0],
+                                                   USBD_MSC_OS_CFG_TASK_STK_SIZE,
+                                 (void *)          0,
+                                                   OS_TASK_OPT_STK_CLR | OS_TASK_OPT_STK_CHK);
 #else
-    os_err = OSTaskCreateExt(        USBD_MSC_OS_Task,
-                             (void *)0,
-                                    &USBD_MSC_OS_TaskStk[0],
-                                     USBD_MSC_OS_CFG_TASK_PRIO,
-                                     USBD_MSC_OS_CFG_TASK_PRIO,
-                                    &USBD_MSC_OS_TaskStk[USBD_MSC_OS_CFG_TASK_STK_SIZE - 1u],
-                                     USBD_MSC_OS_CFG_TASK_STK_SIZE,
-                             (void *)0,
-                                    (OS_TASK_OPT_STK_CLR | OS_TASK_OPT_STK_CHK));
+        os_err = OSTaskCreateExt(                  USBD_MSC_OS_Task,
+                                 (void *)(CPU_ADDR)class_nbr,
+                                                  &USBD_MSC_OS_TaskStk[class_nbr][0],
+                                                   prio,
+                                                   prio,
+                                                  &USBD_MSC_OS_TaskStk[class_nbr][USBD_MSC_OS_CFG_TASK_STK_SIZE - 1u],
+                                                   USBD_MSC_OS_CFG_TASK_STK_SIZE,
+                                 (void *)          0,
+                                                  (OS_TASK_OPT_STK_CLR | OS_TASK_OPT_STK_CHK));
 #endif
 
 #else
 
 #if (OS_STK_GROWTH == 1u)
-    os_err = OSTaskCreate(        USBD_MSC_OS_Task,
-                          (void *)0,
-                                 &USBD_MSC_OS_TaskStk[USBD_MSC_OS_CFG_TASK_STK_SIZE - 1u],
-                                  USBD_MSC_OS_CFG_TASK_PRIO);
+        os_err = OSTaskCreate(                  USBD_MSC_OS_Task,
+                              (void *)(CPU_ADDR)class_nbr,
+                                               &USBD_MSC_OS_TaskStk[class_nbr][USBD_MSC_OS_CFG_TASK_STK_SIZE - 1u],
+                                                prio);
 #else
-    os_err = OSTaskCreate(        USBD_MSC_OS_Task,
-                          (void *)0,
-                                 &USBD_MSC_OS_TaskStk[0],
-                                  USBD_MSC_OS_CFG_TASK_PRIO);
+        os_err = OSTaskCreate(                  USBD_MSC_OS_Task,
+                              (void *)(CPU_ADDR)class_nbr,
+                                               &USBD_MSC_OS_TaskStk[class_nbr][0],
+                                                prio);
 #endif
 
 #endif
-    if (os_err != OS_ERR_NONE) {
-       *p_err   = USBD_ERR_OS_INIT_FAIL;
-        return;
-    }
+        if (os_err != OS_ERR_NONE) {
+           *p_err   = USBD_ERR_OS_INIT_FAIL;
+            return;
+        }
 
 #if (OS_TASK_STAT_EN > 0)
-    OSTaskNameSet(USBD_MSC_OS_CFG_TASK_PRIO, (INT8U *)"USB MSC Task", &os_err);
+        OSTaskNameSet(prio, (INT8U *)"USB MSC Task", &os_err);
 #endif
+    }
 
 #if (USBD_MSC_CFG_FS_REFRESH_TASK_EN == DEF_ENABLED)
 
@@ -474,13 +499,116 @@ void  USBD_MSC_OS_CommSignalDel (CPU_INT08U   class_nbr,
 }
 
 
+/*
+*********************************************************************************************************
+*                                          USBD_MSC_OS_DataSignalPost()
+*
+* Description : Post a semaphore used to signal the completion of an MSC data transfer.
+*
+* Argument(s) : class_nbr   MSC instance class number
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE       OS signal     successfully posted.
+*                               USBD_ERR_OS_FAIL    OS signal NOT successfully posted.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) This function may be called from an ISR.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+void  USBD_MSC_OS_DataSignalPost (CPU_INT08U   class_nbr,
+                                  USBD_ERR    *p_err)
+{
+    OS_EVENT  *p_data_sem;
+    INT8U      os_err;
+
+
+    p_data_sem = USBD_MSC_OS_DataSemTbl[class_nbr];
+
+    os_err = OSSemPost(p_data_sem);
+    if (os_err == OS_ERR_NONE) {
+       *p_err = USBD_ERR_NONE;
+    } else {
+       *p_err = USBD_ERR_OS_FAIL;
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_MSC_OS_DataSignalPend()
+*
+* Description : Wait on a semaphore signaling the completion of an MSC data transfer.
+*
+* Argument(s) : class_nbr   MSC instance class number
+*
+*               timeout     Timeout in milliseconds.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*                               USBD_ERR_NONE          The call was successful and your task owns the resource
+*                                                       or, the event you are waiting for occurred.
+*                               USBD_ERR_OS_TIMEOUT    The semaphore was not received within the specified timeout.
+*                               USBD_ERR_OS_FAIL       otherwise.
+*
+* Return(s)   : None.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+void  USBD_MSC_OS_DataSignalPend (CPU_INT08U   class_nbr,
+                                  CPU_INT32U   timeout,
+                                  USBD_ERR    *p_err)
+{
+    OS_EVENT  *p_data_sem;
+    INT8U      os_err;
+    INT32U     timeout_ticks;
+
+
+    p_data_sem    = USBD_MSC_OS_DataSemTbl[class_nbr];
+    timeout_ticks = ((((INT32U)timeout * OS_TICKS_PER_SEC) + 1000u - 1u) / 1000u);
+
+    OSSemPend(p_data_sem, timeout_ticks, &os_err);
+
+    switch (os_err) {
+        case OS_ERR_NONE:
+            *p_err = USBD_ERR_NONE;
+             break;
+
+        case OS_ERR_TIMEOUT:
+            *p_err = USBD_ERR_OS_TIMEOUT;
+             break;
+
+        case OS_ERR_PEND_ABORT:
+            *p_err = USBD_ERR_OS_ABORT;
+             break;
+
+        case OS_ERR_EVENT_TYPE:
+        case OS_ERR_PEND_ISR:
+        case OS_ERR_PEVENT_NULL:
+        case OS_ERR_PEND_LOCKED:
+        default:
+            *p_err = USBD_ERR_OS_FAIL;
+             break;
+    }
+}
+#endif
+
+
 /*
 *********************************************************************************************************
 *                                          USBD_MSC_OS_EnumSignalPost()
 *
 * Description : Post a semaphore for MSC enumeration process.
 *
-* Argument(s) : p_err       Pointer to variable that will receive the return error code from this function :
+* Argument(s) : class_nbr   MSC instance class number
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
 *
 *                               USBD_ERR_NONE       OS signal     successfully posted.
 *                               USBD_ERR_OS_FAIL    OS signal NOT successfully posted.
@@ -491,12 +619,13 @@ void  USBD_MSC_OS_CommSignalDel (CPU_INT08U   class_nbr,
 *********************************************************************************************************
 */
 
-void  USBD_MSC_OS_EnumSignalPost (USBD_ERR   *p_err)
+void  USBD_MSC_OS_EnumSignalPost (CPU_INT08U   class_nbr,
+                                  USBD_ERR    *p_err)
 {
     OS_EVENT  *p_enum_sem;
 
 
-    p_enum_sem = USBD_MSC_OS_EnumSignal;
+    p_enum_sem = USBD_MSC_OS_EnumSignalTbl[class_nbr];
 
     OSSemPost(p_enum_sem);
 
@@ -510,7 +639,9 @@ void  USBD_MSC_OS_EnumSignalPost (USBD_ERR   *p_err)
 *
 * Description : Wait on a semaphore to become available for MSC enumeration process.
 *
-* Argument(s) : timeout     Timeout in milliseconds.
+* Argument(s) : class_nbr   MSC instance class number
+*
+*               timeout     Timeout in milliseconds.
 *
 *               p_err       Pointer to variable that will receive the return error code from this function :
 *                               USBD_ERR_NONE          The call was successful and your task owns the resource
@@ -524,15 +655,16 @@ void  USBD_MSC_OS_EnumSignalPost (USBD_ERR   *p_err)
 *********************************************************************************************************
 */
 
-void  USBD_MSC_OS_EnumSignalPend (CPU_INT32U  timeout,
-                                  USBD_ERR   *p_err)
+void  USBD_MSC_OS_EnumSignalPend (CPU_INT08U   class_nbr,
+                                  CPU_INT32U   timeout,
+                                  USBD_ERR    *p_err)
 {
     OS_EVENT  *p_enum_sem;
     INT8U      os_err;
     INT32U     timeout_ticks;
 
 
-    p_enum_sem    = USBD_MSC_OS_EnumSignal;
+    p_enum_sem    = USBD_MSC_OS_EnumSignalTbl[class_nbr];
     timeout_ticks = ((((INT32U)timeout * OS_TICKS_PER_SEC) + 1000u - 1u) / 1000u);
 
     OSSemPend(p_enum_sem, timeout_ticks, &os_err);
@@ -106,8 +106,8 @@
 *********************************************************************************************************
 */
 
-static  OS_TCB   USBD_MSC_OS_TaskTCB;
-static  CPU_STK  USBD_MSC_OS_TaskStk[USBD_MSC_OS_CFG_TASK_STK_SIZE];
+static  OS_TCB   USBD_MSC_OS_TaskTCB[USBD_MSC_CFG_MAX_NBR_DEV];
+static  CPU_STK  USBD_MSC_OS_TaskStk[USBD_MSC_CFG_MAX_NBR_DEV][USBD_MSC_OS_CFG_TASK_STK_SIZE];
 
 #if (USBD_MSC_CFG_FS_REFRESH_TASK_EN == DEF_ENABLED)
 static  OS_TCB   USBD_MSC_OS_RefreshTaskTCB;
@@ -116,7 +116,11 @@ static  CPU_STK  USBD_MSC_OS_RefreshTaskStk[USBD_MSC_OS_CFG_REFRESH_TASK_STK_SIZ
 
 static  OS_SEM   USBD_MSC_OS_TASK_SemTbl[USBD_MSC_CFG_MAX_NBR_DEV];
 
-static  OS_SEM   USBD_MSC_OS_EnumSignal;
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+static  OS_SEM   USBD_MSC_OS_DataSemTbl[USBD_MSC_CFG_MAX_NBR_DEV];
+#endif
+
+static  OS_SEM   USBD_MSC_OS_EnumSignalTbl[USBD_MSC_CFG_MAX_NBR_DEV];
 
 
 /*
@@ -160,7 +164,8 @@ static  void  USBD_MSC_OS_RefreshTask(void  *p_arg);
 *
 * Return(s)   : None.
 *
-* Note(s)     : None.
+* Note(s)     : (1) One MSC task is created for each class instance, so that the instances service their
+*                   logical units in parallel. All the MSC tasks share USBD_MSC_OS_CFG_TASK_PRIO.
 *********************************************************************************************************
 */
 
@@ -170,6 +175,9 @@ void  USBD_MSC_OS_Init (USBD_ERR  *p_err)
     CPU_INT08U    class_nbr;
     OS_SEM       *p_comm_sem;
     OS_SEM       *p_enum_sem;
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+    OS_SEM       *p_data_sem;
+#endif
 
 
                                                                 /* Create sem for signal used for MSC comm.             */
@@ -184,33 +192,51 @@ void  USBD_MSC_OS_Init (USBD_ERR  *p_err)
             return;
         }
     }
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+                                                                /* Create sem for signal used for MSC data xfers.       */
+    for (class_nbr = 0u; class_nbr < USBD_MSC_CFG_MAX_NBR_DEV; class_nbr++) {
+        p_data_sem = &USBD_MSC_OS_DataSemTbl[class_nbr];
+        OSSemCreate(p_data_sem,
+                   "USB-Device MSC Data Sem",
+                    0u,
+                   &kernel_err);
+        if (kernel_err != OS_ERR_NONE) {
+           *p_err = USBD_ERR_OS_SIGNAL_CREATE;
+            return;
+        }
+    }
+#endif
                                                                 /* Create sem for signal used for MSC enum.             */
-    p_enum_sem = &USBD_MSC_OS_EnumSignal;
-    OSSemCreate(p_enum_sem,
-               "USB-Device MSC Connect Sem",
-                0u,
-               &kernel_err);
-    if (kernel_err != OS_ERR_NONE) {
-       *p_err = USBD_ERR_OS_SIGNAL_CREATE;
-        return;
+    for (class_nbr = 0u; class_nbr < USBD_MSC_CFG_MAX_NBR_DEV; class_nbr++) {
+        p_enum_sem = &USBD_MSC_OS_EnumSignalTbl[class_nbr];
+        OSSemCreate(p_enum_sem,
+                   "USB-Device MSC Connect Sem",
+                    0u,
+                   &kernel_err);
+        if (kernel_err != OS_ERR_NONE) {
+           *p_err = USBD_ERR_OS_SIGNAL_CREATE;
+            return;
+        }
     }
-
-    OSTaskCreate(        &USBD_MSC_OS_TaskTCB,
-                         "USB MSC Task",
-                          USBD_MSC_OS_Task,
-                 (void *) 0,
-                          USBD_MSC_OS_CFG_TASK_PRIO,
-                         &USBD_MSC_OS_TaskStk[0],
-                          USBD_MSC_OS_CFG_TASK_STK_SIZE / 10u,
-                          USBD_MSC_OS_CFG_TASK_STK_SIZE,
-                          0u,
-                          0u,
-                 (void *) 0,
-                          OS_OPT_TASK_STK_CHK | OS_OPT_TASK_STK_CLR,
-                         &kernel_err);
-    if (kernel_err != OS_ERR_NONE) {
-       *p_err = USBD_ERR_OS_INIT_FAIL;
-        return;
+                                                                /* Create one MSC task per class instance (see Note #1).*/
+    for (class_nbr = 0u; class_nbr < USBD_MSC_CFG_MAX_NBR_DEV; class_nbr++) {
+        OSTaskCreate(                  &USBD_MSC_OS_TaskTCB[class_nbr],
+                                       "USB MSC Task",
+                                        USBD_MSC_OS_Task,
+                     (void *)(CPU_ADDR) class_nbr,
+                                        USBD_MSC_OS_CFG_TASK_PRIO,
+                                       &USBD_MSC_OS_TaskStk[class_nbr][0],
+                                        USBD_MSC_OS_CFG_TASK_STK_SIZE / 10u,
+                                        USBD_MSC_OS_CFG_TASK_STK_SIZE,
+                                        0u,
+                                        0u,
+                     (void *)           0,
+                                        OS_OPT_TASK_STK_CHK | OS_OPT_TASK_STK_CLR,
+                                       &kernel_err);
+        if (kernel_err != OS_ERR_NONE) {
+           *p_err = USBD_ERR_OS_INIT_FAIL;
+            return;
+        }
     }
 
 #if (USBD_MSC_CFG_FS_REFRESH_TASK_EN == DEF_ENABLED)
@@ -439,13 +465,121 @@ void  USBD_MSC_OS_CommSignalDel (CPU_INT08U   class_nbr,
 }
 
 
+/*
+*********************************************************************************************************
+*                                          USBD_MSC_OS_DataSignalPost()
+*
+* Description : Post a semaphore used to signal the completion of an MSC data transfer.
+*
+* Argument(s) : class_nbr   MSC instance class number
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE       OS signal     successfully posted.
+*                               USBD_ERR_OS_FAIL    OS signal NOT successfully posted.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) This function may be called from an ISR.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+void  USBD_MSC_OS_DataSignalPost (CPU_INT08U   class_nbr,
+                                  USBD_ERR    *p_err)
+{
+    OS_SEM  *p_data_sem;
+    OS_ERR   kernel_err;
+
+
+    p_data_sem = &USBD_MSC_OS_DataSemTbl[class_nbr];
+
+    OSSemPost(p_data_sem,
+              OS_OPT_POST_1,
+             &kernel_err);
+    if(kernel_err == OS_ERR_NONE) {
+       *p_err = USBD_ERR_NONE;
+    } else {
+       *p_err = USBD_ERR_OS_FAIL;
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_MSC_OS_DataSignalPend()
+*
+* Description : Wait on a semaphore signaling the completion of an MSC data transfer.
+*
+* Argument(s) : class_nbr   MSC instance class number
+*
+*               timeout     Timeout in milliseconds.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*                               USBD_ERR_NONE          The call was successful and your task owns the resource
+*                                                       or, the event you are waiting for occurred.
+*                               USBD_ERR_OS_TIMEOUT    The semaphore was not received within the specified timeout.
+*                               USBD_ERR_OS_FAIL       otherwise.
+*
+* Return(s)   : None.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+void  USBD_MSC_OS_DataSignalPend (CPU_INT08U   class_nbr,
+                                  CPU_INT32U   timeout,
+                                  USBD_ERR    *p_err)
+{
+    OS_SEM  *p_data_sem;
+    OS_ERR   kernel_err;
+    OS_TICK  timeout_ticks;
+
+
+    p_data_sem    = &USBD_MSC_OS_DataSemTbl[class_nbr];
+    timeout_ticks = ((((OS_TICK)timeout * OSCfg_TickRate_Hz) + 1000u - 1u) / 1000u);
+
+    OSSemPend(          p_data_sem,
+                        timeout_ticks,
+                        OS_OPT_PEND_BLOCKING,
+              (CPU_TS *)0,
+                       &kernel_err);
+
+    switch (kernel_err) {
+        case OS_ERR_NONE:
+            *p_err = USBD_ERR_NONE;
+             break;
+
+
+        case OS_ERR_TIMEOUT:
+            *p_err = USBD_ERR_OS_TIMEOUT;
+             break;
+
+
+        case OS_ERR_PEND_ABORT:
+            *p_err = USBD_ERR_OS_ABORT;
+             break;
+
+
+        default:
+            *p_err = USBD_ERR_OS_FAIL;
+             break;
+    }
+}
+#endif
+
+
 /*
 *********************************************************************************************************
 *                                          USBD_MSC_OS_EnumSignalPost()
 *
 * Description : Post a semaphore for MSC enumeration process.
 *
-* Argument(s) : p_err       Pointer to variable that will receive the return error code from this function :
+* Argument(s) : class_nbr   MSC instance class number
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
 *
 *                               USBD_ERR_NONE       OS signal     successfully posted.
 *                               USBD_ERR_OS_FAIL    OS signal NOT successfully posted.
@@ -456,13 +590,14 @@ void  USBD_MSC_OS_CommSignalDel (CPU_INT08U   class_nbr,
 *********************************************************************************************************
 */
 
-void  USBD_MSC_OS_EnumSignalPost (USBD_ERR  *p_err)
+void  USBD_MSC_OS_EnumSignalPost (CPU_INT08U   class_nbr,
+                                  USBD_ERR    *p_err)
 {
     OS_SEM  *p_enum_sem;
     OS_ERR   kernel_err;
 
 
-    p_enum_sem = &USBD_MSC_OS_EnumSignal;
+    p_enum_sem = &USBD_MSC_OS_EnumSignalTbl[class_nbr];
 
     OSSemPost(p_enum_sem,
               OS_OPT_POST_1,
@@ -481,7 +616,9 @@ void  USBD_MSC_OS_EnumSignalPost (USBD_ERR  *p_err)
 *
 * Description : Wait on a semaphore to become available for MSC enumeration process.
 *
-* Argument(s) : timeout     Timeout in milliseconds.
+* Argument(s) : class_nbr   MSC instance class number
+*
+*               timeout     Timeout in milliseconds.
 *
 *               p_err       Pointer to variable that will receive the return error code from this function :
 *                               USBD_ERR_NONE          The call was successful and your task owns the resource
@@ -495,15 +632,16 @@ void  USBD_MSC_OS_EnumSignalPost (USBD_ERR  *p_err)
 *********************************************************************************************************
 */
 
-void  USBD_MSC_OS_EnumSignalPend (CPU_INT32U  timeout,
-                                  USBD_ERR   *p_err)
+void  USBD_MSC_OS_EnumSignalPend (CPU_INT08U   class_nbr,
+                                  CPU_INT32U   timeout,
+                                  USBD_ERR    *p_err)
 {
     OS_SEM  *p_enum_sem;
     OS_ERR   kernel_err;
     OS_TICK  timeout_ticks;
 
 
-    p_enum_sem    = &USBD_MSC_OS_EnumSignal;
+    p_enum_sem    = &USBD_MSC_OS_EnumSignalTbl[class_nbr];
     timeout_ticks = ((((OS_TICK)timeout * OSCfg_TickRate_Hz) + 1000u - 1u) / 1000u);
 
     OSSemPend(          p_enum_sem,
@@ -45,6 +45,23 @@
 #define  USBD_RAMDISK_SIZE       (USBD_RAMDISK_CFG_BLK_SIZE * \
                                   USBD_RAMDISK_CFG_NBR_BLKS)
 
+#define  USBD_RAMDISK_UNIT_NONE          DEF_INT_08U_MAX_VAL    /* Logical unit without RAMDisk unit.                   */
+
+#if (USBD_RAMDISK_CFG_SPARSE_EN == DEF_ENABLED)
+#define  USBD_RAMDISK_POOL_SIZE                  (USBD_RAMDISK_CFG_BLK_SIZE * \
+                                                  USBD_RAMDISK_CFG_POOL_NBR_BLKS)
+
+#define  USBD_RAMDISK_BLK_NONE                            0u    /* Logical blk not mapped, or end of list.              */
+
+#define  USBD_RAMDISK_HASH_NBR_BUCKETS                   64u    /* Nbr of chains of the content hash tbl.               */
+#define  USBD_RAMDISK_HASH_FNV_OFFSET            0x811C9DC5u    /* FNV-1a 32-bit hash parameters.                       */
+#define  USBD_RAMDISK_HASH_FNV_PRIME             0x01000193u
+
+                                                                /* Pool blks are numbered from 1.                       */
+#define  USBD_RAMDISK_POOL_BLK_PTR(blk_nbr)      (&USBD_RAMDISK_PoolArea[((CPU_SIZE_T)(blk_nbr) - 1u) * \
+                                                                         USBD_RAMDISK_CFG_BLK_SIZE])
+#endif
+
 
 /*
 *********************************************************************************************************
@@ -59,11 +76,40 @@
 *********************************************************************************************************
 */
 
+#if (USBD_RAMDISK_CFG_SPARSE_EN == DEF_DISABLED)
 #if (USBD_RAMDISK_CFG_BASE_ADDR == 0)
 static  CPU_INT08U  USBD_RAMDISK_DataArea[USBD_RAMDISK_CFG_NBR_UNITS][USBD_RAMDISK_SIZE];
 #else
 static  CPU_INT08U *USBD_RAMDISK_DataArea[USBD_RAMDISK_CFG_NBR_UNITS];
 #endif
+#else
+/*
+*********************************************************************************************************
+*                                        SPARSE RAMDISK BLOCK POOL
+*
+* Note(s) : (1) Each logical block of each unit is mapped to a pool block. Pool blocks are numbered from 1
+*               to USBD_RAMDISK_CFG_POOL_NBR_BLKS, and USBD_RAMDISK_BLK_NONE marks a logical block that
+*               holds only zeros. All the tables can then start cleared.
+*
+*           (2) A pool block in use is linked in the chain of the content hash table that matches its hash,
+*               and is shared by 'RefCnt' logical blocks. A free pool block is linked in the free list.
+*********************************************************************************************************
+*/
+
+#if (USBD_RAMDISK_CFG_BASE_ADDR == 0)
+static  CPU_INT08U   USBD_RAMDISK_PoolArea[USBD_RAMDISK_POOL_SIZE];
+#else
+static  CPU_INT08U  *USBD_RAMDISK_PoolArea;
+#endif
+                                                                /* Pool blk mapped to each logical blk.                 */
+static  CPU_INT16U   USBD_RAMDISK_BlkMap[USBD_RAMDISK_CFG_NBR_UNITS][USBD_RAMDISK_CFG_NBR_BLKS];
+
+typedef  struct  usbd_ramdisk_pool_blk {
+    CPU_INT32U  RefCnt;                                         /* Nbr of logical blks mapped to the pool blk.          */
+    CPU_INT32U  Hash;                                           /* Hash of the blk content.                             */
+    CPU_INT16U  NextNbr;                                        /* Next blk of the hash chain or of the free list.      */
+} USBD_RAMDISK_POOL_BLK;
+#endif
 
 
 /*
@@ -78,6 +124,19 @@ static  CPU_INT08U *USBD_RAMDISK_DataArea[USBD_RAMDISK_CFG_NBR_UNITS];
 *                                       LOCAL GLOBAL VARIABLES
 *********************************************************************************************************
 */
+                                                                /* RAMDisk unit of each logical unit, per class.        */
+static  CPU_INT08U             USBD_RAMDISK_UnitTbl[USBD_MSC_CFG_MAX_NBR_DEV][USBD_MSC_CFG_MAX_LUN];
+static  CPU_INT08U             USBD_RAMDISK_UnitNextNbr;        /* Next RAMDisk unit to assign.                         */
+
+#if (USBD_RAMDISK_CFG_SPARSE_EN == DEF_ENABLED)
+                                                                /* Pool blks, indexed by blk nbr.                       */
+static  USBD_RAMDISK_POOL_BLK  USBD_RAMDISK_PoolBlkTbl[USBD_RAMDISK_CFG_POOL_NBR_BLKS + 1u];
+static  CPU_INT16U             USBD_RAMDISK_HashTbl[USBD_RAMDISK_HASH_NBR_BUCKETS];
+static  CPU_INT16U             USBD_RAMDISK_PoolFreeNbr;        /* First blk of the free list.                          */
+static  CPU_INT32U             USBD_RAMDISK_PoolUsedCnt;        /* Nbr of pool blks in use.                             */
+                                                                /* Nbr of logical blks mapped, per unit.                */
+static  CPU_INT32U             USBD_RAMDISK_MappedBlkCnt[USBD_RAMDISK_CFG_NBR_UNITS];
+#endif
 
 
 /*
@@ -86,6 +145,31 @@ static  CPU_INT08U *USBD_RAMDISK_DataArea[USBD_RAMDISK_CFG_NBR_UNITS];
 *********************************************************************************************************
 */
 
+static  CPU_INT08U  USBD_RAMDISK_UnitGet    (CPU_INT08U   class_nbr,
+                                             CPU_INT08U   lun_nbr);
+
+#if (USBD_RAMDISK_CFG_SPARSE_EN == DEF_ENABLED)
+static  void        USBD_RAMDISK_BlkRd      (CPU_INT08U   lun,
+                                             CPU_INT64U   blk_addr,
+                                             CPU_INT08U  *p_buf);
+
+static  void        USBD_RAMDISK_BlkWr      (CPU_INT08U   lun,
+                                             CPU_INT64U   blk_addr,
+                                             CPU_INT08U  *p_buf,
+                                             USBD_ERR    *p_err);
+
+static  void        USBD_RAMDISK_BlkRel     (CPU_INT08U   lun,
+                                             CPU_INT64U   blk_addr);
+
+static  CPU_INT32U  USBD_RAMDISK_BlkHash    (CPU_INT08U  *p_buf,
+                                             CPU_BOOLEAN *p_is_zero);
+
+static  CPU_INT16U  USBD_RAMDISK_PoolBlkFind(CPU_INT08U  *p_buf,
+                                             CPU_INT32U   hash);
+
+static  void        USBD_RAMDISK_PoolBlkRel (CPU_INT16U   blk_nbr);
+#endif
+
 
 /*
 *********************************************************************************************************
@@ -114,12 +198,41 @@ static  CPU_INT08U *USBD_RAMDISK_DataArea[USBD_RAMDISK_CFG_NBR_UNITS];
 *
 * Return(s)   : None.
 *
-* Note(s)     : None.
+* Note(s)     : (1) In sparse mode, all the pool blocks are put in the free list.
+*
+*               (2) No logical unit has a RAMDisk unit until it is added (see USBD_StorageAdd() Note #1).
 *********************************************************************************************************
 */
 
 void  USBD_StorageInit (USBD_ERR  *p_err)
 {
+#if (USBD_RAMDISK_CFG_SPARSE_EN == DEF_ENABLED)
+    CPU_INT32U  blk_nbr;
+#endif
+
+
+    Mem_Set((void *)&USBD_RAMDISK_UnitTbl[0][0],                /* See Note #2.                                         */
+                     USBD_RAMDISK_UNIT_NONE,
+                     sizeof(USBD_RAMDISK_UnitTbl));
+    USBD_RAMDISK_UnitNextNbr = 0u;
+
+#if (USBD_RAMDISK_CFG_SPARSE_EN == DEF_ENABLED)
+#if (USBD_RAMDISK_CFG_BASE_ADDR != 0)
+    USBD_RAMDISK_PoolArea = (CPU_INT08U *)USBD_RAMDISK_CFG_BASE_ADDR;
+#endif
+    for (blk_nbr = 1u; blk_nbr <= USBD_RAMDISK_CFG_POOL_NBR_BLKS; blk_nbr++) {
+        USBD_RAMDISK_PoolBlkTbl[blk_nbr].RefCnt  = 0u;          /* See Note #1.                                         */
+        USBD_RAMDISK_PoolBlkTbl[blk_nbr].Hash    = 0u;
+        USBD_RAMDISK_PoolBlkTbl[blk_nbr].NextNbr = (blk_nbr < USBD_RAMDISK_CFG_POOL_NBR_BLKS) ? (CPU_INT16U)(blk_nbr + 1u)
+                                                                                                : USBD_RAMDISK_BLK_NONE;
+    }
+    USBD_RAMDISK_PoolFreeNbr = 1u;
+    USBD_RAMDISK_PoolUsedCnt = 0u;
+
+    Mem_Clr((void *)&USBD_RAMDISK_HashTbl[0],
+                     sizeof(USBD_RAMDISK_HashTbl));
+#endif
+
    *p_err = USBD_ERR_NONE;
 }
 
@@ -135,22 +248,56 @@ void  USBD_StorageInit (USBD_ERR  *p_err)
 *               p_err       Pointer to variable that will receive error code from this function.
 *
 *                                USBD_ERR_NONE                  Storage successfully initialized.
-*                                USBD_ERR_SCSI_LOG_UNIT_NOTRDY  Initiliazing RAM area failed.
+*                                USBD_ERR_SCSI_LOG_UNIT_NOTRDY  Initiliazing RAM area failed, or no RAMDisk
+*                                                                   unit left.
 *
 * Return(s)   : None.
 *
-* Note(s)     : None.
+* Note(s)     : (1) RAMDisk units are shared by all the MSC class instances. A unit is assigned to each
+*                   logical unit, identified by its class instance and logical unit numbers, the first
+*                   time it is added. Adding it again reuses and clears the same unit.
+*
+*               (2) In sparse mode, the blocks of the unit are released, so that they read back as zeros.
 *********************************************************************************************************
 */
 
 void  USBD_StorageAdd (USBD_STORAGE_LUN  *p_storage_lun,
                        USBD_ERR          *p_err)
 {
+#if (USBD_RAMDISK_CFG_SPARSE_EN == DEF_ENABLED)
+    CPU_INT64U  blk_addr;
+#else
     CPU_INT32U  ix;
+#endif
     CPU_INT08U  lun_nbr;
+    CPU_SR_ALLOC();
+
+
+    if ((p_storage_lun->ClassNbr >= USBD_MSC_CFG_MAX_NBR_DEV) ||
+        (p_storage_lun->LunNbr   >= USBD_MSC_CFG_MAX_LUN)) {
+       *p_err = USBD_ERR_SCSI_LU_NOTRDY;
+        return;
+    }
 
+    CPU_CRITICAL_ENTER();                                       /* See Note #1.                                         */
+    lun_nbr = USBD_RAMDISK_UnitTbl[p_storage_lun->ClassNbr][p_storage_lun->LunNbr];
+    if (lun_nbr == USBD_RAMDISK_UNIT_NONE) {
+        if (USBD_RAMDISK_UnitNextNbr >= USBD_RAMDISK_CFG_NBR_UNITS) {
+            CPU_CRITICAL_EXIT();
+           *p_err = USBD_ERR_SCSI_LU_NOTRDY;
+            return;
+        }
+        lun_nbr = USBD_RAMDISK_UnitNextNbr;
+        USBD_RAMDISK_UnitNextNbr++;
+        USBD_RAMDISK_UnitTbl[p_storage_lun->ClassNbr][p_storage_lun->LunNbr] = lun_nbr;
+    }
+    CPU_CRITICAL_EXIT();
 
-    lun_nbr = p_storage_lun->LunNbr;
+#if (USBD_RAMDISK_CFG_SPARSE_EN == DEF_ENABLED)
+    for (blk_addr = 0u; blk_addr < USBD_RAMDISK_CFG_NBR_BLKS; blk_addr++) {
+        USBD_RAMDISK_BlkRel(lun_nbr, blk_addr);                 /* See Note #2.                                         */
+    }
+#else
                                                                 /* Fill the RAM area with zeros.                        */
 #if (USBD_RAMDISK_CFG_BASE_ADDR != 0)
     USBD_RAMDISK_DataArea[lun_nbr] = (CPU_INT08U *)USBD_RAMDISK_CFG_BASE_ADDR + lun_nbr * USBD_RAMDISK_SIZE;
@@ -164,6 +311,7 @@ void  USBD_StorageAdd (USBD_STORAGE_LUN  *p_storage_lun,
             return;
         }
     }
+#endif
 
     p_storage_lun->MediumPresent = DEF_TRUE;                    /* RAMDisk medium is initially always present.          */
    *p_err                        = USBD_ERR_NONE;
@@ -228,7 +376,7 @@ void  USBD_StorageCapacityGet (USBD_STORAGE_LUN  *p_storage_lun,
 *
 * Return(s)   : None.
 *
-* Note(s)     : None.
+* Note(s)     : (1) In sparse mode, the blocks are read one at a time from the block pool.
 *********************************************************************************************************
 */
 
@@ -239,13 +387,33 @@ void  USBD_StorageRd (USBD_STORAGE_LUN  *p_storage_lun,
                       USBD_ERR          *p_err)
 {
     CPU_INT08U  lun;
+#if (USBD_RAMDISK_CFG_SPARSE_EN == DEF_ENABLED)
+    CPU_INT32U  blk_ix;
+#else
     CPU_INT64U  mem_area_size;
     CPU_INT32U  mem_size_copy;
+#endif
 
 
-    lun = (*p_storage_lun).LunNbr;
+    lun = USBD_RAMDISK_UnitGet(p_storage_lun->ClassNbr, p_storage_lun->LunNbr);
 
-    if (lun > USBD_RAMDISK_CFG_NBR_UNITS) {
+#if (USBD_RAMDISK_CFG_SPARSE_EN == DEF_ENABLED)
+    if (lun >= USBD_RAMDISK_CFG_NBR_UNITS) {
+       *p_err = USBD_ERR_SCSI_LU_NOTSUPPORTED;
+        return;
+    }
+
+    if ((blk_addr + nbr_blks) > USBD_RAMDISK_CFG_NBR_BLKS) {
+       *p_err = USBD_ERR_SCSI_LU_NOTRDY;
+        return;
+    }
+
+    for (blk_ix = 0u; blk_ix < nbr_blks; blk_ix++) {            /* See Note #1.                                         */
+        USBD_RAMDISK_BlkRd(lun, blk_addr + blk_ix, p_data_buf);
+        p_data_buf += USBD_RAMDISK_CFG_BLK_SIZE;
+    }
+#else
+    if (lun >= USBD_RAMDISK_CFG_NBR_UNITS) {
        *p_err = USBD_ERR_SCSI_LU_NOTSUPPORTED;
         return;
     }
@@ -260,6 +428,7 @@ void  USBD_StorageRd (USBD_STORAGE_LUN  *p_storage_lun,
     Mem_Copy((void *) p_data_buf,
              (void *)&USBD_RAMDISK_DataArea[lun][blk_addr * USBD_RAMDISK_CFG_BLK_SIZE],
                       mem_size_copy);
+#endif
 
    *p_err = USBD_ERR_NONE;
 }
@@ -285,10 +454,17 @@ void  USBD_StorageRd (USBD_STORAGE_LUN  *p_storage_lun,
 *                               USBD_ERR_SCSI_LOG_UNIT_NOTSUPPORTED     Logical unit not supported.
 *                               USBD_ERR_SCSI_LOG_UNIT_NOTRDY           Logical unit cannot perform
 *                                                                           operations.
+*                               USBD_ERR_SCSI_SPACE_ALLOC               No free block left in the block
+*                                                                           pool (see Note #2).
 *
 * Return(s)   : None.
 *
-* Note(s)     : None.
+* Note(s)     : (1) When the data buffer was obtained from USBD_StorageWrPtrGet(), the data already
+*                   lies in the RAM disk data area and no copy is needed.
+*
+*               (2) In sparse mode, the blocks are written one at a time to the block pool. The write stops
+*                   at the first block for which the pool has no free block. That block and the following
+*                   ones keep their previous content.
 *********************************************************************************************************
 */
 
@@ -298,14 +474,116 @@ void  USBD_StorageWr (USBD_STORAGE_LUN  *p_storage_lun,
                       CPU_INT08U        *p_data_buf,
                       USBD_ERR          *p_err)
 {
+    CPU_INT08U   lun;
+#if (USBD_RAMDISK_CFG_SPARSE_EN == DEF_ENABLED)
+    CPU_INT32U   blk_ix;
+#else
+    CPU_INT64U   mem_area_size;
+    CPU_INT32U   mem_size_copy;
+    CPU_INT08U  *p_mem;
+#endif
+
+
+    lun = USBD_RAMDISK_UnitGet(p_storage_lun->ClassNbr, p_storage_lun->LunNbr);
+
+#if (USBD_RAMDISK_CFG_SPARSE_EN == DEF_ENABLED)
+    if (lun >= USBD_RAMDISK_CFG_NBR_UNITS) {
+       *p_err = USBD_ERR_SCSI_LU_NOTSUPPORTED;
+        return;
+    }
+
+    if ((blk_addr + nbr_blks) > USBD_RAMDISK_CFG_NBR_BLKS) {
+       *p_err = USBD_ERR_SCSI_LU_NOTRDY;
+        return;
+    }
+
+    for (blk_ix = 0u; blk_ix < nbr_blks; blk_ix++) {            /* See Note #2.                                         */
+        USBD_RAMDISK_BlkWr(lun, blk_addr + blk_ix, p_data_buf, p_err);
+        if (*p_err != USBD_ERR_NONE) {
+            return;
+        }
+        p_data_buf += USBD_RAMDISK_CFG_BLK_SIZE;
+    }
+#else
+    if (lun >= USBD_RAMDISK_CFG_NBR_UNITS) {
+       *p_err = USBD_ERR_SCSI_LU_NOTSUPPORTED;
+        return;
+    }
+
+    mem_area_size = ((blk_addr + nbr_blks) * USBD_RAMDISK_CFG_BLK_SIZE);
+    if (mem_area_size > USBD_RAMDISK_SIZE) {
+       *p_err = USBD_ERR_SCSI_LU_NOTRDY;
+        return;
+    }
+
+    p_mem         = &USBD_RAMDISK_DataArea[lun][blk_addr * USBD_RAMDISK_CFG_BLK_SIZE];
+    mem_size_copy =  nbr_blks * USBD_RAMDISK_CFG_BLK_SIZE;
+    if (p_mem != p_data_buf) {                                  /* See Note #1.                                         */
+        Mem_Copy((void *)p_mem,
+                 (void *)p_data_buf,
+                         mem_size_copy);
+    }
+#endif
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                           USBD_StorageRdPtrGet()
+*
+* Description : Get a pointer to the storage medium's data for a read operation.
+*
+* Argument(s) : p_storage_lun    Pointer to the logical unit storage structure.
+*
+*               blk_addr         Logical Block Address (LBA) of starting read block.
+*
+*               nbr_blks         Number of logical blocks to read.
+*
+*               pp_data_buf      Pointer to variable that will receive the pointer to the data.
+*
+*               p_err       Pointer to variable that will receive error code from this function.
+*
+*                               USBD_ERR_NONE                           Data pointer successfully returned.
+*                               USBD_ERR_SCSI_LOG_UNIT_NOTSUPPORTED     Logical unit not supported.
+*                               USBD_ERR_SCSI_LOG_UNIT_NOTRDY           Logical unit cannot perform
+*                                                                           operations.
+*                               USBD_ERR_SCSI_NO_DIRECT_BUF             Medium cannot be accessed directly.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The returned pointer refers directly to the RAM disk data area. The data can be sent
+*                   to the host without being copied first.
+*
+*               (2) In sparse mode, consecutive logical blocks are not contiguous in the block pool, and
+*                   blocks holding only zeros have no storage. USBD_ERR_SCSI_NO_DIRECT_BUF is returned and
+*                   the data is read with USBD_StorageRd().
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_ZERO_COPY_EN == DEF_ENABLED)
+void  USBD_StorageRdPtrGet (USBD_STORAGE_LUN    *p_storage_lun,
+                            CPU_INT64U           blk_addr,
+                            CPU_INT32U           nbr_blks,
+                            CPU_INT08U         **pp_data_buf,
+                            USBD_ERR            *p_err)
+{
+#if (USBD_RAMDISK_CFG_SPARSE_EN == DEF_ENABLED)
+    (void)p_storage_lun;
+    (void)blk_addr;
+    (void)nbr_blks;
+
+   *pp_data_buf = (CPU_INT08U *)0;
+   *p_err       =  USBD_ERR_SCSI_NO_DIRECT_BUF;                 /* See Note #2.                                         */
+#else
     CPU_INT08U  lun;
     CPU_INT64U  mem_area_size;
-    CPU_INT32U  mem_size_copy;
 
 
-    lun = (*p_storage_lun).LunNbr;
+    lun = USBD_RAMDISK_UnitGet(p_storage_lun->ClassNbr, p_storage_lun->LunNbr);
 
-    if (lun > USBD_RAMDISK_CFG_NBR_UNITS) {
+    if (lun >= USBD_RAMDISK_CFG_NBR_UNITS) {
        *p_err = USBD_ERR_SCSI_LU_NOTSUPPORTED;
         return;
     }
@@ -316,13 +594,266 @@ void  USBD_StorageWr (USBD_STORAGE_LUN  *p_storage_lun,
         return;
     }
 
-    mem_size_copy = nbr_blks * USBD_RAMDISK_CFG_BLK_SIZE;
-    Mem_Copy((void *)&USBD_RAMDISK_DataArea[lun][blk_addr * USBD_RAMDISK_CFG_BLK_SIZE],
-             (void *) p_data_buf,
-                      mem_size_copy);
+   *pp_data_buf = &USBD_RAMDISK_DataArea[lun][blk_addr * USBD_RAMDISK_CFG_BLK_SIZE];
+   *p_err       =  USBD_ERR_NONE;
+#endif
+}
+
+
+/*
+*********************************************************************************************************
+*                                           USBD_StorageWrPtrGet()
+*
+* Description : Get a pointer to the storage medium's data for a write operation.
+*
+* Argument(s) : p_storage_lun    Pointer to the logical unit storage structure.
+*
+*               blk_addr         Logical Block Address (LBA) of starting write block.
+*
+*               nbr_blks         Number of logical blocks to write.
+*
+*               pp_data_buf      Pointer to variable that will receive the pointer to the data.
+*
+*               p_err       Pointer to variable that will receive error code from this function.
+*
+*                               USBD_ERR_NONE                           Data pointer successfully returned.
+*                               USBD_ERR_SCSI_LOG_UNIT_NOTSUPPORTED     Logical unit not supported.
+*                               USBD_ERR_SCSI_LOG_UNIT_NOTRDY           Logical unit cannot perform
+*                                                                           operations.
+*                               USBD_ERR_SCSI_NO_DIRECT_BUF             Medium cannot be accessed directly.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The data received from the host is stored directly in the RAM disk data area. The
+*                   write is completed by calling USBD_StorageWr() with the returned pointer (see
+*                   USBD_StorageWr() Note #1).
+*
+*               (2) If the data transfer fails, the blocks may be left partially written, as with any
+*                   interrupted write to the medium.
+*
+*               (3) See USBD_StorageRdPtrGet() Note #2. The data is written with USBD_StorageWr().
+*********************************************************************************************************
+*/
+
+void  USBD_StorageWrPtrGet (USBD_STORAGE_LUN    *p_storage_lun,
+                            CPU_INT64U           blk_addr,
+                            CPU_INT32U           nbr_blks,
+                            CPU_INT08U         **pp_data_buf,
+                            USBD_ERR            *p_err)
+{
+    USBD_StorageRdPtrGet(p_storage_lun,                         /* Same location for rd & wr (see Notes #1 & #3).       */
+                         blk_addr,
+                         nbr_blks,
+                         pp_data_buf,
+                         p_err);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            USBD_StorageUnmap()
+*
+* Description : Release blocks of the storage medium that the host no longer uses.
+*
+* Argument(s) : p_storage_lun    Pointer to the logical unit storage structure.
+*
+*               blk_addr         Logical Block Address (LBA) of starting block to release.
+*
+*               nbr_blks         Number of logical blocks to release.
+*
+*               p_err       Pointer to variable that will receive error code from this function.
+*
+*                               USBD_ERR_NONE                          Blocks successfully released.
+*                               USBD_ERR_SCSI_LU_NOTSUPPORTED          Logical unit not supported.
+*                               USBD_ERR_SCSI_LU_NOTRDY                Logical unit cannot perform
+*                                                                          operations.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) A RAM disk has no space to reclaim. Released blocks are cleared, so that they read back
+*                   as zeros.
+*
+*               (2) In sparse mode, the pool blocks mapped to the released blocks are returned to the pool
+*                   once no other logical block shares them.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_UNMAP_EN == DEF_ENABLED)
+void  USBD_StorageUnmap (USBD_STORAGE_LUN  *p_storage_lun,
+                         CPU_INT64U         blk_addr,
+                         CPU_INT32U         nbr_blks,
+                         USBD_ERR          *p_err)
+{
+    CPU_INT08U   lun;
+#if (USBD_RAMDISK_CFG_SPARSE_EN == DEF_ENABLED)
+    CPU_INT32U   blk_ix;
+#else
+    CPU_INT64U   mem_area_size;
+    CPU_INT08U  *p_mem;
+#endif
+
+
+    lun = USBD_RAMDISK_UnitGet(p_storage_lun->ClassNbr, p_storage_lun->LunNbr);
+
+    if (lun >= USBD_RAMDISK_CFG_NBR_UNITS) {
+       *p_err = USBD_ERR_SCSI_LU_NOTSUPPORTED;
+        return;
+    }
+
+#if (USBD_RAMDISK_CFG_SPARSE_EN == DEF_ENABLED)
+    if ((blk_addr + nbr_blks) > USBD_RAMDISK_CFG_NBR_BLKS) {
+       *p_err = USBD_ERR_SCSI_LU_NOTRDY;
+        return;
+    }
+
+    for (blk_ix = 0u; blk_ix < nbr_blks; blk_ix++) {
+        USBD_RAMDISK_BlkRel(lun, blk_addr + blk_ix);            /* See Note #2.                                         */
+    }
+#else
+
+    mem_area_size = ((blk_addr + nbr_blks) * USBD_RAMDISK_CFG_BLK_SIZE);
+    if (mem_area_size > USBD_RAMDISK_SIZE) {
+       *p_err = USBD_ERR_SCSI_LU_NOTRDY;
+        return;
+    }
+
+    p_mem = &USBD_RAMDISK_DataArea[lun][blk_addr * USBD_RAMDISK_CFG_BLK_SIZE];
+    Mem_Clr((void     *)p_mem,                                  /* See Note #1.                                         */
+            (CPU_SIZE_T)(nbr_blks * USBD_RAMDISK_CFG_BLK_SIZE));
+#endif
 
    *p_err = USBD_ERR_NONE;
 }
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_StorageAsyncQDepthGet()
+*
+* Description : Get the number of asynchronous accesses the storage medium can have in progress.
+*
+* Argument(s) : p_storage_lun    Pointer to the logical unit storage structure.
+*
+* Return(s)   : Maximum number of accesses started with USBD_StorageRdAsync() or USBD_StorageWrAsync()
+*               that may be in progress at the same time, or 0 if asynchronous accesses are not supported.
+*
+* Note(s)     : (1) The RAM disk is accessed by the CPU, so there is no transfer to overlap with the USB
+*                   transfers. USBD_StorageRd() and USBD_StorageWr() are used.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_STORAGE_ASYNC_EN == DEF_ENABLED)
+CPU_INT08U  USBD_StorageAsyncQDepthGet (USBD_STORAGE_LUN  *p_storage_lun)
+{
+    (void)p_storage_lun;
+
+    return (0u);                                                /* See Note #1.                                         */
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_StorageRdAsync()
+*
+* Description : Start reading data from the storage medium.
+*
+* Argument(s) : p_storage_lun    Pointer to the logical unit storage structure.
+*
+*               blk_addr         Logical Block Address (LBA) of starting read block.
+*
+*               nbr_blks         Number of logical blocks to read.
+*
+*               p_data_buf       Pointer to buffer in which data will be stored.
+*
+*               cmpl_fnct        Function to call when the read completes.
+*
+*               p_cmpl_arg       Argument passed to 'cmpl_fnct'.
+*
+*               p_err       Pointer to variable that will receive error code from this function.
+*
+*                               USBD_ERR_NONE                           Read successfully started.
+*                               USBD_ERR_SCSI_LU_NOTSUPPORTED           Logical unit not supported.
+*                               USBD_ERR_SCSI_LU_NOTRDY                 Logical unit cannot perform
+*                                                                           operations.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) See USBD_StorageAsyncQDepthGet() Note #1. The read is done before returning and
+*                   'cmpl_fnct' is called on success.
+*********************************************************************************************************
+*/
+
+void  USBD_StorageRdAsync (USBD_STORAGE_LUN         *p_storage_lun,
+                           CPU_INT64U                blk_addr,
+                           CPU_INT32U                nbr_blks,
+                           CPU_INT08U               *p_data_buf,
+                           USBD_STORAGE_ASYNC_CMPL   cmpl_fnct,
+                           void                     *p_cmpl_arg,
+                           USBD_ERR                 *p_err)
+{
+    USBD_StorageRd(p_storage_lun,                               /* See Note #1.                                         */
+                   blk_addr,
+                   nbr_blks,
+                   p_data_buf,
+                   p_err);
+    if (*p_err == USBD_ERR_NONE) {
+        cmpl_fnct(p_cmpl_arg, USBD_ERR_NONE);
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_StorageWrAsync()
+*
+* Description : Start writing data to the storage medium.
+*
+* Argument(s) : p_storage_lun    Pointer to the logical unit storage structure.
+*
+*               blk_addr         Logical Block Address (LBA) of starting write block.
+*
+*               nbr_blks         Number of logical blocks to write.
+*
+*               p_data_buf       Pointer to buffer in which data is stored.
+*
+*               cmpl_fnct        Function to call when the write completes.
+*
+*               p_cmpl_arg       Argument passed to 'cmpl_fnct'.
+*
+*               p_err       Pointer to variable that will receive error code from this function.
+*
+*                               USBD_ERR_NONE                           Write successfully started.
+*                               USBD_ERR_SCSI_LU_NOTSUPPORTED           Logical unit not supported.
+*                               USBD_ERR_SCSI_LU_NOTRDY                 Logical unit cannot perform
+*                                                                           operations.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) See USBD_StorageAsyncQDepthGet() Note #1. The write is done before returning and
+*                   'cmpl_fnct' is called on success.
+*********************************************************************************************************
+*/
+
+void  USBD_StorageWrAsync (USBD_STORAGE_LUN         *p_storage_lun,
+                           CPU_INT64U                blk_addr,
+                           CPU_INT32U                nbr_blks,
+                           CPU_INT08U               *p_data_buf,
+                           USBD_STORAGE_ASYNC_CMPL   cmpl_fnct,
+                           void                     *p_cmpl_arg,
+                           USBD_ERR                 *p_err)
+{
+    USBD_StorageWr(p_storage_lun,                               /* See Note #1.                                         */
+                   blk_addr,
+                   nbr_blks,
+                   p_data_buf,
+                   p_err);
+    if (*p_err == USBD_ERR_NONE) {
+        cmpl_fnct(p_cmpl_arg, USBD_ERR_NONE);
+    }
+}
+#endif
 
 
 /*
@@ -350,9 +881,9 @@ void  USBD_StorageStatusGet (USBD_STORAGE_LUN  *p_storage_lun,
 {
     CPU_INT08U  lun;
 
-    lun = p_storage_lun->LunNbr;
+    lun = USBD_RAMDISK_UnitGet(p_storage_lun->ClassNbr, p_storage_lun->LunNbr);
 
-    if (lun > USBD_RAMDISK_CFG_NBR_UNITS) {
+    if (lun >= USBD_RAMDISK_CFG_NBR_UNITS) {
        *p_err = USBD_ERR_SCSI_LU_NOTSUPPORTED;
         return;
     }
@@ -419,3 +950,445 @@ void  USBD_StorageUnlock (USBD_STORAGE_LUN  *p_storage_lun,
 {
    *p_err = USBD_ERR_NONE;
 }
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_RAMDISK_UsageGet()
+*
+* Description : Get the storage used by the RAMDisk unit of a logical unit, against its logical capacity.
+*
+* Argument(s) : class_nbr   MSC instance number.
+*
+*               lun_nbr     Logical unit number.
+*
+*               p_usage     Pointer to variable that will receive the usage of the unit.
+*
+*               p_err       Pointer to variable that will receive error code from this function.
+*
+*                               USBD_ERR_NONE                      Usage successfully gotten.
+*                               USBD_ERR_NULL_PTR                  Argument 'p_usage' passed a NULL pointer.
+*                               USBD_ERR_SCSI_LU_NOTSUPPORTED      Logical unit not supported, or not added.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The pool blocks are shared by all the units, so 'PoolBlkCnt' and 'PoolBlkUsedCnt' are
+*                   the same for every unit. In sparse mode, the sum of 'MappedBlkCnt' for all the units
+*                   exceeds 'PoolBlkUsedCnt' by the number of blocks saved by sharing identical blocks.
+*
+*               (2) Without sparse mode, each unit reserves its whole data area, and all its blocks are
+*                   reported as mapped and in use.
+*********************************************************************************************************
+*/
+
+void  USBD_RAMDISK_UsageGet (CPU_INT08U           class_nbr,
+                             CPU_INT08U           lun_nbr,
+                             USBD_RAMDISK_USAGE  *p_usage,
+                             USBD_ERR            *p_err)
+{
+    CPU_INT08U  unit_nbr;
+#if (USBD_RAMDISK_CFG_SPARSE_EN == DEF_ENABLED)
+    CPU_SR_ALLOC();
+#endif
+
+
+#if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)
+    if (p_usage == (USBD_RAMDISK_USAGE *)0) {
+       *p_err = USBD_ERR_NULL_PTR;
+        return;
+    }
+#endif
+
+    unit_nbr = USBD_RAMDISK_UnitGet(class_nbr, lun_nbr);
+    if (unit_nbr >= USBD_RAMDISK_CFG_NBR_UNITS) {
+       *p_err = USBD_ERR_SCSI_LU_NOTSUPPORTED;
+        return;
+    }
+
+    p_usage->LogBlkCnt = USBD_RAMDISK_CFG_NBR_BLKS;
+    p_usage->BlkSize   = USBD_RAMDISK_CFG_BLK_SIZE;
+#if (USBD_RAMDISK_CFG_SPARSE_EN == DEF_ENABLED)
+    p_usage->PoolBlkCnt     = USBD_RAMDISK_CFG_POOL_NBR_BLKS;   /* See Note #1.                                         */
+    CPU_CRITICAL_ENTER();
+    p_usage->MappedBlkCnt   = USBD_RAMDISK_MappedBlkCnt[unit_nbr];
+    p_usage->PoolBlkUsedCnt = USBD_RAMDISK_PoolUsedCnt;
+    CPU_CRITICAL_EXIT();
+#else
+    p_usage->MappedBlkCnt   = USBD_RAMDISK_CFG_NBR_BLKS;        /* See Note #2.                                         */
+    p_usage->PoolBlkCnt     = USBD_RAMDISK_CFG_NBR_UNITS * USBD_RAMDISK_CFG_NBR_BLKS;
+    p_usage->PoolBlkUsedCnt = p_usage->PoolBlkCnt;
+#endif
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*********************************************************************************************************
+*                                            LOCAL FUNCTIONS
+*********************************************************************************************************
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                        USBD_RAMDISK_UnitGet()
+*
+* Description : Get the RAMDisk unit of a logical unit.
+*
+* Argument(s) : class_nbr   MSC instance number.
+*
+*               lun_nbr     Logical unit number.
+*
+* Return(s)   : RAMDisk unit number,   if a unit is assigned to the logical unit,
+*
+*               USBD_RAMDISK_UNIT_NONE, otherwise.
+*
+* Note(s)     : (1) See USBD_StorageAdd() Note #1.
+*********************************************************************************************************
+*/
+
+static  CPU_INT08U  USBD_RAMDISK_UnitGet (CPU_INT08U  class_nbr,
+                                          CPU_INT08U  lun_nbr)
+{
+    if ((class_nbr >= USBD_MSC_CFG_MAX_NBR_DEV) ||
+        (lun_nbr   >= USBD_MSC_CFG_MAX_LUN)) {
+        return (USBD_RAMDISK_UNIT_NONE);
+    }
+
+    return (USBD_RAMDISK_UnitTbl[class_nbr][lun_nbr]);
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_RAMDISK_BlkRd()
+*
+* Description : Read a logical block of a sparse RAMDisk unit.
+*
+* Argument(s) : lun         RAMDisk unit number.
+*
+*               blk_addr    Logical Block Address (LBA) of the block.
+*
+*               p_buf       Pointer to buffer that will receive the block.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The pool is shared by all the units, which may be accessed from different MSC tasks. A
+*                   reference to the pool block is taken within a critical section, so that the block cannot
+*                   be released and reused by a write to another unit while it is copied. The content of a
+*                   pool block in use never changes, so the copy is done outside the critical section.
+*********************************************************************************************************
+*/
+
+#if (USBD_RAMDISK_CFG_SPARSE_EN == DEF_ENABLED)
+static  void  USBD_RAMDISK_BlkRd (CPU_INT08U   lun,
+                                  CPU_INT64U   blk_addr,
+                                  CPU_INT08U  *p_buf)
+{
+    CPU_INT16U  blk_nbr;
+    CPU_SR_ALLOC();
+
+
+    CPU_CRITICAL_ENTER();                                       /* See Note #1.                                         */
+    blk_nbr = USBD_RAMDISK_BlkMap[lun][blk_addr];
+    if (blk_nbr != USBD_RAMDISK_BLK_NONE) {
+        USBD_RAMDISK_PoolBlkTbl[blk_nbr].RefCnt++;
+    }
+    CPU_CRITICAL_EXIT();
+
+    if (blk_nbr == USBD_RAMDISK_BLK_NONE) {
+        Mem_Clr((void *)p_buf,                                  /* Blk not mapped holds only zeros.                     */
+                        USBD_RAMDISK_CFG_BLK_SIZE);
+        return;
+    }
+
+    Mem_Copy((void *)p_buf,
+             (void *)USBD_RAMDISK_POOL_BLK_PTR(blk_nbr),
+                     USBD_RAMDISK_CFG_BLK_SIZE);
+
+    CPU_CRITICAL_ENTER();
+    USBD_RAMDISK_PoolBlkRel(blk_nbr);
+    CPU_CRITICAL_EXIT();
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_RAMDISK_BlkWr()
+*
+* Description : Write a logical block of a sparse RAMDisk unit.
+*
+* Argument(s) : lun         RAMDisk unit number.
+*
+*               blk_addr    Logical Block Address (LBA) of the block.
+*
+*               p_buf       Pointer to buffer that holds the block.
+*
+*               p_err       Pointer to variable that will receive error code from this function.
+*
+*                               USBD_ERR_NONE                   Block successfully written.
+*                               USBD_ERR_SCSI_SPACE_ALLOC       No free block left in the pool.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) A block holding only zeros is not mapped to any pool block.
+*
+*               (2) A block identical to a pool block in use is mapped to that pool block. Otherwise, it is
+*                   copied to a free pool block. A pool block previously mapped and not shared is released
+*                   first, so that the block is rewritten in place (the free list is last in, first out).
+*
+*               (3) When the pool has no free block, the block is left unchanged.
+*
+*               (4) See USBD_RAMDISK_BlkRd() Note #1. The hash, the comparison with pool blocks and the copy
+*                   are done outside critical sections. The free pool block is taken from the free list
+*                   before the copy, and is linked in its hash chain only once it holds the block.
+*********************************************************************************************************
+*/
+
+static  void  USBD_RAMDISK_BlkWr (CPU_INT08U   lun,
+                                  CPU_INT64U   blk_addr,
+                                  CPU_INT08U  *p_buf,
+                                  USBD_ERR    *p_err)
+{
+    CPU_BOOLEAN             is_zero;
+    CPU_INT32U              hash;
+    CPU_INT16U              blk_nbr_old;
+    CPU_INT16U              blk_nbr_new;
+    CPU_INT16U              bucket;
+    USBD_RAMDISK_POOL_BLK  *p_pool_blk;
+    CPU_SR_ALLOC();
+
+
+    hash        = USBD_RAMDISK_BlkHash(p_buf, &is_zero);        /* See Note #4.                                         */
+    blk_nbr_new = USBD_RAMDISK_BLK_NONE;
+    if (is_zero == DEF_NO) {
+        blk_nbr_new = USBD_RAMDISK_PoolBlkFind(p_buf, hash);    /* See Note #2.                                         */
+    }
+
+    CPU_CRITICAL_ENTER();
+    blk_nbr_old = USBD_RAMDISK_BlkMap[lun][blk_addr];
+
+    if ((is_zero     == DEF_NO) &&                              /* Copy blk to a free pool blk.                         */
+        (blk_nbr_new == USBD_RAMDISK_BLK_NONE)) {
+        if ((blk_nbr_old != USBD_RAMDISK_BLK_NONE) &&
+            (USBD_RAMDISK_PoolBlkTbl[blk_nbr_old].RefCnt == 1u)) {
+            USBD_RAMDISK_BlkMap[lun][blk_addr] = USBD_RAMDISK_BLK_NONE;
+            USBD_RAMDISK_PoolBlkRel(blk_nbr_old);               /* Release prev pool blk first (see Note #2).           */
+            USBD_RAMDISK_MappedBlkCnt[lun]--;
+            blk_nbr_old = USBD_RAMDISK_BLK_NONE;
+        }
+
+        if (USBD_RAMDISK_PoolFreeNbr == USBD_RAMDISK_BLK_NONE) {
+            CPU_CRITICAL_EXIT();
+           *p_err = USBD_ERR_SCSI_SPACE_ALLOC;                  /* See Note #3.                                         */
+            return;
+        }
+
+        blk_nbr_new              = USBD_RAMDISK_PoolFreeNbr;
+        p_pool_blk               = &USBD_RAMDISK_PoolBlkTbl[blk_nbr_new];
+        USBD_RAMDISK_PoolFreeNbr =  p_pool_blk->NextNbr;
+        USBD_RAMDISK_PoolUsedCnt++;
+        CPU_CRITICAL_EXIT();
+
+        Mem_Copy((void *)USBD_RAMDISK_POOL_BLK_PTR(blk_nbr_new),
+                 (void *)p_buf,
+                         USBD_RAMDISK_CFG_BLK_SIZE);
+
+        bucket                       = (CPU_INT16U)(hash % USBD_RAMDISK_HASH_NBR_BUCKETS);
+        CPU_CRITICAL_ENTER();
+        p_pool_blk->RefCnt           =  1u;
+        p_pool_blk->Hash             =  hash;
+        p_pool_blk->NextNbr          =  USBD_RAMDISK_HashTbl[bucket];
+        USBD_RAMDISK_HashTbl[bucket] =  blk_nbr_new;
+    }
+
+    if (blk_nbr_old != USBD_RAMDISK_BLK_NONE) {                 /* Release prev pool blk.                               */
+        USBD_RAMDISK_PoolBlkRel(blk_nbr_old);
+        USBD_RAMDISK_MappedBlkCnt[lun]--;
+    }
+
+    if (blk_nbr_new != USBD_RAMDISK_BLK_NONE) {
+        USBD_RAMDISK_MappedBlkCnt[lun]++;
+    }
+    USBD_RAMDISK_BlkMap[lun][blk_addr] = blk_nbr_new;           /* See Note #1.                                         */
+    CPU_CRITICAL_EXIT();
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_RAMDISK_BlkRel()
+*
+* Description : Release a logical block of a sparse RAMDisk unit, so that it reads back as zeros.
+*
+* Argument(s) : lun         RAMDisk unit number.
+*
+*               blk_addr    Logical Block Address (LBA) of the block.
+*
+* Return(s)   : None.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+static  void  USBD_RAMDISK_BlkRel (CPU_INT08U  lun,
+                                   CPU_INT64U  blk_addr)
+{
+    CPU_INT16U  blk_nbr;
+    CPU_SR_ALLOC();
+
+
+    CPU_CRITICAL_ENTER();
+    blk_nbr = USBD_RAMDISK_BlkMap[lun][blk_addr];
+    if (blk_nbr != USBD_RAMDISK_BLK_NONE) {
+        USBD_RAMDISK_PoolBlkRel(blk_nbr);
+        USBD_RAMDISK_MappedBlkCnt[lun]--;
+        USBD_RAMDISK_BlkMap[lun][blk_addr] = USBD_RAMDISK_BLK_NONE;
+    }
+    CPU_CRITICAL_EXIT();
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_RAMDISK_BlkHash()
+*
+* Description : Compute the content hash of a block.
+*
+* Argument(s) : p_buf       Pointer to buffer that holds the block.
+*
+*               p_is_zero   Pointer to variable that will receive whether the block holds only zeros.
+*
+* Return(s)   : 32-bit FNV-1a hash of the block.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+static  CPU_INT32U  USBD_RAMDISK_BlkHash (CPU_INT08U   *p_buf,
+                                          CPU_BOOLEAN  *p_is_zero)
+{
+    CPU_INT32U  hash;
+    CPU_INT32U  ix;
+    CPU_INT08U  bits;
+
+
+    hash = USBD_RAMDISK_HASH_FNV_OFFSET;
+    bits = 0u;
+    for (ix = 0u; ix < USBD_RAMDISK_CFG_BLK_SIZE; ix++) {
+        bits |= p_buf[ix];
+        hash ^= p_buf[ix];
+        hash *= USBD_RAMDISK_HASH_FNV_PRIME;
+    }
+
+   *p_is_zero = (bits == 0u) ? DEF_YES : DEF_NO;
+
+    return (hash);
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_RAMDISK_PoolBlkFind()
+*
+* Description : Find a pool block in use with the same content as a block.
+*
+* Argument(s) : p_buf       Pointer to buffer that holds the block.
+*
+*               hash        Hash of the block.
+*
+* Return(s)   : Number of the pool block, if found,
+*
+*               USBD_RAMDISK_BLK_NONE,    otherwise.
+*
+* Note(s)     : (1) Must be called outside a critical section. A reference to the pool block found is taken
+*                   on behalf of the caller.
+*
+*               (2) Blocks with the same hash are compared, since different contents may share a hash. A
+*                   reference to each block compared is held during the comparison, which is done outside
+*                   the critical section (see USBD_RAMDISK_BlkRd() Note #1). The block stays linked in its
+*                   hash chain, so the chain walk resumes from it.
+*********************************************************************************************************
+*/
+
+static  CPU_INT16U  USBD_RAMDISK_PoolBlkFind (CPU_INT08U  *p_buf,
+                                              CPU_INT32U   hash)
+{
+    CPU_INT16U   blk_nbr;
+    CPU_INT16U   blk_nbr_next;
+    CPU_BOOLEAN  same;
+    CPU_SR_ALLOC();
+
+
+    CPU_CRITICAL_ENTER();
+    blk_nbr = USBD_RAMDISK_HashTbl[hash % USBD_RAMDISK_HASH_NBR_BUCKETS];
+    while (blk_nbr != USBD_RAMDISK_BLK_NONE) {
+        if (USBD_RAMDISK_PoolBlkTbl[blk_nbr].Hash == hash) {
+            USBD_RAMDISK_PoolBlkTbl[blk_nbr].RefCnt++;
+            CPU_CRITICAL_EXIT();
+                                                                /* See Note #2.                                         */
+            same = Mem_Cmp((void *)USBD_RAMDISK_POOL_BLK_PTR(blk_nbr),
+                           (void *)p_buf,
+                                   USBD_RAMDISK_CFG_BLK_SIZE);
+            if (same == DEF_YES) {
+                return (blk_nbr);                               /* Keep ref for the caller (see Note #1).               */
+            }
+
+            CPU_CRITICAL_ENTER();
+            blk_nbr_next = USBD_RAMDISK_PoolBlkTbl[blk_nbr].NextNbr;
+            USBD_RAMDISK_PoolBlkRel(blk_nbr);
+            blk_nbr      = blk_nbr_next;
+        } else {
+            blk_nbr = USBD_RAMDISK_PoolBlkTbl[blk_nbr].NextNbr;
+        }
+    }
+    CPU_CRITICAL_EXIT();
+
+    return (USBD_RAMDISK_BLK_NONE);
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_RAMDISK_PoolBlkRel()
+*
+* Description : Release a reference to a pool block.
+*
+* Argument(s) : blk_nbr     Number of the pool block.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Must be called within a critical section.
+*
+*               (2) Once no logical block is mapped to the pool block, it is unlinked from its hash chain
+*                   and put first in the free list.
+*********************************************************************************************************
+*/
+
+static  void  USBD_RAMDISK_PoolBlkRel (CPU_INT16U  blk_nbr)
+{
+    USBD_RAMDISK_POOL_BLK  *p_pool_blk;
+    CPU_INT16U             *p_link;
+
+
+    p_pool_blk = &USBD_RAMDISK_PoolBlkTbl[blk_nbr];
+    p_pool_blk->RefCnt--;
+    if (p_pool_blk->RefCnt > 0u) {
+        return;
+    }
+                                                                /* See Note #2.                                         */
+    p_link = &USBD_RAMDISK_HashTbl[p_pool_blk->Hash % USBD_RAMDISK_HASH_NBR_BUCKETS];
+    while (*p_link != blk_nbr) {
+        p_link = &USBD_RAMDISK_PoolBlkTbl[*p_link].NextNbr;
+    }
+   *p_link = p_pool_blk->NextNbr;
+
+    p_pool_blk->NextNbr      = USBD_RAMDISK_PoolFreeNbr;
+    USBD_RAMDISK_PoolFreeNbr = blk_nbr;
+    USBD_RAMDISK_PoolUsedCnt--;
+}
+#endif
@@ -66,6 +66,21 @@
 *********************************************************************************************************
 */
 
+/*
+*********************************************************************************************************
+*                                         RAMDISK USAGE DATA TYPE
+*********************************************************************************************************
+*/
+
+typedef  struct  usbd_ramdisk_usage {
+    CPU_INT64U  LogBlkCnt;                                      /* Nbr of logical blks of the unit.                     */
+    CPU_INT64U  MappedBlkCnt;                                   /* Nbr of logical blks of the unit holding data.        */
+    CPU_INT32U  PoolBlkCnt;                                     /* Nbr of blks of the data area, for all units.         */
+    CPU_INT32U  PoolBlkUsedCnt;                                 /* Nbr of blks of the data area in use, for all units.  */
+    CPU_INT32U  BlkSize;                                        /* Blk size, in octets.                                 */
+} USBD_RAMDISK_USAGE;
+
+
 
 /*
 *********************************************************************************************************
@@ -109,6 +124,47 @@ void  USBD_StorageWr         (USBD_STORAGE_LUN  *p_storage_lun,
                               CPU_INT08U        *p_data_buf,
                               USBD_ERR          *p_err);
 
+#if (USBD_MSC_CFG_ZERO_COPY_EN == DEF_ENABLED)
+void  USBD_StorageRdPtrGet   (USBD_STORAGE_LUN  *p_storage_lun,
+                              CPU_INT64U         blk_addr,
+                              CPU_INT32U         nbr_blks,
+                              CPU_INT08U       **pp_data_buf,
+                              USBD_ERR          *p_err);
+
+void  USBD_StorageWrPtrGet   (USBD_STORAGE_LUN  *p_storage_lun,
+                              CPU_INT64U         blk_addr,
+                              CPU_INT32U         nbr_blks,
+                              CPU_INT08U       **pp_data_buf,
+                              USBD_ERR          *p_err);
+#endif
+
+#if (USBD_MSC_CFG_UNMAP_EN == DEF_ENABLED)
+void  USBD_StorageUnmap      (USBD_STORAGE_LUN  *p_storage_lun,
+                              CPU_INT64U         blk_addr,
+                              CPU_INT32U         nbr_blks,
+                              USBD_ERR          *p_err);
+#endif
+
+#if (USBD_MSC_CFG_STORAGE_ASYNC_EN == DEF_ENABLED)
+CPU_INT08U  USBD_StorageAsyncQDepthGet(USBD_STORAGE_LUN         *p_storage_lun);
+
+void  USBD_StorageRdAsync    (USBD_STORAGE_LUN         *p_storage_lun,
+                              CPU_INT64U                blk_addr,
+                              CPU_INT32U                nbr_blks,
+                              CPU_INT08U               *p_data_buf,
+                              USBD_STORAGE_ASYNC_CMPL   cmpl_fnct,
+                              void                     *p_cmpl_arg,
+                              USBD_ERR                 *p_err);
+
+void  USBD_StorageWrAsync    (USBD_STORAGE_LUN         *p_storage_lun,
+                              CPU_INT64U                blk_addr,
+                              CPU_INT32U                nbr_blks,
+                              CPU_INT08U               *p_data_buf,
+                              USBD_STORAGE_ASYNC_CMPL   cmpl_fnct,
+                              void                     *p_cmpl_arg,
+                              USBD_ERR                 *p_err);
+#endif
+
 void  USBD_StorageStatusGet  (USBD_STORAGE_LUN  *p_storage_lun,
                               USBD_ERR          *p_err);
 
@@ -119,6 +175,11 @@ void  USBD_StorageLock       (USBD_STORAGE_LUN  *p_storage_lun,
 void  USBD_StorageUnlock     (USBD_STORAGE_LUN  *p_storage_lun,
                               USBD_ERR          *p_err);
 
+void  USBD_RAMDISK_UsageGet  (CPU_INT08U          class_nbr,
+                              CPU_INT08U          lun_nbr,
+                              USBD_RAMDISK_USAGE *p_usage,
+                              USBD_ERR           *p_err);
+
 
 /*
 *********************************************************************************************************
@@ -139,9 +200,10 @@ void  USBD_StorageUnlock     (USBD_STORAGE_LUN  *p_storage_lun,
 #endif
 
 #ifndef  USBD_RAMDISK_CFG_NBR_UNITS
-#error  "USBD_RAMDISK_CFG_NBR_UNITS not #defined'd in 'usbd_cfg.h' [MUST be > 0]"
-#elif   (USBD_RAMDISK_CFG_NBR_UNITS < 1u)
-#error  "USBD_RAMDISK_CFG_NBR_UNITS illegally #define'd in 'usbd_cfg.h' [MUST be > 0]"
+#error  "USBD_RAMDISK_CFG_NBR_UNITS not #defined'd in 'usbd_cfg.h' [MUST be >= 1 && <= 254]"
+#elif  ((USBD_RAMDISK_CFG_NBR_UNITS < 1u) || \
+        (USBD_RAMDISK_CFG_NBR_UNITS > 254u))
+#error  "USBD_RAMDISK_CFG_NBR_UNITS illegally #define'd in 'usbd_cfg.h' [MUST be >= 1 && <= 254]"
 #endif
 
 #ifndef  USBD_RAMDISK_CFG_BASE_ADDR
@@ -150,6 +212,21 @@ void  USBD_StorageUnlock     (USBD_STORAGE_LUN  *p_storage_lun,
 #error  "USBD_RAMDISK_CFG_BASE_ADDR illegally #define'd in 'usbd_cfg.h' [MUST be >= 0]"
 #endif
 
+#ifndef  USBD_RAMDISK_CFG_SPARSE_EN
+#error  "USBD_RAMDISK_CFG_SPARSE_EN not #defined'd in 'usbd_cfg.h' [MUST be DEF_ENABLED or DEF_DISABLED]"
+#elif  ((USBD_RAMDISK_CFG_SPARSE_EN != DEF_ENABLED) && \
+        (USBD_RAMDISK_CFG_SPARSE_EN != DEF_DISABLED))
+#error  "USBD_RAMDISK_CFG_SPARSE_EN illegally #define'd in 'usbd_cfg.h' [MUST be DEF_ENABLED or DEF_DISABLED]"
+#elif   (USBD_RAMDISK_CFG_SPARSE_EN == DEF_ENABLED)
+
+#ifndef  USBD_RAMDISK_CFG_POOL_NBR_BLKS
+#error  "USBD_RAMDISK_CFG_POOL_NBR_BLKS not #defined'd in 'usbd_cfg.h' [MUST be >= 1 && <= 65535]"
+#elif  ((USBD_RAMDISK_CFG_POOL_NBR_BLKS < 1u) || \
+        (USBD_RAMDISK_CFG_POOL_NBR_BLKS > DEF_INT_16U_MAX_VAL))
+#error  "USBD_RAMDISK_CFG_POOL_NBR_BLKS illegally #define'd in 'usbd_cfg.h' [MUST be >= 1 && <= 65535]"
+#endif
+#endif
+
 
 /*
 *********************************************************************************************************
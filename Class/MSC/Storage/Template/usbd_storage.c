@@ -229,6 +229,250 @@ void  USBD_StorageWr (USBD_STORAGE_LUN  *p_storage_lun,
 }
 
 
+/*
+*********************************************************************************************************
+*                                         USBD_StorageRdPtrGet()
+*
+* Description : Get a pointer to the storage medium's data for a read operation.
+*
+* Argument(s) : p_storage_lun    Pointer to the logical unit storage structure.
+*
+*               blk_addr         Logical Block Address (LBA) of starting read block.
+*
+*               nbr_blks         Number of logical blocks to read.
+*
+*               pp_data_buf      Pointer to variable that will receive the pointer to the data.
+*
+*               p_err       Pointer to variable that will receive error code from this function.
+*
+*                               USBD_ERR_NONE                           Data pointer successfully returned.
+*                               USBD_ERR_SCSI_NO_DIRECT_BUF             Medium cannot be accessed directly.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Only memory-mapped media can provide a direct pointer. Otherwise, return
+*                   USBD_ERR_SCSI_NO_DIRECT_BUF and the data will be read with USBD_StorageRd().
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_ZERO_COPY_EN == DEF_ENABLED)
+void  USBD_StorageRdPtrGet (USBD_STORAGE_LUN    *p_storage_lun,
+                            CPU_INT64U           blk_addr,
+                            CPU_INT32U           nbr_blks,
+                            CPU_INT08U         **pp_data_buf,
+                            USBD_ERR            *p_err)
+{
+    /* $$$$ Insert code to get a pointer to the data of a memory-mapped storage medium. */
+
+   *p_err = USBD_ERR_SCSI_NO_DIRECT_BUF;
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_StorageWrPtrGet()
+*
+* Description : Get a pointer to the storage medium's data for a write operation.
+*
+* Argument(s) : p_storage_lun    Pointer to the logical unit storage structure.
+*
+*               blk_addr         Logical Block Address (LBA) of starting write block.
+*
+*               nbr_blks         Number of logical blocks to write.
+*
+*               pp_data_buf      Pointer to variable that will receive the pointer to the data.
+*
+*               p_err       Pointer to variable that will receive error code from this function.
+*
+*                               USBD_ERR_NONE                           Data pointer successfully returned.
+*                               USBD_ERR_SCSI_NO_DIRECT_BUF             Medium cannot be accessed directly.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Only memory-mapped media can provide a direct pointer. Otherwise, return
+*                   USBD_ERR_SCSI_NO_DIRECT_BUF and the data will be written with USBD_StorageWr().
+*
+*               (2) Once the data is received in the returned buffer, USBD_StorageWr() is called with
+*                   that same buffer to complete the write.
+*********************************************************************************************************
+*/
+
+void  USBD_StorageWrPtrGet (USBD_STORAGE_LUN    *p_storage_lun,
+                            CPU_INT64U           blk_addr,
+                            CPU_INT32U           nbr_blks,
+                            CPU_INT08U         **pp_data_buf,
+                            USBD_ERR            *p_err)
+{
+    /* $$$$ Insert code to get a pointer to the data of a memory-mapped storage medium. */
+
+   *p_err = USBD_ERR_SCSI_NO_DIRECT_BUF;
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_StorageUnmap()
+*
+* Description : Release blocks of the storage medium that the host no longer uses.
+*
+* Argument(s) : p_storage_lun    Pointer to the logical unit storage structure.
+*
+*               blk_addr         Logical Block Address (LBA) of starting block to release.
+*
+*               nbr_blks         Number of logical blocks to release.
+*
+*               p_err       Pointer to variable that will receive error code from this function.
+*
+*                               USBD_ERR_NONE                           Blocks successfully released.
+*                               USBD_ERR_SCSI_LOG_UNIT_NOTSUPPORTED     Logical unit not supported.
+*                               USBD_ERR_SCSI_LOG_UNIT_NOTRDY           Logical unit cannot perform
+*                                                                           operations.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Releasing blocks is a hint. A storage medium that cannot reclaim released blocks may
+*                   ignore it and return USBD_ERR_NONE. The data of released blocks does not have to be
+*                   kept.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_UNMAP_EN == DEF_ENABLED)
+void  USBD_StorageUnmap (USBD_STORAGE_LUN  *p_storage_lun,
+                         CPU_INT64U         blk_addr,
+                         CPU_INT32U         nbr_blks,
+                         USBD_ERR          *p_err)
+{
+    /* $$$$ Insert code to release blocks of the storage medium (see Note #1). */
+
+   *p_err = USBD_ERR_NONE;
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_StorageAsyncQDepthGet()
+*
+* Description : Get the number of asynchronous accesses the storage medium can have in progress.
+*
+* Argument(s) : p_storage_lun    Pointer to the logical unit storage structure.
+*
+* Return(s)   : Maximum number of accesses started with USBD_StorageRdAsync() or USBD_StorageWrAsync()
+*               that may be in progress at the same time, or 0 if asynchronous accesses are not supported.
+*
+* Note(s)     : (1) Return the depth of the medium's request queue, usually 1 for a DMA controller that
+*                   handles a single transfer at a time. Returning 0 makes the MSC class use
+*                   USBD_StorageRd() and USBD_StorageWr().
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_STORAGE_ASYNC_EN == DEF_ENABLED)
+CPU_INT08U  USBD_StorageAsyncQDepthGet (USBD_STORAGE_LUN  *p_storage_lun)
+{
+    /* $$$$ Insert code to return the depth of the storage medium's request queue (see Note #1). */
+
+    return (0u);
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_StorageRdAsync()
+*
+* Description : Start reading data from the storage medium.
+*
+* Argument(s) : p_storage_lun    Pointer to the logical unit storage structure.
+*
+*               blk_addr         Logical Block Address (LBA) of starting read block.
+*
+*               nbr_blks         Number of logical blocks to read.
+*
+*               p_data_buf       Pointer to buffer in which data will be stored.
+*
+*               cmpl_fnct        Function to call when the read completes.
+*
+*               p_cmpl_arg       Argument passed to 'cmpl_fnct'.
+*
+*               p_err       Pointer to variable that will receive error code from this function.
+*
+*                               USBD_ERR_NONE                           Read successfully started.
+*                               USBD_ERR_SCSI_LU_NOTSUPPORTED           Logical unit not supported.
+*                               USBD_ERR_SCSI_LU_NOTRDY                 Logical unit cannot perform
+*                                                                           operations.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The read must be started and the function must return without waiting for its end.
+*                   'cmpl_fnct' is then called with 'p_cmpl_arg' and the result of the read, either from
+*                   an ISR or a task, or before this function returns if the read ends immediately.
+*
+*               (2) The accesses of a logical unit must complete in the order they were started.
+*
+*               (3) If an error is returned, the read is not started and 'cmpl_fnct' is NOT called.
+*********************************************************************************************************
+*/
+
+void  USBD_StorageRdAsync (USBD_STORAGE_LUN         *p_storage_lun,
+                           CPU_INT64U                blk_addr,
+                           CPU_INT32U                nbr_blks,
+                           CPU_INT08U               *p_data_buf,
+                           USBD_STORAGE_ASYNC_CMPL   cmpl_fnct,
+                           void                     *p_cmpl_arg,
+                           USBD_ERR                 *p_err)
+{
+    /* $$$$ Insert code to start reading data from the storage medium (see Note #1). */
+
+   *p_err = USBD_ERR_SCSI_LU_NOTSUPPORTED;
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_StorageWrAsync()
+*
+* Description : Start writing data to the storage medium.
+*
+* Argument(s) : p_storage_lun    Pointer to the logical unit storage structure.
+*
+*               blk_addr         Logical Block Address (LBA) of starting write block.
+*
+*               nbr_blks         Number of logical blocks to write.
+*
+*               p_data_buf       Pointer to buffer in which data is stored.
+*
+*               cmpl_fnct        Function to call when the write completes.
+*
+*               p_cmpl_arg       Argument passed to 'cmpl_fnct'.
+*
+*               p_err       Pointer to variable that will receive error code from this function.
+*
+*                               USBD_ERR_NONE                           Write successfully started.
+*                               USBD_ERR_SCSI_LU_NOTSUPPORTED           Logical unit not supported.
+*                               USBD_ERR_SCSI_LU_NOTRDY                 Logical unit cannot perform
+*                                                                           operations.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) See USBD_StorageRdAsync() Notes #1, #2 & #3.
+*********************************************************************************************************
+*/
+
+void  USBD_StorageWrAsync (USBD_STORAGE_LUN         *p_storage_lun,
+                           CPU_INT64U                blk_addr,
+                           CPU_INT32U                nbr_blks,
+                           CPU_INT08U               *p_data_buf,
+                           USBD_STORAGE_ASYNC_CMPL   cmpl_fnct,
+                           void                     *p_cmpl_arg,
+                           USBD_ERR                 *p_err)
+{
+    /* $$$$ Insert code to start writing data to the storage medium (see Note #1). */
+
+   *p_err = USBD_ERR_SCSI_LU_NOTSUPPORTED;
+}
+#endif
+
+
 /*
 *********************************************************************************************************
 *                                       USBD_StorageStatusGet()
@@ -119,6 +119,47 @@ void  USBD_StorageWr         (USBD_STORAGE_LUN  *p_storage_lun,
                               CPU_INT08U        *p_data_buf,
                               USBD_ERR          *p_err);
 
+#if (USBD_MSC_CFG_ZERO_COPY_EN == DEF_ENABLED)
+void  USBD_StorageRdPtrGet   (USBD_STORAGE_LUN  *p_storage_lun,
+                              CPU_INT64U         blk_addr,
+                              CPU_INT32U         nbr_blks,
+                              CPU_INT08U       **pp_data_buf,
+                              USBD_ERR          *p_err);
+
+void  USBD_StorageWrPtrGet   (USBD_STORAGE_LUN  *p_storage_lun,
+                              CPU_INT64U         blk_addr,
+                              CPU_INT32U         nbr_blks,
+                              CPU_INT08U       **pp_data_buf,
+                              USBD_ERR          *p_err);
+#endif
+
+#if (USBD_MSC_CFG_UNMAP_EN == DEF_ENABLED)
+void  USBD_StorageUnmap      (USBD_STORAGE_LUN  *p_storage_lun,
+                              CPU_INT64U         blk_addr,
+                              CPU_INT32U         nbr_blks,
+                              USBD_ERR          *p_err);
+#endif
+
+#if (USBD_MSC_CFG_STORAGE_ASYNC_EN == DEF_ENABLED)
+CPU_INT08U  USBD_StorageAsyncQDepthGet(USBD_STORAGE_LUN         *p_storage_lun);
+
+void  USBD_StorageRdAsync    (USBD_STORAGE_LUN         *p_storage_lun,
+                              CPU_INT64U                blk_addr,
+                              CPU_INT32U                nbr_blks,
+                              CPU_INT08U               *p_data_buf,
+                              USBD_STORAGE_ASYNC_CMPL   cmpl_fnct,
+                              void                     *p_cmpl_arg,
+                              USBD_ERR                 *p_err);
+
+void  USBD_StorageWrAsync    (USBD_STORAGE_LUN         *p_storage_lun,
+                              CPU_INT64U                blk_addr,
+                              CPU_INT32U                nbr_blks,
+                              CPU_INT08U               *p_data_buf,
+                              USBD_STORAGE_ASYNC_CMPL   cmpl_fnct,
+                              void                     *p_cmpl_arg,
+                              USBD_ERR                 *p_err);
+#endif
+
 void  USBD_StorageStatusGet  (USBD_STORAGE_LUN  *p_storage_lun,
                               USBD_ERR          *p_err);
 
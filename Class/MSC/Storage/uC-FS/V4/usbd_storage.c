@@ -74,11 +74,11 @@
 */
 
 #if (USBD_MSC_CFG_FS_REFRESH_TASK_EN == DEF_ENABLED)
-                                                                /* Tbl of dev to be polled.                             */
-static  USBD_STORAGE_LUN  *USBD_FS_StorageDevPollList[USBD_MSC_CFG_MAX_LUN];
+                                                                /* Tbl of dev to be polled, per class & LUN.            */
+static  USBD_STORAGE_LUN  *USBD_FS_StorageDevPollList[USBD_MSC_CFG_MAX_NBR_DEV][USBD_MSC_CFG_MAX_LUN];
 #endif
-                                                                /* Cached luns state.                                   */
-static  CPU_BOOLEAN        USBD_FS_LunStatePresent[USBD_MSC_CFG_MAX_LUN];
+                                                                /* Cached luns state, per class & LUN.                  */
+static  CPU_BOOLEAN        USBD_FS_LunStatePresent[USBD_MSC_CFG_MAX_NBR_DEV][USBD_MSC_CFG_MAX_LUN];
 
 
 /*
@@ -125,14 +125,17 @@ static  CPU_BOOLEAN        USBD_FS_LunStatePresent[USBD_MSC_CFG_MAX_LUN];
 
 void  USBD_StorageInit (USBD_ERR  *p_err)
 {
+    CPU_INT08U  class_nbr;
     CPU_INT08U  ix;
 
 
-    for (ix = 0; ix < USBD_MSC_CFG_MAX_LUN; ix++) {
+    for (class_nbr = 0u; class_nbr < USBD_MSC_CFG_MAX_NBR_DEV; class_nbr++) {
+        for (ix = 0; ix < USBD_MSC_CFG_MAX_LUN; ix++) {
 #if (USBD_MSC_CFG_FS_REFRESH_TASK_EN == DEF_ENABLED)
-        USBD_FS_StorageDevPollList[ix] = (USBD_STORAGE_LUN *)0u;
+            USBD_FS_StorageDevPollList[class_nbr][ix] = (USBD_STORAGE_LUN *)0u;
 #endif
-        USBD_FS_LunStatePresent[ix]    =  DEF_FALSE;
+            USBD_FS_LunStatePresent[class_nbr][ix]    =  DEF_FALSE;
+        }
     }
 
    *p_err = USBD_ERR_NONE;
@@ -177,10 +180,10 @@ void  USBD_StorageAdd (USBD_STORAGE_LUN  *p_storage_lun,
                  &err_fs);
     if (err_fs == FS_ERR_NONE){                                 /* Initialize media present status.                     */
         p_storage_lun->MediumPresent                   = DEF_TRUE;
-        USBD_FS_LunStatePresent[p_storage_lun->LunNbr] = DEF_TRUE;
+        USBD_FS_LunStatePresent[p_storage_lun->ClassNbr][p_storage_lun->LunNbr] = DEF_TRUE;
     } else {
         p_storage_lun->MediumPresent                   = DEF_FALSE;
-        USBD_FS_LunStatePresent[p_storage_lun->LunNbr] = DEF_FALSE;
+        USBD_FS_LunStatePresent[p_storage_lun->ClassNbr][p_storage_lun->LunNbr] = DEF_FALSE;
     }
 
 #if (USBD_MSC_CFG_FS_REFRESH_TASK_EN == DEF_ENABLED)
@@ -200,7 +203,7 @@ void  USBD_StorageAdd (USBD_STORAGE_LUN  *p_storage_lun,
     }
 
     if(dev_info.Fixed == DEF_NO) {                              /* Removable media.                                     */
-        USBD_FS_StorageDevPollList[p_storage_lun->LunNbr] = p_storage_lun;
+        USBD_FS_StorageDevPollList[p_storage_lun->ClassNbr][p_storage_lun->LunNbr] = p_storage_lun;
     }
 #endif
    *p_err = USBD_ERR_NONE;
@@ -249,7 +252,7 @@ void  USBD_StorageCapacityGet (USBD_STORAGE_LUN  *p_storage_lun,
        *p_err = USBD_ERR_SCSI_MEDIUM_NOTPRESENT;
                                                                 /* See Note #1.                                         */
         CPU_CRITICAL_ENTER();
-        USBD_FS_LunStatePresent[p_storage_lun->LunNbr] = DEF_FALSE;
+        USBD_FS_LunStatePresent[p_storage_lun->ClassNbr][p_storage_lun->LunNbr] = DEF_FALSE;
         CPU_CRITICAL_EXIT();
         return;
     }
@@ -307,7 +310,7 @@ void  USBD_StorageRd (USBD_STORAGE_LUN  *p_storage_lun,
        *p_err = USBD_ERR_SCSI_MEDIUM_NOTPRESENT;
                                                                 /* See Note #1.                                         */
         CPU_CRITICAL_ENTER();
-        USBD_FS_LunStatePresent[p_storage_lun->LunNbr] = DEF_FALSE;
+        USBD_FS_LunStatePresent[p_storage_lun->ClassNbr][p_storage_lun->LunNbr] = DEF_FALSE;
         CPU_CRITICAL_EXIT();
     } else {
        *p_err = USBD_ERR_NONE;
@@ -361,7 +364,7 @@ void  USBD_StorageWr (USBD_STORAGE_LUN  *p_storage_lun,
        *p_err = USBD_ERR_SCSI_MEDIUM_NOTPRESENT;
                                                                 /* See Note #1.                                         */
         CPU_CRITICAL_ENTER();
-        USBD_FS_LunStatePresent[p_storage_lun->LunNbr] = DEF_FALSE;
+        USBD_FS_LunStatePresent[p_storage_lun->ClassNbr][p_storage_lun->LunNbr] = DEF_FALSE;
         CPU_CRITICAL_EXIT();
     } else {
        *p_err = USBD_ERR_NONE;
@@ -369,6 +372,286 @@ void  USBD_StorageWr (USBD_STORAGE_LUN  *p_storage_lun,
 }
 
 
+/*
+*********************************************************************************************************
+*                                         USBD_StorageRdPtrGet()
+*
+* Description : Get a pointer to the storage medium's data for a read operation.
+*
+* Argument(s) : p_storage_lun    Pointer to the logical unit storage structure.
+*
+*               blk_addr         Logical Block Address (LBA) of starting read block.
+*
+*               nbr_blks         Number of logical blocks to read.
+*
+*               pp_data_buf      Pointer to variable that will receive the pointer to the data.
+*
+*               p_err       Pointer to variable that will receive error code from this function.
+*
+*                               USBD_ERR_NONE                           Data pointer successfully returned.
+*                               USBD_ERR_SCSI_NO_DIRECT_BUF             Medium cannot be accessed directly.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) uC/FS devices are only accessed through FSDev_Rd(). The data is always read
+*                   with USBD_StorageRd().
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_ZERO_COPY_EN == DEF_ENABLED)
+void  USBD_StorageRdPtrGet (USBD_STORAGE_LUN    *p_storage_lun,
+                            CPU_INT64U           blk_addr,
+                            CPU_INT32U           nbr_blks,
+                            CPU_INT08U         **pp_data_buf,
+                            USBD_ERR            *p_err)
+{
+    (void)p_storage_lun;
+    (void)blk_addr;
+    (void)nbr_blks;
+    (void)pp_data_buf;
+
+   *p_err = USBD_ERR_SCSI_NO_DIRECT_BUF;                        /* See Note #1.                                         */
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_StorageWrPtrGet()
+*
+* Description : Get a pointer to the storage medium's data for a write operation.
+*
+* Argument(s) : p_storage_lun    Pointer to the logical unit storage structure.
+*
+*               blk_addr         Logical Block Address (LBA) of starting write block.
+*
+*               nbr_blks         Number of logical blocks to write.
+*
+*               pp_data_buf      Pointer to variable that will receive the pointer to the data.
+*
+*               p_err       Pointer to variable that will receive error code from this function.
+*
+*                               USBD_ERR_NONE                           Data pointer successfully returned.
+*                               USBD_ERR_SCSI_NO_DIRECT_BUF             Medium cannot be accessed directly.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) uC/FS devices are only accessed through FSDev_Wr(). The data is always written
+*                   with USBD_StorageWr().
+*********************************************************************************************************
+*/
+
+void  USBD_StorageWrPtrGet (USBD_STORAGE_LUN    *p_storage_lun,
+                            CPU_INT64U           blk_addr,
+                            CPU_INT32U           nbr_blks,
+                            CPU_INT08U         **pp_data_buf,
+                            USBD_ERR            *p_err)
+{
+    (void)p_storage_lun;
+    (void)blk_addr;
+    (void)nbr_blks;
+    (void)pp_data_buf;
+
+   *p_err = USBD_ERR_SCSI_NO_DIRECT_BUF;                        /* See Note #1.                                         */
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           USBD_StorageUnmap()
+*
+* Description : Release blocks of the storage medium that the host no longer uses.
+*
+* Argument(s) : p_storage_lun    Pointer to the logical unit storage structure.
+*
+*               blk_addr         Logical Block Address (LBA) of starting block to release.
+*
+*               nbr_blks         Number of logical blocks to release.
+*
+*               p_err       Pointer to variable that will receive error code from this function.
+*
+*                               USBD_ERR_NONE                       Blocks successfully released.
+*                               USBD_ERR_SCSI_MEDIUM_NOTPRESENT     Medium not present.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Each sector is released with the FS_DEV_IO_CTRL_SEC_RELEASE I/O control, which lets
+*                   the flash translation layer of NAND & NOR devices reclaim it. Devices that do not
+*                   support this I/O control keep their sectors, which is not an error.
+*
+*               (2) On error set cached state to not present to prevent positive media presence
+*                   returned by USBD_StorageStatusGet() when the host sends a TEST_UNIT_READY SCSI
+*                   command.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_UNMAP_EN == DEF_ENABLED)
+void  USBD_StorageUnmap (USBD_STORAGE_LUN  *p_storage_lun,
+                         CPU_INT64U         blk_addr,
+                         CPU_INT32U         nbr_blks,
+                         USBD_ERR          *p_err)
+{
+    FS_SEC_NBR  sec_nbr;
+    FS_SEC_NBR  sec_end;
+    FS_ERR      err_fs;
+    CPU_SR_ALLOC();
+
+
+    sec_nbr = (FS_SEC_NBR)blk_addr;
+    sec_end = (FS_SEC_NBR)blk_addr + nbr_blks;
+    err_fs  =  FS_ERR_NONE;
+    while (sec_nbr < sec_end) {                                 /* See Note #1.                                         */
+        FSDev_IO_Ctrl(        p_storage_lun->VolStrPtr,
+                              FS_DEV_IO_CTRL_SEC_RELEASE,
+                      (void *)&sec_nbr,
+                             &err_fs);
+        if (err_fs == FS_ERR_DEV_INVALID_IO_CTRL) {             /* Sec release not supported by dev.                    */
+            err_fs = FS_ERR_NONE;
+            break;
+        }
+        if (err_fs != FS_ERR_NONE) {
+            break;
+        }
+        sec_nbr++;
+    }
+
+    if (err_fs != FS_ERR_NONE) {
+       *p_err = USBD_ERR_SCSI_MEDIUM_NOTPRESENT;
+                                                                /* See Note #2.                                         */
+        CPU_CRITICAL_ENTER();
+        USBD_FS_LunStatePresent[p_storage_lun->ClassNbr][p_storage_lun->LunNbr] = DEF_FALSE;
+        CPU_CRITICAL_EXIT();
+    } else {
+       *p_err = USBD_ERR_NONE;
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_StorageAsyncQDepthGet()
+*
+* Description : Get the number of asynchronous accesses the storage medium can have in progress.
+*
+* Argument(s) : p_storage_lun    Pointer to the logical unit storage structure.
+*
+* Return(s)   : Maximum number of accesses started with USBD_StorageRdAsync() or USBD_StorageWrAsync()
+*               that may be in progress at the same time, or 0 if asynchronous accesses are not supported.
+*
+* Note(s)     : (1) uC/FS device accesses block the calling task until they end, so there is no transfer to
+*                   overlap with the USB transfers. USBD_StorageRd() and USBD_StorageWr() are used.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_STORAGE_ASYNC_EN == DEF_ENABLED)
+CPU_INT08U  USBD_StorageAsyncQDepthGet (USBD_STORAGE_LUN  *p_storage_lun)
+{
+    (void)p_storage_lun;
+
+    return (0u);                                                /* See Note #1.                                         */
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_StorageRdAsync()
+*
+* Description : Start reading data from the storage medium.
+*
+* Argument(s) : p_storage_lun    Pointer to the logical unit storage structure.
+*
+*               blk_addr         Logical Block Address (LBA) of starting read block.
+*
+*               nbr_blks         Number of logical blocks to read.
+*
+*               p_data_buf       Pointer to buffer in which data will be stored.
+*
+*               cmpl_fnct        Function to call when the read completes.
+*
+*               p_cmpl_arg       Argument passed to 'cmpl_fnct'.
+*
+*               p_err       Pointer to variable that will receive error code from this function.
+*
+*                               USBD_ERR_NONE                           Read successfully started.
+*                               USBD_ERR_SCSI_MEDIUM_NOTPRESENT         Medium not present.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) See USBD_StorageAsyncQDepthGet() Note #1. The read is done before returning and
+*                   'cmpl_fnct' is called on success.
+*********************************************************************************************************
+*/
+
+void  USBD_StorageRdAsync (USBD_STORAGE_LUN         *p_storage_lun,
+                           CPU_INT64U                blk_addr,
+                           CPU_INT32U                nbr_blks,
+                           CPU_INT08U               *p_data_buf,
+                           USBD_STORAGE_ASYNC_CMPL   cmpl_fnct,
+                           void                     *p_cmpl_arg,
+                           USBD_ERR                 *p_err)
+{
+    USBD_StorageRd(p_storage_lun,                               /* See Note #1.                                         */
+                   blk_addr,
+                   nbr_blks,
+                   p_data_buf,
+                   p_err);
+    if (*p_err == USBD_ERR_NONE) {
+        cmpl_fnct(p_cmpl_arg, USBD_ERR_NONE);
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_StorageWrAsync()
+*
+* Description : Start writing data to the storage medium.
+*
+* Argument(s) : p_storage_lun    Pointer to the logical unit storage structure.
+*
+*               blk_addr         Logical Block Address (LBA) of starting write block.
+*
+*               nbr_blks         Number of logical blocks to write.
+*
+*               p_data_buf       Pointer to buffer in which data is stored.
+*
+*               cmpl_fnct        Function to call when the write completes.
+*
+*               p_cmpl_arg       Argument passed to 'cmpl_fnct'.
+*
+*               p_err       Pointer to variable that will receive error code from this function.
+*
+*                               USBD_ERR_NONE                           Write successfully started.
+*                               USBD_ERR_SCSI_MEDIUM_NOTPRESENT         Medium not present.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) See USBD_StorageAsyncQDepthGet() Note #1. The write is done before returning and
+*                   'cmpl_fnct' is called on success.
+*********************************************************************************************************
+*/
+
+void  USBD_StorageWrAsync (USBD_STORAGE_LUN         *p_storage_lun,
+                           CPU_INT64U                blk_addr,
+                           CPU_INT32U                nbr_blks,
+                           CPU_INT08U               *p_data_buf,
+                           USBD_STORAGE_ASYNC_CMPL   cmpl_fnct,
+                           void                     *p_cmpl_arg,
+                           USBD_ERR                 *p_err)
+{
+    USBD_StorageWr(p_storage_lun,                               /* See Note #1.                                         */
+                   blk_addr,
+                   nbr_blks,
+                   p_data_buf,
+                   p_err);
+    if (*p_err == USBD_ERR_NONE) {
+        cmpl_fnct(p_cmpl_arg, USBD_ERR_NONE);
+    }
+}
+#endif
+
+
 /*
 *********************************************************************************************************
 *                                            USBD_StorageStatusGet()
@@ -402,7 +685,7 @@ void  USBD_StorageStatusGet (USBD_STORAGE_LUN  *p_storage_lun,
     FS_STATE  state;
 
 
-    state = USBD_FS_LunStatePresent[p_storage_lun->LunNbr];
+    state = USBD_FS_LunStatePresent[p_storage_lun->ClassNbr][p_storage_lun->LunNbr];
 
     if (p_storage_lun->MediumPresent == DEF_FALSE) {
 
@@ -550,20 +833,23 @@ void  USBD_StorageUnlock (USBD_STORAGE_LUN  *p_storage_lun,
 void  USBD_StorageRefreshTaskHandler (void *p_arg)
 {
     FS_ERR      err_fs;
+    CPU_INT32U  class_nbr;
     CPU_INT32U  i;
 
 
     (void)p_arg;
                                                                 /* ------ POLLING LIST PROCESSING (see Note #1) ------- */
-    for (i = 0u; i < USBD_MSC_CFG_MAX_LUN; i++) {
+    for (class_nbr = 0u; class_nbr < USBD_MSC_CFG_MAX_NBR_DEV; class_nbr++) {
+        for (i = 0u; i < USBD_MSC_CFG_MAX_LUN; i++) {
 
-        if (USBD_FS_StorageDevPollList[i] != (USBD_STORAGE_LUN *)0u) {
+            if (USBD_FS_StorageDevPollList[class_nbr][i] != (USBD_STORAGE_LUN *)0u) {
                                                                 /* Get status of removable media.                       */
-            FSDev_Refresh(USBD_FS_StorageDevPollList[i]->VolStrPtr, &err_fs);
-            if(err_fs == FS_ERR_NONE) {
-                USBD_FS_LunStatePresent[i] = DEF_TRUE;
-            } else {
-                USBD_FS_LunStatePresent[i] = DEF_FALSE;
+                FSDev_Refresh(USBD_FS_StorageDevPollList[class_nbr][i]->VolStrPtr, &err_fs);
+                if(err_fs == FS_ERR_NONE) {
+                    USBD_FS_LunStatePresent[class_nbr][i] = DEF_TRUE;
+                } else {
+                    USBD_FS_LunStatePresent[class_nbr][i] = DEF_FALSE;
+                }
             }
         }
     }
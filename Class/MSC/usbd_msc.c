@@ -74,6 +74,16 @@
 #define  USBD_MSC_COM_NBR_MAX               (USBD_MSC_CFG_MAX_NBR_DEV * \
                                              USBD_MSC_CFG_MAX_NBR_CFG)
 
+#if (USBD_MSC_CFG_DATA_POOL_EN == DEF_ENABLED)                  /* Data buf pool seg, aligned on buf boundary.          */
+#define  USBD_MSC_DATA_POOL_SEG_LEN       (((USBD_MSC_CFG_DATA_LEN + USBD_CFG_BUF_ALIGN_OCTETS - 1u) / \
+                                             USBD_CFG_BUF_ALIGN_OCTETS) * USBD_CFG_BUF_ALIGN_OCTETS)
+
+#define  USBD_MSC_DATA_POOL_SEG_NBR         (USBD_MSC_CFG_DATA_POOL_LEN / USBD_MSC_DATA_POOL_SEG_LEN)
+#define  USBD_MSC_DATA_POOL_LEN             (USBD_MSC_DATA_POOL_SEG_NBR * USBD_MSC_DATA_POOL_SEG_LEN)
+                                                                /* Segs guaranteed to the MSC instances.                */
+#define  USBD_MSC_DATA_POOL_SEG_RSVD        (USBD_MSC_CFG_MAX_NBR_DEV * USBD_MSC_CFG_DATA_BUF_NBR)
+#endif
+
 
 /*
 *********************************************************************************************************
@@ -102,6 +112,61 @@
 #define  USBD_MSC_PROTOCOL_CODE_CTRL_BULK_INTR_CMD_INTR  0x00
 #define  USBD_MSC_PROTOCOL_CODE_CTRL_BULK_INTR           0x01
 #define  USBD_MSC_PROTOCOL_CODE_BULK_ONLY                0x50
+#define  USBD_MSC_PROTOCOL_CODE_UAS                      0x62
+
+/*
+*********************************************************************************************************
+*                                    USB ATTACHED SCSI (UAS) DEFINES
+*
+* Note(s) : (1) See 'USB Attached SCSI Protocol (UASP)', Revision 1.0.
+*
+*           (2) Each endpoint of the UAS alternate setting is followed by a pipe usage class-specific
+*               descriptor identifying the pipe.  See 'UASP', Section 5.3.3.1.
+*
+*           (3) Multi-byte fields of the information units (IU) are big-endian.  See 'UASP', Section 6.2.
+*********************************************************************************************************
+*/
+
+#define  USBD_MSC_UAS_DESC_TYPE_PIPE_USAGE               0x24   /* See Note #2.                                         */
+#define  USBD_MSC_UAS_DESC_LEN_PIPE_USAGE                   4u
+
+#define  USBD_MSC_UAS_PIPE_ID_CMD                        0x01
+#define  USBD_MSC_UAS_PIPE_ID_STATUS                     0x02
+#define  USBD_MSC_UAS_PIPE_ID_DATA_IN                    0x03
+#define  USBD_MSC_UAS_PIPE_ID_DATA_OUT                   0x04
+
+#define  USBD_MSC_UAS_IU_ID_CMD                          0x01   /* IU ID values.                                        */
+#define  USBD_MSC_UAS_IU_ID_SENSE                        0x03
+#define  USBD_MSC_UAS_IU_ID_RESP                         0x04
+#define  USBD_MSC_UAS_IU_ID_TASK_MGMT                    0x05
+#define  USBD_MSC_UAS_IU_ID_RD_RDY                       0x06
+#define  USBD_MSC_UAS_IU_ID_WR_RDY                       0x07
+
+#define  USBD_MSC_UAS_IU_LEN_CMD                           32u  /* Cmd IU with a 16-byte CDB.                           */
+#define  USBD_MSC_UAS_IU_LEN_TASK_MGMT                     16u
+#define  USBD_MSC_UAS_IU_LEN_RDY                            4u
+#define  USBD_MSC_UAS_IU_LEN_RESP                           8u
+#define  USBD_MSC_UAS_IU_LEN_SENSE_HDR                     16u
+#define  USBD_MSC_UAS_SENSE_DATA_LEN                       18u  /* Fixed format sense data.                             */
+                                                                /* Status buf holds a sense IU with its sense data.     */
+#define  USBD_MSC_UAS_STATUS_BUF_LEN                    (USBD_MSC_UAS_IU_LEN_SENSE_HDR + USBD_MSC_UAS_SENSE_DATA_LEN)
+
+#define  USBD_MSC_UAS_STATUS_GOOD                        0x00   /* SCSI status carried by the sense IU.                 */
+#define  USBD_MSC_UAS_STATUS_CHK_COND                    0x02
+
+#define  USBD_MSC_UAS_TMF_ABORT_TASK                     0x01   /* Task mgmt functions.                                 */
+#define  USBD_MSC_UAS_TMF_ABORT_TASK_SET                 0x02
+#define  USBD_MSC_UAS_TMF_CLR_TASK_SET                   0x04
+#define  USBD_MSC_UAS_TMF_LU_RESET                       0x08
+#define  USBD_MSC_UAS_TMF_IT_NEXUS_RESET                 0x10
+#define  USBD_MSC_UAS_TMF_QUERY_TASK                     0x80
+
+#define  USBD_MSC_UAS_RESP_CMPL                          0x00   /* Response codes.                                      */
+#define  USBD_MSC_UAS_RESP_INVALID_IU                    0x02
+#define  USBD_MSC_UAS_RESP_TMF_NOT_SUPPORTED             0x04
+#define  USBD_MSC_UAS_RESP_TMF_SUCCEEDED                 0x08
+#define  USBD_MSC_UAS_RESP_INCORRECT_LUN                 0x09
+#define  USBD_MSC_UAS_RESP_OVERLAPPED_TAG                0x0A
 
 /*
 *********************************************************************************************************
@@ -249,13 +314,40 @@ typedef  enum  usbd_msc_comm_state {
     USBD_MSC_COMM_STATE_RESET_RECOVERY_BULK_OUT_STALL,
     USBD_MSC_COMM_STATE_RESET_RECOVERY,
     USBD_MSC_COMM_STATE_BULK_IN_STALL,
-    USBD_MSC_COMM_STATE_BULK_OUT_STALL
+    USBD_MSC_COMM_STATE_BULK_OUT_STALL,
+    USBD_MSC_COMM_STATE_IF_ALT_WAIT,
+    USBD_MSC_COMM_STATE_UAS,
+    USBD_MSC_COMM_STATE_UAS_WAIT
 } USBD_MSC_COMM_STATE;
 
 
+/*
+*********************************************************************************************************
+*                                        UAS TASK DATA TYPE
+*
+* Note(s) : (1) Each command or task management IU received on the UAS command pipe occupies one slot
+*               of the task queue until its status is returned on the status pipe.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+typedef  struct  usbd_msc_uas_task {
+    CPU_INT08U   *IU_BufPtr;                                    /* Buf holding the rx'd IU.                             */
+    CPU_INT08U    IU_ID;                                        /* IU ID.                                               */
+    CPU_INT16U    Tag;                                          /* Tag assigned by the host.                            */
+    CPU_INT08U    Lun;                                          /* LUN addressed by the IU.                             */
+    CPU_INT08U    RespCode;                                     /* Resp code determined when the IU was rx'd.           */
+    CPU_BOOLEAN   Abort;                                        /* Task aborted by a task mgmt function.                */
+} USBD_MSC_UAS_TASK;
+#endif
+
+
 /*
 **********************************************************************************************************
 *                                       MSC EP REQUIREMENTS DATA TYPE
+*
+* Note(s) : (1) 'DataBulkInEpAddr' & 'DataBulkOutEpAddr' hold the data EPs of the active alt setting, so
+*               that the data stage functions serve both the bulk-only and the UAS transports.
 **********************************************************************************************************
 */
 
@@ -270,11 +362,22 @@ typedef struct usbd_msc_comm {                                  /* ---------- MS
     CPU_INT32U           BytesToXfer;                           /* Current bytes to xfer during data xfer stage.        */
     void                *SCSIWrBufPtr;                          /* Ptr to the SCSI buf used to wr to SCSI.              */
     CPU_INT32U           SCSIWrBuflen;                          /* SCSI buf len used to wr to SCSI.                     */
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+    CPU_INT08U           BOT_BulkInEpAddr;                      /* Bulk-only alt setting EPs.                           */
+    CPU_INT08U           BOT_BulkOutEpAddr;
+    CPU_INT08U           UAS_CmdEpAddr;                         /* UAS alt setting EPs.                                 */
+    CPU_INT08U           UAS_StatusEpAddr;
+    CPU_INT08U           UAS_DataInEpAddr;
+    CPU_INT08U           UAS_DataOutEpAddr;
+    CPU_INT08U           UAS_AltNbr;                            /* UAS alt setting nbr.                                 */
+    CPU_BOOLEAN          UAS_Active;                            /* UAS alt setting selected by host.                    */
+#endif
 } USBD_MSC_COMM;
 
 
 struct usbd_msc_ctrl {                                          /* ------------- MSC CONTROL INFORMATION -------------- */
     CPU_INT08U         DevNbr;                                  /* MSC dev nbr.                                         */
+    CPU_INT08U         ClassNbr;                                /* MSC class instance nbr.                              */
     USBD_MSC_STATE     State;                                   /* MSC dev state.                                       */
     CPU_INT08U         MaxLun;                                  /* Max logical unit number (LUN).                       */
     USBD_MSC_LUN_CTRL  Lun[USBD_MSC_CFG_MAX_LUN];               /* Array of struct pointing to LUN's                    */
@@ -282,9 +385,34 @@ struct usbd_msc_ctrl {                                          /* -------------
     CPU_INT08U        *CBW_BufPtr;                              /* Buf to rx Cmd Blk  Wrapper.                          */
     CPU_INT08U        *CSW_BufPtr;                              /* Buf to send Cmd Status Wrapper.                      */
     CPU_INT08U        *DataBufPtr;                              /* Buf to handle data stage.                            */
+    CPU_INT32U         DataBufLen;                              /* Len of each data buf.                                */
+#if (USBD_MSC_CFG_DATA_POOL_EN == DEF_ENABLED)
+                                                                /* First pool seg of each data buf.                     */
+    CPU_INT16U         DataPoolSegIxTbl[USBD_MSC_CFG_DATA_BUF_NBR];
+    CPU_INT16U         DataPoolSegNbr;                          /* Nbr of pool segs per data buf.                       */
+#endif
     CPU_INT08U        *CtrlStatusBufPtr;                        /* Buf used for ctrl status xfers.                      */
     CPU_INT32U         USBD_MSC_SCSI_Data_Len;
     CPU_INT08U         USBD_MSC_SCSI_Data_Dir;
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+    CPU_INT08U        *DataBufTbl[USBD_MSC_CFG_DATA_BUF_NBR];   /* Bufs to pipeline data stage.                         */
+    CPU_INT32U         DataLenTbl[USBD_MSC_CFG_DATA_BUF_NBR];   /* Len xfer'd by each pipelined data xfer.              */
+    USBD_ERR           DataErrTbl[USBD_MSC_CFG_DATA_BUF_NBR];   /* Err returned by each pipelined data xfer.            */
+    CPU_INT08U         DataCmplIx;                              /* Ix of next pipelined data xfer to complete.          */
+#endif
+#if (USBD_MSC_CFG_STORAGE_ASYNC_EN == DEF_ENABLED)
+    USBD_ERR           StoErrTbl[USBD_MSC_CFG_DATA_BUF_NBR];    /* Err returned by each async storage access.           */
+    CPU_INT32U         StoCmplCnt;                              /* Nbr of async storage accesses completed.             */
+#endif
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+    USBD_MSC_UAS_TASK  UAS_TaskTbl[USBD_MSC_CFG_UAS_Q_DEPTH];   /* Queue of rx'd UAS IUs.                               */
+    CPU_INT08U         UAS_TaskHead;                            /* Ix of task being executed.                           */
+    CPU_INT08U         UAS_TaskTail;                            /* Ix of slot rx'ing next IU.                           */
+    CPU_INT08U         UAS_TaskCnt;                             /* Nbr of queued tasks.                                 */
+    CPU_BOOLEAN        UAS_TaskExec;                            /* Head task being executed.                            */
+    CPU_BOOLEAN        UAS_CmdRxPend;                           /* Rx pending on cmd pipe.                              */
+    CPU_INT08U        *UAS_StatusBufPtr;                        /* Buf to tx IUs on status pipe.                        */
+#endif
 };
 
 
@@ -306,6 +434,18 @@ static  CPU_INT08U     USBD_MSCCtrlNbrNext;
                                                                 /* MSC comm array.                                      */
 static  USBD_MSC_COMM  USBD_MSCCommTbl[USBD_MSC_COM_NBR_MAX];
 static  CPU_INT16U     USBD_MSCCommNbrNext;
+#if (USBD_CFG_DBG_STATS_POOL_EN == DEF_ENABLED)
+                                                                /* Usage stats of MSC arrays.                           */
+static  USBD_DBG_STATS_POOL  USBD_MSC_DbgStatsPoolCtrl;
+static  USBD_DBG_STATS_POOL  USBD_MSC_DbgStatsPoolComm;
+#endif
+#if (USBD_MSC_CFG_DATA_POOL_EN == DEF_ENABLED)
+                                                                /* Data buf pool shared by MSC instances.               */
+static  CPU_INT08U    *USBD_MSC_DataPoolPtr;
+static  CPU_BOOLEAN    USBD_MSC_DataPoolSegUsedTbl[USBD_MSC_DATA_POOL_SEG_NBR];
+static  CPU_INT16U     USBD_MSC_DataPoolSegFreeCnt;             /* Nbr of free segs.                                    */
+static  CPU_INT16U     USBD_MSC_DataPoolSegRsvdCnt;             /* Free segs guaranteed to instances without bufs.      */
+#endif
 
 
 /*
@@ -358,19 +498,146 @@ static  void                 USBD_MSC_RespVerify    (      USBD_MSC_COMM      *p
                                                            CPU_INT08U          scsi_data_dir,
                                                            USBD_ERR           *p_err);
 
+#if (USBD_MSC_CFG_DATA_BUF_NBR == 1u)
 static  void                 USBD_MSC_SCSI_TxData   (      USBD_MSC_CTRL      *p_ctrl,
                                                            USBD_MSC_COMM      *p_comm);
 
 static  void                 USBD_MSC_SCSI_Rd       (      USBD_MSC_CTRL      *p_ctrl,
                                                            USBD_MSC_COMM      *p_comm);
+#endif
 
 static  void                 USBD_MSC_SCSI_Wr       (const USBD_MSC_CTRL      *p_ctrl,
                                                            USBD_MSC_COMM      *p_comm,
                                                            void               *p_buf,
                                                            CPU_INT32U          xfer_len);
 
+#if ((USBD_MSC_CFG_DATA_BUF_NBR  == 1u) || \
+     (USBD_MSC_CFG_ZERO_COPY_EN == DEF_ENABLED))
 static  void                 USBD_MSC_SCSI_RxData   (      USBD_MSC_CTRL      *p_ctrl,
                                                            USBD_MSC_COMM      *p_comm);
+#endif
+
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+static  void                 USBD_MSC_SCSI_TxDataPipe(     USBD_MSC_CTRL      *p_ctrl,
+                                                           USBD_MSC_COMM      *p_comm);
+
+static  void                 USBD_MSC_SCSI_RxDataPipe(     USBD_MSC_CTRL      *p_ctrl,
+                                                           USBD_MSC_COMM      *p_comm);
+
+static  CPU_INT32U           USBD_MSC_DataXferWait  (      USBD_MSC_CTRL      *p_ctrl,
+                                                           USBD_MSC_COMM      *p_comm,
+                                                           CPU_INT08U          xfer_ix,
+                                                           USBD_ERR           *p_err);
+
+static  void                 USBD_MSC_DataXferCmpl  (      CPU_INT08U          dev_nbr,
+                                                           CPU_INT08U          ep_addr,
+                                                           void               *p_buf,
+                                                           CPU_INT32U          buf_len,
+                                                           CPU_INT32U          xfer_len,
+                                                           void               *p_arg,
+                                                           USBD_ERR            err);
+#endif
+
+#if (USBD_MSC_CFG_STORAGE_ASYNC_EN == DEF_ENABLED)
+static  void                 USBD_MSC_SCSI_TxDataAsync(    USBD_MSC_CTRL      *p_ctrl,
+                                                           USBD_MSC_COMM      *p_comm,
+                                                           CPU_INT08U          q_depth);
+
+static  void                 USBD_MSC_SCSI_RxDataAsync(    USBD_MSC_CTRL      *p_ctrl,
+                                                           USBD_MSC_COMM      *p_comm,
+                                                           CPU_INT08U          q_depth);
+
+static  void                 USBD_MSC_StorageCmpl   (      void               *p_arg,
+                                                           USBD_ERR            err);
+#endif
+
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+static  void                 USBD_MSC_AltSettingUpdate(    CPU_INT08U          dev_nbr,
+                                                           CPU_INT08U          cfg_nbr,
+                                                           CPU_INT08U          if_nbr,
+                                                           CPU_INT08U          if_alt_nbr,
+                                                           void               *p_if_class_arg,
+                                                           void               *p_if_alt_class_arg);
+
+static  void                 USBD_MSC_EP_Desc       (      CPU_INT08U          dev_nbr,
+                                                           CPU_INT08U          cfg_nbr,
+                                                           CPU_INT08U          if_nbr,
+                                                           CPU_INT08U          if_alt_nbr,
+                                                           CPU_INT08U          ep_addr,
+                                                           void               *p_if_class_arg,
+                                                           void               *p_if_alt_class_arg);
+
+static  CPU_INT16U           USBD_MSC_EP_DescSizeGet(      CPU_INT08U          dev_nbr,
+                                                           CPU_INT08U          cfg_nbr,
+                                                           CPU_INT08U          if_nbr,
+                                                           CPU_INT08U          if_alt_nbr,
+                                                           CPU_INT08U          ep_addr,
+                                                           void               *p_if_class_arg,
+                                                           void               *p_if_alt_class_arg);
+
+static  void                 USBD_MSC_UAS_AltAdd    (      CPU_INT08U          dev_nbr,
+                                                           CPU_INT08U          cfg_nbr,
+                                                           CPU_INT08U          if_nbr,
+                                                           USBD_MSC_COMM      *p_comm,
+                                                           USBD_ERR           *p_err);
+
+static  void                 USBD_MSC_UAS_CmdRxStart(      USBD_MSC_CTRL      *p_ctrl,
+                                                           USBD_MSC_COMM      *p_comm);
+
+static  void                 USBD_MSC_UAS_CmdRxCmpl (      CPU_INT08U          dev_nbr,
+                                                           CPU_INT08U          ep_addr,
+                                                           void               *p_buf,
+                                                           CPU_INT32U          buf_len,
+                                                           CPU_INT32U          xfer_len,
+                                                           void               *p_arg,
+                                                           USBD_ERR            err);
+
+static  void                 USBD_MSC_UAS_IU_Parse  (      USBD_MSC_CTRL      *p_ctrl,
+                                                           USBD_MSC_COMM      *p_comm,
+                                                           USBD_MSC_UAS_TASK  *p_task,
+                                                           CPU_INT32U          iu_len);
+
+static  CPU_INT08U           USBD_MSC_UAS_TaskMgmt  (      USBD_MSC_CTRL      *p_ctrl,
+                                                           USBD_MSC_COMM      *p_comm,
+                                                     const CPU_INT08U         *p_iu);
+
+static  void                 USBD_MSC_UAS_TaskExec  (      USBD_MSC_CTRL      *p_ctrl,
+                                                           USBD_MSC_COMM      *p_comm);
+
+static  void                 USBD_MSC_UAS_CmdExec   (      USBD_MSC_CTRL      *p_ctrl,
+                                                           USBD_MSC_COMM      *p_comm,
+                                                           USBD_MSC_UAS_TASK  *p_task);
+
+static  void                 USBD_MSC_UAS_RespTx    (      USBD_MSC_CTRL      *p_ctrl,
+                                                           USBD_MSC_COMM      *p_comm,
+                                                           CPU_INT08U          iu_id,
+                                                           CPU_INT16U          tag,
+                                                           CPU_INT08U          resp_code,
+                                                           USBD_ERR           *p_err);
+
+static  void                 USBD_MSC_UAS_SenseTx   (      USBD_MSC_CTRL      *p_ctrl,
+                                                           USBD_MSC_COMM      *p_comm,
+                                                     const USBD_MSC_UAS_TASK  *p_task,
+                                                           CPU_INT08U          status,
+                                                           USBD_ERR           *p_err);
+
+static  void                 USBD_MSC_UAS_StatusTx  (      USBD_MSC_CTRL      *p_ctrl,
+                                                           USBD_MSC_COMM      *p_comm,
+                                                           CPU_INT32U          iu_len,
+                                                           USBD_ERR           *p_err);
+#endif
+
+#if (USBD_MSC_CFG_DATA_POOL_EN == DEF_ENABLED)
+static  void                 USBD_MSC_DataBufGet    (      USBD_MSC_CTRL      *p_ctrl,
+                                                           CPU_INT32U          data_len);
+
+static  void                 USBD_MSC_DataBufRel    (      USBD_MSC_CTRL      *p_ctrl);
+
+static  CPU_INT16U           USBD_MSC_DataPoolRunFind(     CPU_INT16U          seg_nbr);
+
+static  CPU_BOOLEAN          USBD_MSC_DataPoolRunTake(     CPU_INT16U          seg_ix,
+                                                           CPU_INT16U          seg_nbr);
+#endif
 
 static  void                 USBD_MSC_LunClr        (      USBD_MSC_LUN_CTRL  *p_lun);
 
@@ -390,12 +657,21 @@ static  void                 USBD_MSC_CSW_Fmt       (const USBD_MSC_CSW       *p
 USBD_CLASS_DRV USBD_MSC_Drv = {
     USBD_MSC_Conn,
     USBD_MSC_Disconn,
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+    USBD_MSC_AltSettingUpdate,                                  /* UAS uses an alternate IF.                            */
+#else
     DEF_NULL,                                                   /* MSC does NOT use alternate IF(s).                    */
+#endif
     USBD_MSC_EP_StateUpdate,
     DEF_NULL,                                                   /* MSC does NOT use IF functional desc.                 */
     DEF_NULL,
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+    USBD_MSC_EP_Desc,                                           /* UAS pipe usage desc.                                 */
+    USBD_MSC_EP_DescSizeGet,
+#else
     DEF_NULL,                                                   /* MSC does NOT use EP functional desc.                 */
     DEF_NULL,
+#endif
     DEF_NULL,                                                   /* MSC does NOT handle std req with IF recipient.       */
     USBD_MSC_ClassReq,
     DEF_NULL,
@@ -413,6 +689,16 @@ USBD_CLASS_DRV USBD_MSC_Drv = {
 *********************************************************************************************************
 */
 
+#if (USBD_MSC_CFG_DATA_POOL_EN == DEF_ENABLED)
+#if (USBD_MSC_DATA_POOL_SEG_NBR < USBD_MSC_DATA_POOL_SEG_RSVD)
+#error  "USBD_MSC_CFG_DATA_POOL_LEN illegally #define'd in 'usbd_cfg.h' [MUST hold DATA_BUF_NBR bufs per MSC instance]"
+#endif
+
+#if (USBD_MSC_DATA_POOL_SEG_NBR > DEF_INT_16U_MAX_VAL)
+#error  "USBD_MSC_CFG_DATA_POOL_LEN illegally #define'd in 'usbd_cfg.h' [MUST be <= 65535 * USBD_MSC_CFG_DATA_LEN]"
+#endif
+#endif
+
 
 /*
 *********************************************************************************************************
@@ -442,6 +728,16 @@ USBD_CLASS_DRV USBD_MSC_Drv = {
 void  USBD_MSC_Init (USBD_ERR  *p_err)
 {
     CPU_INT08U      ix;
+#if ((USBD_MSC_CFG_DATA_BUF_NBR >  1u) && \
+     (USBD_MSC_CFG_DATA_POOL_EN == DEF_DISABLED))
+    CPU_INT08U      buf_ix;
+#endif
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+    CPU_INT08U      task_ix;
+#endif
+#if (USBD_MSC_CFG_DATA_POOL_EN == DEF_ENABLED)
+    CPU_INT16U      seg_ix;
+#endif
     USBD_MSC_CTRL  *p_ctrl;
     USBD_MSC_COMM  *p_comm;
     LIB_ERR         err_lib;
@@ -455,6 +751,7 @@ void  USBD_MSC_Init (USBD_ERR  *p_err)
 
     for (ix = 0u; ix < USBD_MSC_CFG_MAX_NBR_DEV; ix++) {        /* Init MSC class struct.                               */
         p_ctrl                         = &USBD_MSCCtrlTbl[ix];
+        p_ctrl->ClassNbr               =  ix;
         p_ctrl->State                  =  USBD_MSC_STATE_NONE;
         p_ctrl->CommPtr                = (USBD_MSC_COMM *)0;
         p_ctrl->MaxLun                 = (CPU_INT08U     )0;
@@ -485,6 +782,14 @@ void  USBD_MSC_Init (USBD_ERR  *p_err)
         Mem_Clr((void *)p_ctrl->CSW_BufPtr,
                         USBD_MSC_LEN_CSW);
 
+        p_ctrl->DataBufLen = USBD_MSC_CFG_DATA_LEN;
+#if (USBD_MSC_CFG_DATA_POOL_EN == DEF_ENABLED)
+        p_ctrl->DataBufPtr     = (CPU_INT08U *)0;               /* Data bufs taken from pool for each data stage.       */
+        p_ctrl->DataPoolSegNbr =  0u;
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+        p_ctrl->DataCmplIx     =  0u;
+#endif
+#else
         p_ctrl->DataBufPtr = (CPU_INT08U *)Mem_HeapAlloc(              USBD_MSC_CFG_DATA_LEN,
                                                                        USBD_CFG_BUF_ALIGN_OCTETS,
                                                          (CPU_SIZE_T *)DEF_NULL,
@@ -497,6 +802,22 @@ void  USBD_MSC_Init (USBD_ERR  *p_err)
         Mem_Clr((void *)p_ctrl->DataBufPtr,
                         USBD_MSC_CFG_DATA_LEN);
 
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+        p_ctrl->DataCmplIx     =  0u;
+        p_ctrl->DataBufTbl[0u] =  p_ctrl->DataBufPtr;           /* First pipeline buf is the data stage buf.            */
+        for (buf_ix = 1u; buf_ix < USBD_MSC_CFG_DATA_BUF_NBR; buf_ix++) {
+            p_ctrl->DataBufTbl[buf_ix] = (CPU_INT08U *)Mem_HeapAlloc(              USBD_MSC_CFG_DATA_LEN,
+                                                                                   USBD_CFG_BUF_ALIGN_OCTETS,
+                                                                     (CPU_SIZE_T *)DEF_NULL,
+                                                                                  &err_lib);
+            if (err_lib != LIB_MEM_ERR_NONE) {
+               *p_err = USBD_ERR_ALLOC;
+                return;
+            }
+        }
+#endif
+#endif
+
         p_ctrl->CtrlStatusBufPtr = (CPU_INT08U *)Mem_HeapAlloc(               sizeof(CPU_ADDR),
                                                                               USBD_CFG_BUF_ALIGN_OCTETS,
                                                                (CPU_SIZE_T  *)DEF_NULL,
@@ -505,6 +826,33 @@ void  USBD_MSC_Init (USBD_ERR  *p_err)
            *p_err = USBD_ERR_ALLOC;
             return;
         }
+
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+        p_ctrl->UAS_TaskHead  = 0u;
+        p_ctrl->UAS_TaskTail  = 0u;
+        p_ctrl->UAS_TaskCnt   = 0u;
+        p_ctrl->UAS_TaskExec  = DEF_NO;
+        p_ctrl->UAS_CmdRxPend = DEF_NO;
+        for (task_ix = 0u; task_ix < USBD_MSC_CFG_UAS_Q_DEPTH; task_ix++) {
+            p_ctrl->UAS_TaskTbl[task_ix].IU_BufPtr = (CPU_INT08U *)Mem_HeapAlloc(              USBD_MSC_UAS_IU_LEN_CMD,
+                                                                                               USBD_CFG_BUF_ALIGN_OCTETS,
+                                                                                 (CPU_SIZE_T *)DEF_NULL,
+                                                                                              &err_lib);
+            if (err_lib != LIB_MEM_ERR_NONE) {
+               *p_err = USBD_ERR_ALLOC;
+                return;
+            }
+        }
+
+        p_ctrl->UAS_StatusBufPtr = (CPU_INT08U *)Mem_HeapAlloc(              USBD_MSC_UAS_STATUS_BUF_LEN,
+                                                                             USBD_CFG_BUF_ALIGN_OCTETS,
+                                                               (CPU_SIZE_T *)DEF_NULL,
+                                                                            &err_lib);
+        if (err_lib != LIB_MEM_ERR_NONE) {
+           *p_err = USBD_ERR_ALLOC;
+            return;
+        }
+#endif
     }
 
     for (ix = 0u; ix < USBD_MSC_COM_NBR_MAX; ix++) {            /* Init test class EP tbl.                              */
@@ -532,11 +880,41 @@ void  USBD_MSC_Init (USBD_ERR  *p_err)
         p_comm->BytesToXfer                = (CPU_INT32U )0;
         p_comm->SCSIWrBufPtr               = (void      *)0;
         p_comm->SCSIWrBuflen               = (CPU_INT32U )0;
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+        p_comm->BOT_BulkInEpAddr           =  USBD_EP_ADDR_NONE;
+        p_comm->BOT_BulkOutEpAddr          =  USBD_EP_ADDR_NONE;
+        p_comm->UAS_CmdEpAddr              =  USBD_EP_ADDR_NONE;
+        p_comm->UAS_StatusEpAddr           =  USBD_EP_ADDR_NONE;
+        p_comm->UAS_DataInEpAddr           =  USBD_EP_ADDR_NONE;
+        p_comm->UAS_DataOutEpAddr          =  USBD_EP_ADDR_NONE;
+        p_comm->UAS_AltNbr                 =  USBD_IF_ALT_NBR_NONE;
+        p_comm->UAS_Active                 =  DEF_NO;
+#endif
+    }
+
+#if (USBD_MSC_CFG_DATA_POOL_EN == DEF_ENABLED)
+    USBD_MSC_DataPoolPtr = (CPU_INT08U *)Mem_HeapAlloc(              USBD_MSC_DATA_POOL_LEN,
+                                                                     USBD_CFG_BUF_ALIGN_OCTETS,
+                                                       (CPU_SIZE_T *)DEF_NULL,
+                                                                    &err_lib);
+    if (err_lib != LIB_MEM_ERR_NONE) {
+       *p_err = USBD_ERR_ALLOC;
+        return;
+    }
+
+    for (seg_ix = 0u; seg_ix < USBD_MSC_DATA_POOL_SEG_NBR; seg_ix++) {
+        USBD_MSC_DataPoolSegUsedTbl[seg_ix] = DEF_NO;
     }
+    USBD_MSC_DataPoolSegFreeCnt = USBD_MSC_DATA_POOL_SEG_NBR;
+    USBD_MSC_DataPoolSegRsvdCnt = USBD_MSC_DATA_POOL_SEG_RSVD;
+#endif
 
     USBD_MSCCtrlNbrNext = 0u;
     USBD_MSCCommNbrNext = 0u;
 
+    USBD_DBG_STATS_POOL_REG(&USBD_MSC_DbgStatsPoolCtrl, "MSC ctrl", USBD_MSC_CFG_MAX_NBR_DEV);
+    USBD_DBG_STATS_POOL_REG(&USBD_MSC_DbgStatsPoolComm, "MSC comm", USBD_MSC_COM_NBR_MAX);
+
     USBD_SCSI_Init(p_err);                                      /* Init SCSI layer.                                     */
     if (*p_err != USBD_ERR_NONE) {
         return;
@@ -586,6 +964,7 @@ CPU_INT08U  USBD_MSC_Add (USBD_ERR  *p_err)
 
     if (msc_nbr >= USBD_MSC_CFG_MAX_NBR_DEV) {
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FAIL(&USBD_MSC_DbgStatsPoolCtrl);
        *p_err = USBD_ERR_MSC_INSTANCE_ALLOC;
         return (USBD_CLASS_NBR_NONE);
     }
@@ -593,6 +972,8 @@ CPU_INT08U  USBD_MSC_Add (USBD_ERR  *p_err)
     USBD_MSCCtrlNbrNext++;
     CPU_CRITICAL_EXIT();
 
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_MSC_DbgStatsPoolCtrl);
+
    *p_err = USBD_ERR_NONE;
     return (msc_nbr);
 }
@@ -667,6 +1048,17 @@ CPU_INT08U  USBD_MSC_Add (USBD_ERR  *p_err)
 *                   is composed of two interfaces. Each class instance has an association with one of the
 *                   interfaces. If 'Configuration 1' is activated by the host, it allows the host to access
 *                   two different functionalities offered by the device.
+*
+*               (2) When USB Attached SCSI is enabled (see 'usbd_cfg.h', MSC Note #10), the interface gets
+*                   a second alternate setting with the UAS protocol code and four bulk endpoints :
+*
+*                   |-- Interface Descriptor (MSC, alternate setting 1, UAS)
+*                   |-- Endpoint Descriptor (Bulk OUT, command pipe)
+*                   |-- Endpoint Descriptor (Bulk IN,  status  pipe)
+*                   |-- Endpoint Descriptor (Bulk IN,  data-in pipe)
+*                   |-- Endpoint Descriptor (Bulk OUT, data-out pipe)
+*
+*                   Hosts without a UAS driver keep using the bulk-only alternate setting 0.
 *********************************************************************************************************
 */
 
@@ -735,6 +1127,8 @@ CPU_BOOLEAN  USBD_MSC_CfgAdd (CPU_INT08U   class_nbr,
     if (comm_nbr >= USBD_MSC_COM_NBR_MAX) {
         USBD_MSCCtrlNbrNext--;
          CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FREE(&USBD_MSC_DbgStatsPoolCtrl);
+        USBD_DBG_STATS_POOL_FAIL(&USBD_MSC_DbgStatsPoolComm);
         *p_err = USBD_ERR_MSC_INSTANCE_ALLOC;
         return (DEF_NO);
     }
@@ -742,6 +1136,8 @@ CPU_BOOLEAN  USBD_MSC_CfgAdd (CPU_INT08U   class_nbr,
     USBD_MSCCommNbrNext++;
     CPU_CRITICAL_EXIT();
 
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_MSC_DbgStatsPoolComm);
+
     p_comm = &USBD_MSCCommTbl[comm_nbr];
 
     if_nbr = USBD_IF_Add (        dev_nbr,                      /* Add MSC IF desc to cfg desc.                         */
@@ -784,6 +1180,20 @@ CPU_BOOLEAN  USBD_MSC_CfgAdd (CPU_INT08U   class_nbr,
 
     p_comm->DataBulkOutEpAddr = ep_addr;                        /* Store bulk-OUT EP address.                           */
 
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+    p_comm->BOT_BulkInEpAddr  = p_comm->DataBulkInEpAddr;
+    p_comm->BOT_BulkOutEpAddr = p_comm->DataBulkOutEpAddr;
+
+    USBD_MSC_UAS_AltAdd(dev_nbr,                                /* Add UAS alt setting (see Note #2).                   */
+                        cfg_nbr,
+                        if_nbr,
+                        p_comm,
+                        p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return (DEF_NO);
+    }
+#endif
+
     CPU_CRITICAL_ENTER();
     p_ctrl->State   =  USBD_MSC_STATE_INIT;                     /* Set class instance to init state.                    */
     p_ctrl->DevNbr  =  dev_nbr;
@@ -882,6 +1292,7 @@ void  USBD_MSC_LunAdd (const  CPU_CHAR    *p_store_name,
 
     USBD_MSC_LunClr(&p_ctrl->Lun[max_lun]);                     /* Init LUN struct.                                     */
 
+    p_ctrl->Lun[max_lun].ClassNbr  =         class_nbr;
     p_ctrl->Lun[max_lun].LunNbr    =         max_lun;
     p_ctrl->Lun[max_lun].LunArgPtr = (void *)p_store_name;
 
@@ -896,7 +1307,8 @@ void  USBD_MSC_LunAdd (const  CPU_CHAR    *p_store_name,
     p_ctrl->Lun[max_lun].LunInfo.ProdRevisionLevel = prod_rev_level;
     p_ctrl->Lun[max_lun].LunInfo.ReadOnly          = rd_only;
 
-    USBD_SCSI_LunAdd(p_ctrl->Lun[max_lun].LunNbr,
+    USBD_SCSI_LunAdd(class_nbr,
+                     p_ctrl->Lun[max_lun].LunNbr,
                      p_ctrl->Lun[max_lun].LunArgPtr,
                      p_err);
 
@@ -953,6 +1365,138 @@ CPU_BOOLEAN  USBD_MSC_IsConn (CPU_INT08U  class_nbr)
 }
 
 
+/*
+*********************************************************************************************************
+*                                      USBD_MSC_LunCacheStatGet()
+*
+* Description : Get the block cache statistics of a logical unit.
+*
+* Argument(s) : class_nbr   MSC instance number.
+*
+*               lun_nbr     Logical unit number.
+*
+*               p_stat      Pointer to structure that will receive the statistics.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                   Statistics successfully returned.
+*                               USBD_ERR_NULL_PTR               Argument 'p_stat' passed a NULL pointer.
+*                               USBD_ERR_CLASS_INVALID_NBR      Invalid class number.
+*                               USBD_ERR_INVALID_ARG            Invalid logical unit number.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Counters are in blocks, except WrBackReqCnt which counts the write requests issued to
+*                   the storage layer. WrBackCnt / WrBackReqCnt gives the average number of dirty blocks
+*                   coalesced per write request.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+void  USBD_MSC_LunCacheStatGet (CPU_INT08U            class_nbr,
+                                CPU_INT08U            lun_nbr,
+                                USBD_MSC_CACHE_STAT  *p_stat,
+                                USBD_ERR             *p_err)
+{
+    USBD_MSC_CTRL  *p_ctrl;
+
+
+#if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)                /* ---------------- VALIDATE ARGUMENTS ---------------- */
+    if (p_err == (USBD_ERR *)0) {                               /* Validate error ptr.                                  */
+        CPU_SW_EXCEPTION(;);
+    }
+
+    if (p_stat == (USBD_MSC_CACHE_STAT *)0) {
+       *p_err = USBD_ERR_NULL_PTR;
+        return;
+    }
+#endif
+
+    if (class_nbr >= USBD_MSCCtrlNbrNext) {
+       *p_err = USBD_ERR_CLASS_INVALID_NBR;
+        return;
+    }
+
+    p_ctrl = &USBD_MSCCtrlTbl[class_nbr];
+
+    if (lun_nbr >= p_ctrl->MaxLun) {
+       *p_err = USBD_ERR_INVALID_ARG;
+        return;
+    }
+
+    USBD_SCSI_CacheStatGet(&p_ctrl->Lun[lun_nbr], p_stat);
+
+   *p_err = USBD_ERR_NONE;
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_MSC_LunRdAheadStatGet()
+*
+* Description : Get the read-ahead statistics of a logical unit.
+*
+* Argument(s) : class_nbr   MSC instance number.
+*
+*               lun_nbr     Logical unit number.
+*
+*               p_stat      Pointer to structure that will receive the statistics.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                   Statistics successfully returned.
+*                               USBD_ERR_NULL_PTR               Argument 'p_stat' passed a NULL pointer.
+*                               USBD_ERR_CLASS_INVALID_NBR      Invalid class number.
+*                               USBD_ERR_INVALID_ARG            Invalid logical unit number.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Counters are in blocks, except SeqCmdCnt which counts READ commands and FillCnt which
+*                   counts the read requests issued to the storage layer to fill the window. HitBlkCnt /
+*                   RdBlkCnt gives the read-ahead hit rate.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+void  USBD_MSC_LunRdAheadStatGet (CPU_INT08U               class_nbr,
+                                  CPU_INT08U               lun_nbr,
+                                  USBD_MSC_RD_AHEAD_STAT  *p_stat,
+                                  USBD_ERR                *p_err)
+{
+    USBD_MSC_CTRL  *p_ctrl;
+
+
+#if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)                /* ---------------- VALIDATE ARGUMENTS ---------------- */
+    if (p_err == (USBD_ERR *)0) {                               /* Validate error ptr.                                  */
+        CPU_SW_EXCEPTION(;);
+    }
+
+    if (p_stat == (USBD_MSC_RD_AHEAD_STAT *)0) {
+       *p_err = USBD_ERR_NULL_PTR;
+        return;
+    }
+#endif
+
+    if (class_nbr >= USBD_MSCCtrlNbrNext) {
+       *p_err = USBD_ERR_CLASS_INVALID_NBR;
+        return;
+    }
+
+    p_ctrl = &USBD_MSCCtrlTbl[class_nbr];
+
+    if (lun_nbr >= p_ctrl->MaxLun) {
+       *p_err = USBD_ERR_INVALID_ARG;
+        return;
+    }
+
+    USBD_SCSI_RdAheadStatGet(&p_ctrl->Lun[lun_nbr], p_stat);
+
+   *p_err = USBD_ERR_NONE;
+}
+#endif
+
+
 /*
 **********************************************************************************************************
 *                                            USBD_MSC_TaskHandler()
@@ -963,7 +1507,8 @@ CPU_BOOLEAN  USBD_MSC_IsConn (CPU_INT08U  class_nbr)
 *
 * Return(s)   : none.
 *
-* Note(s)     : none.
+* Note(s)     : (1) While the UAS alternate setting is selected, the task executes the IUs queued from
+*                   the command pipe instead of running the bulk-only state machine.
 **********************************************************************************************************
 */
 
@@ -984,7 +1529,8 @@ void  USBD_MSC_TaskHandler (CPU_INT08U  class_nbr)
         conn = USBD_MSC_IsConn(class_nbr);
         if (conn != DEF_YES) {
                                                                 /* Wait till MSC state and dev state is connected.      */
-            USBD_MSC_OS_EnumSignalPend((CPU_INT16U)0,
+            USBD_MSC_OS_EnumSignalPend(            class_nbr,
+                                       (CPU_INT16U)0,
                                                   &os_err);
         }
 
@@ -992,6 +1538,12 @@ void  USBD_MSC_TaskHandler (CPU_INT08U  class_nbr)
         p_comm     = p_ctrl->CommPtr;
 
         if (p_comm != (USBD_MSC_COMM *)0) {
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+            if (p_comm->UAS_Active == DEF_YES) {                /* Host selected UAS alt setting (see Note #1).         */
+                USBD_MSC_UAS_TaskExec(p_ctrl, p_comm);
+                continue;
+            }
+#endif
             switch(comm_state) {
                 case USBD_MSC_COMM_STATE_CBW:                   /* ---------------- RECEIVE CBW STATE ----------------- */
                      USBD_MSC_RxCBW(p_ctrl,
@@ -1044,6 +1596,16 @@ void  USBD_MSC_TaskHandler (CPU_INT08U  class_nbr)
                      break;
 
 
+                case USBD_MSC_COMM_STATE_IF_ALT_WAIT:           /* ------------ ALT SETTING UPDATE WAIT STATE --------- */
+                                                                /* Wait on sem for alt setting update to complete.      */
+                     USBD_MSC_OS_CommSignalPend(            class_nbr,
+                                                (CPU_INT16U)0,
+                                                           &os_err);
+                     break;
+
+
+                case USBD_MSC_COMM_STATE_UAS:
+                case USBD_MSC_COMM_STATE_UAS_WAIT:
                 case USBD_MSC_COMM_STATE_NONE:
                 default:
                      break;
@@ -1097,6 +1659,11 @@ static  void  USBD_MSC_Conn (CPU_INT08U   dev_nbr,
     p_comm->CtrlPtr->CommPtr = p_comm;
     p_comm->CtrlPtr->State   = USBD_MSC_STATE_CFG;              /* Set initial MSC state to cfg.                        */
     p_comm->NextCommState    = USBD_MSC_COMM_STATE_CBW;         /* Set initial MSC comm state to rx CBW.                */
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+    p_comm->UAS_Active        = DEF_NO;                         /* Cfg starts with bulk-only alt setting.               */
+    p_comm->DataBulkInEpAddr  = p_comm->BOT_BulkInEpAddr;
+    p_comm->DataBulkOutEpAddr = p_comm->BOT_BulkOutEpAddr;
+#endif
     CPU_CRITICAL_EXIT();
 
     for (lun = 0 ; lun < p_comm->CtrlPtr->MaxLun; lun++){       /* Perform some SCSI operations on each logical unit.   */
@@ -1104,7 +1671,7 @@ static  void  USBD_MSC_Conn (CPU_INT08U   dev_nbr,
         USBD_SCSI_Conn(&p_comm->CtrlPtr->Lun[lun]);
     }
 
-    USBD_MSC_OS_EnumSignalPost(&os_err);
+    USBD_MSC_OS_EnumSignalPost(p_comm->CtrlPtr->ClassNbr, &os_err);
     USBD_DBG_MSC_MSG("MSC: Conn");
 }
 
@@ -1152,6 +1719,8 @@ static  void  USBD_MSC_Disconn (CPU_INT08U   dev_nbr,
         case USBD_MSC_COMM_STATE_RESET_RECOVERY_BULK_OUT_STALL:
         case USBD_MSC_COMM_STATE_BULK_IN_STALL:
         case USBD_MSC_COMM_STATE_BULK_OUT_STALL:
+        case USBD_MSC_COMM_STATE_IF_ALT_WAIT:
+        case USBD_MSC_COMM_STATE_UAS_WAIT:
              post_signal = DEF_TRUE;
              break;
 
@@ -1160,6 +1729,7 @@ static  void  USBD_MSC_Disconn (CPU_INT08U   dev_nbr,
         case USBD_MSC_COMM_STATE_CBW:
         case USBD_MSC_COMM_STATE_DATA:
         case USBD_MSC_COMM_STATE_CSW:
+        case USBD_MSC_COMM_STATE_UAS:
         default:
              post_signal = DEF_FALSE;
              break;
@@ -1167,10 +1737,14 @@ static  void  USBD_MSC_Disconn (CPU_INT08U   dev_nbr,
     p_comm->CtrlPtr->CommPtr = (USBD_MSC_COMM *)0;
     p_comm->CtrlPtr->State   =  USBD_MSC_STATE_INIT;            /* Set MSC state to init.                               */
     p_comm->NextCommState    =  USBD_MSC_COMM_STATE_NONE;       /* Set MSC comm state to none.                          */
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+    p_comm->UAS_Active       =  DEF_NO;                         /* Stop re-arming the UAS cmd pipe.                     */
+#endif
     CPU_CRITICAL_EXIT();
 
     if (post_signal == DEF_TRUE) {
-         USBD_MSC_OS_CommSignalPost(dev_nbr, &os_err);          /* Post sem to notify waiting task if comm ...          */
+         USBD_MSC_OS_CommSignalPost(p_comm->CtrlPtr->ClassNbr,  /* Post sem to notify waiting task if comm ...          */
+                                   &os_err);
     }                                                           /* ... is in reset recovery and bulk-IN or bulk-OUT ... */
                                                                 /* ... stall states.                                    */
                                                                 /* Unlock each logical unit added to configuration      */
@@ -1209,6 +1783,9 @@ static  void  USBD_MSC_Disconn (CPU_INT08U   dev_nbr,
 *                   (a) a Bulk-Only Mass Storage Reset
 *                   (b) a Clear Feature HALT to the Bulk-In endpoint or Bulk-Out endpoint.
 *                   (c) a Clear Feature HALT to the complement Bulk-Out endpoint or Bulk-In endpoint.
+*
+*               (2) UAS has no reset recovery.  A halted UAS pipe is simply cleared by the host and the
+*                   affected commands are terminated through task management IUs.
 *********************************************************************************************************
 */
 
@@ -1236,6 +1813,11 @@ static  void  USBD_MSC_EP_StateUpdate (CPU_INT08U   dev_nbr,
     p_comm     = (USBD_MSC_COMM *)p_if_class_arg;
     err        = USBD_ERR_NONE;
 
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+    if (p_comm->UAS_Active == DEF_YES) {                        /* See Note #2.                                         */
+        return;
+    }
+#endif
 
     switch (p_comm->NextCommState) {
 
@@ -1245,7 +1827,7 @@ static  void  USBD_MSC_EP_StateUpdate (CPU_INT08U   dev_nbr,
                  if (ep_is_stall == DEF_FALSE) {                /* Verify that EP is unstalled.                         */
                            USBD_DBG_MSC_MSG("MSC: UpdateEP Bulk IN Stall, Signal");
                                                                 /* Post sem to notify waiting task.                     */
-                           USBD_MSC_OS_CommSignalPost (dev_nbr, &os_err);
+                           USBD_MSC_OS_CommSignalPost (p_comm->CtrlPtr->ClassNbr, &os_err);
 
                  } else {
                      USBD_DBG_MSC_MSG("MSC: UpdateEp Bulk In Stall, EP not stalled");
@@ -1262,7 +1844,7 @@ static  void  USBD_MSC_EP_StateUpdate (CPU_INT08U   dev_nbr,
                  if (ep_is_stall == DEF_FALSE){                 /* Verify that EP is unstalled.                         */
                          USBD_DBG_MSC_MSG("MSC: UpdateEP Bulk OUT Stall, Signal");
                                                                 /* Post sem to notify waiting task.                     */
-                         USBD_MSC_OS_CommSignalPost (dev_nbr, &os_err);
+                         USBD_MSC_OS_CommSignalPost (p_comm->CtrlPtr->ClassNbr, &os_err);
                  } else {
                      USBD_DBG_MSC_MSG("MSC: UpdateEP Bulk OUT Stall, EP not stalled");
                  }
@@ -1323,7 +1905,7 @@ static  void  USBD_MSC_EP_StateUpdate (CPU_INT08U   dev_nbr,
 
              if ((ep_in_is_stall == DEF_FALSE) && (ep_out_is_stall == DEF_FALSE)){
                  USBD_DBG_MSC_MSG("MSC: UpdateEP Reset Recovery, Signal");
-                 USBD_MSC_OS_CommSignalPost(dev_nbr, &os_err);
+                 USBD_MSC_OS_CommSignalPost(p_comm->CtrlPtr->ClassNbr, &os_err);
              } else {
                  USBD_DBG_MSC_MSG("MSC: UpdateEP Reset Recovery, MSC Reset, Clear Stalled");
              }
@@ -1402,7 +1984,7 @@ static  CPU_BOOLEAN  USBD_MSC_ClassReq (       CPU_INT08U       dev_nbr,
                  if (err != USBD_ERR_NONE) {
                      USBD_DBG_MSC_MSG("MSC: Class Mass Storage Reset, EP OUT Abort failed");
                  }
-                 USBD_SCSI_Reset();                             /* Reset the SCSI.                                      */
+                 USBD_SCSI_Reset(p_ctrl->ClassNbr);             /* Reset the SCSI state of the instance's LUNs.         */
 
                  if (err == USBD_ERR_NONE){
                      valid = DEF_YES;
@@ -1688,12 +2270,26 @@ static  void  USBD_MSC_CMD_Process (USBD_MSC_CTRL  *p_ctrl,
     if (err == USBD_ERR_NONE) {                                 /* SCSI command success.                                */
         p_comm->BytesToXfer = DEF_MIN(p_comm->CBW.dCBWDataTransferLength, p_ctrl->USBD_MSC_SCSI_Data_Len);
         if (p_comm->BytesToXfer > 0) {                          /* Host expects data and device has data.               */
+#if (USBD_MSC_CFG_DATA_POOL_EN == DEF_ENABLED)
+            USBD_MSC_DataBufGet(p_ctrl, p_comm->BytesToXfer);   /* Size data bufs to the data stage.                    */
+#endif
             if (p_comm->CBW.bmCBWFlags == USBD_MSC_BMCBWFLAGS_DIR_HOST_TO_DEVICE) {
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+                USBD_MSC_SCSI_RxDataPipe(p_ctrl, p_comm);       /* Rx data from host on bulk-OUT.                       */
+#else
                 USBD_MSC_SCSI_RxData(p_ctrl, p_comm);           /* Rx data from host on bulk-OUT.                       */
+#endif
 
             } else {
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+                USBD_MSC_SCSI_TxDataPipe(p_ctrl, p_comm);       /* Tx data to host on bulk-IN.                          */
+#else
                 USBD_MSC_SCSI_TxData(p_ctrl, p_comm);           /* Tx data to host on bulk-IN.                          */
+#endif
             }
+#if (USBD_MSC_CFG_DATA_POOL_EN == DEF_ENABLED)
+            USBD_MSC_DataBufRel(p_ctrl);                        /* Return data bufs to the pool.                        */
+#endif
 
         } else {
             if (p_comm->Stall) {                                /* Host expects data and but dev has NO data.           */
@@ -1755,6 +2351,7 @@ static  void  USBD_MSC_CMD_Process (USBD_MSC_CTRL  *p_ctrl,
 **********************************************************************************************************
 */
 
+#if (USBD_MSC_CFG_DATA_BUF_NBR == 1u)
 static  void  USBD_MSC_SCSI_TxData (USBD_MSC_CTRL  *p_ctrl,
                                     USBD_MSC_COMM  *p_comm)
 {
@@ -1763,14 +2360,14 @@ static  void  USBD_MSC_SCSI_TxData (USBD_MSC_CTRL  *p_ctrl,
     CPU_SR_ALLOC();
 
 
-    scsi_buf_len = DEF_MIN(p_comm->BytesToXfer, USBD_MSC_CFG_DATA_LEN);
+    scsi_buf_len = DEF_MIN(p_comm->BytesToXfer, p_ctrl->DataBufLen);
 
     while (scsi_buf_len > 0) {
 
         USBD_MSC_SCSI_Rd(p_ctrl, p_comm);
         p_comm->BytesToXfer         -= scsi_buf_len;            /* Update remaining bytes to transmit.                  */
         p_comm->CSW.dCSWDataResidue -= scsi_buf_len;            /* Update CSW data residue field.                       */
-        scsi_buf_len = DEF_MIN(p_comm->BytesToXfer, USBD_MSC_CFG_DATA_LEN);
+        scsi_buf_len = DEF_MIN(p_comm->BytesToXfer, p_ctrl->DataBufLen);
     }
     if (p_comm->Stall == DEF_TRUE) {
         p_comm->Stall = DEF_FALSE;
@@ -1787,6 +2384,7 @@ static  void  USBD_MSC_SCSI_TxData (USBD_MSC_CTRL  *p_ctrl,
         CPU_CRITICAL_EXIT();
     }
 }
+#endif
 
 
 /*
@@ -1800,31 +2398,47 @@ static  void  USBD_MSC_SCSI_TxData (USBD_MSC_CTRL  *p_ctrl,
 *
 * Return(s)   : None.
 *
-* Note(s)     : None.
+* Note(s)     : (1) If zero-copy is enabled & the storage layer provides a direct pointer to its data,
+*                   the data is sent from that pointer. Otherwise, it is read in the MSC data buffer.
 **********************************************************************************************************
 */
 
+#if (USBD_MSC_CFG_DATA_BUF_NBR == 1u)
 static  void  USBD_MSC_SCSI_Rd (USBD_MSC_CTRL  *p_ctrl,
                                 USBD_MSC_COMM  *p_comm)
 {
-    CPU_INT32U  scsi_ret_len;
-    CPU_INT32U  scsi_buf_len;
-    CPU_INT08U  lun;
-    USBD_ERR    err;
-    USBD_ERR    stall_err;
+    CPU_INT32U   scsi_ret_len;
+    CPU_INT32U   scsi_buf_len;
+    CPU_INT08U   lun;
+    CPU_INT08U  *p_buf;
+    USBD_ERR     err;
+    USBD_ERR     stall_err;
     CPU_SR_ALLOC();
 
 
     CPU_CRITICAL_ENTER();
-    scsi_buf_len = DEF_MIN(p_comm->BytesToXfer, USBD_MSC_CFG_DATA_LEN);
+    scsi_buf_len = DEF_MIN(p_comm->BytesToXfer, p_ctrl->DataBufLen);
     lun = p_comm->CBW.bCBWLUN;
     CPU_CRITICAL_EXIT();
-    USBD_SCSI_DataRd(&p_ctrl->Lun[lun],                         /* Rd data from the SCSI.                               */
-                      p_comm->CBW.CBWCB[0],
-                      p_ctrl->DataBufPtr,
-                      scsi_buf_len,
-                     &scsi_ret_len,
-                     &err);
+
+    p_buf = p_ctrl->DataBufPtr;
+    err   = USBD_ERR_SCSI_NO_DIRECT_BUF;
+#if (USBD_MSC_CFG_ZERO_COPY_EN == DEF_ENABLED)
+    USBD_SCSI_DataRdPtrGet(&p_ctrl->Lun[lun],                   /* Get ptr to sto data (see Note #1).                   */
+                            p_comm->CBW.CBWCB[0],
+                            scsi_buf_len,
+                           &p_buf,
+                           &scsi_ret_len,
+                           &err);
+#endif
+    if (err == USBD_ERR_SCSI_NO_DIRECT_BUF) {
+        USBD_SCSI_DataRd(&p_ctrl->Lun[lun],                     /* Rd data from the SCSI.                               */
+                          p_comm->CBW.CBWCB[0],
+                          p_buf,
+                          scsi_buf_len,
+                         &scsi_ret_len,
+                         &err);
+    }
     if ((err != USBD_ERR_NONE) &&
         (err != USBD_ERR_SCSI_MORE_DATA)) {
         CPU_CRITICAL_ENTER();
@@ -1837,7 +2451,7 @@ static  void  USBD_MSC_SCSI_Rd (USBD_MSC_CTRL  *p_ctrl,
     } else {
         (void)USBD_BulkTx(p_ctrl->DevNbr,                       /* Tx data to the host.                                 */
                           p_comm->DataBulkInEpAddr,
-                          p_ctrl->DataBufPtr,
+                          p_buf,
                           scsi_ret_len,
                           0,
                           DEF_NO,
@@ -1851,6 +2465,7 @@ static  void  USBD_MSC_SCSI_Rd (USBD_MSC_CTRL  *p_ctrl,
         }
     }
 }
+#endif
 
 
 /*
@@ -1916,29 +2531,48 @@ static  void  USBD_MSC_SCSI_Wr (const USBD_MSC_CTRL  *p_ctrl,
 *
 * Return(s)   : None.
 *
-* Note(s)     : None.
+* Note(s)     : (1) If zero-copy is enabled & the storage layer provides a direct pointer to its data,
+*                   the data is received at that location. Otherwise, it is received in the MSC data
+*                   buffer. In both cases, the write is completed by USBD_MSC_SCSI_Wr().
 **********************************************************************************************************
 */
 
+#if ((USBD_MSC_CFG_DATA_BUF_NBR  == 1u) || \
+     (USBD_MSC_CFG_ZERO_COPY_EN == DEF_ENABLED))
 static  void  USBD_MSC_SCSI_RxData (USBD_MSC_CTRL  *p_ctrl,
                                     USBD_MSC_COMM  *p_comm)
 {
     CPU_INT32U      scsi_buf_len;
     CPU_INT32U      xfer_len;
+    CPU_INT08U     *p_buf;
+#if (USBD_MSC_CFG_ZERO_COPY_EN == DEF_ENABLED)
+    CPU_INT08U     *p_direct_buf;
+#endif
     USBD_ERR        err;
     USBD_ERR        stall_err;
     CPU_SR_ALLOC();
 
 
     CPU_CRITICAL_ENTER();
-    scsi_buf_len = DEF_MIN(p_comm->BytesToXfer, USBD_MSC_CFG_DATA_LEN);
+    scsi_buf_len = DEF_MIN(p_comm->BytesToXfer, p_ctrl->DataBufLen);
     CPU_CRITICAL_EXIT();
 
     while (scsi_buf_len > 0){
         USBD_DBG_MSC_ARG("MSC: Rx Data Len:", scsi_buf_len);
+        p_buf = p_ctrl->DataBufPtr;
+#if (USBD_MSC_CFG_ZERO_COPY_EN == DEF_ENABLED)
+        USBD_SCSI_DataWrPtrGet(&p_ctrl->Lun[p_comm->CBW.bCBWLUN],
+                                p_comm->CBW.CBWCB[0],
+                                scsi_buf_len,
+                               &p_direct_buf,
+                               &err);
+        if (err == USBD_ERR_NONE) {                             /* See Note #1.                                         */
+            p_buf = p_direct_buf;
+        }
+#endif
         xfer_len = USBD_BulkRx(p_ctrl->DevNbr,                  /* Rx data from host on bulk-OUT pipe                   */
                                p_comm->DataBulkOutEpAddr,
-                               p_ctrl->DataBufPtr,
+                               p_buf,
                                scsi_buf_len,
                                0,
                               &err);
@@ -1954,10 +2588,10 @@ static  void  USBD_MSC_SCSI_RxData (USBD_MSC_CTRL  *p_ctrl,
 
         } else {
                                                                 /* Process rx data if no err.                           */
-            USBD_MSC_SCSI_Wr(p_ctrl, p_comm, p_ctrl->DataBufPtr, xfer_len);
+            USBD_MSC_SCSI_Wr(p_ctrl, p_comm, p_buf, xfer_len);
             p_comm->BytesToXfer         -= xfer_len;
             p_comm->CSW.dCSWDataResidue -= xfer_len;
-            scsi_buf_len = DEF_MIN(p_comm->BytesToXfer, USBD_MSC_CFG_DATA_LEN);
+            scsi_buf_len = DEF_MIN(p_comm->BytesToXfer, p_ctrl->DataBufLen);
         }
     }
 
@@ -1976,196 +2610,2400 @@ static  void  USBD_MSC_SCSI_RxData (USBD_MSC_CTRL  *p_ctrl,
     p_comm->NextCommState = USBD_MSC_COMM_STATE_CSW;
     CPU_CRITICAL_EXIT();
 }
+#endif
 
 
 /*
 **********************************************************************************************************
-*                                             USBD_MSC_TxCSW()
+*                                         USBD_MSC_SCSI_TxDataPipe()
 *
-* Description : Send status CSW to the host.
+* Description : Reads data from the SCSI and transmits it to the host, overlapping the storage reads with
+*               the bulk-IN transfers.
 *
-* Argument(s) : class_nbr   MSC instance number.
+* Argument(s) : p_ctrl      Pointer to MSC instance control structure.
 *
-*               p_err       Pointer to variable that will receive the return error code from this function :
+*               p_comm      Pointer to MSC communication information.
 *
-*                               USBD_ERR_NONE, if device sends status successfully.
+* Return(s)   : None.
 *
-*                                                               ------ RETURNED BY USBD_BulkTx() : ------
-*                               USBD_ERR_DEV_INVALID_NBR        Invalid device number.
-*                               USBD_ERR_EP_INVALID_NBR         Invalid endpoint number.
-*                               USBD_ERR_DEV_INVALID_STATE      Bulk transfer can ONLY be used after the
-*                                                                   device is in configured state.
-*                               USBD_ERR_EP_INVALID_TYPE        Invalid endpoint type.
+* Note(s)     : (1) The data buffers are used in turn. While up to (USBD_MSC_CFG_DATA_BUF_NBR - 1)
+*                   buffers are queued on the bulk-IN endpoint, the next one is read from the storage.
 *
-* Return(s)   : None.
+*               (2) If the endpoint cannot queue another transfer, the number of queued transfers is
+*                   limited to the current one for the rest of the data stage. The buffer already read
+*                   is queued once the oldest transfer completes.
 *
-* Note(s)     : None.
+*               (3) If the storage layer can read the logical unit asynchronously, the storage reads are
+*                   started ahead of the bulk-IN transfers by USBD_MSC_SCSI_TxDataAsync().
 **********************************************************************************************************
 */
 
-static  void  USBD_MSC_TxCSW  (USBD_MSC_CTRL  *p_ctrl,
-                               USBD_MSC_COMM  *p_comm,
-                               USBD_ERR       *p_err)
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+static  void  USBD_MSC_SCSI_TxDataPipe (USBD_MSC_CTRL  *p_ctrl,
+                                        USBD_MSC_COMM  *p_comm)
 {
-    USBD_ERR  stall_err;
+    CPU_INT32U    bytes_rem;
+    CPU_INT32U    scsi_buf_len;
+    CPU_INT32U    scsi_ret_len;
+    CPU_INT08U    lun;
+    CPU_INT08U    buf_ix;
+    CPU_INT08U    cmpl_ix;
+    CPU_INT08U    xfer_cnt;
+    CPU_INT08U    xfer_max;
+    CPU_INT08U   *p_buf;
+    CPU_BOOLEAN   buf_rdy;
+    CPU_BOOLEAN   abort;
+#if (USBD_MSC_CFG_STORAGE_ASYNC_EN == DEF_ENABLED)
+    CPU_INT08U    q_depth;
+#endif
+    USBD_ERR      err;
+    USBD_ERR      stall_err;
     CPU_SR_ALLOC();
 
 
-    CPU_CRITICAL_ENTER();
-    p_comm->CSW.dCSWSignature = USBD_MSC_SIG_CSW;               /* Set CSW signature and rcvd tag from CBW.             */
-    p_comm->CSW.dCSWTag       = p_comm->CBW.dCBWTag;
+    lun          = p_comm->CBW.bCBWLUN;
+#if (USBD_MSC_CFG_STORAGE_ASYNC_EN == DEF_ENABLED)
+    q_depth      = USBD_SCSI_AsyncQDepthGet(&p_ctrl->Lun[lun], p_comm->CBW.CBWCB[0]);
+    if (q_depth > 0u) {                                         /* See Note #3.                                         */
+        USBD_MSC_SCSI_TxDataAsync(p_ctrl, p_comm, q_depth);
+        return;
+    }
+#endif
+    bytes_rem    = p_comm->BytesToXfer;
+    scsi_buf_len = 0u;
+    scsi_ret_len = 0u;
+    buf_ix       = 0u;
+    cmpl_ix      = 0u;
+    xfer_cnt     = 0u;
+    xfer_max     = USBD_MSC_CFG_DATA_BUF_NBR - 1u;
+    p_buf        = p_ctrl->DataBufTbl[0u];
+    buf_rdy      = DEF_NO;
+    abort        = DEF_NO;
+
+    p_ctrl->DataCmplIx = 0u;
+
+    while ((bytes_rem > 0u) ||
+           (xfer_cnt  > 0u)) {
+
+        if ((bytes_rem > 0u) &&                                 /* Rd & queue next buf (see Note #1).                   */
+            (xfer_cnt  < xfer_max)) {
+            if (buf_rdy == DEF_NO) {
+                scsi_buf_len = DEF_MIN(bytes_rem, p_ctrl->DataBufLen);
+                p_buf        = p_ctrl->DataBufTbl[buf_ix];
+                err          = USBD_ERR_SCSI_NO_DIRECT_BUF;
+#if (USBD_MSC_CFG_ZERO_COPY_EN == DEF_ENABLED)
+                USBD_SCSI_DataRdPtrGet(&p_ctrl->Lun[lun],
+                                        p_comm->CBW.CBWCB[0],
+                                        scsi_buf_len,
+                                       &p_buf,
+                                       &scsi_ret_len,
+                                       &err);
+#endif
+                if (err == USBD_ERR_SCSI_NO_DIRECT_BUF) {
+                    USBD_SCSI_DataRd(&p_ctrl->Lun[lun],         /* Rd data from the SCSI.                               */
+                                      p_comm->CBW.CBWCB[0],
+                                      p_buf,
+                                      scsi_buf_len,
+                                     &scsi_ret_len,
+                                     &err);
+                }
+                if ((err != USBD_ERR_NONE) &&
+                    (err != USBD_ERR_SCSI_MORE_DATA)) {
+                    CPU_CRITICAL_ENTER();
+                    p_comm->CSW.bCSWStatus = (CPU_INT08U)USBD_MSC_BCSWSTATUS_CMD_FAILED;
+                    CPU_CRITICAL_EXIT();
+                    abort     = DEF_YES;
+                    bytes_rem = 0u;
+                    continue;
+                }
+                buf_rdy = DEF_YES;
+            }
 
-    USBD_MSC_CSW_Fmt(        &p_comm->CSW,                      /* Wr CSW to raw buf.                                   */
-                     (void *) p_ctrl->CSW_BufPtr);
-    CPU_CRITICAL_EXIT();
-                                                                /* Tx CSW to host through bulk-IN pipe.                 */
-    (void)USBD_BulkTx(p_ctrl->DevNbr,
-                      p_comm->DataBulkInEpAddr,
-                      p_ctrl->CSW_BufPtr,
-                      USBD_MSC_LEN_CSW,
-                      0,
-                      DEF_NO,
-                      p_err);
-    if (*p_err != USBD_ERR_NONE){                               /* Enter reset recovery state.                          */
-        CPU_CRITICAL_ENTER();
+            USBD_BulkTxAsync(p_ctrl->DevNbr,                    /* Tx data to the host.                                 */
+                             p_comm->DataBulkInEpAddr,
+                             p_buf,
+                             scsi_ret_len,
+                             USBD_MSC_DataXferCmpl,
+                      (void *)p_ctrl,
+                             DEF_NO,
+                            &err);
+            if (err == USBD_ERR_NONE) {
+                buf_rdy    = DEF_NO;
+                buf_ix     = (buf_ix + 1u) % USBD_MSC_CFG_DATA_BUF_NBR;
+                bytes_rem -= scsi_buf_len;
+                xfer_cnt++;
+
+            } else if ((err      == USBD_ERR_EP_QUEUING) &&
+                       (xfer_cnt >  0u)) {
+                xfer_max = xfer_cnt;                            /* See Note #2.                                         */
+
+            } else {
+                abort     = DEF_YES;
+                bytes_rem = 0u;
+            }
+
+        } else {                                                /* Wait for oldest xfer to free its buf.                */
+            (void)USBD_MSC_DataXferWait(p_ctrl, p_comm, cmpl_ix, &err);
+            if (err != USBD_ERR_NONE) {
+                abort     = DEF_YES;
+                bytes_rem = 0u;
+            }
+            cmpl_ix = (cmpl_ix + 1u) % USBD_MSC_CFG_DATA_BUF_NBR;
+            xfer_cnt--;
+        }
+    }
+
+    if ((abort         == DEF_YES) ||
+        (p_comm->Stall == DEF_TRUE)) {
+        p_comm->Stall = DEF_FALSE;
+
+        CPU_CRITICAL_ENTER();                                   /* Set the next state to bulk-IN stall.                 */
         p_comm->NextCommState = USBD_MSC_COMM_STATE_BULK_IN_STALL;
         CPU_CRITICAL_EXIT();
 
-        USBD_DBG_MSC_MSG("MSC: TxCSW, Stall IN");
         USBD_EP_Stall(p_ctrl->DevNbr, p_comm->DataBulkInEpAddr, DEF_SET, &stall_err);
 
     } else {
-        if (p_comm->CSW.bCSWStatus == USBD_MSC_BCSWSTATUS_PHASE_ERROR){
-            CPU_CRITICAL_ENTER();
-            p_comm->NextCommState = USBD_MSC_COMM_STATE_RESET_RECOVERY;
-            CPU_CRITICAL_EXIT();
-        } else {
-            CPU_CRITICAL_ENTER();                               /* Enter rx CBW state.                                  */
-            p_comm->NextCommState =  USBD_MSC_COMM_STATE_CBW;
-            CPU_CRITICAL_EXIT();
-        }
+        CPU_CRITICAL_ENTER();                                   /* Set the next state to tx CSW.                        */
+        p_comm->NextCommState = USBD_MSC_COMM_STATE_CSW;
+        CPU_CRITICAL_EXIT();
     }
 }
+#endif
 
 
 /*
 **********************************************************************************************************
-*                                             USBD_MSC_RxCBW()
+*                                         USBD_MSC_SCSI_RxDataPipe()
 *
-* Description : Receive CBW from the host.
+* Description : Receives data from the host and writes it to the SCSI, overlapping the storage writes
+*               with the bulk-OUT transfers.
 *
-* Argument(s) : class_nbr   MSC instance number.
+* Argument(s) : p_ctrl      Pointer to MSC instance control structure.
 *
-*               p_err       Pointer to variable that will receive the return error code from this function :
-*                               USBD_ERR_NONE                   CBW successfully received from host
-
-*                                                               ------ RETURNED BY USBD_BulkRx() : ------
-*                               USBD_ERR_DEV_INVALID_NBR        Invalid device number.
-*                               USBD_ERR_EP_INVALID_NBR         Invalid endpoint number.
-*                               USBD_ERR_DEV_INVALID_STATE      Bulk transfer can ONLY be used after the
-*                                                                   device is in configured state.
-*                               USBD_ERR_EP_INVALID_TYPE        Invalid endpoint type.
+*               p_comm      Pointer to MSC communication information.
 *
 * Return(s)   : None.
 *
-* Note(s)     : None.
+* Note(s)     : (1) The data buffers are used in turn. While a received buffer is written to the storage,
+*                   up to (USBD_MSC_CFG_DATA_BUF_NBR - 1) other buffers are queued on the bulk-OUT
+*                   endpoint.
+*
+*               (2) If the endpoint cannot queue another transfer, the number of queued transfers is
+*                   limited to the current one for the rest of the data stage.
+*
+*               (3) If the storage layer provides a direct pointer to its data, the data is received
+*                   in place and there is no storage access to overlap. USBD_MSC_SCSI_RxData() is used.
+*
+*               (4) If the storage layer can write the logical unit asynchronously, several storage writes
+*                   are kept in progress by USBD_MSC_SCSI_RxDataAsync().
 **********************************************************************************************************
 */
 
-static  void  USBD_MSC_RxCBW (USBD_MSC_CTRL  *p_ctrl,
-                              USBD_MSC_COMM  *p_comm,
-                              USBD_ERR       *p_err)
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+static  void  USBD_MSC_SCSI_RxDataPipe (USBD_MSC_CTRL  *p_ctrl,
+                                        USBD_MSC_COMM  *p_comm)
 {
-    USBD_ERR    err;
-    USBD_ERR    stall_err;
-    CPU_INT32U  xfer_len;
+    CPU_INT32U    bytes_rem;
+    CPU_INT32U    scsi_buf_len;
+    CPU_INT32U    wr_len;
+    CPU_INT08U    buf_ix;
+    CPU_INT08U    cmpl_ix;
+    CPU_INT08U    wr_ix;
+    CPU_INT08U    xfer_cnt;
+    CPU_INT08U    xfer_max;
+    CPU_BOOLEAN   wr_pend;
+    CPU_BOOLEAN   abort;
+#if (USBD_MSC_CFG_ZERO_COPY_EN == DEF_ENABLED)
+    CPU_INT08U   *p_direct_buf;
+#endif
+#if (USBD_MSC_CFG_STORAGE_ASYNC_EN == DEF_ENABLED)
+    CPU_INT08U    q_depth;
+#endif
+    USBD_ERR      err;
+    USBD_ERR      stall_err;
     CPU_SR_ALLOC();
 
 
-    xfer_len = USBD_BulkRx (p_ctrl->DevNbr,                     /*Rx CBW and returns xfer_len upon success.             */
-                            p_comm->DataBulkOutEpAddr,
-                            p_ctrl->CBW_BufPtr,
-                            USBD_MSC_LEN_CBW,
-                            0,
-                            p_err);
+#if (USBD_MSC_CFG_ZERO_COPY_EN == DEF_ENABLED)
+    USBD_SCSI_DataWrPtrGet(&p_ctrl->Lun[p_comm->CBW.bCBWLUN],
+                            p_comm->CBW.CBWCB[0],
+                            DEF_MIN(p_comm->BytesToXfer, p_ctrl->DataBufLen),
+                           &p_direct_buf,
+                           &err);
+    if (err == USBD_ERR_NONE) {                                 /* See Note #3.                                         */
+        USBD_MSC_SCSI_RxData(p_ctrl, p_comm);
+        return;
+    }
+#endif
+#if (USBD_MSC_CFG_STORAGE_ASYNC_EN == DEF_ENABLED)
+    q_depth = USBD_SCSI_AsyncQDepthGet(&p_ctrl->Lun[p_comm->CBW.bCBWLUN], p_comm->CBW.CBWCB[0]);
+    if (q_depth > 0u) {                                         /* See Note #4.                                         */
+        USBD_MSC_SCSI_RxDataAsync(p_ctrl, p_comm, q_depth);
+        return;
+    }
+#endif
 
-    USBD_DBG_MSC_ARG("MSC: RxCBW", xfer_len);
+    bytes_rem = p_comm->BytesToXfer;
+    wr_len    = 0u;
+    buf_ix    = 0u;
+    cmpl_ix   = 0u;
+    wr_ix     = 0u;
+    xfer_cnt  = 0u;
+    xfer_max  = USBD_MSC_CFG_DATA_BUF_NBR - 1u;
+    wr_pend   = DEF_NO;
+    abort     = DEF_NO;
+
+    p_ctrl->DataCmplIx = 0u;
+
+    do {
+        while ((bytes_rem > 0u) &&                              /* Queue rx in free bufs (see Note #1).                 */
+               (xfer_cnt  < xfer_max)) {
+            scsi_buf_len = DEF_MIN(bytes_rem, p_ctrl->DataBufLen);
+            USBD_DBG_MSC_ARG("MSC: Rx Data Len:", scsi_buf_len);
+            USBD_BulkRxAsync(p_ctrl->DevNbr,                    /* Rx data from host on bulk-OUT pipe.                  */
+                             p_comm->DataBulkOutEpAddr,
+                             p_ctrl->DataBufTbl[buf_ix],
+                             scsi_buf_len,
+                             USBD_MSC_DataXferCmpl,
+                      (void *)p_ctrl,
+                            &err);
+            if (err == USBD_ERR_NONE) {
+                buf_ix     = (buf_ix + 1u) % USBD_MSC_CFG_DATA_BUF_NBR;
+                bytes_rem -= scsi_buf_len;
+                xfer_cnt++;
+
+            } else if ((err      == USBD_ERR_EP_QUEUING) &&
+                       (xfer_cnt >  0u)) {
+                xfer_max = xfer_cnt;                            /* See Note #2.                                         */
 
-    switch (*p_err) {
-        case USBD_ERR_NONE:
-             break;
+            } else {
+                abort     = DEF_YES;
+                bytes_rem = 0u;
+            }
+        }
 
-        case USBD_ERR_DEV_INVALID_NBR:
-        case USBD_ERR_DEV_INVALID_STATE:
-        case USBD_ERR_OS_ABORT:
-        case USBD_ERR_EP_INVALID_ADDR:
-        case USBD_ERR_EP_INVALID_STATE:
-        case USBD_ERR_EP_INVALID_TYPE:
-             CPU_CRITICAL_ENTER();
-             if (p_ctrl->State == USBD_MSC_STATE_CFG){
-                p_comm->NextCommState = USBD_MSC_COMM_STATE_CBW;
-             }
-             CPU_CRITICAL_EXIT();
-             USBD_DBG_MSC_MSG("MSC: RxCBW, OS Abort");
-             break;
+        if (wr_pend == DEF_YES) {                               /* Wr rx'd buf while next bufs are being rx'd.          */
+            USBD_MSC_SCSI_Wr(p_ctrl, p_comm, p_ctrl->DataBufTbl[wr_ix], wr_len);
+            wr_pend = DEF_NO;
+            if (p_comm->NextCommState == USBD_MSC_COMM_STATE_BULK_OUT_STALL) {
+                abort     = DEF_YES;                            /* Bulk-OUT stalled by SCSI wr err.                     */
+                bytes_rem = 0u;
+            }
+        }
 
-        case USBD_ERR_OS_TIMEOUT:
-             CPU_CRITICAL_ENTER();
-             if (p_ctrl->State == USBD_MSC_STATE_CFG){
-                p_comm->NextCommState = USBD_MSC_COMM_STATE_CBW;
-             }
-             CPU_CRITICAL_EXIT();
-             USBD_DBG_MSC_MSG("MSC: RxCBW, OS Timeout");
-             break;
+        if (xfer_cnt > 0u) {                                    /* Wait for oldest rx to cmpl.                          */
+            wr_len = USBD_MSC_DataXferWait(p_ctrl, p_comm, cmpl_ix, &err);
+            if (err != USBD_ERR_NONE) {
+                abort     = DEF_YES;
+                bytes_rem = 0u;
+            } else if (abort == DEF_NO) {
+                wr_ix   = cmpl_ix;
+                wr_pend = DEF_YES;
+            } else {
+                                                                /* Discard data rx'd after an err.                      */
+            }
+            cmpl_ix = (cmpl_ix + 1u) % USBD_MSC_CFG_DATA_BUF_NBR;
+            xfer_cnt--;
+        }
+    } while ((xfer_cnt > 0u) ||
+             (wr_pend  == DEF_YES));
 
-        case USBD_ERR_EP_ABORT:
-        case USBD_ERR_RX:
-        case USBD_ERR_DRV_BUF_OVERFLOW:
-            CPU_CRITICAL_ENTER();
-            p_comm->NextCommState = USBD_MSC_COMM_STATE_RESET_RECOVERY_BULK_IN_STALL;
-            CPU_CRITICAL_EXIT();
-            USBD_DBG_MSC_MSG("MSC: RxCBW, Stall IN/OUT");
-            USBD_EP_Stall(p_ctrl->DevNbr, p_comm->DataBulkInEpAddr, DEF_SET, &stall_err);
-            USBD_EP_Stall(p_ctrl->DevNbr, p_comm->DataBulkOutEpAddr, DEF_SET, &stall_err);
-            break;
+    if (p_comm->NextCommState == USBD_MSC_COMM_STATE_BULK_OUT_STALL) {
+        return;                                                 /* Bulk-OUT already stalled by USBD_MSC_SCSI_Wr().      */
+    }
 
-        case USBD_ERR_OS_FAIL:
-        case USBD_ERR_NULL_PTR:
-        case USBD_ERR_EP_IO_PENDING:
-        case USBD_ERR_EP_QUEUING:
-        case USBD_ERR_DRV_INVALID_PKT:
-        default:
-            CPU_CRITICAL_ENTER();
-            p_comm->NextCommState = USBD_MSC_COMM_STATE_BULK_OUT_STALL;
-            CPU_CRITICAL_EXIT();
-            USBD_DBG_MSC_MSG("MSC: RxCBW, Stall OUT");
-            USBD_EP_Stall(p_ctrl->DevNbr, p_comm->DataBulkOutEpAddr, DEF_SET, &stall_err);
-            break;
+    if ((abort         == DEF_YES) ||
+        (p_comm->Stall == DEF_TRUE)) {
+        CPU_CRITICAL_ENTER();
+        p_comm->Stall = DEF_FALSE;                              /* Enter bulk-OUT stall state.                          */
+        p_comm->NextCommState = USBD_MSC_COMM_STATE_BULK_OUT_STALL;
+        CPU_CRITICAL_EXIT();
+
+        USBD_DBG_MSC_MSG("MSC: Rx Data, Stall OUT");
+        USBD_EP_Stall(p_ctrl->DevNbr, p_comm->DataBulkOutEpAddr, DEF_SET, &stall_err);
+        return;
     }
 
-    if (*p_err == USBD_ERR_NONE) {
-                                                                /* Verify that CBW is valid and meaningful.             */
-        USBD_MSC_CBW_Verify(p_ctrl, p_comm, p_ctrl->CBW_BufPtr, xfer_len, &err);
-        if (err != USBD_ERR_NONE) {                             /* Enter reset recovery state.                          */
-            CPU_CRITICAL_ENTER();
-            p_comm->NextCommState = USBD_MSC_COMM_STATE_RESET_RECOVERY_BULK_IN_STALL;
-            CPU_CRITICAL_EXIT();
+    CPU_CRITICAL_ENTER();                                       /* Enter tx CSW state.                                  */
+    p_comm->NextCommState = USBD_MSC_COMM_STATE_CSW;
+    CPU_CRITICAL_EXIT();
+}
+#endif
 
-            USBD_DBG_MSC_MSG("MSC: RxCBW, Stall IN/OUT");
 
-            USBD_EP_Stall(p_ctrl->DevNbr, p_comm->DataBulkInEpAddr, DEF_SET, &stall_err);
-            USBD_EP_Stall(p_ctrl->DevNbr, p_comm->DataBulkOutEpAddr, DEF_SET, &stall_err);
-            return;
+/*
+**********************************************************************************************************
+*                                          USBD_MSC_DataXferWait()
+*
+* Description : Wait for the completion of a pipelined data transfer.
+*
+* Argument(s) : p_ctrl      Pointer to MSC instance control structure.
+*
+*               p_comm      Pointer to MSC communication information.
+*
+*               xfer_ix     Index of the transfer to wait for.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE       Transfer successfully completed.
+*
+*                                                   ----- RETURNED BY USBD_MSC_OS_DataSignalPend() : -----
+*                               USBD_ERR_OS_TIMEOUT OS signal NOT successfully acquired in the time specified.
+*                               USBD_ERR_OS_ABORT   OS signal aborted.
+*                               USBD_ERR_OS_FAIL    OS signal not acquired because another error.
+*
+*                                                   ---- RETURNED BY USBD_MSC_DataXferCmpl() : ----
+*                               Any error returned by the asynchronous bulk transfer.
+*
+* Return(s)   : Number of octets transferred.
+*
+* Note(s)     : (1) Transfers on an endpoint complete in the order they were queued. Their results are
+*                   stored by USBD_MSC_DataXferCmpl() in the same order.
+**********************************************************************************************************
+*/
 
-        }
-        CPU_CRITICAL_ENTER();
-                                                                /* Host expected transfer length.                       */
-        p_comm->CSW.dCSWDataResidue = p_comm->CBW.dCBWDataTransferLength;
-        p_comm->BytesToXfer         = 0;
-        p_comm->NextCommState       = USBD_MSC_COMM_STATE_DATA; /* Enter data transport state.                          */
-        CPU_CRITICAL_EXIT();
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+static  CPU_INT32U  USBD_MSC_DataXferWait (USBD_MSC_CTRL  *p_ctrl,
+                                           USBD_MSC_COMM  *p_comm,
+                                           CPU_INT08U      xfer_ix,
+                                           USBD_ERR       *p_err)
+{
+    CPU_INT32U  xfer_len;
+
+
+    USBD_MSC_OS_DataSignalPend(p_ctrl->ClassNbr, 0u, p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return (0u);
+    }
+
+   *p_err    = p_ctrl->DataErrTbl[xfer_ix];                     /* See Note #1.                                         */
+    xfer_len = p_ctrl->DataLenTbl[xfer_ix];
+    if (*p_err == USBD_ERR_NONE) {
+        p_comm->BytesToXfer         -= xfer_len;                /* Update remaining bytes to xfer.                      */
+        p_comm->CSW.dCSWDataResidue -= xfer_len;                /* Update CSW data residue field.                       */
     }
+
+    return (xfer_len);
 }
+#endif
+
+
+/*
+**********************************************************************************************************
+*                                          USBD_MSC_DataXferCmpl()
+*
+* Description : Inform the MSC task about the completion of a pipelined data transfer.
+*
+* Argument(s) : dev_nbr     Device number.
+*
+*               ep_addr     Endpoint address.
+*
+*               p_buf       Pointer to the data buffer.
+*
+*               buf_len     Buffer length.
+*
+*               xfer_len    Number of octets transferred.
+*
+*               p_arg       Pointer to MSC instance control structure.
+*
+*               err         Transfer status.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) See USBD_MSC_DataXferWait() Note #1.
+**********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+static  void  USBD_MSC_DataXferCmpl (CPU_INT08U   dev_nbr,
+                                     CPU_INT08U   ep_addr,
+                                     void        *p_buf,
+                                     CPU_INT32U   buf_len,
+                                     CPU_INT32U   xfer_len,
+                                     void        *p_arg,
+                                     USBD_ERR     err)
+{
+    USBD_MSC_CTRL  *p_ctrl;
+    CPU_INT08U      xfer_ix;
+    USBD_ERR        os_err;
+
+
+    (void)dev_nbr;
+    (void)ep_addr;
+    (void)p_buf;
+    (void)buf_len;
+
+    p_ctrl  = (USBD_MSC_CTRL *)p_arg;
+    xfer_ix =  p_ctrl->DataCmplIx;                              /* See Note #1.                                         */
+
+    p_ctrl->DataLenTbl[xfer_ix] =  xfer_len;
+    p_ctrl->DataErrTbl[xfer_ix] =  err;
+    p_ctrl->DataCmplIx          = (xfer_ix + 1u) % USBD_MSC_CFG_DATA_BUF_NBR;
+
+    USBD_MSC_OS_DataSignalPost(p_ctrl->ClassNbr, &os_err);
+}
+#endif
+
+
+/*
+**********************************************************************************************************
+*                                         USBD_MSC_SCSI_TxDataAsync()
+*
+* Description : Reads data from the SCSI with asynchronous storage accesses and transmits it to the host.
+*
+* Argument(s) : p_ctrl      Pointer to MSC instance control structure.
+*
+*               p_comm      Pointer to MSC communication information.
+*
+*               q_depth     Maximum number of storage reads in progress.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The data buffers are used in turn. Each buffer is read from the storage, then queued on
+*                   the bulk-IN endpoint once its read completes. Up to 'q_depth' reads are in progress
+*                   while the buffers already read are transmitted, so that the storage medium and the
+*                   bulk-IN endpoint transfer data at the same time.
+*
+*               (2) The storage reads and the bulk-IN transfers both post the MSC data signal when they
+*                   complete. The signal is only pended when no completion is available, and the posts
+*                   that were not pended are consumed once every access completed. See also
+*                   USBD_MSC_SCSI_TxDataPipe() Note #2.
+*
+*               (3) Up to (USBD_MSC_CFG_DATA_BUF_NBR - 1) bulk-IN transfers are queued, so that the index
+*                   of the oldest transfer differs from the completion index until it completes.
+*
+*               (4) Reads still in progress after an error are waited for before the data stage ends, as
+*                   the storage layer is writing to the data buffers.
+**********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_STORAGE_ASYNC_EN == DEF_ENABLED)
+static  void  USBD_MSC_SCSI_TxDataAsync (USBD_MSC_CTRL  *p_ctrl,
+                                         USBD_MSC_COMM  *p_comm,
+                                         CPU_INT08U      q_depth)
+{
+    CPU_INT32U    rd_rem;
+    CPU_INT32U    tx_rem;
+    CPU_INT32U    scsi_buf_len;
+    CPU_INT32U    xfer_len;
+    CPU_INT32U    sto_cmpl;
+    CPU_INT32U    sig_cnt;
+    CPU_INT08U    lun;
+    CPU_INT08U    rd_ix;
+    CPU_INT08U    tx_ix;
+    CPU_INT08U    cmpl_ix;
+    CPU_INT08U    rd_cnt;
+    CPU_INT08U    xfer_cnt;
+    CPU_INT08U    xfer_max;
+    CPU_BOOLEAN   rd_done;
+    CPU_BOOLEAN   xfer_done;
+    CPU_BOOLEAN   abort;
+    USBD_ERR      err;
+    USBD_ERR      stall_err;
+    CPU_SR_ALLOC();
+
+
+    lun      = p_comm->CBW.bCBWLUN;
+    rd_rem   = p_comm->BytesToXfer;
+    tx_rem   = p_comm->BytesToXfer;
+    sto_cmpl = 0u;
+    sig_cnt  = 0u;
+    rd_ix    = 0u;
+    tx_ix    = 0u;
+    cmpl_ix  = 0u;
+    rd_cnt   = 0u;
+    xfer_cnt = 0u;
+    xfer_max = USBD_MSC_CFG_DATA_BUF_NBR - 1u;                  /* See Note #3.                                         */
+    abort    = DEF_NO;
+
+    CPU_CRITICAL_ENTER();
+    p_ctrl->DataCmplIx = 0u;
+    p_ctrl->StoCmplCnt = 0u;
+    CPU_CRITICAL_EXIT();
+
+    while ((rd_rem   > 0u) ||
+           (rd_cnt   > 0u) ||
+           (xfer_cnt > 0u)) {
+
+        CPU_CRITICAL_ENTER();
+        rd_done   = (p_ctrl->StoCmplCnt != sto_cmpl) ? DEF_YES : DEF_NO;
+        xfer_done = (p_ctrl->DataCmplIx != cmpl_ix)  ? DEF_YES : DEF_NO;
+        CPU_CRITICAL_EXIT();
+
+        if ((rd_rem            >  0u)      &&                   /* Start rd of next free buf (see Note #1).             */
+            (rd_cnt            <  q_depth) &&
+            (rd_cnt + xfer_cnt <  USBD_MSC_CFG_DATA_BUF_NBR)) {
+            scsi_buf_len = DEF_MIN(rd_rem, p_ctrl->DataBufLen);
+            USBD_SCSI_DataRdAsync(&p_ctrl->Lun[lun],
+                                   p_comm->CBW.CBWCB[0],
+                                   p_ctrl->DataBufTbl[rd_ix],
+                                   scsi_buf_len,
+                                   USBD_MSC_StorageCmpl,
+                            (void *)p_ctrl,
+                                  &err);
+            if ((err != USBD_ERR_NONE) &&
+                (err != USBD_ERR_SCSI_MORE_DATA)) {
+                CPU_CRITICAL_ENTER();
+                p_comm->CSW.bCSWStatus = (CPU_INT08U)USBD_MSC_BCSWSTATUS_CMD_FAILED;
+                CPU_CRITICAL_EXIT();
+                abort  = DEF_YES;
+                rd_rem = 0u;
+            } else {
+                rd_ix   = (rd_ix + 1u) % USBD_MSC_CFG_DATA_BUF_NBR;
+                rd_rem -= scsi_buf_len;
+                rd_cnt++;
+                sig_cnt++;
+            }
+
+        } else if ((rd_done == DEF_YES) &&                      /* Tx oldest buf rd.                                    */
+                   ((abort    == DEF_YES) ||
+                    (xfer_cnt <  xfer_max))) {
+            err = p_ctrl->StoErrTbl[sto_cmpl % USBD_MSC_CFG_DATA_BUF_NBR];
+            if (abort == DEF_NO) {
+                USBD_SCSI_DataAsyncCmpl(&p_ctrl->Lun[lun], err);
+                if (err != USBD_ERR_NONE) {
+                    CPU_CRITICAL_ENTER();
+                    p_comm->CSW.bCSWStatus = (CPU_INT08U)USBD_MSC_BCSWSTATUS_CMD_FAILED;
+                    CPU_CRITICAL_EXIT();
+                    abort  = DEF_YES;
+                    rd_rem = 0u;
+                }
+            }
+            if (abort == DEF_NO) {
+                xfer_len = DEF_MIN(tx_rem, p_ctrl->DataBufLen);
+                USBD_BulkTxAsync(p_ctrl->DevNbr,                /* Tx data to the host.                                 */
+                                 p_comm->DataBulkInEpAddr,
+                                 p_ctrl->DataBufTbl[tx_ix],
+                                 xfer_len,
+                                 USBD_MSC_DataXferCmpl,
+                          (void *)p_ctrl,
+                                 DEF_NO,
+                                &err);
+                if (err == USBD_ERR_NONE) {
+                    tx_rem -= xfer_len;
+                    xfer_cnt++;
+                    sig_cnt++;
+
+                } else if ((err      == USBD_ERR_EP_QUEUING) &&
+                           (xfer_cnt >  0u)) {
+                    xfer_max = xfer_cnt;                        /* See USBD_MSC_SCSI_TxDataPipe() Note #2.              */
+                    continue;                                   /* Buf is tx'd once oldest xfer completes.              */
+
+                } else {
+                    abort  = DEF_YES;
+                    rd_rem = 0u;
+                }
+            }
+            tx_ix = (tx_ix + 1u) % USBD_MSC_CFG_DATA_BUF_NBR;
+            sto_cmpl++;
+            rd_cnt--;
+
+        } else if (xfer_done == DEF_YES) {                      /* Free oldest buf tx'd.                                */
+            err      = p_ctrl->DataErrTbl[cmpl_ix];
+            xfer_len = p_ctrl->DataLenTbl[cmpl_ix];
+            if (err == USBD_ERR_NONE) {
+                p_comm->BytesToXfer         -= xfer_len;        /* Update remaining bytes to xfer.                      */
+                p_comm->CSW.dCSWDataResidue -= xfer_len;        /* Update CSW data residue field.                       */
+            } else {
+                abort  = DEF_YES;
+                rd_rem = 0u;
+            }
+            cmpl_ix = (cmpl_ix + 1u) % USBD_MSC_CFG_DATA_BUF_NBR;
+            xfer_cnt--;
+
+        } else {                                                /* Wait for next completion (see Note #2).              */
+            USBD_MSC_OS_DataSignalPend(p_ctrl->ClassNbr, 0u, &err);
+            if (err != USBD_ERR_NONE) {
+                abort = DEF_YES;
+                break;
+            }
+            sig_cnt--;
+        }
+    }
+
+    while ((rd_cnt   == 0u) &&                                  /* Consume remaining posts (see Note #2).               */
+           (xfer_cnt == 0u) &&
+           (sig_cnt  >  0u)) {
+        USBD_MSC_OS_DataSignalPend(p_ctrl->ClassNbr, 0u, &err);
+        if (err != USBD_ERR_NONE) {
+            break;
+        }
+        sig_cnt--;
+    }
+
+    if ((abort         == DEF_YES) ||
+        (p_comm->Stall == DEF_TRUE)) {
+        p_comm->Stall = DEF_FALSE;
+
+        CPU_CRITICAL_ENTER();                                   /* Set the next state to bulk-IN stall.                 */
+        p_comm->NextCommState = USBD_MSC_COMM_STATE_BULK_IN_STALL;
+        CPU_CRITICAL_EXIT();
+
+        USBD_EP_Stall(p_ctrl->DevNbr, p_comm->DataBulkInEpAddr, DEF_SET, &stall_err);
+
+    } else {
+        CPU_CRITICAL_ENTER();                                   /* Set the next state to tx CSW.                        */
+        p_comm->NextCommState = USBD_MSC_COMM_STATE_CSW;
+        CPU_CRITICAL_EXIT();
+    }
+}
+#endif
+
+
+/*
+**********************************************************************************************************
+*                                         USBD_MSC_SCSI_RxDataAsync()
+*
+* Description : Receives data from the host and writes it to the SCSI with asynchronous storage accesses.
+*
+* Argument(s) : p_ctrl      Pointer to MSC instance control structure.
+*
+*               p_comm      Pointer to MSC communication information.
+*
+*               q_depth     Maximum number of storage writes in progress.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The data buffers are used in turn. Each buffer is received on the bulk-OUT endpoint,
+*                   then written to the storage once its transfer completes. Up to 'q_depth' writes are in
+*                   progress while the next buffers are received, so that the storage medium and the
+*                   bulk-OUT endpoint transfer data at the same time.
+*
+*               (2) See USBD_MSC_SCSI_TxDataAsync() Notes #2, #3 & #4.
+*
+*               (3) A failed storage write fails the command and stalls the bulk-OUT endpoint, as
+*                   USBD_MSC_SCSI_Wr() does.
+**********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_STORAGE_ASYNC_EN == DEF_ENABLED)
+static  void  USBD_MSC_SCSI_RxDataAsync (USBD_MSC_CTRL  *p_ctrl,
+                                         USBD_MSC_COMM  *p_comm,
+                                         CPU_INT08U      q_depth)
+{
+    CPU_INT32U    rx_rem;
+    CPU_INT32U    scsi_buf_len;
+    CPU_INT32U    xfer_len;
+    CPU_INT32U    sto_cmpl;
+    CPU_INT32U    sig_cnt;
+    CPU_INT08U    lun;
+    CPU_INT08U    buf_ix;
+    CPU_INT08U    cmpl_ix;
+    CPU_INT08U    wr_cnt;
+    CPU_INT08U    xfer_cnt;
+    CPU_INT08U    xfer_max;
+    CPU_BOOLEAN   wr_done;
+    CPU_BOOLEAN   xfer_done;
+    CPU_BOOLEAN   abort;
+    USBD_ERR      err;
+    USBD_ERR      stall_err;
+    CPU_SR_ALLOC();
+
+
+    lun      = p_comm->CBW.bCBWLUN;
+    rx_rem   = p_comm->BytesToXfer;
+    sto_cmpl = 0u;
+    sig_cnt  = 0u;
+    buf_ix   = 0u;
+    cmpl_ix  = 0u;
+    wr_cnt   = 0u;
+    xfer_cnt = 0u;
+    xfer_max = USBD_MSC_CFG_DATA_BUF_NBR - 1u;
+    abort    = DEF_NO;
+
+    CPU_CRITICAL_ENTER();
+    p_ctrl->DataCmplIx = 0u;
+    p_ctrl->StoCmplCnt = 0u;
+    CPU_CRITICAL_EXIT();
+
+    while ((rx_rem   > 0u) ||
+           (xfer_cnt > 0u) ||
+           (wr_cnt   > 0u)) {
+
+        CPU_CRITICAL_ENTER();
+        wr_done   = (p_ctrl->StoCmplCnt != sto_cmpl) ? DEF_YES : DEF_NO;
+        xfer_done = (p_ctrl->DataCmplIx != cmpl_ix)  ? DEF_YES : DEF_NO;
+        CPU_CRITICAL_EXIT();
+
+        if ((rx_rem            >  0u)       &&                  /* Queue rx in next free buf (see Note #1).             */
+            (xfer_cnt          <  xfer_max) &&
+            (xfer_cnt + wr_cnt <  USBD_MSC_CFG_DATA_BUF_NBR)) {
+            scsi_buf_len = DEF_MIN(rx_rem, p_ctrl->DataBufLen);
+            USBD_DBG_MSC_ARG("MSC: Rx Data Len:", scsi_buf_len);
+            USBD_BulkRxAsync(p_ctrl->DevNbr,                    /* Rx data from host on bulk-OUT pipe.                  */
+                             p_comm->DataBulkOutEpAddr,
+                             p_ctrl->DataBufTbl[buf_ix],
+                             scsi_buf_len,
+                             USBD_MSC_DataXferCmpl,
+                      (void *)p_ctrl,
+                            &err);
+            if (err == USBD_ERR_NONE) {
+                buf_ix  = (buf_ix + 1u) % USBD_MSC_CFG_DATA_BUF_NBR;
+                rx_rem -= scsi_buf_len;
+                xfer_cnt++;
+                sig_cnt++;
+
+            } else if ((err      == USBD_ERR_EP_QUEUING) &&
+                       (xfer_cnt >  0u)) {
+                xfer_max = xfer_cnt;                            /* See USBD_MSC_SCSI_RxDataPipe() Note #2.              */
+
+            } else {
+                abort  = DEF_YES;
+                rx_rem = 0u;
+            }
+
+        } else if ((xfer_done == DEF_YES) &&                    /* Wr oldest buf rx'd.                                  */
+                   ((abort  == DEF_YES) ||
+                    (wr_cnt <  q_depth))) {
+            err      = p_ctrl->DataErrTbl[cmpl_ix];
+            xfer_len = p_ctrl->DataLenTbl[cmpl_ix];
+            if (err != USBD_ERR_NONE) {
+                abort  = DEF_YES;
+                rx_rem = 0u;
+            } else if (abort == DEF_NO) {
+                p_comm->BytesToXfer         -= xfer_len;        /* Update remaining bytes to xfer.                      */
+                p_comm->CSW.dCSWDataResidue -= xfer_len;        /* Update CSW data residue field.                       */
+
+                USBD_SCSI_DataWrAsync(&p_ctrl->Lun[lun],
+                                       p_comm->CBW.CBWCB[0],
+                                       p_ctrl->DataBufTbl[cmpl_ix],
+                                       xfer_len,
+                                       USBD_MSC_StorageCmpl,
+                                (void *)p_ctrl,
+                                      &err);
+                if ((err != USBD_ERR_NONE) &&
+                    (err != USBD_ERR_SCSI_MORE_DATA)) {
+                    CPU_CRITICAL_ENTER();                       /* See Note #3.                                         */
+                    p_comm->CSW.bCSWStatus = USBD_MSC_BCSWSTATUS_CMD_FAILED;
+                    CPU_CRITICAL_EXIT();
+                    abort  = DEF_YES;
+                    rx_rem = 0u;
+                } else {
+                    wr_cnt++;
+                    sig_cnt++;
+                }
+            } else {
+                                                                /* Discard data rx'd after an err.                      */
+            }
+            cmpl_ix = (cmpl_ix + 1u) % USBD_MSC_CFG_DATA_BUF_NBR;
+            xfer_cnt--;
+
+        } else if (wr_done == DEF_YES) {                        /* Free oldest buf wr.                                  */
+            err = p_ctrl->StoErrTbl[sto_cmpl % USBD_MSC_CFG_DATA_BUF_NBR];
+            if (abort == DEF_NO) {
+                USBD_SCSI_DataAsyncCmpl(&p_ctrl->Lun[lun], err);
+                if (err != USBD_ERR_NONE) {
+                    CPU_CRITICAL_ENTER();                       /* See Note #3.                                         */
+                    p_comm->CSW.bCSWStatus = USBD_MSC_BCSWSTATUS_CMD_FAILED;
+                    CPU_CRITICAL_EXIT();
+                    abort  = DEF_YES;
+                    rx_rem = 0u;
+                }
+            }
+            sto_cmpl++;
+            wr_cnt--;
+
+        } else {                                                /* Wait for next completion.                            */
+            USBD_MSC_OS_DataSignalPend(p_ctrl->ClassNbr, 0u, &err);
+            if (err != USBD_ERR_NONE) {
+                abort = DEF_YES;
+                break;
+            }
+            sig_cnt--;
+        }
+    }
+
+    while ((xfer_cnt == 0u) &&                                  /* Consume remaining posts.                             */
+           (wr_cnt   == 0u) &&
+           (sig_cnt  >  0u)) {
+        USBD_MSC_OS_DataSignalPend(p_ctrl->ClassNbr, 0u, &err);
+        if (err != USBD_ERR_NONE) {
+            break;
+        }
+        sig_cnt--;
+    }
+
+    if ((abort         == DEF_YES) ||
+        (p_comm->Stall == DEF_TRUE)) {
+        CPU_CRITICAL_ENTER();
+        p_comm->Stall = DEF_FALSE;                              /* Enter bulk-OUT stall state.                          */
+        p_comm->NextCommState = USBD_MSC_COMM_STATE_BULK_OUT_STALL;
+        CPU_CRITICAL_EXIT();
+
+        USBD_DBG_MSC_MSG("MSC: Rx Data, Stall OUT");
+        USBD_EP_Stall(p_ctrl->DevNbr, p_comm->DataBulkOutEpAddr, DEF_SET, &stall_err);
+        return;
+    }
+
+    CPU_CRITICAL_ENTER();                                       /* Enter tx CSW state.                                  */
+    p_comm->NextCommState = USBD_MSC_COMM_STATE_CSW;
+    CPU_CRITICAL_EXIT();
+}
+#endif
+
+
+/*
+**********************************************************************************************************
+*                                          USBD_MSC_StorageCmpl()
+*
+* Description : Inform the MSC task about the completion of an asynchronous storage access.
+*
+* Argument(s) : p_arg       Pointer to MSC instance control structure.
+*
+*               err         Storage access status.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The storage layer completes the accesses of a logical unit in the order they were
+*                   started (see USBD_StorageRdAsync() Note #2). Their results are stored in the same order.
+**********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_STORAGE_ASYNC_EN == DEF_ENABLED)
+static  void  USBD_MSC_StorageCmpl (void      *p_arg,
+                                    USBD_ERR   err)
+{
+    USBD_MSC_CTRL  *p_ctrl;
+    USBD_ERR        os_err;
+    CPU_SR_ALLOC();
+
+
+    p_ctrl = (USBD_MSC_CTRL *)p_arg;
+
+    CPU_CRITICAL_ENTER();                                       /* See Note #1.                                         */
+    p_ctrl->StoErrTbl[p_ctrl->StoCmplCnt % USBD_MSC_CFG_DATA_BUF_NBR] = err;
+    p_ctrl->StoCmplCnt++;
+    CPU_CRITICAL_EXIT();
+
+    USBD_MSC_OS_DataSignalPost(p_ctrl->ClassNbr, &os_err);
+}
+#endif
+
+
+/*
+**********************************************************************************************************
+*                                             USBD_MSC_TxCSW()
+*
+* Description : Send status CSW to the host.
+*
+* Argument(s) : class_nbr   MSC instance number.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE, if device sends status successfully.
+*
+*                                                               ------ RETURNED BY USBD_BulkTx() : ------
+*                               USBD_ERR_DEV_INVALID_NBR        Invalid device number.
+*                               USBD_ERR_EP_INVALID_NBR         Invalid endpoint number.
+*                               USBD_ERR_DEV_INVALID_STATE      Bulk transfer can ONLY be used after the
+*                                                                   device is in configured state.
+*                               USBD_ERR_EP_INVALID_TYPE        Invalid endpoint type.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Once the CSW of a successful command is sent, the blocks following a sequential READ
+*                   command are read ahead before the next CBW is received (see 'usbd_cfg.h', MSC Note #9).
+**********************************************************************************************************
+*/
+
+static  void  USBD_MSC_TxCSW  (USBD_MSC_CTRL  *p_ctrl,
+                               USBD_MSC_COMM  *p_comm,
+                               USBD_ERR       *p_err)
+{
+    USBD_ERR  stall_err;
+    CPU_SR_ALLOC();
+
+
+    CPU_CRITICAL_ENTER();
+    p_comm->CSW.dCSWSignature = USBD_MSC_SIG_CSW;               /* Set CSW signature and rcvd tag from CBW.             */
+    p_comm->CSW.dCSWTag       = p_comm->CBW.dCBWTag;
+
+    USBD_MSC_CSW_Fmt(        &p_comm->CSW,                      /* Wr CSW to raw buf.                                   */
+                     (void *) p_ctrl->CSW_BufPtr);
+    CPU_CRITICAL_EXIT();
+                                                                /* Tx CSW to host through bulk-IN pipe.                 */
+    (void)USBD_BulkTx(p_ctrl->DevNbr,
+                      p_comm->DataBulkInEpAddr,
+                      p_ctrl->CSW_BufPtr,
+                      USBD_MSC_LEN_CSW,
+                      0,
+                      DEF_NO,
+                      p_err);
+    if (*p_err != USBD_ERR_NONE){                               /* Enter reset recovery state.                          */
+        CPU_CRITICAL_ENTER();
+        p_comm->NextCommState = USBD_MSC_COMM_STATE_BULK_IN_STALL;
+        CPU_CRITICAL_EXIT();
+
+        USBD_DBG_MSC_MSG("MSC: TxCSW, Stall IN");
+        USBD_EP_Stall(p_ctrl->DevNbr, p_comm->DataBulkInEpAddr, DEF_SET, &stall_err);
+
+    } else {
+        if (p_comm->CSW.bCSWStatus == USBD_MSC_BCSWSTATUS_PHASE_ERROR){
+            CPU_CRITICAL_ENTER();
+            p_comm->NextCommState = USBD_MSC_COMM_STATE_RESET_RECOVERY;
+            CPU_CRITICAL_EXIT();
+        } else {
+            CPU_CRITICAL_ENTER();                               /* Enter rx CBW state.                                  */
+            p_comm->NextCommState =  USBD_MSC_COMM_STATE_CBW;
+            CPU_CRITICAL_EXIT();
+#if (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+            if (p_comm->CSW.bCSWStatus == USBD_MSC_BCSWSTATUS_CMD_PASSED) {
+                USBD_SCSI_RdAheadFill(&p_ctrl->Lun[p_comm->CBW.bCBWLUN]);
+            }                                                   /* See Note #1.                                         */
+#endif
+        }
+    }
+}
+
+
+/*
+**********************************************************************************************************
+*                                             USBD_MSC_RxCBW()
+*
+* Description : Receive CBW from the host.
+*
+* Argument(s) : class_nbr   MSC instance number.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*                               USBD_ERR_NONE                   CBW successfully received from host
+
+*                                                               ------ RETURNED BY USBD_BulkRx() : ------
+*                               USBD_ERR_DEV_INVALID_NBR        Invalid device number.
+*                               USBD_ERR_EP_INVALID_NBR         Invalid endpoint number.
+*                               USBD_ERR_DEV_INVALID_STATE      Bulk transfer can ONLY be used after the
+*                                                                   device is in configured state.
+*                               USBD_ERR_EP_INVALID_TYPE        Invalid endpoint type.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The bulk-only EPs are closed while the host switches to the UAS alternate setting.  The
+*                   task then waits for USBD_MSC_AltSettingUpdate() rather than retrying on a closed EP.
+**********************************************************************************************************
+*/
+
+static  void  USBD_MSC_RxCBW (USBD_MSC_CTRL  *p_ctrl,
+                              USBD_MSC_COMM  *p_comm,
+                              USBD_ERR       *p_err)
+{
+    USBD_ERR    err;
+    USBD_ERR    stall_err;
+    CPU_INT32U  xfer_len;
+    CPU_SR_ALLOC();
+
+
+    xfer_len = USBD_BulkRx (p_ctrl->DevNbr,                     /*Rx CBW and returns xfer_len upon success.             */
+                            p_comm->DataBulkOutEpAddr,
+                            p_ctrl->CBW_BufPtr,
+                            USBD_MSC_LEN_CBW,
+                            0,
+                            p_err);
+
+    USBD_DBG_MSC_ARG("MSC: RxCBW", xfer_len);
+
+    switch (*p_err) {
+        case USBD_ERR_NONE:
+             break;
+
+        case USBD_ERR_DEV_INVALID_NBR:
+        case USBD_ERR_DEV_INVALID_STATE:
+        case USBD_ERR_OS_ABORT:
+#if (USBD_MSC_CFG_UAS_EN == DEF_DISABLED)
+        case USBD_ERR_EP_INVALID_ADDR:
+        case USBD_ERR_EP_INVALID_STATE:
+#endif
+        case USBD_ERR_EP_INVALID_TYPE:
+             CPU_CRITICAL_ENTER();
+             if (p_ctrl->State == USBD_MSC_STATE_CFG){
+                p_comm->NextCommState = USBD_MSC_COMM_STATE_CBW;
+             }
+             CPU_CRITICAL_EXIT();
+             USBD_DBG_MSC_MSG("MSC: RxCBW, OS Abort");
+             break;
+
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+        case USBD_ERR_EP_INVALID_ADDR:                          /* See Note #1.                                         */
+        case USBD_ERR_EP_INVALID_STATE:
+             CPU_CRITICAL_ENTER();
+             if (p_ctrl->State == USBD_MSC_STATE_CFG){
+                p_comm->NextCommState = USBD_MSC_COMM_STATE_IF_ALT_WAIT;
+             }
+             CPU_CRITICAL_EXIT();
+             USBD_DBG_MSC_MSG("MSC: RxCBW, EP closed");
+             break;
+#endif
+
+        case USBD_ERR_OS_TIMEOUT:
+             CPU_CRITICAL_ENTER();
+             if (p_ctrl->State == USBD_MSC_STATE_CFG){
+                p_comm->NextCommState = USBD_MSC_COMM_STATE_CBW;
+             }
+             CPU_CRITICAL_EXIT();
+             USBD_DBG_MSC_MSG("MSC: RxCBW, OS Timeout");
+             break;
+
+        case USBD_ERR_EP_ABORT:
+        case USBD_ERR_RX:
+        case USBD_ERR_DRV_BUF_OVERFLOW:
+            CPU_CRITICAL_ENTER();
+            p_comm->NextCommState = USBD_MSC_COMM_STATE_RESET_RECOVERY_BULK_IN_STALL;
+            CPU_CRITICAL_EXIT();
+            USBD_DBG_MSC_MSG("MSC: RxCBW, Stall IN/OUT");
+            USBD_EP_Stall(p_ctrl->DevNbr, p_comm->DataBulkInEpAddr, DEF_SET, &stall_err);
+            USBD_EP_Stall(p_ctrl->DevNbr, p_comm->DataBulkOutEpAddr, DEF_SET, &stall_err);
+            break;
+
+        case USBD_ERR_OS_FAIL:
+        case USBD_ERR_NULL_PTR:
+        case USBD_ERR_EP_IO_PENDING:
+        case USBD_ERR_EP_QUEUING:
+        case USBD_ERR_DRV_INVALID_PKT:
+        default:
+            CPU_CRITICAL_ENTER();
+            p_comm->NextCommState = USBD_MSC_COMM_STATE_BULK_OUT_STALL;
+            CPU_CRITICAL_EXIT();
+            USBD_DBG_MSC_MSG("MSC: RxCBW, Stall OUT");
+            USBD_EP_Stall(p_ctrl->DevNbr, p_comm->DataBulkOutEpAddr, DEF_SET, &stall_err);
+            break;
+    }
+
+    if (*p_err == USBD_ERR_NONE) {
+                                                                /* Verify that CBW is valid and meaningful.             */
+        USBD_MSC_CBW_Verify(p_ctrl, p_comm, p_ctrl->CBW_BufPtr, xfer_len, &err);
+        if (err != USBD_ERR_NONE) {                             /* Enter reset recovery state.                          */
+            CPU_CRITICAL_ENTER();
+            p_comm->NextCommState = USBD_MSC_COMM_STATE_RESET_RECOVERY_BULK_IN_STALL;
+            CPU_CRITICAL_EXIT();
+
+            USBD_DBG_MSC_MSG("MSC: RxCBW, Stall IN/OUT");
+
+            USBD_EP_Stall(p_ctrl->DevNbr, p_comm->DataBulkInEpAddr, DEF_SET, &stall_err);
+            USBD_EP_Stall(p_ctrl->DevNbr, p_comm->DataBulkOutEpAddr, DEF_SET, &stall_err);
+            return;
+
+        }
+        CPU_CRITICAL_ENTER();
+                                                                /* Host expected transfer length.                       */
+        p_comm->CSW.dCSWDataResidue = p_comm->CBW.dCBWDataTransferLength;
+        p_comm->BytesToXfer         = 0;
+        p_comm->NextCommState       = USBD_MSC_COMM_STATE_DATA; /* Enter data transport state.                          */
+        CPU_CRITICAL_EXIT();
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_MSC_AltSettingUpdate()
+*
+* Description : Notify class that interface alternate setting has been updated.
+*
+* Argument(s) : dev_nbr             Device number.
+*
+*               cfg_nbr             Configuration number.
+*
+*               if_nbr              Interface number.
+*
+*               if_alt_nbr          Interface alternate setting number.
+*
+*               p_if_class_arg      Pointer to class argument specific to interface.
+*
+*               p_if_alt_class_arg  Pointer to class argument specific to alternate interface.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The core closes the EPs of the previous alternate setting before calling this function,
+*                   which aborts any transfer pending on them.  The bulk-only and UAS alternate settings
+*                   may share physical EPs, so the data EP addresses are switched to the new alternate
+*                   setting before the MSC task is woken up.
+*
+*               (2) The UAS task queue is emptied on every alternate setting change.  Commands queued
+*                   by the host on the previous alternate setting are implicitly aborted.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+static  void  USBD_MSC_AltSettingUpdate (CPU_INT08U   dev_nbr,
+                                         CPU_INT08U   cfg_nbr,
+                                         CPU_INT08U   if_nbr,
+                                         CPU_INT08U   if_alt_nbr,
+                                         void        *p_if_class_arg,
+                                         void        *p_if_alt_class_arg)
+{
+    USBD_MSC_COMM  *p_comm;
+    USBD_MSC_CTRL  *p_ctrl;
+    CPU_BOOLEAN     post_signal;
+    CPU_BOOLEAN     uas_active;
+    USBD_ERR        os_err;
+    CPU_SR_ALLOC();
+
+
+    (void)dev_nbr;
+    (void)cfg_nbr;
+    (void)if_nbr;
+    (void)p_if_alt_class_arg;
+
+    p_comm     = (USBD_MSC_COMM *)p_if_class_arg;
+    p_ctrl     =  p_comm->CtrlPtr;
+    uas_active = (if_alt_nbr == p_comm->UAS_AltNbr) ? DEF_YES : DEF_NO;
+
+    CPU_CRITICAL_ENTER();
+    switch (p_comm->NextCommState) {                            /* Wake up task if it waits on a closed EP.             */
+        case USBD_MSC_COMM_STATE_RESET_RECOVERY:
+        case USBD_MSC_COMM_STATE_RESET_RECOVERY_BULK_IN_STALL:
+        case USBD_MSC_COMM_STATE_RESET_RECOVERY_BULK_OUT_STALL:
+        case USBD_MSC_COMM_STATE_BULK_IN_STALL:
+        case USBD_MSC_COMM_STATE_BULK_OUT_STALL:
+        case USBD_MSC_COMM_STATE_IF_ALT_WAIT:
+        case USBD_MSC_COMM_STATE_UAS_WAIT:
+             post_signal = DEF_TRUE;
+             break;
+
+
+        case USBD_MSC_COMM_STATE_NONE:
+        case USBD_MSC_COMM_STATE_CBW:
+        case USBD_MSC_COMM_STATE_DATA:
+        case USBD_MSC_COMM_STATE_CSW:
+        case USBD_MSC_COMM_STATE_UAS:
+        default:
+             post_signal = DEF_FALSE;
+             break;
+    }
+
+    p_comm->UAS_Active    = uas_active;                         /* Switch data EPs (see Note #1).                       */
+    p_ctrl->UAS_TaskHead  = 0u;                                 /* Empty task queue (see Note #2).                      */
+    p_ctrl->UAS_TaskTail  = 0u;
+    p_ctrl->UAS_TaskCnt   = 0u;
+    p_ctrl->UAS_TaskExec  = DEF_NO;
+    p_ctrl->UAS_CmdRxPend = uas_active;
+    if (uas_active == DEF_YES) {
+        p_comm->DataBulkInEpAddr  = p_comm->UAS_DataInEpAddr;
+        p_comm->DataBulkOutEpAddr = p_comm->UAS_DataOutEpAddr;
+        p_comm->NextCommState     = USBD_MSC_COMM_STATE_UAS;
+    } else {
+        p_comm->DataBulkInEpAddr  = p_comm->BOT_BulkInEpAddr;
+        p_comm->DataBulkOutEpAddr = p_comm->BOT_BulkOutEpAddr;
+        p_comm->NextCommState     = USBD_MSC_COMM_STATE_CBW;
+    }
+    CPU_CRITICAL_EXIT();
+
+    if (uas_active == DEF_YES) {
+        USBD_MSC_UAS_CmdRxStart(p_ctrl, p_comm);                /* Wait for first IU on cmd pipe.                       */
+    }
+
+    if (post_signal == DEF_TRUE) {
+        USBD_MSC_OS_CommSignalPost(p_ctrl->ClassNbr, &os_err);
+    }
+
+    USBD_DBG_MSC_ARG("MSC: Alt Setting Update", if_alt_nbr);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_MSC_EP_Desc()
+*
+* Description : Class endpoint descriptor callback.
+*
+* Argument(s) : dev_nbr             Device number.
+*
+*               cfg_nbr             Configuration number.
+*
+*               if_nbr              Interface number.
+*
+*               if_alt_nbr          Interface alternate setting number.
+*
+*               ep_addr             Endpoint address.
+*
+*               p_if_class_arg      Pointer to class argument specific to interface.
+*
+*               p_if_alt_class_arg  Pointer to class argument specific to alternate interface.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Each endpoint of the UAS alternate setting is followed by a pipe usage descriptor :
+*
+*                   (a) bLength         = 4
+*                   (b) bDescriptorType = 0x24
+*                   (c) bPipeID         = Command, status, data-in or data-out pipe ID.
+*                   (d) Reserved        = 0
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+static  void  USBD_MSC_EP_Desc (CPU_INT08U   dev_nbr,
+                                CPU_INT08U   cfg_nbr,
+                                CPU_INT08U   if_nbr,
+                                CPU_INT08U   if_alt_nbr,
+                                CPU_INT08U   ep_addr,
+                                void        *p_if_class_arg,
+                                void        *p_if_alt_class_arg)
+{
+    USBD_MSC_COMM  *p_comm;
+    CPU_INT08U      pipe_id;
+
+
+    (void)cfg_nbr;
+    (void)if_nbr;
+    (void)p_if_alt_class_arg;
+
+    p_comm = (USBD_MSC_COMM *)p_if_class_arg;
+    if (if_alt_nbr != p_comm->UAS_AltNbr) {                     /* Bulk-only EPs have no functional desc.               */
+        return;
+    }
+
+    if (ep_addr == p_comm->UAS_CmdEpAddr) {
+        pipe_id = USBD_MSC_UAS_PIPE_ID_CMD;
+    } else if (ep_addr == p_comm->UAS_StatusEpAddr) {
+        pipe_id = USBD_MSC_UAS_PIPE_ID_STATUS;
+    } else if (ep_addr == p_comm->UAS_DataInEpAddr) {
+        pipe_id = USBD_MSC_UAS_PIPE_ID_DATA_IN;
+    } else {
+        pipe_id = USBD_MSC_UAS_PIPE_ID_DATA_OUT;
+    }
+                                                                /* Build pipe usage desc (see Note #1).                 */
+    USBD_DescWr08(dev_nbr, USBD_MSC_UAS_DESC_LEN_PIPE_USAGE);
+    USBD_DescWr08(dev_nbr, USBD_MSC_UAS_DESC_TYPE_PIPE_USAGE);
+    USBD_DescWr08(dev_nbr, pipe_id);
+    USBD_DescWr08(dev_nbr, 0u);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_MSC_EP_DescSizeGet()
+*
+* Description : Retrieve the size of the class endpoint descriptor.
+*
+* Argument(s) : dev_nbr             Device number.
+*
+*               cfg_nbr             Configuration number.
+*
+*               if_nbr              Interface number.
+*
+*               if_alt_nbr          Interface alternate setting number.
+*
+*               ep_addr             Endpoint address.
+*
+*               p_if_class_arg      Pointer to class argument specific to interface.
+*
+*               p_if_alt_class_arg  Pointer to class argument specific to alternate interface.
+*
+* Return(s)   : Size of the class endpoint descriptor.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+static  CPU_INT16U  USBD_MSC_EP_DescSizeGet (CPU_INT08U   dev_nbr,
+                                             CPU_INT08U   cfg_nbr,
+                                             CPU_INT08U   if_nbr,
+                                             CPU_INT08U   if_alt_nbr,
+                                             CPU_INT08U   ep_addr,
+                                             void        *p_if_class_arg,
+                                             void        *p_if_alt_class_arg)
+{
+    USBD_MSC_COMM  *p_comm;
+
+
+    (void)dev_nbr;
+    (void)cfg_nbr;
+    (void)if_nbr;
+    (void)ep_addr;
+    (void)p_if_alt_class_arg;
+
+    p_comm = (USBD_MSC_COMM *)p_if_class_arg;
+    if (if_alt_nbr != p_comm->UAS_AltNbr) {
+        return (0u);
+    }
+
+    return (USBD_MSC_UAS_DESC_LEN_PIPE_USAGE);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_MSC_UAS_AltAdd()
+*
+* Description : Add the UAS alternate setting and its pipes to an MSC interface.
+*
+* Argument(s) : dev_nbr     Device number.
+*
+*               cfg_nbr     Configuration number.
+*
+*               if_nbr      Interface number.
+*
+*               p_comm      Pointer to MSC comm structure.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                   UAS alternate setting successfully added.
+*
+*                                                               ------- RETURNED BY USBD_IF_AltAdd() : -------
+*                               USBD_ERR_IF_ALT_ALLOC           Interface alternate settings NOT available.
+*
+*                                                               ------- RETURNED BY USBD_BulkAdd() : -------
+*                               USBD_ERR_EP_NONE_AVAIL          Physical endpoint NOT available.
+*                               USBD_ERR_EP_ALLOC               Endpoints NOT available.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The pipes are added in the order expected by most UAS host drivers : command, status,
+*                   data-in, data-out.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+static  void  USBD_MSC_UAS_AltAdd (CPU_INT08U      dev_nbr,
+                                   CPU_INT08U      cfg_nbr,
+                                   CPU_INT08U      if_nbr,
+                                   USBD_MSC_COMM  *p_comm,
+                                   USBD_ERR       *p_err)
+{
+    CPU_INT08U  if_alt_nbr;
+    CPU_INT08U  ep_addr;
+
+
+    if_alt_nbr = USBD_IF_AltAdd(        dev_nbr,
+                                        cfg_nbr,
+                                        if_nbr,
+                                (void *)p_comm,
+                                        "USB Attached SCSI Interface",
+                                        p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    USBD_IF_AltProtocolSet(dev_nbr,                             /* Alt setting uses UAS protocol code.                  */
+                           cfg_nbr,
+                           if_nbr,
+                           if_alt_nbr,
+                           USBD_MSC_PROTOCOL_CODE_UAS,
+                           p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+                                                                /* Add pipes (see Note #1).                             */
+    ep_addr = USBD_BulkAdd(dev_nbr, cfg_nbr, if_nbr, if_alt_nbr, DEF_NO,  0u, p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+    p_comm->UAS_CmdEpAddr = ep_addr;
+
+    ep_addr = USBD_BulkAdd(dev_nbr, cfg_nbr, if_nbr, if_alt_nbr, DEF_YES, 0u, p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+    p_comm->UAS_StatusEpAddr = ep_addr;
+
+    ep_addr = USBD_BulkAdd(dev_nbr, cfg_nbr, if_nbr, if_alt_nbr, DEF_YES, 0u, p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+    p_comm->UAS_DataInEpAddr = ep_addr;
+
+    ep_addr = USBD_BulkAdd(dev_nbr, cfg_nbr, if_nbr, if_alt_nbr, DEF_NO,  0u, p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+    p_comm->UAS_DataOutEpAddr = ep_addr;
+    p_comm->UAS_AltNbr        = if_alt_nbr;
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_MSC_UAS_CmdRxStart()
+*
+* Description : Start receiving the next IU on the UAS command pipe.
+*
+* Argument(s) : p_ctrl      Pointer to MSC instance control structure.
+*
+*               p_comm      Pointer to MSC comm structure.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The caller sets 'UAS_CmdRxPend' before calling this function.  The IU is received
+*                   directly in the free slot at the tail of the task queue.
+*
+*               (2) The command pipe is NAKed by the device controller while no receive is pending, which
+*                   throttles the host once the task queue is full.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+static  void  USBD_MSC_UAS_CmdRxStart (USBD_MSC_CTRL  *p_ctrl,
+                                       USBD_MSC_COMM  *p_comm)
+{
+    CPU_INT08U  *p_buf;
+    USBD_ERR     err;
+    CPU_SR_ALLOC();
+
+
+    p_buf = p_ctrl->UAS_TaskTbl[p_ctrl->UAS_TaskTail].IU_BufPtr;
+
+    USBD_BulkRxAsync(        p_ctrl->DevNbr,
+                             p_comm->UAS_CmdEpAddr,
+                     (void *)p_buf,
+                             USBD_MSC_UAS_IU_LEN_CMD,
+                             USBD_MSC_UAS_CmdRxCmpl,
+                     (void *)p_comm,
+                            &err);
+    if (err != USBD_ERR_NONE) {
+        CPU_CRITICAL_ENTER();
+        p_ctrl->UAS_CmdRxPend = DEF_NO;
+        CPU_CRITICAL_EXIT();
+        USBD_DBG_MSC_ARG("MSC: UAS Cmd Rx, failed", err);
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_MSC_UAS_CmdRxCmpl()
+*
+* Description : Inform the class about a completed IU reception on the UAS command pipe.
+*
+* Argument(s) : dev_nbr     Device number.
+*
+*               ep_addr     Endpoint address.
+*
+*               p_buf       Pointer to the receive buffer.
+*
+*               buf_len     Receive buffer length.
+*
+*               xfer_len    Number of octets received.
+*
+*               p_arg       Additional argument provided by application.
+*
+*               err         Transfer status: success or error.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The IU is queued and the next reception is started immediately, so that the host can
+*                   send up to USBD_MSC_CFG_UAS_Q_DEPTH IUs while the MSC task executes the head task.
+*
+*               (2) A reception aborted while the UAS alternate setting remains selected is restarted.
+*                   A reception completing after the host left the UAS alternate setting is dropped.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+static  void  USBD_MSC_UAS_CmdRxCmpl (CPU_INT08U   dev_nbr,
+                                      CPU_INT08U   ep_addr,
+                                      void        *p_buf,
+                                      CPU_INT32U   buf_len,
+                                      CPU_INT32U   xfer_len,
+                                      void        *p_arg,
+                                      USBD_ERR     err)
+{
+    USBD_MSC_COMM      *p_comm;
+    USBD_MSC_CTRL      *p_ctrl;
+    USBD_MSC_UAS_TASK  *p_task;
+    CPU_BOOLEAN         rx_start;
+    CPU_BOOLEAN         post_signal;
+    USBD_ERR            os_err;
+    CPU_SR_ALLOC();
+
+
+    (void)dev_nbr;
+    (void)ep_addr;
+    (void)p_buf;
+    (void)buf_len;
+
+    p_comm = (USBD_MSC_COMM *)p_arg;
+    p_ctrl =  p_comm->CtrlPtr;
+
+    if (err != USBD_ERR_NONE) {                                 /* See Note #2.                                         */
+        CPU_CRITICAL_ENTER();
+        rx_start = p_comm->UAS_Active;
+        if (rx_start == DEF_NO) {
+            p_ctrl->UAS_CmdRxPend = DEF_NO;
+        }
+        CPU_CRITICAL_EXIT();
+
+        if (rx_start == DEF_YES) {
+            USBD_MSC_UAS_CmdRxStart(p_ctrl, p_comm);
+        }
+        return;
+    }
+
+    p_task = &p_ctrl->UAS_TaskTbl[p_ctrl->UAS_TaskTail];
+    USBD_MSC_UAS_IU_Parse(p_ctrl, p_comm, p_task, xfer_len);
+
+    CPU_CRITICAL_ENTER();
+    if (p_comm->UAS_Active == DEF_NO) {
+        p_ctrl->UAS_CmdRxPend = DEF_NO;
+        CPU_CRITICAL_EXIT();
+        return;
+    }
+                                                                /* Queue IU (see Note #1).                              */
+    p_ctrl->UAS_TaskTail = (p_ctrl->UAS_TaskTail + 1u) % USBD_MSC_CFG_UAS_Q_DEPTH;
+    p_ctrl->UAS_TaskCnt++;
+    if (p_ctrl->UAS_TaskCnt < USBD_MSC_CFG_UAS_Q_DEPTH) {
+        rx_start = DEF_YES;
+    } else {                                                    /* Queue full: NAK cmd pipe until a task completes.     */
+        rx_start = DEF_NO;
+        p_ctrl->UAS_CmdRxPend = DEF_NO;
+    }
+    post_signal = DEF_NO;
+    if (p_comm->NextCommState == USBD_MSC_COMM_STATE_UAS_WAIT) {
+        p_comm->NextCommState = USBD_MSC_COMM_STATE_UAS;
+        post_signal           = DEF_YES;
+    }
+    CPU_CRITICAL_EXIT();
+
+    if (rx_start == DEF_YES) {
+        USBD_MSC_UAS_CmdRxStart(p_ctrl, p_comm);
+    }
+
+    if (post_signal == DEF_YES) {                               /* Wake up MSC task waiting for an IU.                  */
+        USBD_MSC_OS_CommSignalPost(p_ctrl->ClassNbr, &os_err);
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_MSC_UAS_IU_Parse()
+*
+* Description : Parse an IU received on the UAS command pipe.
+*
+* Argument(s) : p_ctrl      Pointer to MSC instance control structure.
+*
+*               p_comm      Pointer to MSC comm structure.
+*
+*               p_task      Pointer to the task queue slot holding the IU.
+*
+*               iu_len      Number of octets received.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The response code of the task is determined on reception, so that a malformed IU, an
+*                   invalid LUN or a tag already in use is answered by a response IU in queue order.
+*
+*               (2) Additional CDB bytes are not supported: commands are limited to a 16-byte CDB.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+static  void  USBD_MSC_UAS_IU_Parse (USBD_MSC_CTRL      *p_ctrl,
+                                     USBD_MSC_COMM      *p_comm,
+                                     USBD_MSC_UAS_TASK  *p_task,
+                                     CPU_INT32U          iu_len)
+{
+    CPU_INT08U          *p_iu;
+    USBD_MSC_UAS_TASK   *p_task_q;
+    CPU_INT08U           ix;
+    CPU_SR_ALLOC();
+
+
+    p_iu             = p_task->IU_BufPtr;
+    p_task->IU_ID    = p_iu[0];
+    p_task->Tag      = MEM_VAL_GET_INT16U_BIG(&p_iu[2]);
+    p_task->Lun      = p_iu[9];
+    p_task->RespCode = USBD_MSC_UAS_RESP_CMPL;
+    p_task->Abort    = DEF_NO;
+
+    switch (p_task->IU_ID) {
+        case USBD_MSC_UAS_IU_ID_CMD:
+             if ((iu_len < USBD_MSC_UAS_IU_LEN_CMD) ||          /* See Note #2.                                         */
+                 ((p_iu[6] & 0xFCu) != 0u)) {
+                 p_task->RespCode = USBD_MSC_UAS_RESP_INVALID_IU;
+                 break;
+             }
+
+             if ((p_iu[8]      != 0u) ||
+                 (p_task->Lun  >= p_ctrl->MaxLun)) {
+                 p_task->RespCode = USBD_MSC_UAS_RESP_INCORRECT_LUN;
+                 break;
+             }
+
+             CPU_CRITICAL_ENTER();                              /* Chk that tag is not used by a queued task.           */
+             for (ix = 0u; ix < p_ctrl->UAS_TaskCnt; ix++) {
+                 p_task_q = &p_ctrl->UAS_TaskTbl[(p_ctrl->UAS_TaskHead + ix) % USBD_MSC_CFG_UAS_Q_DEPTH];
+                 if ((p_task_q->Tag   == p_task->Tag) &&
+                     (p_task_q->Abort == DEF_NO)) {
+                     p_task->RespCode = USBD_MSC_UAS_RESP_OVERLAPPED_TAG;
+                 }
+             }
+             CPU_CRITICAL_EXIT();
+             break;
+
+
+        case USBD_MSC_UAS_IU_ID_TASK_MGMT:
+             if (iu_len < USBD_MSC_UAS_IU_LEN_TASK_MGMT) {
+                 p_task->RespCode = USBD_MSC_UAS_RESP_INVALID_IU;
+                 break;
+             }
+             p_task->RespCode = USBD_MSC_UAS_TaskMgmt(p_ctrl, p_comm, p_iu);
+             break;
+
+
+        default:
+             p_task->RespCode = USBD_MSC_UAS_RESP_INVALID_IU;
+             break;
+    }
+
+    USBD_DBG_MSC_ARG("MSC: UAS IU Rx, tag", p_task->Tag);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_MSC_UAS_TaskMgmt()
+*
+* Description : Apply a task management function received on the UAS command pipe.
+*
+* Argument(s) : p_ctrl      Pointer to MSC instance control structure.
+*
+*               p_comm      Pointer to MSC comm structure.
+*
+*               p_iu        Pointer to the task management IU.
+*
+* Return(s)   : Response code to return to the host.
+*
+* Note(s)     : (1) Aborted commands are flagged in the task queue and skipped by the MSC task without
+*                   returning a sense IU.  If the command being executed is aborted, its data transfer is
+*                   aborted as well.
+*
+*               (2) Logical unit reset and I_T nexus reset also reset the SCSI state once the response
+*                   IU is reached in the task queue.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+static  CPU_INT08U  USBD_MSC_UAS_TaskMgmt (      USBD_MSC_CTRL  *p_ctrl,
+                                                 USBD_MSC_COMM  *p_comm,
+                                           const CPU_INT08U     *p_iu)
+{
+    USBD_MSC_UAS_TASK  *p_task;
+    CPU_INT08U          fnct;
+    CPU_INT16U          tag;
+    CPU_INT08U          lun;
+    CPU_INT08U          resp_code;
+    CPU_INT08U          ix;
+    CPU_BOOLEAN         match;
+    CPU_BOOLEAN         exec_abort;
+    USBD_ERR            err;
+    CPU_SR_ALLOC();
+
+
+    fnct = p_iu[4];
+    tag  = MEM_VAL_GET_INT16U_BIG(&p_iu[6]);
+    lun  = p_iu[9];
+
+    switch (fnct) {
+        case USBD_MSC_UAS_TMF_ABORT_TASK:
+        case USBD_MSC_UAS_TMF_ABORT_TASK_SET:
+        case USBD_MSC_UAS_TMF_CLR_TASK_SET:
+        case USBD_MSC_UAS_TMF_LU_RESET:
+        case USBD_MSC_UAS_TMF_IT_NEXUS_RESET:
+        case USBD_MSC_UAS_TMF_QUERY_TASK:
+             break;
+
+
+        default:
+             return (USBD_MSC_UAS_RESP_TMF_NOT_SUPPORTED);
+    }
+
+    if ((fnct != USBD_MSC_UAS_TMF_IT_NEXUS_RESET) &&
+        ((p_iu[8] != 0u) || (lun >= p_ctrl->MaxLun))) {
+        return (USBD_MSC_UAS_RESP_INCORRECT_LUN);
+    }
+
+    resp_code  = USBD_MSC_UAS_RESP_CMPL;
+    exec_abort = DEF_NO;
+
+    CPU_CRITICAL_ENTER();
+    for (ix = 0u; ix < p_ctrl->UAS_TaskCnt; ix++) {
+        p_task = &p_ctrl->UAS_TaskTbl[(p_ctrl->UAS_TaskHead + ix) % USBD_MSC_CFG_UAS_Q_DEPTH];
+        if ((p_task->IU_ID    != USBD_MSC_UAS_IU_ID_CMD) ||
+            (p_task->RespCode != USBD_MSC_UAS_RESP_CMPL) ||
+            (p_task->Abort    == DEF_YES)) {
+            continue;
+        }
+
+        if (fnct == USBD_MSC_UAS_TMF_IT_NEXUS_RESET) {
+            match = DEF_YES;
+        } else if ((fnct == USBD_MSC_UAS_TMF_ABORT_TASK) ||
+                   (fnct == USBD_MSC_UAS_TMF_QUERY_TASK)) {
+            match = ((p_task->Lun == lun) && (p_task->Tag == tag)) ? DEF_YES : DEF_NO;
+        } else {
+            match = (p_task->Lun == lun) ? DEF_YES : DEF_NO;
+        }
+
+        if (match == DEF_YES) {
+            if (fnct == USBD_MSC_UAS_TMF_QUERY_TASK) {
+                resp_code = USBD_MSC_UAS_RESP_TMF_SUCCEEDED;
+            } else {                                            /* See Note #1.                                         */
+                p_task->Abort = DEF_YES;
+                if ((ix == 0u) && (p_ctrl->UAS_TaskExec == DEF_YES)) {
+                    exec_abort = DEF_YES;
+                }
+            }
+        }
+    }
+    CPU_CRITICAL_EXIT();
+
+    if (exec_abort == DEF_YES) {                                /* Abort data xfer of cmd being executed.               */
+        USBD_EP_Abort(p_ctrl->DevNbr, p_comm->UAS_DataInEpAddr,  &err);
+        USBD_EP_Abort(p_ctrl->DevNbr, p_comm->UAS_DataOutEpAddr, &err);
+    }
+
+    return (resp_code);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_MSC_UAS_TaskExec()
+*
+* Description : Execute the task at the head of the UAS task queue.
+*
+* Argument(s) : p_ctrl      Pointer to MSC instance control structure.
+*
+*               p_comm      Pointer to MSC comm structure.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Queued commands are executed one at a time in the order they were received, since the
+*                   SCSI layer handles a single command per logical unit.  The host may still queue up to
+*                   USBD_MSC_CFG_UAS_Q_DEPTH tagged commands, which hides the command and status latency.
+*
+*               (2) An alternate setting change empties the task queue while a task executes.  The task
+*                   is then NOT dequeued again.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+static  void  USBD_MSC_UAS_TaskExec (USBD_MSC_CTRL  *p_ctrl,
+                                     USBD_MSC_COMM  *p_comm)
+{
+    USBD_MSC_UAS_TASK  *p_task;
+    CPU_INT08U          fnct;
+    CPU_BOOLEAN         rx_start;
+    USBD_ERR            err;
+    CPU_SR_ALLOC();
+
+
+    CPU_CRITICAL_ENTER();
+    if (p_comm->UAS_Active == DEF_NO) {                         /* Alt setting changed.                                 */
+        CPU_CRITICAL_EXIT();
+        return;
+    }
+
+    if (p_ctrl->UAS_TaskCnt == 0u) {                            /* Wait for next IU.                                    */
+        p_comm->NextCommState = USBD_MSC_COMM_STATE_UAS_WAIT;
+        CPU_CRITICAL_EXIT();
+
+        USBD_MSC_OS_CommSignalPend(            p_ctrl->ClassNbr,
+                                   (CPU_INT16U)0,
+                                              &err);
+        return;
+    }
+
+    p_task               = &p_ctrl->UAS_TaskTbl[p_ctrl->UAS_TaskHead];
+    p_ctrl->UAS_TaskExec =  DEF_YES;
+    CPU_CRITICAL_EXIT();
+
+    if ((p_task->IU_ID    == USBD_MSC_UAS_IU_ID_CMD) &&
+        (p_task->RespCode == USBD_MSC_UAS_RESP_CMPL)) {
+        if (p_task->Abort == DEF_NO) {                          /* Aborted cmds get no status.                          */
+            USBD_MSC_UAS_CmdExec(p_ctrl, p_comm, p_task);
+        }
+
+    } else {
+        fnct = p_task->IU_BufPtr[4];
+        if ((p_task->IU_ID    == USBD_MSC_UAS_IU_ID_TASK_MGMT) &&
+            (p_task->RespCode == USBD_MSC_UAS_RESP_CMPL)       &&
+           ((fnct == USBD_MSC_UAS_TMF_LU_RESET) ||
+            (fnct == USBD_MSC_UAS_TMF_IT_NEXUS_RESET))) {
+            USBD_SCSI_Reset(p_ctrl->ClassNbr);
+        }
+                                                                /* Tx resp IU for task mgmt and rejected IUs.           */
+        USBD_MSC_UAS_RespTx(p_ctrl,
+                            p_comm,
+                            USBD_MSC_UAS_IU_ID_RESP,
+                            p_task->Tag,
+                            p_task->RespCode,
+                           &err);
+    }
+
+    rx_start = DEF_NO;
+    CPU_CRITICAL_ENTER();
+    if (p_ctrl->UAS_TaskExec == DEF_YES) {                      /* Dequeue task (see Note #2).                          */
+        p_ctrl->UAS_TaskExec = DEF_NO;
+        p_ctrl->UAS_TaskHead = (p_ctrl->UAS_TaskHead + 1u) % USBD_MSC_CFG_UAS_Q_DEPTH;
+        p_ctrl->UAS_TaskCnt--;
+        if ((p_ctrl->UAS_CmdRxPend == DEF_NO) &&                /* Restart cmd pipe rx if queue was full.               */
+            (p_comm->UAS_Active    == DEF_YES)) {
+            p_ctrl->UAS_CmdRxPend = DEF_YES;
+            rx_start              = DEF_YES;
+        }
+    }
+    CPU_CRITICAL_EXIT();
+
+    if (rx_start == DEF_YES) {
+        USBD_MSC_UAS_CmdRxStart(p_ctrl, p_comm);
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_MSC_UAS_CmdExec()
+*
+* Description : Execute a UAS command and return its status.
+*
+* Argument(s) : p_ctrl      Pointer to MSC instance control structure.
+*
+*               p_comm      Pointer to MSC comm structure.
+*
+*               p_task      Pointer to the task holding the command IU.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The command is mapped on the bulk-only CBW so that the data stage reuses the bulk-only
+*                   data functions, including pipelined, asynchronous and zero-copy transfers.  The data
+*                   EPs of the UAS alternate setting are the active data EPs (see USBD_MSC_AltSettingUpdate()
+*                   Note #1).
+*
+*               (2) The device announces the data stage with a read ready or write ready IU on the status
+*                   pipe.  See 'UASP', Section 6.2.4 & 6.2.5.
+*
+*               (3) A data stage aborted by a task management function leaves the data EP halted.  The
+*                   halt is cleared so that the next command can use the pipe.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+static  void  USBD_MSC_UAS_CmdExec (USBD_MSC_CTRL      *p_ctrl,
+                                    USBD_MSC_COMM      *p_comm,
+                                    USBD_MSC_UAS_TASK  *p_task)
+{
+    CPU_INT08U   lun;
+    CPU_INT08U   status;
+    CPU_INT08U   iu_id;
+    CPU_BOOLEAN  data_ok;
+    USBD_ERR     err;
+    USBD_ERR     stall_err;
+    CPU_SR_ALLOC();
+
+
+    lun                 = p_task->Lun;
+    p_comm->CBW.dCBWTag = p_task->Tag;                          /* Map cmd IU on CBW (see Note #1).                     */
+    p_comm->CBW.bCBWLUN = lun;
+    Mem_Copy((void *)p_comm->CBW.CBWCB,
+             (void *)&p_task->IU_BufPtr[16u],
+                     sizeof(p_comm->CBW.CBWCB));
+
+    USBD_SCSI_CmdProcess(&p_ctrl->Lun[lun],                     /* Send the CDB to SCSI dev.                            */
+                          p_comm->CBW.CBWCB,
+                         &(p_ctrl->USBD_MSC_SCSI_Data_Len),
+                         &(p_ctrl->USBD_MSC_SCSI_Data_Dir),
+                         &err);
+
+    status = USBD_MSC_UAS_STATUS_GOOD;
+    if (err != USBD_ERR_NONE) {
+        status = USBD_MSC_UAS_STATUS_CHK_COND;
+
+    } else if (p_ctrl->USBD_MSC_SCSI_Data_Len > 0u) {
+        CPU_CRITICAL_ENTER();
+        p_comm->CBW.bmCBWFlags             = p_ctrl->USBD_MSC_SCSI_Data_Dir;
+        p_comm->CBW.dCBWDataTransferLength = p_ctrl->USBD_MSC_SCSI_Data_Len;
+        p_comm->CSW.dCSWDataResidue        = p_ctrl->USBD_MSC_SCSI_Data_Len;
+        p_comm->CSW.bCSWStatus             = USBD_MSC_BCSWSTATUS_CMD_PASSED;
+        p_comm->BytesToXfer                = p_ctrl->USBD_MSC_SCSI_Data_Len;
+        p_comm->Stall                      = DEF_FALSE;
+        CPU_CRITICAL_EXIT();
+
+        if (p_comm->CBW.bmCBWFlags == USBD_MSC_BMCBWFLAGS_DIR_HOST_TO_DEVICE) {
+            iu_id = USBD_MSC_UAS_IU_ID_WR_RDY;
+        } else {
+            iu_id = USBD_MSC_UAS_IU_ID_RD_RDY;
+        }
+                                                                /* Announce data stage (see Note #2).                   */
+        USBD_MSC_UAS_RespTx(p_ctrl, p_comm, iu_id, p_task->Tag, 0u, &err);
+        if (err != USBD_ERR_NONE) {
+            return;
+        }
+
+        CPU_CRITICAL_ENTER();
+        p_comm->NextCommState = USBD_MSC_COMM_STATE_DATA;
+        CPU_CRITICAL_EXIT();
+
+#if (USBD_MSC_CFG_DATA_POOL_EN == DEF_ENABLED)
+        USBD_MSC_DataBufGet(p_ctrl, p_comm->BytesToXfer);
+#endif
+        if (p_comm->CBW.bmCBWFlags == USBD_MSC_BMCBWFLAGS_DIR_HOST_TO_DEVICE) {
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+            USBD_MSC_SCSI_RxDataPipe(p_ctrl, p_comm);           /* Rx data from host on data-out pipe.                  */
+#else
+            USBD_MSC_SCSI_RxData(p_ctrl, p_comm);               /* Rx data from host on data-out pipe.                  */
+#endif
+        } else {
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+            USBD_MSC_SCSI_TxDataPipe(p_ctrl, p_comm);           /* Tx data to host on data-in pipe.                     */
+#else
+            USBD_MSC_SCSI_TxData(p_ctrl, p_comm);               /* Tx data to host on data-in pipe.                     */
+#endif
+        }
+#if (USBD_MSC_CFG_DATA_POOL_EN == DEF_ENABLED)
+        USBD_MSC_DataBufRel(p_ctrl);
+#endif
+
+        CPU_CRITICAL_ENTER();
+        if ((p_comm->NextCommState  == USBD_MSC_COMM_STATE_CSW) &&
+            (p_comm->CSW.bCSWStatus == USBD_MSC_BCSWSTATUS_CMD_PASSED)) {
+            data_ok = DEF_YES;
+        } else {
+            data_ok = DEF_NO;
+        }
+        if (p_comm->UAS_Active == DEF_YES) {
+            p_comm->NextCommState = USBD_MSC_COMM_STATE_UAS;
+        } else if (p_ctrl->State == USBD_MSC_STATE_CFG) {       /* Host switched back to bulk-only during data stage.   */
+            p_comm->NextCommState = USBD_MSC_COMM_STATE_CBW;
+        }
+        CPU_CRITICAL_EXIT();
+
+        if (data_ok == DEF_NO) {
+            status = USBD_MSC_UAS_STATUS_CHK_COND;
+            if (p_task->Abort == DEF_YES) {                     /* See Note #3.                                         */
+                USBD_EP_Stall(p_ctrl->DevNbr, p_comm->UAS_DataInEpAddr,  DEF_CLR, &stall_err);
+                USBD_EP_Stall(p_ctrl->DevNbr, p_comm->UAS_DataOutEpAddr, DEF_CLR, &stall_err);
+            }
+        }
+    }
+
+    if (p_task->Abort == DEF_YES) {                             /* Aborted cmds get no status.                          */
+        return;
+    }
+
+    USBD_MSC_UAS_SenseTx(p_ctrl, p_comm, p_task, status, &err);
+#if (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+    if ((err    == USBD_ERR_NONE) &&
+        (status == USBD_MSC_UAS_STATUS_GOOD)) {
+        USBD_SCSI_RdAheadFill(&p_ctrl->Lun[lun]);               /* See 'usbd_cfg.h', MSC Note #9.                       */
+    }
+#endif
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_MSC_UAS_RespTx()
+*
+* Description : Send a response, read ready or write ready IU on the UAS status pipe.
+*
+* Argument(s) : p_ctrl      Pointer to MSC instance control structure.
+*
+*               p_comm      Pointer to MSC comm structure.
+*
+*               iu_id       IU ID :
+*
+*                               USBD_MSC_UAS_IU_ID_RESP         Response IU.
+*                               USBD_MSC_UAS_IU_ID_RD_RDY       Read ready IU.
+*                               USBD_MSC_UAS_IU_ID_WR_RDY       Write ready IU.
+*
+*               tag         Tag of the task.
+*
+*               resp_code   Response code (response IU only).
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                   IU successfully sent.
+*
+*                                                               ---- RETURNED BY USBD_MSC_UAS_StatusTx() : ----
+*                               USBD_ERR_EP_INVALID_STATE       UAS alternate setting NOT selected.
+*
+* Return(s)   : None.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+static  void  USBD_MSC_UAS_RespTx (USBD_MSC_CTRL  *p_ctrl,
+                                   USBD_MSC_COMM  *p_comm,
+                                   CPU_INT08U      iu_id,
+                                   CPU_INT16U      tag,
+                                   CPU_INT08U      resp_code,
+                                   USBD_ERR       *p_err)
+{
+    CPU_INT08U  *p_iu;
+    CPU_INT32U   iu_len;
+
+
+    p_iu   = p_ctrl->UAS_StatusBufPtr;
+    iu_len = (iu_id == USBD_MSC_UAS_IU_ID_RESP) ? USBD_MSC_UAS_IU_LEN_RESP : USBD_MSC_UAS_IU_LEN_RDY;
+
+    Mem_Clr((void *)p_iu, iu_len);
+    p_iu[0] = iu_id;
+    MEM_VAL_SET_INT16U_BIG(&p_iu[2], tag);
+    if (iu_id == USBD_MSC_UAS_IU_ID_RESP) {
+        p_iu[7] = resp_code;
+    }
+
+    USBD_MSC_UAS_StatusTx(p_ctrl, p_comm, iu_len, p_err);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_MSC_UAS_SenseTx()
+*
+* Description : Send the sense IU completing a command on the UAS status pipe.
+*
+* Argument(s) : p_ctrl      Pointer to MSC instance control structure.
+*
+*               p_comm      Pointer to MSC comm structure.
+*
+*               p_task      Pointer to the completed task.
+*
+*               status      SCSI status of the command.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                   IU successfully sent.
+*
+*                                                               ---- RETURNED BY USBD_MSC_UAS_StatusTx() : ----
+*                               USBD_ERR_EP_INVALID_STATE       UAS alternate setting NOT selected.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The sense data of a failed command is returned in the sense IU (autosense), so that the
+*                   host does NOT need to issue a REQUEST SENSE command.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+static  void  USBD_MSC_UAS_SenseTx (      USBD_MSC_CTRL      *p_ctrl,
+                                          USBD_MSC_COMM      *p_comm,
+                                    const USBD_MSC_UAS_TASK  *p_task,
+                                          CPU_INT08U          status,
+                                          USBD_ERR           *p_err)
+{
+    CPU_INT08U  *p_iu;
+    CPU_INT08U   sense_len;
+
+
+    p_iu = p_ctrl->UAS_StatusBufPtr;
+    Mem_Clr((void *)p_iu, USBD_MSC_UAS_IU_LEN_SENSE_HDR);
+
+    sense_len = 0u;
+    if (status != USBD_MSC_UAS_STATUS_GOOD) {                   /* See Note #1.                                         */
+        sense_len = USBD_SCSI_SenseGet(&p_ctrl->Lun[p_task->Lun],
+                                       &p_iu[USBD_MSC_UAS_IU_LEN_SENSE_HDR],
+                                        USBD_MSC_UAS_SENSE_DATA_LEN);
+    }
+
+    p_iu[0] = USBD_MSC_UAS_IU_ID_SENSE;
+    MEM_VAL_SET_INT16U_BIG(&p_iu[2], p_task->Tag);
+    p_iu[6] = status;
+    MEM_VAL_SET_INT16U_BIG(&p_iu[14], sense_len);
+
+    USBD_MSC_UAS_StatusTx(p_ctrl, p_comm, USBD_MSC_UAS_IU_LEN_SENSE_HDR + sense_len, p_err);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_MSC_UAS_StatusTx()
+*
+* Description : Send the IU held in the status buffer on the UAS status pipe.
+*
+* Argument(s) : p_ctrl      Pointer to MSC instance control structure.
+*
+*               p_comm      Pointer to MSC comm structure.
+*
+*               iu_len      Length of the IU.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                   IU successfully sent.
+*                               USBD_ERR_EP_INVALID_STATE       UAS alternate setting NOT selected.
+*
+*                                                               ------ RETURNED BY USBD_BulkTx() : ------
+*                               USBD_ERR_DEV_INVALID_NBR        Invalid device number.
+*                               USBD_ERR_DEV_INVALID_STATE      Bulk transfer can ONLY be used after the
+*                                                                   device is in configured state.
+*                               USBD_ERR_OS_ABORT               Transfer aborted.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The status EP may be shared with the bulk-only alternate setting.  NO IU is sent once
+*                   the host left the UAS alternate setting.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+static  void  USBD_MSC_UAS_StatusTx (USBD_MSC_CTRL  *p_ctrl,
+                                     USBD_MSC_COMM  *p_comm,
+                                     CPU_INT32U      iu_len,
+                                     USBD_ERR       *p_err)
+{
+    if (p_comm->UAS_Active == DEF_NO) {                         /* See Note #1.                                         */
+       *p_err = USBD_ERR_EP_INVALID_STATE;
+        return;
+    }
+
+    (void)USBD_BulkTx(p_ctrl->DevNbr,
+                      p_comm->UAS_StatusEpAddr,
+                      p_ctrl->UAS_StatusBufPtr,
+                      iu_len,
+                      0,
+                      DEF_NO,
+                      p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        USBD_DBG_MSC_ARG("MSC: UAS Status Tx, failed", *p_err);
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_MSC_DataBufGet()
+*
+* Description : Take the data buffers of a data stage from the shared data buffer pool.
+*
+* Argument(s) : p_ctrl      Pointer to MSC instance control structure.
+*
+*               data_len    Number of octets to transfer during the data stage.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Each data buffer is a run of contiguous pool segments, long enough to hold the whole
+*                   data stage if the pool has room for it.  The segments guaranteed to the instances that
+*                   hold no data buffer are never given away, so that a buffer of one segment is always
+*                   available (see 'usbd_cfg.h', MSC Note #11).
+*
+*               (2) If the free segments are fragmented, the buffer length is reduced until a run is found
+*                   for each data buffer.  Single segments are always found.
+*
+*               (3) The segments are counted out of the free segments in a critical section before the
+*                   runs are searched, so that another instance cannot take them.  The pool is scanned
+*                   with interrupts enabled, and each run found is checked again and marked used in a
+*                   short critical section (see USBD_MSC_DataPoolRunTake()).  If another instance took
+*                   part of the run in the meantime, the pool is scanned again.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_DATA_POOL_EN == DEF_ENABLED)
+static  void  USBD_MSC_DataBufGet (USBD_MSC_CTRL  *p_ctrl,
+                                   CPU_INT32U      data_len)
+{
+    CPU_INT32U  seg_want;
+    CPU_INT16U  seg_nbr;
+    CPU_INT16U  seg_ix;
+    CPU_INT16U  seg_cnt;
+    CPU_INT08U   buf_ix;
+    CPU_INT08U   buf_got;
+    CPU_BOOLEAN  taken;
+    CPU_SR_ALLOC();
+
+
+    seg_want = (data_len + USBD_MSC_CFG_DATA_LEN - 1u) / USBD_MSC_CFG_DATA_LEN;
+
+    CPU_CRITICAL_ENTER();
+    USBD_MSC_DataPoolSegRsvdCnt -= USBD_MSC_CFG_DATA_BUF_NBR;   /* Use segs guaranteed to this instance.                */
+                                                                /* Size bufs from free segs (see Note #1).              */
+    seg_nbr = (USBD_MSC_DataPoolSegFreeCnt - USBD_MSC_DataPoolSegRsvdCnt) / USBD_MSC_CFG_DATA_BUF_NBR;
+    if (seg_want < seg_nbr) {
+        seg_nbr = (CPU_INT16U)seg_want;
+    }
+    USBD_MSC_DataPoolSegFreeCnt -= seg_nbr * USBD_MSC_CFG_DATA_BUF_NBR;
+    CPU_CRITICAL_EXIT();
+
+    buf_got = 0u;
+    while (buf_got < USBD_MSC_CFG_DATA_BUF_NBR) {
+        seg_ix = USBD_MSC_DataPoolRunFind(seg_nbr);             /* See Note #3.                                         */
+        if (seg_ix < USBD_MSC_DATA_POOL_SEG_NBR) {
+            taken = USBD_MSC_DataPoolRunTake(seg_ix, seg_nbr);
+            if (taken == DEF_YES) {
+                p_ctrl->DataPoolSegIxTbl[buf_got] = seg_ix;
+                buf_got++;
+            }
+
+        } else if (seg_nbr > 1u) {                              /* Release runs & retry shorter bufs (see Note #2).     */
+            for (buf_ix = 0u; buf_ix < buf_got; buf_ix++) {
+                for (seg_cnt = 0u; seg_cnt < seg_nbr; seg_cnt++) {
+                    USBD_MSC_DataPoolSegUsedTbl[p_ctrl->DataPoolSegIxTbl[buf_ix] + seg_cnt] = DEF_NO;
+                }
+            }
+            buf_got = 0u;
+            seg_nbr--;
+
+            CPU_CRITICAL_ENTER();                               /* Return segs no longer needed.                        */
+            USBD_MSC_DataPoolSegFreeCnt += USBD_MSC_CFG_DATA_BUF_NBR;
+            CPU_CRITICAL_EXIT();
+
+        } else {
+                                                                /* Pool changed during scan, scan again (see Note #3).  */
+        }
+    }
+    p_ctrl->DataPoolSegNbr = seg_nbr;
+
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+    for (buf_ix = 0u; buf_ix < USBD_MSC_CFG_DATA_BUF_NBR; buf_ix++) {
+        seg_ix                     = p_ctrl->DataPoolSegIxTbl[buf_ix];
+        p_ctrl->DataBufTbl[buf_ix] = &USBD_MSC_DataPoolPtr[seg_ix * USBD_MSC_DATA_POOL_SEG_LEN];
+    }
+#endif
+    seg_ix             =  p_ctrl->DataPoolSegIxTbl[0u];
+    p_ctrl->DataBufPtr = &USBD_MSC_DataPoolPtr[seg_ix * USBD_MSC_DATA_POOL_SEG_LEN];
+    p_ctrl->DataBufLen =  seg_nbr * USBD_MSC_CFG_DATA_LEN;      /* Keep chunks multiple of USBD_MSC_CFG_DATA_LEN.       */
+
+    USBD_DBG_MSC_ARG("MSC: Data Buf Len", p_ctrl->DataBufLen);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_MSC_DataBufRel()
+*
+* Description : Return the data buffers of a data stage to the shared data buffer pool.
+*
+* Argument(s) : p_ctrl      Pointer to MSC instance control structure.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The data stage functions return once every transfer queued on the data buffers has
+*                   completed, so the segments can be reused by another instance right away.
+*
+*               (2) The segments of the data buffers are only written by the instance that holds them, and
+*                   are marked free with interrupts enabled.  They are counted back as free segments
+*                   afterwards, in a critical section (see USBD_MSC_DataBufGet() Note #3).
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_DATA_POOL_EN == DEF_ENABLED)
+static  void  USBD_MSC_DataBufRel (USBD_MSC_CTRL  *p_ctrl)
+{
+    CPU_INT16U  seg_cnt;
+    CPU_INT08U  buf_ix;
+    CPU_SR_ALLOC();
+
+
+    if (p_ctrl->DataPoolSegNbr == 0u) {                         /* No bufs taken.                                       */
+        return;
+    }
+
+    for (buf_ix = 0u; buf_ix < USBD_MSC_CFG_DATA_BUF_NBR; buf_ix++) {
+        for (seg_cnt = 0u; seg_cnt < p_ctrl->DataPoolSegNbr; seg_cnt++) {
+            USBD_MSC_DataPoolSegUsedTbl[p_ctrl->DataPoolSegIxTbl[buf_ix] + seg_cnt] = DEF_NO;
+        }
+    }
+
+    CPU_CRITICAL_ENTER();                                       /* See Note #2.                                         */
+    USBD_MSC_DataPoolSegFreeCnt += p_ctrl->DataPoolSegNbr * USBD_MSC_CFG_DATA_BUF_NBR;
+    USBD_MSC_DataPoolSegRsvdCnt += USBD_MSC_CFG_DATA_BUF_NBR;   /* Guarantee segs to this instance again.               */
+    CPU_CRITICAL_EXIT();
+
+    p_ctrl->DataPoolSegNbr = 0u;
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_MSC_DataPoolRunFind()
+*
+* Description : Find the first run of free contiguous segments in the data buffer pool.
+*
+* Argument(s) : seg_nbr     Number of segments in the run.
+*
+* Return(s)   : Index of the first segment of the run, if found.
+*
+*               USBD_MSC_DATA_POOL_SEG_NBR,             otherwise.
+*
+* Note(s)     : (1) The pool is scanned with interrupts enabled. Other instances may take or release segments
+*                   during the scan, so the run returned MUST be taken with USBD_MSC_DataPoolRunTake().
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_DATA_POOL_EN == DEF_ENABLED)
+static  CPU_INT16U  USBD_MSC_DataPoolRunFind (CPU_INT16U  seg_nbr)
+{
+    CPU_INT16U  seg_ix;
+    CPU_INT16U  run_len;
+
+
+    run_len = 0u;
+    for (seg_ix = 0u; seg_ix < USBD_MSC_DATA_POOL_SEG_NBR; seg_ix++) {
+        if (USBD_MSC_DataPoolSegUsedTbl[seg_ix] == DEF_NO) {
+            run_len++;
+            if (run_len == seg_nbr) {
+                return (seg_ix + 1u - seg_nbr);
+            }
+        } else {
+            run_len = 0u;
+        }
+    }
+
+    return (USBD_MSC_DATA_POOL_SEG_NBR);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_MSC_DataPoolRunTake()
+*
+* Description : Mark a run of contiguous segments of the data buffer pool as used, if it is still free.
+*
+* Argument(s) : seg_ix      Index of the first segment of the run.
+*
+*               seg_nbr     Number of segments in the run.
+*
+* Return(s)   : DEF_YES, if the run has been taken.
+*
+*               DEF_NO,  if a segment of the run has been taken by another instance.
+*
+* Note(s)     : (1) The critical section only covers the segments of the run, so that interrupts are not
+*                   disabled for a scan of the whole pool (see USBD_MSC_DataBufGet() Note #3).
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_DATA_POOL_EN == DEF_ENABLED)
+static  CPU_BOOLEAN  USBD_MSC_DataPoolRunTake (CPU_INT16U  seg_ix,
+                                               CPU_INT16U  seg_nbr)
+{
+    CPU_INT16U  seg_cnt;
+    CPU_SR_ALLOC();
+
+
+    CPU_CRITICAL_ENTER();                                       /* See Note #1.                                         */
+    for (seg_cnt = 0u; seg_cnt < seg_nbr; seg_cnt++) {
+        if (USBD_MSC_DataPoolSegUsedTbl[seg_ix + seg_cnt] == DEF_YES) {
+            CPU_CRITICAL_EXIT();
+            return (DEF_NO);
+        }
+    }
+
+    for (seg_cnt = 0u; seg_cnt < seg_nbr; seg_cnt++) {
+        USBD_MSC_DataPoolSegUsedTbl[seg_ix + seg_cnt] = DEF_YES;
+    }
+    CPU_CRITICAL_EXIT();
+
+    return (DEF_YES);
+}
+#endif
 
 
 /*
@@ -2184,6 +5022,7 @@ static  void  USBD_MSC_RxCBW (USBD_MSC_CTRL  *p_ctrl,
 
 static  void  USBD_MSC_LunClr  (USBD_MSC_LUN_CTRL  *p_lun)
 {
+    p_lun->ClassNbr                  = 0;
     p_lun->LunNbr                    = 0;
     p_lun->LunInfo.ProdRevisionLevel = 0;
     p_lun->LunInfo.ReadOnly          = DEF_FALSE;
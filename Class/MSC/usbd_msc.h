@@ -81,6 +81,39 @@
 **********************************************************************************************************
 */
 
+/*
+*********************************************************************************************************
+*                                      LOGICAL UNIT CACHE STATISTICS
+*********************************************************************************************************
+*/
+
+typedef  struct  usbd_msc_cache_stat {
+    CPU_INT32U  RdHitCnt;                                       /* Nbr of blks rd from the cache.                       */
+    CPU_INT32U  RdMissCnt;                                      /* Nbr of blks rd from the storage layer.               */
+    CPU_INT32U  WrHitCnt;                                       /* Nbr of blks wr to an already cached blk.             */
+    CPU_INT32U  WrMissCnt;                                      /* Nbr of blks wr to an uncached blk.                   */
+    CPU_INT32U  WrBackCnt;                                      /* Nbr of dirty blks wr back to the storage layer.      */
+    CPU_INT32U  WrBackReqCnt;                                   /* Nbr of storage layer wr req for dirty blks.          */
+} USBD_MSC_CACHE_STAT;
+
+
+/*
+*********************************************************************************************************
+*                                   LOGICAL UNIT READ-AHEAD STATISTICS
+*
+* Note(s) : (1) The read-ahead hit rate is (HitBlkCnt / RdBlkCnt).
+*********************************************************************************************************
+*/
+
+typedef  struct  usbd_msc_rd_ahead_stat {
+    CPU_INT32U  RdBlkCnt;                                       /* Nbr of blks rd by READ cmds.                         */
+    CPU_INT32U  HitBlkCnt;                                      /* Nbr of blks rd from the read-ahead window.           */
+    CPU_INT32U  SeqCmdCnt;                                      /* Nbr of READ cmds continuing the previous one.        */
+    CPU_INT32U  FillCnt;                                        /* Nbr of storage layer rd req filling the window.      */
+    CPU_INT32U  FillBlkCnt;                                     /* Nbr of blks rd ahead.                                */
+    CPU_INT32U  DiscardCnt;                                     /* Nbr of windows dropped by a wr or a medium change.   */
+} USBD_MSC_RD_AHEAD_STAT;
+
 
 /*
 *********************************************************************************************************
@@ -122,6 +155,20 @@ void         USBD_MSC_LunAdd     (const  CPU_CHAR    *p_store_name,
 
 CPU_BOOLEAN  USBD_MSC_IsConn     (       CPU_INT08U   class_nbr);
 
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+void         USBD_MSC_LunCacheStatGet(CPU_INT08U            class_nbr,
+                                      CPU_INT08U            lun_nbr,
+                                      USBD_MSC_CACHE_STAT  *p_stat,
+                                      USBD_ERR             *p_err);
+#endif
+
+#if (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+void         USBD_MSC_LunRdAheadStatGet(CPU_INT08U               class_nbr,
+                                        CPU_INT08U               lun_nbr,
+                                        USBD_MSC_RD_AHEAD_STAT  *p_stat,
+                                        USBD_ERR                *p_err);
+#endif
+
 void         USBD_MSC_TaskHandler(       CPU_INT08U   class_nbr);
 
 
@@ -163,10 +210,116 @@ void         USBD_MSC_TaskHandler(       CPU_INT08U   class_nbr);
 #error  "USBD_MSC_CFG_DATA_LEN illegally #define'd in 'usbd_cfg.h' [MUST be >= 1]"
 #endif
 
+#ifndef  USBD_MSC_CFG_DATA_BUF_NBR
+#error  "USBD_MSC_CFG_DATA_BUF_NBR not #define'd in 'usbd_cfg.h' [MUST be >= 1]"
+#endif
+
+#if     (USBD_MSC_CFG_DATA_BUF_NBR < 1u)
+#error  "USBD_MSC_CFG_DATA_BUF_NBR illegally #define'd in 'usbd_cfg.h' [MUST be >= 1]"
+#endif
+
+#ifndef  USBD_MSC_CFG_DATA_POOL_EN
+#error  "USBD_MSC_CFG_DATA_POOL_EN not #define'd in 'usbd_cfg.h' [MUST be DEF_ENABLED or DEF_DISABLED]"
+#elif  ((USBD_MSC_CFG_DATA_POOL_EN != DEF_ENABLED) && \
+        (USBD_MSC_CFG_DATA_POOL_EN != DEF_DISABLED))
+#error  "USBD_MSC_CFG_DATA_POOL_EN illegally #define'd in 'usbd_cfg.h' [MUST be DEF_ENABLED or DEF_DISABLED]"
+#elif   (USBD_MSC_CFG_DATA_POOL_EN == DEF_ENABLED)
+
+#ifndef  USBD_MSC_CFG_DATA_POOL_LEN
+#error  "USBD_MSC_CFG_DATA_POOL_LEN not #define'd in 'usbd_cfg.h' [MUST be >= USBD_MSC_CFG_DATA_LEN]"
+#elif   (USBD_MSC_CFG_DATA_POOL_LEN < USBD_MSC_CFG_DATA_LEN)
+#error  "USBD_MSC_CFG_DATA_POOL_LEN illegally #define'd in 'usbd_cfg.h' [MUST be >= USBD_MSC_CFG_DATA_LEN]"
+#endif
+#endif
+
 #ifndef  USBD_MSC_CFG_MICRIUM_FS
 #error  "USBD_MSC_CFG_MICRIUM_FS not #define'd in 'usbd_cfg.h' [MUST be DEF_ENABLED or DEF_DISABLED]"
 #endif
 
+#ifndef  USBD_MSC_CFG_ZERO_COPY_EN
+#error  "USBD_MSC_CFG_ZERO_COPY_EN not #define'd in 'usbd_cfg.h' [MUST be DEF_ENABLED or DEF_DISABLED]"
+#elif  ((USBD_MSC_CFG_ZERO_COPY_EN != DEF_ENABLED) && \
+        (USBD_MSC_CFG_ZERO_COPY_EN != DEF_DISABLED))
+#error  "USBD_MSC_CFG_ZERO_COPY_EN illegally #define'd in 'usbd_cfg.h' [MUST be DEF_ENABLED or DEF_DISABLED]"
+#endif
+
+#ifndef  USBD_MSC_CFG_CACHE_EN
+#error  "USBD_MSC_CFG_CACHE_EN not #define'd in 'usbd_cfg.h' [MUST be DEF_ENABLED or DEF_DISABLED]"
+#elif  ((USBD_MSC_CFG_CACHE_EN != DEF_ENABLED) && \
+        (USBD_MSC_CFG_CACHE_EN != DEF_DISABLED))
+#error  "USBD_MSC_CFG_CACHE_EN illegally #define'd in 'usbd_cfg.h' [MUST be DEF_ENABLED or DEF_DISABLED]"
+#elif   (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+
+#ifndef  USBD_MSC_CFG_CACHE_NBR_BLK
+#error  "USBD_MSC_CFG_CACHE_NBR_BLK not #define'd in 'usbd_cfg.h' [MUST be >= 1 && <= 255]"
+#elif  ((USBD_MSC_CFG_CACHE_NBR_BLK < 1u) || \
+        (USBD_MSC_CFG_CACHE_NBR_BLK > 255u))
+#error  "USBD_MSC_CFG_CACHE_NBR_BLK illegally #define'd in 'usbd_cfg.h' [MUST be >= 1 && <= 255]"
+#endif
+
+#ifndef  USBD_MSC_CFG_CACHE_BLK_SIZE
+#error  "USBD_MSC_CFG_CACHE_BLK_SIZE not #define'd in 'usbd_cfg.h' [MUST be >= 1]"
+#elif   (USBD_MSC_CFG_CACHE_BLK_SIZE < 1u)
+#error  "USBD_MSC_CFG_CACHE_BLK_SIZE illegally #define'd in 'usbd_cfg.h' [MUST be >= 1]"
+#endif
+#endif
+
+#ifndef  USBD_MSC_CFG_UNMAP_EN
+#error  "USBD_MSC_CFG_UNMAP_EN not #define'd in 'usbd_cfg.h' [MUST be DEF_ENABLED or DEF_DISABLED]"
+#elif  ((USBD_MSC_CFG_UNMAP_EN != DEF_ENABLED) && \
+        (USBD_MSC_CFG_UNMAP_EN != DEF_DISABLED))
+#error  "USBD_MSC_CFG_UNMAP_EN illegally #define'd in 'usbd_cfg.h' [MUST be DEF_ENABLED or DEF_DISABLED]"
+#endif
+
+#ifndef  USBD_MSC_CFG_STORAGE_ASYNC_EN
+#error  "USBD_MSC_CFG_STORAGE_ASYNC_EN not #define'd in 'usbd_cfg.h' [MUST be DEF_ENABLED or DEF_DISABLED]"
+#elif  ((USBD_MSC_CFG_STORAGE_ASYNC_EN != DEF_ENABLED) && \
+        (USBD_MSC_CFG_STORAGE_ASYNC_EN != DEF_DISABLED))
+#error  "USBD_MSC_CFG_STORAGE_ASYNC_EN illegally #define'd in 'usbd_cfg.h' [MUST be DEF_ENABLED or DEF_DISABLED]"
+#elif  ((USBD_MSC_CFG_STORAGE_ASYNC_EN == DEF_ENABLED) && \
+        (USBD_MSC_CFG_DATA_BUF_NBR     <  2u))
+#error  "USBD_MSC_CFG_STORAGE_ASYNC_EN illegally #define'd in 'usbd_cfg.h' [MUST be DEF_DISABLED if DATA_BUF_NBR < 2]"
+#endif
+
+#ifndef  USBD_MSC_CFG_RD_AHEAD_EN
+#error  "USBD_MSC_CFG_RD_AHEAD_EN not #define'd in 'usbd_cfg.h' [MUST be DEF_ENABLED or DEF_DISABLED]"
+#elif  ((USBD_MSC_CFG_RD_AHEAD_EN != DEF_ENABLED) && \
+        (USBD_MSC_CFG_RD_AHEAD_EN != DEF_DISABLED))
+#error  "USBD_MSC_CFG_RD_AHEAD_EN illegally #define'd in 'usbd_cfg.h' [MUST be DEF_ENABLED or DEF_DISABLED]"
+#elif   (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+
+#if     (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+#error  "USBD_MSC_CFG_RD_AHEAD_EN illegally #define'd in 'usbd_cfg.h' [MUST be DEF_DISABLED if CACHE_EN is DEF_ENABLED]"
+#endif
+
+#ifndef  USBD_MSC_CFG_RD_AHEAD_NBR_BLK
+#error  "USBD_MSC_CFG_RD_AHEAD_NBR_BLK not #define'd in 'usbd_cfg.h' [MUST be >= 1]"
+#elif   (USBD_MSC_CFG_RD_AHEAD_NBR_BLK < 1u)
+#error  "USBD_MSC_CFG_RD_AHEAD_NBR_BLK illegally #define'd in 'usbd_cfg.h' [MUST be >= 1]"
+#endif
+
+#ifndef  USBD_MSC_CFG_RD_AHEAD_BLK_SIZE
+#error  "USBD_MSC_CFG_RD_AHEAD_BLK_SIZE not #define'd in 'usbd_cfg.h' [MUST be >= 1]"
+#elif   (USBD_MSC_CFG_RD_AHEAD_BLK_SIZE < 1u)
+#error  "USBD_MSC_CFG_RD_AHEAD_BLK_SIZE illegally #define'd in 'usbd_cfg.h' [MUST be >= 1]"
+#endif
+#endif
+
+#ifndef  USBD_MSC_CFG_UAS_EN
+#error  "USBD_MSC_CFG_UAS_EN not #define'd in 'usbd_cfg.h' [MUST be DEF_ENABLED or DEF_DISABLED]"
+#elif  ((USBD_MSC_CFG_UAS_EN != DEF_ENABLED) && \
+        (USBD_MSC_CFG_UAS_EN != DEF_DISABLED))
+#error  "USBD_MSC_CFG_UAS_EN illegally #define'd in 'usbd_cfg.h' [MUST be DEF_ENABLED or DEF_DISABLED]"
+#elif   (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+
+#ifndef  USBD_MSC_CFG_UAS_Q_DEPTH
+#error  "USBD_MSC_CFG_UAS_Q_DEPTH not #define'd in 'usbd_cfg.h' [MUST be >= 1 && <= 255]"
+#elif  ((USBD_MSC_CFG_UAS_Q_DEPTH < 1u) || \
+        (USBD_MSC_CFG_UAS_Q_DEPTH > 255u))
+#error  "USBD_MSC_CFG_UAS_Q_DEPTH illegally #define'd in 'usbd_cfg.h' [MUST be >= 1 && <= 255]"
+#endif
+#endif
+
 
 /*
 *********************************************************************************************************
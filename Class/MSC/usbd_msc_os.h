@@ -95,9 +95,20 @@ void  USBD_MSC_OS_CommSignalPend(CPU_INT08U    class_nbr,
 void  USBD_MSC_OS_CommSignalDel (CPU_INT08U    class_nbr,
                                  USBD_ERR     *p_err);
 
-void  USBD_MSC_OS_EnumSignalPost(USBD_ERR     *p_err);
+#if (USBD_MSC_CFG_DATA_BUF_NBR > 1u)
+void  USBD_MSC_OS_DataSignalPost(CPU_INT08U    class_nbr,
+                                 USBD_ERR     *p_err);
+
+void  USBD_MSC_OS_DataSignalPend(CPU_INT08U    class_nbr,
+                                 CPU_INT32U    timeout,
+                                 USBD_ERR     *p_err);
+#endif
+
+void  USBD_MSC_OS_EnumSignalPost(CPU_INT08U    class_nbr,
+                                 USBD_ERR     *p_err);
 
-void  USBD_MSC_OS_EnumSignalPend(CPU_INT32U    timeout,
+void  USBD_MSC_OS_EnumSignalPend(CPU_INT08U    class_nbr,
+                                 CPU_INT32U    timeout,
                                  USBD_ERR     *p_err);
 
 
@@ -38,6 +38,8 @@
 #else
 #include  "Storage/RAMDisk/usbd_storage.h"
 #endif
+#include  "usbd_storage_cache.h"
+#include  "usbd_storage_rd_ahead.h"
 
 
 /*
@@ -180,6 +182,7 @@
 #define  USBD_SCSI_CMD_CHANGE_DEFINITION                 0x40
 #define  USBD_SCSI_CMD_WRITE_SAME_10                     0x41
 #define  USBD_SCSI_CMD_READ_SUBCHANNEL                   0x42
+#define  USBD_SCSI_CMD_UNMAP                             0x42
 #define  USBD_SCSI_CMD_READ_TOC_PMA_ATIP                 0x43
 #define  USBD_SCSI_CMD_REPORT_DENSITY_SUPPORT            0x44
 #define  USBD_SCSI_CMD_READ_HEADER                       0x44
@@ -436,10 +439,14 @@
 #define  USBD_SCSI_ASC_CD_CONTROL_ERR                    0x73
 #define  USBD_SCSI_ASC_SECURITY_ERR                      0x74
 
+                                                                /* ------ SCSI ADDITIONAL SENSE CODE QUALIFIERS ------- */
+#define  USBD_SCSI_ASCQ_SPACE_ALLOC_FAILED               0x07   /* With USBD_SCSI_ASC_WR_PROTECTED.                     */
+
                                                                 /* ------- SCSI MODE PAGE CODES (See Notes #5) -------- */
 #define USBD_SCSI_PAGE_CODE_READ_WRITE_ERROR_RECOVERY    0x01
 #define USBD_SCSI_PAGE_CODE_FORMAT_DEVICE                0x03
 #define USBD_SCSI_PAGE_CODE_FLEXIBLE_DISK                0x05
+#define USBD_SCSI_PAGE_CODE_CACHING                      0x08
 #define USBD_SCSI_PAGE_CODE_INFORMATIONAL_EXCEPTIONS     0x1C
 #define USBD_SCSI_PAGE_CODE_ALL                          0x3F
 
@@ -447,6 +454,7 @@
 #define USBD_SCSI_PAGE_LENGTH_READ_WRITE_ERROR_RECOVERY  0x0A
 #define USBD_SCSI_PAGE_LENGTH_FLEXIBLE_DISK              0x1E
 #define USBD_SCSI_PAGE_LENGTH_FORMAT_DEVICE              0x16
+#define USBD_SCSI_PAGE_LENGTH_CACHING                    0x12
 
 
 /*
@@ -495,6 +503,57 @@
 #define  USBD_SCSI_START_STOP_UNIT_LOEJ             DEF_BIT_01
 
 
+/*
+**********************************************************************************************************
+*                                       VITAL PRODUCT DATA PAGES
+*
+* Note(s) : (1) The Supported VPD Pages page is specified in 'SCSI Primary Commands - 3' (SPC-3),
+*               Revision 23, Section 7.6.10.
+*
+*           (2) The Block Limits and Logical Block Provisioning VPD pages are specified in 'SCSI Block
+*               Commands - 3' (SBC-3), Revision 25, Sections 6.5.3 and 6.5.4.
+**********************************************************************************************************
+*/
+
+#define  USBD_SCSI_INQUIRY_EVPD                         0x01
+                                                                /* ------------------ VPD PAGE CODES ------------------ */
+#define  USBD_SCSI_VPD_PAGE_SUPPORTED_PAGES             0x00
+#define  USBD_SCSI_VPD_PAGE_BLK_LIMITS                  0xB0
+#define  USBD_SCSI_VPD_PAGE_LOG_BLK_PROVISIONING        0xB2
+
+#define  USBD_SCSI_VPD_DATA_LEN                           64u
+#define  USBD_SCSI_VPD_PAGE_HDR_LEN                        4u
+#define  USBD_SCSI_VPD_PAGE_LEN_BLK_LIMITS              0x3C
+#define  USBD_SCSI_VPD_PAGE_LEN_LOG_BLK_PROVISIONING    0x04
+                                                                /* ---------------- BLOCK LIMITS PAGE ----------------- */
+#define  USBD_SCSI_VPD_BLK_LIMITS_WSNZ                  0x01
+#define  USBD_SCSI_VPD_MAX_UNMAP_LBA_CNT          0xFFFFFFFFu
+#define  USBD_SCSI_VPD_MAX_UNMAP_DESC_CNT                 15u
+#define  USBD_SCSI_VPD_OPT_UNMAP_GRANULARITY               1u
+#define  USBD_SCSI_VPD_MAX_WR_SAME_LEN                 65535u
+                                                                /* -------- LOGICAL BLOCK PROVISIONING PAGE ----------- */
+#define  USBD_SCSI_VPD_LBP_LBPU                         0x80
+#define  USBD_SCSI_VPD_LBP_LBPWS                        0x40
+#define  USBD_SCSI_VPD_LBP_LBPWS10                      0x20
+#define  USBD_SCSI_VPD_LBP_TYPE_RESOURCE                0x01
+
+
+/*
+**********************************************************************************************************
+*                                     UNMAP AND WRITE SAME CMDS
+**********************************************************************************************************
+*/
+
+#define  USBD_SCSI_UNMAP_PARAM_HDR_LEN                     8u
+#define  USBD_SCSI_UNMAP_BLK_DESC_LEN                     16u
+#define  USBD_SCSI_UNMAP_PARAM_DATA_LEN   (USBD_SCSI_UNMAP_PARAM_HDR_LEN + \
+                                          (USBD_SCSI_UNMAP_BLK_DESC_LEN * USBD_SCSI_VPD_MAX_UNMAP_DESC_CNT))
+
+#define  USBD_SCSI_WR_SAME_UNMAP                    DEF_BIT_03
+
+#define  USBD_SCSI_RD_CAPACITY_16_LBPME                 0x80
+
+
 /*
 *********************************************************************************************************
 *                                       MODE SENSE CMD AND DATA
@@ -519,6 +578,8 @@
 #define  USBD_SCSI_MODE_SENSE_DATA_HEAD_OFFSET_CNT      0x00
 #define  USBD_SCSI_MODE_SENSE_DATA_DATA_STROBE_OFFSET   0x00
 #define  USBD_SCSI_MODE_SENSE_DATA_RECOVERY_LIMIT       0x00
+                                                                /* ---------------- CACHING PAGE PARAM ---------------- */
+#define  USBD_SCSI_MODE_SENSE_DATA_WCE                  0x04
 
 
 /*
@@ -550,6 +611,54 @@
 **********************************************************************************************************
 */
 
+/*
+**********************************************************************************************************
+*                                       LOGICAL UNIT SCSI CONTEXT
+*
+* Note(s) : (1) Each logical unit of each MSC instance keeps its own command state, sense data and
+*               response buffers. Logical units never share SCSI state, so the MSC instances can process
+*               commands on their logical units concurrently, each one from its own task.
+*
+*           (2) When the block cache is enabled, READ and WRITE commands of at most
+*               USBD_MSC_CFG_CACHE_NBR_BLK blocks insert their blocks in the cache. Longer commands only
+*               use the blocks already cached (see 'usbd_cfg.h', MSC Note #6).
+*
+*           (3) A WRITE SAME command with the UNMAP bit set releases its block range instead of writing it,
+*               when logical block provisioning is enabled (see 'usbd_cfg.h', MSC Note #7).
+*
+*           (4) When read-ahead is enabled, the blocks following a sequential READ command are read once
+*               its CSW is sent (see 'usbd_cfg.h', MSC Note #9).
+**********************************************************************************************************
+*/
+
+typedef  struct  usbd_scsi_lun_ctx {
+    USBD_STORAGE_LUN     StorageLun;                            /* Storage layer logical unit.                          */
+    CPU_INT08U          *RespBufPtr;                            /* Ptr to data buf for Data IN phase.                   */
+    CPU_INT32U           RespLen;                               /* Buf len.                                             */
+    CPU_INT64U           LBAddr;                                /* 64-bit Logical Blk Addr.                             */
+    CPU_INT32U           LBCnt;                                 /* Nbr of mem blks.                                     */
+    CPU_INT08U           SenseKey;                              /* Sense key describing an err or exception cond.       */
+    CPU_INT08U           ASC;                                   /* Additional Sense Code describing sense key in detail.*/
+    CPU_INT08U           ASCQ;                                  /* Additional Sense Code Qualifier.                     */
+    CPU_INT08U           InquiryData[USBD_SCSI_INQUIRY_DATA_LEN];
+    CPU_INT08U           ModeSenseData[USBD_SCSI_MODE_SENSE_DATA_LEN];
+    CPU_INT08U           ReadCapacityData[USBD_SCSI_RD_CAPACITY_16_PARAM_DATA_LEN];
+    CPU_INT08U           ReqSenseData[USBD_SCSI_REQ_SENSE_DATA_LEN];
+    CPU_INT08U           VpdData[USBD_SCSI_VPD_DATA_LEN];
+#if (USBD_MSC_CFG_UNMAP_EN == DEF_ENABLED)
+    CPU_INT08U           UnmapParamData[USBD_SCSI_UNMAP_PARAM_DATA_LEN];
+    CPU_INT32U           UnmapParamLen;                         /* Nbr of UNMAP param list octets rx'd.                 */
+    CPU_BOOLEAN          WrSameUnmap;                           /* WRITE SAME releases blks (see Note #3).              */
+#endif
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+    USBD_STORAGE_CACHE   Cache;                                 /* Blk cache.                                           */
+    CPU_BOOLEAN          CacheAlloc;                            /* Cur cmd inserts blks in the cache (see Note #2).     */
+#endif
+#if (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+    USBD_STORAGE_RD_AHEAD RdAhead;                              /* Read-ahead window (see Note #4).                     */
+#endif
+} USBD_SCSI_LUN_CTX;
+
 
 /*
 **********************************************************************************************************
@@ -557,11 +666,7 @@
 **********************************************************************************************************
 */
 
-static  USBD_STORAGE_LUN  USBD_SCSI_LunTbl[USBD_MSC_CFG_MAX_LUN];
-static  CPU_INT08U        USBD_SCSI_InquiryData[USBD_SCSI_INQUIRY_DATA_LEN];
-static  CPU_INT08U        USBD_SCSI_ModeSenseData[USBD_SCSI_MODE_SENSE_DATA_LEN];
-static  CPU_INT08U        USBD_SCSI_ReadCapacityData[USBD_SCSI_RD_CAPACITY_16_PARAM_DATA_LEN];
-static  CPU_INT08U        USBD_SCSI_ReqSenseData[USBD_SCSI_REQ_SENSE_DATA_LEN];
+static  USBD_SCSI_LUN_CTX  USBD_SCSI_LunCtxTbl[USBD_MSC_CFG_MAX_NBR_DEV][USBD_MSC_CFG_MAX_LUN];
 
 
 /*
@@ -570,14 +675,6 @@ static  CPU_INT08U        USBD_SCSI_ReqSenseData[USBD_SCSI_REQ_SENSE_DATA_LEN];
 **********************************************************************************************************
 */
 
-static  CPU_INT08U  *USBD_SCSI_RespBufPtr;                      /* Ptr to data buf for Data IN phase.                   */
-static  CPU_INT32U   USBD_SCSI_RespLen;                         /* Buf len.                                             */
-static  CPU_INT64U   USBD_SCSI_LBAddr;                          /* 64-bit Logical Blk Addr.                             */
-static  CPU_INT32U   USBD_SCSI_LBCnt;                           /* Nbr of mem blks.                                     */
-static  CPU_INT08U   USBD_SCSI_SenseKey;                        /* Sense key describing an err or exception cond.       */
-static  CPU_INT08U   USBD_SCSI_ASC;                             /* Additional Sense Code describing sense key in detail.*/
-static  CPU_INT08U   USBD_SCSI_ASCQ;                            /* Additional Sense Code Qualifier.                     */
-
 
 /*
 **********************************************************************************************************
@@ -590,7 +687,8 @@ static  void   USBD_SCSI_ModeSenseDataPrepare(const USBD_MSC_LUN_CTRL  *p_lun,
                                                     CPU_INT08U          page_code,
                                                     USBD_ERR           *p_err);
 
-static  void   USBD_SCSI_ReqSenseDataUpdate  (      CPU_INT08U          sense_key,
+static  void   USBD_SCSI_ReqSenseDataUpdate  (      USBD_SCSI_LUN_CTX  *p_ctx,
+                                                    CPU_INT08U          sense_key,
                                                     CPU_INT08U          sense_code,
                                                     CPU_INT08U          sense_code_qual);
 
@@ -599,12 +697,30 @@ static  void   USBD_SCSI_InquiryDataPrepare  (const USBD_MSC_LUN_CTRL  *p_lun,
                                                     CPU_INT08U          page_code,
                                                     USBD_ERR           *p_err);
 
-static  void   USBD_SCSI_LunStatusAnalyze    (      USBD_ERR            err);
+static  void   USBD_SCSI_LunStatusAnalyze    (      USBD_SCSI_LUN_CTX  *p_ctx,
+                                                    USBD_ERR            err);
 
 static  void   USBD_SCSI_PageRdWrErrRecovery (      void               *p_buf_dest);
 
 static  void   USBD_SCSI_PageInfoExcept      (      void               *p_buf_dest);
 
+static  void   USBD_SCSI_PageCaching         (      void               *p_buf_dest);
+
+static  void   USBD_SCSI_VpdPageBlkLimits    (      void               *p_buf_dest);
+
+#if (USBD_MSC_CFG_UNMAP_EN == DEF_ENABLED)
+static  void   USBD_SCSI_VpdPageLogBlkProv   (      void               *p_buf_dest);
+
+static  void   USBD_SCSI_UnmapParamProcess   (const USBD_MSC_LUN_CTRL  *p_lun,
+                                                    USBD_SCSI_LUN_CTX  *p_ctx,
+                                                    USBD_ERR           *p_err);
+
+static  void   USBD_SCSI_Unmap               (      USBD_SCSI_LUN_CTX  *p_ctx,
+                                                    CPU_INT64U          blk_addr,
+                                                    CPU_INT32U          nbr_blks,
+                                                    USBD_ERR           *p_err);
+#endif
+
 
 /*
 **********************************************************************************************************
@@ -665,40 +781,26 @@ static  void   USBD_SCSI_PageInfoExcept      (      void               *p_buf_de
 
 void  USBD_SCSI_Init (USBD_ERR  *p_err)
 {
-    CPU_INT08U  ix;
+    CPU_INT08U          class_nbr;
+    CPU_INT08U          lun_nbr;
+    USBD_SCSI_LUN_CTX  *p_ctx;
 
 
-    for (ix = 0; ix < USBD_MSC_CFG_MAX_LUN; ix++) {
-        Mem_Clr((void     *)&USBD_SCSI_LunTbl[ix],
-                (CPU_SIZE_T) sizeof(USBD_STORAGE_LUN));
-    }
-                                                                /* See Note #1.                                         */
-    Mem_Clr((void     *)USBD_SCSI_InquiryData,
-            (CPU_SIZE_T)USBD_SCSI_INQUIRY_DATA_LEN);
-                                                                /* See Note #2.                                         */
-    Mem_Clr((void     *)USBD_SCSI_ModeSenseData,
-            (CPU_SIZE_T)USBD_SCSI_MODE_SENSE_DATA_LEN);
-                                                                /* See Note #3.                                         */
-    Mem_Clr((void     *)USBD_SCSI_ReadCapacityData,
-            (CPU_SIZE_T)USBD_SCSI_RD_CAPACITY_16_PARAM_DATA_LEN);
-                                                                /* See Note #4.                                         */
-    Mem_Clr((void     *)USBD_SCSI_ReqSenseData,
-            (CPU_SIZE_T)USBD_SCSI_REQ_SENSE_DATA_LEN);
+    for (class_nbr = 0u; class_nbr < USBD_MSC_CFG_MAX_NBR_DEV; class_nbr++) {
+        for (lun_nbr = 0u; lun_nbr < USBD_MSC_CFG_MAX_LUN; lun_nbr++) {
+            p_ctx = &USBD_SCSI_LunCtxTbl[class_nbr][lun_nbr];
+                                                                /* Clr LUN state & resp bufs (see Notes #1 to #4).      */
+            Mem_Clr((void     *)p_ctx,
+                    (CPU_SIZE_T)sizeof(USBD_SCSI_LUN_CTX));
                                                                 /* See Note #1a to 1c.                                  */
-    USBD_SCSI_InquiryData[2] =  USBD_SCSI_INQUIRY_VERS_SPC_3;
-    USBD_SCSI_InquiryData[3] =  USBD_SCSI_INQUIRY_RESP_DATA_FMT_DEFAULT;
-    USBD_SCSI_InquiryData[4] = (USBD_SCSI_INQUIRY_DATA_LEN - 5);
+            p_ctx->InquiryData[2] =  USBD_SCSI_INQUIRY_VERS_SPC_3;
+            p_ctx->InquiryData[3] =  USBD_SCSI_INQUIRY_RESP_DATA_FMT_DEFAULT;
+            p_ctx->InquiryData[4] = (USBD_SCSI_INQUIRY_DATA_LEN - 5);
                                                                 /* See Note #4a to 4b.                                  */
-    USBD_SCSI_ReqSenseData[0] =  USBD_SCSI_REQ_SENSE_RESP_CODE_CUR_ERR;
-    USBD_SCSI_ReqSenseData[7] = (USBD_SCSI_REQ_SENSE_DATA_LEN - 8);
-
-    USBD_SCSI_RespBufPtr = (CPU_INT08U *)0u;
-    USBD_SCSI_RespLen    =  0u;
-    USBD_SCSI_LBAddr     =  0u;
-    USBD_SCSI_LBCnt      =  0u;
-    USBD_SCSI_SenseKey   =  0u;
-    USBD_SCSI_ASC        =  0u;
-    USBD_SCSI_ASCQ       =  0u;
+            p_ctx->ReqSenseData[0] =  USBD_SCSI_REQ_SENSE_RESP_CODE_CUR_ERR;
+            p_ctx->ReqSenseData[7] = (USBD_SCSI_REQ_SENSE_DATA_LEN - 8);
+        }
+    }
 
     USBD_StorageInit(p_err);                                    /* Init storage layer.                                  */
 }
@@ -710,7 +812,9 @@ void  USBD_SCSI_Init (USBD_ERR  *p_err)
 *
 * Description : Initialize the specified logical unit.
 *
-* Argument(s) : lun_nbr         Logical unit number.
+* Argument(s) : class_nbr       MSC instance number.
+*
+*               lun_nbr         Logical unit number.
 *
 *               p_vol_str       Pointer to string uniquely identifying the logical unit.
 *
@@ -719,20 +823,43 @@ void  USBD_SCSI_Init (USBD_ERR  *p_err)
 *                                               ---------- RETURNED BY USBD_StorageAdd() : -------
 *                               USBD_ERR_NONE   Logical unit successfully initialized.
 *
+*                                               ------- RETURNED BY USBD_StorageCacheInit() : -----
+*                               USBD_ERR_ALLOC  Block cache data buffer allocation failed.
+*
+*                                               ----- RETURNED BY USBD_StorageRdAheadInit() : ----
+*                               USBD_ERR_ALLOC  Read-ahead window data buffer allocation failed.
+*
 * Return(s)   : None.
 *
 * Note(s)     : None.
 *********************************************************************************************************
 */
 
-void  USBD_SCSI_LunAdd (CPU_INT08U   lun_nbr,
+void  USBD_SCSI_LunAdd (CPU_INT08U   class_nbr,
+                        CPU_INT08U   lun_nbr,
                         CPU_CHAR    *p_vol_str,
                         USBD_ERR    *p_err)
 {
-    USBD_SCSI_LunTbl[lun_nbr].LunNbr    = lun_nbr;
-    USBD_SCSI_LunTbl[lun_nbr].VolStrPtr = p_vol_str;
+    USBD_STORAGE_LUN  *p_storage_lun;
+
+
+    p_storage_lun            = &USBD_SCSI_LunCtxTbl[class_nbr][lun_nbr].StorageLun;
+    p_storage_lun->ClassNbr  =  class_nbr;                      /* Storage layers key their state by class & LUN nbr.   */
+    p_storage_lun->LunNbr    =  lun_nbr;
+    p_storage_lun->VolStrPtr =  p_vol_str;
 
-    USBD_StorageAdd(&USBD_SCSI_LunTbl[lun_nbr], p_err);         /* Init logical unit.                                   */
+    USBD_StorageAdd(p_storage_lun, p_err);                      /* Init logical unit.                                   */
+
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+    if (*p_err == USBD_ERR_NONE) {                              /* Alloc logical unit blk cache.                        */
+        USBD_StorageCacheInit(&USBD_SCSI_LunCtxTbl[class_nbr][lun_nbr].Cache, p_err);
+    }
+#endif
+#if (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+    if (*p_err == USBD_ERR_NONE) {                              /* Alloc logical unit read-ahead window.                */
+        USBD_StorageRdAheadInit(&USBD_SCSI_LunCtxTbl[class_nbr][lun_nbr].RdAhead, p_err);
+    }
+#endif
 }
 
 
@@ -768,7 +895,7 @@ void  USBD_SCSI_LunAdd (CPU_INT08U   lun_nbr,
 *                               USBD_ERR_SCSI_LOCK_TIMEOUT          Logical unit lock timed out.
 *
 *                                                                   --- RETURNED BY USBD_SCSI_InquiryDataPrepare() : ---
-*                               USBD_ERR_SCSI_UNSUPPORTED_CMD       SCSI command not supported.
+*                               USBD_ERR_SCSI_UNSUPPORTED_CMD       SCSI command or VPD page not supported.
 *
 *                                                                   --- RETURNED BY USBD_StorageStatusGet() : ---
 *                               USBD_ERR_SCSI_MEDIUM_NOTPRESENT     Medium not present.
@@ -798,6 +925,10 @@ void  USBD_SCSI_LunAdd (CPU_INT08U   lun_nbr,
 *               (5) The format of READ(10) command is specified in 'SCSI Block Commands - 3'
 *                   (SBC), Revision 16, Section 5.8.
 *
+*                   (a) When read-ahead is enabled, each READ command is checked for continuing the
+*                       previous one. Blocks written by WRITE and WRITE SAME commands are dropped from
+*                       the read-ahead window.
+*
 *               (6) The format of READ(12) command is specified in 'SCSI Block Commands - 3'
 *                   (SBC), Revision 16, Section 5.9.
 *
@@ -836,6 +967,34 @@ void  USBD_SCSI_LunAdd (CPU_INT08U   lun_nbr,
 *
 *               (18)    The format of START STOP UNIT command is specified in 'SCSI Primary
 *                       Commands - 3' (SPC-3), Revision 23, Section 5.19.
+*
+*                       (a) When the block cache is enabled, the cached blocks are written to the medium
+*                           before the logical unit is stopped or ejected. An ejected medium may be replaced,
+*                           so the cache and the read-ahead window are then emptied.
+*
+*               (19)    The format of SYNCHRONIZE CACHE(10) and SYNCHRONIZE CACHE(16) commands is specified
+*                       in 'SCSI Block Commands - 3' (SBC-3). The whole cache is written to the medium,
+*                       regardless of the block range given by the host. Without block cache, the data is
+*                       already on the medium and the command completes immediately.
+*
+*               (20)    The format of UNMAP command is specified in 'SCSI Block Commands - 3' (SBC-3),
+*                       Revision 25, Section 5.28. Logical block provisioning is reported by the LBPME bit of
+*                       READ CAPACITY(16) parameter data & by the Logical Block Provisioning VPD page.
+*
+*                       (a) The parameter list is received in the data OUT phase and processed once complete
+*                           by USBD_SCSI_DataWr(). A parameter list longer than the maximum number of block
+*                           descriptors reported in the Block Limits VPD page is rejected.
+*
+*                       (b) A parameter list length of zero is not an error. No block is released.
+*
+*               (21)    The format of WRITE SAME(10) and WRITE SAME(16) commands is specified in 'SCSI Block
+*                       Commands - 3' (SBC-3), Revision 25, Sections 5.40 and 5.41. A single block is received
+*                       in the data OUT phase & written to each block of the range. A NUMBER OF LOGICAL BLOCKS
+*                       of zero is rejected, as reported by the WSNZ bit of the Block Limits VPD page.
+*
+*                       (a) When logical block provisioning is enabled and the UNMAP bit is set, the range is
+*                           released instead. Released blocks do not read back as the received block, which
+*                           is allowed since the LBPRZ bit is cleared. Otherwise, the UNMAP bit is ignored.
 **********************************************************************************************************
 */
 
@@ -845,22 +1004,24 @@ void  USBD_SCSI_CmdProcess (      USBD_MSC_LUN_CTRL  *p_lun,
                                   CPU_INT08U         *p_data_dir,
                                   USBD_ERR           *p_err)
 {
-    CPU_INT08U         scsi_cmd;
-    CPU_INT08U         page_code;
-    CPU_INT08U         cmdt_evpd;
-    CPU_INT08U         loej;
-    CPU_INT08U         start_flag;
-    CPU_INT32U         len;
-    CPU_INT64U         nbr_blks;
-    CPU_INT32U         total_area_size_verifd;
-    CPU_INT32U         total_lu_size;
-    USBD_STORAGE_LUN  *p_storage_lun;
+    CPU_INT08U          scsi_cmd;
+    CPU_INT08U          page_code;
+    CPU_INT08U          cmdt_evpd;
+    CPU_INT08U          loej;
+    CPU_INT08U          start_flag;
+    CPU_INT32U          len;
+    CPU_INT64U          nbr_blks;
+    CPU_INT32U          total_area_size_verifd;
+    CPU_INT32U          total_lu_size;
+    USBD_SCSI_LUN_CTX  *p_ctx;
+    USBD_STORAGE_LUN   *p_storage_lun;
 
 
     scsi_cmd      =  p_cbwcb[0];                                /* Get the SCSI cmd blk opcode.                         */
    *p_err         =  USBD_ERR_NONE;
    *p_resp_len    =  0;
-    p_storage_lun = &USBD_SCSI_LunTbl[p_lun->LunNbr];
+    p_ctx         = &USBD_SCSI_LunCtxTbl[p_lun->ClassNbr][p_lun->LunNbr];
+    p_storage_lun = &p_ctx->StorageLun;
 
     switch (scsi_cmd) {
         case USBD_SCSI_CMD_INQUIRY:                             /* --------------  INQUIRY(see Notes #1) -------------- */
@@ -872,20 +1033,20 @@ void  USBD_SCSI_CmdProcess (      USBD_MSC_LUN_CTRL  *p_lun,
              USBD_SCSI_InquiryDataPrepare(p_lun, cmdt_evpd, page_code, p_err);
 
              if (*p_err  == USBD_ERR_NONE) {
-                 len = DEF_MIN(USBD_SCSI_INQUIRY_DATA_LEN, p_cbwcb[4]);
-                                                                /* Copy the Inquiry data.                               */
-                 USBD_SCSI_RespBufPtr = &USBD_SCSI_InquiryData[0];
-                 USBD_SCSI_RespLen    = len;
-                *p_data_dir           = USBD_SCSI_CBW_DEVICE_TO_HOST;
+                 len = MEM_VAL_GET_INT16U_BIG(&p_cbwcb[3]);     /* Get the alloc len.                                   */
+                 p_ctx->RespLen = DEF_MIN(p_ctx->RespLen, len);
+                *p_data_dir     = USBD_SCSI_CBW_DEVICE_TO_HOST;
                                                                 /* Build req sense data with no err cond.               */
-                 USBD_SCSI_ReqSenseDataUpdate(USBD_SCSI_SENSE_KEY_NO_SENSE,
+                 USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                              USBD_SCSI_SENSE_KEY_NO_SENSE,
                                               USBD_SCSI_ASC_NO_ADDITIONAL_SENSE_INFO,
                                               0x00);
              } else {
-                 USBD_SCSI_RespBufPtr = (CPU_INT08U *)0;
-                 USBD_SCSI_RespLen    =  0;
+                 p_ctx->RespBufPtr = (CPU_INT08U *)0;
+                 p_ctx->RespLen    =  0;
                                                                 /* Build req sense data with an err cond.               */
-                 USBD_SCSI_ReqSenseDataUpdate(USBD_SCSI_SENSE_KEY_ILLEGAL_REQUEST,
+                 USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                              USBD_SCSI_SENSE_KEY_ILLEGAL_REQUEST,
                                               USBD_SCSI_ASC_INVALID_FIELD_IN_CDB,
                                               0x00);
              }
@@ -915,9 +1076,9 @@ void  USBD_SCSI_CmdProcess (      USBD_MSC_LUN_CTRL  *p_lun,
                  p_storage_lun->EjectFlag = DEF_FALSE;
              }
 
-             USBD_SCSI_LunStatusAnalyze(*p_err);                /* Check err code & build req sense data.               */
-             USBD_SCSI_RespBufPtr = (CPU_INT08U *)0;
-             USBD_SCSI_RespLen    = 0;
+             USBD_SCSI_LunStatusAnalyze(p_ctx, *p_err);         /* Check err code & build req sense data.               */
+             p_ctx->RespBufPtr = (CPU_INT08U *)0;
+             p_ctx->RespLen    = 0;
              break;
 
 
@@ -932,7 +1093,7 @@ void  USBD_SCSI_CmdProcess (      USBD_MSC_LUN_CTRL  *p_lun,
                  USBD_StorageStatusGet(p_storage_lun, p_err);
              }
 
-             USBD_SCSI_LunStatusAnalyze(*p_err);                /* Check err code & build req sense data.               */
+             USBD_SCSI_LunStatusAnalyze(p_ctx, *p_err);         /* Check err code & build req sense data.               */
              if (*p_err == USBD_ERR_NONE){
                                                                 /* Get the capacity, nbr of blks and blk size.          */
                  USBD_StorageCapacityGet(p_storage_lun,
@@ -940,24 +1101,30 @@ void  USBD_SCSI_CmdProcess (      USBD_MSC_LUN_CTRL  *p_lun,
                                         &p_lun->BlockSize,
                                          p_err);
 
-                 USBD_SCSI_LunStatusAnalyze(*p_err);            /* Check err code & build req sense data.               */
+                 USBD_SCSI_LunStatusAnalyze(p_ctx, *p_err);     /* Check err code & build req sense data.               */
                  if (*p_err != USBD_ERR_NONE ) {
                      break;
                  }
 
                  if (scsi_cmd == USBD_SCSI_CMD_READ_CAPACITY_10) {
 
-                     MEM_VAL_SET_INT32U_BIG(&USBD_SCSI_ReadCapacityData[0], p_lun->NbrBlocks - 1);
-                     MEM_VAL_SET_INT32U_BIG(&USBD_SCSI_ReadCapacityData[4], p_lun->BlockSize);
-                     USBD_SCSI_RespBufPtr = &USBD_SCSI_ReadCapacityData[0];
-                     USBD_SCSI_RespLen    =  USBD_SCSI_RD_CAPACITY_10_PARAM_DATA_LEN;
+                     MEM_VAL_SET_INT32U_BIG(&p_ctx->ReadCapacityData[0], p_lun->NbrBlocks - 1);
+                     MEM_VAL_SET_INT32U_BIG(&p_ctx->ReadCapacityData[4], p_lun->BlockSize);
+                     p_ctx->RespBufPtr = &p_ctx->ReadCapacityData[0];
+                     p_ctx->RespLen    =  USBD_SCSI_RD_CAPACITY_10_PARAM_DATA_LEN;
 
                  } else {
                      nbr_blks = p_lun->NbrBlocks - 1;
-                     MEM_VAL_COPY_SET_INTU_BIG(&USBD_SCSI_ReadCapacityData[0], &nbr_blks, 8u);
-                     MEM_VAL_SET_INT32U_BIG(&USBD_SCSI_ReadCapacityData[8], p_lun->BlockSize);
-                     USBD_SCSI_RespBufPtr = &USBD_SCSI_ReadCapacityData[0];
-                     USBD_SCSI_RespLen    =  USBD_SCSI_RD_CAPACITY_16_PARAM_DATA_LEN;
+                     MEM_VAL_COPY_SET_INTU_BIG(&p_ctx->ReadCapacityData[0], &nbr_blks, 8u);
+                     MEM_VAL_SET_INT32U_BIG(&p_ctx->ReadCapacityData[8], p_lun->BlockSize);
+#if (USBD_MSC_CFG_UNMAP_EN == DEF_ENABLED)
+                                                                /* Logical blk provisioning en'd (see Note #20).        */
+                     p_ctx->ReadCapacityData[14] = USBD_SCSI_RD_CAPACITY_16_LBPME;
+#else
+                     p_ctx->ReadCapacityData[14] = 0x00;
+#endif
+                     p_ctx->RespBufPtr = &p_ctx->ReadCapacityData[0];
+                     p_ctx->RespLen    =  USBD_SCSI_RD_CAPACITY_16_PARAM_DATA_LEN;
                  }
                 *p_data_dir = USBD_SCSI_CBW_DEVICE_TO_HOST;
              }
@@ -977,32 +1144,41 @@ void  USBD_SCSI_CmdProcess (      USBD_MSC_LUN_CTRL  *p_lun,
                 USBD_StorageStatusGet(p_storage_lun, p_err);
              }
 
-             USBD_SCSI_LunStatusAnalyze(*p_err);                /* Check err code & build req sense data.               */
+             USBD_SCSI_LunStatusAnalyze(p_ctx, *p_err);         /* Check err code & build req sense data.               */
              if (*p_err == USBD_ERR_NONE){
 
                  if (scsi_cmd == USBD_SCSI_CMD_READ_10){
                                                                 /* Get the LBA from where data has to be rd.            */
-                     USBD_SCSI_LBAddr = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[2]);
+                     p_ctx->LBAddr = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[2]);
                                                                 /* Nbr of log blks that shall be rd.                    */
-                     USBD_SCSI_LBCnt  = MEM_VAL_GET_INT16U_BIG(&p_cbwcb[7]);
+                     p_ctx->LBCnt  = MEM_VAL_GET_INT16U_BIG(&p_cbwcb[7]);
 
                  } else if (scsi_cmd == USBD_SCSI_CMD_READ_12){
                                                                 /* Get the LBA from where data has to be rd.            */
-                     USBD_SCSI_LBAddr = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[2]);
+                     p_ctx->LBAddr = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[2]);
                                                                 /* Nbr of log blks that shall be rd.                    */
-                     USBD_SCSI_LBCnt  = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[6]);
+                     p_ctx->LBCnt  = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[6]);
 
                  } else {
                                                                 /* Get the LBA from where data has to be rd.            */
-                     MEM_VAL_COPY_GET_INTU_BIG(&USBD_SCSI_LBAddr, &p_cbwcb[2], 8u);
+                     MEM_VAL_COPY_GET_INTU_BIG(&p_ctx->LBAddr, &p_cbwcb[2], 8u);
                                                                 /* Nbr of log blks that shall be rd.                    */
-                     USBD_SCSI_LBCnt = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[10]);
+                     p_ctx->LBCnt = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[10]);
                  }
-                 USBD_SCSI_RespBufPtr = (CPU_INT08U *)0;
-                 USBD_SCSI_RespLen    =  USBD_SCSI_LBCnt * (p_lun->BlockSize);
-                *p_data_dir           =  USBD_SCSI_CBW_DEVICE_TO_HOST;
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+                                                                /* Only short rd are inserted in the blk cache.         */
+                 p_ctx->CacheAlloc = (p_ctx->LBCnt <= USBD_MSC_CFG_CACHE_NBR_BLK) ? DEF_YES : DEF_NO;
+#endif
+#if (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+                                                                /* Detect sequential rd (see Note #5a).                 */
+                 USBD_StorageRdAheadCmd(&p_ctx->RdAhead, p_ctx->LBAddr, p_ctx->LBCnt);
+#endif
+                 p_ctx->RespBufPtr = (CPU_INT08U *)0;
+                 p_ctx->RespLen    =  p_ctx->LBCnt * (p_lun->BlockSize);
+                *p_data_dir        =  USBD_SCSI_CBW_DEVICE_TO_HOST;
                                                                 /* Build req sense data with no err cond.               */
-                 USBD_SCSI_ReqSenseDataUpdate(USBD_SCSI_SENSE_KEY_NO_SENSE,
+                 USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                              USBD_SCSI_SENSE_KEY_NO_SENSE,
                                               USBD_SCSI_ASC_NO_ADDITIONAL_SENSE_INFO,
                                               0x00);
              }
@@ -1017,15 +1193,17 @@ void  USBD_SCSI_CmdProcess (      USBD_MSC_LUN_CTRL  *p_lun,
              if ((p_storage_lun->LockFlag  == DEF_FALSE) ||     /* Logical unit not locked...                           */
                  (p_storage_lun->EjectFlag == DEF_TRUE )) {     /* Logical unit has been ejected by host...             */
                                                                 /* ...medium is considered not present.                 */
-                     USBD_SCSI_RespBufPtr = (CPU_INT08U *)0;
-                     USBD_SCSI_RespLen    =  0;
-                     USBD_SCSI_ReqSenseDataUpdate(USBD_SCSI_SENSE_KEY_NOT_RDY,
+                     p_ctx->RespBufPtr = (CPU_INT08U *)0;
+                     p_ctx->RespLen    =  0;
+                     USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                                  USBD_SCSI_SENSE_KEY_NOT_RDY,
                                                   USBD_SCSI_ASC_MEDIUM_NOT_PRESENT,
                                                   0x00);
              }
 
              if (p_lun->LunInfo.ReadOnly == DEF_TRUE) {         /* Check medium is wr protected or not.                 */
-                 USBD_SCSI_ReqSenseDataUpdate(USBD_SCSI_SENSE_KEY_DATA_PROTECT,
+                 USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                              USBD_SCSI_SENSE_KEY_DATA_PROTECT,
                                               USBD_SCSI_ASC_WR_PROTECTED,
                                               0x00);
                 *p_err = USBD_ERR_SCSI_UNSUPPORTED_CMD;
@@ -1034,27 +1212,36 @@ void  USBD_SCSI_CmdProcess (      USBD_MSC_LUN_CTRL  *p_lun,
 
              if (scsi_cmd == USBD_SCSI_CMD_WRITE_10) {
                                                                 /* Get the LBA from where data has to be written.       */
-                 USBD_SCSI_LBAddr = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[2]);
+                 p_ctx->LBAddr = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[2]);
                                                                 /* Nbr of log blks that shall be written.               */
-                 USBD_SCSI_LBCnt  = MEM_VAL_GET_INT16U_BIG(&p_cbwcb[7]);
+                 p_ctx->LBCnt  = MEM_VAL_GET_INT16U_BIG(&p_cbwcb[7]);
 
              } else if (scsi_cmd == USBD_SCSI_CMD_WRITE_12) {
                                                                 /* Get the LBA from where data has to be written.       */
-                 USBD_SCSI_LBAddr = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[2]);
+                 p_ctx->LBAddr = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[2]);
                                                                 /* Nbr of log blks that shall be written.               */
-                 USBD_SCSI_LBCnt  = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[6]);
+                 p_ctx->LBCnt  = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[6]);
 
              } else {
                                                                 /* Get the LBA from where data has to be written.       */
-                 MEM_VAL_COPY_GET_INTU_BIG(&USBD_SCSI_LBAddr, &p_cbwcb[2], 8u);
+                 MEM_VAL_COPY_GET_INTU_BIG(&p_ctx->LBAddr, &p_cbwcb[2], 8u);
                                                                 /* Nbr of log blks that shall be written.               */
-                 USBD_SCSI_LBCnt  = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[10]);
+                 p_ctx->LBCnt  = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[10]);
              }
-             USBD_SCSI_RespBufPtr = (CPU_INT08U *)0;
-             USBD_SCSI_RespLen    =  USBD_SCSI_LBCnt * (p_lun->BlockSize);
-            *p_data_dir           =  USBD_SCSI_CBW_HOST_TO_DEVICE;
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+                                                                /* Only short wr are inserted in the blk cache.         */
+             p_ctx->CacheAlloc = (p_ctx->LBCnt <= USBD_MSC_CFG_CACHE_NBR_BLK) ? DEF_YES : DEF_NO;
+#endif
+#if (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+                                                                /* Drop read-ahead blks being wr (see Note #5a).        */
+             USBD_StorageRdAheadDiscard(&p_ctx->RdAhead, p_ctx->LBAddr, p_ctx->LBCnt);
+#endif
+             p_ctx->RespBufPtr = (CPU_INT08U *)0;
+             p_ctx->RespLen    =  p_ctx->LBCnt * (p_lun->BlockSize);
+            *p_data_dir        =  USBD_SCSI_CBW_HOST_TO_DEVICE;
                                                                 /* Build req sense data with no err cond.               */
-             USBD_SCSI_ReqSenseDataUpdate(USBD_SCSI_SENSE_KEY_NO_SENSE,
+             USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                          USBD_SCSI_SENSE_KEY_NO_SENSE,
                                           USBD_SCSI_ASC_NO_ADDITIONAL_SENSE_INFO,
                                           0x00);
              break;
@@ -1067,31 +1254,31 @@ void  USBD_SCSI_CmdProcess (      USBD_MSC_LUN_CTRL  *p_lun,
 
              if (scsi_cmd == USBD_SCSI_CMD_VERIFY_10){
                                                                 /* Get the LBA of where data has to be verified.        */
-                 USBD_SCSI_LBAddr = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[2]);
+                 p_ctx->LBAddr = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[2]);
                                                                 /* Nbr of log blks that shall  be verified.             */
-                 USBD_SCSI_LBCnt  = MEM_VAL_GET_INT16U_BIG(&p_cbwcb[7]);
+                 p_ctx->LBCnt  = MEM_VAL_GET_INT16U_BIG(&p_cbwcb[7]);
 
              } else if (scsi_cmd == USBD_SCSI_CMD_VERIFY_12) {
                                                                 /* Get the LBA of where data has to be verified.        */
-                 USBD_SCSI_LBAddr = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[2]);
+                 p_ctx->LBAddr = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[2]);
                                                                 /* Nbr of log blks that shall  be verified.             */
-                 USBD_SCSI_LBCnt  = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[6]);
+                 p_ctx->LBCnt  = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[6]);
 
              } else {
                                                                 /* Get the LBA of where data has to be verified.        */
-                 MEM_VAL_COPY_GET_INTU_BIG(&USBD_SCSI_LBAddr, &p_cbwcb[2], 8u);
+                 MEM_VAL_COPY_GET_INTU_BIG(&p_ctx->LBAddr, &p_cbwcb[2], 8u);
                                                                 /* Nbr of log blks that shall  be verified.             */
-                 USBD_SCSI_LBCnt = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[10]);
+                 p_ctx->LBCnt = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[10]);
              }
 
-             total_area_size_verifd = USBD_SCSI_LBAddr * USBD_SCSI_LBCnt;
+             total_area_size_verifd = p_ctx->LBAddr * p_ctx->LBCnt;
              total_lu_size          = p_lun->NbrBlocks * p_lun->BlockSize;
              if (total_area_size_verifd > total_lu_size) {
                 *p_err = USBD_ERR_SCSI_LOG_BLOCK_ADDR;
              }
-             USBD_SCSI_LunStatusAnalyze(*p_err);                /* Check err code & build req sense data.               */
-             USBD_SCSI_RespBufPtr = (CPU_INT08U *)0;
-             USBD_SCSI_RespLen    = 0;
+             USBD_SCSI_LunStatusAnalyze(p_ctx, *p_err);         /* Check err code & build req sense data.               */
+             p_ctx->RespBufPtr = (CPU_INT08U *)0;
+             p_ctx->RespLen    = 0;
              break;
 
 
@@ -1106,7 +1293,7 @@ void  USBD_SCSI_CmdProcess (      USBD_MSC_LUN_CTRL  *p_lun,
                  USBD_StorageStatusGet(p_storage_lun, p_err);
              }
 
-             USBD_SCSI_LunStatusAnalyze(*p_err);                /* Check err code & build req sense data.               */
+             USBD_SCSI_LunStatusAnalyze(p_ctx, *p_err);         /* Check err code & build req sense data.               */
              if (*p_err == USBD_ERR_NONE){
                                                                 /* Get page code.                                       */
                  page_code = p_cbwcb[2] & USBD_SCSI_MSK_PAGE_CODE;
@@ -1114,23 +1301,25 @@ void  USBD_SCSI_CmdProcess (      USBD_MSC_LUN_CTRL  *p_lun,
                  if (*p_err == USBD_ERR_NONE) {
 
                      if (scsi_cmd == USBD_SCSI_CMD_MODE_SENSE_06) {
-                         len = DEF_MIN(USBD_SCSI_ModeSenseData[0] + 1, p_cbwcb[4]);
+                         len = DEF_MIN(p_ctx->ModeSenseData[0] + 1, p_cbwcb[4]);
 
                      } else {
                          len = (p_cbwcb[7] << 8u) |
                                 p_cbwcb[8];
-                         len = DEF_MIN(((CPU_INT32U)USBD_SCSI_ModeSenseData[0] + 1), len);
+                         len = DEF_MIN(((CPU_INT32U)p_ctx->ModeSenseData[0] + 1), len);
 
                      }
-                     USBD_SCSI_RespBufPtr = &USBD_SCSI_ModeSenseData[0];
-                     USBD_SCSI_RespLen    =  len;               /* Nbr of bytes of data that shall be xfered.           */
-                    *p_data_dir           =  USBD_SCSI_CBW_DEVICE_TO_HOST;
-                     USBD_SCSI_ReqSenseDataUpdate(USBD_SCSI_SENSE_KEY_NO_SENSE,
+                     p_ctx->RespBufPtr = &p_ctx->ModeSenseData[0];
+                     p_ctx->RespLen    =  len;                  /* Nbr of bytes of data that shall be xfered.           */
+                    *p_data_dir        =  USBD_SCSI_CBW_DEVICE_TO_HOST;
+                     USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                                  USBD_SCSI_SENSE_KEY_NO_SENSE,
                                                   USBD_SCSI_ASC_NO_ADDITIONAL_SENSE_INFO,
                                                   0x00);
 
                  } else {
-                     USBD_SCSI_ReqSenseDataUpdate(USBD_SCSI_SENSE_KEY_ILLEGAL_REQUEST,
+                     USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                                  USBD_SCSI_SENSE_KEY_ILLEGAL_REQUEST,
                                                   USBD_SCSI_ASC_INVALID_FIELD_IN_CDB,
                                                   0x00);
                  }
@@ -1141,13 +1330,14 @@ void  USBD_SCSI_CmdProcess (      USBD_MSC_LUN_CTRL  *p_lun,
         case USBD_SCSI_CMD_REQUEST_SENSE:                       /* ----------- REQUEST SENSE(see Notes #16) ----------- */
              USBD_DBG_MSC_SCSI_MSG("SCSI: REQUEST SENSE Command");
              len                        =  DEF_MIN(USBD_SCSI_REQ_SENSE_DATA_LEN, p_cbwcb[4]);
-             USBD_SCSI_ReqSenseData[2]  =  USBD_SCSI_SenseKey;
-             USBD_SCSI_ReqSenseData[12] =  USBD_SCSI_ASC;
-             USBD_SCSI_ReqSenseData[13] =  USBD_SCSI_ASCQ;
-             USBD_SCSI_RespBufPtr       = &USBD_SCSI_ReqSenseData[0];
-             USBD_SCSI_RespLen          =  len;                 /* Nbr of bytes of data that shall be xferred.          */
-            *p_data_dir                 =  USBD_SCSI_CBW_DEVICE_TO_HOST;
-             USBD_SCSI_ReqSenseDataUpdate(USBD_SCSI_SENSE_KEY_NO_SENSE,
+             p_ctx->ReqSenseData[2]  =  p_ctx->SenseKey;
+             p_ctx->ReqSenseData[12] =  p_ctx->ASC;
+             p_ctx->ReqSenseData[13] =  p_ctx->ASCQ;
+             p_ctx->RespBufPtr       = &p_ctx->ReqSenseData[0];
+             p_ctx->RespLen          =  len;                    /* Nbr of bytes of data that shall be xferred.          */
+            *p_data_dir              =  USBD_SCSI_CBW_DEVICE_TO_HOST;
+             USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                          USBD_SCSI_SENSE_KEY_NO_SENSE,
                                           USBD_SCSI_ASC_NO_ADDITIONAL_SENSE_INFO,
                                           0x00);
              break;
@@ -1156,9 +1346,10 @@ void  USBD_SCSI_CmdProcess (      USBD_MSC_LUN_CTRL  *p_lun,
         case USBD_SCSI_CMD_PREVENT_ALLOW_MEDIUM_REMOVAL:        /* --- PREVENT ALLOW MEDIUM REMOVAL (see Notes #17) --- */
              USBD_DBG_MSC_SCSI_MSG("SCSI: PREVENT ALLOW MEDIUM REMOVAL Command");
 
-             USBD_SCSI_RespBufPtr = (CPU_INT08U *)0;
-             USBD_SCSI_RespLen    = 0;
-             USBD_SCSI_ReqSenseDataUpdate(USBD_SCSI_SENSE_KEY_NO_SENSE,
+             p_ctx->RespBufPtr = (CPU_INT08U *)0;
+             p_ctx->RespLen    = 0;
+             USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                          USBD_SCSI_SENSE_KEY_NO_SENSE,
                                           USBD_SCSI_ASC_NO_ADDITIONAL_SENSE_INFO,
                                           0x00);
              break;
@@ -1170,24 +1361,43 @@ void  USBD_SCSI_CmdProcess (      USBD_MSC_LUN_CTRL  *p_lun,
              loej       = p_cbwcb[4] & USBD_SCSI_START_STOP_UNIT_LOEJ;
              start_flag = p_cbwcb[4] & USBD_SCSI_START_STOP_UNIT_START;
 
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+             if (DEF_BIT_IS_CLR(start_flag, USBD_SCSI_START_STOP_UNIT_START) == DEF_YES) {
+                                                                /* Wr cached blks to medium (see Note #18a).            */
+                 USBD_StorageCacheFlush(&p_ctx->Cache, p_storage_lun, p_err);
+                 if (*p_err != USBD_ERR_NONE) {
+                     p_ctx->RespBufPtr = (CPU_INT08U *)0;
+                     p_ctx->RespLen    = 0;
+                     USBD_SCSI_LunStatusAnalyze(p_ctx, *p_err);
+                     break;
+                 }
+             }
+#endif
                                                                 /* Eject the medium.                                    */
              if ((DEF_BIT_IS_SET(loej,       USBD_SCSI_START_STOP_UNIT_LOEJ)  == DEF_YES) &&
                  (DEF_BIT_IS_CLR(start_flag, USBD_SCSI_START_STOP_UNIT_START) == DEF_YES)) {
 
                  p_storage_lun->EjectFlag = DEF_TRUE;           /* Flag logical unit as ejected.                        */
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+                 USBD_StorageCacheInvalidate(&p_ctx->Cache);    /* See Note #18a.                                       */
+#endif
+#if (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+                 USBD_StorageRdAheadInvalidate(&p_ctx->RdAhead);/* See Note #18a.                                       */
+#endif
 
                  USBD_StorageUnlock(p_storage_lun, p_err);
                  p_storage_lun->LockFlag = DEF_FALSE;
-                 USBD_SCSI_LunStatusAnalyze(*p_err);            /* Check err code & build req sense data.               */
+                 USBD_SCSI_LunStatusAnalyze(p_ctx, *p_err);     /* Check err code & build req sense data.               */
                  if (*p_err != USBD_ERR_NONE ) {
                      break;
                  }
              } else {
 
-                 USBD_SCSI_RespBufPtr = (CPU_INT08U *)0;
-                 USBD_SCSI_RespLen    = 0;
+                 p_ctx->RespBufPtr = (CPU_INT08U *)0;
+                 p_ctx->RespLen    = 0;
                 *p_err = USBD_ERR_SCSI_UNSUPPORTED_CMD;
-                 USBD_SCSI_ReqSenseDataUpdate(USBD_SCSI_SENSE_KEY_ILLEGAL_REQUEST,
+                 USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                              USBD_SCSI_SENSE_KEY_ILLEGAL_REQUEST,
                                               USBD_SCSI_ASC_NO_ADDITIONAL_SENSE_INFO,
                                               0x00);
              }
@@ -1195,19 +1405,159 @@ void  USBD_SCSI_CmdProcess (      USBD_MSC_LUN_CTRL  *p_lun,
              break;
 
 
+        case USBD_SCSI_CMD_SYNCHRONIZE_CACHE_10:                /* --------- SYNCHRONIZE CACHE (see Note #19) --------- */
+        case USBD_SCSI_CMD_SYNCHRONIZE_CACHE_16:
+             USBD_DBG_MSC_SCSI_MSG("SCSI: SYNCHRONIZE CACHE Command");
+
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+             USBD_StorageCacheFlush(&p_ctx->Cache, p_storage_lun, p_err);
+#endif
+             USBD_SCSI_LunStatusAnalyze(p_ctx, *p_err);         /* Check err code & build req sense data.               */
+             p_ctx->RespBufPtr = (CPU_INT08U *)0;
+             p_ctx->RespLen    = 0;
+             break;
+
+
+        case USBD_SCSI_CMD_WRITE_SAME_10:                       /* ---------- WRITE SAME(10) (see Note #21) ----------- */
+        case USBD_SCSI_CMD_WRITE_SAME_16:                       /* ---------- WRITE SAME(16) (see Note #21) ----------- */
+             USBD_DBG_MSC_SCSI_MSG("SCSI: WRITE SAME 10 / 16 Command");
+
+             if ((p_storage_lun->LockFlag  == DEF_FALSE) ||     /* Logical unit not locked...                           */
+                 (p_storage_lun->EjectFlag == DEF_TRUE )) {     /* Logical unit has been ejected by host...             */
+                *p_err = USBD_ERR_SCSI_MEDIUM_NOTPRESENT;       /* ...medium is considered not present.                 */
+             } else {                                           /* Get logical unit status.                             */
+                 USBD_StorageStatusGet(p_storage_lun, p_err);
+             }
+
+             USBD_SCSI_LunStatusAnalyze(p_ctx, *p_err);         /* Check err code & build req sense data.               */
+             p_ctx->RespBufPtr = (CPU_INT08U *)0;
+             p_ctx->RespLen    =  0;
+             if (*p_err != USBD_ERR_NONE) {
+                 break;
+             }
+
+             if (p_lun->LunInfo.ReadOnly == DEF_TRUE) {         /* Check medium is wr protected or not.                 */
+                 USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                              USBD_SCSI_SENSE_KEY_DATA_PROTECT,
+                                              USBD_SCSI_ASC_WR_PROTECTED,
+                                              0x00);
+                *p_err = USBD_ERR_SCSI_UNSUPPORTED_CMD;
+                 break;
+             }
+
+             if (scsi_cmd == USBD_SCSI_CMD_WRITE_SAME_10) {
+                                                                /* Get the LBA from where data has to be written.       */
+                 p_ctx->LBAddr = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[2]);
+                                                                /* Nbr of log blks that shall be written.               */
+                 p_ctx->LBCnt  = MEM_VAL_GET_INT16U_BIG(&p_cbwcb[7]);
+
+             } else {
+                                                                /* Get the LBA from where data has to be written.       */
+                 MEM_VAL_COPY_GET_INTU_BIG(&p_ctx->LBAddr, &p_cbwcb[2], 8u);
+                                                                /* Nbr of log blks that shall be written.               */
+                 p_ctx->LBCnt  = MEM_VAL_GET_INT32U_BIG(&p_cbwcb[10]);
+             }
+
+             if ((p_ctx->LBCnt == 0u) ||                        /* See Note #21.                                        */
+                 (p_ctx->LBCnt >  USBD_SCSI_VPD_MAX_WR_SAME_LEN)) {
+                 USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                              USBD_SCSI_SENSE_KEY_ILLEGAL_REQUEST,
+                                              USBD_SCSI_ASC_INVALID_FIELD_IN_CDB,
+                                              0x00);
+                *p_err = USBD_ERR_SCSI_UNSUPPORTED_CMD;
+                 break;
+             }
+
+             if ((p_ctx->LBAddr >= p_lun->NbrBlocks) ||
+                 (p_ctx->LBCnt  > (p_lun->NbrBlocks - p_ctx->LBAddr))) {
+                *p_err = USBD_ERR_SCSI_LOG_BLOCK_ADDR;
+                 USBD_SCSI_LunStatusAnalyze(p_ctx, *p_err);
+                 break;
+             }
+#if (USBD_MSC_CFG_UNMAP_EN == DEF_ENABLED)
+                                                                /* See Note #21a.                                       */
+             p_ctx->WrSameUnmap = DEF_BIT_IS_SET(p_cbwcb[1], USBD_SCSI_WR_SAME_UNMAP);
+#endif
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+                                                                /* Only short wr are inserted in the blk cache.         */
+             p_ctx->CacheAlloc = (p_ctx->LBCnt <= USBD_MSC_CFG_CACHE_NBR_BLK) ? DEF_YES : DEF_NO;
+#endif
+#if (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+                                                                /* Drop read-ahead blks being wr (see Note #5a).        */
+             USBD_StorageRdAheadDiscard(&p_ctx->RdAhead, p_ctx->LBAddr, p_ctx->LBCnt);
+#endif
+             p_ctx->RespLen =  p_lun->BlockSize;                /* Rx a single blk.                                     */
+            *p_data_dir     =  USBD_SCSI_CBW_HOST_TO_DEVICE;
+             break;
+
+
+#if (USBD_MSC_CFG_UNMAP_EN == DEF_ENABLED)
+        case USBD_SCSI_CMD_UNMAP:                               /* --------------- UNMAP (see Note #20) --------------- */
+             USBD_DBG_MSC_SCSI_MSG("SCSI: UNMAP Command");
+
+             if ((p_storage_lun->LockFlag  == DEF_FALSE) ||     /* Logical unit not locked...                           */
+                 (p_storage_lun->EjectFlag == DEF_TRUE )) {     /* Logical unit has been ejected by host...             */
+                *p_err = USBD_ERR_SCSI_MEDIUM_NOTPRESENT;       /* ...medium is considered not present.                 */
+             } else {                                           /* Get logical unit status.                             */
+                 USBD_StorageStatusGet(p_storage_lun, p_err);
+             }
+
+             USBD_SCSI_LunStatusAnalyze(p_ctx, *p_err);         /* Check err code & build req sense data.               */
+             p_ctx->RespBufPtr = (CPU_INT08U *)0;
+             p_ctx->RespLen    =  0;
+             if (*p_err != USBD_ERR_NONE) {
+                 break;
+             }
+
+             if (p_lun->LunInfo.ReadOnly == DEF_TRUE) {         /* Check medium is wr protected or not.                 */
+                 USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                              USBD_SCSI_SENSE_KEY_DATA_PROTECT,
+                                              USBD_SCSI_ASC_WR_PROTECTED,
+                                              0x00);
+                *p_err = USBD_ERR_SCSI_UNSUPPORTED_CMD;
+                 break;
+             }
+                                                                /* Get the param list len.                              */
+             len = MEM_VAL_GET_INT16U_BIG(&p_cbwcb[7]);
+             if (len > USBD_SCSI_UNMAP_PARAM_DATA_LEN) {        /* See Note #20a.                                       */
+                 USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                              USBD_SCSI_SENSE_KEY_ILLEGAL_REQUEST,
+                                              USBD_SCSI_ASC_INVALID_FIELD_IN_CDB,
+                                              0x00);
+                *p_err = USBD_ERR_SCSI_UNSUPPORTED_CMD;
+                 break;
+             }
+             if ((len > 0u) &&
+                 (len < USBD_SCSI_UNMAP_PARAM_HDR_LEN)) {
+                 USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                              USBD_SCSI_SENSE_KEY_ILLEGAL_REQUEST,
+                                              USBD_SCSI_ASC_PARAMETER_LIST_LENGTH_ERR,
+                                              0x00);
+                *p_err = USBD_ERR_SCSI_UNSUPPORTED_CMD;
+                 break;
+             }
+
+             p_ctx->UnmapParamLen =  0u;
+             p_ctx->RespLen       =  len;                       /* See Note #20b.                                       */
+            *p_data_dir           =  USBD_SCSI_CBW_HOST_TO_DEVICE;
+             break;
+#endif
+
+
         default :                                               /* Cmd not supported.                                   */
              USBD_DBG_MSC_SCSI_MSG("SCSI: UNSUPPORTED Command");
-             USBD_SCSI_RespBufPtr = (CPU_INT08U *)0;
-             USBD_SCSI_RespLen    = 0;
+             p_ctx->RespBufPtr = (CPU_INT08U *)0;
+             p_ctx->RespLen    = 0;
             *p_err                = USBD_ERR_SCSI_UNSUPPORTED_CMD;
-             USBD_SCSI_ReqSenseDataUpdate(USBD_SCSI_SENSE_KEY_ILLEGAL_REQUEST,
+             USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                          USBD_SCSI_SENSE_KEY_ILLEGAL_REQUEST,
                                           USBD_SCSI_ASC_NO_ADDITIONAL_SENSE_INFO,
                                           0x00);
              break;
     }
 
     if (*p_err == USBD_ERR_NONE) {
-       *p_resp_len = USBD_SCSI_RespLen;                         /* SCSI supported len.                                  */
+       *p_resp_len = p_ctx->RespLen;                            /* SCSI supported len.                                  */
     }
 }
 
@@ -1252,9 +1602,12 @@ void  USBD_SCSI_DataRd (const USBD_MSC_LUN_CTRL  *p_lun,
                               CPU_INT32U         *p_ret_len,
                               USBD_ERR           *p_err)
 {
-    CPU_INT32U  lb_cnt;
+    CPU_INT32U          lb_cnt;
+    USBD_SCSI_LUN_CTX  *p_ctx;
 
 
+    p_ctx = &USBD_SCSI_LunCtxTbl[p_lun->ClassNbr][p_lun->LunNbr];
+
     switch (scsi_cmd) {
         case USBD_SCSI_CMD_READ_10:
         case USBD_SCSI_CMD_READ_12:
@@ -1262,19 +1615,38 @@ void  USBD_SCSI_DataRd (const USBD_MSC_LUN_CTRL  *p_lun,
              USBD_DBG_MSC_SCSI_MSG("SCSI Read data from Disk.");
              lb_cnt = data_len / p_lun->BlockSize;              /* Nbr of blks that can fit in scsi_data_buf.           */
 
-             USBD_StorageRd(&USBD_SCSI_LunTbl[p_lun->LunNbr],
-                             USBD_SCSI_LBAddr,
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+             USBD_StorageCacheRd(&p_ctx->Cache,
+                                 &p_ctx->StorageLun,
+                                  p_ctx->LBAddr,
+                                  lb_cnt,
+                                  p_lun->BlockSize,
+                                  p_ctx->CacheAlloc,
+                                  p_data_buf,
+                                  p_err);
+#elif (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+             USBD_StorageRdAheadRd(&p_ctx->RdAhead,
+                                   &p_ctx->StorageLun,
+                                    p_ctx->LBAddr,
+                                    lb_cnt,
+                                    p_lun->BlockSize,
+                                    p_data_buf,
+                                    p_err);
+#else
+             USBD_StorageRd(&p_ctx->StorageLun,
+                             p_ctx->LBAddr,
                              lb_cnt,
                              p_data_buf,
                              p_err);
+#endif
 
-             USBD_SCSI_LunStatusAnalyze(*p_err);                /* Check err code & build req sense data.               */
+             USBD_SCSI_LunStatusAnalyze(p_ctx, *p_err);         /* Check err code & build req sense data.               */
              if (*p_err != USBD_ERR_NONE) {
                  return;
              }
-             USBD_SCSI_LBAddr += lb_cnt;
-             USBD_SCSI_LBCnt  -= lb_cnt;
-             if (USBD_SCSI_LBCnt > 0) {                         /* More data has to be transferred.                     */
+             p_ctx->LBAddr += lb_cnt;
+             p_ctx->LBCnt  -= lb_cnt;
+             if (p_ctx->LBCnt > 0) {                            /* More data has to be transferred.                     */
                 *p_err = USBD_ERR_SCSI_MORE_DATA;
              } else {
                 *p_err = USBD_ERR_NONE;
@@ -1284,15 +1656,15 @@ void  USBD_SCSI_DataRd (const USBD_MSC_LUN_CTRL  *p_lun,
 
 
         default:                                                /* See Note #1.                                         */
-             if (data_len < USBD_SCSI_RespLen) {                /* More data than mass sto req'd.                       */
+             if (data_len < p_ctx->RespLen) {                   /* More data than mass sto req'd.                       */
                 *p_ret_len = data_len;
                 *p_err     = USBD_ERR_SCSI_MORE_DATA;
              } else {
-                *p_ret_len = USBD_SCSI_RespLen;
+                *p_ret_len = p_ctx->RespLen;
                 *p_err     = USBD_ERR_NONE;
              }
              Mem_Copy((void *)p_data_buf,                       /* Retrieve resp buf answering SCSI cmd.                */
-                      (void *)USBD_SCSI_RespBufPtr,
+                      (void *)p_ctx->RespBufPtr,
                              *p_ret_len);
              break;
     }
@@ -1319,13 +1691,20 @@ void  USBD_SCSI_DataRd (const USBD_MSC_LUN_CTRL  *p_lun,
 *                                                                   to write.
 *                               USBD_ERR_SCSI_MORE_DATA             Write was successful & more data to write.
 *                               USBD_ERR_SCSI_UNSUPPORTED_CMD       Command not supported.
+*                               USBD_ERR_SCSI_LOG_BLOCK_ADDR        UNMAP block descriptor out of range.
 *
                                                                     ---- RETURNED BY USBD_StorageWr() : ---
 *                               USBD_ERR_SCSI_MEDIUM_NOTPRESENT     Writing to logical unit failed.
 *
 * Return(s)   : None.
 *
-* Note(s)     : None.
+* Note(s)     : (1) SCSI commands that require a Data OUT phase are: WRITE, WRITE SAME and UNMAP.
+*
+*               (2) WRITE SAME receives a single block, which is written to every block of the range, or
+*                   releases the range (see USBD_SCSI_CmdProcess(), Note #21).
+*
+*               (3) The UNMAP parameter list is accumulated until it is complete, then its block descriptors
+*                   are processed (see USBD_SCSI_CmdProcess(), Note #20).
 **********************************************************************************************************
 */
 
@@ -1335,8 +1714,14 @@ void  USBD_SCSI_DataWr (const USBD_MSC_LUN_CTRL  *p_lun,
                               CPU_INT32U          data_len,
                               USBD_ERR           *p_err)
 {
-    CPU_INT32U  lb_cnt;
+    CPU_INT32U          lb_cnt;
+#if (USBD_MSC_CFG_UNMAP_EN == DEF_ENABLED)
+    CPU_INT32U          len;
+#endif
+    USBD_SCSI_LUN_CTX  *p_ctx;
+
 
+    p_ctx = &USBD_SCSI_LunCtxTbl[p_lun->ClassNbr][p_lun->LunNbr];
 
     switch (scsi_cmd) {
         case USBD_SCSI_CMD_WRITE_10:
@@ -1345,19 +1730,30 @@ void  USBD_SCSI_DataWr (const USBD_MSC_LUN_CTRL  *p_lun,
              USBD_DBG_MSC_SCSI_MSG("SCSI Write data to Disk.");
              lb_cnt = data_len / (p_lun->BlockSize);            /* Nbr of blks present in scsi_data_buf.                */
 
-             USBD_StorageWr(&USBD_SCSI_LunTbl[p_lun->LunNbr],
-                             USBD_SCSI_LBAddr,
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+             USBD_StorageCacheWr(&p_ctx->Cache,
+                                 &p_ctx->StorageLun,
+                                  p_ctx->LBAddr,
+                                  lb_cnt,
+                                  p_lun->BlockSize,
+                                  p_ctx->CacheAlloc,
+                                  p_data_buf,
+                                  p_err);
+#else
+             USBD_StorageWr(&p_ctx->StorageLun,
+                             p_ctx->LBAddr,
                              lb_cnt,
                              p_data_buf,
                              p_err);
+#endif
 
-             USBD_SCSI_LunStatusAnalyze(*p_err);                /* Check err code & build req sense data.               */
+             USBD_SCSI_LunStatusAnalyze(p_ctx, *p_err);         /* Check err code & build req sense data.               */
              if (*p_err != USBD_ERR_NONE) {
                  return;
              }
-             USBD_SCSI_LBAddr += lb_cnt;
-             USBD_SCSI_LBCnt  -= lb_cnt;
-             if (USBD_SCSI_LBCnt > 0) {                         /* More data has to be xferred.                         */
+             p_ctx->LBAddr += lb_cnt;
+             p_ctx->LBCnt  -= lb_cnt;
+             if (p_ctx->LBCnt > 0) {                            /* More data has to be xferred.                         */
                 *p_err = USBD_ERR_SCSI_MORE_DATA;
              } else {
                 *p_err = USBD_ERR_NONE;
@@ -1365,9 +1761,65 @@ void  USBD_SCSI_DataWr (const USBD_MSC_LUN_CTRL  *p_lun,
              break;
 
 
+        case USBD_SCSI_CMD_WRITE_SAME_10:                       /* See Note #2.                                         */
+        case USBD_SCSI_CMD_WRITE_SAME_16:
+#if (USBD_MSC_CFG_UNMAP_EN == DEF_ENABLED)
+             if (p_ctx->WrSameUnmap == DEF_YES) {
+                 USBD_DBG_MSC_SCSI_MSG("SCSI Release blocks of Disk.");
+                 USBD_SCSI_Unmap(p_ctx, p_ctx->LBAddr, p_ctx->LBCnt, p_err);
+                 USBD_SCSI_LunStatusAnalyze(p_ctx, *p_err);     /* Check err code & build req sense data.               */
+                 break;
+             }
+#endif
+             USBD_DBG_MSC_SCSI_MSG("SCSI Write same data to Disk.");
+            *p_err = USBD_ERR_NONE;
+             while ((p_ctx->LBCnt >  0u) &&                     /* Wr rx'd blk to each blk of the range.                */
+                    (*p_err       == USBD_ERR_NONE)) {
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+                 USBD_StorageCacheWr(&p_ctx->Cache,
+                                     &p_ctx->StorageLun,
+                                      p_ctx->LBAddr,
+                                      1u,
+                                      p_lun->BlockSize,
+                                      p_ctx->CacheAlloc,
+                                      p_data_buf,
+                                      p_err);
+#else
+                 USBD_StorageWr(&p_ctx->StorageLun,
+                                 p_ctx->LBAddr,
+                                 1u,
+                                 p_data_buf,
+                                 p_err);
+#endif
+                 p_ctx->LBAddr++;
+                 p_ctx->LBCnt--;
+             }
+             USBD_SCSI_LunStatusAnalyze(p_ctx, *p_err);         /* Check err code & build req sense data.               */
+             break;
+
+
+#if (USBD_MSC_CFG_UNMAP_EN == DEF_ENABLED)
+        case USBD_SCSI_CMD_UNMAP:                               /* See Note #3.                                         */
+             USBD_DBG_MSC_SCSI_MSG("SCSI Unmap parameter list.");
+             len = DEF_MIN(data_len, p_ctx->RespLen - p_ctx->UnmapParamLen);
+             Mem_Copy((void     *)&p_ctx->UnmapParamData[p_ctx->UnmapParamLen],
+                      (void     *) p_data_buf,
+                      (CPU_SIZE_T) len);
+             p_ctx->UnmapParamLen += len;
+             if (p_ctx->UnmapParamLen < p_ctx->RespLen) {       /* More data has to be xferred.                         */
+                *p_err = USBD_ERR_SCSI_MORE_DATA;
+                 break;
+             }
+
+             USBD_SCSI_UnmapParamProcess(p_lun, p_ctx, p_err);
+             break;
+#endif
+
+
          default:
             *p_err = USBD_ERR_SCSI_UNSUPPORTED_CMD;
-             USBD_SCSI_ReqSenseDataUpdate(USBD_SCSI_SENSE_KEY_ILLEGAL_REQUEST,
+             USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                          USBD_SCSI_SENSE_KEY_ILLEGAL_REQUEST,
                                           USBD_SCSI_ASC_NO_ADDITIONAL_SENSE_INFO,
                                           0x00);
              break;
@@ -1377,72 +1829,551 @@ void  USBD_SCSI_DataWr (const USBD_MSC_LUN_CTRL  *p_lun,
 
 /*
 **********************************************************************************************************
-*                                              USBD_SCSI_Reset()
+*                                           USBD_SCSI_DataRdPtrGet()
 *
-* Description : Reset the SCSI global variables when Bulk-Only Mass Storage Reset request is sent by the
-*               host.
+* Description : Get a pointer to the storage medium's data to be sent to the host.
 *
-* Argument(s) : None.
+* Argument(s) : p_lun           Pointer to Logical Unit information.
 *
-* Return(s)   : None.
+*               scsi_cmd        SCSI command operation code.
 *
-* Note(s)     : None.
-**********************************************************************************************************
-*/
-
-void  USBD_SCSI_Reset (void)
-{
-    USBD_SCSI_LBAddr     = 0;
-    USBD_SCSI_LBCnt      = 0;
-    USBD_SCSI_RespLen    = 0;
-    USBD_SCSI_RespBufPtr = (CPU_INT08U *)0;
-    USBD_SCSI_SenseKey   = 0;
-    USBD_SCSI_ASC        = 0;
-    USBD_SCSI_ASCQ       = 0;
-
-    USBD_DBG_MSC_SCSI_MSG("SCSI Reset");
-}
-
-
-/*
-**********************************************************************************************************
-*                                              USBD_SCSI_Conn()
+*               data_len        Number of bytes to read.
 *
-* Description : Reset eject flag upon new configuration activation.
+*               pp_data_buf     Pointer to variable that will receive the pointer to the data.
 *
-* Argument(s) : p_lun       Pointer to Logical Unit information.
+*               p_ret_len       Pointer to variable that will receive the number of bytes to send.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                       Pointer returned & no more data to be read.
+*                               USBD_ERR_SCSI_MORE_DATA             Pointer returned & more data to be read.
+*                               USBD_ERR_SCSI_NO_DIRECT_BUF         No direct pointer available (see Note #1).
 *
 * Return(s)   : None.
 *
-* Note(s)     : None.
+* Note(s)     : (1) When no pointer is returned, the read position is left untouched and the data must be
+*                   read with USBD_SCSI_DataRd(), which also reports any storage error to the host.
+*
+*               (2) The pointer is handed directly to the bulk endpoint, so it must satisfy the
+*                   controller's buffer alignment.
+*
+*               (3) Blocks of a cached logical unit must go through the block cache, which may hold more
+*                   recent data than the medium.
+*
+*               (4) Blocks read directly from the storage layer need no read-ahead. The sequential stream
+*                   is forgotten so that the window is not filled after the command.
 **********************************************************************************************************
 */
 
-void  USBD_SCSI_Conn (const USBD_MSC_LUN_CTRL  *p_lun)
+#if (USBD_MSC_CFG_ZERO_COPY_EN == DEF_ENABLED)
+void  USBD_SCSI_DataRdPtrGet (const USBD_MSC_LUN_CTRL    *p_lun,
+                                    CPU_INT08U            scsi_cmd,
+                                    CPU_INT32U            data_len,
+                                    CPU_INT08U          **pp_data_buf,
+                                    CPU_INT32U           *p_ret_len,
+                                    USBD_ERR             *p_err)
 {
-    USBD_SCSI_LunTbl[p_lun->LunNbr].LockFlag  = DEF_FALSE;
-    USBD_SCSI_LunTbl[p_lun->LunNbr].EjectFlag = DEF_FALSE;
+    CPU_INT32U          lb_cnt;
+    CPU_INT08U         *p_buf;
+    USBD_SCSI_LUN_CTX  *p_ctx;
+
+
+    p_ctx = &USBD_SCSI_LunCtxTbl[p_lun->ClassNbr][p_lun->LunNbr];
+
+    switch (scsi_cmd) {
+        case USBD_SCSI_CMD_READ_10:
+        case USBD_SCSI_CMD_READ_12:
+        case USBD_SCSI_CMD_READ_16:
+             lb_cnt = data_len / p_lun->BlockSize;
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+             if (USBD_StorageCacheIsEn(&p_ctx->Cache, p_lun->BlockSize) == DEF_YES) {
+                *p_err = USBD_ERR_SCSI_NO_DIRECT_BUF;           /* See Note #3.                                         */
+                 return;
+             }
+#endif
+
+             USBD_StorageRdPtrGet(&p_ctx->StorageLun,
+                                   p_ctx->LBAddr,
+                                   lb_cnt,
+                                  &p_buf,
+                                   p_err);
+             if (*p_err != USBD_ERR_NONE) {                     /* See Note #1.                                         */
+                *p_err = USBD_ERR_SCSI_NO_DIRECT_BUF;
+                 return;
+             }
+             if (((CPU_ADDR)p_buf % USBD_CFG_BUF_ALIGN_OCTETS) != 0u) {
+                *p_err = USBD_ERR_SCSI_NO_DIRECT_BUF;           /* See Note #2.                                         */
+                 return;
+             }
+
+             USBD_DBG_MSC_SCSI_MSG("SCSI Read data from Disk (direct).");
+#if (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+             USBD_StorageRdAheadInvalidate(&p_ctx->RdAhead);    /* See Note #4.                                         */
+#endif
+             p_ctx->LBAddr += lb_cnt;
+             p_ctx->LBCnt  -= lb_cnt;
+             if (p_ctx->LBCnt > 0) {                            /* More data has to be transferred.                     */
+                *p_err = USBD_ERR_SCSI_MORE_DATA;
+             } else {
+                *p_err = USBD_ERR_NONE;
+             }
+            *pp_data_buf = p_buf;
+            *p_ret_len   = data_len;
+             break;
+
+
+        default:                                                /* Resp data is prepared in the SCSI bufs.              */
+            *p_err = USBD_ERR_SCSI_NO_DIRECT_BUF;
+             break;
+    }
 }
 
 
 /*
 **********************************************************************************************************
-*                                              USBD_SCSI_Unlock()
+*                                           USBD_SCSI_DataWrPtrGet()
 *
-* Description : Unlock the SCSI Storage Medium.
+* Description : Get a pointer to the storage medium's data in which the host data will be received.
 *
-* Argument(s) : p_lun       Pointer to Logical Unit information.
+* Argument(s) : p_lun           Pointer to Logical Unit information.
+*
+*               scsi_cmd        SCSI command operation code.
+*
+*               data_len        Number of bytes to write.
+*
+*               pp_data_buf     Pointer to variable that will receive the pointer to the data.
 *
 *               p_err       Pointer to variable that will receive the return error code from this function :
 *
-*                               USBD_ERR_NONE   Eject flag successfully reset.
+*                               USBD_ERR_NONE                       Pointer successfully returned.
+*                               USBD_ERR_SCSI_NO_DIRECT_BUF         No direct pointer available (see Note #1).
 *
 * Return(s)   : None.
 *
-* Note(s)     : (1) Unlocking a logical unit can be done with a software eject (for instance Windows
-*                   right's click eject). In that case, the unlock operation must not be executed another
-*                   time. If a software eject has occurred, the unlock operation done upon physical
-*                   disconnection of the device must be discarded.
+* Note(s)     : (1) When no pointer is returned, the data must be received in an intermediate buffer. In
+*                   both cases, the write is completed by USBD_SCSI_DataWr(), which updates the write
+*                   position and reports any storage error to the host.
+*
+*               (2) The pointer is handed directly to the bulk endpoint, so it must satisfy the
+*                   controller's buffer alignment.
+*
+*               (3) Blocks of a cached logical unit must go through the block cache, which may hold more
+*                   recent data than the medium.
+**********************************************************************************************************
+*/
+
+void  USBD_SCSI_DataWrPtrGet (const USBD_MSC_LUN_CTRL    *p_lun,
+                                    CPU_INT08U            scsi_cmd,
+                                    CPU_INT32U            data_len,
+                                    CPU_INT08U          **pp_data_buf,
+                                    USBD_ERR             *p_err)
+{
+    CPU_INT32U          lb_cnt;
+    CPU_INT08U         *p_buf;
+    USBD_SCSI_LUN_CTX  *p_ctx;
+
+
+    p_ctx = &USBD_SCSI_LunCtxTbl[p_lun->ClassNbr][p_lun->LunNbr];
+
+    switch (scsi_cmd) {
+        case USBD_SCSI_CMD_WRITE_10:
+        case USBD_SCSI_CMD_WRITE_12:
+        case USBD_SCSI_CMD_WRITE_16:
+             lb_cnt = data_len / p_lun->BlockSize;
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+             if (USBD_StorageCacheIsEn(&p_ctx->Cache, p_lun->BlockSize) == DEF_YES) {
+                *p_err = USBD_ERR_SCSI_NO_DIRECT_BUF;           /* See Note #3.                                         */
+                 return;
+             }
+#endif
+
+             USBD_StorageWrPtrGet(&p_ctx->StorageLun,
+                                   p_ctx->LBAddr,
+                                   lb_cnt,
+                                  &p_buf,
+                                   p_err);
+             if (*p_err != USBD_ERR_NONE) {                     /* See Note #1.                                         */
+                *p_err = USBD_ERR_SCSI_NO_DIRECT_BUF;
+                 return;
+             }
+             if (((CPU_ADDR)p_buf % USBD_CFG_BUF_ALIGN_OCTETS) != 0u) {
+                *p_err = USBD_ERR_SCSI_NO_DIRECT_BUF;           /* See Note #2.                                         */
+                 return;
+             }
+
+            *pp_data_buf = p_buf;
+             break;
+
+
+        default:
+            *p_err = USBD_ERR_SCSI_NO_DIRECT_BUF;
+             break;
+    }
+}
+#endif
+
+
+/*
+**********************************************************************************************************
+*                                         USBD_SCSI_AsyncQDepthGet()
+*
+* Description : Get the number of asynchronous storage accesses a command can have in progress.
+*
+* Argument(s) : p_lun           Pointer to Logical Unit information.
+*
+*               scsi_cmd        SCSI command operation code.
+*
+* Return(s)   : Storage layer queue depth, or 0 if the command's data must be accessed with
+*               USBD_SCSI_DataRd() or USBD_SCSI_DataWr().
+*
+* Note(s)     : (1) Only the data of READ and WRITE commands can be accessed asynchronously. The other
+*                   commands with a data stage use the SCSI response buffers or process their data
+*                   block by block.
+*
+*               (2) Blocks of a cached logical unit must go through the block cache, which is accessed
+*                   synchronously. Likewise, READ commands of a logical unit using read-ahead must go
+*                   through the read-ahead window.
+**********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_STORAGE_ASYNC_EN == DEF_ENABLED)
+CPU_INT08U  USBD_SCSI_AsyncQDepthGet (const USBD_MSC_LUN_CTRL  *p_lun,
+                                            CPU_INT08U          scsi_cmd)
+{
+    CPU_INT08U          q_depth;
+    USBD_SCSI_LUN_CTX  *p_ctx;
+
+
+    p_ctx = &USBD_SCSI_LunCtxTbl[p_lun->ClassNbr][p_lun->LunNbr];
+
+    switch (scsi_cmd) {                                         /* See Note #1.                                         */
+        case USBD_SCSI_CMD_READ_10:
+        case USBD_SCSI_CMD_READ_12:
+        case USBD_SCSI_CMD_READ_16:
+        case USBD_SCSI_CMD_WRITE_10:
+        case USBD_SCSI_CMD_WRITE_12:
+        case USBD_SCSI_CMD_WRITE_16:
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+             if (USBD_StorageCacheIsEn(&p_ctx->Cache, p_lun->BlockSize) == DEF_YES) {
+                 q_depth = 0u;                                  /* See Note #2.                                         */
+                 break;
+             }
+#endif
+#if (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+             if (((scsi_cmd == USBD_SCSI_CMD_READ_10)  ||
+                  (scsi_cmd == USBD_SCSI_CMD_READ_12)  ||
+                  (scsi_cmd == USBD_SCSI_CMD_READ_16)) &&
+                 (USBD_StorageRdAheadIsEn(&p_ctx->RdAhead, p_lun->BlockSize) == DEF_YES)) {
+                 q_depth = 0u;                                  /* See Note #2.                                         */
+                 break;
+             }
+#endif
+             q_depth = USBD_StorageAsyncQDepthGet(&p_ctx->StorageLun);
+             break;
+
+
+        default:
+             q_depth = 0u;
+             break;
+    }
+
+    return (q_depth);
+}
+
+
+/*
+**********************************************************************************************************
+*                                           USBD_SCSI_DataRdAsync()
+*
+* Description : Start reading data from the SCSI device.
+*
+* Argument(s) : p_lun           Pointer to Logical Unit information.
+*
+*               scsi_cmd        SCSI command operation code.
+*
+*               p_data_buf      Pointer to receive buffer.
+*
+*               data_len        Number of bytes to read.
+*
+*               cmpl_fnct       Function to call when the read completes.
+*
+*               p_cmpl_arg      Argument passed to 'cmpl_fnct'.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                       Read started & no more data to be read.
+*                               USBD_ERR_SCSI_MORE_DATA             Read started & more data to be read.
+*                               USBD_ERR_SCSI_UNSUPPORTED_CMD       Command not supported.
+*
+*                                                                   --- RETURNED BY USBD_StorageRdAsync() : ---
+*                               USBD_ERR_SCSI_MEDIUM_NOTPRESENT     Reading logical unit failed.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The read position is updated when the read is started, so that the next read can be
+*                   started before this one completes. The result of the read must be reported with
+*                   USBD_SCSI_DataAsyncCmpl().
+*
+*               (2) Must only be called if USBD_SCSI_AsyncQDepthGet() returned a non-zero depth for the
+*                   command.
+**********************************************************************************************************
+*/
+
+void  USBD_SCSI_DataRdAsync (const USBD_MSC_LUN_CTRL        *p_lun,
+                                   CPU_INT08U                scsi_cmd,
+                                   CPU_INT08U               *p_data_buf,
+                                   CPU_INT32U                data_len,
+                                   USBD_STORAGE_ASYNC_CMPL   cmpl_fnct,
+                                   void                     *p_cmpl_arg,
+                                   USBD_ERR                 *p_err)
+{
+    CPU_INT32U          lb_cnt;
+    USBD_SCSI_LUN_CTX  *p_ctx;
+
+
+    p_ctx = &USBD_SCSI_LunCtxTbl[p_lun->ClassNbr][p_lun->LunNbr];
+
+    switch (scsi_cmd) {
+        case USBD_SCSI_CMD_READ_10:
+        case USBD_SCSI_CMD_READ_12:
+        case USBD_SCSI_CMD_READ_16:
+             USBD_DBG_MSC_SCSI_MSG("SCSI Read data from Disk (async).");
+             lb_cnt = data_len / p_lun->BlockSize;              /* Nbr of blks that can fit in scsi_data_buf.           */
+
+             USBD_StorageRdAsync(&p_ctx->StorageLun,
+                                  p_ctx->LBAddr,
+                                  lb_cnt,
+                                  p_data_buf,
+                                  cmpl_fnct,
+                                  p_cmpl_arg,
+                                  p_err);
+
+             USBD_SCSI_LunStatusAnalyze(p_ctx, *p_err);         /* Check err code & build req sense data.               */
+             if (*p_err != USBD_ERR_NONE) {
+                 return;
+             }
+             p_ctx->LBAddr += lb_cnt;                           /* See Note #1.                                         */
+             p_ctx->LBCnt  -= lb_cnt;
+             if (p_ctx->LBCnt > 0) {                            /* More data has to be transferred.                     */
+                *p_err = USBD_ERR_SCSI_MORE_DATA;
+             } else {
+                *p_err = USBD_ERR_NONE;
+             }
+             break;
+
+
+        default:                                                /* See Note #2.                                         */
+            *p_err = USBD_ERR_SCSI_UNSUPPORTED_CMD;
+             USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                          USBD_SCSI_SENSE_KEY_ILLEGAL_REQUEST,
+                                          USBD_SCSI_ASC_NO_ADDITIONAL_SENSE_INFO,
+                                          0x00);
+             break;
+    }
+}
+
+
+/*
+**********************************************************************************************************
+*                                           USBD_SCSI_DataWrAsync()
+*
+* Description : Start writing data to the SCSI device.
+*
+* Argument(s) : p_lun           Pointer to Logical Unit information.
+*
+*               scsi_cmd        SCSI command operation code.
+*
+*               p_data_buf      Pointer to transmit buffer.
+*
+*               data_len        Number of bytes to write.
+*
+*               cmpl_fnct       Function to call when the write completes.
+*
+*               p_cmpl_arg      Argument passed to 'cmpl_fnct'.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                       Write started & no more data to write.
+*                               USBD_ERR_SCSI_MORE_DATA             Write started & more data to write.
+*                               USBD_ERR_SCSI_UNSUPPORTED_CMD       Command not supported.
+*
+*                                                                   --- RETURNED BY USBD_StorageWrAsync() : ---
+*                               USBD_ERR_SCSI_MEDIUM_NOTPRESENT     Writing to logical unit failed.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) See USBD_SCSI_DataRdAsync() Notes #1 & #2.
+**********************************************************************************************************
+*/
+
+void  USBD_SCSI_DataWrAsync (const USBD_MSC_LUN_CTRL        *p_lun,
+                                   CPU_INT08U                scsi_cmd,
+                                   CPU_INT08U               *p_data_buf,
+                                   CPU_INT32U                data_len,
+                                   USBD_STORAGE_ASYNC_CMPL   cmpl_fnct,
+                                   void                     *p_cmpl_arg,
+                                   USBD_ERR                 *p_err)
+{
+    CPU_INT32U          lb_cnt;
+    USBD_SCSI_LUN_CTX  *p_ctx;
+
+
+    p_ctx = &USBD_SCSI_LunCtxTbl[p_lun->ClassNbr][p_lun->LunNbr];
+
+    switch (scsi_cmd) {
+        case USBD_SCSI_CMD_WRITE_10:
+        case USBD_SCSI_CMD_WRITE_12:
+        case USBD_SCSI_CMD_WRITE_16:
+             USBD_DBG_MSC_SCSI_MSG("SCSI Write data to Disk (async).");
+             lb_cnt = data_len / p_lun->BlockSize;              /* Nbr of blks present in scsi_data_buf.                */
+
+             USBD_StorageWrAsync(&p_ctx->StorageLun,
+                                  p_ctx->LBAddr,
+                                  lb_cnt,
+                                  p_data_buf,
+                                  cmpl_fnct,
+                                  p_cmpl_arg,
+                                  p_err);
+
+             USBD_SCSI_LunStatusAnalyze(p_ctx, *p_err);         /* Check err code & build req sense data.               */
+             if (*p_err != USBD_ERR_NONE) {
+                 return;
+             }
+             p_ctx->LBAddr += lb_cnt;
+             p_ctx->LBCnt  -= lb_cnt;
+             if (p_ctx->LBCnt > 0) {                            /* More data has to be xferred.                         */
+                *p_err = USBD_ERR_SCSI_MORE_DATA;
+             } else {
+                *p_err = USBD_ERR_NONE;
+             }
+             break;
+
+
+        default:
+            *p_err = USBD_ERR_SCSI_UNSUPPORTED_CMD;
+             USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                          USBD_SCSI_SENSE_KEY_ILLEGAL_REQUEST,
+                                          USBD_SCSI_ASC_NO_ADDITIONAL_SENSE_INFO,
+                                          0x00);
+             break;
+    }
+}
+
+
+/*
+**********************************************************************************************************
+*                                          USBD_SCSI_DataAsyncCmpl()
+*
+* Description : Report the result of an asynchronous storage access.
+*
+* Argument(s) : p_lun           Pointer to Logical Unit information.
+*
+*               err             Error code passed to the completion function by the storage layer.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Must be called from the MSC task, in the order the accesses were started.
+**********************************************************************************************************
+*/
+
+void  USBD_SCSI_DataAsyncCmpl (const USBD_MSC_LUN_CTRL  *p_lun,
+                                     USBD_ERR            err)
+{
+    USBD_SCSI_LUN_CTX  *p_ctx;
+
+
+    p_ctx = &USBD_SCSI_LunCtxTbl[p_lun->ClassNbr][p_lun->LunNbr];
+
+    USBD_SCSI_LunStatusAnalyze(p_ctx, err);                     /* Check err code & build req sense data.               */
+}
+#endif
+
+
+/*
+**********************************************************************************************************
+*                                              USBD_SCSI_Reset()
+*
+* Description : Reset the SCSI state of an MSC instance's logical units when Bulk-Only Mass Storage Reset
+*               request is sent by the host.
+*
+* Argument(s) : class_nbr   MSC instance number.
+*
+* Return(s)   : None.
+*
+* Note(s)     : None.
+**********************************************************************************************************
+*/
+
+void  USBD_SCSI_Reset (CPU_INT08U  class_nbr)
+{
+    CPU_INT08U          lun_nbr;
+    USBD_SCSI_LUN_CTX  *p_ctx;
+
+
+    for (lun_nbr = 0u; lun_nbr < USBD_MSC_CFG_MAX_LUN; lun_nbr++) {
+        p_ctx = &USBD_SCSI_LunCtxTbl[class_nbr][lun_nbr];
+
+        p_ctx->LBAddr     = 0;
+        p_ctx->LBCnt      = 0;
+        p_ctx->RespLen    = 0;
+        p_ctx->RespBufPtr = (CPU_INT08U *)0;
+        p_ctx->SenseKey   = 0;
+        p_ctx->ASC        = 0;
+        p_ctx->ASCQ       = 0;
+    }
+
+    USBD_DBG_MSC_SCSI_MSG("SCSI Reset");
+}
+
+
+/*
+**********************************************************************************************************
+*                                              USBD_SCSI_Conn()
+*
+* Description : Reset eject flag upon new configuration activation.
+*
+* Argument(s) : p_lun       Pointer to Logical Unit information.
+*
+* Return(s)   : None.
+*
+* Note(s)     : None.
+**********************************************************************************************************
+*/
+
+void  USBD_SCSI_Conn (const USBD_MSC_LUN_CTRL  *p_lun)
+{
+    USBD_STORAGE_LUN  *p_storage_lun;
+
+
+    p_storage_lun = &USBD_SCSI_LunCtxTbl[p_lun->ClassNbr][p_lun->LunNbr].StorageLun;
+
+    p_storage_lun->LockFlag  = DEF_FALSE;
+    p_storage_lun->EjectFlag = DEF_FALSE;
+}
+
+
+/*
+**********************************************************************************************************
+*                                              USBD_SCSI_Unlock()
+*
+* Description : Unlock the SCSI Storage Medium.
+*
+* Argument(s) : p_lun       Pointer to Logical Unit information.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE   Eject flag successfully reset.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Unlocking a logical unit can be done with a software eject (for instance Windows
+*                   right's click eject). In that case, the unlock operation must not be executed another
+*                   time. If a software eject has occurred, the unlock operation done upon physical
+*                   disconnection of the device must be discarded.
+*
+*               (2) The block cache is flushed so that the application finds the data written by the host
+*                   on the medium once the device is disconnected. A flush error is not reported, since
+*                   the logical unit must be unlocked anyway.
 **********************************************************************************************************
 */
 
@@ -1452,9 +2383,15 @@ void  USBD_SCSI_Unlock (const USBD_MSC_LUN_CTRL  *p_lun,
     USBD_STORAGE_LUN  *p_storage_lun;
 
 
-    p_storage_lun = &USBD_SCSI_LunTbl[p_lun->LunNbr];
+    p_storage_lun = &USBD_SCSI_LunCtxTbl[p_lun->ClassNbr][p_lun->LunNbr].StorageLun;
 
     if (p_storage_lun->EjectFlag == DEF_FALSE) {                /* See Note #1.                                         */
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+                                                                /* Wr cached blks before releasing medium (see Note #2).*/
+        USBD_StorageCacheFlush(&USBD_SCSI_LunCtxTbl[p_lun->ClassNbr][p_lun->LunNbr].Cache,
+                                p_storage_lun,
+                                p_err);
+#endif
         USBD_StorageUnlock(p_storage_lun, p_err);               /* Unlock logical unit upon physical disconnect.        */
         p_storage_lun->LockFlag = DEF_FALSE;
     } else {
@@ -1463,6 +2400,149 @@ void  USBD_SCSI_Unlock (const USBD_MSC_LUN_CTRL  *p_lun,
 }
 
 
+/*
+**********************************************************************************************************
+*                                            USBD_SCSI_SenseGet()
+*
+* Description : Get the sense data of a logical unit & clear it.
+*
+* Argument(s) : p_lun       Pointer to Logical Unit information.
+*
+*               p_buf       Pointer to buffer that will receive the sense data.
+*
+*               buf_len     Length of the buffer, in octets.
+*
+* Return(s)   : Length of the sense data copied, in octets.
+*
+* Note(s)     : (1) Used by transports that return the sense data with the command status (autosense),
+*                   such as USB Attached SCSI. The sense data is formatted as for REQUEST SENSE, then
+*                   cleared, as the host does not send a REQUEST SENSE command afterwards.
+**********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+CPU_INT08U  USBD_SCSI_SenseGet (const USBD_MSC_LUN_CTRL  *p_lun,
+                                      CPU_INT08U         *p_buf,
+                                      CPU_INT08U          buf_len)
+{
+    USBD_SCSI_LUN_CTX  *p_ctx;
+    CPU_INT08U          len;
+
+
+    p_ctx = &USBD_SCSI_LunCtxTbl[p_lun->ClassNbr][p_lun->LunNbr];
+    len   =  DEF_MIN(USBD_SCSI_REQ_SENSE_DATA_LEN, buf_len);
+
+    p_ctx->ReqSenseData[2]  = p_ctx->SenseKey;                  /* See Note #1.                                         */
+    p_ctx->ReqSenseData[12] = p_ctx->ASC;
+    p_ctx->ReqSenseData[13] = p_ctx->ASCQ;
+
+    Mem_Copy((void     *)p_buf,
+             (void     *)&p_ctx->ReqSenseData[0],
+             (CPU_SIZE_T)len);
+
+    USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                 USBD_SCSI_SENSE_KEY_NO_SENSE,
+                                 USBD_SCSI_ASC_NO_ADDITIONAL_SENSE_INFO,
+                                 0x00);
+
+    return (len);
+}
+#endif
+
+
+/*
+**********************************************************************************************************
+*                                          USBD_SCSI_CacheStatGet()
+*
+* Description : Get the block cache statistics of a logical unit.
+*
+* Argument(s) : p_lun       Pointer to Logical Unit information.
+*
+*               p_stat      Pointer to structure that will receive the statistics.
+*
+* Return(s)   : None.
+*
+* Note(s)     : None.
+**********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+void  USBD_SCSI_CacheStatGet (const USBD_MSC_LUN_CTRL    *p_lun,
+                                    USBD_MSC_CACHE_STAT  *p_stat)
+{
+    USBD_StorageCacheStatGet(&USBD_SCSI_LunCtxTbl[p_lun->ClassNbr][p_lun->LunNbr].Cache,
+                              p_stat);
+}
+#endif
+
+
+/*
+**********************************************************************************************************
+*                                          USBD_SCSI_RdAheadFill()
+*
+* Description : Read the blocks following the current READ command into the read-ahead window.
+*
+* Argument(s) : p_lun       Pointer to Logical Unit information.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Called once the CSW of a successful command is sent. The window is only filled after a
+*                   sequential READ command (see Note #4 of USBD_SCSI_LUN_CTX).
+*
+*               (2) A read error only leaves the window empty. It is reported to the host by the READ
+*                   command that needs the blocks, so the sense data is left untouched.
+**********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+void  USBD_SCSI_RdAheadFill (const USBD_MSC_LUN_CTRL  *p_lun)
+{
+    USBD_SCSI_LUN_CTX  *p_ctx;
+    USBD_ERR            err;
+
+
+    p_ctx = &USBD_SCSI_LunCtxTbl[p_lun->ClassNbr][p_lun->LunNbr];
+
+    if ((p_ctx->StorageLun.LockFlag  == DEF_FALSE) ||           /* No medium to rd from.                                */
+        (p_ctx->StorageLun.EjectFlag == DEF_TRUE )) {
+        return;
+    }
+
+    USBD_StorageRdAheadFill(&p_ctx->RdAhead,                    /* See Note #2.                                         */
+                            &p_ctx->StorageLun,
+                             p_lun->BlockSize,
+                             p_lun->NbrBlocks,
+                            &err);
+}
+#endif
+
+
+/*
+**********************************************************************************************************
+*                                        USBD_SCSI_RdAheadStatGet()
+*
+* Description : Get the read-ahead statistics of a logical unit.
+*
+* Argument(s) : p_lun       Pointer to Logical Unit information.
+*
+*               p_stat      Pointer to structure that will receive the statistics.
+*
+* Return(s)   : None.
+*
+* Note(s)     : None.
+**********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+void  USBD_SCSI_RdAheadStatGet (const USBD_MSC_LUN_CTRL       *p_lun,
+                                      USBD_MSC_RD_AHEAD_STAT  *p_stat)
+{
+    USBD_StorageRdAheadStatGet(&USBD_SCSI_LunCtxTbl[p_lun->ClassNbr][p_lun->LunNbr].RdAhead,
+                                p_stat);
+}
+#endif
+
+
 /*
 *********************************************************************************************************
 *********************************************************************************************************
@@ -1519,6 +2599,11 @@ void  USBD_SCSI_Unlock (const USBD_MSC_LUN_CTRL  *p_lun,
 *                   medium.
 *                   The format of Read/Write Error Recovery mode Page is specified in
 *                   'SCSI Blocks Commands - 3' (SBC-3), Revision 16, Section 6.3.5.
+*
+*               (4) The Caching mode page reports whether the device caches written data. Hosts only send
+*                   SYNCHRONIZE CACHE to devices reporting a write cache.
+*                   The format of Caching mode page is specified in 'SCSI Blocks Commands - 3' (SBC-3),
+*                   Revision 16, Section 6.3.3.
 **********************************************************************************************************
 */
 
@@ -1527,12 +2612,16 @@ static  void  USBD_SCSI_ModeSenseDataPrepare (const USBD_MSC_LUN_CTRL  *p_lun,
                                                     CPU_INT08U          page_code,
                                                     USBD_ERR           *p_err)
 {
-    CPU_INT08U  ix_mode_data_len;
-    CPU_INT08U  ix_medium_type;
-    CPU_INT08U  ix_dev_spec_param;
-    CPU_INT08U  ix_mode_page;
-    CPU_INT08U  ix_nxt_page;
-    CPU_INT08U  mode_param_hdr_len;
+    CPU_INT08U          ix_mode_data_len;
+    CPU_INT08U          ix_medium_type;
+    CPU_INT08U          ix_dev_spec_param;
+    CPU_INT08U          ix_mode_page;
+    CPU_INT08U          ix_nxt_page;
+    CPU_INT08U          mode_param_hdr_len;
+    USBD_SCSI_LUN_CTX  *p_ctx;
+
+
+    p_ctx = &USBD_SCSI_LunCtxTbl[p_lun->ClassNbr][p_lun->LunNbr];
 
                                                                 /* Index preparation according to MODE SENSE cmd type.  */
     if(scsi_cmd == USBD_SCSI_CMD_MODE_SENSE_06) {
@@ -1549,27 +2638,27 @@ static  void  USBD_SCSI_ModeSenseDataPrepare (const USBD_MSC_LUN_CTRL  *p_lun,
         mode_param_hdr_len = USBD_SCSI_MODE_SENSE_DATA_MODE_PARAM_HDR_10_LEN;
     }
                                                                  /* Ensure Mode Sense buf properly reset.               */
-    Mem_Clr((void     *)USBD_SCSI_ModeSenseData,
+    Mem_Clr((void     *)p_ctx->ModeSenseData,
             (CPU_SIZE_T)USBD_SCSI_MODE_SENSE_DATA_LEN);
 
                                                                 /* ------------------ MODE PARAM HDR ------------------ */
                                                                 /* Medium type supported by LUN.                        */
-    USBD_SCSI_ModeSenseData[ix_medium_type] = USBD_DISK_MEMORY_MEDIA;
+    p_ctx->ModeSenseData[ix_medium_type] = USBD_DISK_MEMORY_MEDIA;
                                                                 /* Indicate if medium is write-protected.               */
     if (p_lun->LunInfo.ReadOnly) {
-        USBD_SCSI_ModeSenseData[ix_dev_spec_param] = USBD_SCSI_MODE_SENSE_DATA_SPEC_PARAM_WR_PROT;
+        p_ctx->ModeSenseData[ix_dev_spec_param] = USBD_SCSI_MODE_SENSE_DATA_SPEC_PARAM_WR_PROT;
     } else {
-        USBD_SCSI_ModeSenseData[ix_dev_spec_param] = USBD_SCSI_MODE_SENSE_DATA_SPEC_PARAM_WR_EN;
+        p_ctx->ModeSenseData[ix_dev_spec_param] = USBD_SCSI_MODE_SENSE_DATA_SPEC_PARAM_WR_EN;
     }
 
     switch (page_code) {
         case USBD_SCSI_PAGE_CODE_INFORMATIONAL_EXCEPTIONS:      /* See Note #1.                                         */
                                                                 /* Mode Data Len.                                       */
-             USBD_SCSI_ModeSenseData[ix_mode_data_len] = mode_param_hdr_len                          +
+             p_ctx->ModeSenseData[ix_mode_data_len] = mode_param_hdr_len                          +
                                                          USBD_SCSI_MODE_SENSE_DATA_MODE_PAGE_HDR_LEN +
                                                          USBD_SCSI_PAGE_LENGTH_INFORMATIONAL_EXCEPTIONS;
                                                                 /* --------------- BLK DESC & MODE PAGE --------------- */
-             USBD_SCSI_PageInfoExcept((void *)&USBD_SCSI_ModeSenseData[ix_mode_page]);
+             USBD_SCSI_PageInfoExcept((void *)&p_ctx->ModeSenseData[ix_mode_page]);
 
             *p_err = USBD_ERR_NONE;
              break;
@@ -1577,11 +2666,23 @@ static  void  USBD_SCSI_ModeSenseDataPrepare (const USBD_MSC_LUN_CTRL  *p_lun,
 
         case USBD_SCSI_PAGE_CODE_READ_WRITE_ERROR_RECOVERY:     /* See Note #2.                                         */
                                                                 /* Mode Data Len.                                       */
-             USBD_SCSI_ModeSenseData[ix_mode_data_len] = mode_param_hdr_len                          +
+             p_ctx->ModeSenseData[ix_mode_data_len] = mode_param_hdr_len                          +
                                                          USBD_SCSI_MODE_SENSE_DATA_MODE_PAGE_HDR_LEN +
                                                          USBD_SCSI_PAGE_LENGTH_READ_WRITE_ERROR_RECOVERY;
                                                                 /* --------------- BLK DESC & MODE PAGE --------------- */
-             USBD_SCSI_PageRdWrErrRecovery((void *)&USBD_SCSI_ModeSenseData[ix_mode_page]);
+             USBD_SCSI_PageRdWrErrRecovery((void *)&p_ctx->ModeSenseData[ix_mode_page]);
+
+            *p_err = USBD_ERR_NONE;
+             break;
+
+
+        case USBD_SCSI_PAGE_CODE_CACHING:                       /* See Note #4.                                         */
+                                                                /* Mode Data Len.                                       */
+             p_ctx->ModeSenseData[ix_mode_data_len] = mode_param_hdr_len                          +
+                                                         USBD_SCSI_MODE_SENSE_DATA_MODE_PAGE_HDR_LEN +
+                                                         USBD_SCSI_PAGE_LENGTH_CACHING;
+                                                                /* --------------- BLK DESC & MODE PAGE --------------- */
+             USBD_SCSI_PageCaching((void *)&p_ctx->ModeSenseData[ix_mode_page]);
 
             *p_err = USBD_ERR_NONE;
              break;
@@ -1589,18 +2690,25 @@ static  void  USBD_SCSI_ModeSenseDataPrepare (const USBD_MSC_LUN_CTRL  *p_lun,
 
         case USBD_SCSI_PAGE_CODE_ALL:                           /* Page Code: all pages supported by target.            */
                                                                 /* Mode Data Len.                                       */
-             USBD_SCSI_ModeSenseData[ix_mode_data_len] = mode_param_hdr_len                              +
+             p_ctx->ModeSenseData[ix_mode_data_len] = mode_param_hdr_len                              +
                                                          USBD_SCSI_MODE_SENSE_DATA_MODE_PAGE_HDR_LEN     +
                                                          USBD_SCSI_PAGE_LENGTH_READ_WRITE_ERROR_RECOVERY +
                                                          USBD_SCSI_MODE_SENSE_DATA_MODE_PAGE_HDR_LEN     +
+                                                         USBD_SCSI_PAGE_LENGTH_CACHING                   +
+                                                         USBD_SCSI_MODE_SENSE_DATA_MODE_PAGE_HDR_LEN     +
                                                          USBD_SCSI_PAGE_LENGTH_INFORMATIONAL_EXCEPTIONS;
                                                                 /* --------------- BLK DESC & MODE PAGE --------------- */
-             USBD_SCSI_PageRdWrErrRecovery((void *)&USBD_SCSI_ModeSenseData[ix_mode_page]);
-
+             USBD_SCSI_PageRdWrErrRecovery((void *)&p_ctx->ModeSenseData[ix_mode_page]);
+                                                                /* Pages are returned in ascending page code order.     */
              ix_nxt_page = ix_mode_page                                +
                            USBD_SCSI_MODE_SENSE_DATA_MODE_PAGE_HDR_LEN +
                            USBD_SCSI_PAGE_LENGTH_READ_WRITE_ERROR_RECOVERY;
-             USBD_SCSI_PageInfoExcept((void *)&USBD_SCSI_ModeSenseData[ix_nxt_page]);
+             USBD_SCSI_PageCaching((void *)&p_ctx->ModeSenseData[ix_nxt_page]);
+
+             ix_nxt_page = ix_nxt_page                                 +
+                           USBD_SCSI_MODE_SENSE_DATA_MODE_PAGE_HDR_LEN +
+                           USBD_SCSI_PAGE_LENGTH_CACHING;
+             USBD_SCSI_PageInfoExcept((void *)&p_ctx->ModeSenseData[ix_nxt_page]);
 
             *p_err = USBD_ERR_NONE;
              break;
@@ -1619,7 +2727,9 @@ static  void  USBD_SCSI_ModeSenseDataPrepare (const USBD_MSC_LUN_CTRL  *p_lun,
 *
 * Description : Update Request Sense data parameters.
 *
-* Argument(s) : sense_key           Sense key describing an error or exception condition.
+* Argument(s) : p_ctx               Pointer to logical unit SCSI context.
+*
+*               sense_key           Sense key describing an error or exception condition.
 *
 *               sense_code          Additional Sense Code describing sense key in detail.
 *
@@ -1631,13 +2741,14 @@ static  void  USBD_SCSI_ModeSenseDataPrepare (const USBD_MSC_LUN_CTRL  *p_lun,
 **********************************************************************************************************
 */
 
-static  void  USBD_SCSI_ReqSenseDataUpdate (CPU_INT08U  sense_key,
-                                            CPU_INT08U  sense_code,
-                                            CPU_INT08U  sense_code_qual)
+static  void  USBD_SCSI_ReqSenseDataUpdate (USBD_SCSI_LUN_CTX  *p_ctx,
+                                            CPU_INT08U          sense_key,
+                                            CPU_INT08U          sense_code,
+                                            CPU_INT08U          sense_code_qual)
 {
-    USBD_SCSI_SenseKey = sense_key;
-    USBD_SCSI_ASC      = sense_code;
-    USBD_SCSI_ASCQ     = sense_code_qual;
+    p_ctx->SenseKey = sense_key;
+    p_ctx->ASC      = sense_code;
+    p_ctx->ASCQ     = sense_code_qual;
 }
 
 
@@ -1645,7 +2756,7 @@ static  void  USBD_SCSI_ReqSenseDataUpdate (CPU_INT08U  sense_key,
 **********************************************************************************************************
 *                                              USBD_SCSI_InquiryDataPrepare()
 *
-* Description : Prepare response for INQUIRY SCSI command.
+* Description : Prepare response for INQUIRY SCSI command & set it as the logical unit response buffer.
 *
 * Argument(s) : p_lun           Pointer to Logical Unit information.
 *
@@ -1680,6 +2791,13 @@ static  void  USBD_SCSI_ReqSenseDataUpdate (CPU_INT08U  sense_key,
 *
 *                    See 'SCSI Primary Commands - 3' (SPC-3), Revision 23, Section 6.4.2, fore more
 *                    details.
+*
+*               (2) When the EVPD bit is set, the Vital Product Data page given by the page code is returned
+*                   instead. Every VPD page starts with a 4-octet header holding the peripheral device type,
+*                   the page code and the page length.
+*
+*               (3) The Logical Block Provisioning VPD page is only reported when UNMAP is supported
+*                   (see 'usbd_cfg.h', MSC Note #7).
 **********************************************************************************************************
 */
 
@@ -1688,32 +2806,89 @@ static  void  USBD_SCSI_InquiryDataPrepare (const USBD_MSC_LUN_CTRL  *p_lun,
                                                   CPU_INT08U          page_code,
                                                   USBD_ERR           *p_err)
 {
+    USBD_SCSI_LUN_CTX  *p_ctx;
+
+
+    p_ctx = &USBD_SCSI_LunCtxTbl[p_lun->ClassNbr][p_lun->LunNbr];
+
+    p_ctx->RespBufPtr = (CPU_INT08U *)0;
+    p_ctx->RespLen    =  0u;
+
     if (cmdt_evpd == USBD_SCSI_STD_INQUIRY_DATA) {
 
         if (page_code == 0) {                                   /* Get target info.                                     */
-            USBD_SCSI_InquiryData[0] =  USBD_SCSI_PER_DEV_TYPE_DIRECT_ACCESS_BLOCK_DEV |
+            p_ctx->InquiryData[0] =  USBD_SCSI_PER_DEV_TYPE_DIRECT_ACCESS_BLOCK_DEV |
                                        (USBD_SCSI_PER_QUAL_CONN << 5);
                                                                 /* Indicate medium as removable.                        */
-            DEF_BIT_SET(USBD_SCSI_InquiryData[1], USBD_SCSI_INQUIRY_RMB);
+            DEF_BIT_SET(p_ctx->InquiryData[1], USBD_SCSI_INQUIRY_RMB);
                                                                 /* Vendor ID info.                                      */
-            Mem_Copy((void *)&USBD_SCSI_InquiryData[8],
+            Mem_Copy((void *)&p_ctx->InquiryData[8],
                      (void *)&p_lun->LunInfo.VendorId[0],
                               sizeof(p_lun->LunInfo.VendorId));
 
                                                                 /* Product ID info.                                     */
-            Mem_Copy((void *)&USBD_SCSI_InquiryData[16],
+            Mem_Copy((void *)&p_ctx->InquiryData[16],
                      (void *)&p_lun->LunInfo.ProdId[0],
                               sizeof(p_lun->LunInfo.ProdId));
 
                                                                 /* Product revision level.                              */
-            Mem_Copy((void *)&USBD_SCSI_InquiryData[32],
+            Mem_Copy((void *)&p_ctx->InquiryData[32],
                      (void *)&p_lun->LunInfo.ProdRevisionLevel,
                               4u);
 
+            p_ctx->RespBufPtr = &p_ctx->InquiryData[0];
+            p_ctx->RespLen    =  USBD_SCSI_INQUIRY_DATA_LEN;
            *p_err = USBD_ERR_NONE;
         } else {
            *p_err = USBD_ERR_SCSI_UNSUPPORTED_CMD;              /* Page code is not supported.                          */
         }
+
+    } else if (cmdt_evpd == USBD_SCSI_INQUIRY_EVPD) {           /* See Note #2.                                         */
+        Mem_Clr((void     *)p_ctx->VpdData,
+                (CPU_SIZE_T)USBD_SCSI_VPD_DATA_LEN);
+
+        p_ctx->VpdData[0] = USBD_SCSI_PER_DEV_TYPE_DIRECT_ACCESS_BLOCK_DEV |
+                           (USBD_SCSI_PER_QUAL_CONN << 5);
+        p_ctx->VpdData[1] = page_code;
+
+       *p_err = USBD_ERR_NONE;
+        switch (page_code) {
+            case USBD_SCSI_VPD_PAGE_SUPPORTED_PAGES:            /* Page codes in ascending order.                       */
+                 p_ctx->VpdData[4] = USBD_SCSI_VPD_PAGE_SUPPORTED_PAGES;
+                 p_ctx->VpdData[5] = USBD_SCSI_VPD_PAGE_BLK_LIMITS;
+#if (USBD_MSC_CFG_UNMAP_EN == DEF_ENABLED)
+                 p_ctx->VpdData[6] = USBD_SCSI_VPD_PAGE_LOG_BLK_PROVISIONING;
+                 p_ctx->VpdData[3] = 3u;
+#else
+                 p_ctx->VpdData[3] = 2u;
+#endif
+                 break;
+
+
+            case USBD_SCSI_VPD_PAGE_BLK_LIMITS:
+                 p_ctx->VpdData[3] = USBD_SCSI_VPD_PAGE_LEN_BLK_LIMITS;
+                 USBD_SCSI_VpdPageBlkLimits((void *)&p_ctx->VpdData[0]);
+                 break;
+
+
+#if (USBD_MSC_CFG_UNMAP_EN == DEF_ENABLED)
+            case USBD_SCSI_VPD_PAGE_LOG_BLK_PROVISIONING:       /* See Note #3.                                         */
+                 p_ctx->VpdData[3] = USBD_SCSI_VPD_PAGE_LEN_LOG_BLK_PROVISIONING;
+                 USBD_SCSI_VpdPageLogBlkProv((void *)&p_ctx->VpdData[0]);
+                 break;
+#endif
+
+
+            default:
+                *p_err = USBD_ERR_SCSI_UNSUPPORTED_CMD;         /* Page code is not supported.                          */
+                 break;
+        }
+
+        if (*p_err == USBD_ERR_NONE) {
+            p_ctx->RespBufPtr = &p_ctx->VpdData[0];
+            p_ctx->RespLen    =  USBD_SCSI_VPD_PAGE_HDR_LEN + p_ctx->VpdData[3];
+        }
+
     } else {
        *p_err = USBD_ERR_SCSI_UNSUPPORTED_CMD;
     }
@@ -1727,61 +2902,104 @@ static  void  USBD_SCSI_InquiryDataPrepare (const USBD_MSC_LUN_CTRL  *p_lun,
 * Description : Update Request Sense data parameters corresponding to the error code gotten from logical
 *               unit.
 *
-* Argument(s) : err             Error code from logical unit.
+* Argument(s) : p_ctx           Pointer to logical unit SCSI context.
+*
+*               err             Error code from logical unit.
 *
 * Return(s)   : None.
 *
-* Note(s)     : None.
+* Note(s)     : (1) A medium state transition means that the medium has been removed or replaced. The
+*                   blocks held by the block cache or by the read-ahead window no longer belong to the
+*                   medium and are discarded.
+*
+*               (2) A thinly provisioned medium that cannot allocate the blocks of a write reports
+*                   'SPACE ALLOCATION FAILED WRITE PROTECT' (see 'SCSI Block Commands - 3' (SBC-3),
+*                   Revision 25, Section 4.7.3.7).
 **********************************************************************************************************
 */
 
-static  void  USBD_SCSI_LunStatusAnalyze (USBD_ERR  err)
+static  void  USBD_SCSI_LunStatusAnalyze (USBD_SCSI_LUN_CTX  *p_ctx,
+                                          USBD_ERR            err)
 {
     switch (err) {
         case USBD_ERR_NONE:
-             USBD_SCSI_ReqSenseDataUpdate(USBD_SCSI_SENSE_KEY_NO_SENSE,
+             USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                          USBD_SCSI_SENSE_KEY_NO_SENSE,
                                           USBD_SCSI_ASC_NO_ADDITIONAL_SENSE_INFO,
                                           0x00);
              break;
 
         case USBD_ERR_SCSI_MEDIUM_NOTPRESENT:                   /* Target is not present.                               */
-             USBD_SCSI_ReqSenseDataUpdate(USBD_SCSI_SENSE_KEY_NOT_RDY,
+             USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                          USBD_SCSI_SENSE_KEY_NOT_RDY,
                                           USBD_SCSI_ASC_MEDIUM_NOT_PRESENT,
                                           0x00);
              break;
 
         case USBD_ERR_SCSI_MEDIUM_NOT_RDY_TO_RDY:               /* Target in not rdy to rdy transition.                 */
-             USBD_SCSI_ReqSenseDataUpdate(USBD_SCSI_SENSE_KEY_UNIT_ATTENTION,
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+             USBD_StorageCacheInvalidate(&p_ctx->Cache);        /* See Note #1.                                         */
+#endif
+#if (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+             USBD_StorageRdAheadInvalidate(&p_ctx->RdAhead);    /* See Note #1.                                         */
+#endif
+             USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                          USBD_SCSI_SENSE_KEY_UNIT_ATTENTION,
                                           USBD_SCSI_ASC_NOT_RDY_TO_RDY_CHANGE,
                                           0x00);
              break;
 
         case USBD_ERR_SCSI_MEDIUM_RDY_TO_NOT_RDY:               /* Target in rdy to not rdy transition.                 */
-             USBD_SCSI_ReqSenseDataUpdate(USBD_SCSI_SENSE_KEY_NOT_RDY,
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+             USBD_StorageCacheInvalidate(&p_ctx->Cache);        /* See Note #1.                                         */
+#endif
+#if (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+             USBD_StorageRdAheadInvalidate(&p_ctx->RdAhead);    /* See Note #1.                                         */
+#endif
+             USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                          USBD_SCSI_SENSE_KEY_NOT_RDY,
                                           USBD_SCSI_ASC_MEDIUM_NOT_PRESENT,
                                           0x00);
              break;
 
         case USBD_ERR_SCSI_LU_NOTRDY:                           /* LUN is not rdy to perform any operation.             */
-             USBD_SCSI_ReqSenseDataUpdate(USBD_SCSI_SENSE_KEY_NOT_RDY,
+             USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                          USBD_SCSI_SENSE_KEY_NOT_RDY,
                                           USBD_SCSI_ASC_LOG_UNIT_NOT_RDY,
                                           0x00);
              break;
 
         case USBD_ERR_SCSI_LU_NOTSUPPORTED:                     /* LUN is not supported.                                */
-             USBD_SCSI_ReqSenseDataUpdate(USBD_SCSI_SENSE_KEY_ILLEGAL_REQUEST,
+             USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                          USBD_SCSI_SENSE_KEY_ILLEGAL_REQUEST,
                                           USBD_SCSI_ASC_LOG_UNIT_NOT_SUPPORTED,
                                           0x00);
              break;
 
         case USBD_ERR_SCSI_LU_BUSY:                             /* LUN is busy.                                         */
-             USBD_SCSI_ReqSenseDataUpdate(USBD_SCSI_SENSE_KEY_UNIT_ATTENTION,
+             USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                          USBD_SCSI_SENSE_KEY_UNIT_ATTENTION,
                                           USBD_SCSI_ASC_NOT_RDY_TO_RDY_CHANGE,
                                           0x00);
              break;
 
+        case USBD_ERR_SCSI_LOG_BLOCK_ADDR:                      /* LBA out of range.                                    */
+             USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                          USBD_SCSI_SENSE_KEY_ILLEGAL_REQUEST,
+                                          USBD_SCSI_ASC_LOG_BLOCK_ADDR_OUT_OF_RANGE,
+                                          0x00);
+             break;
+
+        case USBD_ERR_SCSI_SPACE_ALLOC:                         /* No space left on medium (see Note #2).               */
+             USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                          USBD_SCSI_SENSE_KEY_DATA_PROTECT,
+                                          USBD_SCSI_ASC_WR_PROTECTED,
+                                          USBD_SCSI_ASCQ_SPACE_ALLOC_FAILED);
+             break;
+
         default:                                                /* Err is not supported considered as hw err.           */
-             USBD_SCSI_ReqSenseDataUpdate(USBD_SCSI_SENSE_KEY_HARDWARE_ERROR,
+             USBD_SCSI_ReqSenseDataUpdate(p_ctx,
+                                          USBD_SCSI_SENSE_KEY_HARDWARE_ERROR,
                                           USBD_SCSI_ASC_NO_ADDITIONAL_SENSE_INFO,
                                           0x00);
              break;
@@ -1856,4 +3074,233 @@ static  void  USBD_SCSI_PageInfoExcept (void  *p_buf_dest)
 }
 
 
+/*
+**********************************************************************************************************
+*                                       USBD_SCSI_PageCaching()
+*
+* Description : Prepare Mode Sense Data with Caching Page parameters.
+*
+* Argument(s) : p_buf_dest      Pointer to buffer that will hold Mode sense data.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The format of Caching mode page is specified in 'SCSI Blocks Commands - 3' (SBC-3),
+*                   Revision 16, Section 6.3.3.
+*
+*               (2) The Write Cache Enable (WCE) bit is set when written blocks are held by the block cache.
+*                   Read caching and prefetch parameters are left to zero.
+**********************************************************************************************************
+*/
+
+static  void  USBD_SCSI_PageCaching (void  *p_buf_dest)
+{
+    CPU_INT08U  *p_buf_dest_08;
+
+
+    p_buf_dest_08    = (CPU_INT08U *)p_buf_dest;
+    p_buf_dest_08[0] =  USBD_SCSI_PAGE_CODE_CACHING;
+    p_buf_dest_08[1] =  USBD_SCSI_PAGE_LENGTH_CACHING;
+                                                                /* Remaining fields are cleared by caller.              */
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+    p_buf_dest_08[2] =  USBD_SCSI_MODE_SENSE_DATA_WCE;          /* See Note #2.                                         */
+#else
+    p_buf_dest_08[2] =  0u;
+#endif
+}
+
+
+/*
+**********************************************************************************************************
+*                                     USBD_SCSI_VpdPageBlkLimits()
+*
+* Description : Prepare Inquiry Data with Block Limits VPD page parameters.
+*
+* Argument(s) : p_buf_dest      Pointer to buffer that will hold the VPD page.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The format of Block Limits VPD page is specified in 'SCSI Block Commands - 3' (SBC-3),
+*                   Revision 25, Section 6.5.3. The page header is prepared by the caller & the remaining
+*                   fields are cleared by the caller.
+*
+*               (2) The transfer length limits are left to zero, since the MSC data stage has no limit. The
+*                   unmap limits are only reported when UNMAP is supported.
+**********************************************************************************************************
+*/
+
+static  void  USBD_SCSI_VpdPageBlkLimits (void  *p_buf_dest)
+{
+    CPU_INT08U  *p_buf_dest_08;
+
+
+    p_buf_dest_08    = (CPU_INT08U *)p_buf_dest;
+    p_buf_dest_08[4] =  USBD_SCSI_VPD_BLK_LIMITS_WSNZ;          /* WRITE SAME of zero blks not supported.               */
+
+#if (USBD_MSC_CFG_UNMAP_EN == DEF_ENABLED)
+                                                                /* Unmap limits (see Note #2).                          */
+    MEM_VAL_SET_INT32U_BIG(p_buf_dest_08 + 20, USBD_SCSI_VPD_MAX_UNMAP_LBA_CNT);
+    MEM_VAL_SET_INT32U_BIG(p_buf_dest_08 + 24, USBD_SCSI_VPD_MAX_UNMAP_DESC_CNT);
+    MEM_VAL_SET_INT32U_BIG(p_buf_dest_08 + 28, USBD_SCSI_VPD_OPT_UNMAP_GRANULARITY);
+#endif
+                                                                /* Max WRITE SAME len, upper 32 bits are zero.          */
+    MEM_VAL_SET_INT32U_BIG(p_buf_dest_08 + 40, USBD_SCSI_VPD_MAX_WR_SAME_LEN);
+}
+
+
+/*
+**********************************************************************************************************
+*                                     USBD_SCSI_VpdPageLogBlkProv()
+*
+* Description : Prepare Inquiry Data with Logical Block Provisioning VPD page parameters.
+*
+* Argument(s) : p_buf_dest      Pointer to buffer that will hold the VPD page.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The format of Logical Block Provisioning VPD page is specified in 'SCSI Block
+*                   Commands - 3' (SBC-3), Revision 25, Section 6.5.4. The page header is prepared by the
+*                   caller & the remaining fields are cleared by the caller.
+*
+*               (2) The LBPRZ bit is cleared. Released blocks are not guaranteed to read back as zeros, since
+*                   the storage layer decides what a released block holds.
+**********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_UNMAP_EN == DEF_ENABLED)
+static  void  USBD_SCSI_VpdPageLogBlkProv (void  *p_buf_dest)
+{
+    CPU_INT08U  *p_buf_dest_08;
+
+
+    p_buf_dest_08    = (CPU_INT08U *)p_buf_dest;
+    p_buf_dest_08[4] =  0u;                                     /* Threshold exponent.                                  */
+    p_buf_dest_08[5] =  USBD_SCSI_VPD_LBP_LBPU  |               /* UNMAP, WRITE SAME(16) & (10) with UNMAP supported.   */
+                        USBD_SCSI_VPD_LBP_LBPWS |
+                        USBD_SCSI_VPD_LBP_LBPWS10;              /* See Note #2.                                         */
+    p_buf_dest_08[6] =  USBD_SCSI_VPD_LBP_TYPE_RESOURCE;        /* Provisioning type.                                   */
+}
+#endif
+
+
+/*
+**********************************************************************************************************
+*                                    USBD_SCSI_UnmapParamProcess()
+*
+* Description : Release the block ranges given by a received UNMAP parameter list.
+*
+* Argument(s) : p_lun           Pointer to Logical Unit information.
+*
+*               p_ctx           Pointer to logical unit SCSI context.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                       Block ranges successfully released.
+*                               USBD_ERR_SCSI_LOG_BLOCK_ADDR        Block descriptor out of range.
+*
+*                                                                   --- RETURNED BY USBD_StorageUnmap() : ---
+*                               USBD_ERR_SCSI_MEDIUM_NOTPRESENT     Releasing blocks failed.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The UNMAP parameter list is specified in 'SCSI Block Commands - 3' (SBC-3), Revision 25,
+*                   Section 5.28.2. An 8-octet header holding the block descriptor data length is followed
+*                   by 16-octet block descriptors, each holding an 8-octet LBA & a 4-octet number of blocks.
+*
+*               (2) A block descriptor data length larger than the received parameter list is truncated to
+*                   the received block descriptors.
+*
+*               (3) Every block descriptor is checked before any block is released, so that a parameter
+*                   list holding an invalid descriptor releases nothing.
+**********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_UNMAP_EN == DEF_ENABLED)
+static  void  USBD_SCSI_UnmapParamProcess (const USBD_MSC_LUN_CTRL  *p_lun,
+                                                 USBD_SCSI_LUN_CTX  *p_ctx,
+                                                 USBD_ERR           *p_err)
+{
+    CPU_INT08U  *p_desc;
+    CPU_INT32U   desc_len;
+    CPU_INT32U   nbr_desc;
+    CPU_INT32U   ix;
+    CPU_INT64U   blk_addr;
+    CPU_INT32U   nbr_blks;
+
+
+    desc_len = MEM_VAL_GET_INT16U_BIG(&p_ctx->UnmapParamData[2]);
+    desc_len = DEF_MIN(desc_len, p_ctx->UnmapParamLen - USBD_SCSI_UNMAP_PARAM_HDR_LEN);
+    nbr_desc = desc_len / USBD_SCSI_UNMAP_BLK_DESC_LEN;         /* See Note #2.                                         */
+
+   *p_err = USBD_ERR_NONE;
+    for (ix = 0u; ix < nbr_desc; ix++) {                        /* Chk every desc (see Note #3).                        */
+        p_desc = &p_ctx->UnmapParamData[USBD_SCSI_UNMAP_PARAM_HDR_LEN + (ix * USBD_SCSI_UNMAP_BLK_DESC_LEN)];
+        MEM_VAL_COPY_GET_INTU_BIG(&blk_addr, p_desc, 8u);
+        nbr_blks = MEM_VAL_GET_INT32U_BIG(p_desc + 8u);
+
+        if ((blk_addr >= p_lun->NbrBlocks) ||
+            (nbr_blks > (p_lun->NbrBlocks - blk_addr))) {
+           *p_err = USBD_ERR_SCSI_LOG_BLOCK_ADDR;
+            break;
+        }
+    }
+
+    for (ix = 0u; (ix < nbr_desc) && (*p_err == USBD_ERR_NONE); ix++) {
+        p_desc = &p_ctx->UnmapParamData[USBD_SCSI_UNMAP_PARAM_HDR_LEN + (ix * USBD_SCSI_UNMAP_BLK_DESC_LEN)];
+        MEM_VAL_COPY_GET_INTU_BIG(&blk_addr, p_desc, 8u);
+        nbr_blks = MEM_VAL_GET_INT32U_BIG(p_desc + 8u);
+
+        if (nbr_blks > 0u) {
+            USBD_SCSI_Unmap(p_ctx, blk_addr, nbr_blks, p_err);
+        }
+    }
+
+    USBD_SCSI_LunStatusAnalyze(p_ctx, *p_err);                  /* Check err code & build req sense data.               */
+}
+#endif
+
+
+/*
+**********************************************************************************************************
+*                                          USBD_SCSI_Unmap()
+*
+* Description : Release a range of blocks of a logical unit.
+*
+* Argument(s) : p_ctx           Pointer to logical unit SCSI context.
+*
+*               blk_addr        Logical Block Address (LBA) of starting block to release.
+*
+*               nbr_blks        Number of logical blocks to release.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                                                                   --- RETURNED BY USBD_StorageUnmap() : ---
+*                               USBD_ERR_NONE                       Blocks successfully released.
+*                               USBD_ERR_SCSI_MEDIUM_NOTPRESENT     Releasing blocks failed.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The cached copy of the range is discarded first. A dirty block written back by a later
+*                   flush would otherwise overwrite the released block. Released blocks are also dropped from
+*                   the read-ahead window.
+**********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_UNMAP_EN == DEF_ENABLED)
+static  void  USBD_SCSI_Unmap (USBD_SCSI_LUN_CTX  *p_ctx,
+                               CPU_INT64U          blk_addr,
+                               CPU_INT32U          nbr_blks,
+                               USBD_ERR           *p_err)
+{
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+    USBD_StorageCacheDiscard(&p_ctx->Cache, blk_addr, nbr_blks);/* See Note #1.                                         */
+#endif
+#if (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+    USBD_StorageRdAheadDiscard(&p_ctx->RdAhead, blk_addr, nbr_blks);
+#endif
+
+    USBD_StorageUnmap(&p_ctx->StorageLun, blk_addr, nbr_blks, p_err);
+}
+#endif
+
+
 
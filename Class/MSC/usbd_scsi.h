@@ -77,6 +77,7 @@
 */
 
 typedef  struct  usbd_storage_lun {
+    CPU_INT08U    ClassNbr;                                     /* MSC class instance number of the logical unit.       */
     CPU_INT08U    LunNbr;                                       /* Logical Unit Number.                                 */
     CPU_CHAR     *VolStrPtr;                                    /* String uniquely identifying a logical unit.          */
     CPU_BOOLEAN   MediumPresent;                                /* Flag indicating presence of logical unit.            */
@@ -85,6 +86,18 @@ typedef  struct  usbd_storage_lun {
 } USBD_STORAGE_LUN;
 
 
+/*
+**********************************************************************************************************
+*                                   STORAGE ACCESS COMPLETION CALLBACK
+**********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_STORAGE_ASYNC_EN == DEF_ENABLED)
+typedef  void  (*USBD_STORAGE_ASYNC_CMPL)(void      *p_cmpl_arg,
+                                          USBD_ERR   err);
+#endif
+
+
 /*
 **********************************************************************************************************
 *                                        LOGICAL UNIT CHARACTERISTICS
@@ -106,6 +119,7 @@ typedef  struct  usbd_lun_info {
 */
 
 typedef  struct  usbd_msc_lun_ctrl {
+    CPU_INT08U       ClassNbr;                                  /* MSC instance the logical unit belongs to.            */
     CPU_INT08U       LunNbr;                                    /* LUN given by MSC IF.                                 */
     USBD_LUN_INFO    LunInfo;                                   /* Logical unit info.                                   */
     CPU_INT64U       NbrBlocks;                                 /* Nbr of blks supported by logical unit.               */
@@ -136,7 +150,8 @@ typedef  struct  usbd_msc_lun_ctrl {
 
 void  USBD_SCSI_Init      (      USBD_ERR          *p_err);
 
-void  USBD_SCSI_LunAdd    (      CPU_INT08U         lun_nbr,
+void  USBD_SCSI_LunAdd    (      CPU_INT08U         class_nbr,
+                                 CPU_INT08U         lun_nbr,
                                  CPU_CHAR          *p_vol_str,
                                  USBD_ERR          *p_err);
 
@@ -159,13 +174,70 @@ void  USBD_SCSI_DataWr    (const USBD_MSC_LUN_CTRL  *p_lun,
                                  CPU_INT32U          data_len,
                                  USBD_ERR           *p_err);
 
-void  USBD_SCSI_Reset     (      void);
+#if (USBD_MSC_CFG_ZERO_COPY_EN == DEF_ENABLED)
+void  USBD_SCSI_DataRdPtrGet(const USBD_MSC_LUN_CTRL  *p_lun,
+                                   CPU_INT08U          scsi_cmd,
+                                   CPU_INT32U          data_len,
+                                   CPU_INT08U        **pp_data_buf,
+                                   CPU_INT32U         *p_ret_len,
+                                   USBD_ERR           *p_err);
+
+void  USBD_SCSI_DataWrPtrGet(const USBD_MSC_LUN_CTRL  *p_lun,
+                                   CPU_INT08U          scsi_cmd,
+                                   CPU_INT32U          data_len,
+                                   CPU_INT08U        **pp_data_buf,
+                                   USBD_ERR           *p_err);
+#endif
+
+#if (USBD_MSC_CFG_STORAGE_ASYNC_EN == DEF_ENABLED)
+CPU_INT08U  USBD_SCSI_AsyncQDepthGet(const USBD_MSC_LUN_CTRL        *p_lun,
+                                           CPU_INT08U                scsi_cmd);
+
+void  USBD_SCSI_DataRdAsync (const USBD_MSC_LUN_CTRL        *p_lun,
+                                   CPU_INT08U                scsi_cmd,
+                                   CPU_INT08U               *p_data_buf,
+                                   CPU_INT32U                data_len,
+                                   USBD_STORAGE_ASYNC_CMPL   cmpl_fnct,
+                                   void                     *p_cmpl_arg,
+                                   USBD_ERR                 *p_err);
+
+void  USBD_SCSI_DataWrAsync (const USBD_MSC_LUN_CTRL        *p_lun,
+                                   CPU_INT08U                scsi_cmd,
+                                   CPU_INT08U               *p_data_buf,
+                                   CPU_INT32U                data_len,
+                                   USBD_STORAGE_ASYNC_CMPL   cmpl_fnct,
+                                   void                     *p_cmpl_arg,
+                                   USBD_ERR                 *p_err);
+
+void  USBD_SCSI_DataAsyncCmpl(const USBD_MSC_LUN_CTRL        *p_lun,
+                                    USBD_ERR                  err);
+#endif
+
+void  USBD_SCSI_Reset     (      CPU_INT08U         class_nbr);
 
 void  USBD_SCSI_Conn      (const USBD_MSC_LUN_CTRL  *p_lun);
 
 void  USBD_SCSI_Unlock    (const USBD_MSC_LUN_CTRL  *p_lun,
                                  USBD_ERR           *p_err);
 
+#if (USBD_MSC_CFG_UAS_EN == DEF_ENABLED)
+CPU_INT08U  USBD_SCSI_SenseGet(const USBD_MSC_LUN_CTRL  *p_lun,
+                                     CPU_INT08U         *p_buf,
+                                     CPU_INT08U          buf_len);
+#endif
+
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+void  USBD_SCSI_CacheStatGet(const USBD_MSC_LUN_CTRL    *p_lun,
+                                   USBD_MSC_CACHE_STAT  *p_stat);
+#endif
+
+#if (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+void  USBD_SCSI_RdAheadFill   (const USBD_MSC_LUN_CTRL       *p_lun);
+
+void  USBD_SCSI_RdAheadStatGet(const USBD_MSC_LUN_CTRL       *p_lun,
+                                     USBD_MSC_RD_AHEAD_STAT  *p_stat);
+#endif
+
 
 /*
 **********************************************************************************************************
@@ -0,0 +1,934 @@
+/*
+*********************************************************************************************************
+*                                            uC/USB-Device
+*                                    The Embedded USB Device Stack
+*
+*                    Copyright 2004-2021 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*
+*                                  USB DEVICE MSC STORAGE BLOCK CACHE
+*
+* Filename : usbd_storage_cache.c
+* Version  : V4.06.01
+*********************************************************************************************************
+* Note(s)  : (1) The block cache sits between the SCSI layer and the storage layer of a logical unit. It
+*                only relies on USBD_StorageRd() and USBD_StorageWr(), so it can be used with any storage
+*                layer.
+*
+*            (2) The cache is write-back : written blocks are kept in the cache and are only written to
+*                the storage layer when their entry is reused or when the cache is flushed. Entries are
+*                reused in least recently used order, invalid entries first.
+*
+*            (3) A cache is only accessed from the task of the MSC instance its logical unit belongs to.
+*                Only the statistics may be read from another task.
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#define    MICRIUM_SOURCE
+#include  "usbd_storage_cache.h"
+#if (USBD_MSC_CFG_MICRIUM_FS == DEF_ENABLED)
+#include  "Storage/uC-FS/V4/usbd_storage.h"
+#else
+#include  "Storage/RAMDisk/usbd_storage.h"
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                             LOCAL CONSTANTS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                              LOCAL TABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                       LOCAL GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+static  CPU_INT08U                *USBD_StorageCacheEntryDataGet(USBD_STORAGE_CACHE        *p_cache,
+                                                                 USBD_STORAGE_CACHE_ENTRY  *p_entry);
+
+static  USBD_STORAGE_CACHE_ENTRY  *USBD_StorageCacheEntryFind   (USBD_STORAGE_CACHE        *p_cache,
+                                                                 CPU_INT64U                 blk_addr);
+
+static  USBD_STORAGE_CACHE_ENTRY  *USBD_StorageCacheEntryAlloc  (USBD_STORAGE_CACHE        *p_cache,
+                                                                 USBD_STORAGE_LUN          *p_storage_lun,
+                                                                 CPU_INT64U                 blk_addr,
+                                                                 USBD_ERR                  *p_err);
+
+static  void                       USBD_StorageCacheBlkSizeSet  (USBD_STORAGE_CACHE        *p_cache,
+                                                                 USBD_STORAGE_LUN          *p_storage_lun,
+                                                                 CPU_INT32U                 blk_size,
+                                                                 USBD_ERR                  *p_err);
+
+static  void                       USBD_StorageCacheMissRd      (USBD_STORAGE_CACHE        *p_cache,
+                                                                 USBD_STORAGE_LUN          *p_storage_lun,
+                                                                 CPU_INT64U                 blk_addr,
+                                                                 CPU_INT32U                 nbr_blks,
+                                                                 CPU_BOOLEAN                alloc,
+                                                                 CPU_INT08U                *p_data_buf,
+                                                                 USBD_ERR                  *p_err);
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                     LOCAL CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*********************************************************************************************************
+*                                          GLOBAL FUNCTIONS
+*********************************************************************************************************
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+/*
+*********************************************************************************************************
+*                                       USBD_StorageCacheInit()
+*
+* Description : Allocate the data buffer of a logical unit's block cache and invalidate the cache.
+*
+* Argument(s) : p_cache     Pointer to logical unit block cache.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE   Block cache successfully initialized.
+*                               USBD_ERR_ALLOC  Block cache data buffer allocation failed.
+*
+* Return(s)   : None.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+void  USBD_StorageCacheInit (USBD_STORAGE_CACHE  *p_cache,
+                             USBD_ERR            *p_err)
+{
+    CPU_SIZE_T  buf_len;
+    LIB_ERR     err_lib;
+
+
+    if (p_cache->BufPtr == (CPU_INT08U *)0) {                   /* Cache buf is kept if LUN is added again.             */
+        buf_len         = (CPU_SIZE_T)USBD_MSC_CFG_CACHE_NBR_BLK * USBD_MSC_CFG_CACHE_BLK_SIZE;
+        p_cache->BufPtr = (CPU_INT08U *)Mem_HeapAlloc(              buf_len,
+                                                                    USBD_CFG_BUF_ALIGN_OCTETS,
+                                                      (CPU_SIZE_T *)DEF_NULL,
+                                                                   &err_lib);
+        if (err_lib != LIB_MEM_ERR_NONE) {
+           *p_err = USBD_ERR_ALLOC;
+            return;
+        }
+    }
+
+    USBD_StorageCacheInvalidate(p_cache);
+
+    Mem_Clr((void     *)&p_cache->Stat,
+            (CPU_SIZE_T) sizeof(USBD_MSC_CACHE_STAT));
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_StorageCacheIsEn()
+*
+* Description : Determine if the blocks of a logical unit go through the block cache.
+*
+* Argument(s) : p_cache     Pointer to logical unit block cache.
+*
+*               blk_size    Block size of the logical unit.
+*
+* Return(s)   : DEF_YES, if the logical unit's blocks are cached.
+*
+*               DEF_NO,  otherwise.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+CPU_BOOLEAN  USBD_StorageCacheIsEn (USBD_STORAGE_CACHE  *p_cache,
+                                    CPU_INT32U           blk_size)
+{
+    if ((p_cache->BufPtr == (CPU_INT08U *)0)            ||
+        (blk_size        == 0u)                         ||
+        (blk_size         > USBD_MSC_CFG_CACHE_BLK_SIZE)) {
+        return (DEF_NO);
+    }
+
+    return (DEF_YES);
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_StorageCacheRd()
+*
+* Description : Read blocks through the block cache.
+*
+* Argument(s) : p_cache         Pointer to logical unit block cache.
+*
+*               p_storage_lun   Pointer to the logical unit storage structure.
+*
+*               blk_addr        Logical Block Address (LBA) of starting read block.
+*
+*               nbr_blks        Number of logical blocks to read.
+*
+*               blk_size        Block size of the logical unit.
+*
+*               alloc           Indicate if the blocks read from the storage layer are inserted in the
+*                               cache (see Note #2) :
+*
+*                                   DEF_YES     Insert the blocks in the cache.
+*                                   DEF_NO      Only return the blocks.
+*
+*               p_data_buf      Pointer to buffer in which data will be stored.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                       Blocks successfully read.
+*
+*                                                                   --- RETURNED BY USBD_StorageRd() : ---
+*                                                                   --- RETURNED BY USBD_StorageWr() : ---
+*                               USBD_ERR_SCSI_MEDIUM_NOTPRESENT     Accessing logical unit failed.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Consecutive blocks missing from the cache are read from the storage layer with a single
+*                   request.
+*
+*               (2) Large reads are not inserted in the cache so that a long sequential read does not evict
+*                   the whole working set. Blocks that are already cached, in particular dirty blocks, are
+*                   always returned from the cache.
+*********************************************************************************************************
+*/
+
+void  USBD_StorageCacheRd (USBD_STORAGE_CACHE  *p_cache,
+                           USBD_STORAGE_LUN    *p_storage_lun,
+                           CPU_INT64U           blk_addr,
+                           CPU_INT32U           nbr_blks,
+                           CPU_INT32U           blk_size,
+                           CPU_BOOLEAN          alloc,
+                           CPU_INT08U          *p_data_buf,
+                           USBD_ERR            *p_err)
+{
+    CPU_INT32U                 ix;
+    CPU_INT32U                 miss_ix;
+    CPU_INT32U                 miss_cnt;
+    USBD_STORAGE_CACHE_ENTRY  *p_entry;
+
+
+    if (USBD_StorageCacheIsEn(p_cache, blk_size) == DEF_NO) {
+        USBD_StorageRd(p_storage_lun,
+                       blk_addr,
+                       nbr_blks,
+                       p_data_buf,
+                       p_err);
+        return;
+    }
+
+    USBD_StorageCacheBlkSizeSet(p_cache, p_storage_lun, blk_size, p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    miss_ix  = 0u;
+    miss_cnt = 0u;
+    for (ix = 0u; ix < nbr_blks; ix++) {
+        p_entry = USBD_StorageCacheEntryFind(p_cache, blk_addr + ix);
+        if (p_entry == (USBD_STORAGE_CACHE_ENTRY *)0) {
+            if (miss_cnt == 0u) {                               /* Start a new run of missing blks (see Note #1).       */
+                miss_ix = ix;
+            }
+            miss_cnt++;
+            continue;
+        }
+
+        Mem_Copy((void *)&p_data_buf[ix * blk_size],            /* Blk hit: copy it before any entry is reused.         */
+                 (void *) USBD_StorageCacheEntryDataGet(p_cache, p_entry),
+                          blk_size);
+        p_cache->UseCtr++;
+        p_entry->LastUse = p_cache->UseCtr;
+        p_cache->Stat.RdHitCnt++;
+
+        if (miss_cnt > 0u) {                                    /* Rd run of missing blks preceding the hit.            */
+            USBD_StorageCacheMissRd(p_cache,
+                                    p_storage_lun,
+                                    blk_addr + miss_ix,
+                                    miss_cnt,
+                                    alloc,
+                                   &p_data_buf[miss_ix * blk_size],
+                                    p_err);
+            if (*p_err != USBD_ERR_NONE) {
+                return;
+            }
+            miss_cnt = 0u;
+        }
+    }
+
+    if (miss_cnt > 0u) {
+        USBD_StorageCacheMissRd(p_cache,
+                                p_storage_lun,
+                                blk_addr + miss_ix,
+                                miss_cnt,
+                                alloc,
+                               &p_data_buf[miss_ix * blk_size],
+                                p_err);
+        if (*p_err != USBD_ERR_NONE) {
+            return;
+        }
+    }
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_StorageCacheWr()
+*
+* Description : Write blocks through the block cache.
+*
+* Argument(s) : p_cache         Pointer to logical unit block cache.
+*
+*               p_storage_lun   Pointer to the logical unit storage structure.
+*
+*               blk_addr        Logical Block Address (LBA) of starting write block.
+*
+*               nbr_blks        Number of logical blocks to write.
+*
+*               blk_size        Block size of the logical unit.
+*
+*               alloc           Indicate if the blocks that are not cached are inserted in the cache
+*                               (see Note #2) :
+*
+*                                   DEF_YES     Insert the blocks in the cache.
+*                                   DEF_NO      Write the blocks to the storage layer.
+*
+*               p_data_buf      Pointer to buffer that holds the data to write.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                       Blocks successfully written.
+*
+*                                                                   ---- RETURNED BY USBD_StorageWr() : ---
+*                               USBD_ERR_SCSI_MEDIUM_NOTPRESENT     Writing to logical unit failed.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Blocks written to the cache are marked dirty and only reach the storage layer when
+*                   their entry is reused or when the cache is flushed.
+*
+*               (2) Large writes are not inserted in the cache. Blocks that are already cached are updated
+*                   in the cache so that it never holds stale data, and the other blocks are written to the
+*                   storage layer, consecutive blocks with a single request.
+*********************************************************************************************************
+*/
+
+void  USBD_StorageCacheWr (USBD_STORAGE_CACHE  *p_cache,
+                           USBD_STORAGE_LUN    *p_storage_lun,
+                           CPU_INT64U           blk_addr,
+                           CPU_INT32U           nbr_blks,
+                           CPU_INT32U           blk_size,
+                           CPU_BOOLEAN          alloc,
+                           CPU_INT08U          *p_data_buf,
+                           USBD_ERR            *p_err)
+{
+    CPU_INT32U                 ix;
+    CPU_INT32U                 miss_ix;
+    CPU_INT32U                 miss_cnt;
+    USBD_STORAGE_CACHE_ENTRY  *p_entry;
+
+
+    if (USBD_StorageCacheIsEn(p_cache, blk_size) == DEF_NO) {
+        USBD_StorageWr(p_storage_lun,
+                       blk_addr,
+                       nbr_blks,
+                       p_data_buf,
+                       p_err);
+        return;
+    }
+
+    USBD_StorageCacheBlkSizeSet(p_cache, p_storage_lun, blk_size, p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    miss_ix  = 0u;
+    miss_cnt = 0u;
+    for (ix = 0u; ix < nbr_blks; ix++) {
+        p_entry = USBD_StorageCacheEntryFind(p_cache, blk_addr + ix);
+        if (p_entry != (USBD_STORAGE_CACHE_ENTRY *)0) {
+            p_cache->Stat.WrHitCnt++;
+
+        } else if (alloc == DEF_YES) {
+            p_cache->Stat.WrMissCnt++;
+            p_entry = USBD_StorageCacheEntryAlloc(p_cache, p_storage_lun, blk_addr + ix, p_err);
+            if (*p_err != USBD_ERR_NONE) {
+                return;
+            }
+
+        } else {                                                /* Uncached blk of a large wr (see Note #2).            */
+            p_cache->Stat.WrMissCnt++;
+            if (miss_cnt == 0u) {
+                miss_ix = ix;
+            }
+            miss_cnt++;
+            continue;
+        }
+
+        Mem_Copy((void *) USBD_StorageCacheEntryDataGet(p_cache, p_entry),
+                 (void *)&p_data_buf[ix * blk_size],
+                          blk_size);
+        p_entry->Dirty = DEF_YES;                               /* See Note #1.                                         */
+        p_cache->UseCtr++;
+        p_entry->LastUse = p_cache->UseCtr;
+
+        if (miss_cnt > 0u) {
+            USBD_StorageWr(p_storage_lun,
+                           blk_addr + miss_ix,
+                           miss_cnt,
+                          &p_data_buf[miss_ix * blk_size],
+                           p_err);
+            if (*p_err != USBD_ERR_NONE) {
+                return;
+            }
+            miss_cnt = 0u;
+        }
+    }
+
+    if (miss_cnt > 0u) {
+        USBD_StorageWr(p_storage_lun,
+                       blk_addr + miss_ix,
+                       miss_cnt,
+                      &p_data_buf[miss_ix * blk_size],
+                       p_err);
+        if (*p_err != USBD_ERR_NONE) {
+            return;
+        }
+    }
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_StorageCacheFlush()
+*
+* Description : Write all dirty blocks of the block cache to the storage layer.
+*
+* Argument(s) : p_cache         Pointer to logical unit block cache.
+*
+*               p_storage_lun   Pointer to the logical unit storage structure.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                       Cache successfully flushed.
+*
+*                                                                   ---- RETURNED BY USBD_StorageWr() : ---
+*                               USBD_ERR_SCSI_MEDIUM_NOTPRESENT     Writing to logical unit failed.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Dirty blocks are written in ascending block address order. Dirty blocks with consecutive
+*                   addresses held by consecutive entries are contiguous in the cache buffer and are written
+*                   with a single request. Since free entries are used in order, this is the usual case for
+*                   sequential writes.
+*
+*               (2) If a write fails, the remaining blocks stay dirty and the flush can be retried.
+*********************************************************************************************************
+*/
+
+void  USBD_StorageCacheFlush (USBD_STORAGE_CACHE  *p_cache,
+                              USBD_STORAGE_LUN    *p_storage_lun,
+                              USBD_ERR            *p_err)
+{
+    CPU_INT32U                 ix;
+    CPU_INT32U                 first_ix;
+    CPU_INT32U                 run_cnt;
+    USBD_STORAGE_CACHE_ENTRY  *p_entry;
+    USBD_STORAGE_CACHE_ENTRY  *p_first;
+
+
+   *p_err = USBD_ERR_NONE;
+
+    if ((p_cache->BufPtr  == (CPU_INT08U *)0) ||
+        (p_cache->BlkSize == 0u)) {
+        return;
+    }
+
+    for (;;) {
+        p_first  = (USBD_STORAGE_CACHE_ENTRY *)0;
+        first_ix = 0u;
+        for (ix = 0u; ix < USBD_MSC_CFG_CACHE_NBR_BLK; ix++) {  /* Find dirty blk with lowest addr (see Note #1).       */
+            p_entry = &p_cache->EntryTbl[ix];
+            if ((p_entry->Valid == DEF_YES) &&
+                (p_entry->Dirty == DEF_YES)) {
+                if ((p_first          == (USBD_STORAGE_CACHE_ENTRY *)0) ||
+                    (p_entry->BlkAddr  <  p_first->BlkAddr)) {
+                    p_first  = p_entry;
+                    first_ix = ix;
+                }
+            }
+        }
+
+        if (p_first == (USBD_STORAGE_CACHE_ENTRY *)0) {         /* No more dirty blks.                                  */
+            break;
+        }
+                                                                /* Extend run with following entries.                   */
+        run_cnt = 1u;
+        while ((first_ix + run_cnt) < USBD_MSC_CFG_CACHE_NBR_BLK) {
+            p_entry = &p_cache->EntryTbl[first_ix + run_cnt];
+            if ((p_entry->Valid   != DEF_YES) ||
+                (p_entry->Dirty   != DEF_YES) ||
+                (p_entry->BlkAddr != (p_first->BlkAddr + run_cnt))) {
+                break;
+            }
+            run_cnt++;
+        }
+
+        USBD_StorageWr(p_storage_lun,
+                       p_first->BlkAddr,
+                       run_cnt,
+                       USBD_StorageCacheEntryDataGet(p_cache, p_first),
+                       p_err);
+        if (*p_err != USBD_ERR_NONE) {                          /* See Note #2.                                         */
+            return;
+        }
+
+        for (ix = first_ix; ix < (first_ix + run_cnt); ix++) {
+            p_cache->EntryTbl[ix].Dirty = DEF_NO;
+        }
+        p_cache->Stat.WrBackCnt += run_cnt;
+        p_cache->Stat.WrBackReqCnt++;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                    USBD_StorageCacheInvalidate()
+*
+* Description : Discard all the blocks held by the block cache.
+*
+* Argument(s) : p_cache     Pointer to logical unit block cache.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Dirty blocks are discarded without being written. The cache must be flushed first if
+*                   their data must be kept.
+*********************************************************************************************************
+*/
+
+void  USBD_StorageCacheInvalidate (USBD_STORAGE_CACHE  *p_cache)
+{
+    CPU_INT32U  ix;
+
+
+    for (ix = 0u; ix < USBD_MSC_CFG_CACHE_NBR_BLK; ix++) {
+        p_cache->EntryTbl[ix].BlkAddr = 0u;
+        p_cache->EntryTbl[ix].LastUse = 0u;
+        p_cache->EntryTbl[ix].Valid   = DEF_NO;
+        p_cache->EntryTbl[ix].Dirty   = DEF_NO;
+    }
+    p_cache->BlkSize = 0u;
+    p_cache->UseCtr  = 0u;
+}
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_StorageCacheDiscard()
+*
+* Description : Discard the cached copy of a range of blocks.
+*
+* Argument(s) : p_cache     Pointer to logical unit block cache.
+*
+*               blk_addr    Logical Block Address (LBA) of starting block to discard.
+*
+*               nbr_blks    Number of logical blocks to discard.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Used when blocks are released by the host. Dirty blocks in the range are dropped without
+*                   being written, since their data is no longer needed.
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_UNMAP_EN == DEF_ENABLED)
+void  USBD_StorageCacheDiscard (USBD_STORAGE_CACHE  *p_cache,
+                                CPU_INT64U           blk_addr,
+                                CPU_INT32U           nbr_blks)
+{
+    USBD_STORAGE_CACHE_ENTRY  *p_entry;
+    CPU_INT32U                 ix;
+
+
+    for (ix = 0u; ix < USBD_MSC_CFG_CACHE_NBR_BLK; ix++) {
+        p_entry = &p_cache->EntryTbl[ix];
+        if ((p_entry->Valid   == DEF_YES)  &&
+            (p_entry->BlkAddr >= blk_addr) &&
+            (p_entry->BlkAddr <  blk_addr + nbr_blks)) {
+            p_entry->Valid = DEF_NO;                            /* See Note #1.                                         */
+            p_entry->Dirty = DEF_NO;
+        }
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_StorageCacheStatGet()
+*
+* Description : Get the statistics of the block cache.
+*
+* Argument(s) : p_cache     Pointer to logical unit block cache.
+*
+*               p_stat      Pointer to structure that will receive the statistics.
+*
+* Return(s)   : None.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+void  USBD_StorageCacheStatGet (USBD_STORAGE_CACHE   *p_cache,
+                                USBD_MSC_CACHE_STAT  *p_stat)
+{
+    CPU_SR_ALLOC();
+
+
+    CPU_CRITICAL_ENTER();                                       /* Stats are updated by the MSC task.                   */
+    Mem_Copy((void     *) p_stat,
+             (void     *)&p_cache->Stat,
+             (CPU_SIZE_T) sizeof(USBD_MSC_CACHE_STAT));
+    CPU_CRITICAL_EXIT();
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*********************************************************************************************************
+*                                           LOCAL FUNCTIONS
+*********************************************************************************************************
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+/*
+*********************************************************************************************************
+*                                   USBD_StorageCacheEntryDataGet()
+*
+* Description : Get the data of a cache entry.
+*
+* Argument(s) : p_cache     Pointer to logical unit block cache.
+*
+*               p_entry     Pointer to cache entry.
+*
+* Return(s)   : Pointer to the entry's block data.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+static  CPU_INT08U  *USBD_StorageCacheEntryDataGet (USBD_STORAGE_CACHE        *p_cache,
+                                                    USBD_STORAGE_CACHE_ENTRY  *p_entry)
+{
+    CPU_INT32U  ix;
+
+
+    ix = (CPU_INT32U)(p_entry - &p_cache->EntryTbl[0]);
+
+    return (&p_cache->BufPtr[ix * p_cache->BlkSize]);
+}
+
+
+/*
+*********************************************************************************************************
+*                                    USBD_StorageCacheEntryFind()
+*
+* Description : Find the cache entry holding a block.
+*
+* Argument(s) : p_cache     Pointer to logical unit block cache.
+*
+*               blk_addr    Logical Block Address (LBA) of the block.
+*
+* Return(s)   : Pointer to the cache entry, if the block is cached.
+*
+*               Null pointer,                otherwise.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+static  USBD_STORAGE_CACHE_ENTRY  *USBD_StorageCacheEntryFind (USBD_STORAGE_CACHE  *p_cache,
+                                                               CPU_INT64U           blk_addr)
+{
+    CPU_INT32U                 ix;
+    USBD_STORAGE_CACHE_ENTRY  *p_entry;
+
+
+    for (ix = 0u; ix < USBD_MSC_CFG_CACHE_NBR_BLK; ix++) {
+        p_entry = &p_cache->EntryTbl[ix];
+        if ((p_entry->Valid   == DEF_YES) &&
+            (p_entry->BlkAddr == blk_addr)) {
+            return (p_entry);
+        }
+    }
+
+    return ((USBD_STORAGE_CACHE_ENTRY *)0);
+}
+
+
+/*
+*********************************************************************************************************
+*                                    USBD_StorageCacheEntryAlloc()
+*
+* Description : Get a cache entry to hold a block that is not cached.
+*
+* Argument(s) : p_cache         Pointer to logical unit block cache.
+*
+*               p_storage_lun   Pointer to the logical unit storage structure.
+*
+*               blk_addr        Logical Block Address (LBA) of the block.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                       Entry successfully allocated.
+*
+*                                                                   ---- RETURNED BY USBD_StorageWr() : ---
+*                               USBD_ERR_SCSI_MEDIUM_NOTPRESENT     Writing back the reused entry failed.
+*
+* Return(s)   : Pointer to the cache entry, if NO error(s).
+*
+*               Null pointer,                otherwise.
+*
+* Note(s)     : (1) The first invalid entry is used if any, otherwise the least recently used entry is
+*                   reused. A dirty entry is written to the storage layer before being reused.
+*
+*               (2) The returned entry is valid and clean. Its data must be filled by the caller.
+*********************************************************************************************************
+*/
+
+static  USBD_STORAGE_CACHE_ENTRY  *USBD_StorageCacheEntryAlloc (USBD_STORAGE_CACHE  *p_cache,
+                                                                USBD_STORAGE_LUN    *p_storage_lun,
+                                                                CPU_INT64U           blk_addr,
+                                                                USBD_ERR            *p_err)
+{
+    CPU_INT32U                 ix;
+    USBD_STORAGE_CACHE_ENTRY  *p_entry;
+    USBD_STORAGE_CACHE_ENTRY  *p_victim;
+
+
+    p_victim = &p_cache->EntryTbl[0];
+    for (ix = 0u; ix < USBD_MSC_CFG_CACHE_NBR_BLK; ix++) {      /* See Note #1.                                         */
+        p_entry = &p_cache->EntryTbl[ix];
+        if (p_entry->Valid == DEF_NO) {
+            p_victim = p_entry;
+            break;
+        }
+                                                                /* Ctr wrap-around is handled by the subtraction.       */
+        if ((CPU_INT32U)(p_cache->UseCtr - p_entry->LastUse) >
+            (CPU_INT32U)(p_cache->UseCtr - p_victim->LastUse)) {
+            p_victim = p_entry;
+        }
+    }
+
+    if ((p_victim->Valid == DEF_YES) &&
+        (p_victim->Dirty == DEF_YES)) {
+        USBD_StorageWr(p_storage_lun,
+                       p_victim->BlkAddr,
+                       1u,
+                       USBD_StorageCacheEntryDataGet(p_cache, p_victim),
+                       p_err);
+        if (*p_err != USBD_ERR_NONE) {
+            return ((USBD_STORAGE_CACHE_ENTRY *)0);
+        }
+        p_cache->Stat.WrBackCnt++;
+        p_cache->Stat.WrBackReqCnt++;
+    }
+
+    p_victim->BlkAddr = blk_addr;                               /* See Note #2.                                         */
+    p_victim->Valid   = DEF_YES;
+    p_victim->Dirty   = DEF_NO;
+
+   *p_err = USBD_ERR_NONE;
+
+    return (p_victim);
+}
+
+
+/*
+*********************************************************************************************************
+*                                    USBD_StorageCacheBlkSizeSet()
+*
+* Description : Set the size of the blocks held by the block cache.
+*
+* Argument(s) : p_cache         Pointer to logical unit block cache.
+*
+*               p_storage_lun   Pointer to the logical unit storage structure.
+*
+*               blk_size        Block size of the logical unit.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                       Block size successfully set.
+*
+*                                                                   ---- RETURNED BY USBD_StorageWr() : ---
+*                               USBD_ERR_SCSI_MEDIUM_NOTPRESENT     Flushing the cache failed.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The block size of a logical unit is only known once the host has read its capacity and
+*                   may change with the medium. The cache is flushed and emptied when it changes.
+*********************************************************************************************************
+*/
+
+static  void  USBD_StorageCacheBlkSizeSet (USBD_STORAGE_CACHE  *p_cache,
+                                           USBD_STORAGE_LUN    *p_storage_lun,
+                                           CPU_INT32U           blk_size,
+                                           USBD_ERR            *p_err)
+{
+    if (p_cache->BlkSize == blk_size) {
+       *p_err = USBD_ERR_NONE;
+        return;
+    }
+
+    USBD_StorageCacheFlush(p_cache, p_storage_lun, p_err);      /* See Note #1.                                         */
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    USBD_StorageCacheInvalidate(p_cache);
+    p_cache->BlkSize = blk_size;
+}
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_StorageCacheMissRd()
+*
+* Description : Read a run of consecutive blocks missing from the block cache.
+*
+* Argument(s) : p_cache         Pointer to logical unit block cache.
+*
+*               p_storage_lun   Pointer to the logical unit storage structure.
+*
+*               blk_addr        Logical Block Address (LBA) of the first block.
+*
+*               nbr_blks        Number of logical blocks to read.
+*
+*               alloc           Indicate if the blocks are inserted in the cache.
+*
+*               p_data_buf      Pointer to buffer in which data will be stored.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                       Blocks successfully read.
+*
+*                                                                   --- RETURNED BY USBD_StorageRd() : ---
+*                                                                   --- RETURNED BY USBD_StorageWr() : ---
+*                               USBD_ERR_SCSI_MEDIUM_NOTPRESENT     Accessing logical unit failed.
+*
+* Return(s)   : None.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+static  void  USBD_StorageCacheMissRd (USBD_STORAGE_CACHE  *p_cache,
+                                       USBD_STORAGE_LUN    *p_storage_lun,
+                                       CPU_INT64U           blk_addr,
+                                       CPU_INT32U           nbr_blks,
+                                       CPU_BOOLEAN          alloc,
+                                       CPU_INT08U          *p_data_buf,
+                                       USBD_ERR            *p_err)
+{
+    CPU_INT32U                 ix;
+    USBD_STORAGE_CACHE_ENTRY  *p_entry;
+
+
+    USBD_StorageRd(p_storage_lun,
+                   blk_addr,
+                   nbr_blks,
+                   p_data_buf,
+                   p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    p_cache->Stat.RdMissCnt += nbr_blks;
+
+    if (alloc == DEF_NO) {
+        return;
+    }
+
+    for (ix = 0u; ix < nbr_blks; ix++) {                        /* Insert blks in cache.                                */
+        p_entry = USBD_StorageCacheEntryAlloc(p_cache, p_storage_lun, blk_addr + ix, p_err);
+        if (*p_err != USBD_ERR_NONE) {
+            return;
+        }
+        p_cache->UseCtr++;
+        p_entry->LastUse = p_cache->UseCtr;
+
+        Mem_Copy((void *) USBD_StorageCacheEntryDataGet(p_cache, p_entry),
+                 (void *)&p_data_buf[ix * p_cache->BlkSize],
+                          p_cache->BlkSize);
+    }
+}
+#endif
@@ -0,0 +1,170 @@
+/*
+*********************************************************************************************************
+*                                            uC/USB-Device
+*                                    The Embedded USB Device Stack
+*
+*                    Copyright 2004-2021 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*
+*                                  USB DEVICE MSC STORAGE BLOCK CACHE
+*
+* Filename : usbd_storage_cache.h
+* Version  : V4.06.01
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                               MODULE
+*********************************************************************************************************
+*/
+
+#ifndef  USBD_STORAGE_CACHE_H
+#define  USBD_STORAGE_CACHE_H
+
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#include  "../../Source/usbd_core.h"
+#include  "usbd_scsi.h"
+
+
+/*
+*********************************************************************************************************
+*                                               DEFINES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                             DATA TYPES
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+/*
+*********************************************************************************************************
+*                                          CACHED BLOCK ENTRY
+*********************************************************************************************************
+*/
+
+typedef  struct  usbd_storage_cache_entry {
+    CPU_INT64U    BlkAddr;                                      /* Logical blk addr held by entry.                      */
+    CPU_INT32U    LastUse;                                      /* Cache access ctr value at last access.               */
+    CPU_BOOLEAN   Valid;                                        /* Entry holds a blk.                                   */
+    CPU_BOOLEAN   Dirty;                                        /* Blk modified & not yet wr to storage layer.          */
+} USBD_STORAGE_CACHE_ENTRY;
+
+
+/*
+*********************************************************************************************************
+*                                       LOGICAL UNIT BLOCK CACHE
+*
+* Note(s) : (1) The data of entry 'n' is located at offset (n * BlkSize) of the buffer pointed by BufPtr,
+*               so that entries holding consecutive blocks in consecutive slots can be written back to
+*               the storage layer with a single request.
+*********************************************************************************************************
+*/
+
+typedef  struct  usbd_storage_cache {
+    CPU_INT08U                *BufPtr;                          /* Ptr to blk data buf (see Note #1).                   */
+    CPU_INT32U                 BlkSize;                         /* Size of cached blks, 0 if nothing cached yet.        */
+    CPU_INT32U                 UseCtr;                          /* Cache access ctr.                                    */
+    USBD_STORAGE_CACHE_ENTRY   EntryTbl[USBD_MSC_CFG_CACHE_NBR_BLK];
+    USBD_MSC_CACHE_STAT        Stat;                            /* Cache stats.                                         */
+} USBD_STORAGE_CACHE;
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                               MACRO'S
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                         FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_CACHE_EN == DEF_ENABLED)
+void         USBD_StorageCacheInit      (USBD_STORAGE_CACHE   *p_cache,
+                                         USBD_ERR             *p_err);
+
+CPU_BOOLEAN  USBD_StorageCacheIsEn      (USBD_STORAGE_CACHE   *p_cache,
+                                         CPU_INT32U            blk_size);
+
+void         USBD_StorageCacheRd        (USBD_STORAGE_CACHE   *p_cache,
+                                         USBD_STORAGE_LUN     *p_storage_lun,
+                                         CPU_INT64U            blk_addr,
+                                         CPU_INT32U            nbr_blks,
+                                         CPU_INT32U            blk_size,
+                                         CPU_BOOLEAN           alloc,
+                                         CPU_INT08U           *p_data_buf,
+                                         USBD_ERR             *p_err);
+
+void         USBD_StorageCacheWr        (USBD_STORAGE_CACHE   *p_cache,
+                                         USBD_STORAGE_LUN     *p_storage_lun,
+                                         CPU_INT64U            blk_addr,
+                                         CPU_INT32U            nbr_blks,
+                                         CPU_INT32U            blk_size,
+                                         CPU_BOOLEAN           alloc,
+                                         CPU_INT08U           *p_data_buf,
+                                         USBD_ERR             *p_err);
+
+void         USBD_StorageCacheFlush     (USBD_STORAGE_CACHE   *p_cache,
+                                         USBD_STORAGE_LUN     *p_storage_lun,
+                                         USBD_ERR             *p_err);
+
+void         USBD_StorageCacheInvalidate(USBD_STORAGE_CACHE   *p_cache);
+
+#if (USBD_MSC_CFG_UNMAP_EN == DEF_ENABLED)
+void         USBD_StorageCacheDiscard   (USBD_STORAGE_CACHE   *p_cache,
+                                         CPU_INT64U            blk_addr,
+                                         CPU_INT32U            nbr_blks);
+#endif
+
+void         USBD_StorageCacheStatGet   (USBD_STORAGE_CACHE   *p_cache,
+                                         USBD_MSC_CACHE_STAT  *p_stat);
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                        CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                             MODULE END
+*********************************************************************************************************
+*/
+
+#endif
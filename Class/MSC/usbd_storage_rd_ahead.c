@@ -0,0 +1,498 @@
+/*
+*********************************************************************************************************
+*                                            uC/USB-Device
+*                                    The Embedded USB Device Stack
+*
+*                    Copyright 2004-2021 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*
+*                                   USB DEVICE MSC STORAGE READ-AHEAD
+*
+* Filename : usbd_storage_rd_ahead.c
+* Version  : V4.06.01
+*********************************************************************************************************
+* Note(s)  : (1) The read-ahead window sits between the SCSI layer and the storage layer of a logical
+*                unit. It only relies on USBD_StorageRd(), so it can be used with any storage layer.
+*
+*            (2) A READ command starting at the block following the previous READ command is sequential.
+*                After the CSW of a sequential READ command, the blocks following it are read into the
+*                window with a single storage request, so that the next READ command of the stream is
+*                served without accessing the storage layer.
+*
+*            (3) The window only holds blocks read from the storage layer. Blocks written or released by
+*                the host drop the whole window, which is never written back.
+*
+*            (4) A window is only accessed from the task of the MSC instance its logical unit belongs to.
+*                Only the statistics may be read from another task.
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#define    MICRIUM_SOURCE
+#include  "usbd_storage_rd_ahead.h"
+#if (USBD_MSC_CFG_MICRIUM_FS == DEF_ENABLED)
+#include  "Storage/uC-FS/V4/usbd_storage.h"
+#else
+#include  "Storage/RAMDisk/usbd_storage.h"
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#define  USBD_STORAGE_RD_AHEAD_SEQ_MIN                    1u    /* Nbr of sequential READ cmds before filling window.   */
+
+
+/*
+*********************************************************************************************************
+*                                             LOCAL CONSTANTS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                              LOCAL TABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                       LOCAL GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                     LOCAL CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*********************************************************************************************************
+*                                          GLOBAL FUNCTIONS
+*********************************************************************************************************
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+/*
+*********************************************************************************************************
+*                                      USBD_StorageRdAheadInit()
+*
+* Description : Allocate the data buffer of a logical unit's read-ahead window and empty the window.
+*
+* Argument(s) : p_ra        Pointer to logical unit read-ahead window.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE   Read-ahead window successfully initialized.
+*                               USBD_ERR_ALLOC  Read-ahead window data buffer allocation failed.
+*
+* Return(s)   : None.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+void  USBD_StorageRdAheadInit (USBD_STORAGE_RD_AHEAD  *p_ra,
+                               USBD_ERR               *p_err)
+{
+    CPU_SIZE_T  buf_len;
+    LIB_ERR     err_lib;
+
+
+    if (p_ra->BufPtr == (CPU_INT08U *)0) {                      /* Window buf is kept if LUN is added again.            */
+        buf_len      = (CPU_SIZE_T)USBD_MSC_CFG_RD_AHEAD_NBR_BLK * USBD_MSC_CFG_RD_AHEAD_BLK_SIZE;
+        p_ra->BufPtr = (CPU_INT08U *)Mem_HeapAlloc(              buf_len,
+                                                                 USBD_CFG_BUF_ALIGN_OCTETS,
+                                                   (CPU_SIZE_T *)DEF_NULL,
+                                                                &err_lib);
+        if (err_lib != LIB_MEM_ERR_NONE) {
+           *p_err = USBD_ERR_ALLOC;
+            return;
+        }
+    }
+
+    USBD_StorageRdAheadInvalidate(p_ra);
+
+    Mem_Clr((void     *)&p_ra->Stat,
+            (CPU_SIZE_T) sizeof(USBD_MSC_RD_AHEAD_STAT));
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_StorageRdAheadIsEn()
+*
+* Description : Determine if the blocks of a logical unit are read ahead.
+*
+* Argument(s) : p_ra        Pointer to logical unit read-ahead window.
+*
+*               blk_size    Block size of the logical unit.
+*
+* Return(s)   : DEF_YES, if the logical unit's blocks are read ahead.
+*
+*               DEF_NO,  otherwise.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+CPU_BOOLEAN  USBD_StorageRdAheadIsEn (USBD_STORAGE_RD_AHEAD  *p_ra,
+                                      CPU_INT32U              blk_size)
+{
+    if ((p_ra->BufPtr == (CPU_INT08U *)0)               ||
+        (blk_size     == 0u)                            ||
+        (blk_size      > USBD_MSC_CFG_RD_AHEAD_BLK_SIZE)) {
+        return (DEF_NO);
+    }
+
+    return (DEF_YES);
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_StorageRdAheadCmd()
+*
+* Description : Track the block range of a new READ command.
+*
+* Argument(s) : p_ra        Pointer to logical unit read-ahead window.
+*
+*               blk_addr    Logical Block Address (LBA) of starting read block.
+*
+*               nbr_blks    Number of logical blocks to read.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The window is filled after the command's CSW once USBD_STORAGE_RD_AHEAD_SEQ_MIN
+*                   sequential READ commands were received in a row (see 'usbd_storage_rd_ahead.c',
+*                   Note #2).
+*********************************************************************************************************
+*/
+
+void  USBD_StorageRdAheadCmd (USBD_STORAGE_RD_AHEAD  *p_ra,
+                              CPU_INT64U              blk_addr,
+                              CPU_INT32U              nbr_blks)
+{
+    if (nbr_blks == 0u) {
+        return;
+    }
+
+    if ((p_ra->LastNbrBlks != 0u)               &&
+        (p_ra->NextBlkAddr == blk_addr)) {
+        p_ra->SeqCnt++;
+        p_ra->Stat.SeqCmdCnt++;
+    } else {
+        p_ra->SeqCnt = 0u;                                      /* Stream broken: restart detection.                    */
+    }
+
+    p_ra->NextBlkAddr = blk_addr + nbr_blks;
+    p_ra->LastNbrBlks = nbr_blks;
+    p_ra->FillReq     = (p_ra->SeqCnt >= USBD_STORAGE_RD_AHEAD_SEQ_MIN) ? DEF_YES : DEF_NO;
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_StorageRdAheadRd()
+*
+* Description : Read blocks through the read-ahead window.
+*
+* Argument(s) : p_ra            Pointer to logical unit read-ahead window.
+*
+*               p_storage_lun   Pointer to the logical unit storage structure.
+*
+*               blk_addr        Logical Block Address (LBA) of starting read block.
+*
+*               nbr_blks        Number of logical blocks to read.
+*
+*               blk_size        Block size of the logical unit.
+*
+*               p_data_buf      Pointer to buffer in which data will be stored.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                       Blocks successfully read.
+*
+*                                                                   --- RETURNED BY USBD_StorageRd() : ---
+*                               USBD_ERR_SCSI_MEDIUM_NOTPRESENT     Accessing logical unit failed.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Only the leading blocks found in the window are copied from it. The remaining blocks
+*                   are read from the storage layer with a single request.
+*********************************************************************************************************
+*/
+
+void  USBD_StorageRdAheadRd (USBD_STORAGE_RD_AHEAD  *p_ra,
+                             USBD_STORAGE_LUN       *p_storage_lun,
+                             CPU_INT64U              blk_addr,
+                             CPU_INT32U              nbr_blks,
+                             CPU_INT32U              blk_size,
+                             CPU_INT08U             *p_data_buf,
+                             USBD_ERR               *p_err)
+{
+    CPU_INT32U  hit_cnt;
+    CPU_INT64U  win_end;
+
+
+    if (USBD_StorageRdAheadIsEn(p_ra, blk_size) == DEF_NO) {
+        USBD_StorageRd(p_storage_lun,
+                       blk_addr,
+                       nbr_blks,
+                       p_data_buf,
+                       p_err);
+        return;
+    }
+
+    hit_cnt = 0u;
+    win_end = p_ra->BlkAddr + p_ra->NbrBlks;
+    if ((p_ra->NbrBlks != 0u)            &&
+        (blk_addr      >= p_ra->BlkAddr) &&
+        (blk_addr      <  win_end)) {                           /* Copy leading blks held by the window.                */
+        hit_cnt = (win_end - blk_addr < nbr_blks) ? (CPU_INT32U)(win_end - blk_addr) : nbr_blks;
+        Mem_Copy((void     *) p_data_buf,
+                 (void     *)&p_ra->BufPtr[(blk_addr - p_ra->BlkAddr) * blk_size],
+                 (CPU_SIZE_T)(hit_cnt * blk_size));
+    }
+
+    if (hit_cnt < nbr_blks) {                                   /* Rd remaining blks (see Note #1).                     */
+        USBD_StorageRd(p_storage_lun,
+                       blk_addr + hit_cnt,
+                       nbr_blks - hit_cnt,
+                      &p_data_buf[hit_cnt * blk_size],
+                       p_err);
+        if (*p_err != USBD_ERR_NONE) {
+            return;
+        }
+    } else {
+       *p_err = USBD_ERR_NONE;
+    }
+
+    p_ra->Stat.RdBlkCnt  += nbr_blks;
+    p_ra->Stat.HitBlkCnt += hit_cnt;
+}
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_StorageRdAheadFill()
+*
+* Description : Read the blocks following a sequential READ command into the read-ahead window.
+*
+* Argument(s) : p_ra            Pointer to logical unit read-ahead window.
+*
+*               p_storage_lun   Pointer to the logical unit storage structure.
+*
+*               blk_size        Block size of the logical unit.
+*
+*               lun_nbr_blks    Number of blocks of the logical unit.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                       Window filled or no fill needed.
+*
+*                                                                   --- RETURNED BY USBD_StorageRd() : ---
+*                               USBD_ERR_SCSI_MEDIUM_NOTPRESENT     Accessing logical unit failed.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Called once the CSW of the current command is sent. Does nothing unless the current
+*                   command is a sequential READ command (see USBD_StorageRdAheadCmd()).
+*
+*               (2) The window is left untouched if it already holds as many blocks following the last
+*                   READ command as that command read.
+*
+*               (3) The window holds USBD_MSC_CFG_RD_AHEAD_NBR_BLK blocks of USBD_MSC_CFG_RD_AHEAD_BLK_SIZE
+*                   octets, or more blocks if the logical unit's blocks are smaller. The fill stops at the
+*                   end of the logical unit.
+*
+*               (4) The window is left empty if the storage layer fails to read the blocks. The error is
+*                   reported to the host by the next READ command that needs the blocks.
+*********************************************************************************************************
+*/
+
+void  USBD_StorageRdAheadFill (USBD_STORAGE_RD_AHEAD  *p_ra,
+                               USBD_STORAGE_LUN       *p_storage_lun,
+                               CPU_INT32U              blk_size,
+                               CPU_INT64U              lun_nbr_blks,
+                               USBD_ERR               *p_err)
+{
+    CPU_INT32U  win_nbr_blks;
+    CPU_INT32U  nbr_blks;
+    CPU_INT64U  next_end;
+
+
+   *p_err = USBD_ERR_NONE;
+
+    if (p_ra->FillReq == DEF_NO) {                              /* See Note #1.                                         */
+        return;
+    }
+    p_ra->FillReq = DEF_NO;
+
+    if ((USBD_StorageRdAheadIsEn(p_ra, blk_size) == DEF_NO) ||
+        (p_ra->NextBlkAddr >= lun_nbr_blks)) {
+        return;
+    }
+
+    win_nbr_blks = (USBD_MSC_CFG_RD_AHEAD_NBR_BLK * USBD_MSC_CFG_RD_AHEAD_BLK_SIZE) / blk_size;
+    nbr_blks     = (p_ra->LastNbrBlks < win_nbr_blks) ? p_ra->LastNbrBlks : win_nbr_blks;
+    next_end     =  p_ra->NextBlkAddr + nbr_blks;
+    if ((p_ra->NbrBlks     != 0u)                           &&
+        (p_ra->NextBlkAddr >= p_ra->BlkAddr)                &&
+        (next_end          <= p_ra->BlkAddr + p_ra->NbrBlks)) {
+        return;                                                 /* See Note #2.                                         */
+    }
+                                                                /* See Note #3.                                         */
+    nbr_blks = win_nbr_blks;
+    if (lun_nbr_blks - p_ra->NextBlkAddr < nbr_blks) {
+        nbr_blks = (CPU_INT32U)(lun_nbr_blks - p_ra->NextBlkAddr);
+    }
+
+    p_ra->NbrBlks = 0u;                                         /* See Note #4.                                         */
+    USBD_StorageRd(p_storage_lun,
+                   p_ra->NextBlkAddr,
+                   nbr_blks,
+                   p_ra->BufPtr,
+                   p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    p_ra->BlkAddr          = p_ra->NextBlkAddr;
+    p_ra->NbrBlks          = nbr_blks;
+    p_ra->Stat.FillCnt++;
+    p_ra->Stat.FillBlkCnt += nbr_blks;
+}
+
+
+/*
+*********************************************************************************************************
+*                                   USBD_StorageRdAheadInvalidate()
+*
+* Description : Empty the read-ahead window and restart sequential stream detection.
+*
+* Argument(s) : p_ra        Pointer to logical unit read-ahead window.
+*
+* Return(s)   : None.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+void  USBD_StorageRdAheadInvalidate (USBD_STORAGE_RD_AHEAD  *p_ra)
+{
+    if (p_ra->NbrBlks != 0u) {
+        p_ra->Stat.DiscardCnt++;
+    }
+    p_ra->BlkAddr     = 0u;
+    p_ra->NbrBlks     = 0u;
+    p_ra->NextBlkAddr = 0u;
+    p_ra->LastNbrBlks = 0u;
+    p_ra->SeqCnt      = 0u;
+    p_ra->FillReq     = DEF_NO;
+}
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_StorageRdAheadDiscard()
+*
+* Description : Empty the read-ahead window if it holds blocks of a range.
+*
+* Argument(s) : p_ra        Pointer to logical unit read-ahead window.
+*
+*               blk_addr    Logical Block Address (LBA) of starting block to discard.
+*
+*               nbr_blks    Number of logical blocks to discard.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) Used when blocks are written or released by the host (see 'usbd_storage_rd_ahead.c',
+*                   Note #3). Sequential stream detection is not affected.
+*********************************************************************************************************
+*/
+
+void  USBD_StorageRdAheadDiscard (USBD_STORAGE_RD_AHEAD  *p_ra,
+                                  CPU_INT64U              blk_addr,
+                                  CPU_INT32U              nbr_blks)
+{
+    if ((p_ra->NbrBlks != 0u)                           &&
+        (blk_addr      <  p_ra->BlkAddr + p_ra->NbrBlks) &&
+        (p_ra->BlkAddr <  blk_addr      + nbr_blks)) {
+        p_ra->NbrBlks = 0u;
+        p_ra->Stat.DiscardCnt++;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_StorageRdAheadStatGet()
+*
+* Description : Get the statistics of the read-ahead window.
+*
+* Argument(s) : p_ra        Pointer to logical unit read-ahead window.
+*
+*               p_stat      Pointer to structure that will receive the statistics.
+*
+* Return(s)   : None.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+void  USBD_StorageRdAheadStatGet (USBD_STORAGE_RD_AHEAD   *p_ra,
+                                  USBD_MSC_RD_AHEAD_STAT  *p_stat)
+{
+    CPU_SR_ALLOC();
+
+
+    CPU_CRITICAL_ENTER();                                       /* Stats are updated by the MSC task.                   */
+    Mem_Copy((void     *) p_stat,
+             (void     *)&p_ra->Stat,
+             (CPU_SIZE_T) sizeof(USBD_MSC_RD_AHEAD_STAT));
+    CPU_CRITICAL_EXIT();
+}
+#endif
@@ -0,0 +1,156 @@
+/*
+*********************************************************************************************************
+*                                            uC/USB-Device
+*                                    The Embedded USB Device Stack
+*
+*                    Copyright 2004-2021 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*
+*                                   USB DEVICE MSC STORAGE READ-AHEAD
+*
+* Filename : usbd_storage_rd_ahead.h
+* Version  : V4.06.01
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                               MODULE
+*********************************************************************************************************
+*/
+
+#ifndef  USBD_STORAGE_RD_AHEAD_H
+#define  USBD_STORAGE_RD_AHEAD_H
+
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#include  "../../Source/usbd_core.h"
+#include  "usbd_scsi.h"
+
+
+/*
+*********************************************************************************************************
+*                                               DEFINES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                             DATA TYPES
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+/*
+*********************************************************************************************************
+*                                    LOGICAL UNIT READ-AHEAD WINDOW
+*
+* Note(s) : (1) The window holds the NbrBlks consecutive blocks starting at BlkAddr. It is empty when
+*               NbrBlks is 0.
+*
+*           (2) NextBlkAddr is the block following the last READ command. A READ command starting at
+*               NextBlkAddr continues a sequential stream.
+*********************************************************************************************************
+*/
+
+typedef  struct  usbd_storage_rd_ahead {
+    CPU_INT08U              *BufPtr;                            /* Ptr to window data buf.                              */
+    CPU_INT64U               BlkAddr;                           /* Logical blk addr of first blk in window.             */
+    CPU_INT32U               NbrBlks;                           /* Nbr of blks in window (see Note #1).                 */
+    CPU_INT64U               NextBlkAddr;                       /* Blk following the last READ cmd (see Note #2).       */
+    CPU_INT32U               LastNbrBlks;                       /* Nbr of blks rd by the last READ cmd.                 */
+    CPU_INT32U               SeqCnt;                            /* Nbr of consecutive sequential READ cmds.             */
+    CPU_BOOLEAN              FillReq;                           /* Window must be filled after the cur cmd.             */
+    USBD_MSC_RD_AHEAD_STAT   Stat;                              /* Read-ahead stats.                                    */
+} USBD_STORAGE_RD_AHEAD;
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                               MACRO'S
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                         FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+#if (USBD_MSC_CFG_RD_AHEAD_EN == DEF_ENABLED)
+void         USBD_StorageRdAheadInit      (USBD_STORAGE_RD_AHEAD   *p_ra,
+                                           USBD_ERR                *p_err);
+
+CPU_BOOLEAN  USBD_StorageRdAheadIsEn      (USBD_STORAGE_RD_AHEAD   *p_ra,
+                                           CPU_INT32U               blk_size);
+
+void         USBD_StorageRdAheadCmd       (USBD_STORAGE_RD_AHEAD   *p_ra,
+                                           CPU_INT64U               blk_addr,
+                                           CPU_INT32U               nbr_blks);
+
+void         USBD_StorageRdAheadRd        (USBD_STORAGE_RD_AHEAD   *p_ra,
+                                           USBD_STORAGE_LUN        *p_storage_lun,
+                                           CPU_INT64U               blk_addr,
+                                           CPU_INT32U               nbr_blks,
+                                           CPU_INT32U               blk_size,
+                                           CPU_INT08U              *p_data_buf,
+                                           USBD_ERR                *p_err);
+
+void         USBD_StorageRdAheadFill      (USBD_STORAGE_RD_AHEAD   *p_ra,
+                                           USBD_STORAGE_LUN        *p_storage_lun,
+                                           CPU_INT32U               blk_size,
+                                           CPU_INT64U               lun_nbr_blks,
+                                           USBD_ERR                *p_err);
+
+void         USBD_StorageRdAheadInvalidate(USBD_STORAGE_RD_AHEAD   *p_ra);
+
+void         USBD_StorageRdAheadDiscard   (USBD_STORAGE_RD_AHEAD   *p_ra,
+                                           CPU_INT64U               blk_addr,
+                                           CPU_INT32U               nbr_blks);
+
+void         USBD_StorageRdAheadStatGet   (USBD_STORAGE_RD_AHEAD   *p_ra,
+                                           USBD_MSC_RD_AHEAD_STAT  *p_stat);
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                        CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                             MODULE END
+*********************************************************************************************************
+*/
+
+#endif
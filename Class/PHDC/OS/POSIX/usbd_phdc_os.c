@@ -0,0 +1,585 @@
+/*
+*********************************************************************************************************
+*                                            uC/USB-Device
+*                                    The Embedded USB Device Stack
+*
+*                    Copyright 2004-2021 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*
+*                                 USB PHDC CLASS OPERATING SYSTEM LAYER
+*                                                POSIX
+*
+* Filename : usbd_phdc_os.c
+* Version  : V4.06.01
+*********************************************************************************************************
+* Note(s)  : (1) This port relies on the primitives of the POSIX core OS port ('OS/POSIX/usbd_os.c').
+*
+*            (2) Task priorities #define'd in 'app_cfg.h' are NOT used : see 'OS/POSIX/usbd_os.c  Note #2'.
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#define    MICRIUM_SOURCE
+#include  <app_cfg.h>
+#include  "../../usbd_phdc.h"
+#include  "../../usbd_phdc_os.h"
+#include  "../../../../OS/POSIX/usbd_os_posix.h"
+
+
+/*
+*********************************************************************************************************
+*                                        CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+#if USBD_PHDC_OS_CFG_SCHED_EN == DEF_ENABLED
+#ifndef USBD_PHDC_OS_CFG_SCHED_TASK_STK_SIZE
+#error  "USBD_PHDC_OS_CFG_SCHED_TASK_STK_SIZE not #define'd in 'app_cfg.h' [MUST be > 0]"
+#endif
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#if USBD_PHDC_OS_CFG_SCHED_EN == DEF_ENABLED
+#define  USBD_PHDC_OS_BULK_WR_PRIO_MAX                     5u
+#else
+#define  USBD_PHDC_OS_BULK_WR_PRIO_MAX                     1u
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                           LOCAL CONSTANTS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                          LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                          PHDC OS CTRL INFO
+*
+* Note(s) : (1) The scheduler task can NOT pend on several semaphores at once. Instead, lock & release
+*               requests are accumulated in 'SchedLockReqCnt' & 'SchedReleaseReq' and a single scheduler
+*               semaphore, shared by all class instances, is posted to wake the scheduler task up.
+*********************************************************************************************************
+*/
+
+typedef struct usbd_phdc_os_ctrl {
+    USBD_OS_POSIX_SEM   WrIntrSem;                              /* Lock that protect wr intr EP.                        */
+    USBD_OS_POSIX_SEM   RdSem;                                  /* Lock that protect rd bulk EP.                        */
+    USBD_OS_POSIX_SEM   WrBulkSem[USBD_PHDC_OS_BULK_WR_PRIO_MAX];
+                                                                /* Sem that unlock bulk write of given prio.            */
+#if USBD_PHDC_OS_CFG_SCHED_EN == DEF_ENABLED
+    CPU_INT08U          WrBulkSemCtr[USBD_PHDC_OS_BULK_WR_PRIO_MAX];
+                                                                /* Count of lock performed on given prio.               */
+    CPU_BOOLEAN         ReleasedSched;                          /* Indicate if sched is released.                       */
+    CPU_INT08U          WrBulkLockCnt;                          /* Count of call to WrBulkLock.                         */
+    CPU_INT08U          SchedLockReqCnt;                        /* Lock req not yet handled by sched (see Note #1).     */
+    CPU_BOOLEAN         SchedReleaseReq;                        /* Release req not yet handled by sched.                */
+#endif
+} USBD_PHDC_OS_CTRL;
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL TABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                       LOCAL GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+static  USBD_PHDC_OS_CTRL  USBD_PHDC_OS_CtrlTbl[USBD_PHDC_CFG_MAX_NBR_DEV];
+
+#if USBD_PHDC_OS_CFG_SCHED_EN == DEF_ENABLED
+static  USBD_OS_POSIX_SEM  USBD_PHDC_OS_SchedSem;               /* Sem that wakes up sched task.                        */
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL MACRO'S
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+#if USBD_PHDC_OS_CFG_SCHED_EN == DEF_ENABLED
+static  void  USBD_PHDC_OS_WrBulkSchedTask(void  *p_arg);
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_PHDC_OS_Init()
+*
+* Description : Initialize PHDC OS interface.
+*
+* Argument(s) : p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE               OS initialization successful.
+*                               USBD_ERR_OS_SIGNAL_CREATE   OS semaphore NOT successfully initialized.
+*                               USBD_ERR_OS_INIT_FAIL       OS task      NOT successfully initialized.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_PHDC_OS_Init (USBD_ERR  *p_err)
+{
+    USBD_PHDC_OS_CTRL  *p_os_ctrl;
+    CPU_INT08U          ix;
+    CPU_INT08U          cnt;
+    USBD_ERR            err;
+
+
+    for (cnt = 0; cnt < USBD_PHDC_CFG_MAX_NBR_DEV; cnt ++) {
+        p_os_ctrl = &USBD_PHDC_OS_CtrlTbl[cnt];
+
+        USBD_OS_POSIX_SemCreate(&p_os_ctrl->WrIntrSem, 1u, &err);
+        if (err != USBD_ERR_NONE) {
+           *p_err = USBD_ERR_OS_SIGNAL_CREATE;
+            return;
+        }
+
+        USBD_OS_POSIX_SemCreate(&p_os_ctrl->RdSem, 1u, &err);
+        if (err != USBD_ERR_NONE) {
+           *p_err = USBD_ERR_OS_SIGNAL_CREATE;
+            return;
+        }
+
+        for (ix = 0u; ix < USBD_PHDC_OS_BULK_WR_PRIO_MAX; ix++) {
+#if USBD_PHDC_OS_CFG_SCHED_EN == DEF_ENABLED
+            USBD_OS_POSIX_SemCreate(&p_os_ctrl->WrBulkSem[ix], 0u, &err);
+#else
+            USBD_OS_POSIX_SemCreate(&p_os_ctrl->WrBulkSem[ix], 1u, &err);
+#endif
+            if (err != USBD_ERR_NONE) {
+               *p_err = USBD_ERR_OS_SIGNAL_CREATE;
+                return;
+            }
+#if USBD_PHDC_OS_CFG_SCHED_EN == DEF_ENABLED
+            p_os_ctrl->WrBulkSemCtr[ix] = 0u;
+#endif
+        }
+
+#if USBD_PHDC_OS_CFG_SCHED_EN == DEF_ENABLED
+        p_os_ctrl->WrBulkLockCnt   = 0u;
+        p_os_ctrl->ReleasedSched   = DEF_YES;                   /* Sched is released by dflt.                           */
+        p_os_ctrl->SchedLockReqCnt = 0u;
+        p_os_ctrl->SchedReleaseReq = DEF_NO;
+#endif
+    }
+
+#if USBD_PHDC_OS_CFG_SCHED_EN == DEF_ENABLED
+    USBD_OS_POSIX_SemCreate(&USBD_PHDC_OS_SchedSem, 0u, &err);  /* Create sched sem.                                    */
+    if (err != USBD_ERR_NONE) {
+       *p_err = USBD_ERR_OS_SIGNAL_CREATE;
+        return;
+    }
+                                                                /* Create sched task.                                   */
+    USBD_OS_POSIX_TaskCreate(        "USB PHDC Scheduler",
+                                      USBD_PHDC_OS_WrBulkSchedTask,
+                             (void *) 0,
+                                      USBD_PHDC_OS_CFG_SCHED_TASK_STK_SIZE,
+                                     &err);
+    if (err != USBD_ERR_NONE) {
+       *p_err = USBD_ERR_OS_INIT_FAIL;
+        return;
+    }
+#endif
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_PHDC_OS_RdLock()
+*
+* Description : Lock PHDC read pipe.
+*
+* Argument(s) : class_nbr   PHDC instance number;
+*
+*               timeout     Timeout, in ms.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE           OS signal     successfully acquired.
+*                               USBD_OS_ERR_TIMEOUT     OS signal NOT successfully acquired in the time
+*                                                         specified by 'timeout'.
+*                               USBD_OS_ERR_ABORT       OS signal aborted.
+*                               USBD_OS_ERR_FAIL        OS signal not acquired because another error.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_PHDC_OS_RdLock (CPU_INT08U   class_nbr,
+                           CPU_INT16U   timeout,
+                           USBD_ERR    *p_err)
+{
+    USBD_PHDC_OS_CTRL  *p_os_ctrl;
+
+
+    p_os_ctrl = &USBD_PHDC_OS_CtrlTbl[class_nbr];
+
+    USBD_OS_POSIX_SemPend(&p_os_ctrl->RdSem, timeout, p_err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_PHDC_OS_RdUnlock()
+*
+* Description : Unlock PHDC read pipe.
+*
+* Argument(s) : class_nbr   PHDC instance number;
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_PHDC_OS_RdUnlock (CPU_INT08U  class_nbr)
+{
+    USBD_PHDC_OS_CTRL  *p_os_ctrl;
+    USBD_ERR            err;
+
+
+    p_os_ctrl = &USBD_PHDC_OS_CtrlTbl[class_nbr];
+
+    USBD_OS_POSIX_SemPost(&p_os_ctrl->RdSem, &err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_PHDC_OS_WrIntrLock()
+*
+* Description : Lock PHDC write interrupt pipe.
+*
+* Argument(s) : class_nbr   PHDC instance number;
+*
+*               timeout     Timeout, in ms.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE           OS signal     successfully acquired.
+*                               USBD_OS_ERR_TIMEOUT     OS signal NOT successfully acquired in the time
+*                                                       specified by 'timeout'.
+*                               USBD_OS_ERR_ABORT       OS signal aborted.
+*                               USBD_OS_ERR_FAIL        OS signal not acquired because another error.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_PHDC_OS_WrIntrLock (CPU_INT08U   class_nbr,
+                               CPU_INT16U   timeout,
+                               USBD_ERR    *p_err)
+{
+    USBD_PHDC_OS_CTRL  *p_os_ctrl;
+
+
+    p_os_ctrl = &USBD_PHDC_OS_CtrlTbl[class_nbr];
+
+    USBD_OS_POSIX_SemPend(&p_os_ctrl->WrIntrSem, timeout, p_err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_PHDC_OS_WrIntrUnlock()
+*
+* Description : Unlock PHDC write interrupt pipe.
+*
+* Argument(s) : class_nbr   PHDC instance number;
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_PHDC_OS_WrIntrUnlock (CPU_INT08U  class_nbr)
+{
+    USBD_PHDC_OS_CTRL  *p_os_ctrl;
+    USBD_ERR            err;
+
+
+    p_os_ctrl = &USBD_PHDC_OS_CtrlTbl[class_nbr];
+
+    USBD_OS_POSIX_SemPost(&p_os_ctrl->WrIntrSem, &err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_PHDC_OS_WrBulkLock()
+*
+* Description : Lock PHDC write bulk pipe.
+*
+* Argument(s) : class_nbr   PHDC instance number;
+*
+*               timeout     Timeout, in ms.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE           OS signal     successfully acquired.
+*                               USBD_OS_ERR_TIMEOUT     OS signal NOT successfully acquired in the time
+*                                                         specified by 'timeout'.
+*                               USBD_OS_ERR_ABORT       OS signal aborted.
+*                               USBD_OS_ERR_FAIL        OS signal not acquired because another error.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_PHDC_OS_WrBulkLock (CPU_INT08U   class_nbr,
+                               CPU_INT08U   prio,
+                               CPU_INT16U   timeout,
+                               USBD_ERR    *p_err)
+{
+    USBD_OS_POSIX_SEM   *p_sem;
+    USBD_PHDC_OS_CTRL   *p_os_ctrl;
+#if USBD_PHDC_OS_CFG_SCHED_EN == DEF_ENABLED
+    USBD_ERR             err;
+    CPU_SR_ALLOC();
+#else
+    (void)prio;
+#endif
+
+
+    p_os_ctrl = &USBD_PHDC_OS_CtrlTbl[class_nbr];
+
+#if USBD_PHDC_OS_CFG_SCHED_EN == DEF_ENABLED
+    p_sem = &p_os_ctrl->WrBulkSem[prio];
+
+    CPU_CRITICAL_ENTER();
+    p_os_ctrl->WrBulkSemCtr[prio]++;
+    p_os_ctrl->SchedLockReqCnt++;                               /* Req lock to sched (see 'PHDC OS CTRL INFO Note #1'). */
+    CPU_CRITICAL_EXIT();
+
+    USBD_OS_POSIX_SemPost(&USBD_PHDC_OS_SchedSem, &err);
+#else
+    p_sem = &p_os_ctrl->WrBulkSem[0];
+#endif
+
+    USBD_OS_POSIX_SemPend(p_sem, timeout, p_err);
+
+#if USBD_PHDC_OS_CFG_SCHED_EN == DEF_ENABLED
+    CPU_CRITICAL_ENTER();
+    if (p_os_ctrl->WrBulkSemCtr[prio] > 0) {
+        p_os_ctrl->WrBulkSemCtr[prio]--;
+    }
+
+    if ((*p_err                   == USBD_ERR_OS_TIMEOUT) &&
+        ( p_os_ctrl->WrBulkLockCnt > 0)) {
+        p_os_ctrl->WrBulkLockCnt--;
+    }
+    CPU_CRITICAL_EXIT();
+#endif
+}
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_PHDC_OS_WrBulkUnlock()
+*
+* Description : Unlock PHDC write bulk pipe.
+*
+* Argument(s) : class_nbr   PHDC instance number;
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_PHDC_OS_WrBulkUnlock (CPU_INT08U  class_nbr)
+{
+    USBD_PHDC_OS_CTRL   *p_os_ctrl;
+    USBD_ERR             err;
+#if USBD_PHDC_OS_CFG_SCHED_EN == DEF_ENABLED
+    CPU_SR_ALLOC();
+#endif
+
+
+    p_os_ctrl = &USBD_PHDC_OS_CtrlTbl[class_nbr];
+
+#if USBD_PHDC_OS_CFG_SCHED_EN == DEF_ENABLED
+    CPU_CRITICAL_ENTER();
+    p_os_ctrl->SchedReleaseReq = DEF_YES;                       /* Req release to sched.                                */
+    CPU_CRITICAL_EXIT();
+
+    USBD_OS_POSIX_SemPost(&USBD_PHDC_OS_SchedSem, &err);
+#else
+    USBD_OS_POSIX_SemPost(&p_os_ctrl->WrBulkSem[0], &err);
+#endif
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_PHDC_OS_Reset()
+*
+* Description : Reset PHDC OS layer for given instance.
+*
+* Argument(s) : class_nbr   PHDC instance number;
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_PHDC_OS_Reset (CPU_INT08U  class_nbr)
+{
+    USBD_PHDC_OS_CTRL        *p_os_ctrl;
+    CPU_INT08U                cnt;
+#if USBD_PHDC_OS_CFG_SCHED_EN == DEF_ENABLED
+    CPU_SR_ALLOC();
+#endif
+
+
+    p_os_ctrl = &USBD_PHDC_OS_CtrlTbl[class_nbr];
+
+    USBD_OS_POSIX_SemPendAbort(&p_os_ctrl->WrIntrSem);          /* Resume all task pending on sem.                      */
+
+    USBD_OS_POSIX_SemPendAbort(&p_os_ctrl->RdSem);
+
+    for (cnt = 0; cnt < USBD_PHDC_OS_BULK_WR_PRIO_MAX; cnt++) {
+        USBD_OS_POSIX_SemPendAbort(&p_os_ctrl->WrBulkSem[cnt]);
+    }
+
+#if USBD_PHDC_OS_CFG_SCHED_EN == DEF_ENABLED
+    CPU_CRITICAL_ENTER();
+    p_os_ctrl->WrBulkLockCnt   = 0;
+    p_os_ctrl->ReleasedSched   = DEF_YES;
+    p_os_ctrl->SchedLockReqCnt = 0;
+    p_os_ctrl->SchedReleaseReq = DEF_NO;
+
+    for (cnt = 0; cnt < USBD_PHDC_OS_BULK_WR_PRIO_MAX; cnt++) {
+        p_os_ctrl->WrBulkSemCtr[cnt] = 0;
+    }
+    CPU_CRITICAL_EXIT();
+#endif
+}
+
+
+/*
+*********************************************************************************************************
+*                                   USBD_PHDC_OS_WrBulkSchedTask()
+*
+* Description : OS-dependent shell task to schedule bulk transfers in function of their priority.
+*
+* Argument(s) : p_arg       Pointer to task initialization argument.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Only one task handle all class instances bulk write scheduling.
+*
+*               (2) Every time the task is woken up, the lock & release requests of all class instances
+*                   are consumed (see 'PHDC OS CTRL INFO Note #1'). As the scheduler semaphore is posted
+*                   once per request, the task may later wake up with no request left; this is harmless.
+*********************************************************************************************************
+*/
+#if USBD_PHDC_OS_CFG_SCHED_EN == DEF_ENABLED
+static  void  USBD_PHDC_OS_WrBulkSchedTask (void *p_arg)
+{
+    USBD_PHDC_OS_CTRL   *p_os_ctrl;
+    CPU_INT08U           prio;
+    CPU_INT08U           cnt;
+    USBD_ERR             err;
+    CPU_SR_ALLOC();
+
+
+    (void)p_arg;
+
+    while (DEF_ON) {
+        USBD_OS_POSIX_SemPend(&USBD_PHDC_OS_SchedSem, 0u, &err);
+        if (err != USBD_ERR_NONE) {
+            continue;
+        }
+
+        for (cnt = 0; cnt < USBD_PHDC_CFG_MAX_NBR_DEV; cnt++) {
+            p_os_ctrl = &USBD_PHDC_OS_CtrlTbl[cnt];
+            prio      =  USBD_PHDC_OS_BULK_WR_PRIO_MAX;
+
+            CPU_CRITICAL_ENTER();                               /* Consume pending req (see Note #2).                   */
+            p_os_ctrl->WrBulkLockCnt   += p_os_ctrl->SchedLockReqCnt;
+            p_os_ctrl->SchedLockReqCnt  = 0u;
+            if (p_os_ctrl->SchedReleaseReq == DEF_YES) {
+                p_os_ctrl->ReleasedSched   = DEF_YES;
+                p_os_ctrl->SchedReleaseReq = DEF_NO;
+            }
+
+            if ((p_os_ctrl->WrBulkLockCnt  > 0      ) &&
+                (p_os_ctrl->ReleasedSched == DEF_YES)) {
+                prio = 0u;
+
+                p_os_ctrl->WrBulkLockCnt--;
+                p_os_ctrl->ReleasedSched = DEF_NO;
+
+                while (prio < USBD_PHDC_OS_BULK_WR_PRIO_MAX) {
+                    if (p_os_ctrl->WrBulkSemCtr[prio] > 0) {
+                        break;
+                    }
+                    prio++;
+                }
+            }
+            CPU_CRITICAL_EXIT();
+
+            if (prio < USBD_PHDC_OS_BULK_WR_PRIO_MAX) {
+                USBD_OS_POSIX_SemPost(&p_os_ctrl->WrBulkSem[prio], &err);
+            }
+        }
+    }
+}
+#endif
@@ -54,6 +54,10 @@
 #endif
 #endif
 
+#if (OS_VERSION >= 30000)
+#error  "USB-Device PHDC class is not supported by uC/OS-III"
+#endif
+
 
 /*
 *********************************************************************************************************
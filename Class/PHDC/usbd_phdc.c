@@ -324,6 +324,11 @@ static  CPU_INT08U      USBD_PHDC_CtrlNbrNext;
 static  USBD_PHDC_COMM  USBD_PHDC_CommTbl[USBD_PHDC_COM_NBR_MAX];
 static  CPU_INT16U      USBD_PHDC_CommNbrNext;
 
+#if (USBD_CFG_DBG_STATS_POOL_EN == DEF_ENABLED)
+static  USBD_DBG_STATS_POOL  USBD_PHDC_DbgStatsPoolCtrl;
+static  USBD_DBG_STATS_POOL  USBD_PHDC_DbgStatsPoolComm;
+#endif
+
 
 /*
 **********************************************************************************************************
@@ -536,6 +541,9 @@ void  USBD_PHDC_Init (USBD_ERR  *p_err)
     USBD_PHDC_CtrlNbrNext = 0;
     USBD_PHDC_CommNbrNext = 0;
 
+    USBD_DBG_STATS_POOL_REG(&USBD_PHDC_DbgStatsPoolCtrl, "PHDC ctrl", USBD_PHDC_CFG_MAX_NBR_DEV);
+    USBD_DBG_STATS_POOL_REG(&USBD_PHDC_DbgStatsPoolComm, "PHDC comm", USBD_PHDC_COM_NBR_MAX);
+
     USBD_PHDC_OS_Init(p_err);
 }
 
@@ -601,6 +609,7 @@ CPU_INT08U  USBD_PHDC_Add (CPU_BOOLEAN                    data_fmt_11073,
 
     if (phdc_nbr >= USBD_PHDC_CFG_MAX_NBR_DEV) {
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FAIL(&USBD_PHDC_DbgStatsPoolCtrl);
        *p_err = USBD_ERR_PHDC_INSTANCE_ALLOC;
         return (USBD_CLASS_NBR_NONE);
     }
@@ -608,6 +617,8 @@ CPU_INT08U  USBD_PHDC_Add (CPU_BOOLEAN                    data_fmt_11073,
     USBD_PHDC_CtrlNbrNext++;
     CPU_CRITICAL_EXIT();
 
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_PHDC_DbgStatsPoolCtrl);
+
     p_ctrl = &USBD_PHDC_CtrlTbl[phdc_nbr];
 
     p_ctrl->IF_Params.DataFmt11073    = data_fmt_11073;
@@ -702,6 +713,8 @@ CPU_BOOLEAN  USBD_PHDC_CfgAdd (CPU_INT08U   class_nbr,
     if (comm_nbr >= USBD_PHDC_COM_NBR_MAX) {
         USBD_PHDC_CtrlNbrNext--;
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FREE(&USBD_PHDC_DbgStatsPoolCtrl);
+        USBD_DBG_STATS_POOL_FAIL(&USBD_PHDC_DbgStatsPoolComm);
        *p_err = USBD_ERR_PHDC_INSTANCE_ALLOC;
         return (DEF_NO);
     }
@@ -709,6 +722,8 @@ CPU_BOOLEAN  USBD_PHDC_CfgAdd (CPU_INT08U   class_nbr,
     USBD_PHDC_CommNbrNext++;
     CPU_CRITICAL_EXIT();
 
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_PHDC_DbgStatsPoolComm);
+
     p_comm = &USBD_PHDC_CommTbl[comm_nbr];
 
     if_nbr = USBD_IF_Add(        dev_nbr,                       /* Add PHDC to cfg.                                         */
@@ -41,7 +41,6 @@
 */
 
 #include  "../../Source/usbd_core.h"
-#include  <Source/os.h>
 
 
 /*
@@ -116,10 +115,6 @@ void  USBD_PHDC_OS_Reset       (CPU_INT08U   class_nbr);
 *********************************************************************************************************
 */
 
-#if (OS_VERSION >= 30000)
-#error  "USB-Device PHDC class is not supported by uC/OS-III"
-#endif
-
 
 /*
 *********************************************************************************************************
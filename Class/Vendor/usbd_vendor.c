@@ -149,6 +149,11 @@ static  CPU_INT08U        USBD_Vendor_CtrlNbrNext;
                                                                 /* Vendor class comm array.                             */
 static  USBD_VENDOR_COMM  USBD_Vendor_CommTbl[USBD_VENDOR_COMM_NBR_MAX];
 static  CPU_INT08U        USBD_Vendor_CommNbrNext;
+#if (USBD_CFG_DBG_STATS_POOL_EN == DEF_ENABLED)
+                                                                /* Usage stats of class arrays.                         */
+static  USBD_DBG_STATS_POOL  USBD_Vendor_DbgStatsPoolCtrl;
+static  USBD_DBG_STATS_POOL  USBD_Vendor_DbgStatsPoolComm;
+#endif
 
 
 /*
@@ -322,6 +327,9 @@ void  USBD_Vendor_Init (USBD_ERR  *p_err)
     USBD_Vendor_CtrlNbrNext = 0u;
     USBD_Vendor_CommNbrNext = 0u;
 
+    USBD_DBG_STATS_POOL_REG(&USBD_Vendor_DbgStatsPoolCtrl, "Vendor ctrl", USBD_VENDOR_CFG_MAX_NBR_DEV);
+    USBD_DBG_STATS_POOL_REG(&USBD_Vendor_DbgStatsPoolComm, "Vendor comm", USBD_VENDOR_COMM_NBR_MAX);
+
    *p_err = USBD_ERR_NONE;
 }
 
@@ -383,12 +391,15 @@ CPU_INT08U  USBD_Vendor_Add (CPU_BOOLEAN            intr_en,
     vendor_class_nbr = USBD_Vendor_CtrlNbrNext;                 /* Alloc new vendor class instance nbr.                 */
     if (vendor_class_nbr >= USBD_VENDOR_CFG_MAX_NBR_DEV) {      /* Chk if max nbr of instances reached.                 */
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FAIL(&USBD_Vendor_DbgStatsPoolCtrl);
        *p_err = USBD_ERR_VENDOR_INSTANCE_ALLOC;
         return (USBD_CLASS_NBR_NONE);
     }
     USBD_Vendor_CtrlNbrNext++;                                  /* Next avail vendor class instance nbr.                */
     CPU_CRITICAL_EXIT();
 
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_Vendor_DbgStatsPoolCtrl);
+
     p_ctrl = &USBD_Vendor_CtrlTbl[vendor_class_nbr];            /* Get vendor class instance.                           */
                                                                 /* Store vendor class instance info.                    */
     p_ctrl->IntrEn               =  intr_en;                    /* Intr EPs en/dis.                                     */
@@ -520,12 +531,16 @@ void  USBD_Vendor_CfgAdd (CPU_INT08U   class_nbr,
     if (comm_nbr >= USBD_VENDOR_COMM_NBR_MAX) {                 /* Chk if max nbr of comm instances reached.            */
         USBD_Vendor_CtrlNbrNext--;
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FREE(&USBD_Vendor_DbgStatsPoolCtrl);
+        USBD_DBG_STATS_POOL_FAIL(&USBD_Vendor_DbgStatsPoolComm);
        *p_err = USBD_ERR_VENDOR_INSTANCE_ALLOC;
         return;
     }
     USBD_Vendor_CommNbrNext++;                                  /* Next avail vendor class comm info nbr.               */
     CPU_CRITICAL_EXIT();
 
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_Vendor_DbgStatsPoolComm);
+
     p_comm = &USBD_Vendor_CommTbl[comm_nbr];                    /* Get vendor class comm info.                          */
 
                                                                 /* -------------- CFG DESC CONSTRUCTION --------------- */
@@ -0,0 +1,2986 @@
+/*
+*********************************************************************************************************
+*                                            uC/USB-Device
+*                                    The Embedded USB Device Stack
+*
+*                    Copyright 2004-2021 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*
+*                                          USB DEVICE DRIVER
+*
+*                                 SIMULATED CONTROLLER AND VIRTUAL HOST
+*
+* Filename : usbd_drv_sim.c
+* Version  : V4.06.01
+*********************************************************************************************************
+* Note(s)  : (1) The simulated controller keeps, for each physical endpoint, a queue of the buffers
+*                submitted by the core. The virtual host owns one transfer per endpoint and moves it
+*                forward one transaction at a time each time USBD_DrvSim_FrameRun() is called :
+*
+*                (a) Periodic (isochronous and interrupt) endpoints are served first, up to their number
+*                    of transactions per (micro)frame. Control and bulk endpoints then share the rest of
+*                    the (micro)frame in round-robin order.
+*
+*                (b) The device answers each token as a controller would : ACK when a buffer is queued,
+*                    NAK otherwise, STALL when the endpoint is halted. SETUP tokens are always accepted.
+*
+*                (c) Every transaction that completes a buffer, and every bus event, raises the
+*                    controller interrupt : the driver ISR is called from the virtual host context and
+*                    reports the event to the core through the same callbacks as a hardware driver.
+*
+*            (2) The frame clock only advances in USBD_DrvSim_FrameRun(). The (micro)frame count of each
+*                host transfer is therefore a measure of the stack latency, independent of the speed of
+*                the machine running the simulation.
+*
+*            (3) Interrupt and isochronous endpoints are polled every (micro)frame, whatever their
+*                interval. Data toggles and device addressing are not modeled.
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#define    MICRIUM_SOURCE
+#include  "../../Source/usbd_core.h"
+#include  "usbd_drv_sim.h"
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#define  USBD_DRV_SIM_NBR_EP_PHY                          32u   /* Nbr of phy EPs (16 OUT + 16 IN).                     */
+#define  USBD_DRV_SIM_EP_QUEUE_DEPTH                       4u   /* Nbr of buf that can be queued on each EP.            */
+
+#define  USBD_DRV_SIM_SETUP_PKT_LEN                        8u
+#define  USBD_DRV_SIM_FRAME_NBR_MASK                  0x07FFu
+
+#define  USBD_DRV_SIM_FRAME_OCTET_FS                    1500u   /* 12 Mb/s during 1 ms.                                 */
+#define  USBD_DRV_SIM_FRAME_OCTET_HS                    7500u   /* 480 Mb/s during 125 us.                              */
+#define  USBD_DRV_SIM_PKT_OVERHEAD_FS                     13u   /* Protocol overhead of FS bulk transaction.            */
+#define  USBD_DRV_SIM_PKT_OVERHEAD_HS                     55u   /* Protocol overhead of HS bulk transaction.            */
+#define  USBD_DRV_SIM_UFRAME_PER_FRAME                     8u
+
+#define  USBD_DRV_SIM_ERR_RETRY_MAX_DFLT                   3u
+#define  USBD_DRV_SIM_RATE_SCALE                        1000u   /* NAK and err rates are per thousand transactions.     */
+
+                                                                /* ------------------- BUS INT FLAGS ------------------ */
+#define  USBD_DRV_SIM_INT_CONN                    DEF_BIT_00
+#define  USBD_DRV_SIM_INT_DISCONN                 DEF_BIT_01
+#define  USBD_DRV_SIM_INT_RESET                   DEF_BIT_02
+#define  USBD_DRV_SIM_INT_SUSPEND                 DEF_BIT_03
+#define  USBD_DRV_SIM_INT_RESUME                  DEF_BIT_04
+#define  USBD_DRV_SIM_INT_SETUP                   DEF_BIT_05
+
+                                                                /* --------------- HOST TRANSFER STATES --------------- */
+#define  USBD_DRV_SIM_HOST_STATE_NONE                      0u
+#define  USBD_DRV_SIM_HOST_STATE_SETUP                     1u
+#define  USBD_DRV_SIM_HOST_STATE_DATA                      2u
+#define  USBD_DRV_SIM_HOST_STATE_STATUS                    3u
+#define  USBD_DRV_SIM_HOST_STATE_CMPL                      4u
+
+                                                                /* ---------------- TRANSACTION RESULTS --------------- */
+#define  USBD_DRV_SIM_PID_NONE                             0u   /* No transaction issued.                               */
+#define  USBD_DRV_SIM_PID_ACK                              1u
+#define  USBD_DRV_SIM_PID_NAK                              2u
+#define  USBD_DRV_SIM_PID_STALL                            3u
+#define  USBD_DRV_SIM_PID_ERR                              4u   /* Corrupted or lost packet.                            */
+
+
+/*
+*********************************************************************************************************
+*                                           LOCAL CONSTANTS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL MACROS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                          LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+typedef  struct  usbd_drv_sim_buf {                             /* ----------- BUFFER QUEUED BY THE CORE -------------- */
+    CPU_INT08U   *BufPtr;                                       /* Ptr to buf.                                          */
+    CPU_INT32U    BufLen;                                       /* Len of buf.                                          */
+    CPU_INT32U    XferLen;                                      /* Nbr of octets xfer'd so far.                         */
+} USBD_DRV_SIM_BUF;
+
+
+typedef  struct  usbd_drv_sim_host_xfer {                       /* --------------- VIRTUAL HOST TRANSFER -------------- */
+    CPU_INT08U    State;                                        /* Xfer state.                                          */
+    CPU_BOOLEAN   DirIn;                                        /* Dir of current data or status stage.                 */
+    CPU_INT08U    Setup[USBD_DRV_SIM_SETUP_PKT_LEN];            /* Setup pkt of ctrl xfer.                              */
+    CPU_INT08U   *BufPtr;                                       /* Ptr to host buf.                                     */
+    CPU_INT32U    BufLen;                                       /* Len of host buf.                                     */
+    CPU_INT32U    XferLen;                                      /* Nbr of octets xfer'd so far.                         */
+    CPU_INT08U    ErrCnt;                                       /* Nbr of consecutive transaction errs.                 */
+    CPU_INT32U    FrameStart;                                   /* (Micro)frame at which xfer was submitted.            */
+    USBD_ERR      Err;                                          /* Xfer result.                                         */
+} USBD_DRV_SIM_HOST_XFER;
+
+
+typedef  struct  usbd_drv_sim_ep {                              /* ----------------- SIMULATED ENDPOINT --------------- */
+    CPU_BOOLEAN              Open;
+    CPU_INT08U               Type;
+    CPU_INT16U               MaxPktSize;
+    CPU_INT08U               TransFrame;                        /* Max nbr of transactions per (micro)frame.            */
+    CPU_INT08U               TransCnt;                          /* Nbr of transactions in current (micro)frame.         */
+    CPU_BOOLEAN              Stall;
+
+    USBD_DRV_SIM_BUF         BufTbl[USBD_DRV_SIM_EP_QUEUE_DEPTH];
+    CPU_INT08U               BufHeadIx;                         /* Ix of oldest queued buf.                             */
+    CPU_INT08U               BufNbr;                            /* Nbr of queued buf.                                   */
+    CPU_INT08U               BufCmplNbr;                        /* Nbr of OUT buf cmpl'd but not read by the core.      */
+    CPU_INT08U               IntCmplNbr;                        /* Nbr of cmpl not yet reported by the ISR.             */
+
+    CPU_INT08U               ErrInjectNbr;                      /* Nbr of transaction errs to force.                    */
+    USBD_DRV_SIM_HOST_XFER   HostXfer;                          /* Host xfer targeting this EP.                         */
+    USBD_DRV_SIM_STAT        Stat;
+} USBD_DRV_SIM_EP;
+
+
+typedef  struct  usbd_drv_sim_data {                            /* ------------------- DRIVER DATA -------------------- */
+    USBD_DRV                *DrvPtr;                            /* Ptr to drv, set when the core starts the dev.        */
+    USBD_DRV_SIM_MODEL_CFG   Cfg;                               /* Model cfg.                                           */
+    CPU_INT32U               RandState;                         /* State of NAK and err generator.                      */
+
+    CPU_BOOLEAN              PullUpEn;                          /* Dev is ready to be enumerated.                       */
+    CPU_BOOLEAN              Conn;                              /* Host is attached.                                    */
+    CPU_BOOLEAN              Suspended;
+    CPU_INT32U               FrameCnt;                          /* Nbr of (micro)frames since init.                     */
+    CPU_INT08U               RR_Ix;                             /* Round-robin start for ctrl and bulk EPs.             */
+
+    CPU_INT08U               IntStat;                           /* Pending bus int.                                     */
+    CPU_INT08U               SetupBuf[USBD_DRV_SIM_SETUP_PKT_LEN];
+
+    USBD_DRV_SIM_EP          EP_Tbl[USBD_DRV_SIM_NBR_EP_PHY];
+} USBD_DRV_SIM_DATA;
+
+
+/*
+*********************************************************************************************************
+*                                USB DEVICE ENDPOINT INFORMATION TABLE
+*********************************************************************************************************
+*/
+
+USBD_DRV_EP_INFO  USBD_DrvEP_InfoTbl_Sim[] = {
+    {USBD_EP_INFO_TYPE_CTRL                                                   | USBD_EP_INFO_DIR_OUT, 0u,   64u},
+    {USBD_EP_INFO_TYPE_CTRL                                                   | USBD_EP_INFO_DIR_IN,  0u,   64u},
+    {USBD_EP_INFO_TYPE_ISOC | USBD_EP_INFO_TYPE_BULK | USBD_EP_INFO_TYPE_INTR | USBD_EP_INFO_DIR_OUT, 1u, 1024u},
+    {USBD_EP_INFO_TYPE_ISOC | USBD_EP_INFO_TYPE_BULK | USBD_EP_INFO_TYPE_INTR | USBD_EP_INFO_DIR_IN,  1u, 1024u},
+    {USBD_EP_INFO_TYPE_ISOC | USBD_EP_INFO_TYPE_BULK | USBD_EP_INFO_TYPE_INTR | USBD_EP_INFO_DIR_OUT, 2u, 1024u},
+    {USBD_EP_INFO_TYPE_ISOC | USBD_EP_INFO_TYPE_BULK | USBD_EP_INFO_TYPE_INTR | USBD_EP_INFO_DIR_IN,  2u, 1024u},
+    {USBD_EP_INFO_TYPE_ISOC | USBD_EP_INFO_TYPE_BULK | USBD_EP_INFO_TYPE_INTR | USBD_EP_INFO_DIR_OUT, 3u, 1024u},
+    {USBD_EP_INFO_TYPE_ISOC | USBD_EP_INFO_TYPE_BULK | USBD_EP_INFO_TYPE_INTR | USBD_EP_INFO_DIR_IN,  3u, 1024u},
+    {USBD_EP_INFO_TYPE_ISOC | USBD_EP_INFO_TYPE_BULK | USBD_EP_INFO_TYPE_INTR | USBD_EP_INFO_DIR_OUT, 4u, 1024u},
+    {USBD_EP_INFO_TYPE_ISOC | USBD_EP_INFO_TYPE_BULK | USBD_EP_INFO_TYPE_INTR | USBD_EP_INFO_DIR_IN,  4u, 1024u},
+    {USBD_EP_INFO_TYPE_ISOC | USBD_EP_INFO_TYPE_BULK | USBD_EP_INFO_TYPE_INTR | USBD_EP_INFO_DIR_OUT, 5u, 1024u},
+    {USBD_EP_INFO_TYPE_ISOC | USBD_EP_INFO_TYPE_BULK | USBD_EP_INFO_TYPE_INTR | USBD_EP_INFO_DIR_IN,  5u, 1024u},
+    {DEF_BIT_NONE                                                                                 ,   0u,    0u}
+};
+
+
+/*
+*********************************************************************************************************
+*                                       LOCAL GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+static  USBD_DRV_SIM_DATA  USBD_DrvSim_DataTbl[USBD_CFG_MAX_NBR_DEV];
+
+
+/*
+*********************************************************************************************************
+*                             USB DEVICE CONTROLLER DRIVER API PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  void         USBD_DrvInit       (USBD_DRV     *p_drv,
+                                         USBD_ERR     *p_err);
+
+static  void         USBD_DrvStart      (USBD_DRV     *p_drv,
+                                         USBD_ERR     *p_err);
+
+static  void         USBD_DrvStop       (USBD_DRV     *p_drv);
+
+static  CPU_BOOLEAN  USBD_DrvAddrSet    (USBD_DRV     *p_drv,
+                                         CPU_INT08U    dev_addr);
+
+static  void         USBD_DrvAddrEn     (USBD_DRV     *p_drv,
+                                         CPU_INT08U    dev_addr);
+
+static  CPU_BOOLEAN  USBD_DrvCfgSet     (USBD_DRV     *p_drv,
+                                         CPU_INT08U    cfg_val);
+
+static  void         USBD_DrvCfgClr     (USBD_DRV     *p_drv,
+                                         CPU_INT08U    cfg_val);
+
+static  CPU_INT16U   USBD_DrvFrameNbrGet(USBD_DRV     *p_drv);
+
+static  void         USBD_DrvEP_Open    (USBD_DRV     *p_drv,
+                                         CPU_INT08U    ep_addr,
+                                         CPU_INT08U    ep_type,
+                                         CPU_INT16U    max_pkt_size,
+                                         CPU_INT08U    transaction_frame,
+                                         USBD_ERR     *p_err);
+
+static  void         USBD_DrvEP_Close   (USBD_DRV     *p_drv,
+                                         CPU_INT08U    ep_addr);
+
+static  CPU_INT32U   USBD_DrvEP_RxStart (USBD_DRV     *p_drv,
+                                         CPU_INT08U    ep_addr,
+                                         CPU_INT08U   *p_buf,
+                                         CPU_INT32U    buf_len,
+                                         USBD_ERR     *p_err);
+
+static  CPU_INT32U   USBD_DrvEP_Rx      (USBD_DRV     *p_drv,
+                                         CPU_INT08U    ep_addr,
+                                         CPU_INT08U   *p_buf,
+                                         CPU_INT32U    buf_len,
+                                         USBD_ERR     *p_err);
+
+static  void         USBD_DrvEP_RxZLP   (USBD_DRV     *p_drv,
+                                         CPU_INT08U    ep_addr,
+                                         USBD_ERR     *p_err);
+
+static  CPU_INT32U   USBD_DrvEP_Tx      (USBD_DRV     *p_drv,
+                                         CPU_INT08U    ep_addr,
+                                         CPU_INT08U   *p_buf,
+                                         CPU_INT32U    buf_len,
+                                         USBD_ERR     *p_err);
+
+static  void         USBD_DrvEP_TxStart (USBD_DRV     *p_drv,
+                                         CPU_INT08U    ep_addr,
+                                         CPU_INT08U   *p_buf,
+                                         CPU_INT32U    buf_len,
+                                         USBD_ERR     *p_err);
+
+static  void         USBD_DrvEP_TxZLP   (USBD_DRV     *p_drv,
+                                         CPU_INT08U    ep_addr,
+                                         USBD_ERR     *p_err);
+
+static  CPU_BOOLEAN  USBD_DrvEP_Abort   (USBD_DRV     *p_drv,
+                                         CPU_INT08U    ep_addr);
+
+static  CPU_BOOLEAN  USBD_DrvEP_Stall   (USBD_DRV     *p_drv,
+                                         CPU_INT08U    ep_addr,
+                                         CPU_BOOLEAN   state);
+
+static  void         USBD_DrvISR_Handler(USBD_DRV     *p_drv);
+
+static  CPU_INT08U   USBD_DrvEP_QueueDepthGet(USBD_DRV  *p_drv,
+                                              CPU_INT08U  ep_addr);
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  USBD_DRV_SIM_DATA  *USBD_DrvSim_DataGet     (CPU_INT08U               dev_nbr,
+                                                     USBD_ERR                *p_err);
+
+static  void                USBD_DrvSim_BufPush     (USBD_DRV_SIM_EP         *p_ep,
+                                                     CPU_INT08U              *p_buf,
+                                                     CPU_INT32U               buf_len,
+                                                     USBD_ERR                *p_err);
+
+static  CPU_INT32U          USBD_DrvSim_BufPop      (USBD_DRV_SIM_EP         *p_ep,
+                                                     USBD_ERR                *p_err);
+
+static  void                USBD_DrvSim_BufFlush    (USBD_DRV_SIM_EP         *p_ep);
+
+static  CPU_INT32U          USBD_DrvSim_FrameExec   (USBD_DRV_SIM_DATA       *p_data);
+
+static  CPU_INT08U          USBD_DrvSim_TransExec   (USBD_DRV_SIM_DATA       *p_data,
+                                                     CPU_INT08U               ep_phy_nbr,
+                                                     CPU_INT32U              *p_octet_rem,
+                                                     CPU_INT32U              *p_octet_xfer);
+
+static  CPU_INT08U          USBD_DrvSim_TransSetup  (USBD_DRV_SIM_DATA       *p_data,
+                                                     USBD_DRV_SIM_HOST_XFER  *p_host_xfer);
+
+static  CPU_INT08U          USBD_DrvSim_TransOut    (USBD_DRV_SIM_EP         *p_ep,
+                                                     USBD_DRV_SIM_HOST_XFER  *p_host_xfer,
+                                                     CPU_INT32U               pkt_len,
+                                                     CPU_BOOLEAN             *p_host_cmpl);
+
+static  CPU_INT08U          USBD_DrvSim_TransIn     (USBD_DRV_SIM_EP         *p_ep,
+                                                     USBD_DRV_SIM_HOST_XFER  *p_host_xfer,
+                                                     CPU_INT32U              *p_pkt_len,
+                                                     CPU_BOOLEAN             *p_host_cmpl);
+
+static  void                USBD_DrvSim_HostStageNext(USBD_DRV_SIM_DATA      *p_data,
+                                                     USBD_DRV_SIM_EP         *p_host_ep);
+
+static  void                USBD_DrvSim_HostXferEnd (USBD_DRV_SIM_DATA       *p_data,
+                                                     USBD_DRV_SIM_EP         *p_host_ep,
+                                                     USBD_ERR                 err);
+
+static  void                USBD_DrvSim_HostXferEndAll(USBD_DRV_SIM_DATA     *p_data,
+                                                     USBD_ERR                 err);
+
+static  CPU_BOOLEAN         USBD_DrvSim_RandHit     (USBD_DRV_SIM_DATA       *p_data,
+                                                     CPU_INT16U               rate);
+
+static  void                USBD_DrvSim_IntRaise    (USBD_DRV_SIM_DATA       *p_data);
+
+
+/*
+*********************************************************************************************************
+*                                     LOCAL CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+#if (USBD_DRV_SIM_EP_QUEUE_DEPTH > DEF_INT_08U_MAX_VAL)
+#error  "USBD_DRV_SIM_EP_QUEUE_DEPTH  illegally #define'd in 'usbd_drv_sim.c'  [MUST be <= 255]"
+#endif
+                                                                /* ISR is called from virtual host (see Note #1c).      */
+#if (USBD_CFG_EP_DIRECT_CMPL_EN == DEF_ENABLED)
+#error  "USBD_CFG_EP_DIRECT_CMPL_EN          illegally #define'd in 'usbd_cfg.h'      [MUST be DEF_DISABLED]"
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                  USB DEVICE CONTROLLER DRIVER API
+*********************************************************************************************************
+*/
+
+USBD_DRV_API  USBD_DrvAPI_Sim = { USBD_DrvInit,
+                                  USBD_DrvStart,
+                                  USBD_DrvStop,
+                                  USBD_DrvAddrSet,
+                                  USBD_DrvAddrEn,
+                                  USBD_DrvCfgSet,
+                                  USBD_DrvCfgClr,
+                                  USBD_DrvFrameNbrGet,
+                                  USBD_DrvEP_Open,
+                                  USBD_DrvEP_Close,
+                                  USBD_DrvEP_RxStart,
+                                  USBD_DrvEP_Rx,
+                                  USBD_DrvEP_RxZLP,
+                                  USBD_DrvEP_Tx,
+                                  USBD_DrvEP_TxStart,
+                                  USBD_DrvEP_TxZLP,
+                                  USBD_DrvEP_Abort,
+                                  USBD_DrvEP_Stall,
+                                  USBD_DrvISR_Handler,
+                                  USBD_DrvEP_QueueDepthGet,
+};
+
+
+/*
+*********************************************************************************************************
+*                                   USB DEVICE DRIVER BSP INTERFACE
+*
+* Note(s) : (1) The simulated controller has no board-specific operation. The interrupt is raised by the
+*               virtual host, which calls the driver ISR directly.
+*********************************************************************************************************
+*/
+
+USBD_DRV_BSP_API  USBD_DrvBSP_Sim = {
+    DEF_NULL,
+    DEF_NULL,
+    DEF_NULL
+};
+
+
+/*
+*********************************************************************************************************
+*********************************************************************************************************
+*                                          GLOBAL FUNCTIONS
+*********************************************************************************************************
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                      USBD_DrvSim_ModelCfgSet()
+*
+* Description : Set the parameters of the bus model.
+*
+* Argument(s) : dev_nbr     Device number.
+*
+*               p_cfg       Pointer to model configuration (see 'usbd_drv_sim.h  SIMULATION MODEL
+*                           CONFIGURATION').
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE               Model configuration successfully set.
+*                               USBD_ERR_NULL_PTR           Argument 'p_cfg' passed a NULL pointer.
+*                               USBD_ERR_DEV_INVALID_NBR    Invalid device number.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) This function may be called before the device is started. The configuration is kept
+*                   by the driver initialization.
+*********************************************************************************************************
+*/
+
+void  USBD_DrvSim_ModelCfgSet (       CPU_INT08U               dev_nbr,
+                               const  USBD_DRV_SIM_MODEL_CFG  *p_cfg,
+                                      USBD_ERR                *p_err)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    CPU_SR_ALLOC();
+
+
+#if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)
+    if (p_cfg == (const USBD_DRV_SIM_MODEL_CFG *)0) {
+       *p_err = USBD_ERR_NULL_PTR;
+        return;
+    }
+#endif
+
+    if (dev_nbr >= USBD_CFG_MAX_NBR_DEV) {
+       *p_err = USBD_ERR_DEV_INVALID_NBR;
+        return;
+    }
+
+    p_data = &USBD_DrvSim_DataTbl[dev_nbr];
+
+    CPU_CRITICAL_ENTER();
+    p_data->Cfg       = *p_cfg;
+    p_data->RandState =  p_cfg->Seed;
+    CPU_CRITICAL_EXIT();
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_DrvSim_FrameRun()
+*
+* Description : Run one frame (full-speed) or microframe (high-speed) of bus traffic.
+*
+* Argument(s) : dev_nbr     Device number.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                   Frame successfully executed.
+*                               USBD_ERR_DEV_INVALID_NBR        Invalid device number.
+*                               USBD_ERR_DEV_INVALID_STATE      Device not started.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) The driver ISR, and thus the core event callbacks, are called from this function.
+*********************************************************************************************************
+*/
+
+void  USBD_DrvSim_FrameRun (CPU_INT08U   dev_nbr,
+                            USBD_ERR    *p_err)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+
+
+    p_data = USBD_DrvSim_DataGet(dev_nbr, p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    (void)USBD_DrvSim_FrameExec(p_data);
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_DrvSim_ErrInject()
+*
+* Description : Force transaction errors on an endpoint.
+*
+* Argument(s) : dev_nbr     Device number.
+*
+*               ep_addr     Endpoint address.
+*
+*               nbr_err     Number of upcoming transactions on the endpoint that will fail.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                   Errors successfully scheduled.
+*                               USBD_ERR_EP_INVALID_ADDR        Invalid endpoint address.
+*                               USBD_ERR_DEV_INVALID_NBR        Invalid device number.
+*                               USBD_ERR_DEV_INVALID_STATE      Device not started.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Forced errors apply in addition to the random errors set by 'ErrRate'. Setting a
+*                   number of errors greater or equal to 'ErrRetryMax' halts the next host transfer.
+*********************************************************************************************************
+*/
+
+void  USBD_DrvSim_ErrInject (CPU_INT08U   dev_nbr,
+                             CPU_INT08U   ep_addr,
+                             CPU_INT08U   nbr_err,
+                             USBD_ERR    *p_err)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    CPU_INT08U          ep_phy_nbr;
+    CPU_SR_ALLOC();
+
+
+    p_data = USBD_DrvSim_DataGet(dev_nbr, p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(ep_addr);
+    if (ep_phy_nbr >= USBD_DRV_SIM_NBR_EP_PHY) {
+       *p_err = USBD_ERR_EP_INVALID_ADDR;
+        return;
+    }
+
+    CPU_CRITICAL_ENTER();
+    p_data->EP_Tbl[ep_phy_nbr].ErrInjectNbr = nbr_err;
+    CPU_CRITICAL_EXIT();
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_DrvSim_StatGet()
+*
+* Description : Get the bus statistics of an endpoint.
+*
+* Argument(s) : dev_nbr     Device number.
+*
+*               ep_addr     Endpoint address.
+*
+*               p_stat      Pointer to variable that will receive the statistics.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                   Statistics successfully copied.
+*                               USBD_ERR_NULL_PTR               Argument 'p_stat' passed a NULL pointer.
+*                               USBD_ERR_EP_INVALID_ADDR        Invalid endpoint address.
+*                               USBD_ERR_DEV_INVALID_NBR        Invalid device number.
+*                               USBD_ERR_DEV_INVALID_STATE      Device not started.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Transactions are accounted on the endpoint they target. Host transfers, including
+*                   control transfers, are accounted on the endpoint they were submitted to.
+*********************************************************************************************************
+*/
+
+void  USBD_DrvSim_StatGet (CPU_INT08U          dev_nbr,
+                           CPU_INT08U          ep_addr,
+                           USBD_DRV_SIM_STAT  *p_stat,
+                           USBD_ERR           *p_err)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    CPU_INT08U          ep_phy_nbr;
+    CPU_SR_ALLOC();
+
+
+#if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)
+    if (p_stat == (USBD_DRV_SIM_STAT *)0) {
+       *p_err = USBD_ERR_NULL_PTR;
+        return;
+    }
+#endif
+
+    p_data = USBD_DrvSim_DataGet(dev_nbr, p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(ep_addr);
+    if (ep_phy_nbr >= USBD_DRV_SIM_NBR_EP_PHY) {
+       *p_err = USBD_ERR_EP_INVALID_ADDR;
+        return;
+    }
+
+    CPU_CRITICAL_ENTER();
+   *p_stat = p_data->EP_Tbl[ep_phy_nbr].Stat;
+    CPU_CRITICAL_EXIT();
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_DrvSim_StatClr()
+*
+* Description : Clear the bus statistics of all endpoints.
+*
+* Argument(s) : dev_nbr     Device number.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                   Statistics successfully cleared.
+*                               USBD_ERR_DEV_INVALID_NBR        Invalid device number.
+*                               USBD_ERR_DEV_INVALID_STATE      Device not started.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_DrvSim_StatClr (CPU_INT08U   dev_nbr,
+                           USBD_ERR    *p_err)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    CPU_INT08U          ep_phy_nbr;
+    CPU_SR_ALLOC();
+
+
+    p_data = USBD_DrvSim_DataGet(dev_nbr, p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    CPU_CRITICAL_ENTER();
+    for (ep_phy_nbr = 0u; ep_phy_nbr < USBD_DRV_SIM_NBR_EP_PHY; ep_phy_nbr++) {
+        Mem_Clr(&p_data->EP_Tbl[ep_phy_nbr].Stat, sizeof(USBD_DRV_SIM_STAT));
+    }
+    CPU_CRITICAL_EXIT();
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_DrvSim_HostConn()
+*
+* Description : Attach the virtual host to the device.
+*
+* Argument(s) : dev_nbr     Device number.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                   Host successfully attached.
+*                               USBD_ERR_DEV_INVALID_NBR        Invalid device number.
+*                               USBD_ERR_DEV_INVALID_STATE      Device not started.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) The connect event is reported first. If the device pull-up is enabled, the host then
+*                   resets the bus, as it would after detecting the device.
+*********************************************************************************************************
+*/
+
+void  USBD_DrvSim_HostConn (CPU_INT08U   dev_nbr,
+                            USBD_ERR    *p_err)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    CPU_SR_ALLOC();
+
+
+    p_data = USBD_DrvSim_DataGet(dev_nbr, p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    CPU_CRITICAL_ENTER();
+    p_data->Conn      = DEF_YES;
+    p_data->Suspended = DEF_NO;
+    DEF_BIT_SET(p_data->IntStat, USBD_DRV_SIM_INT_CONN);
+    if (p_data->PullUpEn == DEF_YES) {                          /* See Note #1.                                         */
+        DEF_BIT_SET(p_data->IntStat, USBD_DRV_SIM_INT_RESET);
+    }
+    CPU_CRITICAL_EXIT();
+
+    USBD_DrvSim_IntRaise(p_data);
+}
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_DrvSim_HostDisconn()
+*
+* Description : Detach the virtual host from the device.
+*
+* Argument(s) : dev_nbr     Device number.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                   Host successfully detached.
+*                               USBD_ERR_DEV_INVALID_NBR        Invalid device number.
+*                               USBD_ERR_DEV_INVALID_STATE      Device not started.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Host transfers in progress end with USBD_ERR_FAIL.
+*********************************************************************************************************
+*/
+
+void  USBD_DrvSim_HostDisconn (CPU_INT08U   dev_nbr,
+                               USBD_ERR    *p_err)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    CPU_SR_ALLOC();
+
+
+    p_data = USBD_DrvSim_DataGet(dev_nbr, p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    CPU_CRITICAL_ENTER();
+    p_data->Conn = DEF_NO;
+    DEF_BIT_SET(p_data->IntStat, USBD_DRV_SIM_INT_DISCONN);
+    USBD_DrvSim_HostXferEndAll(p_data, USBD_ERR_FAIL);          /* See Note #1.                                         */
+    CPU_CRITICAL_EXIT();
+
+    USBD_DrvSim_IntRaise(p_data);
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_DrvSim_HostReset()
+*
+* Description : Reset the bus.
+*
+* Argument(s) : dev_nbr     Device number.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                   Bus successfully reset.
+*                               USBD_ERR_DEV_INVALID_NBR        Invalid device number.
+*                               USBD_ERR_DEV_INVALID_STATE      Device not started or host not attached.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Host transfers in progress end with USBD_ERR_FAIL. On a high-speed controller, the
+*                   high-speed event follows the reset event, as after a successful chirp sequence.
+*********************************************************************************************************
+*/
+
+void  USBD_DrvSim_HostReset (CPU_INT08U   dev_nbr,
+                             USBD_ERR    *p_err)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    CPU_SR_ALLOC();
+
+
+    p_data = USBD_DrvSim_DataGet(dev_nbr, p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    CPU_CRITICAL_ENTER();
+    if (p_data->Conn == DEF_NO) {
+        CPU_CRITICAL_EXIT();
+       *p_err = USBD_ERR_DEV_INVALID_STATE;
+        return;
+    }
+
+    p_data->Suspended = DEF_NO;
+    DEF_BIT_SET(p_data->IntStat, USBD_DRV_SIM_INT_RESET);
+    USBD_DrvSim_HostXferEndAll(p_data, USBD_ERR_FAIL);          /* See Note #1.                                         */
+    CPU_CRITICAL_EXIT();
+
+    USBD_DrvSim_IntRaise(p_data);
+}
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_DrvSim_HostSuspend()
+*
+* Description : Suspend the bus.
+*
+* Argument(s) : dev_nbr     Device number.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                   Bus successfully suspended.
+*                               USBD_ERR_DEV_INVALID_NBR        Invalid device number.
+*                               USBD_ERR_DEV_INVALID_STATE      Device not started or host not attached.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) No token is issued while the bus is suspended. The frame clock keeps running.
+*********************************************************************************************************
+*/
+
+void  USBD_DrvSim_HostSuspend (CPU_INT08U   dev_nbr,
+                               USBD_ERR    *p_err)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    CPU_SR_ALLOC();
+
+
+    p_data = USBD_DrvSim_DataGet(dev_nbr, p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    CPU_CRITICAL_ENTER();
+    if (p_data->Conn == DEF_NO) {
+        CPU_CRITICAL_EXIT();
+       *p_err = USBD_ERR_DEV_INVALID_STATE;
+        return;
+    }
+
+    p_data->Suspended = DEF_YES;
+    DEF_BIT_SET(p_data->IntStat, USBD_DRV_SIM_INT_SUSPEND);
+    CPU_CRITICAL_EXIT();
+
+    USBD_DrvSim_IntRaise(p_data);
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_DrvSim_HostResume()
+*
+* Description : Resume the bus.
+*
+* Argument(s) : dev_nbr     Device number.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                   Bus successfully resumed.
+*                               USBD_ERR_DEV_INVALID_NBR        Invalid device number.
+*                               USBD_ERR_DEV_INVALID_STATE      Device not started or host not attached.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_DrvSim_HostResume (CPU_INT08U   dev_nbr,
+                              USBD_ERR    *p_err)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    CPU_SR_ALLOC();
+
+
+    p_data = USBD_DrvSim_DataGet(dev_nbr, p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    CPU_CRITICAL_ENTER();
+    if (p_data->Conn == DEF_NO) {
+        CPU_CRITICAL_EXIT();
+       *p_err = USBD_ERR_DEV_INVALID_STATE;
+        return;
+    }
+
+    p_data->Suspended = DEF_NO;
+    DEF_BIT_SET(p_data->IntStat, USBD_DRV_SIM_INT_RESUME);
+    CPU_CRITICAL_EXIT();
+
+    USBD_DrvSim_IntRaise(p_data);
+}
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_DrvSim_HostCtrlSubmit()
+*
+* Description : Submit a control transfer on the default endpoint.
+*
+* Argument(s) : dev_nbr     Device number.
+*
+*               p_setup     Pointer to the 8-octet setup packet.
+*
+*               p_buf       Pointer to data stage buffer. Its length is given by the 'wLength' field of the
+*                           setup packet. May be NULL if 'wLength' is zero.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                   Transfer successfully submitted.
+*                               USBD_ERR_NULL_PTR               Argument 'p_setup'/'p_buf' passed a NULL pointer.
+*                               USBD_ERR_EP_IO_PENDING          Control transfer already in progress.
+*                               USBD_ERR_DEV_INVALID_NBR        Invalid device number.
+*                               USBD_ERR_DEV_INVALID_STATE      Device not started.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) The transfer goes through the setup, data and status stages. Its completion is
+*                   reported by USBD_DrvSim_HostXferIsCmpl() or USBD_DrvSim_HostXferWait() on endpoint
+*                   address 0x00 or 0x80.
+*********************************************************************************************************
+*/
+
+void  USBD_DrvSim_HostCtrlSubmit (       CPU_INT08U   dev_nbr,
+                                  const  CPU_INT08U  *p_setup,
+                                         void        *p_buf,
+                                         USBD_ERR    *p_err)
+{
+    USBD_DRV_SIM_DATA       *p_data;
+    USBD_DRV_SIM_HOST_XFER  *p_host_xfer;
+    CPU_INT16U               len;
+    CPU_SR_ALLOC();
+
+
+#if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)
+    if (p_setup == (const CPU_INT08U *)0) {
+       *p_err = USBD_ERR_NULL_PTR;
+        return;
+    }
+#endif
+
+    len = MEM_VAL_GET_INT16U_LITTLE(&p_setup[6u]);
+    if ((len   != 0u) &&
+        (p_buf == (void *)0)) {
+       *p_err = USBD_ERR_NULL_PTR;
+        return;
+    }
+
+    p_data = USBD_DrvSim_DataGet(dev_nbr, p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    p_host_xfer = &p_data->EP_Tbl[0u].HostXfer;
+
+    CPU_CRITICAL_ENTER();
+    if ((p_host_xfer->State != USBD_DRV_SIM_HOST_STATE_NONE) &&
+        (p_host_xfer->State != USBD_DRV_SIM_HOST_STATE_CMPL)) {
+        CPU_CRITICAL_EXIT();
+       *p_err = USBD_ERR_EP_IO_PENDING;
+        return;
+    }
+
+    Mem_Copy(p_host_xfer->Setup, p_setup, USBD_DRV_SIM_SETUP_PKT_LEN);
+    p_host_xfer->BufPtr     = (CPU_INT08U *)p_buf;
+    p_host_xfer->BufLen     =  len;
+    p_host_xfer->XferLen    =  0u;
+    p_host_xfer->ErrCnt     =  0u;
+    p_host_xfer->DirIn      =  DEF_NO;
+    p_host_xfer->FrameStart =  p_data->FrameCnt;
+    p_host_xfer->Err        =  USBD_ERR_NONE;
+    p_host_xfer->State      =  USBD_DRV_SIM_HOST_STATE_SETUP;
+    CPU_CRITICAL_EXIT();
+}
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_DrvSim_HostXferSubmit()
+*
+* Description : Submit a bulk, interrupt or isochronous transfer.
+*
+* Argument(s) : dev_nbr     Device number.
+*
+*               ep_addr     Endpoint address. The direction bit gives the direction of the transfer.
+*
+*               p_buf       Pointer to host buffer.
+*
+*               buf_len     Length of host buffer. A zero-length OUT transfer sends a zero-length packet.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                   Transfer successfully submitted.
+*                               USBD_ERR_NULL_PTR               Argument 'p_buf' passed a NULL pointer.
+*                               USBD_ERR_EP_INVALID_ADDR        Invalid endpoint address.
+*                               USBD_ERR_EP_IO_PENDING          Transfer already in progress on endpoint.
+*                               USBD_ERR_DEV_INVALID_NBR        Invalid device number.
+*                               USBD_ERR_DEV_INVALID_STATE      Device not started.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) As on a real host, an OUT transfer whose length is a multiple of the maximum packet
+*                   size is NOT followed by a zero-length packet. An IN transfer ends on a short packet,
+*                   or when the host buffer is full.
+*********************************************************************************************************
+*/
+
+void  USBD_DrvSim_HostXferSubmit (CPU_INT08U   dev_nbr,
+                                  CPU_INT08U   ep_addr,
+                                  void        *p_buf,
+                                  CPU_INT32U   buf_len,
+                                  USBD_ERR    *p_err)
+{
+    USBD_DRV_SIM_DATA       *p_data;
+    USBD_DRV_SIM_HOST_XFER  *p_host_xfer;
+    CPU_INT08U               ep_phy_nbr;
+    CPU_SR_ALLOC();
+
+
+#if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)
+    if ((buf_len != 0u) &&
+        (p_buf   == (void *)0)) {
+       *p_err = USBD_ERR_NULL_PTR;
+        return;
+    }
+#endif
+
+    p_data = USBD_DrvSim_DataGet(dev_nbr, p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(ep_addr);
+    if ((USBD_EP_ADDR_TO_LOG(ep_addr) == 0u) ||                 /* Ctrl xfers are submitted with setup pkt.             */
+        (ep_phy_nbr                   >= USBD_DRV_SIM_NBR_EP_PHY)) {
+       *p_err = USBD_ERR_EP_INVALID_ADDR;
+        return;
+    }
+
+    p_host_xfer = &p_data->EP_Tbl[ep_phy_nbr].HostXfer;
+
+    CPU_CRITICAL_ENTER();
+    if ((p_host_xfer->State != USBD_DRV_SIM_HOST_STATE_NONE) &&
+        (p_host_xfer->State != USBD_DRV_SIM_HOST_STATE_CMPL)) {
+        CPU_CRITICAL_EXIT();
+       *p_err = USBD_ERR_EP_IO_PENDING;
+        return;
+    }
+
+    p_host_xfer->BufPtr     = (CPU_INT08U *)p_buf;
+    p_host_xfer->BufLen     =  buf_len;
+    p_host_xfer->XferLen    =  0u;
+    p_host_xfer->ErrCnt     =  0u;
+    p_host_xfer->DirIn      =  USBD_EP_IS_IN(ep_addr);
+    p_host_xfer->FrameStart =  p_data->FrameCnt;
+    p_host_xfer->Err        =  USBD_ERR_NONE;
+    p_host_xfer->State      =  USBD_DRV_SIM_HOST_STATE_DATA;
+    CPU_CRITICAL_EXIT();
+}
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_DrvSim_HostXferIsCmpl()
+*
+* Description : Check whether the host transfer submitted on an endpoint has completed.
+*
+* Argument(s) : dev_nbr     Device number.
+*
+*               ep_addr     Endpoint address. Address 0x00 or 0x80 designates the control transfer.
+*
+*               p_xfer_len  Pointer to variable that will receive the number of octets transferred in the
+*                           data stage. May be NULL.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                   Transfer completed successfully, or in
+*                                                                   progress.
+*                               USBD_ERR_EP_STALL               Transfer ended on a STALL handshake.
+*                               USBD_ERR_DRV_BUF_OVERFLOW       Device sent more data than the host buffer.
+*                               USBD_ERR_FAIL                   Transfer halted by transaction errors, bus
+*                                                                   reset or disconnection.
+*                               USBD_ERR_EP_INVALID_ADDR        Invalid endpoint address.
+*                               USBD_ERR_EP_INVALID_STATE       No transfer submitted on endpoint.
+*                               USBD_ERR_DEV_INVALID_NBR        Invalid device number.
+*                               USBD_ERR_DEV_INVALID_STATE      Device not started.
+*
+* Return(s)   : DEF_YES, if the transfer has completed.
+*
+*               DEF_NO,  otherwise.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+CPU_BOOLEAN  USBD_DrvSim_HostXferIsCmpl (CPU_INT08U   dev_nbr,
+                                         CPU_INT08U   ep_addr,
+                                         CPU_INT32U  *p_xfer_len,
+                                         USBD_ERR    *p_err)
+{
+    USBD_DRV_SIM_DATA       *p_data;
+    USBD_DRV_SIM_HOST_XFER  *p_host_xfer;
+    CPU_INT08U               ep_phy_nbr;
+    CPU_BOOLEAN              cmpl;
+    CPU_SR_ALLOC();
+
+
+    if (p_xfer_len != (CPU_INT32U *)0) {
+       *p_xfer_len = 0u;
+    }
+
+    p_data = USBD_DrvSim_DataGet(dev_nbr, p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return (DEF_NO);
+    }
+
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(ep_addr);
+    if (USBD_EP_ADDR_TO_LOG(ep_addr) == 0u) {
+        ep_phy_nbr = 0u;                                        /* Ctrl xfer is kept on EP 0x00.                        */
+    }
+    if (ep_phy_nbr >= USBD_DRV_SIM_NBR_EP_PHY) {
+       *p_err = USBD_ERR_EP_INVALID_ADDR;
+        return (DEF_NO);
+    }
+
+    p_host_xfer = &p_data->EP_Tbl[ep_phy_nbr].HostXfer;
+    cmpl        =  DEF_NO;
+
+    CPU_CRITICAL_ENTER();
+    switch (p_host_xfer->State) {
+        case USBD_DRV_SIM_HOST_STATE_NONE:
+            *p_err = USBD_ERR_EP_INVALID_STATE;
+             break;
+
+        case USBD_DRV_SIM_HOST_STATE_CMPL:
+             if (p_xfer_len != (CPU_INT32U *)0) {
+                *p_xfer_len = p_host_xfer->XferLen;
+             }
+            *p_err = p_host_xfer->Err;
+             cmpl  = DEF_YES;
+             break;
+
+        default:
+             break;
+    }
+    CPU_CRITICAL_EXIT();
+
+    return (cmpl);
+}
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_DrvSim_HostXferWait()
+*
+* Description : Run frames until the host transfer submitted on an endpoint completes.
+*
+* Argument(s) : dev_nbr         Device number.
+*
+*               ep_addr         Endpoint address. Address 0x00 or 0x80 designates the control transfer.
+*
+*               timeout_frame   Maximum number of (micro)frames to run. Zero means no limit.
+*
+*               p_err           Pointer to variable that will receive the return error code from this function :
+*
+*                                   USBD_ERR_NONE               Transfer completed successfully.
+*                                   USBD_ERR_OS_TIMEOUT         Transfer did not complete in time. It is
+*                                                                   aborted.
+*
+*                                   - RETURNED BY USBD_DrvSim_HostXferIsCmpl() -
+*                                   See USBD_DrvSim_HostXferIsCmpl() for additional return error codes.
+*
+* Return(s)   : Number of octets transferred in the data stage.
+*
+* Note(s)     : (1) When the model does not run in real time, the caller sleeps one millisecond after
+*                   each frame that carried no data, so that the stack tasks can queue buffers. Frames
+*                   keep being counted (see 'usbd_drv_sim.c  Note #2').
+*********************************************************************************************************
+*/
+
+CPU_INT32U  USBD_DrvSim_HostXferWait (CPU_INT08U   dev_nbr,
+                                      CPU_INT08U   ep_addr,
+                                      CPU_INT32U   timeout_frame,
+                                      USBD_ERR    *p_err)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    CPU_INT32U          xfer_len;
+    CPU_INT32U          frame_cnt;
+    CPU_INT32U          octet_xfer;
+    CPU_BOOLEAN         cmpl;
+    USBD_ERR            err;
+
+
+    frame_cnt = 0u;
+    cmpl      = USBD_DrvSim_HostXferIsCmpl(dev_nbr, ep_addr, &xfer_len, p_err);
+
+    while ((cmpl   == DEF_NO) &&
+           (*p_err == USBD_ERR_NONE)) {
+
+        if ((timeout_frame != 0u) &&
+            (frame_cnt     >= timeout_frame)) {
+            USBD_DrvSim_HostXferAbort(dev_nbr, ep_addr, &err);
+           *p_err = USBD_ERR_OS_TIMEOUT;
+            return (0u);
+        }
+
+        p_data     = &USBD_DrvSim_DataTbl[dev_nbr];             /* Dev nbr validated by USBD_DrvSim_HostXferIsCmpl().   */
+        octet_xfer =  USBD_DrvSim_FrameExec(p_data);
+        frame_cnt++;
+
+        if ((octet_xfer             == 0u) &&                   /* See Note #1.                                         */
+            (p_data->Cfg.RealTimeEn == DEF_DISABLED)) {
+            USBD_OS_DlyMs(1u);
+        }
+
+        cmpl = USBD_DrvSim_HostXferIsCmpl(dev_nbr, ep_addr, &xfer_len, p_err);
+    }
+
+    return (xfer_len);
+}
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_DrvSim_HostXferAbort()
+*
+* Description : Abort the host transfer submitted on an endpoint.
+*
+* Argument(s) : dev_nbr     Device number.
+*
+*               ep_addr     Endpoint address. Address 0x00 or 0x80 designates the control transfer.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                   Transfer successfully aborted.
+*                               USBD_ERR_EP_INVALID_ADDR        Invalid endpoint address.
+*                               USBD_ERR_DEV_INVALID_NBR        Invalid device number.
+*                               USBD_ERR_DEV_INVALID_STATE      Device not started.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Buffers already queued on the device side are left untouched.
+*********************************************************************************************************
+*/
+
+void  USBD_DrvSim_HostXferAbort (CPU_INT08U   dev_nbr,
+                                 CPU_INT08U   ep_addr,
+                                 USBD_ERR    *p_err)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    CPU_INT08U          ep_phy_nbr;
+    CPU_SR_ALLOC();
+
+
+    p_data = USBD_DrvSim_DataGet(dev_nbr, p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(ep_addr);
+    if (USBD_EP_ADDR_TO_LOG(ep_addr) == 0u) {
+        ep_phy_nbr = 0u;
+    }
+    if (ep_phy_nbr >= USBD_DRV_SIM_NBR_EP_PHY) {
+       *p_err = USBD_ERR_EP_INVALID_ADDR;
+        return;
+    }
+
+    CPU_CRITICAL_ENTER();
+    p_data->EP_Tbl[ep_phy_nbr].HostXfer.State = USBD_DRV_SIM_HOST_STATE_NONE;
+    CPU_CRITICAL_EXIT();
+}
+
+
+/*
+*********************************************************************************************************
+*********************************************************************************************************
+*                                     DRIVER INTERFACE FUNCTIONS
+*********************************************************************************************************
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                           USBD_DrvInit()
+*
+* Description : Initialize the device.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE               Device successfully initialized.
+*                               USBD_ERR_DEV_INVALID_NBR    Invalid device number.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) The model configuration set by USBD_DrvSim_ModelCfgSet() is preserved.
+*********************************************************************************************************
+*/
+
+static  void  USBD_DrvInit (USBD_DRV  *p_drv,
+                            USBD_ERR  *p_err)
+{
+    USBD_DRV_SIM_DATA       *p_data;
+    USBD_DRV_SIM_MODEL_CFG   cfg;
+    CPU_SR_ALLOC();
+
+
+    if (p_drv->DevNbr >= USBD_CFG_MAX_NBR_DEV) {
+       *p_err = USBD_ERR_DEV_INVALID_NBR;
+        return;
+    }
+
+    p_data = &USBD_DrvSim_DataTbl[p_drv->DevNbr];
+
+    CPU_CRITICAL_ENTER();
+    cfg = p_data->Cfg;                                          /* See Note #1.                                         */
+    Mem_Clr(p_data, sizeof(USBD_DRV_SIM_DATA));
+    p_data->Cfg       = cfg;
+    p_data->RandState = cfg.Seed;
+    p_data->DrvPtr    = p_drv;
+    CPU_CRITICAL_EXIT();
+
+    p_drv->DataPtr = p_data;                                    /* Store drv internal data ptr.                         */
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                           USBD_DrvStart()
+*
+* Description : Start device operation.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE    Device successfully connected.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Enabling the pull-up while the host is attached makes the host reset the bus. The reset
+*                   event is reported on the next frame.
+*********************************************************************************************************
+*/
+
+static  void  USBD_DrvStart (USBD_DRV  *p_drv,
+                             USBD_ERR  *p_err)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    CPU_SR_ALLOC();
+
+
+    p_data = (USBD_DRV_SIM_DATA *)p_drv->DataPtr;
+
+    CPU_CRITICAL_ENTER();
+    p_data->PullUpEn = DEF_YES;
+    if (p_data->Conn == DEF_YES) {                              /* See Note #1.                                         */
+        DEF_BIT_SET(p_data->IntStat, USBD_DRV_SIM_INT_RESET);
+    }
+    CPU_CRITICAL_EXIT();
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                           USBD_DrvStop()
+*
+* Description : Stop device operation.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Host transfers in progress end with USBD_ERR_FAIL, as the device disappears from the
+*                   bus.
+*********************************************************************************************************
+*/
+
+static  void  USBD_DrvStop (USBD_DRV  *p_drv)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    CPU_SR_ALLOC();
+
+
+    p_data = (USBD_DRV_SIM_DATA *)p_drv->DataPtr;
+
+    CPU_CRITICAL_ENTER();
+    p_data->PullUpEn = DEF_NO;
+    p_data->IntStat  = DEF_BIT_NONE;
+    USBD_DrvSim_HostXferEndAll(p_data, USBD_ERR_FAIL);          /* See Note #1.                                         */
+    CPU_CRITICAL_EXIT();
+}
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_DrvAddrSet()
+*
+* Description : Assign an address to device.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+*               dev_addr    Device address assigned by the host.
+*
+* Return(s)   : DEF_OK.
+*
+* Note(s)     : (1) Device addressing is not modeled (see 'usbd_drv_sim.c  Note #3').
+*********************************************************************************************************
+*/
+
+static  CPU_BOOLEAN  USBD_DrvAddrSet (USBD_DRV    *p_drv,
+                                      CPU_INT08U   dev_addr)
+{
+    (void)p_drv;
+    (void)dev_addr;
+
+    return (DEF_OK);
+}
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_DrvAddrEn()
+*
+* Description : Enable address on device.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+*               dev_addr    Device address assigned by the host.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Device addressing is not modeled (see 'usbd_drv_sim.c  Note #3').
+*********************************************************************************************************
+*/
+
+static  void  USBD_DrvAddrEn (USBD_DRV    *p_drv,
+                              CPU_INT08U   dev_addr)
+{
+    (void)p_drv;
+    (void)dev_addr;
+}
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_DrvCfgSet()
+*
+* Description : Bring device into configured state.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+*               cfg_val     Configuration value.
+*
+* Return(s)   : DEF_OK.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  CPU_BOOLEAN  USBD_DrvCfgSet (USBD_DRV    *p_drv,
+                                     CPU_INT08U   cfg_val)
+{
+    (void)p_drv;
+    (void)cfg_val;
+
+    return (DEF_OK);
+}
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_DrvCfgClr()
+*
+* Description : Bring device into de-configured state.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+*               cfg_val     Configuration value.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  void  USBD_DrvCfgClr (USBD_DRV    *p_drv,
+                              CPU_INT08U   cfg_val)
+{
+    (void)p_drv;
+    (void)cfg_val;
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_DrvFrameNbrGet()
+*
+* Description : Retrieve current frame number.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+* Return(s)   : Frame number.
+*
+* Note(s)     : (1) At high-speed, eight microframes make one frame.
+*********************************************************************************************************
+*/
+
+static  CPU_INT16U  USBD_DrvFrameNbrGet (USBD_DRV  *p_drv)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    CPU_INT32U          frame_cnt;
+
+
+    p_data    = (USBD_DRV_SIM_DATA *)p_drv->DataPtr;
+    frame_cnt =  p_data->FrameCnt;
+
+    if (p_drv->CfgPtr->Spd == USBD_DEV_SPD_HIGH) {              /* See Note #1.                                         */
+        frame_cnt /= USBD_DRV_SIM_UFRAME_PER_FRAME;
+    }
+
+    return ((CPU_INT16U)(frame_cnt & USBD_DRV_SIM_FRAME_NBR_MASK));
+}
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_DrvEP_Open()
+*
+* Description : Open and configure a device endpoint, given its characteristics (e.g., endpoint type,
+*               endpoint address, maximum packet size, etc).
+*
+* Argument(s) : p_drv               Pointer to device driver structure.
+*
+*               ep_addr             Endpoint address.
+*
+*               ep_type             Endpoint type :
+*
+*                                       USBD_EP_TYPE_CTRL,
+*                                       USBD_EP_TYPE_ISOC,
+*                                       USBD_EP_TYPE_BULK,
+*                                       USBD_EP_TYPE_INTR.
+*
+*               max_pkt_size        Maximum packet size.
+*
+*               transaction_frame   Endpoint transactions per frame.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE               Endpoint successfully opened.
+*                               USBD_ERR_EP_INVALID_ADDR    Invalid endpoint address.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  void  USBD_DrvEP_Open (USBD_DRV    *p_drv,
+                               CPU_INT08U   ep_addr,
+                               CPU_INT08U   ep_type,
+                               CPU_INT16U   max_pkt_size,
+                               CPU_INT08U   transaction_frame,
+                               USBD_ERR    *p_err)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    USBD_DRV_SIM_EP    *p_ep;
+    CPU_INT08U          ep_phy_nbr;
+    CPU_SR_ALLOC();
+
+
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(ep_addr);
+    if (ep_phy_nbr >= USBD_DRV_SIM_NBR_EP_PHY) {
+       *p_err = USBD_ERR_EP_INVALID_ADDR;
+        return;
+    }
+
+    p_data = (USBD_DRV_SIM_DATA *)p_drv->DataPtr;
+    p_ep   = &p_data->EP_Tbl[ep_phy_nbr];
+
+    CPU_CRITICAL_ENTER();
+    USBD_DrvSim_BufFlush(p_ep);
+    p_ep->Type       =  ep_type;
+    p_ep->MaxPktSize =  max_pkt_size;
+    p_ep->TransFrame = (transaction_frame != 0u) ? transaction_frame : 1u;
+    p_ep->Stall      =  DEF_NO;
+    p_ep->Open       =  DEF_YES;
+    CPU_CRITICAL_EXIT();
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_DrvEP_Close()
+*
+* Description : Close a device endpoint, and uninitialize/clear endpoint configuration in hardware.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+*               ep_addr     Endpoint address.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  void  USBD_DrvEP_Close (USBD_DRV    *p_drv,
+                                CPU_INT08U   ep_addr)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    USBD_DRV_SIM_EP    *p_ep;
+    CPU_INT08U          ep_phy_nbr;
+    CPU_SR_ALLOC();
+
+
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(ep_addr);
+    if (ep_phy_nbr >= USBD_DRV_SIM_NBR_EP_PHY) {
+        return;
+    }
+
+    p_data = (USBD_DRV_SIM_DATA *)p_drv->DataPtr;
+    p_ep   = &p_data->EP_Tbl[ep_phy_nbr];
+
+    CPU_CRITICAL_ENTER();
+    p_ep->Open = DEF_NO;
+    USBD_DrvSim_BufFlush(p_ep);
+    CPU_CRITICAL_EXIT();
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_DrvEP_RxStart()
+*
+* Description : Configure endpoint with buffer to receive data.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+*               ep_addr     Endpoint address.
+*
+*               p_buf       Pointer to data buffer.
+*
+*               buf_len     Length of the buffer.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE               Receive successfully configured.
+*                               USBD_ERR_EP_INVALID_ADDR    Invalid endpoint address.
+*                               USBD_ERR_EP_QUEUING         Endpoint queue is full.
+*
+* Return(s)   : Maximum number of octets that will be received, if NO error(s).
+*
+*               0,                                              otherwise.
+*
+* Note(s)     : (1) The length is limited by the model 'XferLenMax' parameter.
+*********************************************************************************************************
+*/
+
+static  CPU_INT32U  USBD_DrvEP_RxStart (USBD_DRV    *p_drv,
+                                        CPU_INT08U   ep_addr,
+                                        CPU_INT08U  *p_buf,
+                                        CPU_INT32U   buf_len,
+                                        USBD_ERR    *p_err)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    CPU_INT08U          ep_phy_nbr;
+    CPU_INT32U          xfer_len_max;
+    CPU_SR_ALLOC();
+
+
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(ep_addr);
+    if (ep_phy_nbr >= USBD_DRV_SIM_NBR_EP_PHY) {
+       *p_err = USBD_ERR_EP_INVALID_ADDR;
+        return (0u);
+    }
+
+    p_data       = (USBD_DRV_SIM_DATA *)p_drv->DataPtr;
+    xfer_len_max =  p_data->Cfg.XferLenMax;
+    if ((xfer_len_max != 0u) &&                                 /* See Note #1.                                         */
+        (buf_len      >  xfer_len_max)) {
+        buf_len = xfer_len_max;
+    }
+
+    CPU_CRITICAL_ENTER();
+    USBD_DrvSim_BufPush(&p_data->EP_Tbl[ep_phy_nbr], p_buf, buf_len, p_err);
+    CPU_CRITICAL_EXIT();
+
+    if (*p_err != USBD_ERR_NONE) {
+        return (0u);
+    }
+
+    return (buf_len);
+}
+
+
+/*
+*********************************************************************************************************
+*                                           USBD_DrvEP_Rx()
+*
+* Description : Receive the specified amount of data from device endpoint.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+*               ep_addr     Endpoint address.
+*
+*               p_buf       Pointer to data buffer.
+*
+*               buf_len     Length of the buffer.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE               Data successfully received.
+*                               USBD_ERR_RX                 No completed receive on endpoint.
+*                               USBD_ERR_DRV_BUF_OVERFLOW   Host sent more data than the buffer length.
+*                               USBD_ERR_EP_INVALID_ADDR    Invalid endpoint address.
+*
+* Return(s)   : Number of octets received, if NO error(s).
+*
+*               0,                         otherwise.
+*
+* Note(s)     : (1) The data was copied into the buffer given to USBD_DrvEP_RxStart() when it was received.
+*                   The oldest completed buffer is released.
+*********************************************************************************************************
+*/
+
+static  CPU_INT32U  USBD_DrvEP_Rx (USBD_DRV    *p_drv,
+                                   CPU_INT08U   ep_addr,
+                                   CPU_INT08U  *p_buf,
+                                   CPU_INT32U   buf_len,
+                                   USBD_ERR    *p_err)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    CPU_INT08U          ep_phy_nbr;
+    CPU_INT32U          xfer_len;
+    CPU_SR_ALLOC();
+
+
+    (void)p_buf;
+
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(ep_addr);
+    if (ep_phy_nbr >= USBD_DRV_SIM_NBR_EP_PHY) {
+       *p_err = USBD_ERR_EP_INVALID_ADDR;
+        return (0u);
+    }
+
+    p_data = (USBD_DRV_SIM_DATA *)p_drv->DataPtr;
+
+    CPU_CRITICAL_ENTER();
+    xfer_len = USBD_DrvSim_BufPop(&p_data->EP_Tbl[ep_phy_nbr], p_err);
+    CPU_CRITICAL_EXIT();
+
+    if ((*p_err   == USBD_ERR_NONE) &&
+        ( xfer_len > buf_len)) {
+       *p_err    = USBD_ERR_DRV_BUF_OVERFLOW;
+        xfer_len = buf_len;
+    }
+
+    return (xfer_len);
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_DrvEP_RxZLP()
+*
+* Description : Receive zero-length packet from endpoint.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+*               ep_addr     Endpoint address.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE               Zero-length packet successfully received.
+*                               USBD_ERR_RX                 No completed receive on endpoint.
+*                               USBD_ERR_DRV_BUF_OVERFLOW   Host sent data instead of a zero-length packet.
+*                               USBD_ERR_EP_INVALID_ADDR    Invalid endpoint address.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  void  USBD_DrvEP_RxZLP (USBD_DRV    *p_drv,
+                                CPU_INT08U   ep_addr,
+                                USBD_ERR    *p_err)
+{
+    (void)USBD_DrvEP_Rx(p_drv,
+                        ep_addr,
+           (CPU_INT08U *)0,
+                        0u,
+                        p_err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                           USBD_DrvEP_Tx()
+*
+* Description : Configure endpoint with buffer to transmit data.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+*               ep_addr     Endpoint address.
+*
+*               p_buf       Pointer to buffer of data that will be transmitted.
+*
+*               buf_len     Number of octets to transmit.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE   Transmit successfully configured.
+*
+* Return(s)   : Number of octets transmitted, if NO error(s).
+*
+*               0,                            otherwise.
+*
+* Note(s)     : (1) The length is limited by the model 'XferLenMax' parameter.
+*********************************************************************************************************
+*/
+
+static  CPU_INT32U  USBD_DrvEP_Tx (USBD_DRV    *p_drv,
+                                   CPU_INT08U   ep_addr,
+                                   CPU_INT08U  *p_buf,
+                                   CPU_INT32U   buf_len,
+                                   USBD_ERR    *p_err)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    CPU_INT32U          xfer_len_max;
+
+
+    (void)ep_addr;
+    (void)p_buf;
+
+    p_data       = (USBD_DRV_SIM_DATA *)p_drv->DataPtr;
+    xfer_len_max =  p_data->Cfg.XferLenMax;
+    if ((xfer_len_max != 0u) &&                                 /* See Note #1.                                         */
+        (buf_len      >  xfer_len_max)) {
+        buf_len = xfer_len_max;
+    }
+
+   *p_err = USBD_ERR_NONE;
+
+    return (buf_len);
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_DrvEP_TxStart()
+*
+* Description : Transmit the specified amount of data to device endpoint.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+*               ep_addr     Endpoint address.
+*
+*               p_buf       Pointer to buffer of data that will be transmitted.
+*
+*               buf_len     Number of octets to transmit.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE               Data successfully queued.
+*                               USBD_ERR_EP_INVALID_ADDR    Invalid endpoint address.
+*                               USBD_ERR_EP_QUEUING         Endpoint queue is full.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) The buffer is read by the virtual host, one packet per IN token. It must remain valid
+*                   until the transmit completion is reported.
+*********************************************************************************************************
+*/
+
+static  void  USBD_DrvEP_TxStart (USBD_DRV    *p_drv,
+                                  CPU_INT08U   ep_addr,
+                                  CPU_INT08U  *p_buf,
+                                  CPU_INT32U   buf_len,
+                                  USBD_ERR    *p_err)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    CPU_INT08U          ep_phy_nbr;
+    CPU_SR_ALLOC();
+
+
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(ep_addr);
+    if (ep_phy_nbr >= USBD_DRV_SIM_NBR_EP_PHY) {
+       *p_err = USBD_ERR_EP_INVALID_ADDR;
+        return;
+    }
+
+    p_data = (USBD_DRV_SIM_DATA *)p_drv->DataPtr;
+
+    CPU_CRITICAL_ENTER();
+    USBD_DrvSim_BufPush(&p_data->EP_Tbl[ep_phy_nbr], p_buf, buf_len, p_err);
+    CPU_CRITICAL_EXIT();
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_DrvEP_TxZLP()
+*
+* Description : Transmit zero-length packet from endpoint.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+*               ep_addr     Endpoint address.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE               Zero-length packet successfully queued.
+*                               USBD_ERR_EP_INVALID_ADDR    Invalid endpoint address.
+*                               USBD_ERR_EP_QUEUING         Endpoint queue is full.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  void  USBD_DrvEP_TxZLP (USBD_DRV    *p_drv,
+                                CPU_INT08U   ep_addr,
+                                USBD_ERR    *p_err)
+{
+    USBD_DrvEP_TxStart(p_drv,
+                       ep_addr,
+          (CPU_INT08U *)0,
+                       0u,
+                       p_err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_DrvEP_Abort()
+*
+* Description : Abort any pending transfer on endpoint.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+*               ep_addr     Endpoint Address.
+*
+* Return(s)   : DEF_OK,   if NO error(s).
+*
+*               DEF_FAIL, otherwise.
+*
+* Note(s)     : (1) Completions not yet reported by the ISR are discarded with the buffers.
+*********************************************************************************************************
+*/
+
+static  CPU_BOOLEAN  USBD_DrvEP_Abort (USBD_DRV    *p_drv,
+                                       CPU_INT08U   ep_addr)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    CPU_INT08U          ep_phy_nbr;
+    CPU_SR_ALLOC();
+
+
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(ep_addr);
+    if (ep_phy_nbr >= USBD_DRV_SIM_NBR_EP_PHY) {
+        return (DEF_FAIL);
+    }
+
+    p_data = (USBD_DRV_SIM_DATA *)p_drv->DataPtr;
+
+    CPU_CRITICAL_ENTER();
+    USBD_DrvSim_BufFlush(&p_data->EP_Tbl[ep_phy_nbr]);          /* See Note #1.                                         */
+    CPU_CRITICAL_EXIT();
+
+    return (DEF_OK);
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_DrvEP_Stall()
+*
+* Description : Set or clear stall condition on endpoint.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+*               ep_addr     Endpoint address.
+*
+*               state       Endpoint stall state.
+*
+* Return(s)   : DEF_OK,   if NO error(s).
+*
+*               DEF_FAIL, otherwise.
+*
+* Note(s)     : (1) A stall on the control endpoint is cleared by the next SETUP token.
+*********************************************************************************************************
+*/
+
+static  CPU_BOOLEAN  USBD_DrvEP_Stall (USBD_DRV     *p_drv,
+                                       CPU_INT08U    ep_addr,
+                                       CPU_BOOLEAN   state)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    CPU_INT08U          ep_phy_nbr;
+    CPU_SR_ALLOC();
+
+
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(ep_addr);
+    if (ep_phy_nbr >= USBD_DRV_SIM_NBR_EP_PHY) {
+        return (DEF_FAIL);
+    }
+
+    p_data = (USBD_DRV_SIM_DATA *)p_drv->DataPtr;
+
+    CPU_CRITICAL_ENTER();
+    p_data->EP_Tbl[ep_phy_nbr].Stall = state;
+    CPU_CRITICAL_EXIT();
+
+    return (DEF_OK);
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_DrvISR_Handler()
+*
+* Description : USB device Interrupt Service Routine (ISR) handler.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) The status is latched and cleared in a critical section, then the core is notified
+*                   outside of it, as the core callbacks may enter critical sections themselves.
+*
+*               (2) Endpoint completions are reported before a new setup packet, so that the status stage
+*                   of the previous control transfer completes first.
+*********************************************************************************************************
+*/
+
+static  void  USBD_DrvISR_Handler (USBD_DRV  *p_drv)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+    USBD_DRV_SIM_EP    *p_ep;
+    CPU_INT08U          int_stat;
+    CPU_INT08U          setup_buf[USBD_DRV_SIM_SETUP_PKT_LEN];
+    CPU_INT08U          cmpl_nbr[USBD_DRV_SIM_NBR_EP_PHY];
+    CPU_INT08U          ep_phy_nbr;
+    CPU_INT08U          ep_log_nbr;
+    CPU_SR_ALLOC();
+
+
+    p_data = (USBD_DRV_SIM_DATA *)p_drv->DataPtr;
+
+    CPU_CRITICAL_ENTER();                                       /* See Note #1.                                         */
+    int_stat        = p_data->IntStat;
+    p_data->IntStat = DEF_BIT_NONE;
+    Mem_Copy(setup_buf, p_data->SetupBuf, USBD_DRV_SIM_SETUP_PKT_LEN);
+    for (ep_phy_nbr = 0u; ep_phy_nbr < USBD_DRV_SIM_NBR_EP_PHY; ep_phy_nbr++) {
+        p_ep                 = &p_data->EP_Tbl[ep_phy_nbr];
+        cmpl_nbr[ep_phy_nbr] =  p_ep->IntCmplNbr;
+        p_ep->IntCmplNbr     =  0u;
+    }
+    CPU_CRITICAL_EXIT();
+
+                                                                /* -------------------- BUS EVENTS -------------------- */
+    if (DEF_BIT_IS_SET(int_stat, USBD_DRV_SIM_INT_CONN) == DEF_YES) {
+        USBD_EventConn(p_drv);                                  /* Notify connect event.                                */
+    }
+
+    if (DEF_BIT_IS_SET(int_stat, USBD_DRV_SIM_INT_RESET) == DEF_YES) {
+        USBD_EventReset(p_drv);                                 /* Notify bus reset event.                              */
+
+        if (p_drv->CfgPtr->Spd == USBD_DEV_SPD_HIGH) {
+            USBD_EventHS(p_drv);                                /* Notify high-speed event.                             */
+        }
+    }
+
+    if (DEF_BIT_IS_SET(int_stat, USBD_DRV_SIM_INT_SUSPEND) == DEF_YES) {
+        USBD_EventSuspend(p_drv);                               /* Notify suspend event.                                */
+    }
+
+    if (DEF_BIT_IS_SET(int_stat, USBD_DRV_SIM_INT_RESUME) == DEF_YES) {
+        USBD_EventResume(p_drv);                                /* Notify resume event.                                 */
+    }
+
+                                                                /* ----------------- EP COMPLETIONS ------------------- */
+    for (ep_phy_nbr = 0u; ep_phy_nbr < USBD_DRV_SIM_NBR_EP_PHY; ep_phy_nbr++) {
+        ep_log_nbr = USBD_EP_PHY_TO_LOG(ep_phy_nbr);
+
+        while (cmpl_nbr[ep_phy_nbr] > 0u) {
+            if ((ep_phy_nbr & 1u) == 0u) {                      /* Even phy EPs are OUT EPs.                            */
+                USBD_EP_RxCmpl(p_drv, ep_log_nbr);
+            } else {
+                USBD_EP_TxCmpl(p_drv, ep_log_nbr);
+            }
+            cmpl_nbr[ep_phy_nbr]--;
+        }
+    }
+
+    if (DEF_BIT_IS_SET(int_stat, USBD_DRV_SIM_INT_SETUP) == DEF_YES) {
+        USBD_EventSetup(p_drv, (void *)&setup_buf[0u]);         /* See Note #2.                                         */
+    }
+
+    if (DEF_BIT_IS_SET(int_stat, USBD_DRV_SIM_INT_DISCONN) == DEF_YES) {
+        USBD_EventDisconn(p_drv);                               /* Notify disconnect event.                             */
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_DrvEP_QueueDepthGet()
+*
+* Description : Get the number of transfers the controller can hold at once on endpoint.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+*               ep_addr     Endpoint address.
+*
+* Return(s)   : Number of transfers that can be submitted on the endpoint before the first completes.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  CPU_INT08U  USBD_DrvEP_QueueDepthGet (USBD_DRV    *p_drv,
+                                              CPU_INT08U   ep_addr)
+{
+    (void)p_drv;
+    (void)ep_addr;
+
+    return (USBD_DRV_SIM_EP_QUEUE_DEPTH);
+}
+
+
+/*
+*********************************************************************************************************
+*********************************************************************************************************
+*                                           LOCAL FUNCTIONS
+*********************************************************************************************************
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                        USBD_DrvSim_DataGet()
+*
+* Description : Get the driver data of a started device.
+*
+* Argument(s) : dev_nbr     Device number.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                   Device is started.
+*                               USBD_ERR_DEV_INVALID_NBR        Invalid device number.
+*                               USBD_ERR_DEV_INVALID_STATE      Device not started.
+*
+* Return(s)   : Pointer to driver data, if NO error(s).
+*
+*               Pointer to NULL,        otherwise.
+*********************************************************************************************************
+*/
+
+static  USBD_DRV_SIM_DATA  *USBD_DrvSim_DataGet (CPU_INT08U   dev_nbr,
+                                                 USBD_ERR    *p_err)
+{
+    USBD_DRV_SIM_DATA  *p_data;
+
+
+    if (dev_nbr >= USBD_CFG_MAX_NBR_DEV) {
+       *p_err = USBD_ERR_DEV_INVALID_NBR;
+        return ((USBD_DRV_SIM_DATA *)0);
+    }
+
+    p_data = &USBD_DrvSim_DataTbl[dev_nbr];
+    if (p_data->DrvPtr == (USBD_DRV *)0) {
+       *p_err = USBD_ERR_DEV_INVALID_STATE;
+        return ((USBD_DRV_SIM_DATA *)0);
+    }
+
+   *p_err = USBD_ERR_NONE;
+
+    return (p_data);
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_DrvSim_BufPush()
+*
+* Description : Queue a buffer on an endpoint.
+*
+* Argument(s) : p_ep        Pointer to simulated endpoint.
+*
+*               p_buf       Pointer to buffer.
+*
+*               buf_len     Length of buffer.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE           Buffer successfully queued.
+*                               USBD_ERR_EP_QUEUING     Endpoint queue is full.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Must be called in a critical section.
+*********************************************************************************************************
+*/
+
+static  void  USBD_DrvSim_BufPush (USBD_DRV_SIM_EP  *p_ep,
+                                   CPU_INT08U       *p_buf,
+                                   CPU_INT32U        buf_len,
+                                   USBD_ERR         *p_err)
+{
+    USBD_DRV_SIM_BUF  *p_sim_buf;
+    CPU_INT08U         buf_ix;
+
+
+    if (p_ep->BufNbr >= USBD_DRV_SIM_EP_QUEUE_DEPTH) {
+       *p_err = USBD_ERR_EP_QUEUING;
+        return;
+    }
+
+    buf_ix             = (p_ep->BufHeadIx + p_ep->BufNbr) % USBD_DRV_SIM_EP_QUEUE_DEPTH;
+    p_sim_buf          = &p_ep->BufTbl[buf_ix];
+    p_sim_buf->BufPtr  =  p_buf;
+    p_sim_buf->BufLen  =  buf_len;
+    p_sim_buf->XferLen =  0u;
+    p_ep->BufNbr++;
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_DrvSim_BufPop()
+*
+* Description : Release the oldest completed OUT buffer of an endpoint.
+*
+* Argument(s) : p_ep        Pointer to simulated endpoint.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE   Buffer successfully released.
+*                               USBD_ERR_RX     No completed buffer on endpoint.
+*
+* Return(s)   : Number of octets received by the host in the buffer.
+*
+* Note(s)     : (1) Must be called in a critical section.
+*********************************************************************************************************
+*/
+
+static  CPU_INT32U  USBD_DrvSim_BufPop (USBD_DRV_SIM_EP  *p_ep,
+                                        USBD_ERR         *p_err)
+{
+    CPU_INT32U  xfer_len;
+
+
+    if (p_ep->BufCmplNbr == 0u) {
+       *p_err = USBD_ERR_RX;
+        return (0u);
+    }
+
+    xfer_len        = p_ep->BufTbl[p_ep->BufHeadIx].XferLen;
+    p_ep->BufHeadIx = (p_ep->BufHeadIx + 1u) % USBD_DRV_SIM_EP_QUEUE_DEPTH;
+    p_ep->BufNbr--;
+    p_ep->BufCmplNbr--;
+
+   *p_err = USBD_ERR_NONE;
+
+    return (xfer_len);
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_DrvSim_BufFlush()
+*
+* Description : Discard all buffers queued on an endpoint.
+*
+* Argument(s) : p_ep        Pointer to simulated endpoint.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Must be called in a critical section.
+*********************************************************************************************************
+*/
+
+static  void  USBD_DrvSim_BufFlush (USBD_DRV_SIM_EP  *p_ep)
+{
+    p_ep->BufHeadIx  = 0u;
+    p_ep->BufNbr     = 0u;
+    p_ep->BufCmplNbr = 0u;
+    p_ep->IntCmplNbr = 0u;
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_DrvSim_FrameExec()
+*
+* Description : Execute one (micro)frame of bus traffic.
+*
+* Argument(s) : p_data      Pointer to driver data.
+*
+* Return(s)   : Number of payload octets ACK'd during the (micro)frame.
+*
+* Note(s)     : (1) See 'usbd_drv_sim.c  Note #1a'. Control and bulk endpoints are served until the
+*                   (micro)frame is full, or until a whole round carried no data.
+*
+*               (2) Pending bus events are reported at the start of the (micro)frame.
+*********************************************************************************************************
+*/
+
+static  CPU_INT32U  USBD_DrvSim_FrameExec (USBD_DRV_SIM_DATA  *p_data)
+{
+    USBD_DRV_SIM_EP  *p_ep;
+    CPU_INT32U        octet_rem;
+    CPU_INT32U        octet_xfer;
+    CPU_INT32U        octet_round;
+    CPU_INT32U        uframe_per_ms;
+    CPU_INT08U        ep_phy_nbr;
+    CPU_INT08U        ep_ix;
+    CPU_INT08U        ep_type;
+    CPU_INT08U        rr_ix;
+    CPU_BOOLEAN       active;
+    CPU_BOOLEAN       hs;
+    CPU_SR_ALLOC();
+
+
+    hs = (p_data->DrvPtr->CfgPtr->Spd == USBD_DEV_SPD_HIGH) ? DEF_YES : DEF_NO;
+
+    CPU_CRITICAL_ENTER();
+    p_data->FrameCnt++;
+    for (ep_phy_nbr = 0u; ep_phy_nbr < USBD_DRV_SIM_NBR_EP_PHY; ep_phy_nbr++) {
+        p_data->EP_Tbl[ep_phy_nbr].TransCnt = 0u;
+    }
+    active = ((p_data->Conn      == DEF_YES) &&
+              (p_data->PullUpEn  == DEF_YES) &&
+              (p_data->Suspended == DEF_NO)) ? DEF_YES : DEF_NO;
+    rr_ix  =   p_data->RR_Ix;
+    p_data->RR_Ix = (p_data->RR_Ix + 1u) % USBD_DRV_SIM_NBR_EP_PHY;
+    CPU_CRITICAL_EXIT();
+
+    USBD_DrvSim_IntRaise(p_data);                               /* See Note #2.                                         */
+
+    octet_xfer = 0u;
+    if (active == DEF_YES) {
+        octet_rem = p_data->Cfg.FrameOctetMax;
+        if (octet_rem == 0u) {
+            octet_rem = (hs == DEF_YES) ? USBD_DRV_SIM_FRAME_OCTET_HS
+                                        : USBD_DRV_SIM_FRAME_OCTET_FS;
+        }
+                                                                /* ---------------- PERIODIC TRANSFERS ---------------- */
+        for (ep_phy_nbr = 0u; ep_phy_nbr < USBD_DRV_SIM_NBR_EP_PHY; ep_phy_nbr++) {
+            p_ep    = &p_data->EP_Tbl[ep_phy_nbr];
+            ep_type =  p_ep->Type & USBD_EP_TYPE_MASK;
+            if ((ep_type == USBD_EP_TYPE_ISOC) ||
+                (ep_type == USBD_EP_TYPE_INTR)) {
+                while ((p_ep->TransCnt < p_ep->TransFrame) &&
+                       (USBD_DrvSim_TransExec(p_data, ep_phy_nbr, &octet_rem, &octet_xfer) != USBD_DRV_SIM_PID_NONE)) {
+                    ;
+                }
+            }
+        }
+                                                                /* ------------- CONTROL & BULK TRANSFERS ------------- */
+        do {
+            octet_round = octet_xfer;
+            for (ep_ix = 0u; ep_ix < USBD_DRV_SIM_NBR_EP_PHY; ep_ix++) {
+                ep_phy_nbr = (rr_ix + ep_ix) % USBD_DRV_SIM_NBR_EP_PHY;
+                ep_type    =  p_data->EP_Tbl[ep_phy_nbr].Type & USBD_EP_TYPE_MASK;
+                if ((ep_type    == USBD_EP_TYPE_BULK) ||
+                    (ep_phy_nbr == 0u)) {                       /* Ctrl xfers are kept on EP 0x00.                      */
+                    (void)USBD_DrvSim_TransExec(p_data, ep_phy_nbr, &octet_rem, &octet_xfer);
+                }
+            }
+        } while (octet_xfer != octet_round);
+    }
+
+    if (p_data->Cfg.RealTimeEn == DEF_ENABLED) {                /* Pace frame clock (see 'usbd_drv_sim.h  Note #4').    */
+        uframe_per_ms = (hs == DEF_YES) ? USBD_DRV_SIM_UFRAME_PER_FRAME : 1u;
+        if ((p_data->FrameCnt % uframe_per_ms) == 0u) {
+            USBD_OS_DlyMs(1u);
+        }
+    }
+
+    return (octet_xfer);
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_DrvSim_TransExec()
+*
+* Description : Issue the next transaction of the host transfer submitted on an endpoint.
+*
+* Argument(s) : p_data          Pointer to driver data.
+*
+*               ep_phy_nbr      Physical number of the endpoint holding the host transfer.
+*
+*               p_octet_rem     Pointer to the bus time left in the (micro)frame, in octets.
+*
+*               p_octet_xfer    Pointer to the number of payload octets ACK'd during the (micro)frame.
+*
+* Return(s)   : Handshake of the transaction, or USBD_DRV_SIM_PID_NONE if no transaction was issued.
+*
+* Note(s)     : (1) An IN transaction is only issued if the bus time left can hold a maximum size packet,
+*                   since the host cannot know in advance how much data the device will return.
+*
+*               (2) Consecutive errors halt the transfer, except on isochronous endpoints where the
+*                   packet is simply lost (see 'usbd_drv_sim.h  Note #2b').
+*
+*               (3) The ISR is called once the critical section is released, as a hardware interrupt
+*                   would fire at the end of the transaction.
+*********************************************************************************************************
+*/
+
+static  CPU_INT08U  USBD_DrvSim_TransExec (USBD_DRV_SIM_DATA  *p_data,
+                                           CPU_INT08U          ep_phy_nbr,
+                                           CPU_INT32U         *p_octet_rem,
+                                           CPU_INT32U         *p_octet_xfer)
+{
+    USBD_DRV_SIM_EP         *p_host_ep;
+    USBD_DRV_SIM_EP         *p_ep;
+    USBD_DRV_SIM_HOST_XFER  *p_host_xfer;
+    CPU_INT32U               overhead;
+    CPU_INT32U               pkt_len;
+    CPU_INT32U               octet_req;
+    CPU_INT08U               retry_max;
+    CPU_INT08U               pid;
+    CPU_BOOLEAN              isoc;
+    CPU_BOOLEAN              host_cmpl;
+    CPU_BOOLEAN              nak_forced;
+    CPU_SR_ALLOC();
+
+
+    overhead    = (p_data->DrvPtr->CfgPtr->Spd == USBD_DEV_SPD_HIGH) ? USBD_DRV_SIM_PKT_OVERHEAD_HS
+                                                                      : USBD_DRV_SIM_PKT_OVERHEAD_FS;
+    retry_max   = (p_data->Cfg.ErrRetryMax != 0u) ? p_data->Cfg.ErrRetryMax
+                                                  : USBD_DRV_SIM_ERR_RETRY_MAX_DFLT;
+    p_host_ep   = &p_data->EP_Tbl[ep_phy_nbr];
+    p_host_xfer = &p_host_ep->HostXfer;
+    pkt_len     =  0u;
+    host_cmpl   =  DEF_NO;
+    nak_forced  =  DEF_NO;
+
+    CPU_CRITICAL_ENTER();
+    if ((p_host_xfer->State == USBD_DRV_SIM_HOST_STATE_NONE) ||
+        (p_host_xfer->State == USBD_DRV_SIM_HOST_STATE_CMPL)) {
+        CPU_CRITICAL_EXIT();
+        return (USBD_DRV_SIM_PID_NONE);
+    }
+                                                                /* ------------------ SELECT TARGET ------------------- */
+    if (p_host_xfer->State == USBD_DRV_SIM_HOST_STATE_SETUP) {
+        p_ep      = &p_data->EP_Tbl[0u];
+        octet_req =  USBD_DRV_SIM_SETUP_PKT_LEN + overhead;
+    } else {
+        p_ep = p_host_ep;
+        if (ep_phy_nbr == 0u) {                                 /* Ctrl data/status stage, IN on phy EP 1.              */
+            p_ep = &p_data->EP_Tbl[(p_host_xfer->DirIn == DEF_YES) ? 1u : 0u];
+        }
+
+        if (p_host_xfer->State == USBD_DRV_SIM_HOST_STATE_STATUS) {
+            pkt_len = 0u;
+        } else if (p_host_xfer->DirIn == DEF_YES) {
+            pkt_len = p_ep->MaxPktSize;                         /* See Note #1.                                         */
+        } else {
+            pkt_len = DEF_MIN(p_ep->MaxPktSize, p_host_xfer->BufLen - p_host_xfer->XferLen);
+        }
+        octet_req = pkt_len + overhead;
+    }
+
+    if (*p_octet_rem < octet_req) {                             /* No bus time left in (micro)frame.                    */
+        CPU_CRITICAL_EXIT();
+        return (USBD_DRV_SIM_PID_NONE);
+    }
+
+    isoc = ((p_ep->Type & USBD_EP_TYPE_MASK) == USBD_EP_TYPE_ISOC) ? DEF_YES : DEF_NO;
+    p_host_ep->TransCnt++;
+                                                                /* ----------------- ISSUE TRANSACTION ---------------- */
+    if ((p_ep->ErrInjectNbr > 0u) ||
+        (USBD_DrvSim_RandHit(p_data, p_data->Cfg.ErrRate) == DEF_YES)) {
+        if (p_ep->ErrInjectNbr > 0u) {
+            p_ep->ErrInjectNbr--;
+        }
+        pid = USBD_DRV_SIM_PID_ERR;
+
+    } else if (p_host_xfer->State == USBD_DRV_SIM_HOST_STATE_SETUP) {
+        pid = USBD_DrvSim_TransSetup(p_data, p_host_xfer);
+        if (pid == USBD_DRV_SIM_PID_ACK) {
+            pkt_len = USBD_DRV_SIM_SETUP_PKT_LEN;
+        }
+
+    } else if (p_ep->Open == DEF_NO) {
+        pid = USBD_DRV_SIM_PID_NAK;                             /* EP not ready to be used.                             */
+
+    } else if ((p_ep->Stall == DEF_YES) &&
+               (isoc        == DEF_NO)) {
+        pid = USBD_DRV_SIM_PID_STALL;
+
+    } else if ((isoc                                                   == DEF_NO) &&
+               (USBD_DrvSim_RandHit(p_data, p_data->Cfg.NakRate) == DEF_YES)) {
+        pid = USBD_DRV_SIM_PID_NAK;
+        nak_forced = DEF_YES;
+
+    } else if (p_host_xfer->DirIn == DEF_YES) {
+        pid = USBD_DrvSim_TransIn(p_ep, p_host_xfer, &pkt_len, &host_cmpl);
+
+    } else {
+        pid = USBD_DrvSim_TransOut(p_ep, p_host_xfer, pkt_len, &host_cmpl);
+    }
+                                                                /* ------------------ UPDATE STATUS ------------------- */
+    switch (pid) {
+        case USBD_DRV_SIM_PID_ACK:
+             p_ep->Stat.AckCnt++;
+             p_ep->Stat.OctetCnt += pkt_len;
+            *p_octet_rem         -= pkt_len + overhead;
+            *p_octet_xfer        += pkt_len;
+             p_host_xfer->ErrCnt  = 0u;
+             if ((p_host_xfer->State == USBD_DRV_SIM_HOST_STATE_SETUP) ||
+                 (host_cmpl          == DEF_YES)) {
+                 USBD_DrvSim_HostStageNext(p_data, p_host_ep);
+             }
+             break;
+
+        case USBD_DRV_SIM_PID_NAK:
+             if (nak_forced == DEF_YES) {
+                 p_ep->Stat.NakForcedCnt++;
+             } else {
+                 p_ep->Stat.NakNotRdyCnt++;
+             }
+            *p_octet_rem -= overhead;
+             if (isoc == DEF_YES) {                             /* Isoc data is lost if EP is not ready.                */
+                 USBD_DrvSim_HostXferEnd(p_data, p_host_ep, USBD_ERR_NONE);
+             }
+             break;
+
+        case USBD_DRV_SIM_PID_STALL:
+             p_ep->Stat.StallCnt++;
+            *p_octet_rem -= overhead;
+             USBD_DrvSim_HostXferEnd(p_data, p_host_ep, USBD_ERR_EP_STALL);
+             break;
+
+        case USBD_DRV_SIM_PID_ERR:
+        default:
+             p_ep->Stat.ErrCnt++;
+            *p_octet_rem -= octet_req;
+             p_host_xfer->ErrCnt++;
+             if (isoc == DEF_YES) {                             /* See Note #2.                                         */
+                 USBD_DrvSim_HostXferEnd(p_data, p_host_ep, USBD_ERR_NONE);
+             } else if (p_host_xfer->ErrCnt >= retry_max) {
+                 USBD_DrvSim_HostXferEnd(p_data, p_host_ep, USBD_ERR_FAIL);
+             } else {
+                 ;
+             }
+             break;
+    }
+    CPU_CRITICAL_EXIT();
+
+    USBD_DrvSim_IntRaise(p_data);                               /* See Note #3.                                         */
+
+    return (pid);
+}
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_DrvSim_TransSetup()
+*
+* Description : Issue a SETUP transaction.
+*
+* Argument(s) : p_data          Pointer to driver data.
+*
+*               p_host_xfer     Pointer to host control transfer.
+*
+* Return(s)   : USBD_DRV_SIM_PID_ACK, if the setup packet was received.
+*
+*               USBD_DRV_SIM_PID_NAK, if the control endpoint is not open yet.
+*
+* Note(s)     : (1) 'Universal Serial Bus Specification Rev 2.0', section 8.5.3 states that a SETUP token
+*                   is always accepted. It clears the stall condition of the control endpoint and cancels
+*                   the buffers not yet used by the previous control transfer.
+*
+*               (2) Must be called in a critical section.
+*********************************************************************************************************
+*/
+
+static  CPU_INT08U  USBD_DrvSim_TransSetup (USBD_DRV_SIM_DATA       *p_data,
+                                            USBD_DRV_SIM_HOST_XFER  *p_host_xfer)
+{
+    USBD_DRV_SIM_EP  *p_ep_out;
+    USBD_DRV_SIM_EP  *p_ep_in;
+
+
+    p_ep_out = &p_data->EP_Tbl[0u];
+    p_ep_in  = &p_data->EP_Tbl[1u];
+
+    if (p_ep_out->Open == DEF_NO) {
+        return (USBD_DRV_SIM_PID_NAK);
+    }
+                                                                /* See Note #1.                                         */
+    p_ep_out->Stall  = DEF_NO;
+    p_ep_in->Stall   = DEF_NO;
+    p_ep_out->BufNbr = p_ep_out->BufCmplNbr;                    /* Keep OUT buf cmpl'd but not read yet.                */
+    p_ep_in->BufNbr  = 0u;
+
+    Mem_Copy(p_data->SetupBuf, p_host_xfer->Setup, USBD_DRV_SIM_SETUP_PKT_LEN);
+    DEF_BIT_SET(p_data->IntStat, USBD_DRV_SIM_INT_SETUP);
+
+    return (USBD_DRV_SIM_PID_ACK);
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_DrvSim_TransOut()
+*
+* Description : Issue an OUT transaction.
+*
+* Argument(s) : p_ep            Pointer to target endpoint.
+*
+*               p_host_xfer     Pointer to host transfer.
+*
+*               pkt_len         Length of the packet sent by the host.
+*
+*               p_host_cmpl     Pointer to variable that will receive DEF_YES if the host stage is complete.
+*
+* Return(s)   : USBD_DRV_SIM_PID_ACK, if the packet was received.
+*
+*               USBD_DRV_SIM_PID_NAK, if no buffer is queued on the endpoint.
+*
+* Note(s)     : (1) A buffer completes on a short packet, or when it is full. If the packet is larger than
+*                   the room left in the buffer, the excess is dropped but still counted, so that
+*                   USBD_DrvEP_Rx() reports the overflow.
+*
+*               (2) Must be called in a critical section.
+*********************************************************************************************************
+*/
+
+static  CPU_INT08U  USBD_DrvSim_TransOut (USBD_DRV_SIM_EP         *p_ep,
+                                          USBD_DRV_SIM_HOST_XFER  *p_host_xfer,
+                                          CPU_INT32U               pkt_len,
+                                          CPU_BOOLEAN             *p_host_cmpl)
+{
+    USBD_DRV_SIM_BUF  *p_sim_buf;
+    CPU_INT08U         buf_ix;
+    CPU_INT32U         copy_len;
+
+
+    if (p_ep->BufCmplNbr >= p_ep->BufNbr) {                     /* No buf waiting for data.                             */
+        return (USBD_DRV_SIM_PID_NAK);
+    }
+
+    buf_ix    = (p_ep->BufHeadIx + p_ep->BufCmplNbr) % USBD_DRV_SIM_EP_QUEUE_DEPTH;
+    p_sim_buf = &p_ep->BufTbl[buf_ix];
+
+    copy_len = DEF_MIN(pkt_len, p_sim_buf->BufLen - DEF_MIN(p_sim_buf->XferLen, p_sim_buf->BufLen));
+    if (copy_len > 0u) {
+        Mem_Copy(&p_sim_buf->BufPtr[p_sim_buf->XferLen],
+                 &p_host_xfer->BufPtr[p_host_xfer->XferLen],
+                  copy_len);
+    }
+    p_sim_buf->XferLen   += pkt_len;                            /* See Note #1.                                         */
+    p_host_xfer->XferLen += pkt_len;
+
+    if ((pkt_len            <  p_ep->MaxPktSize) ||             /* Device side cmpl.                                    */
+        (p_sim_buf->XferLen >= p_sim_buf->BufLen)) {
+        p_ep->BufCmplNbr++;
+        p_ep->IntCmplNbr++;
+    }
+
+    if ((p_host_xfer->State   == USBD_DRV_SIM_HOST_STATE_STATUS) ||
+        (pkt_len              <  p_ep->MaxPktSize)               ||
+        (p_host_xfer->XferLen >= p_host_xfer->BufLen)) {
+       *p_host_cmpl = DEF_YES;
+    }
+
+    return (USBD_DRV_SIM_PID_ACK);
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_DrvSim_TransIn()
+*
+* Description : Issue an IN transaction.
+*
+* Argument(s) : p_ep            Pointer to target endpoint.
+*
+*               p_host_xfer     Pointer to host transfer.
+*
+*               p_pkt_len       Pointer to variable that will receive the length of the packet sent by the
+*                               device.
+*
+*               p_host_cmpl     Pointer to variable that will receive DEF_YES if the host stage is complete.
+*
+* Return(s)   : USBD_DRV_SIM_PID_ACK, if a packet was sent.
+*
+*               USBD_DRV_SIM_PID_NAK, if no buffer is queued on the endpoint.
+*
+* Note(s)     : (1) The device sends at most one maximum size packet from the oldest queued buffer. The
+*                   buffer completes once all of its data was sent, and is released right away.
+*
+*               (2) If the packet does not fit in the host buffer, the host keeps what fits and ends the
+*                   transfer with USBD_ERR_DRV_BUF_OVERFLOW (babble).
+*
+*               (3) Must be called in a critical section.
+*********************************************************************************************************
+*/
+
+static  CPU_INT08U  USBD_DrvSim_TransIn (USBD_DRV_SIM_EP         *p_ep,
+                                         USBD_DRV_SIM_HOST_XFER  *p_host_xfer,
+                                         CPU_INT32U              *p_pkt_len,
+                                         CPU_BOOLEAN             *p_host_cmpl)
+{
+    USBD_DRV_SIM_BUF  *p_sim_buf;
+    CPU_INT32U         pkt_len;
+    CPU_INT32U         host_rem;
+    CPU_INT32U         copy_len;
+
+
+    if (p_ep->BufNbr == 0u) {
+        return (USBD_DRV_SIM_PID_NAK);
+    }
+
+    p_sim_buf = &p_ep->BufTbl[p_ep->BufHeadIx];                 /* See Note #1.                                         */
+    pkt_len   =  DEF_MIN(p_ep->MaxPktSize, p_sim_buf->BufLen - p_sim_buf->XferLen);
+
+    host_rem = 0u;
+    if (p_host_xfer->State != USBD_DRV_SIM_HOST_STATE_STATUS) {
+        host_rem = p_host_xfer->BufLen - p_host_xfer->XferLen;
+    }
+    copy_len = DEF_MIN(pkt_len, host_rem);
+    if (copy_len > 0u) {
+        Mem_Copy(&p_host_xfer->BufPtr[p_host_xfer->XferLen],
+                 &p_sim_buf->BufPtr[p_sim_buf->XferLen],
+                  copy_len);
+    }
+    p_sim_buf->XferLen   += pkt_len;
+    p_host_xfer->XferLen += copy_len;
+
+    if (p_sim_buf->XferLen >= p_sim_buf->BufLen) {              /* Device side cmpl.                                    */
+        p_ep->BufHeadIx = (p_ep->BufHeadIx + 1u) % USBD_DRV_SIM_EP_QUEUE_DEPTH;
+        p_ep->BufNbr--;
+        p_ep->IntCmplNbr++;
+    }
+
+    if (pkt_len > host_rem) {                                   /* See Note #2.                                         */
+        p_host_xfer->Err = USBD_ERR_DRV_BUF_OVERFLOW;
+       *p_host_cmpl      = DEF_YES;
+    } else if ((pkt_len              <  p_ep->MaxPktSize) ||
+               (p_host_xfer->XferLen >= p_host_xfer->BufLen)) {
+       *p_host_cmpl      = DEF_YES;
+    } else {
+        ;
+    }
+
+   *p_pkt_len = pkt_len;
+
+    return (USBD_DRV_SIM_PID_ACK);
+}
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_DrvSim_HostStageNext()
+*
+* Description : Move a host transfer to its next stage.
+*
+* Argument(s) : p_data      Pointer to driver data.
+*
+*               p_host_ep   Pointer to endpoint holding the host transfer.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) A control transfer without data stage has an IN status stage. Otherwise, the status
+*                   stage goes in the direction opposite to the data stage.
+*
+*               (2) Must be called in a critical section.
+*********************************************************************************************************
+*/
+
+static  void  USBD_DrvSim_HostStageNext (USBD_DRV_SIM_DATA  *p_data,
+                                         USBD_DRV_SIM_EP    *p_host_ep)
+{
+    USBD_DRV_SIM_HOST_XFER  *p_host_xfer;
+
+
+    p_host_xfer = &p_host_ep->HostXfer;
+
+    if (p_host_xfer->Err != USBD_ERR_NONE) {
+        USBD_DrvSim_HostXferEnd(p_data, p_host_ep, p_host_xfer->Err);
+        return;
+    }
+
+    switch (p_host_xfer->State) {
+        case USBD_DRV_SIM_HOST_STATE_SETUP:
+             if (p_host_xfer->BufLen > 0u) {
+                 p_host_xfer->DirIn = DEF_BIT_IS_SET(p_host_xfer->Setup[0u], USBD_REQ_DIR_BIT);
+                 p_host_xfer->State = USBD_DRV_SIM_HOST_STATE_DATA;
+             } else {
+                 p_host_xfer->DirIn = DEF_YES;                  /* See Note #1.                                         */
+                 p_host_xfer->State = USBD_DRV_SIM_HOST_STATE_STATUS;
+             }
+             break;
+
+        case USBD_DRV_SIM_HOST_STATE_DATA:
+             if (p_host_ep == &p_data->EP_Tbl[0u]) {            /* Ctrl xfer continues with status stage.               */
+                 p_host_xfer->DirIn = (p_host_xfer->DirIn == DEF_YES) ? DEF_NO : DEF_YES;
+                 p_host_xfer->State =  USBD_DRV_SIM_HOST_STATE_STATUS;
+             } else {
+                 USBD_DrvSim_HostXferEnd(p_data, p_host_ep, USBD_ERR_NONE);
+             }
+             break;
+
+        case USBD_DRV_SIM_HOST_STATE_STATUS:
+        default:
+             USBD_DrvSim_HostXferEnd(p_data, p_host_ep, USBD_ERR_NONE);
+             break;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_DrvSim_HostXferEnd()
+*
+* Description : End a host transfer and account for its duration.
+*
+* Argument(s) : p_data      Pointer to driver data.
+*
+*               p_host_ep   Pointer to endpoint holding the host transfer.
+*
+*               err         Transfer result.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Must be called in a critical section.
+*********************************************************************************************************
+*/
+
+static  void  USBD_DrvSim_HostXferEnd (USBD_DRV_SIM_DATA  *p_data,
+                                       USBD_DRV_SIM_EP    *p_host_ep,
+                                       USBD_ERR            err)
+{
+    USBD_DRV_SIM_HOST_XFER  *p_host_xfer;
+    CPU_INT32U               frame_nbr;
+
+
+    p_host_xfer = &p_host_ep->HostXfer;
+    frame_nbr   =  p_data->FrameCnt - p_host_xfer->FrameStart;
+
+    p_host_xfer->Err   = err;
+    p_host_xfer->State = USBD_DRV_SIM_HOST_STATE_CMPL;
+
+    p_host_ep->Stat.XferCnt++;
+    p_host_ep->Stat.XferFrameTot += frame_nbr;
+    if (frame_nbr > p_host_ep->Stat.XferFrameMax) {
+        p_host_ep->Stat.XferFrameMax = frame_nbr;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_DrvSim_HostXferEndAll()
+*
+* Description : End all host transfers in progress.
+*
+* Argument(s) : p_data      Pointer to driver data.
+*
+*               err         Transfer result.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Must be called in a critical section.
+*********************************************************************************************************
+*/
+
+static  void  USBD_DrvSim_HostXferEndAll (USBD_DRV_SIM_DATA  *p_data,
+                                          USBD_ERR            err)
+{
+    USBD_DRV_SIM_EP  *p_ep;
+    CPU_INT08U        ep_phy_nbr;
+
+
+    for (ep_phy_nbr = 0u; ep_phy_nbr < USBD_DRV_SIM_NBR_EP_PHY; ep_phy_nbr++) {
+        p_ep = &p_data->EP_Tbl[ep_phy_nbr];
+        if ((p_ep->HostXfer.State != USBD_DRV_SIM_HOST_STATE_NONE) &&
+            (p_ep->HostXfer.State != USBD_DRV_SIM_HOST_STATE_CMPL)) {
+            USBD_DrvSim_HostXferEnd(p_data, p_ep, err);
+        }
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_DrvSim_RandHit()
+*
+* Description : Draw a random event.
+*
+* Argument(s) : p_data      Pointer to driver data.
+*
+*               rate        Event rate, per thousand draws.
+*
+* Return(s)   : DEF_YES, if the event occurs.
+*
+*               DEF_NO,  otherwise.
+*
+* Note(s)     : (1) A linear congruential generator is used, so that a given seed always produces the same
+*                   sequence of NAKs and errors.
+*
+*               (2) Must be called in a critical section.
+*********************************************************************************************************
+*/
+
+static  CPU_BOOLEAN  USBD_DrvSim_RandHit (USBD_DRV_SIM_DATA  *p_data,
+                                          CPU_INT16U          rate)
+{
+    CPU_INT32U  val;
+
+
+    if (rate == 0u) {
+        return (DEF_NO);
+    }
+
+    p_data->RandState = (p_data->RandState * 1103515245u) + 12345u;
+    val               = (p_data->RandState >> 16u) % USBD_DRV_SIM_RATE_SCALE;
+
+    return ((val < rate) ? DEF_YES : DEF_NO);
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_DrvSim_IntRaise()
+*
+* Description : Call the driver ISR if an interrupt is pending.
+*
+* Argument(s) : p_data      Pointer to driver data.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Must NOT be called in a critical section.
+*********************************************************************************************************
+*/
+
+static  void  USBD_DrvSim_IntRaise (USBD_DRV_SIM_DATA  *p_data)
+{
+    USBD_DRV      *p_drv;
+    USBD_DRV_API  *p_drv_api;
+    CPU_INT08U     ep_phy_nbr;
+    CPU_BOOLEAN    pending;
+    CPU_SR_ALLOC();
+
+
+    CPU_CRITICAL_ENTER();
+    pending = (p_data->IntStat != DEF_BIT_NONE) ? DEF_YES : DEF_NO;
+    for (ep_phy_nbr = 0u; ep_phy_nbr < USBD_DRV_SIM_NBR_EP_PHY; ep_phy_nbr++) {
+        if (p_data->EP_Tbl[ep_phy_nbr].IntCmplNbr > 0u) {
+            pending = DEF_YES;
+        }
+    }
+    if (p_data->PullUpEn == DEF_NO) {                           /* No int while dev is stopped.                         */
+        pending = DEF_NO;
+    }
+    CPU_CRITICAL_EXIT();
+
+    if (pending == DEF_YES) {
+        p_drv     = p_data->DrvPtr;
+        p_drv_api = p_drv->API_Ptr;                             /* Get a reference to USBD_DRV_API.                     */
+        p_drv_api->ISR_Handler(p_drv);                          /* Call the USB Device driver ISR.                      */
+    }
+}
@@ -0,0 +1,205 @@
+/*
+*********************************************************************************************************
+*                                            uC/USB-Device
+*                                    The Embedded USB Device Stack
+*
+*                    Copyright 2004-2021 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*
+*                                          USB DEVICE DRIVER
+*
+*                                 SIMULATED CONTROLLER AND VIRTUAL HOST
+*
+* Filename : usbd_drv_sim.h
+* Version  : V4.06.01
+*********************************************************************************************************
+* Note(s)  : (1) This driver does not access any hardware. The controller is modeled in memory and driven
+*                by an in-process virtual host that issues SETUP, IN and OUT tokens frame by frame (see
+*                'usbd_drv_sim.c  Note #1').
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                               MODULE
+*
+* Note(s) : (1) This USB device driver function header file is protected from multiple pre-processor
+*               inclusion through use of the USB device driver module present pre-processor macro
+*               definition.
+*********************************************************************************************************
+*/
+
+#ifndef  USBD_DRV_SIM_MODULE_PRESENT                            /* See Note #1.                                         */
+#define  USBD_DRV_SIM_MODULE_PRESENT
+
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#include  "../../Source/usbd_core.h"
+
+
+/*
+*********************************************************************************************************
+*                                    SIMULATION MODEL CONFIGURATION
+*
+* Note(s) : (1) 'FrameOctetMax' is the bus time available in each frame (full-speed) or microframe
+*               (high-speed), expressed in octets. Each transaction consumes its payload plus the protocol
+*               overhead of its speed. A value of 0 selects the raw bus capacity : 1500 octets per frame
+*               at full-speed, 7500 octets per microframe at high-speed.
+*
+*           (2) 'NakRate' and 'ErrRate' are expressed per thousand transactions :
+*
+*               (a) A forced NAK is returned even though the endpoint is ready, as a busy controller
+*                   would. The host retries the transaction later.
+*
+*               (b) A transaction error models a corrupted or lost packet. The host retries the
+*                   transaction and halts the transfer with USBD_ERR_FAIL after 'ErrRetryMax'
+*                   consecutive errors (three, per 'Universal Serial Bus Specification Rev 2.0',
+*                   section 10.2.6). Isochronous transactions are never retried.
+*
+*           (3) 'XferLenMax' limits the number of octets accepted by each EP_RxStart()/EP_Tx() call, so
+*               that transfers are split into several driver transactions. A value of 0 removes the limit.
+*
+*           (4) When 'RealTimeEn' is enabled, the frame clock is paced with USBD_OS_DlyMs() so that one
+*               millisecond of bus time lasts one millisecond. Otherwise, frames run back to back and the
+*               host only yields to the stack when a frame carried no data.
+*********************************************************************************************************
+*/
+
+typedef  struct  usbd_drv_sim_model_cfg {
+    CPU_INT32U   FrameOctetMax;                                 /* Bus time per (micro)frame (see Note #1).             */
+    CPU_INT16U   NakRate;                                       /* Forced NAK rate        (see Note #2a).               */
+    CPU_INT16U   ErrRate;                                       /* Transaction error rate (see Note #2b).               */
+    CPU_INT08U   ErrRetryMax;                                   /* Consecutive errors before halting xfer.              */
+    CPU_INT32U   XferLenMax;                                    /* Max len per drv transaction (see Note #3).           */
+    CPU_BOOLEAN  RealTimeEn;                                    /* Pace frame clock in real time (see Note #4).         */
+    CPU_INT32U   Seed;                                          /* Seed of error and NAK generator.                     */
+} USBD_DRV_SIM_MODEL_CFG;
+
+
+/*
+*********************************************************************************************************
+*                                   SIMULATED ENDPOINT STATISTICS
+*
+* Note(s) : (1) 'NakNotRdyCnt' counts the NAKs returned because no buffer was queued on the endpoint. Along
+*               with 'XferFrameTot', the number of (micro)frames elapsed between the submission of host
+*               transfers and their completion, it gives the stack overhead per transfer.
+*********************************************************************************************************
+*/
+
+typedef  struct  usbd_drv_sim_stat {
+    CPU_INT32U  AckCnt;                                         /* Nbr of ACK'd transactions.                           */
+    CPU_INT32U  NakNotRdyCnt;                                   /* Nbr of NAKs, EP not ready (see Note #1).             */
+    CPU_INT32U  NakForcedCnt;                                   /* Nbr of forced NAKs.                                  */
+    CPU_INT32U  StallCnt;                                       /* Nbr of STALL handshakes.                             */
+    CPU_INT32U  ErrCnt;                                         /* Nbr of transaction errors.                           */
+    CPU_INT32U  OctetCnt;                                       /* Nbr of payload octets ACK'd.                         */
+    CPU_INT32U  XferCnt;                                        /* Nbr of completed host xfers.                         */
+    CPU_INT32U  XferFrameTot;                                   /* Frames spent in completed host xfers (see Note #1).  */
+    CPU_INT32U  XferFrameMax;                                   /* Longest completed host xfer, in frames.              */
+} USBD_DRV_SIM_STAT;
+
+
+/*
+*********************************************************************************************************
+*                                          USB DEVICE DRIVER
+*********************************************************************************************************
+*/
+
+extern  USBD_DRV_API       USBD_DrvAPI_Sim;
+extern  USBD_DRV_BSP_API   USBD_DrvBSP_Sim;
+extern  USBD_DRV_EP_INFO   USBD_DrvEP_InfoTbl_Sim[];
+
+
+/*
+*********************************************************************************************************
+*                                         FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+                                                                /* ------------------ MODEL CONTROL ------------------- */
+void         USBD_DrvSim_ModelCfgSet    (       CPU_INT08U               dev_nbr,
+                                         const  USBD_DRV_SIM_MODEL_CFG  *p_cfg,
+                                                USBD_ERR                *p_err);
+
+void         USBD_DrvSim_FrameRun       (       CPU_INT08U               dev_nbr,
+                                                USBD_ERR                *p_err);
+
+void         USBD_DrvSim_ErrInject      (       CPU_INT08U               dev_nbr,
+                                                CPU_INT08U               ep_addr,
+                                                CPU_INT08U               nbr_err,
+                                                USBD_ERR                *p_err);
+
+void         USBD_DrvSim_StatGet        (       CPU_INT08U               dev_nbr,
+                                                CPU_INT08U               ep_addr,
+                                                USBD_DRV_SIM_STAT       *p_stat,
+                                                USBD_ERR                *p_err);
+
+void         USBD_DrvSim_StatClr        (       CPU_INT08U               dev_nbr,
+                                                USBD_ERR                *p_err);
+
+                                                                /* -------------------- BUS EVENTS -------------------- */
+void         USBD_DrvSim_HostConn       (       CPU_INT08U               dev_nbr,
+                                                USBD_ERR                *p_err);
+
+void         USBD_DrvSim_HostDisconn    (       CPU_INT08U               dev_nbr,
+                                                USBD_ERR                *p_err);
+
+void         USBD_DrvSim_HostReset      (       CPU_INT08U               dev_nbr,
+                                                USBD_ERR                *p_err);
+
+void         USBD_DrvSim_HostSuspend    (       CPU_INT08U               dev_nbr,
+                                                USBD_ERR                *p_err);
+
+void         USBD_DrvSim_HostResume     (       CPU_INT08U               dev_nbr,
+                                                USBD_ERR                *p_err);
+
+                                                                /* ------------------ HOST TRANSFERS ------------------ */
+void         USBD_DrvSim_HostCtrlSubmit (       CPU_INT08U               dev_nbr,
+                                         const  CPU_INT08U              *p_setup,
+                                                void                    *p_buf,
+                                                USBD_ERR                *p_err);
+
+void         USBD_DrvSim_HostXferSubmit (       CPU_INT08U               dev_nbr,
+                                                CPU_INT08U               ep_addr,
+                                                void                    *p_buf,
+                                                CPU_INT32U               buf_len,
+                                                USBD_ERR                *p_err);
+
+CPU_BOOLEAN  USBD_DrvSim_HostXferIsCmpl (       CPU_INT08U               dev_nbr,
+                                                CPU_INT08U               ep_addr,
+                                                CPU_INT32U              *p_xfer_len,
+                                                USBD_ERR                *p_err);
+
+CPU_INT32U   USBD_DrvSim_HostXferWait   (       CPU_INT08U               dev_nbr,
+                                                CPU_INT08U               ep_addr,
+                                                CPU_INT32U               timeout_frame,
+                                                USBD_ERR                *p_err);
+
+void         USBD_DrvSim_HostXferAbort  (       CPU_INT08U               dev_nbr,
+                                                CPU_INT08U               ep_addr,
+                                                USBD_ERR                *p_err);
+
+
+/*
+*********************************************************************************************************
+*                                             MODULE END
+*********************************************************************************************************
+*/
+
+#endif
@@ -148,6 +148,9 @@ static  CPU_BOOLEAN  USBD_DrvEP_Stall   (USBD_DRV     *p_drv,
 
 static  void         USBD_DrvISR_Handler(USBD_DRV     *p_drv);
 
+static  CPU_INT08U   USBD_DrvEP_QueueDepthGet(USBD_DRV  *p_drv,
+                                              CPU_INT08U  ep_addr);
+
 
 /*
 *********************************************************************************************************
@@ -188,6 +191,7 @@ USBD_DRV_API  USBD_DrvAPI_Template = { USBD_DrvInit,
                                        USBD_DrvEP_Abort,
                                        USBD_DrvEP_Stall,
                                        USBD_DrvISR_Handler,
+                                       USBD_DrvEP_QueueDepthGet,
 };
 
 
@@ -844,3 +848,34 @@ static  void  USBD_DrvISR_Handler (USBD_DRV  *p_drv)
 {
     (void)p_drv;
 }
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_DrvEP_QueueDepthGet()
+*
+* Description : Get the number of transfers the controller can hold at once on endpoint.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+*               ep_addr     Endpoint address.
+*
+* Return(s)   : Number of transfers that can be submitted on the endpoint before the first completes.
+*
+* Note(s)     : (1) This function is optional and may be set to DEF_NULL in the driver API structure.
+*                   The core then submits a single transfer at a time on each endpoint.
+*
+*               (2) A driver returning more than one MUST accept several calls to EP_RxStart()/EP_Tx()/
+*                   EP_TxStart() on the same endpoint before the first transfer completes, and MUST
+*                   report the completions in submission order.
+*********************************************************************************************************
+*/
+
+static  CPU_INT08U  USBD_DrvEP_QueueDepthGet (USBD_DRV    *p_drv,
+                                              CPU_INT08U   ep_addr)
+{
+    (void)p_drv;
+    (void)ep_addr;
+
+    return (1u);
+}
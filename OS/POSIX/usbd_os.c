@@ -0,0 +1,1439 @@
+/*
+*********************************************************************************************************
+*                                            uC/USB-Device
+*                                    The Embedded USB Device Stack
+*
+*                    Copyright 2004-2021 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*
+*                                   USB DEVICE OPERATING SYSTEM LAYER
+*                                                POSIX
+*
+* Filename : usbd_os.c
+* Version  : V4.06.01
+*********************************************************************************************************
+* Note(s)  : (1) This port runs the stack on top of POSIX threads so that it can be exercised on a host
+*                (e.g. with a simulated device controller driver). It relies on :
+*
+*                (a) pthread mutexes & condition variables for semaphores, locks & message queues;
+*                (b) CLOCK_MONOTONIC for every timeout & delay, so that wall-clock adjustments never
+*                    shorten or extend a wait;
+*                (c) uC/CPU's POSIX port for CPU_CRITICAL_ENTER()/CPU_CRITICAL_EXIT(), which are used
+*                    by the core to protect data shared with the driver's ISR context.
+*
+*            (2) Task priorities #define'd in 'app_cfg.h' are NOT used : every task is created as a
+*                regular thread with the default scheduling policy of the process.
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#ifndef  _GNU_SOURCE
+#define  _GNU_SOURCE                                            /* Required for pthread_setname_np().                   */
+#endif
+
+#define    MICRIUM_SOURCE
+#include  <app_cfg.h>
+#include  "../../Source/usbd_core.h"
+#include  "../../Source/usbd_internal.h"
+#include  "usbd_os_posix.h"
+#include  <lib_mem.h>
+#include  <lib_str.h>
+#include  <errno.h>
+#if (USBD_CFG_CAPTURE_EN == DEF_ENABLED)
+#include  <stdio.h>
+#endif
+#include  <limits.h>
+#include  <time.h>
+
+
+/*
+*********************************************************************************************************
+*                                        CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+#ifndef  USBD_OS_CFG_CORE_TASK_STK_SIZE
+#error  "USBD_OS_CFG_CORE_TASK_STK_SIZE not #define'd in 'app_cfg.h' [MUST be > 0]"
+#endif
+
+#if     (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
+#ifndef  USBD_OS_CFG_TRACE_TASK_STK_SIZE
+#error  "USBD_OS_CFG_TRACE_TASK_STK_SIZE not #define'd in 'app_cfg.h' [MUST be > 0]"
+#endif
+#endif
+                                                                /* Direct cmpl unsupported (see 'usbd_cfg.h' Note #2c). */
+#if     (USBD_CFG_EP_DIRECT_CMPL_EN == DEF_ENABLED)
+#error  "USBD_CFG_EP_DIRECT_CMPL_EN illegally #define'd in 'usbd_cfg.h' [MUST be DEF_DISABLED with POSIX port]"
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL DEFINES
+*********************************************************************************************************
+*/
+
+#define  USBD_OS_POSIX_TASK_NAME_LEN_MAX                  15u   /* Max len of thread name, excluding NULL char.         */
+
+#define  USBD_OS_POSIX_NSEC_PER_SEC              1000000000L
+#define  USBD_OS_POSIX_NSEC_PER_MSEC                1000000L
+
+#define  USBD_OS_POSIX_CAPTURE_BUF_LEN                  4096u   /* Len of capture dump rd buf.                          */
+
+
+/*
+*********************************************************************************************************
+*                                           LOCAL CONSTANTS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                          LOCAL DATA TYPES
+*********************************************************************************************************
+*/
+
+typedef  struct  usbd_os_posix_task {
+    USBD_OS_POSIX_TASK_FNCT   FnctPtr;                          /* Task fnct.                                           */
+    void                     *ArgPtr;                           /* Task fnct arg.                                       */
+} USBD_OS_POSIX_TASK;
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL TABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                       LOCAL GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+static  USBD_OS_POSIX_Q    USBD_OS_CoreEventQTbl[USBD_CORE_TASK_NBR];
+
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
+static  USBD_OS_POSIX_SEM  USBD_OS_TraceSem;
+#endif
+
+static  USBD_OS_POSIX_SEM  USBD_OS_EP_SemTbl[USBD_CFG_MAX_NBR_DEV][USBD_CFG_MAX_NBR_EP_OPEN];
+static  USBD_OS_POSIX_SEM  USBD_OS_EP_LockTbl[USBD_CFG_MAX_NBR_DEV][USBD_CFG_MAX_NBR_EP_OPEN];
+
+
+/*
+*********************************************************************************************************
+*                                            LOCAL MACRO'S
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                      LOCAL FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+static  void         USBD_OS_CoreTask          (void               *p_arg);
+
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
+static  void         USBD_OS_TraceTask         (void               *p_arg);
+#endif
+
+static  void        *USBD_OS_POSIX_TaskStart   (void               *p_arg);
+
+static  CPU_BOOLEAN  USBD_OS_POSIX_CondInit    (pthread_cond_t     *p_cond);
+
+static  void         USBD_OS_POSIX_AbsTimeGet  (CPU_INT32U          timeout_ms,
+                                                struct  timespec   *p_ts);
+
+static  int          USBD_OS_POSIX_CondWait    (pthread_cond_t     *p_cond,
+                                                pthread_mutex_t    *p_mutex,
+                                                CPU_INT32U          timeout_ms,
+                                                struct  timespec   *p_ts);
+
+
+/*
+*********************************************************************************************************
+*                                           USBD_OS_Init()
+*
+* Description : Initialize OS interface.
+*
+* Argument(s) : p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE           OS initialization successful.
+*                               USBD_ERR_OS_INIT_FAIL   OS objects NOT successfully initialized.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_OS_Init (USBD_ERR  *p_err)
+{
+    CPU_INT08U  task_ix;
+    USBD_ERR    err;
+
+
+    for (task_ix = 0u; task_ix < USBD_CORE_TASK_NBR; task_ix++) {
+        USBD_OS_POSIX_QCreate(&USBD_OS_CoreEventQTbl[task_ix],
+                               USBD_CORE_TASK_EVENT_NBR,
+                              &err);
+        if (err != USBD_ERR_NONE) {
+           *p_err = USBD_ERR_OS_INIT_FAIL;
+            return;
+        }
+    }
+
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
+    USBD_OS_POSIX_SemCreate(&USBD_OS_TraceSem, 0u, &err);
+    if (err != USBD_ERR_NONE) {
+       *p_err = USBD_ERR_OS_INIT_FAIL;
+        return;
+    }
+#endif
+
+    for (task_ix = 0u; task_ix < USBD_CORE_TASK_NBR; task_ix++) {
+        USBD_OS_POSIX_TaskCreate("USB Core Task",
+                                  USBD_OS_CoreTask,
+                         (void *)(CPU_ADDR)task_ix,
+                                  USBD_OS_CFG_CORE_TASK_STK_SIZE,
+                                 &err);
+        if (err != USBD_ERR_NONE) {
+           *p_err = USBD_ERR_OS_INIT_FAIL;
+            return;
+        }
+    }
+
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
+    USBD_OS_POSIX_TaskCreate("USB Trace Task",
+                              USBD_OS_TraceTask,
+                     (void *) 0,
+                              USBD_OS_CFG_TRACE_TASK_STK_SIZE,
+                             &err);
+    if (err != USBD_ERR_NONE) {
+       *p_err = USBD_ERR_OS_INIT_FAIL;
+        return;
+    }
+#endif
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_OS_CoreTask()
+*
+* Description : OS-dependent shell task to process USB core events.
+*
+* Argument(s) : p_arg       Index of the core task.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  void  USBD_OS_CoreTask (void  *p_arg)
+{
+    CPU_INT08U  task_ix;
+
+
+    task_ix = (CPU_INT08U)(CPU_ADDR)p_arg;
+
+    while (DEF_ON) {
+        USBD_CoreTaskHandler(task_ix);
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_OS_TraceTask()
+*
+* Description : OS-dependent shell task to process debug events.
+*
+* Argument(s) : p_arg       Pointer to task initialization argument.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
+static  void  USBD_OS_TraceTask (void  *p_arg)
+{
+    (void)p_arg;
+
+    while (DEF_ON) {
+        USBD_DbgTaskHandler();
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_OS_SignalCreate()
+*
+* Description : Create an OS signal.
+*
+* Argument(s) : dev_nbr     Device number.
+*               -------     Argument validated by the caller(s).
+*
+*               ep_ix       Endpoint index.
+*               -----       Argument validated by the caller(s).
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE               OS signal     successfully created.
+*                               USBD_ERR_OS_SIGNAL_CREATE   OS signal NOT successfully created.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_OS_EP_SignalCreate (CPU_INT08U   dev_nbr,
+                               CPU_INT08U   ep_ix,
+                               USBD_ERR    *p_err)
+{
+    USBD_ERR  err;
+
+
+    USBD_OS_POSIX_SemCreate(&USBD_OS_EP_SemTbl[dev_nbr][ep_ix], 0u, &err);
+    if (err != USBD_ERR_NONE) {
+       *p_err = USBD_ERR_OS_SIGNAL_CREATE;
+    } else {
+       *p_err = USBD_ERR_NONE;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_OS_SignalDel()
+*
+* Description : Delete an OS signal.
+*
+* Argument(s) : dev_nbr     Device number.
+*               -------     Argument validated by the caller(s).
+*
+*               ep_ix       Endpoint index.
+*               -----       Argument validated by the caller(s).
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_OS_EP_SignalDel (CPU_INT08U  dev_nbr,
+                            CPU_INT08U  ep_ix)
+{
+    USBD_OS_POSIX_SemDel(&USBD_OS_EP_SemTbl[dev_nbr][ep_ix]);
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_OS_SignalPend()
+*
+* Description : Wait for a signal to become available.
+*
+* Argument(s) : dev_nbr     Device number.
+*               -------     Argument validated by the caller(s).
+*
+*               ep_ix       Endpoint index.
+*               -----       Argument validated by the caller(s).
+*
+*               timeout_ms  Signal wait timeout in milliseconds.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE           OS signal     successfully acquired.
+*                               USBD_ERR_OS_TIMEOUT     OS signal NOT successfully acquired in the time
+*                                                           specified by 'timeout_ms'.
+*                               USBD_ERR_OS_ABORT       OS signal aborted.
+*                               USBD_ERR_OS_FAIL        OS signal not acquired because another error.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_OS_EP_SignalPend (CPU_INT08U   dev_nbr,
+                             CPU_INT08U   ep_ix,
+                             CPU_INT16U   timeout_ms,
+                             USBD_ERR    *p_err)
+{
+    USBD_OS_POSIX_SemPend(&USBD_OS_EP_SemTbl[dev_nbr][ep_ix],
+                           timeout_ms,
+                           p_err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_OS_SignalAbort()
+*
+* Description : Abort any wait operation on signal.
+*
+* Argument(s) : dev_nbr     Device number.
+*               -------     Argument validated by the caller(s).
+*
+*               ep_ix       Endpoint index.
+*               -----       Argument validated by the caller(s).
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE       OS signal     successfully aborted.
+*                               USBD_ERR_OS_FAIL    OS signal NOT successfully aborted.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_OS_EP_SignalAbort (CPU_INT08U   dev_nbr,
+                              CPU_INT08U   ep_ix,
+                              USBD_ERR    *p_err)
+{
+    USBD_OS_POSIX_SemPendAbort(&USBD_OS_EP_SemTbl[dev_nbr][ep_ix]);
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_OS_SignalPost()
+*
+* Description : Make a signal available.
+*
+* Argument(s) : dev_nbr     Device number.
+*               -------     Argument validated by the caller(s).
+*
+*               ep_ix       Endpoint index.
+*               -----       Argument validated by the caller(s).
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE       OS signal     successfully readied.
+*                               USBD_ERR_OS_FAIL    OS signal NOT successfully readied.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_OS_EP_SignalPost (CPU_INT08U   dev_nbr,
+                             CPU_INT08U   ep_ix,
+                             USBD_ERR    *p_err)
+{
+    USBD_OS_POSIX_SemPost(&USBD_OS_EP_SemTbl[dev_nbr][ep_ix], p_err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_OS_EP_LockCreate()
+*
+* Description : Create an OS resource to use as an endpoint lock.
+*
+* Argument(s) : dev_nbr     Device number.
+*               -------     Argument validated by the caller(s).
+*
+*               ep_ix       Endpoint index.
+*               -----       Argument validated by the caller(s).
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE               OS lock     successfully created.
+*                               USBD_ERR_OS_SIGNAL_CREATE   OS lock NOT successfully created.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) The lock is a binary semaphore rather than a pthread mutex : the lock may be acquired
+*                   with a timeout & is released by the core task on behalf of the application task that
+*                   acquired it, which a pthread mutex does not allow.
+*********************************************************************************************************
+*/
+
+void   USBD_OS_EP_LockCreate (CPU_INT08U   dev_nbr,
+                              CPU_INT08U   ep_ix,
+                              USBD_ERR    *p_err)
+{
+    USBD_ERR  err;
+
+
+    USBD_OS_POSIX_SemCreate(&USBD_OS_EP_LockTbl[dev_nbr][ep_ix], 1u, &err);
+    if (err != USBD_ERR_NONE) {
+       *p_err = USBD_ERR_OS_SIGNAL_CREATE;
+    } else {
+       *p_err = USBD_ERR_NONE;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_OS_EP_LockDel()
+*
+* Description : Delete the OS resource used as an endpoint lock.
+*
+* Argument(s) : dev_nbr     Device number.
+*               -------     Argument validated by the caller(s).
+*
+*               ep_ix       Endpoint index.
+*               -----       Argument validated by the caller(s).
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void   USBD_OS_EP_LockDel (CPU_INT08U  dev_nbr,
+                           CPU_INT08U  ep_ix)
+{
+    USBD_OS_POSIX_SemDel(&USBD_OS_EP_LockTbl[dev_nbr][ep_ix]);
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_OS_EP_LockAcquire()
+*
+* Description : Wait for an endpoint to become available and acquire its lock.
+*
+* Argument(s) : dev_nbr     Device number.
+*               -------     Argument validated by the caller(s).
+*
+*               ep_ix       Endpoint index.
+*               -----       Argument validated by the caller(s).
+*
+*               timeout_ms  Lock wait timeout in milliseconds.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE           OS lock     successfully acquired.
+*                               USBD_ERR_OS_TIMEOUT     OS lock NOT successfully acquired in the time
+*                                                           specified by 'timeout_ms'.
+*                               USBD_ERR_OS_ABORT       OS lock aborted.
+*                               USBD_ERR_OS_FAIL        OS lock not acquired because another error.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void   USBD_OS_EP_LockAcquire (CPU_INT08U   dev_nbr,
+                               CPU_INT08U   ep_ix,
+                               CPU_INT16U   timeout_ms,
+                               USBD_ERR    *p_err)
+{
+    USBD_OS_POSIX_SemPend(&USBD_OS_EP_LockTbl[dev_nbr][ep_ix],
+                           timeout_ms,
+                           p_err);
+}
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_OS_EP_LockRelease()
+*
+* Description : Release an endpoint lock.
+*
+* Argument(s) : dev_nbr     Device number.
+*               -------     Argument validated by the caller(s).
+*
+*               ep_ix       Endpoint index.
+*               -----       Argument validated by the caller(s).
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void   USBD_OS_EP_LockRelease (CPU_INT08U  dev_nbr,
+                               CPU_INT08U  ep_ix)
+{
+    USBD_ERR  err;
+
+
+    USBD_OS_POSIX_SemPost(&USBD_OS_EP_LockTbl[dev_nbr][ep_ix], &err);
+    (void)err;
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_OS_DlyMs()
+*
+* Description : Delay a task for a certain time.
+*
+* Argument(s) : ms          Delay in milliseconds.
+*
+* Return(s)   : None.
+*
+* Note(s)     : (1) The delay is measured against CLOCK_MONOTONIC & resumed when interrupted by a signal.
+*********************************************************************************************************
+*/
+
+void  USBD_OS_DlyMs (CPU_INT32U  ms)
+{
+    struct  timespec  ts;
+    int               res;
+
+
+    USBD_OS_POSIX_AbsTimeGet(ms, &ts);
+
+    do {
+        res = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, DEF_NULL);
+    } while (res == EINTR);
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_OS_CoreEventGet()
+*
+* Description : Wait until a core event is ready.
+*
+* Argument(s) : task_ix     Index of the core task.
+*
+*               timeout_ms  Timeout in milliseconds.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE           Core event successfully obtained.
+*                               USBD_ERR_OS_TIMEOUT     Core event NOT ready and a timeout occurred.
+*                               USBD_ERR_OS_ABORT       Core event was aborted.
+*                               USBD_ERR_OS_FAIL        Core event NOT ready because of another error.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  *USBD_OS_CoreEventGet (CPU_INT08U   task_ix,
+                             CPU_INT32U   timeout_ms,
+                             USBD_ERR    *p_err)
+{
+    void  *p_msg;
+
+
+    p_msg = USBD_OS_POSIX_QPend(&USBD_OS_CoreEventQTbl[task_ix],
+                                 timeout_ms,
+                                 p_err);
+
+    return (p_msg);
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_OS_CoreEventPut()
+*
+* Description : Queues core event.
+*
+* Argument(s) : task_ix     Index of the core task.
+*
+*               p_event     Pointer to core event.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_OS_CoreEventPut (CPU_INT08U   task_ix,
+                            void        *p_event)
+{
+    USBD_ERR  err;
+
+
+    USBD_OS_POSIX_QPost(&USBD_OS_CoreEventQTbl[task_ix],
+                         p_event,
+                        &err);
+    (void)err;
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_OS_DbgEventRdy()
+*
+* Description : Signals that a trace event is ready for processing.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
+void  USBD_OS_DbgEventRdy (void)
+{
+    USBD_ERR  err;
+
+
+    USBD_OS_POSIX_SemPost(&USBD_OS_TraceSem, &err);
+    (void)err;
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_OS_DbgEventWait()
+*
+* Description : Waits until a trace event is available.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
+void  USBD_OS_DbgEventWait (void)
+{
+    USBD_ERR  err;
+
+
+    USBD_OS_POSIX_SemPend(&USBD_OS_TraceSem, 0u, &err);
+    (void)err;
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_OS_POSIX_TaskCreate()
+*
+* Description : Create a task running in its own detached thread.
+*
+* Argument(s) : p_name      Pointer to task name.
+*
+*               p_fnct      Pointer to task function.
+*
+*               p_arg       Pointer to task function argument.
+*
+*               stk_size    Task stack size, in CPU_STK elements.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE       Task successfully created.
+*                               USBD_ERR_ALLOC      Task context could NOT be allocated.
+*                               USBD_ERR_OS_FAIL    Thread   could NOT be created.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) The stack size is expressed in CPU_STK elements, as for the other OS ports, so that the
+*                   same 'app_cfg.h' values can be used. It is raised to PTHREAD_STACK_MIN if smaller.
+*
+*               (2) The task name is truncated to the length supported by pthread_setname_np() & is only
+*                   used to identify the thread in debuggers & profilers.
+*********************************************************************************************************
+*/
+
+void  USBD_OS_POSIX_TaskCreate (const  CPU_CHAR                 *p_name,
+                                       USBD_OS_POSIX_TASK_FNCT   p_fnct,
+                                       void                     *p_arg,
+                                       CPU_INT32U                stk_size,
+                                       USBD_ERR                 *p_err)
+{
+    USBD_OS_POSIX_TASK  *p_task;
+    pthread_t            thread;
+    pthread_attr_t       attr;
+    size_t               stk_size_bytes;
+    CPU_CHAR             name[USBD_OS_POSIX_TASK_NAME_LEN_MAX + 1u];
+    CPU_SIZE_T           reqd_octets;
+    LIB_ERR              err_lib;
+    int                  res;
+
+
+    p_task = (USBD_OS_POSIX_TASK *)Mem_HeapAlloc(sizeof(USBD_OS_POSIX_TASK),
+                                                 sizeof(CPU_ALIGN),
+                                                &reqd_octets,
+                                                &err_lib);
+    if (p_task == DEF_NULL) {
+       *p_err = USBD_ERR_ALLOC;
+        return;
+    }
+
+    p_task->FnctPtr = p_fnct;
+    p_task->ArgPtr  = p_arg;
+
+    stk_size_bytes = (size_t)stk_size * sizeof(CPU_STK);        /* See Note #1.                                         */
+    if (stk_size_bytes < (size_t)PTHREAD_STACK_MIN) {
+        stk_size_bytes = (size_t)PTHREAD_STACK_MIN;
+    }
+
+    if (pthread_attr_init(&attr) != 0) {
+       *p_err = USBD_ERR_OS_FAIL;
+        return;
+    }
+
+    (void)pthread_attr_setstacksize(&attr, stk_size_bytes);
+    (void)pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    res = pthread_create(&thread, &attr, USBD_OS_POSIX_TaskStart, (void *)p_task);
+    (void)pthread_attr_destroy(&attr);
+    if (res != 0) {
+       *p_err = USBD_ERR_OS_FAIL;
+        return;
+    }
+
+#ifdef  __linux__                                               /* See Note #2.                                         */
+    (void)Str_Copy_N(name, p_name, USBD_OS_POSIX_TASK_NAME_LEN_MAX);
+    name[USBD_OS_POSIX_TASK_NAME_LEN_MAX] = '\0';
+    (void)pthread_setname_np(thread, name);
+#else
+    (void)name;
+    (void)p_name;
+#endif
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_OS_POSIX_SemCreate()
+*
+* Description : Create a counting semaphore.
+*
+* Argument(s) : p_sem       Pointer to semaphore.
+*
+*               cnt         Initial semaphore count.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE       Semaphore     successfully created.
+*                               USBD_ERR_OS_FAIL    Semaphore NOT successfully created.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) See 'usbd_os_posix.h  SEMAPHORE DATA TYPE  Note #2'.
+*********************************************************************************************************
+*/
+
+void  USBD_OS_POSIX_SemCreate (USBD_OS_POSIX_SEM  *p_sem,
+                               CPU_INT32U          cnt,
+                               USBD_ERR           *p_err)
+{
+    CPU_BOOLEAN  ok;
+
+
+    if (p_sem->InitDone == DEF_NO) {                            /* See Note #1.                                         */
+        if (pthread_mutex_init(&p_sem->Mutex, DEF_NULL) != 0) {
+           *p_err = USBD_ERR_OS_FAIL;
+            return;
+        }
+
+        ok = USBD_OS_POSIX_CondInit(&p_sem->Cond);
+        if (ok != DEF_OK) {
+            (void)pthread_mutex_destroy(&p_sem->Mutex);
+           *p_err = USBD_ERR_OS_FAIL;
+            return;
+        }
+
+        p_sem->AbortCtr = 0u;
+        p_sem->InitDone = DEF_YES;
+    }
+
+    (void)pthread_mutex_lock(&p_sem->Mutex);
+    p_sem->Cnt = cnt;
+    (void)pthread_mutex_unlock(&p_sem->Mutex);
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_OS_POSIX_SemDel()
+*
+* Description : Delete a semaphore.
+*
+* Argument(s) : p_sem       Pointer to semaphore.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Tasks pending on the semaphore are aborted & the count is cleared. The mutex & the
+*                   condition variable are kept for a later creation of the same semaphore.
+*********************************************************************************************************
+*/
+
+void  USBD_OS_POSIX_SemDel (USBD_OS_POSIX_SEM  *p_sem)
+{
+    if (p_sem->InitDone == DEF_NO) {
+        return;
+    }
+
+    (void)pthread_mutex_lock(&p_sem->Mutex);
+    p_sem->Cnt = 0u;
+    p_sem->AbortCtr++;
+    (void)pthread_cond_broadcast(&p_sem->Cond);
+    (void)pthread_mutex_unlock(&p_sem->Mutex);
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_OS_POSIX_SemPend()
+*
+* Description : Wait for a semaphore to become available.
+*
+* Argument(s) : p_sem       Pointer to semaphore.
+*
+*               timeout_ms  Timeout in milliseconds, 0 to wait forever.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE           Semaphore     successfully acquired.
+*                               USBD_ERR_OS_TIMEOUT     Semaphore NOT successfully acquired in the time
+*                                                           specified by 'timeout_ms'.
+*                               USBD_ERR_OS_ABORT       Semaphore pend aborted.
+*                               USBD_ERR_OS_FAIL        Semaphore not acquired because another error.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_OS_POSIX_SemPend (USBD_OS_POSIX_SEM  *p_sem,
+                             CPU_INT32U          timeout_ms,
+                             USBD_ERR           *p_err)
+{
+    struct  timespec  ts;
+    CPU_INT32U        abort_ctr;
+    int               res;
+
+
+    if (timeout_ms != 0u) {
+        USBD_OS_POSIX_AbsTimeGet(timeout_ms, &ts);
+    }
+
+    (void)pthread_mutex_lock(&p_sem->Mutex);
+
+    abort_ctr = p_sem->AbortCtr;
+    res       = 0;
+    while ((p_sem->Cnt      == 0u)        &&
+           (p_sem->AbortCtr == abort_ctr) &&
+           (res             == 0)) {
+        res = USBD_OS_POSIX_CondWait(&p_sem->Cond,
+                                     &p_sem->Mutex,
+                                      timeout_ms,
+                                     &ts);
+    }
+
+    if (p_sem->AbortCtr != abort_ctr) {
+       *p_err = USBD_ERR_OS_ABORT;
+    } else if (p_sem->Cnt > 0u) {
+        p_sem->Cnt--;
+       *p_err = USBD_ERR_NONE;
+    } else if (res == ETIMEDOUT) {
+       *p_err = USBD_ERR_OS_TIMEOUT;
+    } else {
+       *p_err = USBD_ERR_OS_FAIL;
+    }
+
+    (void)pthread_mutex_unlock(&p_sem->Mutex);
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_OS_POSIX_SemPost()
+*
+* Description : Make a semaphore available.
+*
+* Argument(s) : p_sem       Pointer to semaphore.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE       Semaphore     successfully posted.
+*                               USBD_ERR_OS_FAIL    Semaphore NOT successfully posted.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_OS_POSIX_SemPost (USBD_OS_POSIX_SEM  *p_sem,
+                             USBD_ERR           *p_err)
+{
+    if (pthread_mutex_lock(&p_sem->Mutex) != 0) {
+       *p_err = USBD_ERR_OS_FAIL;
+        return;
+    }
+
+    if (p_sem->Cnt == DEF_INT_32U_MAX_VAL) {
+        (void)pthread_mutex_unlock(&p_sem->Mutex);
+       *p_err = USBD_ERR_OS_FAIL;
+        return;
+    }
+
+    p_sem->Cnt++;
+    (void)pthread_cond_signal(&p_sem->Cond);
+    (void)pthread_mutex_unlock(&p_sem->Mutex);
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_OS_POSIX_SemPendAbort()
+*
+* Description : Abort every wait operation on a semaphore.
+*
+* Argument(s) : p_sem       Pointer to semaphore.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_OS_POSIX_SemPendAbort (USBD_OS_POSIX_SEM  *p_sem)
+{
+    (void)pthread_mutex_lock(&p_sem->Mutex);
+    p_sem->AbortCtr++;
+    (void)pthread_cond_broadcast(&p_sem->Cond);
+    (void)pthread_mutex_unlock(&p_sem->Mutex);
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_OS_POSIX_QCreate()
+*
+* Description : Create a message queue.
+*
+* Argument(s) : p_q         Pointer to message queue.
+*
+*               size        Maximum number of messages in queue.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE       Message queue     successfully created.
+*                               USBD_ERR_ALLOC      Message buffer could NOT be allocated.
+*                               USBD_ERR_OS_FAIL    Message queue NOT successfully created.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) The message buffer is allocated from the heap & a queue can NOT be deleted.
+*********************************************************************************************************
+*/
+
+void  USBD_OS_POSIX_QCreate (USBD_OS_POSIX_Q  *p_q,
+                             CPU_INT32U        size,
+                             USBD_ERR         *p_err)
+{
+    CPU_SIZE_T   reqd_octets;
+    CPU_BOOLEAN  ok;
+    LIB_ERR      err_lib;
+
+
+    p_q->BufPtr = (void **)Mem_HeapAlloc(size * sizeof(void *),
+                                         sizeof(void *),
+                                        &reqd_octets,
+                                        &err_lib);
+    if (p_q->BufPtr == DEF_NULL) {
+       *p_err = USBD_ERR_ALLOC;
+        return;
+    }
+
+    if (pthread_mutex_init(&p_q->Mutex, DEF_NULL) != 0) {
+       *p_err = USBD_ERR_OS_FAIL;
+        return;
+    }
+
+    ok = USBD_OS_POSIX_CondInit(&p_q->Cond);
+    if (ok != DEF_OK) {
+        (void)pthread_mutex_destroy(&p_q->Mutex);
+       *p_err = USBD_ERR_OS_FAIL;
+        return;
+    }
+
+    p_q->Size  = size;
+    p_q->Cnt   = 0u;
+    p_q->IxIn  = 0u;
+    p_q->IxOut = 0u;
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_OS_POSIX_QPost()
+*
+* Description : Post a message at the end of a message queue.
+*
+* Argument(s) : p_q         Pointer to message queue.
+*
+*               p_msg       Pointer to message.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE       Message     successfully posted.
+*                               USBD_ERR_OS_FAIL    Message NOT successfully posted (queue full).
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_OS_POSIX_QPost (USBD_OS_POSIX_Q  *p_q,
+                           void             *p_msg,
+                           USBD_ERR         *p_err)
+{
+    (void)pthread_mutex_lock(&p_q->Mutex);
+
+    if (p_q->Cnt >= p_q->Size) {
+        (void)pthread_mutex_unlock(&p_q->Mutex);
+       *p_err = USBD_ERR_OS_FAIL;
+        return;
+    }
+
+    p_q->BufPtr[p_q->IxIn] = p_msg;
+    p_q->IxIn++;
+    if (p_q->IxIn >= p_q->Size) {
+        p_q->IxIn = 0u;
+    }
+    p_q->Cnt++;
+
+    (void)pthread_cond_signal(&p_q->Cond);
+    (void)pthread_mutex_unlock(&p_q->Mutex);
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_OS_POSIX_QPend()
+*
+* Description : Wait for a message to be available in a message queue.
+*
+* Argument(s) : p_q         Pointer to message queue.
+*
+*               timeout_ms  Timeout in milliseconds, 0 to wait forever.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE           Message successfully obtained.
+*                               USBD_ERR_OS_TIMEOUT     Message NOT available and a timeout occurred.
+*                               USBD_ERR_OS_FAIL        Message NOT available because of another error.
+*
+* Return(s)   : Pointer to message, if NO error(s).
+*
+*               Null pointer,       otherwise.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  *USBD_OS_POSIX_QPend (USBD_OS_POSIX_Q  *p_q,
+                            CPU_INT32U        timeout_ms,
+                            USBD_ERR         *p_err)
+{
+    struct  timespec   ts;
+    void              *p_msg;
+    int                res;
+
+
+    if (timeout_ms != 0u) {
+        USBD_OS_POSIX_AbsTimeGet(timeout_ms, &ts);
+    }
+
+    (void)pthread_mutex_lock(&p_q->Mutex);
+
+    res = 0;
+    while ((p_q->Cnt == 0u) &&
+           (res      == 0)) {
+        res = USBD_OS_POSIX_CondWait(&p_q->Cond,
+                                     &p_q->Mutex,
+                                      timeout_ms,
+                                     &ts);
+    }
+
+    if (p_q->Cnt > 0u) {
+        p_msg = p_q->BufPtr[p_q->IxOut];
+        p_q->IxOut++;
+        if (p_q->IxOut >= p_q->Size) {
+            p_q->IxOut = 0u;
+        }
+        p_q->Cnt--;
+       *p_err = USBD_ERR_NONE;
+    } else {
+        p_msg = DEF_NULL;
+       *p_err = (res == ETIMEDOUT) ? USBD_ERR_OS_TIMEOUT : USBD_ERR_OS_FAIL;
+    }
+
+    (void)pthread_mutex_unlock(&p_q->Mutex);
+
+    return (p_msg);
+}
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_OS_POSIX_CaptureDump()
+*
+* Description : Append the content of the traffic capture ring to a pcap file.
+*
+* Argument(s) : p_file_name Name of the capture file.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE       Capture ring successfully drained.
+*                               USBD_ERR_NULL_PTR   Null file name.
+*                               USBD_ERR_FAIL       File could not be opened or written.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) The pcap file header is written only if the file is empty, so that the function can be
+*                   called periodically with the same file name to build a single capture.
+*
+*               (2) The function stops at the first write error. The data read from the ring for that write
+*                   is lost & the file is left with a truncated record.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_CAPTURE_EN == DEF_ENABLED)
+void  USBD_OS_POSIX_CaptureDump (const  CPU_CHAR  *p_file_name,
+                                        USBD_ERR  *p_err)
+{
+    FILE        *p_file;
+    CPU_INT08U   buf[USBD_OS_POSIX_CAPTURE_BUF_LEN];
+    CPU_INT32U   len;
+    long         pos;
+    USBD_ERR     err;
+
+
+    if (p_file_name == (const CPU_CHAR *)0) {
+       *p_err = USBD_ERR_NULL_PTR;
+        return;
+    }
+
+    p_file = fopen((const char *)p_file_name, "ab");
+    if (p_file == (FILE *)0) {
+       *p_err = USBD_ERR_FAIL;
+        return;
+    }
+
+   *p_err = USBD_ERR_NONE;
+
+    (void)fseek(p_file, 0L, SEEK_END);
+    pos = ftell(p_file);
+    if (pos == 0L) {                                            /* Empty file: wr file hdr first (see Note #1).         */
+        len = USBD_CaptureFileHdrGet(buf, sizeof(buf), &err);
+        if (fwrite(buf, 1u, len, p_file) != len) {
+           *p_err = USBD_ERR_FAIL;
+        }
+    } else if (pos < 0L) {
+       *p_err = USBD_ERR_FAIL;
+    }
+
+    while (*p_err == USBD_ERR_NONE) {                          /* Drain the ring.                                      */
+        len = USBD_CaptureRd(buf, sizeof(buf), &err);
+        if (len == 0u) {
+            break;
+        }
+        if (fwrite(buf, 1u, len, p_file) != len) {              /* See Note #2.                                         */
+           *p_err = USBD_ERR_FAIL;
+        }
+    }
+
+    if (fclose(p_file) != 0) {
+       *p_err = USBD_ERR_FAIL;
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*********************************************************************************************************
+*                                           LOCAL FUNCTIONS
+*********************************************************************************************************
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                      USBD_OS_POSIX_TaskStart()
+*
+* Description : Thread entry point; call the task function with its argument.
+*
+* Argument(s) : p_arg       Pointer to task context.
+*
+* Return(s)   : Null pointer.
+*
+* Note(s)     : (1) The task context is allocated from the heap & is never freed, as task functions never
+*                   return.
+*********************************************************************************************************
+*/
+
+static  void  *USBD_OS_POSIX_TaskStart (void  *p_arg)
+{
+    USBD_OS_POSIX_TASK  *p_task;
+
+
+    p_task = (USBD_OS_POSIX_TASK *)p_arg;
+
+    p_task->FnctPtr(p_task->ArgPtr);
+
+    return (DEF_NULL);
+}
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_OS_POSIX_CondInit()
+*
+* Description : Initialize a condition variable using the monotonic clock for timed waits.
+*
+* Argument(s) : p_cond      Pointer to condition variable.
+*
+* Return(s)   : DEF_OK,   if condition variable successfully initialized.
+*
+*               DEF_FAIL, otherwise.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  CPU_BOOLEAN  USBD_OS_POSIX_CondInit (pthread_cond_t  *p_cond)
+{
+    pthread_condattr_t  attr;
+    int                 res;
+
+
+    if (pthread_condattr_init(&attr) != 0) {
+        return (DEF_FAIL);
+    }
+
+    res = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    if (res == 0) {
+        res = pthread_cond_init(p_cond, &attr);
+    }
+
+    (void)pthread_condattr_destroy(&attr);
+
+    return ((res == 0) ? DEF_OK : DEF_FAIL);
+}
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_OS_POSIX_AbsTimeGet()
+*
+* Description : Compute the absolute monotonic time at which a timeout expires.
+*
+* Argument(s) : timeout_ms  Timeout in milliseconds.
+*
+*               p_ts        Pointer to variable that will receive the expiration time.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  void  USBD_OS_POSIX_AbsTimeGet (CPU_INT32U         timeout_ms,
+                                        struct  timespec  *p_ts)
+{
+    (void)clock_gettime(CLOCK_MONOTONIC, p_ts);
+
+    p_ts->tv_sec  += (time_t)(timeout_ms / 1000u);
+    p_ts->tv_nsec += (long)(timeout_ms % 1000u) * USBD_OS_POSIX_NSEC_PER_MSEC;
+    if (p_ts->tv_nsec >= USBD_OS_POSIX_NSEC_PER_SEC) {
+        p_ts->tv_sec++;
+        p_ts->tv_nsec -= USBD_OS_POSIX_NSEC_PER_SEC;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_OS_POSIX_CondWait()
+*
+* Description : Wait on a condition variable, with or without timeout.
+*
+* Argument(s) : p_cond      Pointer to condition variable.
+*
+*               p_mutex     Pointer to mutex protecting the condition, locked by the caller.
+*
+*               timeout_ms  Timeout in milliseconds, 0 to wait forever.
+*
+*               p_ts        Pointer to absolute expiration time, used only if 'timeout_ms' is not 0.
+*
+* Return(s)   : 0,          if condition variable signaled (or spurious wake-up).
+*
+*               ETIMEDOUT,  if timeout expired.
+*
+*               Other pthread error code, otherwise.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  int  USBD_OS_POSIX_CondWait (pthread_cond_t     *p_cond,
+                                     pthread_mutex_t    *p_mutex,
+                                     CPU_INT32U          timeout_ms,
+                                     struct  timespec   *p_ts)
+{
+    int  res;
+
+
+    if (timeout_ms == 0u) {
+        res = pthread_cond_wait(p_cond, p_mutex);
+    } else {
+        res = pthread_cond_timedwait(p_cond, p_mutex, p_ts);
+    }
+
+    return (res);
+}
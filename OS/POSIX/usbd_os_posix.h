@@ -0,0 +1,185 @@
+/*
+*********************************************************************************************************
+*                                            uC/USB-Device
+*                                    The Embedded USB Device Stack
+*
+*                    Copyright 2004-2021 Silicon Laboratories Inc. www.silabs.com
+*
+*                                 SPDX-License-Identifier: APACHE-2.0
+*
+*               This software is subject to an open source license and is distributed by
+*                Silicon Laboratories Inc. pursuant to the terms of the Apache License,
+*                    Version 2.0 available at www.apache.org/licenses/LICENSE-2.0.
+*
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*
+*                                   USB DEVICE OPERATING SYSTEM LAYER
+*                                                POSIX
+*
+* Filename : usbd_os_posix.h
+* Version  : V4.06.01
+*********************************************************************************************************
+* Note(s)  : (1) This file declares the pthreads-based primitives implemented by the POSIX port of the core
+*                OS layer ('OS/POSIX/usbd_os.c'). They are shared by the POSIX ports of the class OS layers
+*                so that every port relies on the same semaphore, queue and task semantics.
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                               MODULE
+*********************************************************************************************************
+*/
+
+#ifndef  USBD_OS_POSIX_MODULE_PRESENT
+#define  USBD_OS_POSIX_MODULE_PRESENT
+
+
+/*
+*********************************************************************************************************
+*                                            INCLUDE FILES
+*********************************************************************************************************
+*/
+
+#include  "../../Source/usbd_core.h"
+#include  <pthread.h>
+
+
+/*
+*********************************************************************************************************
+*                                               DEFINES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                             DATA TYPES
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                          SEMAPHORE DATA TYPE
+*
+* Note(s) : (1) Pending tasks are aborted by incrementing 'AbortCtr'. A task that observes a different
+*               'AbortCtr' value than the one read when it started pending returns USBD_ERR_OS_ABORT.
+*
+*           (2) The mutex and the condition variable are initialized on the first creation of the
+*               semaphore and are never destroyed, so that a semaphore can be deleted and created again
+*               (e.g. endpoint signals) without re-initializing objects other tasks may still reference.
+*********************************************************************************************************
+*/
+
+typedef  struct  usbd_os_posix_sem {
+    pthread_mutex_t   Mutex;                                    /* Mutex protecting sem state.                          */
+    pthread_cond_t    Cond;                                     /* Cond signaled on post & abort.                       */
+    CPU_INT32U        Cnt;                                      /* Sem cnt.                                             */
+    CPU_INT32U        AbortCtr;                                 /* Pend abort ctr (see Note #1).                        */
+    CPU_BOOLEAN       InitDone;                                 /* Mutex & cond initialized (see Note #2).              */
+} USBD_OS_POSIX_SEM;
+
+
+/*
+*********************************************************************************************************
+*                                        MESSAGE QUEUE DATA TYPE
+*********************************************************************************************************
+*/
+
+typedef  struct  usbd_os_posix_q {
+    pthread_mutex_t   Mutex;                                    /* Mutex protecting q state.                            */
+    pthread_cond_t    Cond;                                     /* Cond signaled on post.                               */
+    void            **BufPtr;                                   /* Ptr to msg ring buf.                                 */
+    CPU_INT32U        Size;                                     /* Max nbr of msgs in q.                                */
+    CPU_INT32U        Cnt;                                      /* Nbr of msgs in q.                                    */
+    CPU_INT32U        IxIn;                                     /* Ix where next msg is posted.                         */
+    CPU_INT32U        IxOut;                                    /* Ix of next msg to retrieve.                          */
+} USBD_OS_POSIX_Q;
+
+
+/*
+*********************************************************************************************************
+*                                       TASK FUNCTION DATA TYPE
+*********************************************************************************************************
+*/
+
+typedef  void  (*USBD_OS_POSIX_TASK_FNCT)(void  *p_arg);
+
+
+/*
+*********************************************************************************************************
+*                                          GLOBAL VARIABLES
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                               MACRO'S
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                         FUNCTION PROTOTYPES
+*********************************************************************************************************
+*/
+
+void   USBD_OS_POSIX_TaskCreate  (const  CPU_CHAR                 *p_name,
+                                         USBD_OS_POSIX_TASK_FNCT   p_fnct,
+                                         void                     *p_arg,
+                                         CPU_INT32U                stk_size,
+                                         USBD_ERR                 *p_err);
+
+void   USBD_OS_POSIX_SemCreate   (       USBD_OS_POSIX_SEM        *p_sem,
+                                         CPU_INT32U                cnt,
+                                         USBD_ERR                 *p_err);
+
+void   USBD_OS_POSIX_SemDel      (       USBD_OS_POSIX_SEM        *p_sem);
+
+void   USBD_OS_POSIX_SemPend     (       USBD_OS_POSIX_SEM        *p_sem,
+                                         CPU_INT32U                timeout_ms,
+                                         USBD_ERR                 *p_err);
+
+void   USBD_OS_POSIX_SemPost     (       USBD_OS_POSIX_SEM        *p_sem,
+                                         USBD_ERR                 *p_err);
+
+void   USBD_OS_POSIX_SemPendAbort(       USBD_OS_POSIX_SEM        *p_sem);
+
+void   USBD_OS_POSIX_QCreate     (       USBD_OS_POSIX_Q          *p_q,
+                                         CPU_INT32U                size,
+                                         USBD_ERR                 *p_err);
+
+void   USBD_OS_POSIX_QPost       (       USBD_OS_POSIX_Q          *p_q,
+                                         void                     *p_msg,
+                                         USBD_ERR                 *p_err);
+
+void  *USBD_OS_POSIX_QPend       (       USBD_OS_POSIX_Q          *p_q,
+                                         CPU_INT32U                timeout_ms,
+                                         USBD_ERR                 *p_err);
+
+#if (USBD_CFG_CAPTURE_EN == DEF_ENABLED)
+void   USBD_OS_POSIX_CaptureDump (const  CPU_CHAR                 *p_file_name,
+                                         USBD_ERR                 *p_err);
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                        CONFIGURATION ERRORS
+*********************************************************************************************************
+*/
+
+
+/*
+*********************************************************************************************************
+*                                             MODULE END
+*********************************************************************************************************
+*/
+
+#endif
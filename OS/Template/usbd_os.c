@@ -93,7 +93,7 @@
 
 static  void  USBD_OS_CoreTask (void  *p_arg);
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 static  void  USBD_OS_TraceTask(void  *p_arg);
 #endif
 
@@ -127,20 +127,24 @@ void  USBD_OS_Init (USBD_ERR  *p_err)
 *
 * Description : OS-dependent shell task to process USB core events.
 *
-* Argument(s) : p_arg       Pointer to task initialization argument (can be removed, depending of the kernel).
+* Argument(s) : p_arg       Index of the core task (see 'usbd_core.h  USB CORE TASKS').
 *
 * Return(s)   : none.
 *
-* Note(s)     : none.
+* Note(s)     : (1) USBD_OS_Init() must create USBD_CORE_TASK_NBR core tasks, each with its own event
+*                   queue, & pass its index to each of them.
 *********************************************************************************************************
 */
 
 static  void  USBD_OS_CoreTask (void  *p_arg)
 {
-    (void)p_arg;
+    CPU_INT08U  task_ix;
+
+
+    task_ix = (CPU_INT08U)(CPU_ADDR)p_arg;
 
     while (DEF_ON) {
-        USBD_CoreTaskHandler();
+        USBD_CoreTaskHandler(task_ix);
     }
 }
 
@@ -159,7 +163,7 @@ static  void  USBD_OS_CoreTask (void  *p_arg)
 *********************************************************************************************************
 */
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 static  void  USBD_OS_TraceTask (void  *p_arg)
 {
     (void)p_arg;
@@ -466,7 +470,9 @@ void  USBD_OS_DlyMs (CPU_INT32U  ms)
 *
 * Description : Wait until a core event is ready.
 *
-* Argument(s) : timeout_ms  Timeout in milliseconds.
+* Argument(s) : task_ix     Index of the core task.
+*
+*               timeout_ms  Timeout in milliseconds.
 *
 *               p_err       Pointer to variable that will receive the return error code from this function :
 *
@@ -481,7 +487,8 @@ void  USBD_OS_DlyMs (CPU_INT32U  ms)
 *********************************************************************************************************
 */
 
-void  *USBD_OS_CoreEventGet (CPU_INT32U   timeout_ms,
+void  *USBD_OS_CoreEventGet (CPU_INT08U   task_ix,
+                             CPU_INT32U   timeout_ms,
                              USBD_ERR    *p_err)
 {
    *p_err = USBD_ERR_NONE;
@@ -496,7 +503,9 @@ void  *USBD_OS_CoreEventGet (CPU_INT32U   timeout_ms,
 *
 * Description : Queues core event.
 *
-* Argument(s) : p_event     Pointer to core event.
+* Argument(s) : task_ix     Index of the core task.
+*
+*               p_event     Pointer to core event.
 *
 * Return(s)   : none.
 *
@@ -504,7 +513,8 @@ void  *USBD_OS_CoreEventGet (CPU_INT32U   timeout_ms,
 *********************************************************************************************************
 */
 
-void  USBD_OS_CoreEventPut (void  *p_event)
+void  USBD_OS_CoreEventPut (CPU_INT08U   task_ix,
+                            void        *p_event)
 {
 }
 
@@ -523,7 +533,7 @@ void  USBD_OS_CoreEventPut (void  *p_event)
 *********************************************************************************************************
 */
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 void  USBD_OS_DbgEventRdy (void)
 {
 }
@@ -544,7 +554,7 @@ void  USBD_OS_DbgEventRdy (void)
 *********************************************************************************************************
 */
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 void  USBD_OS_DbgEventWait (void)
 {
 }
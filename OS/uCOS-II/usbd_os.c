@@ -53,7 +53,7 @@
 #error  "USBD_OS_CFG_CORE_TASK_PRIO not #define'd in 'app_cfg.h' [MUST be > 0]"
 #endif
 
-#if     (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if     (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 #ifndef  USBD_OS_CFG_TRACE_TASK_STK_SIZE
 #error  "USBD_OS_CFG_TRACE_TASK_STK_SIZE not #define'd in 'app_cfg.h' [MUST be > 0]"
 #endif
@@ -100,12 +100,12 @@
 */
 
                                                                 /* -------------- USB EVENT QUEUE OBJECTS ------------- */
-static  OS_EVENT  *USBD_OS_EventQPtr;
-static  void      *USBD_OS_EventQ[USBD_CORE_EVENT_NBR_TOTAL];
+static  OS_EVENT  *USBD_OS_EventQPtr[USBD_CORE_TASK_NBR];
+static  void      *USBD_OS_EventQ[USBD_CORE_TASK_NBR][USBD_CORE_TASK_EVENT_NBR];
 
-static  OS_STK     USBD_OS_CoreTaskStk[USBD_OS_CFG_CORE_TASK_STK_SIZE];
+static  OS_STK     USBD_OS_CoreTaskStk[USBD_CORE_TASK_NBR][USBD_OS_CFG_CORE_TASK_STK_SIZE];
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 static  OS_EVENT  *USBD_OS_TraceSem;
 static  OS_STK     USBD_OS_TraceTaskStk[USBD_OS_CFG_TRACE_TASK_STK_SIZE];
 #endif
@@ -129,7 +129,7 @@ static  OS_EVENT  *USBD_OS_EP_LockTbl[USBD_CFG_MAX_NBR_DEV][USBD_CFG_MAX_NBR_EP_
 
 static  void  USBD_OS_CoreTask (void  *p_arg);
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 static  void  USBD_OS_TraceTask(void  *p_arg);
 #endif
 
@@ -147,73 +147,81 @@ static  void  USBD_OS_TraceTask(void  *p_arg);
 *
 * Return(s)   : none.
 *
-* Note(s)     : none.
+* Note(s)     : (1) If a core task is created per device (see 'usbd_core.h  USB CORE TASKS'), the core task
+*                   of device #n runs at priority (USBD_OS_CFG_CORE_TASK_PRIO + n). uC/OS-II requires
+*                   these priorities to be free.
 *********************************************************************************************************
 */
 
 void  USBD_OS_Init (USBD_ERR  *p_err)
 {
-    INT8U  os_err;
+    CPU_INT08U  task_ix;
+    INT8U       prio;
+    INT8U       os_err;
 
 
+    for (task_ix = 0u; task_ix < USBD_CORE_TASK_NBR; task_ix++) {
                                                                 /* Create USB events queue.                             */
-    USBD_OS_EventQPtr = OSQCreate(&USBD_OS_EventQ[0], USBD_CORE_EVENT_NBR_TOTAL);
+        USBD_OS_EventQPtr[task_ix] = OSQCreate(&USBD_OS_EventQ[task_ix][0], USBD_CORE_TASK_EVENT_NBR);
 
-    if (USBD_OS_EventQPtr == (OS_EVENT *)0) {
-       *p_err = USBD_ERR_OS_INIT_FAIL;
-        return;
-    }
+        if (USBD_OS_EventQPtr[task_ix] == (OS_EVENT *)0) {
+           *p_err = USBD_ERR_OS_INIT_FAIL;
+            return;
+        }
+
+        prio = (INT8U)(USBD_OS_CFG_CORE_TASK_PRIO + task_ix);   /* See Note #1.                                         */
                                                                 /* Create USB core task.                                */
 #if (OS_TASK_CREATE_EXT_EN == 1u)
 
 #if (OS_STK_GROWTH == 1u)
-    os_err = OSTaskCreateExt(        USBD_OS_CoreTask,
-                             (void *)0,
-                                    &USBD_OS_CoreTaskStk[USBD_OS_CFG_CORE_TASK_STK_SIZE - 1u],
-                                     USBD_OS_CFG_CORE_TASK_PRIO,
-                                     USBD_OS_CFG_CORE_TASK_PRIO,
-                                    &USBD_OS_CoreTaskStk[0],
-                                     USBD_OS_CFG_CORE_TASK_STK_SIZE,
-                             (void *)0,
-                                     OS_TASK_OPT_STK_CLR | OS_TASK_OPT_STK_CHK);
+        os_err = OSTaskCreateExt(                  USBD_OS_CoreTask,
+                                 (void *)(CPU_ADDR)task_ix,
+                                                  &USBD_OS_CoreTaskStk[task_ix][USBD_OS_CFG_CORE_TASK_STK_SIZE - 1u],
+                                                   prio,
+                                                   prio,
+                                                  &USBD_OS_CoreTaskStk[task_ix][0],
+                                                   USBD_OS_CFG_CORE_TASK_STK_SIZE,
+                                 (void *)          0,
+                                                   OS_TASK_OPT_STK_CLR | OS_TASK_OPT_STK_CHK);
 #else
-    os_err = OSTaskCreateExt(        USBD_OS_CoreTask,
-                             (void *)0,
-                                    &USBD_OS_CoreTaskStk[0],
-                                     USBD_OS_CFG_CORE_TASK_PRIO,
-                                     USBD_OS_CFG_CORE_TASK_PRIO,
-                                    &USBD_OS_CoreTaskStk[USBD_OS_CFG_CORE_TASK_STK_SIZE - 1u],
-                                     USBD_OS_CFG_CORE_TASK_STK_SIZE,
-                             (void *)0,
-                                     OS_TASK_OPT_STK_CLR | OS_TASK_OPT_STK_CHK);
+        os_err = OSTaskCreateExt(                  USBD_OS_CoreTask,
+                                 (void *)(CPU_ADDR)task_ix,
+                                                  &USBD_OS_CoreTaskStk[task_ix][0],
+                                                   prio,
+                                                   prio,
+                                                  &USBD_OS_CoreTaskStk[task_ix][USBD_OS_CFG_CORE_TASK_STK_SIZE - 1u],
+                                                   USBD_OS_CFG_CORE_TASK_STK_SIZE,
+                                 (void *)          0,
+                                                   OS_TASK_OPT_STK_CLR | OS_TASK_OPT_STK_CHK);
 #endif
 
 #else
 
 #if (OS_STK_GROWTH == 1u)
-    os_err = OSTaskCreate(        USBD_OS_CoreTask,
-                          (void *)0,
-                                 &USBD_OS_CoreTaskStk[USBD_OS_CFG_CORE_TASK_STK_SIZE - 1u],
-                                  USBD_OS_CFG_CORE_TASK_PRIO);
+        os_err = OSTaskCreate(                  USBD_OS_CoreTask,
+                              (void *)(CPU_ADDR)task_ix,
+                                               &USBD_OS_CoreTaskStk[task_ix][USBD_OS_CFG_CORE_TASK_STK_SIZE - 1u],
+                                                prio);
 #else
-    os_err = OSTaskCreate(        USBD_OS_CoreTask,
-                          (void *)0,
-                                 &USBD_OS_CoreTaskStk[0],
-                                  USBD_OS_CFG_CORE_TASK_PRIO);
+        os_err = OSTaskCreate(                  USBD_OS_CoreTask,
+                              (void *)(CPU_ADDR)task_ix,
+                                               &USBD_OS_CoreTaskStk[task_ix][0],
+                                                prio);
 #endif
 
 #endif
 
+        if (os_err !=  OS_ERR_NONE) {
+           *p_err = USBD_ERR_OS_INIT_FAIL;
+            return;
+        }
+
 #if (OS_TASK_NAME_EN > 0)
-    OSTaskNameSet(USBD_OS_CFG_CORE_TASK_PRIO, (INT8U *)"USB Core Task", &os_err);
+        OSTaskNameSet(prio, (INT8U *)"USB Core Task", &os_err);
 #endif
-
-    if (os_err !=  OS_ERR_NONE) {
-       *p_err = USBD_ERR_OS_INIT_FAIL;
-        return;
     }
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 
     USBD_OS_TraceSem = OSSemCreate(0u);
     if (USBD_OS_TraceSem == (OS_EVENT *)0) {
@@ -277,7 +285,7 @@ void  USBD_OS_Init (USBD_ERR  *p_err)
 *
 * Description : OS-dependent shell task to process USB core events.
 *
-* Argument(s) : p_arg       Pointer to task initialization argument (required by uC/OS-II).
+* Argument(s) : p_arg       Index of the core task.
 *
 * Return(s)   : none.
 *
@@ -287,10 +295,13 @@ void  USBD_OS_Init (USBD_ERR  *p_err)
 
 static  void  USBD_OS_CoreTask (void  *p_arg)
 {
-    (void)p_arg;
+    CPU_INT08U  task_ix;
+
+
+    task_ix = (CPU_INT08U)(CPU_ADDR)p_arg;
 
     while (DEF_ON) {
-        USBD_CoreTaskHandler();
+        USBD_CoreTaskHandler(task_ix);
     }
 }
 
@@ -309,7 +320,7 @@ static  void  USBD_OS_CoreTask (void  *p_arg)
 *********************************************************************************************************
 */
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 static  void  USBD_OS_TraceTask (void  *p_arg)
 {
     (void)p_arg;
@@ -781,7 +792,9 @@ void  USBD_OS_DlyMs (CPU_INT32U  ms)
 *
 * Description : Wait until a core event is ready.
 *
-* Argument(s) : timeout_ms  Timeout in milliseconds.
+* Argument(s) : task_ix     Index of the core task.
+*
+*               timeout_ms  Timeout in milliseconds.
 *
 *               p_err       Pointer to variable that will receive the return error code from this function :
 *
@@ -796,7 +809,8 @@ void  USBD_OS_DlyMs (CPU_INT32U  ms)
 *********************************************************************************************************
 */
 
-void  *USBD_OS_CoreEventGet (CPU_INT32U   timeout_ms,
+void  *USBD_OS_CoreEventGet (CPU_INT08U   task_ix,
+                             CPU_INT32U   timeout_ms,
                              USBD_ERR    *p_err)
 {
     void    *p_msg;
@@ -806,7 +820,7 @@ void  *USBD_OS_CoreEventGet (CPU_INT32U   timeout_ms,
 
     timeout_ticks = (((timeout_ms * OS_TICKS_PER_SEC)  + 1000u - 1u) / 1000u);
 
-    p_msg = OSQPend(USBD_OS_EventQPtr,
+    p_msg = OSQPend(USBD_OS_EventQPtr[task_ix],
                     timeout_ticks,
                    &os_err);
     switch (os_err) {
@@ -846,7 +860,9 @@ void  *USBD_OS_CoreEventGet (CPU_INT32U   timeout_ms,
 *
 * Description : Queues core event.
 *
-* Argument(s) : p_event     Pointer to core event.
+* Argument(s) : task_ix     Index of the core task.
+*
+*               p_event     Pointer to core event.
 *
 * Return(s)   : none.
 *
@@ -854,9 +870,10 @@ void  *USBD_OS_CoreEventGet (CPU_INT32U   timeout_ms,
 *********************************************************************************************************
 */
 
-void  USBD_OS_CoreEventPut (void  *p_event)
+void  USBD_OS_CoreEventPut (CPU_INT08U   task_ix,
+                            void        *p_event)
 {
-    (void)OSQPost(USBD_OS_EventQPtr, p_event);
+    (void)OSQPost(USBD_OS_EventQPtr[task_ix], p_event);
 }
 
 
@@ -874,7 +891,7 @@ void  USBD_OS_CoreEventPut (void  *p_event)
 *********************************************************************************************************
 */
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 void  USBD_OS_DbgEventRdy (void)
 {
     (void)OSSemPost(USBD_OS_TraceSem);
@@ -896,7 +913,7 @@ void  USBD_OS_DbgEventRdy (void)
 *********************************************************************************************************
 */
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 void  USBD_OS_DbgEventWait (void)
 {
     INT8U  os_err;
@@ -77,7 +77,7 @@
 #error  "USBD_OS_CFG_CORE_TASK_PRIO not #define'd in 'app_cfg.h' [MUST be > 0]"
 #endif
 
-#if     (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if     (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 #ifndef  USBD_OS_CFG_TRACE_TASK_STK_SIZE
 #error  "USBD_OS_CFG_TRACE_TASK_STK_SIZE not #define'd in 'app_cfg.h' [MUST be > 0]"
 #endif
@@ -123,10 +123,10 @@
 *********************************************************************************************************
 */
 
-static  OS_TCB    USBD_OS_CoreTaskTCB;
-static  CPU_STK   USBD_OS_CoreTaskStk[USBD_OS_CFG_CORE_TASK_STK_SIZE];
+static  OS_TCB    USBD_OS_CoreTaskTCB[USBD_CORE_TASK_NBR];
+static  CPU_STK   USBD_OS_CoreTaskStk[USBD_CORE_TASK_NBR][USBD_OS_CFG_CORE_TASK_STK_SIZE];
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 static  OS_TCB    USBD_OS_TraceTaskTCB;
 static  CPU_STK   USBD_OS_TraceTaskStk[USBD_OS_CFG_TRACE_TASK_STK_SIZE];
 
@@ -151,7 +151,7 @@ static  OS_MUTEX  USBD_OS_EP_MutexTbl[USBD_CFG_MAX_NBR_DEV][USBD_CFG_MAX_NBR_EP_
 
 static  void  USBD_OS_CoreTask (void  *p_arg);
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 static  void  USBD_OS_TraceTask(void  *p_arg);
 #endif
 
@@ -169,35 +169,39 @@ static  void  USBD_OS_TraceTask(void  *p_arg);
 *
 * Return(s)   : none.
 *
-* Note(s)     : none.
+* Note(s)     : (1) If a core task is created per device (see 'usbd_core.h  USB CORE TASKS'), the core task
+*                   of device #n runs at priority (USBD_OS_CFG_CORE_TASK_PRIO + n).
 *********************************************************************************************************
 */
 
 void  USBD_OS_Init (USBD_ERR  *p_err)
 {
-    OS_ERR  err_os;
-
+    CPU_INT08U  task_ix;
+    OS_ERR      err_os;
 
-    OSTaskCreate(        &USBD_OS_CoreTaskTCB,
-                         "USB Core Task",
-                          USBD_OS_CoreTask,
-                  (void *)0,
-                          USBD_OS_CFG_CORE_TASK_PRIO,
-                         &USBD_OS_CoreTaskStk[0],
-                          USBD_OS_CFG_CORE_TASK_STK_SIZE / 10u,
-                          USBD_OS_CFG_CORE_TASK_STK_SIZE,
-                          USBD_CORE_EVENT_NBR_TOTAL,
-                          0u,
-                  (void *)0,
-                          OS_OPT_TASK_STK_CHK | OS_OPT_TASK_STK_CLR,
-                         &err_os);
 
-    if (err_os !=  OS_ERR_NONE) {
-       *p_err = USBD_ERR_OS_INIT_FAIL;
-        return;
+    for (task_ix = 0u; task_ix < USBD_CORE_TASK_NBR; task_ix++) {
+        OSTaskCreate(        &USBD_OS_CoreTaskTCB[task_ix],
+                             "USB Core Task",
+                              USBD_OS_CoreTask,
+                     (void *)(CPU_ADDR)task_ix,
+                              USBD_OS_CFG_CORE_TASK_PRIO + task_ix,
+                             &USBD_OS_CoreTaskStk[task_ix][0],
+                              USBD_OS_CFG_CORE_TASK_STK_SIZE / 10u,
+                              USBD_OS_CFG_CORE_TASK_STK_SIZE,
+                              USBD_CORE_TASK_EVENT_NBR,
+                              0u,
+                     (void *)0,
+                              OS_OPT_TASK_STK_CHK | OS_OPT_TASK_STK_CLR,
+                             &err_os);
+
+        if (err_os !=  OS_ERR_NONE) {
+           *p_err = USBD_ERR_OS_INIT_FAIL;
+            return;
+        }
     }
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
     OSTaskCreate(        &USBD_OS_TraceTaskTCB,
                          "USB Trace Task",
                           USBD_OS_TraceTask,
@@ -228,7 +232,7 @@ void  USBD_OS_Init (USBD_ERR  *p_err)
 *
 * Description : OS-dependent shell task to process USB core events.
 *
-* Argument(s) : p_arg       Pointer to task initialization argument (required by uC/OS-II).
+* Argument(s) : p_arg       Index of the core task.
 *
 * Return(s)   : none.
 *
@@ -238,10 +242,13 @@ void  USBD_OS_Init (USBD_ERR  *p_err)
 
 static  void  USBD_OS_CoreTask (void  *p_arg)
 {
-    (void)p_arg;
+    CPU_INT08U  task_ix;
+
+
+    task_ix = (CPU_INT08U)(CPU_ADDR)p_arg;
 
     while (DEF_ON) {
-        USBD_CoreTaskHandler();
+        USBD_CoreTaskHandler(task_ix);
     }
 }
 
@@ -260,7 +267,7 @@ static  void  USBD_OS_CoreTask (void  *p_arg)
 *********************************************************************************************************
 */
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 static  void  USBD_OS_TraceTask (void  *p_arg)
 {
     (void)p_arg;
@@ -741,7 +748,9 @@ void  USBD_OS_DlyMs (CPU_INT32U  ms)
 *
 * Description : Wait until a core event is ready.
 *
-* Argument(s) : timeout_ms  Timeout in milliseconds.
+* Argument(s) : task_ix     Index of the core task.
+*
+*               timeout_ms  Timeout in milliseconds.
 *
 *               p_err       Pointer to variable that will receive the return error code from this function :
 *
@@ -756,7 +765,8 @@ void  USBD_OS_DlyMs (CPU_INT32U  ms)
 *********************************************************************************************************
 */
 
-void  *USBD_OS_CoreEventGet (CPU_INT32U   timeout_ms,
+void  *USBD_OS_CoreEventGet (CPU_INT08U   task_ix,
+                             CPU_INT32U   timeout_ms,
                              USBD_ERR    *p_err)
 {
     void         *p_msg;
@@ -765,6 +775,8 @@ void  *USBD_OS_CoreEventGet (CPU_INT32U   timeout_ms,
     OS_ERR        err;
 
 
+    (void)task_ix;                                              /* Only called from the core task itself.               */
+
     timeout_ticks = (((timeout_ms * OSCfg_TickRate_Hz)  + 1000u - 1u) / 1000u);
 
     p_msg         = OSTaskQPend(          timeout_ticks,
@@ -808,7 +820,9 @@ void  *USBD_OS_CoreEventGet (CPU_INT32U   timeout_ms,
 *
 * Description : Queues core event.
 *
-* Argument(s) : p_event     Pointer to core event.
+* Argument(s) : task_ix     Index of the core task.
+*
+*               p_event     Pointer to core event.
 *
 * Return(s)   : none.
 *
@@ -816,12 +830,13 @@ void  *USBD_OS_CoreEventGet (CPU_INT32U   timeout_ms,
 *********************************************************************************************************
 */
 
-void  USBD_OS_CoreEventPut (void  *p_event)
+void  USBD_OS_CoreEventPut (CPU_INT08U   task_ix,
+                            void        *p_event)
 {
     OS_ERR  err;
 
 
-    OSTaskQPost(&USBD_OS_CoreTaskTCB,
+    OSTaskQPost(&USBD_OS_CoreTaskTCB[task_ix],
                  p_event,
                  sizeof(void *),
                  OS_OPT_POST_FIFO,
@@ -843,7 +858,7 @@ void  USBD_OS_CoreEventPut (void  *p_event)
 *********************************************************************************************************
 */
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 void  USBD_OS_DbgEventRdy (void)
 {
     OS_ERR  err;
@@ -870,7 +885,7 @@ void  USBD_OS_DbgEventRdy (void)
 *********************************************************************************************************
 */
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 void  USBD_OS_DbgEventWait (void)
 {
     OS_ERR  err;
@@ -75,12 +75,20 @@
 *                   D6    Self-powered
 *                   D5    Remote Wakeup
 *                   D4..0 Reserved (reset to zero)
+*
+*           (3) A configuration descriptor that does not fit in the cache buffer is marked with
+*               USBD_CFG_DESC_CACHE_LEN_OVF, so that the following requests build it on the fly without
+*               trying the cache first. The mark is cleared with the cached descriptor, whenever the
+*               cache is invalidated. USBD_CFG_DESC_CACHE_BUF_LEN is less than this value, so it is never
+*               the length of a cached descriptor.
 *********************************************************************************************************
 */
 
 #define  USBD_CFG_DESC_BUF_LEN                            64u   /* See Note #1a.                                        */
 #define  USBD_EP_CTRL_ALLOC                       (DEF_BIT_00 | DEF_BIT_01)
 
+#define  USBD_CFG_DESC_CACHE_LEN_OVF     DEF_INT_16U_MAX_VAL    /* See Note #3.                                         */
+
 #define  USBD_CFG_DESC_SELF_POWERED                DEF_BIT_06   /* See Note #2.                                         */
 #define  USBD_CFG_DESC_REMOTE_WAKEUP               DEF_BIT_05
 #define  USBD_CFG_DESC_RSVD_SET                    DEF_BIT_07
@@ -102,6 +110,11 @@
 #define  USBD_MS_OS_FEATURE_COMPAT_ID                 0x0004u
 #define  USBD_MS_OS_FEATURE_EXT_PROPERTIES            0x0005u
 
+                                                                /* ---------------- CORE EVENT LANES ------------------ */
+#define  USBD_CORE_EVENT_LANE_BUS                          0u   /* Bus & setup events.                                  */
+#define  USBD_CORE_EVENT_LANE_EP                           1u   /* Endpoint events.                                     */
+#define  USBD_CORE_EVENT_LANE_NBR                          2u
+
 
 /*
 *********************************************************************************************************
@@ -153,7 +166,8 @@ typedef  enum  usbd_event_code {
     USBD_EVENT_BUS_DISCONN,
     USBD_EVENT_BUS_HS,
     USBD_EVENT_EP,
-    USBD_EVENT_SETUP
+    USBD_EVENT_SETUP,
+    USBD_EVENT_EP_PEND
 } USBD_EVENT_CODE;
 
 
@@ -205,6 +219,7 @@ typedef  struct  usbd_if_alt {
             void          *ClassArgPtr;                         /* Dev class drv arg ptr specific to alternate setting. */
             CPU_INT32U     EP_AllocMap;                         /* EP allocation bitmap.                                */
             CPU_INT08U     EP_NbrTotal;                         /* Number of EP.                                        */
+            CPU_INT08U     ClassProtocolCode;                   /* Alt setting protocol code.                           */
     const   CPU_CHAR      *NamePtr;
 #if (USBD_CFG_OPTIMIZE_SPD == DEF_ENABLED)
             USBD_EP_INFO  *EP_TblPtrs[USBD_EP_MAX_NBR];
@@ -326,6 +341,11 @@ typedef struct  usbd_cfg {                                      /* -------------
             CPU_INT08U    Attrib;                               /* Configuration attributes.                            */
             CPU_INT16U    MaxPwr;                               /* Maximum bus power drawn.                             */
             CPU_INT16U    DescLen;                              /* Configuration descriptor length.                     */
+#if (USBD_CFG_DESC_CACHE_EN == DEF_ENABLED)
+            CPU_INT08U   *DescCachePtr;                         /* Cached configuration descriptor buffer.              */
+            CPU_INT16U    DescCacheLen;                         /* Cached configuration descriptor len (0 if invalid).  */
+                                                                /* ... or USBD_CFG_DESC_CACHE_LEN_OVF if too long.      */
+#endif
     const   CPU_CHAR     *NamePtr;                              /* Configuration name.                                  */
 
 #if (USBD_CFG_OPTIMIZE_SPD == DEF_ENABLED)                      /* Interface & group list:                              */
@@ -425,7 +445,7 @@ typedef  struct  usbd_dev {                                     /* -------------
                                                                 /* ---- CONFIGURATION AND STRING DESCRIPTOR BUFFER ---- */
            CPU_INT08U      *ActualBufPtr;                       /* Pointer to the buffer where data will be written.    */
            CPU_INT08U      *DescBufPtr;                         /* Configuration & string descriptor buffer.            */
-           CPU_INT08U       DescBufIx;                          /* Configuration & string descriptor buffer index.      */
+           CPU_INT16U       DescBufIx;                          /* Configuration & string descriptor buffer index.      */
            CPU_INT16U       DescBufReqLen;                      /* Configuration & string descriptor requested length.  */
            CPU_INT16U       DescBufMaxLen;                      /* Configuration & string descriptor maximum length.    */
            USBD_ERR        *DescBufErrPtr;                      /* Configuration & string descriptor error pointer.     */
@@ -467,17 +487,74 @@ typedef  struct  usbd_core_event {
     USBD_EVENT_CODE   Type;                                     /* Core event type.                                     */
     USBD_DRV         *DrvPtr;                                   /* Pointer to driver structure.                         */
     CPU_INT08U        EP_Addr;                                  /* Endpoint address.                                    */
+    CPU_INT08U        TaskIx;                                   /* Ix of core task processing event.                    */
+    CPU_INT08U        Lane;                                     /* Lane from which event was allocated.                 */
     USBD_ERR          Err;                                      /* Error Code returned by Driver, if any.               */
 } USBD_CORE_EVENT;
 
 
+/*
+*********************************************************************************************************
+*                                           CORE EVENT LANE
+*
+* Note(s) : (1) Each core task has its own lanes. Each lane owns a slice of the core event pool & of the
+*               pending event table, starting at 'Ix' & holding 'Size' entries. Free events are kept as a
+*               stack & pending events as a FIFO.
+*
+*           (2) The OS queue only carries wake-up tokens : one token is posted for each queued event. The
+*               core task takes the oldest event of the highest priority lane that is not empty, whatever
+*               the token it received.
+*********************************************************************************************************
+*/
+
+typedef  struct  usbd_core_event_lane {
+    CPU_INT32U        Ix;                                       /* Ix of lane's first slot in pool & pending tbls.      */
+    CPU_INT32U        Size;                                     /* Nbr of slots in lane.                                */
+    CPU_INT32U        FreeCnt;                                  /* Nbr of free events in lane's pool.                   */
+    CPU_INT32U        Cnt;                                      /* Nbr of pending events in lane.                       */
+    CPU_INT32U        IxIn;                                     /* Ix where next pending event is put.                  */
+    CPU_INT32U        IxOut;                                    /* Ix of oldest pending event.                          */
+} USBD_CORE_EVENT_LANE;
+
+
+/*
+*********************************************************************************************************
+*                                 PENDING ENDPOINT COMPLETIONS DATA TYPE
+*
+* Note(s) : (1) When completion coalescing is enabled, the asynchronous completions of a device waiting for
+*               the core task are recorded here (see 'usbd_cfg.h  USB DEVICE INTERFACES CONFIGURATION
+*               Note #5'). Each bit of 'Map' flags a physical endpoint that has 'CntTbl[]' completions to
+*               process. A single USBD_EVENT_EP_PEND core event is queued while 'Map' is not zero.
+*
+*           (2) The error code of an endpoint applies to its last pending completion. The completions that
+*               follow an error are queued as regular USBD_EVENT_EP events, so that they are processed
+*               after it.
+*
+*           (3) 'EventCntTbl[]' is the number of regular USBD_EVENT_EP events of an endpoint still queued to
+*               the core task. While it is not zero, new completions of the endpoint are queued as regular
+*               events too. Each regular event first processes the pending completions of its endpoint,
+*               which are older (see USBD_EventEP_PendFlush()). The completions of an endpoint are then
+*               processed in order, even if the USBD_EVENT_EP_PEND event is queued again behind them.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_EP_CMPL_COALESCE_EN == DEF_ENABLED)
+typedef  struct  usbd_ep_cmpl_pend {
+    CPU_INT32U        Map;                                      /* Bitmap of phy EPs with pending cmpl.                 */
+    CPU_INT16U        CntTbl[USBD_EP_MAX_NBR];                  /* Nbr of pending cmpl per phy EP.                      */
+    USBD_ERR          ErrTbl[USBD_EP_MAX_NBR];                  /* Err of last pending cmpl (see Note #2).              */
+    CPU_INT16U        EventCntTbl[USBD_EP_MAX_NBR];             /* Nbr of queued regular events (see Note #3).          */
+} USBD_EP_CMPL_PEND;
+#endif
+
+
 /*
 *********************************************************************************************************
 *                                         USB DEBUG DATA TYPE
 *********************************************************************************************************
 */
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 typedef struct  usbd_dbg_event {
     const   CPU_CHAR        *MsgPtr;
             CPU_INT08U       EP_Addr;
@@ -551,6 +628,22 @@ static  CPU_INT08U          USBD_EP_InfoNbrNext;
         USBD_DBG_STATS_DEV  USBD_DbgStatsDevTbl[USBD_CFG_MAX_NBR_DEV];
 #endif
 
+#if (USBD_CFG_DBG_STATS_POOL_EN == DEF_ENABLED)
+static  USBD_DBG_STATS_POOL  *USBD_DbgStatsPoolHeadPtr;         /* Head of registered pools list.                       */
+static  USBD_DBG_STATS_POOL  *USBD_DbgStatsPoolTailPtr;         /* Tail of registered pools list.                       */
+static  CPU_INT08U            USBD_DbgStatsPoolNbr;             /* Nbr of registered pools.                             */
+                                                                /* Usage stats of core obj pools.                       */
+static  USBD_DBG_STATS_POOL   USBD_DbgStatsPoolDev;
+static  USBD_DBG_STATS_POOL   USBD_DbgStatsPoolCfg;
+static  USBD_DBG_STATS_POOL   USBD_DbgStatsPoolIF;
+static  USBD_DBG_STATS_POOL   USBD_DbgStatsPoolIF_Alt;
+#if (USBD_CFG_MAX_NBR_IF_GRP > 0)
+static  USBD_DBG_STATS_POOL   USBD_DbgStatsPoolIF_Grp;
+#endif
+static  USBD_DBG_STATS_POOL   USBD_DbgStatsPoolEP_Info;
+static  USBD_DBG_STATS_POOL   USBD_DbgStatsPoolCoreEvent[USBD_CORE_EVENT_LANE_NBR];
+#endif
+
 
 /*
 *********************************************************************************************************
@@ -559,12 +652,20 @@ static  CPU_INT08U          USBD_EP_InfoNbrNext;
 * Note(s) : (1) USB device driver signals the core task using a core event queue.
 *               The core event queue contains core event objects. These objects are
 *               allocated from the core event pool.
+*
+*           (2) The pool is split in priority lanes (see 'usbd_core.h  USB CORE EVENTS Note #2'). Lane
+*               USBD_CORE_EVENT_LANE_BUS has the highest priority.
 *********************************************************************************************************
 */
 
-static  CPU_INT32U        USBD_CoreEventPoolIx;
-static  USBD_CORE_EVENT   USBD_CoreEventPoolData[USBD_CORE_EVENT_NBR_TOTAL];
-static  USBD_CORE_EVENT  *USBD_CoreEventPoolPtrs[USBD_CORE_EVENT_NBR_TOTAL];
+static  USBD_CORE_EVENT_LANE   USBD_CoreEventLaneTbl[USBD_CORE_TASK_NBR][USBD_CORE_EVENT_LANE_NBR];
+static  USBD_CORE_EVENT        USBD_CoreEventPoolData[USBD_CORE_EVENT_NBR_TOTAL];
+static  USBD_CORE_EVENT       *USBD_CoreEventPoolPtrs[USBD_CORE_EVENT_NBR_TOTAL];
+static  USBD_CORE_EVENT       *USBD_CoreEventQPtrs[USBD_CORE_EVENT_NBR_TOTAL];
+
+#if (USBD_CFG_EP_CMPL_COALESCE_EN == DEF_ENABLED)
+static  USBD_EP_CMPL_PEND      USBD_EP_CmplPendTbl[USBD_CFG_MAX_NBR_DEV];
+#endif
 
 
 /*
@@ -573,7 +674,7 @@ static  USBD_CORE_EVENT  *USBD_CoreEventPoolPtrs[USBD_CORE_EVENT_NBR_TOTAL];
 *********************************************************************************************************
 */
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
                                                                 /* Debug event pool.                                    */
 static  USBD_DBG_EVENT   USBD_DbgEventTbl[USBD_CFG_DBG_TRACE_NBR_EVENTS];
 
@@ -584,6 +685,11 @@ static  USBD_DBG_EVENT  *USBD_DbgEventTailPtr;                  /* Debug events
 static  CPU_INT32U       USBD_DbgEventCtr;                      /* Global debug event counter.                          */
 #endif
 
+#if ((USBD_CFG_DBG_TRACE_EN     == DEF_ENABLED) && \
+     (USBD_CFG_DBG_TRACE_BIN_EN == DEF_ENABLED))
+USBD_DBG_TRACE_RING  USBD_DbgTraceRing;                         /* Binary trace ring (see 'usbd_core.h').               */
+#endif
+
 
 /*
 *********************************************************************************************************
@@ -670,6 +776,24 @@ static  void               USBD_CfgDescSend  (       USBD_DEV         *p_dev,
                                                      CPU_INT16U        req_len,
                                                      USBD_ERR         *p_err);
 
+static  void               USBD_CfgDescWr    (       USBD_DEV         *p_dev,
+                                                     USBD_CFG         *p_cfg,
+                                                     CPU_INT08U        cfg_nbr_cur,
+                                                     CPU_INT08U        cfg_nbr,
+                                                     CPU_BOOLEAN       other);
+
+#if (USBD_CFG_DESC_CACHE_EN == DEF_ENABLED)
+static  void               USBD_CfgCacheTx   (       USBD_DEV         *p_dev,
+                                                     USBD_CFG         *p_cfg,
+                                                     CPU_INT08U        cfg_nbr_cur,
+                                                     CPU_INT08U        cfg_nbr,
+                                                     CPU_BOOLEAN       other,
+                                                     CPU_INT16U        req_len,
+                                                     USBD_ERR         *p_err);
+
+static  void               USBD_CfgCacheInv  (const  USBD_DEV         *p_dev);
+#endif
+
 static  void               USBD_StrDescSend  (       USBD_DEV         *p_dev,
                                                      CPU_INT08U        str_ix,
                                                      CPU_INT16U        req_len,
@@ -755,9 +879,31 @@ static  CPU_BOOLEAN        USBD_EP_Alloc     (       USBD_DEV         *p_dev,
 
 static  void               USBD_CoreEventFree(       USBD_CORE_EVENT   *p_core_event);
 
-static  USBD_CORE_EVENT   *USBD_CoreEventGet (void);
+static  USBD_CORE_EVENT   *USBD_CoreEventGet (       CPU_INT08U         dev_nbr,
+                                                     CPU_INT08U         lane);
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+static  void               USBD_CoreEventPut (       USBD_CORE_EVENT   *p_core_event);
+
+static  USBD_CORE_EVENT   *USBD_CoreEventNext(       CPU_INT08U         task_ix);
+
+#if (USBD_CFG_EP_CMPL_COALESCE_EN == DEF_ENABLED)
+static  CPU_BOOLEAN        USBD_EventEP_Merge(       USBD_DRV          *p_drv,
+                                                     CPU_INT08U         ep_addr,
+                                                     USBD_ERR           err);
+
+static  CPU_BOOLEAN        USBD_EventEP_PendProcess( USBD_DRV          *p_drv);
+
+static  void               USBD_EventEP_PendFlush(   USBD_DRV          *p_drv,
+                                                     CPU_INT08U         ep_addr);
+
+static  void               USBD_EventEP_PendRun(     USBD_DRV          *p_drv,
+                                                     CPU_INT08U         ep_phy_nbr,
+                                                     CPU_BOOLEAN        map_clr);
+
+static  void               USBD_EventEP_PendClr(     CPU_INT08U         dev_nbr);
+#endif
+
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 static  USBD_DBG_EVENT    *USBD_DbgEventGet  (void);
 
 static  void               USBD_DbgEventFree (       USBD_DBG_EVENT    *p_event);
@@ -765,6 +911,16 @@ static  void               USBD_DbgEventFree (       USBD_DBG_EVENT    *p_event)
 static  void               USBD_DbgEventPut  (       USBD_DBG_EVENT    *p_event);
 #endif
 
+#if ((USBD_CFG_DBG_TRACE_EN     == DEF_ENABLED) && \
+     (USBD_CFG_DBG_TRACE_BIN_EN == DEF_ENABLED))
+static  void               USBD_DbgTraceRecPut(const  CPU_CHAR          *p_msg,
+                                                      CPU_INT08U         ep_addr,
+                                                      CPU_INT08U         if_nbr,
+                                                      CPU_BOOLEAN        arg_en,
+                                                      CPU_INT32U         arg,
+                                                      USBD_ERR           err);
+#endif
+
 
 /*
 *********************************************************************************************************
@@ -815,8 +971,16 @@ void  USBD_Init (USBD_ERR  *p_err)
     USBD_IF_GRP     *p_if_grp;
 #endif
     USBD_EP_INFO    *p_ep;
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+    USBD_CORE_EVENT_LANE  *p_lane;
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
     USBD_DBG_EVENT  *p_event;
+#endif
+    CPU_INT32U       pool_ix;
+    CPU_INT08U       lane;
+#if ((USBD_CFG_DBG_TRACE_EN     == DEF_ENABLED) && \
+     (USBD_CFG_DBG_TRACE_BIN_EN == DEF_ENABLED) && \
+     (CPU_CFG_TS_TMR_EN         == DEF_ENABLED))
+    CPU_ERR          err_cpu;
 #endif
     CPU_INT16U       tbl_ix;
     LIB_ERR          err_lib;
@@ -1040,10 +1204,33 @@ void  USBD_Init (USBD_ERR  *p_err)
                                                                 /* Init pool of core events.                            */
     for (tbl_ix = 0u; tbl_ix < USBD_CORE_EVENT_NBR_TOTAL; tbl_ix++) {
         USBD_CoreEventPoolPtrs[tbl_ix] = &USBD_CoreEventPoolData[tbl_ix];
+        USBD_CoreEventQPtrs[tbl_ix]    = (USBD_CORE_EVENT *)0;
+    }
+#if (USBD_CFG_EP_CMPL_COALESCE_EN == DEF_ENABLED)
+    Mem_Clr((void     *)&USBD_EP_CmplPendTbl[0u],
+            (CPU_SIZE_T) sizeof(USBD_EP_CmplPendTbl));
+#endif
+                                                                /* Split pool in core tasks & prio lanes.               */
+    pool_ix = 0u;
+    for (tbl_ix = 0u; tbl_ix < USBD_CORE_TASK_NBR; tbl_ix++) {
+        for (lane = 0u; lane < USBD_CORE_EVENT_LANE_NBR; lane++) {
+            p_lane = &USBD_CoreEventLaneTbl[tbl_ix][lane];
+            if (lane == USBD_CORE_EVENT_LANE_BUS) {
+                p_lane->Size = USBD_CORE_EVENT_BUS_NBR_TOTAL / USBD_CORE_TASK_NBR;
+            } else {
+                p_lane->Size = USBD_CORE_EVENT_URB_NBR_TOTAL / USBD_CORE_TASK_NBR;
+            }
+            p_lane->Ix      =  pool_ix;
+            p_lane->FreeCnt =  p_lane->Size;
+            p_lane->Cnt     =  0u;
+            p_lane->IxIn    =  0u;
+            p_lane->IxOut   =  0u;
+            pool_ix        +=  p_lane->Size;
+        }
     }
 
                                                                 /* Init pool of debug events.                           */
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
     for (tbl_ix = 0u; tbl_ix < (USBD_CFG_DBG_TRACE_NBR_EVENTS - 1u); tbl_ix++) {
         p_event          = &USBD_DbgEventTbl[tbl_ix];
         p_event->NextPtr = &USBD_DbgEventTbl[tbl_ix + 1u];
@@ -1054,6 +1241,22 @@ void  USBD_Init (USBD_ERR  *p_err)
     USBD_DbgEventCtr     = 0u;
     USBD_DbgEventFreePtr = &USBD_DbgEventTbl[0u];
 #endif
+                                                                /* Init binary trace ring.                              */
+#if ((USBD_CFG_DBG_TRACE_EN     == DEF_ENABLED) && \
+     (USBD_CFG_DBG_TRACE_BIN_EN == DEF_ENABLED))
+    Mem_Clr((void     *)&USBD_DbgTraceRing,
+            (CPU_SIZE_T) sizeof(USBD_DbgTraceRing));
+
+    USBD_DbgTraceRing.Magic   =  USBD_DBG_TRACE_MAGIC;
+    USBD_DbgTraceRing.Ver     =  USBD_DBG_TRACE_VER;
+    USBD_DbgTraceRing.RecSize = (CPU_INT08U)sizeof(USBD_DBG_TRACE_REC);
+    USBD_DbgTraceRing.PtrSize = (CPU_INT08U)sizeof(const CPU_CHAR *);
+    USBD_DbgTraceRing.RecNbr  =  USBD_CFG_DBG_TRACE_NBR_EVENTS;
+#if (CPU_CFG_TS_TMR_EN == DEF_ENABLED)
+    USBD_DbgTraceRing.TsFreq  = (CPU_INT32U)CPU_TS_TmrFreqGet(&err_cpu);
+#endif
+    USBD_DbgTraceRing.SeqNext =  1u;                            /* Seq nbr 0 marks an empty or incomplete rec.          */
+#endif
 
     USBD_DevNbrNext       = 0u;
     USBD_CfgNbrNext       = 0u;
@@ -1063,7 +1266,26 @@ void  USBD_Init (USBD_ERR  *p_err)
     USBD_IF_GrpNbrNext    = 0u;
 #endif
     USBD_EP_InfoNbrNext   = 0u;
-    USBD_CoreEventPoolIx  = USBD_CORE_EVENT_NBR_TOTAL;
+                                                                /* Register core obj pools in pool stats.               */
+#if (USBD_CFG_DBG_STATS_POOL_EN == DEF_ENABLED)
+    USBD_DbgStatsPoolHeadPtr = (USBD_DBG_STATS_POOL *)0;
+    USBD_DbgStatsPoolTailPtr = (USBD_DBG_STATS_POOL *)0;
+    USBD_DbgStatsPoolNbr     =  0u;
+#endif
+    USBD_DBG_STATS_POOL_REG(&USBD_DbgStatsPoolDev,     "Device",           USBD_CFG_MAX_NBR_DEV);
+    USBD_DBG_STATS_POOL_REG(&USBD_DbgStatsPoolCfg,     "Configuration",    USBD_CFG_MAX_NBR_CFG);
+    USBD_DBG_STATS_POOL_REG(&USBD_DbgStatsPoolIF,      "Interface",        USBD_CFG_MAX_NBR_IF);
+    USBD_DBG_STATS_POOL_REG(&USBD_DbgStatsPoolIF_Alt,  "Alt setting",      USBD_CFG_MAX_NBR_IF_ALT);
+#if (USBD_CFG_MAX_NBR_IF_GRP > 0)
+    USBD_DBG_STATS_POOL_REG(&USBD_DbgStatsPoolIF_Grp,  "Interface group",  USBD_CFG_MAX_NBR_IF_GRP);
+#endif
+    USBD_DBG_STATS_POOL_REG(&USBD_DbgStatsPoolEP_Info, "EP descriptor",    USBD_CFG_MAX_NBR_EP_DESC);
+    USBD_DBG_STATS_POOL_REG(&USBD_DbgStatsPoolCoreEvent[USBD_CORE_EVENT_LANE_BUS],
+                            "Core event (bus)",
+                            (USBD_CORE_EVENT_BUS_NBR_TOTAL / USBD_CORE_TASK_NBR) * USBD_CORE_TASK_NBR);
+    USBD_DBG_STATS_POOL_REG(&USBD_DbgStatsPoolCoreEvent[USBD_CORE_EVENT_LANE_EP],
+                            "Core event (EP)",
+                            (USBD_CORE_EVENT_URB_NBR_TOTAL / USBD_CORE_TASK_NBR) * USBD_CORE_TASK_NBR);
 
     USBD_EP_Init();
 }
@@ -1203,12 +1425,15 @@ CPU_INT08U  USBD_DevAdd (USBD_DEV_CFG      *p_dev_cfg,
     dev_nbr = USBD_DevNbrNext;
     if (dev_nbr >= USBD_CFG_MAX_NBR_DEV) {                      /* Chk if dev nbr is valid.                             */
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FAIL(&USBD_DbgStatsPoolDev);
        *p_err =  USBD_ERR_DEV_ALLOC;
         return (USBD_DEV_NBR_NONE);
     }
     USBD_DevNbrNext++;
     CPU_CRITICAL_EXIT();
 
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_DbgStatsPoolDev);
+
                                                                 /* ------------ INITIALIZE DEVICE STRUCTURE ----------- */
     p_dev                  = &USBD_DevTbl[dev_nbr];
     p_dev->Nbr             = dev_nbr;
@@ -1365,6 +1590,10 @@ void  USBD_DevStart (CPU_INT08U   dev_nbr,
         init = DEF_YES;
     }
 
+#if (USBD_CFG_DESC_CACHE_EN == DEF_ENABLED)
+    USBD_CfgCacheInv(p_dev);                                    /* Cfg desc rebuilt on first req.                       */
+#endif
+
     p_drv_api->Start(p_drv, p_err);
 
     if (init == DEF_YES) {
@@ -1438,6 +1667,10 @@ void  USBD_DevStop (CPU_INT08U   dev_nbr,
 
     p_drv_api->Stop(p_drv);
 
+#if (USBD_CFG_EP_CMPL_COALESCE_EN == DEF_ENABLED)
+    USBD_EventEP_PendClr(dev_nbr);                              /* Discard cmpl dropped while stopping.                 */
+#endif
+
    *p_err = USBD_ERR_NONE;
 }
 
@@ -1472,6 +1705,8 @@ void  USBD_DevStop (CPU_INT08U   dev_nbr,
 *                               USBD_ERR_DEV_INVALID_SPD        Speed mismatch in device controller (see Note #4).
 *                               USBD_ERR_CFG_INVALID_MAX_PWR    Invalid maximum power (see Note #1).
 *                               USBD_ERR_CFG_ALLOC              Configuration cannot be allocated.
+*                               USBD_ERR_ALLOC                  Configuration descriptor cache buffer cannot be
+*                                                                   allocated.
 *
 * Return(s)   : Configuration number, if NO error(s).
 *
@@ -1510,6 +1745,9 @@ CPU_INT08U  USBD_CfgAdd (       CPU_INT08U     dev_nbr,
     USBD_CFG      *p_cfg;
     CPU_INT08U     cfg_tbl_ix;
     CPU_INT08U     cfg_nbr;
+#if (USBD_CFG_DESC_CACHE_EN == DEF_ENABLED)
+    LIB_ERR        err_lib;
+#endif
     CPU_SR_ALLOC();
 
 
@@ -1552,6 +1790,7 @@ CPU_INT08U  USBD_CfgAdd (       CPU_INT08U     dev_nbr,
     cfg_tbl_ix = USBD_CfgNbrNext;
     if (cfg_tbl_ix >= USBD_CFG_MAX_NBR_CFG) {                   /* Chk if cfg is avail.                                 */
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FAIL(&USBD_DbgStatsPoolCfg);
        *p_err =  USBD_ERR_CFG_ALLOC;
         return (USBD_CFG_NBR_NONE);
     }
@@ -1629,12 +1868,27 @@ CPU_INT08U  USBD_CfgAdd (       CPU_INT08U     dev_nbr,
     CPU_CRITICAL_EXIT();
 #endif
 
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_DbgStatsPoolCfg);
+
     p_cfg->Attrib      = attrib;
     p_cfg->NamePtr     = p_name;
     p_cfg->EP_AllocMap = USBD_EP_CTRL_ALLOC;                    /* Init EP alloc bitmap.                                */
     p_cfg->MaxPwr      = max_pwr;
     p_cfg->DescLen     = 0u;                                    /* Init cfg desc len.                                   */
 
+#if (USBD_CFG_DESC_CACHE_EN == DEF_ENABLED)
+                                                                /* Alloc cfg desc cache buf from heap.                  */
+    p_cfg->DescCachePtr = (CPU_INT08U *)Mem_HeapAlloc(              USBD_CFG_DESC_CACHE_BUF_LEN,
+                                                                    USBD_CFG_BUF_ALIGN_OCTETS,
+                                                      (CPU_SIZE_T *)DEF_NULL,
+                                                                   &err_lib);
+    if (err_lib != LIB_MEM_ERR_NONE) {
+       *p_err = USBD_ERR_ALLOC;
+        return (USBD_CFG_NBR_NONE);
+    }
+    p_cfg->DescCacheLen = 0u;                                   /* Cfg desc built on first req.                         */
+#endif
+
 #if (USBD_CFG_MAX_NBR_STR > 0u)
     USBD_StrDescAdd(p_dev, p_name, p_err);                      /* Add cfg string to dev.                               */
     if (*p_err != USBD_ERR_NONE) {
@@ -2165,6 +2419,7 @@ CPU_INT08U  USBD_IF_Add (       CPU_INT08U        dev_nbr,
     if_tbl_ix = USBD_IF_NbrNext;
     if (if_tbl_ix >= USBD_CFG_MAX_NBR_IF) {                     /* Chk if IF struct is avail.                           */
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FAIL(&USBD_DbgStatsPoolIF);
        *p_err = USBD_ERR_IF_ALLOC;
         return (USBD_IF_NBR_NONE);
     }
@@ -2172,6 +2427,7 @@ CPU_INT08U  USBD_IF_Add (       CPU_INT08U        dev_nbr,
     if_alt_nbr = USBD_IF_AltNbrNext;
     if (if_alt_nbr >= USBD_CFG_MAX_NBR_IF_ALT) {                /* Chk if IF alt struct is avail.                       */
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FAIL(&USBD_DbgStatsPoolIF_Alt);
        *p_err = USBD_ERR_IF_ALT_ALLOC;
         return (USBD_IF_NBR_NONE);
     }
@@ -2212,6 +2468,9 @@ CPU_INT08U  USBD_IF_Add (       CPU_INT08U        dev_nbr,
     CPU_CRITICAL_EXIT();
 #endif
 
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_DbgStatsPoolIF);
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_DbgStatsPoolIF_Alt);
+
     p_if->ClassCode         = class_code;
     p_if->ClassSubCode      = class_sub_code;
     p_if->ClassProtocolCode = class_protocol_code;
@@ -2225,6 +2484,12 @@ CPU_INT08U  USBD_IF_Add (       CPU_INT08U        dev_nbr,
     p_if_alt->EP_AllocMap   = p_if->EP_AllocMap;
     p_if_alt->ClassArgPtr   = p_if_alt_class_arg;
 
+    p_if_alt->ClassProtocolCode = class_protocol_code;          /* Dflt alt setting uses IF protocol code.              */
+
+#if (USBD_CFG_DESC_CACHE_EN == DEF_ENABLED)
+    p_cfg->DescCacheLen = 0u;                                   /* Invalidate cached cfg desc.                          */
+#endif
+
 #if (USBD_CFG_MAX_NBR_STR > 0u)
     USBD_StrDescAdd(p_dev, p_name, p_err);                      /* Add IF string to dev.                                */
     if (*p_err != USBD_ERR_NONE) {
@@ -2267,7 +2532,8 @@ CPU_INT08U  USBD_IF_Add (       CPU_INT08U        dev_nbr,
 *
 *               USBD_IF_ALT_NBR_NONE,               otherwise.
 *
-* Note(s)     : none.
+* Note(s)     : (1) The alternate setting reports the interface protocol code in its descriptor. Use
+*                   USBD_IF_AltProtocolSet() to advertise a different protocol (e.g. MSC UAS).
 *********************************************************************************************************
 */
 
@@ -2315,6 +2581,7 @@ CPU_INT08U  USBD_IF_AltAdd (       CPU_INT08U   dev_nbr,
     if_alt_tbl_ix = USBD_IF_AltNbrNext;
     if (if_alt_tbl_ix >= USBD_CFG_MAX_NBR_IF_ALT) {             /* Chk if next alt setting is avail.                    */
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FAIL(&USBD_DbgStatsPoolIF_Alt);
        *p_err = USBD_ERR_IF_ALT_ALLOC;
         return (USBD_IF_ALT_NBR_NONE);
     }
@@ -2344,14 +2611,20 @@ CPU_INT08U  USBD_IF_AltAdd (       CPU_INT08U   dev_nbr,
     CPU_CRITICAL_EXIT();
 #endif
 
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_DbgStatsPoolIF_Alt);
 
-    p_if_alt->ClassArgPtr = p_class_arg;
-    p_if_alt->EP_AllocMap = USBD_EP_CTRL_ALLOC;
-    p_if_alt->NamePtr     = p_name;
+    p_if_alt->ClassArgPtr       = p_class_arg;
+    p_if_alt->EP_AllocMap       = USBD_EP_CTRL_ALLOC;
+    p_if_alt->NamePtr           = p_name;
+    p_if_alt->ClassProtocolCode = p_if->ClassProtocolCode;      /* Inherit IF protocol code (see Note #1).              */
 
     DEF_BIT_CLR(p_if_alt->EP_AllocMap, p_if->EP_AllocMap);
     DEF_BIT_SET(p_if_alt->EP_AllocMap, USBD_EP_CTRL_ALLOC);
 
+#if (USBD_CFG_DESC_CACHE_EN == DEF_ENABLED)
+    p_cfg->DescCacheLen = 0u;                                   /* Invalidate cached cfg desc.                          */
+#endif
+
 #if (USBD_CFG_MAX_NBR_STR > 0u)
     USBD_StrDescAdd(p_dev, p_name, p_err);                      /* Add alt setting string to dev.                       */
     if (*p_err != USBD_ERR_NONE) {
@@ -2366,6 +2639,97 @@ CPU_INT08U  USBD_IF_AltAdd (       CPU_INT08U   dev_nbr,
 }
 
 
+/*
+*********************************************************************************************************
+*                                       USBD_IF_AltProtocolSet()
+*
+* Description : Set the protocol code reported by a specific interface alternate setting.
+*
+* Argument(s) : dev_nbr             Device number.
+*
+*               cfg_nbr             Configuration number.
+*
+*               if_nbr              Interface number.
+*
+*               if_alt_nbr          Interface alternate setting number.
+*
+*               class_protocol_code Protocol code assigned by the USB-IF.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE                   Protocol code successfully set.
+*                               USBD_ERR_DEV_INVALID_NBR        Invalid device        number.
+*                               USBD_ERR_DEV_INVALID_STATE      Invalid device state.
+*                               USBD_ERR_CFG_INVALID_NBR        Invalid configuration number.
+*                               USBD_ERR_IF_INVALID_NBR         Invalid interface     number.
+*                               USBD_ERR_IF_ALT_INVALID_NBR     Invalid interface alternate setting number.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Some classes define a different transport protocol per alternate setting (e.g. MSC
+*                   Bulk-Only Transport on the default setting and USB Attached SCSI on alternate setting 1).
+*********************************************************************************************************
+*/
+
+void  USBD_IF_AltProtocolSet (CPU_INT08U   dev_nbr,
+                              CPU_INT08U   cfg_nbr,
+                              CPU_INT08U   if_nbr,
+                              CPU_INT08U   if_alt_nbr,
+                              CPU_INT08U   class_protocol_code,
+                              USBD_ERR    *p_err)
+{
+    USBD_DEV     *p_dev;
+    USBD_CFG     *p_cfg;
+    USBD_IF      *p_if;
+    USBD_IF_ALT  *p_if_alt;
+
+
+#if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)                /* ---------------- VALIDATE ARGUMENTS ---------------- */
+    if (p_err == (USBD_ERR *)0) {                               /* Validate error ptr.                                  */
+        CPU_SW_EXCEPTION(;);
+    }
+#endif
+                                                                /* --------------- GET OBJECT REFERENCES -------------- */
+    p_dev = USBD_DevRefGet(dev_nbr);                            /* Get dev struct.                                      */
+    if (p_dev == (USBD_DEV *)0) {
+       *p_err = USBD_ERR_DEV_INVALID_NBR;
+        return;
+    }
+
+    if ((p_dev->State != USBD_DEV_STATE_NONE) &&                /* Chk curr dev state.                                  */
+        (p_dev->State != USBD_DEV_STATE_INIT)) {
+       *p_err = USBD_ERR_DEV_INVALID_STATE;
+        return;
+    }
+
+    p_cfg = USBD_CfgRefGet(p_dev, cfg_nbr);                     /* Get cfg struct.                                      */
+    if (p_cfg == (USBD_CFG *)0) {
+       *p_err = USBD_ERR_CFG_INVALID_NBR;
+        return;
+    }
+
+    p_if = USBD_IF_RefGet(p_cfg, if_nbr);                       /* Get IF struct.                                       */
+    if (p_if == (USBD_IF *)0) {
+       *p_err = USBD_ERR_IF_INVALID_NBR;
+        return;
+    }
+
+    p_if_alt = USBD_IF_AltRefGet(p_if, if_alt_nbr);             /* Get IF alt setting struct.                           */
+    if (p_if_alt == (USBD_IF_ALT *)0) {
+       *p_err = USBD_ERR_IF_ALT_INVALID_NBR;
+        return;
+    }
+
+    p_if_alt->ClassProtocolCode = class_protocol_code;
+
+#if (USBD_CFG_DESC_CACHE_EN == DEF_ENABLED)
+    p_cfg->DescCacheLen = 0u;                                   /* Invalidate cached cfg desc.                          */
+#endif
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
 /*
 *********************************************************************************************************
 *                                            USBD_IF_Grp()
@@ -2468,6 +2832,7 @@ CPU_INT08U  USBD_IF_Grp (       CPU_INT08U   dev_nbr,
     if_grp_tbl_ix = USBD_IF_GrpNbrNext;
     if (if_grp_tbl_ix >= USBD_CFG_MAX_NBR_IF_GRP) {             /* Chk if IF grp is avail.                              */
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FAIL(&USBD_DbgStatsPoolIF_Grp);
        *p_err =  USBD_ERR_IF_GRP_ALLOC;
         return (USBD_IF_GRP_NBR_NONE);
     }
@@ -2497,6 +2862,8 @@ CPU_INT08U  USBD_IF_Grp (       CPU_INT08U   dev_nbr,
     CPU_CRITICAL_EXIT();
 #endif
 
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_DbgStatsPoolIF_Grp);
+
     p_if_grp->ClassCode         =  class_code;
     p_if_grp->ClassSubCode      =  class_sub_code;
     p_if_grp->ClassProtocolCode =  class_protocol_code;
@@ -2522,6 +2889,10 @@ CPU_INT08U  USBD_IF_Grp (       CPU_INT08U   dev_nbr,
         CPU_CRITICAL_EXIT();
     }
 
+#if (USBD_CFG_DESC_CACHE_EN == DEF_ENABLED)
+    p_cfg->DescCacheLen = 0u;                                   /* Invalidate cached cfg desc.                          */
+#endif
+
 #if (USBD_CFG_MAX_NBR_STR > 0u)
     USBD_StrDescAdd(p_dev, p_name, p_err);                      /* Add IF grp string to dev.                            */
     if (*p_err != USBD_ERR_NONE) {
@@ -2622,7 +2993,7 @@ CPU_INT08U  USBD_DescDevGet (USBD_DRV    *p_drv,
                      max_len,
                      p_err);
 
-    desc_len             =  p_dev->DescBufIx;
+    desc_len             = (CPU_INT08U)p_dev->DescBufIx;
     p_dev->DescBufErrPtr = (USBD_ERR *)0;
 
     return (desc_len);
@@ -2672,7 +3043,7 @@ CPU_INT16U  USBD_DescCfgGet (USBD_DRV    *p_drv,
                              USBD_ERR    *p_err)
 {
     USBD_DEV    *p_dev;
-    CPU_INT08U   desc_len;
+    CPU_INT16U   desc_len;
 
 
 #if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)
@@ -2808,7 +3179,7 @@ CPU_INT08U  USBD_DescStrGet (USBD_DRV    *p_drv,
                      max_len,
                      p_err);
 
-    desc_len             =  p_dev->DescBufIx;
+    desc_len             = (CPU_INT08U)p_dev->DescBufIx;
     p_dev->DescBufErrPtr = (USBD_ERR *)0;
 
     return (desc_len);
@@ -2870,6 +3241,10 @@ void  USBD_StrAdd (       CPU_INT08U   dev_nbr,
 #else
     (void)p_str;
 #endif
+
+#if (USBD_CFG_DESC_CACHE_EN == DEF_ENABLED)
+    USBD_CfgCacheInv(p_dev);                                    /* Invalidate cached cfg desc.                          */
+#endif
 }
 
 
@@ -3712,6 +4087,9 @@ void  USBD_IsocSyncRefreshSet (CPU_INT08U   dev_nbr,
     CPU_CRITICAL_ENTER();
     p_ep->SyncRefresh = sync_refresh;
     CPU_CRITICAL_EXIT();
+#if (USBD_CFG_DESC_CACHE_EN == DEF_ENABLED)
+    p_cfg->DescCacheLen = 0u;                                   /* Invalidate cached cfg desc.                          */
+#endif
 }
 #endif
 
@@ -3925,6 +4303,9 @@ void  USBD_IsocSyncAddrSet (CPU_INT08U   dev_nbr,
     CPU_CRITICAL_ENTER();
     p_ep_isoc->SyncAddr = sync_addr;
     CPU_CRITICAL_EXIT();
+#if (USBD_CFG_DESC_CACHE_EN == DEF_ENABLED)
+    p_cfg->DescCacheLen = 0u;                                   /* Invalidate cached cfg desc.                          */
+#endif
 }
 #endif
 
@@ -4036,12 +4417,15 @@ static  CPU_INT08U  USBD_EP_Add (CPU_INT08U    dev_nbr,
     ep_nbr = USBD_EP_InfoNbrNext;
     if (ep_nbr >= USBD_CFG_MAX_NBR_EP_DESC) {                  /* Chk if EP is avail.                                  */
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FAIL(&USBD_DbgStatsPoolEP_Info);
        *p_err = USBD_ERR_EP_ALLOC;
         return (USBD_EP_NBR_NONE);
     }
     USBD_EP_InfoNbrNext++;
     CPU_CRITICAL_EXIT();
 
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_DbgStatsPoolEP_Info);
+
     ep_type = attrib & USBD_EP_TYPE_MASK;
 #if (USBD_CFG_HS_EN == DEF_ENABLED)
     if (DEF_BIT_IS_SET(cfg_nbr, USBD_CFG_NBR_SPD_BIT) == DEF_YES) {
@@ -4077,6 +4461,7 @@ static  CPU_INT08U  USBD_EP_Add (CPU_INT08U    dev_nbr,
     if (alloc != DEF_OK) {
         USBD_EP_InfoNbrNext--;
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FREE(&USBD_DbgStatsPoolEP_Info);
        *p_err = USBD_ERR_EP_NONE_AVAIL;
         return (USBD_EP_NBR_NONE);
     }
@@ -4112,6 +4497,10 @@ static  CPU_INT08U  USBD_EP_Add (CPU_INT08U    dev_nbr,
 #endif
     CPU_CRITICAL_EXIT();
 
+#if (USBD_CFG_DESC_CACHE_EN == DEF_ENABLED)
+    p_cfg->DescCacheLen = 0u;                                   /* Invalidate cached cfg desc.                          */
+#endif
+
    *p_err = USBD_ERR_NONE;
 
     return (p_ep->Addr);
@@ -4478,14 +4867,19 @@ void  USBD_EventSetup (USBD_DRV  *p_drv,
         return;
     }
 
-    p_core_event = USBD_CoreEventGet();                         /* Get core event struct.                                */
+    p_core_event = USBD_CoreEventGet(p_drv->DevNbr,             /* Get core event struct.                               */
+                                     USBD_CORE_EVENT_LANE_BUS);
     if (p_core_event == (USBD_CORE_EVENT *)0) {
+        USBD_DBG_STATS_POOL_FAIL(&USBD_DbgStatsPoolCoreEvent[USBD_CORE_EVENT_LANE_BUS]);
         return;
     }
 
     USBD_DBG_CORE_STD("Setup Pkt");
 
     p_buf_08                          = (CPU_INT08U *)p_buf;
+#if (USBD_CFG_CAPTURE_EN == DEF_ENABLED)
+    USBD_EP_CaptureSetup(p_drv->DevNbr, p_buf_08);              /* Record setup pkt in capture ring.                    */
+#endif
     p_dev->SetupReqNext.bmRequestType =  p_buf_08[0u];
     p_dev->SetupReqNext.bRequest      =  p_buf_08[1u];
     p_dev->SetupReqNext.wValue        =  MEM_VAL_GET_INT16U_LITTLE(p_buf_08 + 2u);
@@ -4496,7 +4890,7 @@ void  USBD_EventSetup (USBD_DRV  *p_drv,
     p_core_event->DrvPtr              =  p_drv;
     p_core_event->Err                 =  USBD_ERR_NONE;
 
-    USBD_OS_CoreEventPut(p_core_event);
+    USBD_CoreEventPut(p_core_event);
 }
 
 
@@ -4521,28 +4915,44 @@ void  USBD_EventSetup (USBD_DRV  *p_drv,
 *
 *               err         Error code returned by the USB device driver.
 *
-* Return(s)   : none.
+* Return(s)   : DEF_OK,   if the event has been queued to the core task.
 *
-* Note(s)     : none.
+*               DEF_FAIL, otherwise (see Note #1).
+*
+* Note(s)     : (1) The event is dropped if no core event is available. The caller then undoes any state
+*                   that expects the completion to be processed by the core task.
+*
+*               (2) See 'PENDING ENDPOINT COMPLETIONS DATA TYPE Note #3'.
 *********************************************************************************************************
 */
 
-void  USBD_EventEP (USBD_DRV    *p_drv,
-                    CPU_INT08U   ep_addr,
-                    USBD_ERR     err)
+CPU_BOOLEAN  USBD_EventEP (USBD_DRV    *p_drv,
+                           CPU_INT08U   ep_addr,
+                           USBD_ERR     err)
 {
     USBD_CORE_EVENT  *p_core_event;
+#if (USBD_CFG_EP_CMPL_COALESCE_EN == DEF_ENABLED)
+    CPU_SR_ALLOC();
+#endif
 
 
 #if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)
     if (p_drv == (USBD_DRV *)0) {
-        return;
+        return (DEF_FAIL);
     }
 #endif
 
-    p_core_event = USBD_CoreEventGet();                         /* Get core event struct.                               */
-    if (p_core_event == (USBD_CORE_EVENT *)0) {
-        return;
+#if (USBD_CFG_EP_CMPL_COALESCE_EN == DEF_ENABLED)
+    if (USBD_EventEP_Merge(p_drv, ep_addr, err) == DEF_YES) {   /* Merge with pending cmpl of dev, if possible.         */
+        return (DEF_OK);
+    }
+#endif
+
+    p_core_event = USBD_CoreEventGet(p_drv->DevNbr,             /* Get core event struct.                               */
+                                     USBD_CORE_EVENT_LANE_EP);
+    if (p_core_event == (USBD_CORE_EVENT *)0) {                 /* See Note #1.                                         */
+        USBD_DBG_STATS_POOL_FAIL(&USBD_DbgStatsPoolCoreEvent[USBD_CORE_EVENT_LANE_EP]);
+        return (DEF_FAIL);
     }
 
     p_core_event->Type    = USBD_EVENT_EP;
@@ -4550,7 +4960,15 @@ void  USBD_EventEP (USBD_DRV    *p_drv,
     p_core_event->EP_Addr = ep_addr;
     p_core_event->Err     = err;
 
-    USBD_OS_CoreEventPut(p_core_event);                         /* Queue core event.                                    */
+#if (USBD_CFG_EP_CMPL_COALESCE_EN == DEF_ENABLED)
+    CPU_CRITICAL_ENTER();                                       /* See Note #2.                                         */
+    USBD_EP_CmplPendTbl[p_drv->DevNbr].EventCntTbl[USBD_EP_ADDR_TO_PHY(ep_addr)]++;
+    CPU_CRITICAL_EXIT();
+#endif
+
+    USBD_CoreEventPut(p_core_event);                            /* Queue core event.                                    */
+
+    return (DEF_OK);
 }
 
 
@@ -6726,9 +7144,15 @@ static  void  USBD_DevDescSend (USBD_DEV     *p_dev,
 *                               - RETURNED BY USBD_DescWrStop() -
 *                               See USBD_DescWrStop() for additional return error codes.
 *
+*                               - RETURNED BY USBD_CfgCacheTx() -
+*                               See USBD_CfgCacheTx() for additional return error codes.
+*
 * Return(s)   : none.
 *
-* Note(s)     : none.
+* Note(s)     : (1) When the configuration descriptor cache is enabled, a Get Descriptor standard request is
+*                   answered from the cached descriptor. The descriptor is built on the fly if it does not
+*                   fit in the cache buffer, or if it is requested by a driver supporting standard
+*                   requests auto-reply.
 *********************************************************************************************************
 */
 
@@ -6738,25 +7162,8 @@ static  void  USBD_CfgDescSend (USBD_DEV     *p_dev,
                                 CPU_INT16U    req_len,
                                 USBD_ERR     *p_err)
 {
-    USBD_CFG        *p_cfg;
-    USBD_IF         *p_if;
-    USBD_EP_INFO    *p_ep;
-    USBD_IF_ALT     *p_if_alt;
-#if (USBD_CFG_MAX_NBR_IF_GRP > 0)
-    USBD_IF_GRP     *p_if_grp;
-#endif
-    USBD_CLASS_DRV  *p_if_drv;
-    CPU_INT08U       cfg_nbr_cur;
-    CPU_INT08U       ep_nbr;
-    CPU_INT08U       if_nbr;
-    CPU_INT08U       if_total;
-    CPU_INT08U       if_grp_cur;
-    CPU_INT08U       if_alt_nbr;
-    CPU_INT08U       str_ix;
-    CPU_INT08U       attrib;
-#if (USBD_CFG_OPTIMIZE_SPD == DEF_ENABLED)
-    CPU_INT32U       ep_alloc_map;
-#endif
+    USBD_CFG    *p_cfg;
+    CPU_INT08U   cfg_nbr_cur;
 
 
 #if (USBD_CFG_HS_EN == DEF_ENABLED)
@@ -6794,32 +7201,113 @@ static  void  USBD_CfgDescSend (USBD_DEV     *p_dev,
     }
 #endif
 
-    p_cfg->DescLen = USBD_DESC_LEN_CFG;                         /* Init cfg desc len.                                   */
+#if (USBD_CFG_DESC_CACHE_EN == DEF_ENABLED)
+    if ((p_dev->ActualBufPtr == p_dev->DescBufPtr) &&           /* Std req: send desc from cache (see Note #1)...       */
+        (p_cfg->DescCacheLen != USBD_CFG_DESC_CACHE_LEN_OVF)) { /* ... unless it is known not to fit.                   */
+        USBD_CfgCacheTx(p_dev,
+                        p_cfg,
+                        cfg_nbr_cur,
+                        cfg_nbr,
+                        other,
+                        req_len,
+                        p_err);
+        if (*p_err != USBD_ERR_ALLOC) {
+            return;
+        }
+       *p_err = USBD_ERR_NONE;                                  /* Desc does not fit in cache: build it on the fly.     */
+    }
+#endif
 
     USBD_DescWrStart(p_dev, req_len);
-                                                                /* ---------- BUILD CONFIGURATION DESCRIPTOR ---------- */
-    USBD_DescWrReq08(p_dev, USBD_DESC_LEN_CFG);                 /* Desc len.                                            */
-    if (other == DEF_YES) {
-        USBD_DescWrReq08(p_dev, USBD_DESC_TYPE_OTHER_SPEED_CONFIGURATION);
-    } else {
-        USBD_DescWrReq08(p_dev, USBD_DESC_TYPE_CONFIGURATION);  /* Desc type.                                           */
-    }
 
-    if_total   = p_cfg->IF_NbrTotal;
-    if_grp_cur = USBD_IF_GRP_NBR_NONE;
+    USBD_CfgDescWr(p_dev,
+                   p_cfg,
+                   cfg_nbr_cur,
+                   cfg_nbr,
+                   other);
 
-    for (if_nbr = 0u; if_nbr < if_total; if_nbr++) {
-        p_if     = USBD_IF_RefGet(p_cfg, if_nbr);
-        p_if_drv = p_if->ClassDrvPtr;
+    USBD_DescWrStop(p_dev, p_err);
+}
 
-        if ((p_if->GrpNbr != if_grp_cur          ) &&
-            (p_if->GrpNbr != USBD_IF_GRP_NBR_NONE)) {
-                                                                /* Add IF assoc desc len.                               */
-            p_cfg->DescLen += USBD_DESC_LEN_IF_ASSOCIATION;
-            if_grp_cur      = p_if->GrpNbr;
-        }
 
-        p_cfg->DescLen += (USBD_DESC_LEN_IF * p_if->AltNbrTotal);
+/*
+*********************************************************************************************************
+*                                          USBD_CfgDescWr()
+*
+* Description : Write configuration descriptor in the descriptor buffer.
+*
+* Argument(s) : p_dev           Pointer to device struct.
+*               -----           Argument validated by the caller(s).
+*
+*               p_cfg           Pointer to configuration struct.
+*               -----           Argument validated by the caller(s).
+*
+*               cfg_nbr_cur     Configuration number, including speed bit, of 'p_cfg'.
+*
+*               cfg_nbr         Configuration number requested by the host.
+*
+*               other           Other speed configuration :
+*
+*                                   DEF_NO      Descriptor is build for the current speed.
+*                                   DEF_YES     Descriptor is build for the  other  speed.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) USBD_DescWrStart() MUST be called prior to this function. Errors are reported through
+*                   'DescBufErrPtr'.
+*********************************************************************************************************
+*/
+
+static  void  USBD_CfgDescWr (USBD_DEV     *p_dev,
+                              USBD_CFG     *p_cfg,
+                              CPU_INT08U    cfg_nbr_cur,
+                              CPU_INT08U    cfg_nbr,
+                              CPU_BOOLEAN   other)
+{
+    USBD_IF         *p_if;
+    USBD_EP_INFO    *p_ep;
+    USBD_IF_ALT     *p_if_alt;
+#if (USBD_CFG_MAX_NBR_IF_GRP > 0)
+    USBD_IF_GRP     *p_if_grp;
+#endif
+    USBD_CLASS_DRV  *p_if_drv;
+    CPU_INT08U       ep_nbr;
+    CPU_INT08U       if_nbr;
+    CPU_INT08U       if_total;
+    CPU_INT08U       if_grp_cur;
+    CPU_INT08U       if_alt_nbr;
+    CPU_INT08U       str_ix;
+    CPU_INT08U       attrib;
+#if (USBD_CFG_OPTIMIZE_SPD == DEF_ENABLED)
+    CPU_INT32U       ep_alloc_map;
+#endif
+
+
+    p_cfg->DescLen = USBD_DESC_LEN_CFG;                         /* Init cfg desc len.                                   */
+
+                                                                /* ---------- BUILD CONFIGURATION DESCRIPTOR ---------- */
+    USBD_DescWrReq08(p_dev, USBD_DESC_LEN_CFG);                 /* Desc len.                                            */
+    if (other == DEF_YES) {
+        USBD_DescWrReq08(p_dev, USBD_DESC_TYPE_OTHER_SPEED_CONFIGURATION);
+    } else {
+        USBD_DescWrReq08(p_dev, USBD_DESC_TYPE_CONFIGURATION);  /* Desc type.                                           */
+    }
+
+    if_total   = p_cfg->IF_NbrTotal;
+    if_grp_cur = USBD_IF_GRP_NBR_NONE;
+
+    for (if_nbr = 0u; if_nbr < if_total; if_nbr++) {
+        p_if     = USBD_IF_RefGet(p_cfg, if_nbr);
+        p_if_drv = p_if->ClassDrvPtr;
+
+        if ((p_if->GrpNbr != if_grp_cur          ) &&
+            (p_if->GrpNbr != USBD_IF_GRP_NBR_NONE)) {
+                                                                /* Add IF assoc desc len.                               */
+            p_cfg->DescLen += USBD_DESC_LEN_IF_ASSOCIATION;
+            if_grp_cur      = p_if->GrpNbr;
+        }
+
+        p_cfg->DescLen += (USBD_DESC_LEN_IF * p_if->AltNbrTotal);
 
         for (if_alt_nbr = 0u; if_alt_nbr < p_if->AltNbrTotal; if_alt_nbr++) {
             p_if_alt        =  USBD_IF_AltRefGet(p_if, if_alt_nbr);
@@ -6941,7 +7429,7 @@ static  void  USBD_CfgDescSend (USBD_DEV     *p_dev,
             USBD_DescWrReq08(p_dev, p_if_alt->EP_NbrTotal);
             USBD_DescWrReq08(p_dev, p_if->ClassCode);
             USBD_DescWrReq08(p_dev, p_if->ClassSubCode);
-            USBD_DescWrReq08(p_dev, p_if->ClassProtocolCode);
+            USBD_DescWrReq08(p_dev, p_if_alt->ClassProtocolCode);
 
             str_ix = USBD_StrDescIxGet(p_dev, p_if_alt->NamePtr);
             USBD_DescWrReq08(p_dev, str_ix);
@@ -7042,9 +7530,154 @@ static  void  USBD_CfgDescSend (USBD_DEV     *p_dev,
 #endif
         }
     }
+}
 
-    USBD_DescWrStop(p_dev, p_err);
+
+/*
+*********************************************************************************************************
+*                                          USBD_CfgCacheTx()
+*
+* Description : Send configuration descriptor from the configuration descriptor cache.
+*
+* Argument(s) : p_dev           Pointer to device struct.
+*               -----           Argument validated by the caller(s).
+*
+*               p_cfg           Pointer to configuration struct.
+*               -----           Argument validated by the caller(s).
+*
+*               cfg_nbr_cur     Configuration number, including speed bit, of 'p_cfg'.
+*
+*               cfg_nbr         Configuration number requested by the host.
+*
+*               other           Other speed configuration :
+*
+*                                   DEF_NO      Descriptor is sent for the current speed.
+*                                   DEF_YES     Descriptor is sent for the  other  speed.
+*
+*               req_len         Requested length by the host.
+*
+*               p_err           Pointer to variable that will receive the return error code from this function :
+*
+*                                   USBD_ERR_NONE       Configuration descriptor successfully sent.
+*                                   USBD_ERR_ALLOC      Configuration descriptor does not fit in cache buffer
+*                                                           (see Note #3).
+*
+*                                   - RETURNED BY USBD_CtrlTx() -
+*                                   See USBD_CtrlTx() for additional return error codes.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) The descriptor is built in the cache buffer by redirecting the descriptor writes,
+*                   the same way as for a driver supporting standard requests auto-reply.
+*
+*               (2) A configuration can be reported either as the current speed or as the other speed
+*                   configuration. Only the descriptor type and the configuration value differ between
+*                   both, so these fields are updated in the cached descriptor before each transfer.
+*
+*               (3) A descriptor that does not fit is marked, so that it is not built in the cache again
+*                   until the cache is invalidated (see 'LOCAL DEFINES Note #3').
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_DESC_CACHE_EN == DEF_ENABLED)
+static  void  USBD_CfgCacheTx (USBD_DEV     *p_dev,
+                               USBD_CFG     *p_cfg,
+                               CPU_INT08U    cfg_nbr_cur,
+                               CPU_INT08U    cfg_nbr,
+                               CPU_BOOLEAN   other,
+                               CPU_INT16U    req_len,
+                               USBD_ERR     *p_err)
+{
+    CPU_INT08U  *p_desc;
+    CPU_INT16U   desc_len;
+    CPU_INT16U   tx_len;
+
+
+    p_desc = p_cfg->DescCachePtr;
+
+    if (p_cfg->DescCacheLen == 0u) {                            /* ------------- BUILD CACHED DESCRIPTOR -------------- */
+        p_dev->ActualBufPtr  = p_desc;                          /* See Note #1.                                         */
+        p_dev->DescBufMaxLen = USBD_CFG_DESC_CACHE_BUF_LEN;
+
+        USBD_DescWrStart(p_dev, DEF_INT_16U_MAX_VAL);
+        USBD_CfgDescWr(p_dev,
+                       p_cfg,
+                       cfg_nbr_cur,
+                       cfg_nbr,
+                       other);
+
+        p_dev->ActualBufPtr  = p_dev->DescBufPtr;
+        p_dev->DescBufMaxLen = USBD_CFG_DESC_BUF_LEN;
+
+        if (*p_err != USBD_ERR_NONE) {
+            if (*p_err == USBD_ERR_ALLOC) {
+                p_cfg->DescCacheLen = USBD_CFG_DESC_CACHE_LEN_OVF;  /* See Note #3.                                     */
+            }
+            return;
+        }
+
+        p_cfg->DescCacheLen = p_dev->DescBufIx;
+    }
+                                                                /* -------------- SEND CACHED DESCRIPTOR -------------- */
+    if (other == DEF_YES) {                                     /* See Note #2.                                         */
+        p_desc[1u] = USBD_DESC_TYPE_OTHER_SPEED_CONFIGURATION;
+    } else {
+        p_desc[1u] = USBD_DESC_TYPE_CONFIGURATION;
+    }
+    p_desc[5u] = cfg_nbr + 1u;
+
+    desc_len = p_cfg->DescCacheLen;
+    tx_len   = DEF_MIN(desc_len, req_len);
+
+    (void)USBD_CtrlTx(            p_dev->Nbr,
+                                  p_desc,
+                      (CPU_INT32U)tx_len,
+                                  USBD_CFG_CTRL_REQ_TIMEOUT_mS,
+                                 (req_len > desc_len) ? DEF_YES : DEF_NO,
+                                  p_err);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_CfgCacheInv()
+*
+* Description : Invalidate the cached descriptor of all the configurations of a device.
+*
+* Argument(s) : p_dev       Pointer to device struct.
+*               -----       Argument validated by the caller(s).
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_DESC_CACHE_EN == DEF_ENABLED)
+static  void  USBD_CfgCacheInv (const  USBD_DEV  *p_dev)
+{
+    USBD_CFG    *p_cfg;
+    CPU_INT08U   cfg_nbr;
+
+
+    for (cfg_nbr = 0u; cfg_nbr < p_dev->CfgFS_TotalNbr; cfg_nbr++) {
+        p_cfg = USBD_CfgRefGet(p_dev, cfg_nbr);
+        if (p_cfg != (USBD_CFG *)0) {
+            p_cfg->DescCacheLen = 0u;
+        }
+    }
+
+#if (USBD_CFG_HS_EN == DEF_ENABLED)
+    for (cfg_nbr = 0u; cfg_nbr < p_dev->CfgHS_TotalNbr; cfg_nbr++) {
+        p_cfg = USBD_CfgRefGet(p_dev, cfg_nbr | USBD_CFG_NBR_SPD_BIT);
+        if (p_cfg != (USBD_CFG *)0) {
+            p_cfg->DescCacheLen = 0u;
+        }
+    }
+#endif
 }
+#endif
 
 
 /*
@@ -7302,6 +7935,9 @@ static  void  USBD_DescWrReq16 (USBD_DEV    *p_dev,
 *                   this pointer will store the error code, stop the rest of the data phase, skip the
 *                   status phase and ensure that the control endpoint 0 is stalled to notify the host
 *                   that an error has occurred.
+*
+*               (3) Data is copied in blocks limited by the remaining space in the buffer, so that class
+*                   descriptors written with USBD_DescWr() are not copied one octet at a time.
 *********************************************************************************************************
 */
 
@@ -7310,8 +7946,9 @@ static  void  USBD_DescWrReq (       USBD_DEV    *p_dev,
                                      CPU_INT16U   len)
 {
     CPU_INT08U  *p_desc;
-    CPU_INT08U   buf_cur_ix;
+    CPU_INT16U   buf_cur_ix;
     CPU_INT16U   len_req;
+    CPU_INT16U   len_copy;
     USBD_ERR     err;
     CPU_SR_ALLOC();
 
@@ -7339,12 +7976,18 @@ static  void  USBD_DescWrReq (       USBD_DEV    *p_dev,
                 len_req = 0u;
                 err     = USBD_ERR_ALLOC;
             }
-        } else {
-            p_desc[buf_cur_ix] = *p_buf;
-            p_buf++;
-            len--;
-            len_req--;
-            buf_cur_ix++;
+        } else {                                                /* Copy as much as fits in buf (see Note #3).           */
+            len_copy = DEF_MIN(len, len_req);
+            len_copy = DEF_MIN(len_copy, p_dev->DescBufMaxLen - buf_cur_ix);
+
+            Mem_Copy((void *)&p_desc[buf_cur_ix],
+                     (void *) p_buf,
+                              len_copy);
+
+            p_buf      += len_copy;
+            len        -= len_copy;
+            len_req    -= len_copy;
+            buf_cur_ix += len_copy;
         }
     }
 
@@ -7503,8 +8146,10 @@ static  void  USBD_EventSet (USBD_DRV         *p_drv,
     }
 #endif
 
-    p_core_event = USBD_CoreEventGet();
+    p_core_event = USBD_CoreEventGet(p_drv->DevNbr,
+                                     USBD_CORE_EVENT_LANE_BUS);
     if (p_core_event == (USBD_CORE_EVENT *)0) {
+        USBD_DBG_STATS_POOL_FAIL(&USBD_DbgStatsPoolCoreEvent[USBD_CORE_EVENT_LANE_BUS]);
         return;
     }
 
@@ -7512,7 +8157,7 @@ static  void  USBD_EventSet (USBD_DRV         *p_drv,
     p_core_event->DrvPtr = p_drv;
     p_core_event->Err    = USBD_ERR_NONE;
 
-    USBD_OS_CoreEventPut(p_core_event);
+    USBD_CoreEventPut(p_core_event);
 }
 
 
@@ -7520,17 +8165,22 @@ static  void  USBD_EventSet (USBD_DRV         *p_drv,
 *********************************************************************************************************
 *                                        USBD_CoreTaskHandler()
 *
-* Description : Process all core events and core operations.
+* Description : Process all core events and core operations of a core task.
 *
-* Argument(s) : none.
+* Argument(s) : task_ix     Index of the core task (see 'usbd_core.h  USB CORE TASKS').
 *
 * Return(s)   : none.
 *
-* Note(s)     : none.
+* Note(s)     : (1) The message received from the OS queue is only a wake-up token (see 'CORE EVENT LANE
+*                   Note #2').
+*
+*               (2) A USBD_EVENT_EP_PEND event processes the pending completions of a device once. If new
+*                   completions were merged meanwhile, the event is queued again behind the other events
+*                   of its lane, so that a busy endpoint cannot hold the core task.
 *********************************************************************************************************
 */
 
-void  USBD_CoreTaskHandler (void)
+void  USBD_CoreTaskHandler (CPU_INT08U  task_ix)
 {
     USBD_CORE_EVENT  *p_core_event;
     USBD_DEV         *p_dev;
@@ -7538,15 +8188,24 @@ void  USBD_CoreTaskHandler (void)
     CPU_INT08U        ep_addr;
     USBD_EVENT_CODE   event;
     USBD_ERR          err;
+#if (USBD_CFG_EP_CMPL_COALESCE_EN == DEF_ENABLED)
+    CPU_BOOLEAN       requeue;
+#endif
 
 
     while (DEF_TRUE) {
                                                                 /* Wait for an event.                                   */
-        p_core_event = (USBD_CORE_EVENT *)USBD_OS_CoreEventGet(0u, &err);
+        p_core_event = (USBD_CORE_EVENT *)USBD_OS_CoreEventGet(task_ix, 0u, &err);
+        if (p_core_event != (USBD_CORE_EVENT *)0) {
+            p_core_event = USBD_CoreEventNext(task_ix);         /* Take highest prio event (see Note #1).               */
+        }
         if (p_core_event != (USBD_CORE_EVENT *)0) {
             event = p_core_event->Type;
             p_drv = p_core_event->DrvPtr;
             p_dev = USBD_DevRefGet(p_drv->DevNbr);
+#if (USBD_CFG_EP_CMPL_COALESCE_EN == DEF_ENABLED)
+            requeue = DEF_NO;
+#endif
 
             if (p_dev != (USBD_DEV *)0) {
                 if (p_dev->State != USBD_DEV_STATE_STOPPING) {
@@ -7566,6 +8225,9 @@ void  USBD_CoreTaskHandler (void)
                                  p_dev->State = p_dev->StatePrev;
                              }
                              ep_addr = p_core_event->EP_Addr;
+#if (USBD_CFG_EP_CMPL_COALESCE_EN == DEF_ENABLED)
+                             USBD_EventEP_PendFlush(p_drv, ep_addr);    /* Process older merged cmpl first.             */
+#endif
                              USBD_EP_XferAsyncProcess(p_drv, ep_addr, p_core_event->Err);
                              break;
 
@@ -7577,12 +8239,28 @@ void  USBD_CoreTaskHandler (void)
                              USBD_StdReqHandler(p_dev);
                              break;
 
+#if (USBD_CFG_EP_CMPL_COALESCE_EN == DEF_ENABLED)
+                        case USBD_EVENT_EP_PEND:                /* ------------- COALESCED ENDPOINT EVENTS ------------ */
+                             if (p_dev->State == USBD_DEV_STATE_SUSPENDED) {
+                                 p_dev->State = p_dev->StatePrev;
+                             }
+                             requeue = USBD_EventEP_PendProcess(p_drv);
+                             break;
+#endif
+
                         default:
                              break;
                     }
                 }
             }
 
+#if (USBD_CFG_EP_CMPL_COALESCE_EN == DEF_ENABLED)
+            if (requeue == DEF_YES) {                           /* Cmpl still pending: keep event queued (see Note #2). */
+                USBD_CoreEventPut(p_core_event);
+                continue;
+            }
+#endif
+
             USBD_CoreEventFree(p_core_event);                   /* Return event to free pool.                           */
         }
     }
@@ -7764,34 +8442,55 @@ static  void  USBD_EventProcess (USBD_DEV         *p_dev,
 *********************************************************************************************************
 *                                        USBD_CoreEventGet()
 *
-* Description : Get a new core event from the pool.
+* Description : Get a new core event from the pool of a lane.
 *
-* Argument(s) : none.
+* Argument(s) : dev_nbr     Device number.
+*
+*               lane        Lane from which the core event is allocated :
+*
+*                               USBD_CORE_EVENT_LANE_BUS    Bus & setup events.
+*                               USBD_CORE_EVENT_LANE_EP     Endpoint events.
 *
 * Return(s)   : Pointer to core event, if NO error(s).
 *
 *               Pointer to NULL,       otherwise.
 *
-* Note(s)     : none.
+* Note(s)     : (1) A refused allocation is accounted in the pool stats by the caller, so that the location
+*                   of the dropped event is recorded.
 *********************************************************************************************************
 */
 
-static  USBD_CORE_EVENT  *USBD_CoreEventGet (void)
+static  USBD_CORE_EVENT  *USBD_CoreEventGet (CPU_INT08U  dev_nbr,
+                                             CPU_INT08U  lane)
 {
-    USBD_CORE_EVENT  *p_core_event;
+    USBD_CORE_EVENT_LANE  *p_lane;
+    USBD_CORE_EVENT       *p_core_event;
+    CPU_INT08U             task_ix;
     CPU_SR_ALLOC();
 
 
+#if (USBD_CFG_CORE_TASK_PER_DEV_EN == DEF_DISABLED)
+    (void)dev_nbr;                                              /* Single core task serves every dev.                   */
+#endif
+
+    task_ix = USBD_CORE_TASK_IX(dev_nbr);
+    p_lane  = &USBD_CoreEventLaneTbl[task_ix][lane];
+
     CPU_CRITICAL_ENTER();
-    if (USBD_CoreEventPoolIx < 1u) {                            /* Chk if core event is avail.                          */
+    if (p_lane->FreeCnt < 1u) {                                 /* Chk if core event is avail.                          */
         CPU_CRITICAL_EXIT();
         return ((USBD_CORE_EVENT *)0);
     }
 
-    USBD_CoreEventPoolIx--;
-    p_core_event = USBD_CoreEventPoolPtrs[USBD_CoreEventPoolIx];
+    p_lane->FreeCnt--;
+    p_core_event = USBD_CoreEventPoolPtrs[p_lane->Ix + p_lane->FreeCnt];
     CPU_CRITICAL_EXIT();
 
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_DbgStatsPoolCoreEvent[lane]);
+
+    p_core_event->TaskIx = task_ix;
+    p_core_event->Lane   = lane;
+
     return (p_core_event);
 }
 
@@ -7800,7 +8499,7 @@ static  USBD_CORE_EVENT  *USBD_CoreEventGet (void)
 *********************************************************************************************************
 *                                        USBD_CoreEventFree()
 *
-* Description : Return a core event to the pool.
+* Description : Return a core event to the pool of its lane.
 *
 * Argument(s) : p_core_event    Pointer to core event.
 *
@@ -7812,168 +8511,526 @@ static  USBD_CORE_EVENT  *USBD_CoreEventGet (void)
 
 static  void  USBD_CoreEventFree (USBD_CORE_EVENT  *p_core_event)
 {
+    USBD_CORE_EVENT_LANE  *p_lane;
     CPU_SR_ALLOC();
 
 
+    p_lane = &USBD_CoreEventLaneTbl[p_core_event->TaskIx][p_core_event->Lane];
+
     CPU_CRITICAL_ENTER();
-    if (USBD_CoreEventPoolIx == USBD_CORE_EVENT_NBR_TOTAL) {
+    if (p_lane->FreeCnt == p_lane->Size) {
         CPU_CRITICAL_EXIT();
         return;
     }
 
-    USBD_CoreEventPoolPtrs[USBD_CoreEventPoolIx] = p_core_event;
-    USBD_CoreEventPoolIx++;
+    USBD_CoreEventPoolPtrs[p_lane->Ix + p_lane->FreeCnt] = p_core_event;
+    p_lane->FreeCnt++;
     CPU_CRITICAL_EXIT();
+
+    USBD_DBG_STATS_POOL_FREE(&USBD_DbgStatsPoolCoreEvent[p_core_event->Lane]);
 }
 
 
 /*
 *********************************************************************************************************
-*                                          USBD_IF_RefGet()
+*                                         USBD_CoreEventPut()
 *
-* Description : Get interface structure.
-*
-* Argument(s) : p_cfg       Pointer to configuration structure.
+* Description : Queue a core event in its lane & wake up the core task.
 *
-*               if_nbr      Interface number.
+* Argument(s) : p_core_event    Pointer to core event.
 *
-* Return(s)   : Pointer to interface structure, if NO error(s).
+* Return(s)   : none.
 *
-*               Pointer to NULL,                otherwise.
+* Note(s)     : (1) A lane can hold all the events of its pool, so the lane FIFO never overflows.
 *
-* Note(s)     : none.
+*               (2) The event is queued in its lane before the wake-up token is posted, so that the core
+*                   task always finds at least one pending event when it receives a token.
 *********************************************************************************************************
 */
 
-static  USBD_IF  *USBD_IF_RefGet (const  USBD_CFG    *p_cfg,
-                                         CPU_INT08U   if_nbr)
+static  void  USBD_CoreEventPut (USBD_CORE_EVENT  *p_core_event)
 {
-    USBD_IF     *p_if;
-#if (USBD_CFG_OPTIMIZE_SPD == DEF_DISABLED)
-    CPU_INT08U   if_ix;
-#endif
+    USBD_CORE_EVENT_LANE  *p_lane;
+    CPU_SR_ALLOC();
 
-    if (if_nbr >= p_cfg->IF_NbrTotal) {                         /* Chk if IF nbr is valid.                              */
-        return ((USBD_IF *)0);
-    }
 
-#if (USBD_CFG_OPTIMIZE_SPD == DEF_ENABLED)                      /* Get IF struct.                                       */
-    p_if = p_cfg->IF_TblPtrs[if_nbr];
-#else
-    p_if = p_cfg->IF_HeadPtr;
+    p_lane = &USBD_CoreEventLaneTbl[p_core_event->TaskIx][p_core_event->Lane];
 
-    for (if_ix = 0u; if_ix < if_nbr; if_ix++) {
-        p_if = p_if->NextPtr;
+    CPU_CRITICAL_ENTER();                                       /* See Note #1.                                         */
+    USBD_CoreEventQPtrs[p_lane->Ix + p_lane->IxIn] = p_core_event;
+    p_lane->IxIn++;
+    if (p_lane->IxIn >= p_lane->Size) {
+        p_lane->IxIn = 0u;
     }
-#endif
+    p_lane->Cnt++;
+    CPU_CRITICAL_EXIT();
 
-    return (p_if);
+    USBD_OS_CoreEventPut(p_core_event->TaskIx,                  /* Post wake-up token (see Note #2).                    */
+                         p_core_event);
 }
 
 
 /*
 *********************************************************************************************************
-*                                         USBD_IF_AltRefGet()
-*
-* Description : Get alternate setting interface structure.
+*                                        USBD_CoreEventNext()
 *
-* Argument(s) : p_if        Pointer to interface structure.
+* Description : Get the oldest pending core event of the highest priority lane of a core task that is not
+*               empty.
 *
-*               if_alt_nbr  Alternate setting interface number.
+* Argument(s) : task_ix     Index of the core task.
 *
-* Return(s)   : Pointer to alternate setting interface structure, if NO error(s).
+* Return(s)   : Pointer to core event, if any event pending.
 *
-*               Pointer to NULL,                                  otherwise.
+*               Pointer to NULL,       otherwise.
 *
 * Note(s)     : none.
 *********************************************************************************************************
 */
 
-static  USBD_IF_ALT  *USBD_IF_AltRefGet (const  USBD_IF     *p_if,
-                                                CPU_INT08U   if_alt_nbr)
+static  USBD_CORE_EVENT  *USBD_CoreEventNext (CPU_INT08U  task_ix)
 {
-    USBD_IF_ALT  *p_if_alt;
-#if (USBD_CFG_OPTIMIZE_SPD == DEF_DISABLED)
-    CPU_INT08U    if_alt_ix;
-#endif
+    USBD_CORE_EVENT_LANE  *p_lane;
+    USBD_CORE_EVENT       *p_core_event;
+    CPU_INT08U             lane;
+    CPU_SR_ALLOC();
 
-    if (if_alt_nbr >= p_if->AltNbrTotal) {                      /* Chk alt setting nbr.                                 */
-        return ((USBD_IF_ALT *)0);
-    }
 
-#if (USBD_CFG_OPTIMIZE_SPD == DEF_ENABLED)                      /* Get alt IF struct.                                   */
-    p_if_alt = p_if->AltTblPtrs[if_alt_nbr];
-#else
-    p_if_alt = p_if->AltHeadPtr;
+    p_core_event = (USBD_CORE_EVENT *)0;
 
-    for (if_alt_ix = 0u; if_alt_ix < if_alt_nbr; if_alt_ix++) {
-        p_if_alt = p_if_alt->NextPtr;
+    CPU_CRITICAL_ENTER();
+    for (lane = 0u; lane < USBD_CORE_EVENT_LANE_NBR; lane++) {  /* Lanes are ordered by decreasing prio.               */
+        p_lane = &USBD_CoreEventLaneTbl[task_ix][lane];
+        if (p_lane->Cnt > 0u) {
+            p_core_event = USBD_CoreEventQPtrs[p_lane->Ix + p_lane->IxOut];
+            p_lane->IxOut++;
+            if (p_lane->IxOut >= p_lane->Size) {
+                p_lane->IxOut = 0u;
+            }
+            p_lane->Cnt--;
+            break;
+        }
     }
-#endif
+    CPU_CRITICAL_EXIT();
 
-    return (p_if_alt);
+    return (p_core_event);
 }
 
 
 /*
 *********************************************************************************************************
-*                                          USBD_IF_AltOpen()
-*
-* Description : Open all endpoints from the specified alternate setting.
+*                                        USBD_EventEP_Merge()
 *
-* Argument(s) : p_dev       Pointer to USB device.
-*               -----       Argument validated in 'USBD_DevSetupPkt()' before posting the event to queue.
+* Description : Merge an endpoint completion with the pending completions of its device.
 *
-*               if_nbr      Interface number.
+* Argument(s) : p_drv       Pointer to device driver.
 *
-*               p_if_alt    Pointer to alternate setting interface.
+*               ep_addr     Endpoint address.
 *
-*               p_err       Pointer to variable that will receive the return error code from this function :
+*               err         Error code returned by the USB device driver.
 *
-*                               USBD_ERR_NONE               Alternate setting successfully opened.
+* Return(s)   : DEF_YES, if completion merged.
 *
-*                               - RETURNED BY USBD_EP_Open() -
-*                               See USBD_EP_Open() for additional return error codes.
+*               DEF_NO,  if completion must be queued as a regular endpoint event.
 *
-* Return(s)   : none.
+* Note(s)     : (1) See 'PENDING ENDPOINT COMPLETIONS DATA TYPE Notes #2 & #3'.
 *
-* Note(s)     : none.
+*               (2) The core event is allocated outside the critical section. If the core task or another
+*                   ISR sets 'Map' in the meantime, the completion is merged & the event is returned to
+*                   the pool.
 *********************************************************************************************************
 */
 
-static  void  USBD_IF_AltOpen (       USBD_DEV     *p_dev,
-                                      CPU_INT08U    if_nbr,
-                               const  USBD_IF_ALT  *p_if_alt,
-                                      USBD_ERR     *p_err)
+#if (USBD_CFG_EP_CMPL_COALESCE_EN == DEF_ENABLED)
+static  CPU_BOOLEAN  USBD_EventEP_Merge (USBD_DRV    *p_drv,
+                                         CPU_INT08U   ep_addr,
+                                         USBD_ERR     err)
 {
-    CPU_INT08U     ep_nbr;
-    CPU_INT08U     ep_phy_nbr;
-    CPU_BOOLEAN    valid;
-    USBD_EP_INFO  *p_ep;
-#if (USBD_CFG_OPTIMIZE_SPD == DEF_ENABLED)
-    CPU_INT32U     ep_alloc_map;
-#endif
+    USBD_EP_CMPL_PEND  *p_pend;
+    USBD_CORE_EVENT    *p_core_event;
+    CPU_INT08U          ep_phy_nbr;
     CPU_SR_ALLOC();
 
 
-    valid = DEF_OK;
+    p_pend       = &USBD_EP_CmplPendTbl[p_drv->DevNbr];
+    ep_phy_nbr   =  USBD_EP_ADDR_TO_PHY(ep_addr);
+    p_core_event = (USBD_CORE_EVENT *)0;
 
-#if (USBD_CFG_OPTIMIZE_SPD == DEF_ENABLED)
-    ep_alloc_map = p_if_alt->EP_TblMap;
-    while (ep_alloc_map != DEF_BIT_NONE) {
-        ep_nbr     = (CPU_INT08U)CPU_CntTrailZeros32(ep_alloc_map);
-        p_ep       =  p_if_alt->EP_TblPtrs[ep_nbr];
-        ep_phy_nbr =  USBD_EP_ADDR_TO_PHY(p_ep->Addr);
+    CPU_CRITICAL_ENTER();
+    if ((p_pend->ErrTbl[ep_phy_nbr]      != USBD_ERR_NONE) ||   /* See Note #1.                                         */
+        (p_pend->EventCntTbl[ep_phy_nbr] >  0u)) {
+        CPU_CRITICAL_EXIT();
+        return (DEF_NO);
+    }
 
-        CPU_CRITICAL_ENTER();
-        p_dev->EP_IF_Tbl[ep_phy_nbr] = if_nbr;
+    if (p_pend->Map == DEF_BIT_NONE) {                          /* No pending cmpl: alloc event (see Note #2).          */
         CPU_CRITICAL_EXIT();
 
-        USBD_EP_Open(&p_dev->Drv,
-                      p_ep->Addr,
-                      p_ep->MaxPktSize,
-                      p_ep->Attrib,
-                      p_ep->Interval,
+        p_core_event = USBD_CoreEventGet(p_drv->DevNbr,
+                                         USBD_CORE_EVENT_LANE_EP);
+        if (p_core_event == (USBD_CORE_EVENT *)0) {
+            return (DEF_NO);
+        }
+
+        p_core_event->Type    = USBD_EVENT_EP_PEND;
+        p_core_event->DrvPtr  = p_drv;
+        p_core_event->EP_Addr = USBD_EP_ADDR_NONE;
+        p_core_event->Err     = USBD_ERR_NONE;
+
+        CPU_CRITICAL_ENTER();
+        if (p_pend->Map != DEF_BIT_NONE) {                      /* Map set meanwhile: event no longer needed.           */
+            CPU_CRITICAL_EXIT();
+            USBD_CoreEventFree(p_core_event);
+            p_core_event = (USBD_CORE_EVENT *)0;
+            CPU_CRITICAL_ENTER();
+        }
+    }
+
+    DEF_BIT_SET(p_pend->Map, DEF_BIT32(ep_phy_nbr));
+    p_pend->CntTbl[ep_phy_nbr]++;
+    p_pend->ErrTbl[ep_phy_nbr] = err;
+    CPU_CRITICAL_EXIT();
+
+    if (p_core_event != (USBD_CORE_EVENT *)0) {
+        USBD_CoreEventPut(p_core_event);
+    }
+
+    return (DEF_YES);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                     USBD_EventEP_PendProcess()
+*
+* Description : Process the pending endpoint completions of a device.
+*
+* Argument(s) : p_drv       Pointer to device driver.
+*
+* Return(s)   : DEF_YES, if completions were merged during processing.
+*
+*               DEF_NO,  otherwise.
+*
+* Note(s)     : (1) Each endpoint flagged when the function is entered is processed once (see
+*                   USBD_EventEP_PendRun()). An endpoint already processed by one of its regular
+*                   events is found without pending completion.
+*
+*               (2) The event that called this function stays in charge of 'Map' while 'Map' is not zero,
+*                   so that the ISR never queues a second USBD_EVENT_EP_PEND event for the device.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_EP_CMPL_COALESCE_EN == DEF_ENABLED)
+static  CPU_BOOLEAN  USBD_EventEP_PendProcess (USBD_DRV  *p_drv)
+{
+    USBD_EP_CMPL_PEND  *p_pend;
+    CPU_INT32U          map;
+    CPU_INT08U          ep_phy_nbr;
+    CPU_BOOLEAN         pend;
+    CPU_SR_ALLOC();
+
+
+    p_pend = &USBD_EP_CmplPendTbl[p_drv->DevNbr];
+
+    CPU_CRITICAL_ENTER();
+    map = p_pend->Map;
+    CPU_CRITICAL_EXIT();
+
+    while (map != DEF_BIT_NONE) {                               /* See Note #1.                                         */
+        ep_phy_nbr = (CPU_INT08U)CPU_CntTrailZeros32(map);
+        DEF_BIT_CLR(map, DEF_BIT32(ep_phy_nbr));
+
+        USBD_EventEP_PendRun(p_drv, ep_phy_nbr, DEF_YES);
+    }
+
+    CPU_CRITICAL_ENTER();                                       /* See Note #2.                                         */
+    pend = (p_pend->Map != DEF_BIT_NONE) ? DEF_YES : DEF_NO;
+    CPU_CRITICAL_EXIT();
+
+    return (pend);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_EventEP_PendFlush()
+*
+* Description : Process the pending completions of an endpoint ahead of one of its regular endpoint events.
+*
+* Argument(s) : p_drv       Pointer to device driver.
+*
+*               ep_addr     Endpoint address.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) See 'PENDING ENDPOINT COMPLETIONS DATA TYPE Note #3'. The regular event is no longer
+*                   counted once taken by the core task. A completion notified from now on is more recent
+*                   than the event and may be merged again.
+*
+*               (2) The bit of the endpoint stays set in 'Map', so that the USBD_EVENT_EP_PEND event of the
+*                   device, if any, stays in charge of it (see USBD_EventEP_PendProcess() Note #2). That
+*                   event then finds no pending completion for the endpoint.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_EP_CMPL_COALESCE_EN == DEF_ENABLED)
+static  void  USBD_EventEP_PendFlush (USBD_DRV    *p_drv,
+                                      CPU_INT08U   ep_addr)
+{
+    USBD_EP_CMPL_PEND  *p_pend;
+    CPU_INT08U          ep_phy_nbr;
+    CPU_SR_ALLOC();
+
+
+    p_pend     = &USBD_EP_CmplPendTbl[p_drv->DevNbr];
+    ep_phy_nbr =  USBD_EP_ADDR_TO_PHY(ep_addr);
+
+    CPU_CRITICAL_ENTER();                                       /* See Note #1.                                         */
+    if (p_pend->EventCntTbl[ep_phy_nbr] > 0u) {
+        p_pend->EventCntTbl[ep_phy_nbr]--;
+    }
+    CPU_CRITICAL_EXIT();
+
+    USBD_EventEP_PendRun(p_drv, ep_phy_nbr, DEF_NO);            /* See Note #2.                                         */
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_EventEP_PendRun()
+*
+* Description : Process the pending completions of an endpoint.
+*
+* Argument(s) : p_drv       Pointer to device driver.
+*
+*               ep_phy_nbr  Endpoint physical number.
+*
+*               map_clr     Clear the bit of the endpoint in 'Map' :
+*
+*                               DEF_YES     Called from the USBD_EVENT_EP_PEND event.
+*                               DEF_NO      Called from a regular endpoint event.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) The pending completions are taken from the table in a critical section, then processed
+*                   in order. The error code of the endpoint is passed with its last completion.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_EP_CMPL_COALESCE_EN == DEF_ENABLED)
+static  void  USBD_EventEP_PendRun (USBD_DRV     *p_drv,
+                                    CPU_INT08U    ep_phy_nbr,
+                                    CPU_BOOLEAN   map_clr)
+{
+    USBD_EP_CMPL_PEND  *p_pend;
+    CPU_INT16U          cnt;
+    CPU_INT08U          ep_addr;
+    USBD_ERR            err;
+    CPU_SR_ALLOC();
+
+
+    p_pend = &USBD_EP_CmplPendTbl[p_drv->DevNbr];
+
+    CPU_CRITICAL_ENTER();                                       /* See Note #1.                                         */
+    cnt                        = p_pend->CntTbl[ep_phy_nbr];
+    err                        = p_pend->ErrTbl[ep_phy_nbr];
+    p_pend->CntTbl[ep_phy_nbr] = 0u;
+    p_pend->ErrTbl[ep_phy_nbr] = USBD_ERR_NONE;
+    if (map_clr == DEF_YES) {
+        DEF_BIT_CLR(p_pend->Map, DEF_BIT32(ep_phy_nbr));
+    }
+    CPU_CRITICAL_EXIT();
+
+    ep_addr = USBD_EP_PHY_TO_ADDR(ep_phy_nbr);
+    while (cnt > 1u) {
+        USBD_EP_XferAsyncProcess(p_drv, ep_addr, USBD_ERR_NONE);
+        cnt--;
+    }
+    if (cnt == 1u) {
+        USBD_EP_XferAsyncProcess(p_drv, ep_addr, err);
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_EventEP_PendClr()
+*
+* Description : Discard the pending endpoint completions of a device.
+*
+* Argument(s) : dev_nbr     Device number.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) A USBD_EVENT_EP_PEND event still queued for the device finds no pending completion &
+*                   is freed.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_EP_CMPL_COALESCE_EN == DEF_ENABLED)
+static  void  USBD_EventEP_PendClr (CPU_INT08U  dev_nbr)
+{
+    CPU_SR_ALLOC();
+
+
+    CPU_CRITICAL_ENTER();
+    Mem_Clr((void     *)&USBD_EP_CmplPendTbl[dev_nbr],
+            (CPU_SIZE_T) sizeof(USBD_EP_CMPL_PEND));
+    CPU_CRITICAL_EXIT();
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_IF_RefGet()
+*
+* Description : Get interface structure.
+*
+* Argument(s) : p_cfg       Pointer to configuration structure.
+*
+*               if_nbr      Interface number.
+*
+* Return(s)   : Pointer to interface structure, if NO error(s).
+*
+*               Pointer to NULL,                otherwise.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  USBD_IF  *USBD_IF_RefGet (const  USBD_CFG    *p_cfg,
+                                         CPU_INT08U   if_nbr)
+{
+    USBD_IF     *p_if;
+#if (USBD_CFG_OPTIMIZE_SPD == DEF_DISABLED)
+    CPU_INT08U   if_ix;
+#endif
+
+    if (if_nbr >= p_cfg->IF_NbrTotal) {                         /* Chk if IF nbr is valid.                              */
+        return ((USBD_IF *)0);
+    }
+
+#if (USBD_CFG_OPTIMIZE_SPD == DEF_ENABLED)                      /* Get IF struct.                                       */
+    p_if = p_cfg->IF_TblPtrs[if_nbr];
+#else
+    p_if = p_cfg->IF_HeadPtr;
+
+    for (if_ix = 0u; if_ix < if_nbr; if_ix++) {
+        p_if = p_if->NextPtr;
+    }
+#endif
+
+    return (p_if);
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_IF_AltRefGet()
+*
+* Description : Get alternate setting interface structure.
+*
+* Argument(s) : p_if        Pointer to interface structure.
+*
+*               if_alt_nbr  Alternate setting interface number.
+*
+* Return(s)   : Pointer to alternate setting interface structure, if NO error(s).
+*
+*               Pointer to NULL,                                  otherwise.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  USBD_IF_ALT  *USBD_IF_AltRefGet (const  USBD_IF     *p_if,
+                                                CPU_INT08U   if_alt_nbr)
+{
+    USBD_IF_ALT  *p_if_alt;
+#if (USBD_CFG_OPTIMIZE_SPD == DEF_DISABLED)
+    CPU_INT08U    if_alt_ix;
+#endif
+
+    if (if_alt_nbr >= p_if->AltNbrTotal) {                      /* Chk alt setting nbr.                                 */
+        return ((USBD_IF_ALT *)0);
+    }
+
+#if (USBD_CFG_OPTIMIZE_SPD == DEF_ENABLED)                      /* Get alt IF struct.                                   */
+    p_if_alt = p_if->AltTblPtrs[if_alt_nbr];
+#else
+    p_if_alt = p_if->AltHeadPtr;
+
+    for (if_alt_ix = 0u; if_alt_ix < if_alt_nbr; if_alt_ix++) {
+        p_if_alt = p_if_alt->NextPtr;
+    }
+#endif
+
+    return (p_if_alt);
+}
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_IF_AltOpen()
+*
+* Description : Open all endpoints from the specified alternate setting.
+*
+* Argument(s) : p_dev       Pointer to USB device.
+*               -----       Argument validated in 'USBD_DevSetupPkt()' before posting the event to queue.
+*
+*               if_nbr      Interface number.
+*
+*               p_if_alt    Pointer to alternate setting interface.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE               Alternate setting successfully opened.
+*
+*                               - RETURNED BY USBD_EP_Open() -
+*                               See USBD_EP_Open() for additional return error codes.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+static  void  USBD_IF_AltOpen (       USBD_DEV     *p_dev,
+                                      CPU_INT08U    if_nbr,
+                               const  USBD_IF_ALT  *p_if_alt,
+                                      USBD_ERR     *p_err)
+{
+    CPU_INT08U     ep_nbr;
+    CPU_INT08U     ep_phy_nbr;
+    CPU_BOOLEAN    valid;
+    USBD_EP_INFO  *p_ep;
+#if (USBD_CFG_OPTIMIZE_SPD == DEF_ENABLED)
+    CPU_INT32U     ep_alloc_map;
+#endif
+    CPU_SR_ALLOC();
+
+
+    valid = DEF_OK;
+
+#if (USBD_CFG_OPTIMIZE_SPD == DEF_ENABLED)
+    ep_alloc_map = p_if_alt->EP_TblMap;
+    while (ep_alloc_map != DEF_BIT_NONE) {
+        ep_nbr     = (CPU_INT08U)CPU_CntTrailZeros32(ep_alloc_map);
+        p_ep       =  p_if_alt->EP_TblPtrs[ep_nbr];
+        ep_phy_nbr =  USBD_EP_ADDR_TO_PHY(p_ep->Addr);
+
+        CPU_CRITICAL_ENTER();
+        p_dev->EP_IF_Tbl[ep_phy_nbr] = if_nbr;
+        CPU_CRITICAL_EXIT();
+
+        USBD_EP_Open(&p_dev->Drv,
+                      p_ep->Addr,
+                      p_ep->MaxPktSize,
+                      p_ep->Attrib,
+                      p_ep->Interval,
                       p_err);
         if (*p_err != USBD_ERR_NONE) {
                 valid = DEF_FAIL;
@@ -8296,7 +9353,7 @@ static  CPU_INT08U  USBD_StrDescIxGet (const  USBD_DEV  *p_dev,
 *
 * Return(s)   : none.
 *
-* Note(s)     : none.
+* Note(s)     : (1) If USBD_CFG_DBG_TRACE_BIN_EN is DEF_ENABLED, the event is stored in the binary trace ring.
 *********************************************************************************************************
 */
 
@@ -8306,13 +9363,18 @@ void  USBD_Dbg (const  CPU_CHAR    *p_msg,
                        CPU_INT08U   if_nbr,
                        USBD_ERR     err)
 {
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
     USBD_DBG_EVENT  *p_event;
+#endif
 
 
     if (p_msg == (const CPU_CHAR *)0) {
         return;
     }
 
+#if (USBD_CFG_DBG_TRACE_BIN_EN == DEF_ENABLED)                  /* See Note #1.                                         */
+    USBD_DbgTraceRecPut(p_msg, ep_addr, if_nbr, DEF_NO, 0u, err);
+#else
     p_event = USBD_DbgEventGet();
     if (p_event != (USBD_DBG_EVENT *)0) {
         p_event->MsgPtr  = p_msg;
@@ -8323,6 +9385,7 @@ void  USBD_Dbg (const  CPU_CHAR    *p_msg,
         USBD_DbgEventPut(p_event);
         USBD_OS_DbgEventRdy();
     }
+#endif
 }
 #endif
 
@@ -8345,7 +9408,7 @@ void  USBD_Dbg (const  CPU_CHAR    *p_msg,
 *
 * Return(s)   : none.
 *
-* Note(s)     : none.
+* Note(s)     : (1) If USBD_CFG_DBG_TRACE_BIN_EN is DEF_ENABLED, the event is stored in the binary trace ring.
 *********************************************************************************************************
 */
 
@@ -8356,13 +9419,18 @@ void  USBD_DbgArg (const  CPU_CHAR    *p_msg,
                           CPU_INT32U   arg,
                           USBD_ERR     err)
 {
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
     USBD_DBG_EVENT  *p_event;
+#endif
 
 
     if (p_msg == (const CPU_CHAR *)0) {
         return;
     }
 
+#if (USBD_CFG_DBG_TRACE_BIN_EN == DEF_ENABLED)                  /* See Note #1.                                         */
+    USBD_DbgTraceRecPut(p_msg, ep_addr, if_nbr, DEF_YES, arg, err);
+#else
     p_event = USBD_DbgEventGet();
     if (p_event != (USBD_DBG_EVENT *)0) {
         p_event->MsgPtr  = p_msg;
@@ -8374,6 +9442,262 @@ void  USBD_DbgArg (const  CPU_CHAR    *p_msg,
         USBD_DbgEventPut(p_event);
         USBD_OS_DbgEventRdy();
     }
+#endif
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_DbgStatsPoolReg()
+*
+* Description : Register a pool in the pool usage stats.
+*
+* Argument(s) : p_pool      Pointer to pool stats object.
+*
+*               p_name      Pointer to pool name.
+*
+*               size        Number of objects in the pool.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) The pool stats are cleared. A pool already registered keeps its position in the list.
+*
+*               (2) The list of registered pools is cleared by USBD_Init(). Class drivers MUST register
+*                   their pools after USBD_Init() has been called.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_DBG_STATS_POOL_EN == DEF_ENABLED)
+void  USBD_DbgStatsPoolReg (       USBD_DBG_STATS_POOL  *p_pool,
+                            const  CPU_CHAR             *p_name,
+                                   CPU_INT32U            size)
+{
+    USBD_DBG_STATS_POOL  *p_pool_cur;
+    CPU_SR_ALLOC();
+
+
+    CPU_CRITICAL_ENTER();
+    p_pool->NamePtr      =  p_name;
+    p_pool->Size         =  size;
+    p_pool->Used         =  0u;
+    p_pool->UsedMax      =  0u;
+    p_pool->AllocFailCnt =  0u;
+    p_pool->FailLocPtr   = (const CPU_CHAR *)0;
+
+    p_pool_cur = USBD_DbgStatsPoolHeadPtr;                      /* See Note #1.                                         */
+    while ((p_pool_cur != (USBD_DBG_STATS_POOL *)0) &&
+           (p_pool_cur != p_pool)) {
+        p_pool_cur = p_pool_cur->NextPtr;
+    }
+
+    if (p_pool_cur == (USBD_DBG_STATS_POOL *)0) {               /* Add pool at end of list.                             */
+        p_pool->NextPtr = (USBD_DBG_STATS_POOL *)0;
+        if (USBD_DbgStatsPoolTailPtr == (USBD_DBG_STATS_POOL *)0) {
+            USBD_DbgStatsPoolHeadPtr          = p_pool;
+        } else {
+            USBD_DbgStatsPoolTailPtr->NextPtr = p_pool;
+        }
+        USBD_DbgStatsPoolTailPtr = p_pool;
+        USBD_DbgStatsPoolNbr++;
+    }
+    CPU_CRITICAL_EXIT();
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_DbgStatsPoolAlloc()
+*
+* Description : Account for an object allocated from a pool.
+*
+* Argument(s) : p_pool      Pointer to pool stats object.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_DBG_STATS_POOL_EN == DEF_ENABLED)
+void  USBD_DbgStatsPoolAlloc (USBD_DBG_STATS_POOL  *p_pool)
+{
+    CPU_SR_ALLOC();
+
+
+    CPU_CRITICAL_ENTER();
+    p_pool->Used++;
+    if (p_pool->Used > p_pool->UsedMax) {
+        p_pool->UsedMax = p_pool->Used;
+    }
+    CPU_CRITICAL_EXIT();
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_DbgStatsPoolFree()
+*
+* Description : Account for an object returned to a pool.
+*
+* Argument(s) : p_pool      Pointer to pool stats object.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_DBG_STATS_POOL_EN == DEF_ENABLED)
+void  USBD_DbgStatsPoolFree (USBD_DBG_STATS_POOL  *p_pool)
+{
+    CPU_SR_ALLOC();
+
+
+    CPU_CRITICAL_ENTER();
+    if (p_pool->Used > 0u) {
+        p_pool->Used--;
+    }
+    CPU_CRITICAL_EXIT();
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_DbgStatsPoolFail()
+*
+* Description : Account for an allocation refused by a pool.
+*
+* Argument(s) : p_pool      Pointer to pool stats object.
+*
+*               p_loc       Pointer to string holding the location of the allocation.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Only the location of the first refused allocation is kept. It is normally provided by
+*                   USBD_DBG_STATS_POOL_FAIL() as "file:line".
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_DBG_STATS_POOL_EN == DEF_ENABLED)
+void  USBD_DbgStatsPoolFail (       USBD_DBG_STATS_POOL  *p_pool,
+                             const  CPU_CHAR             *p_loc)
+{
+    CPU_SR_ALLOC();
+
+
+    CPU_CRITICAL_ENTER();
+    if (p_pool->FailLocPtr == (const CPU_CHAR *)0) {            /* See Note #1.                                         */
+        p_pool->FailLocPtr = p_loc;
+    }
+    p_pool->AllocFailCnt++;
+    CPU_CRITICAL_EXIT();
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_DbgStatsPoolNbrGet()
+*
+* Description : Get number of pools registered in the pool usage stats.
+*
+* Argument(s) : none.
+*
+* Return(s)   : Number of registered pools.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_DBG_STATS_POOL_EN == DEF_ENABLED)
+CPU_INT08U  USBD_DbgStatsPoolNbrGet (void)
+{
+    return (USBD_DbgStatsPoolNbr);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_DbgStatsPoolGet()
+*
+* Description : Get a snapshot of the usage stats of a pool.
+*
+* Argument(s) : pool_ix     Index of the pool, between 0 and USBD_DbgStatsPoolNbrGet() - 1.
+*
+*               p_stats     Pointer to variable that will receive the pool stats.
+*
+*               reset       Flag indicating if the stats are reset once copied :
+*
+*                               DEF_YES     Reset   stats (see Note #2).
+*                               DEF_NO      Keep    stats.
+*
+*               p_err       Pointer to variable that will receive return error code from this function :
+*
+*                               USBD_ERR_NONE           Pool stats successfully copied.
+*                               USBD_ERR_NULL_PTR       Null pointer passed to 'p_stats'.
+*                               USBD_ERR_INVALID_ARG    Invalid pool index.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) See 'usbd_core.h  POOL USAGE STATS' for the definition of the stats. The 'NextPtr'
+*                   field of the snapshot is cleared.
+*
+*               (2) The high-water mark restarts from the current use. The refused allocations counter and
+*                   the first failure location are cleared.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_DBG_STATS_POOL_EN == DEF_ENABLED)
+void  USBD_DbgStatsPoolGet (CPU_INT08U            pool_ix,
+                            USBD_DBG_STATS_POOL  *p_stats,
+                            CPU_BOOLEAN           reset,
+                            USBD_ERR             *p_err)
+{
+    USBD_DBG_STATS_POOL  *p_pool;
+    CPU_SR_ALLOC();
+
+
+#if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)                /* ---------------- VALIDATE ARGUMENTS ---------------- */
+    if (p_err == (USBD_ERR *)0) {                               /* Validate error ptr.                                  */
+        CPU_SW_EXCEPTION(;);
+    }
+
+    if (p_stats == (USBD_DBG_STATS_POOL *)0) {
+       *p_err = USBD_ERR_NULL_PTR;
+        return;
+    }
+#endif
+
+    CPU_CRITICAL_ENTER();
+    p_pool = USBD_DbgStatsPoolHeadPtr;
+    while ((p_pool  != (USBD_DBG_STATS_POOL *)0) &&
+           (pool_ix >  0u)) {
+        p_pool = p_pool->NextPtr;
+        pool_ix--;
+    }
+
+    if (p_pool == (USBD_DBG_STATS_POOL *)0) {
+        CPU_CRITICAL_EXIT();
+       *p_err = USBD_ERR_INVALID_ARG;
+        return;
+    }
+
+   *p_stats         = *p_pool;
+    p_stats->NextPtr = (USBD_DBG_STATS_POOL *)0;
+
+    if (reset == DEF_YES) {                                     /* See Note #2.                                         */
+        p_pool->UsedMax      =  p_pool->Used;
+        p_pool->AllocFailCnt =  0u;
+        p_pool->FailLocPtr   = (const CPU_CHAR *)0;
+    }
+    CPU_CRITICAL_EXIT();
+
+   *p_err = USBD_ERR_NONE;
 }
 #endif
 
@@ -8392,7 +9716,7 @@ void  USBD_DbgArg (const  CPU_CHAR    *p_msg,
 *********************************************************************************************************
 */
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 void  USBD_DbgTaskHandler (void)
 {
     USBD_DBG_EVENT   *p_event;
@@ -8566,7 +9890,7 @@ void  USBD_DbgTaskHandler (void)
 *********************************************************************************************************
 */
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 static  USBD_DBG_EVENT  *USBD_DbgEventGet (void)
 {
     USBD_DBG_EVENT  *p_event;
@@ -8612,7 +9936,7 @@ static  USBD_DBG_EVENT  *USBD_DbgEventGet (void)
 *********************************************************************************************************
 */
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 static  void  USBD_DbgEventPut (USBD_DBG_EVENT  *p_event)
 {
     CPU_SR_ALLOC();
@@ -8644,7 +9968,7 @@ static  void  USBD_DbgEventPut (USBD_DBG_EVENT  *p_event)
 *********************************************************************************************************
 */
 
-#if (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 static  void  USBD_DbgEventFree (USBD_DBG_EVENT  *p_event)
 {
     CPU_SR_ALLOC();
@@ -8660,3 +9984,75 @@ static  void  USBD_DbgEventFree (USBD_DBG_EVENT  *p_event)
     CPU_CRITICAL_EXIT();
 }
 #endif
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_DbgTraceRecPut()
+*
+* Description : Store a debug event in the binary trace ring.
+*
+* Argument(s) : p_msg       Debug message (event id).
+*
+*               ep_addr     Endpoint address.
+*
+*               if_nbr      Interface number.
+*
+*               arg_en      Indicates if the event has an argument.
+*
+*               arg         Argument   associated with the debug message.
+*
+*               err         Error code associated with the debug message.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Only the sequence number is reserved within a critical section. The record itself is
+*                   written with interrupts enabled, its 'Seq' field being cleared first and set last so that
+*                   a record interrupted while being written is detected as incomplete by the decoder.
+*
+*               (2) The oldest record is overwritten when the ring is full. The decoder reports the
+*                   overwritten events from the gaps in the sequence numbers.
+*********************************************************************************************************
+*/
+
+#if ((USBD_CFG_DBG_TRACE_EN     == DEF_ENABLED) && \
+     (USBD_CFG_DBG_TRACE_BIN_EN == DEF_ENABLED))
+static  void  USBD_DbgTraceRecPut (const  CPU_CHAR     *p_msg,
+                                          CPU_INT08U    ep_addr,
+                                          CPU_INT08U    if_nbr,
+                                          CPU_BOOLEAN   arg_en,
+                                          CPU_INT32U    arg,
+                                          USBD_ERR      err)
+{
+    volatile  USBD_DBG_TRACE_REC  *p_rec;
+              CPU_INT32U           seq;
+              CPU_TS32             ts;
+    CPU_SR_ALLOC();
+
+
+#if (CPU_CFG_TS_TMR_EN == DEF_ENABLED)
+    ts  = CPU_TS_Get32();
+#else
+    ts  = 0u;
+#endif
+
+    CPU_CRITICAL_ENTER();                                       /* Reserve seq nbr (see Note #1).                       */
+    seq = USBD_DbgTraceRing.SeqNext;
+    USBD_DbgTraceRing.SeqNext++;
+    if (USBD_DbgTraceRing.SeqNext == 0u) {                      /* Seq nbr 0 is never used.                             */
+        USBD_DbgTraceRing.SeqNext = 1u;
+    }
+    CPU_CRITICAL_EXIT();
+
+    p_rec          = &USBD_DbgTraceRing.RecTbl[seq % USBD_CFG_DBG_TRACE_NBR_EVENTS];
+    p_rec->Seq     =  0u;                                       /* Mark rec as incomplete.                              */
+    p_rec->Ts      =  ts;
+    p_rec->MsgPtr  =  p_msg;
+    p_rec->Arg     = (arg_en == DEF_YES) ? arg : 0u;
+    p_rec->Err     = (CPU_INT16U)err;
+    p_rec->EP_Addr =  ep_addr;
+    p_rec->IF_Nbr  =  if_nbr;
+    p_rec->Flags   = (arg_en == DEF_YES) ? USBD_DBG_TRACE_FLAG_ARG : 0u;
+    p_rec->Seq     =  seq;                                      /* Publish rec.                                         */
+}
+#endif
@@ -498,6 +498,8 @@ typedef  enum  usbd_err {                                       /* Device error
     USBD_ERR_SCSI_LOCK                   = 1415u,               /* Medium lock failed.                                  */
     USBD_ERR_SCSI_LOCK_TIMEOUT           = 1416u,               /* Medium lock timed out.                               */
     USBD_ERR_SCSI_UNLOCK                 = 1417u,               /* Medium successfully unlocked.                        */
+    USBD_ERR_SCSI_NO_DIRECT_BUF          = 1418u,               /* Storage medium cannot provide a direct data buf.     */
+    USBD_ERR_SCSI_SPACE_ALLOC            = 1419u,               /* Storage medium has no space left for the data.       */
                                                                 /* -------------- PHDC CLASS ERROR CODES -------------- */
     USBD_ERR_PHDC_INSTANCE_ALLOC         = 1500u,
                                                                 /* ------------- VENDOR CLASS ERROR CODES ------------- */
@@ -563,13 +565,22 @@ typedef  enum  usbd_err {                                       /* Device error
 *                   USBD_EventConn(),
 *                   USBD_EventDisconn(),
 *                   USBD_EventHS().
+*
+*           (2) Bus & setup events are allocated from a pool reserved for them & are processed by the
+*               core task before any endpoint event. A flood of endpoint events can neither exhaust the
+*               pool used by bus & setup events nor delay their processing.
+*
+*           (3) A host does not send a new setup packet before the status stage of the previous control
+*               transfer, unless it aborts that transfer. Two setup events per controller cover the
+*               setup packet being processed & the one that aborts it.
 *********************************************************************************************************
 */
 
 #define  USBD_CORE_EVENT_BUS_NBR                          7u   /* Number of bus events per controller.                 */
+#define  USBD_CORE_EVENT_SETUP_NBR                        2u   /* Number of setup events per controller (see Note #3). */
 
-                                                                /* Total number of bus events.                          */
-#define  USBD_CORE_EVENT_BUS_NBR_TOTAL        (USBD_CFG_MAX_NBR_DEV * USBD_CORE_EVENT_BUS_NBR)
+                                                                /* Total number of bus & setup events (see Note #2).    */
+#define  USBD_CORE_EVENT_BUS_NBR_TOTAL        (USBD_CFG_MAX_NBR_DEV * (USBD_CORE_EVENT_BUS_NBR + USBD_CORE_EVENT_SETUP_NBR))
 
                                                                 /* Total number of USB request blocks (URB).            */
 #define  USBD_CORE_EVENT_URB_NBR_TOTAL        (USBD_CFG_MAX_NBR_DEV * (USBD_CFG_MAX_NBR_EP_OPEN + USBD_CFG_MAX_NBR_URB_EXTRA))
@@ -578,6 +589,31 @@ typedef  enum  usbd_err {                                       /* Device error
                                                USBD_CORE_EVENT_URB_NBR_TOTAL)
 
 
+/*
+*********************************************************************************************************
+*                                             USB CORE TASKS
+*
+* Note(s) : (1) If USBD_CFG_CORE_TASK_PER_DEV_EN is DEF_ENABLED, each device has its own core task & its
+*               own core event queue, so that a device whose class callback blocks does not delay the
+*               events of the other devices. Otherwise, a single core task processes the events of every
+*               device.
+*
+*           (2) Core events are evenly split between core tasks : each core task owns the events of the
+*               devices it serves.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_CORE_TASK_PER_DEV_EN == DEF_ENABLED)
+#define  USBD_CORE_TASK_NBR                    USBD_CFG_MAX_NBR_DEV
+#define  USBD_CORE_TASK_IX(dev_nbr)          (dev_nbr)
+#else
+#define  USBD_CORE_TASK_NBR                               1u
+#define  USBD_CORE_TASK_IX(dev_nbr)                       0u
+#endif
+                                                                /* Number of core events per core task (see Note #2).   */
+#define  USBD_CORE_TASK_EVENT_NBR             (USBD_CORE_EVENT_NBR_TOTAL / USBD_CORE_TASK_NBR)
+
+
 /*
 *********************************************************************************************************
 *                                             DATA TYPES
@@ -915,9 +951,28 @@ typedef  void  (*USBD_ASYNC_FNCT)(CPU_INT08U   dev_nbr,         /* Device number
                                   USBD_ERR     err);            /* Error status.                                        */
 
 
+/*
+*********************************************************************************************************
+*                                       BUFFER SEGMENT DATA TYPE
+*
+* Note(s) : (1) A table of buffer segments describes a single transfer made of several non-contiguous
+*               buffers (see USBD_BulkTxVecAsync()).
+*********************************************************************************************************
+*/
+
+typedef  struct  usbd_buf_seg {
+    void        *BufPtr;                                        /* Pointer to segment buffer.                           */
+    CPU_INT32U   BufLen;                                        /* Segment buffer length.                               */
+} USBD_BUF_SEG;
+
+
 /*
 *********************************************************************************************************
 *                                        USB DEVICE DRIVER API
+*
+* Note(s) : (1) 'EP_QueueDepthGet()' is optional and may be left NULL. It returns the number of transfers
+*               the controller can hold at once on the given endpoint. It is only used when
+*               USBD_CFG_EP_PRE_QUEUE_EN is DEF_ENABLED; a NULL pointer is treated as a depth of one.
 *********************************************************************************************************
 */
 
@@ -994,6 +1049,9 @@ struct  usbd_drv_api {
                                 CPU_BOOLEAN   state);
 
     void         (*ISR_Handler)(USBD_DRV     *p_drv);           /* ISR handler.                                         */
+
+    CPU_INT08U   (*EP_QueueDepthGet)(USBD_DRV  *p_drv,          /* EP xfer queue depth (optional, see Note #1).         */
+                                     CPU_INT08U  ep_addr);
 };
 
 
@@ -1088,6 +1146,105 @@ struct  usbd_drv_api {
 #define  USBD_DBG_GENERIC_ARG_ERR(msg, epp_addr, if_nbr, arg, err)
 #endif
 
+                                                                /* Debug task formats events unless binary trace used.  */
+#if ((USBD_CFG_DBG_TRACE_EN     == DEF_ENABLED) && \
+     (USBD_CFG_DBG_TRACE_BIN_EN != DEF_ENABLED))
+#define  USBD_DBG_TRACE_TASK_EN                     DEF_ENABLED
+#else
+#define  USBD_DBG_TRACE_TASK_EN                     DEF_DISABLED
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          BINARY TRACE RING
+*
+* Note(s) : (1) If USBD_CFG_DBG_TRACE_BIN_EN is DEF_ENABLED, USBD_Dbg() and USBD_DbgArg() store each trace
+*               event as a fixed-size binary record in 'USBD_DbgTraceRing'. No string is formatted and no
+*               OS service is called. The ring is dumped from the target's memory (debugger, crash dump,
+*               ...) and formatted offline by 'App/Host/app_dbg_trace_decode.c'.
+*
+*           (2) Each event is assigned a sequence number, starting at 1. The event of sequence number 'n'
+*               is stored at index (n % USBD_CFG_DBG_TRACE_NBR_EVENTS), so that the ring always holds the
+*               most recent events. 'Seq' is cleared while the record is written and set last. A record
+*               whose 'Seq' does not match its index is incomplete and is skipped by the decoder.
+*
+*           (3) The event id is the address of the trace message. The decoder resolves it to the message
+*               string using the ELF image of the firmware.
+*
+*           (4) The header fields describe the record layout, so that the decoder does not depend on the
+*               target's word size or endianness.
+*********************************************************************************************************
+*/
+
+#define  USBD_DBG_TRACE_MAGIC                     0x54425355u   /* 'USBT', in target's endianness (see Note #4).        */
+#define  USBD_DBG_TRACE_VER                                1u
+
+#define  USBD_DBG_TRACE_FLAG_ARG                  DEF_BIT_00    /* Flag indicating if the event has an argument.        */
+
+#if ((USBD_CFG_DBG_TRACE_EN     == DEF_ENABLED) && \
+     (USBD_CFG_DBG_TRACE_BIN_EN == DEF_ENABLED))
+typedef  struct  usbd_dbg_trace_rec {                           /* ----------------- TRACE EVENT RECORD --------------- */
+           CPU_INT32U   Seq;                                    /* Sequence nbr (see Note #2).                          */
+           CPU_TS32     Ts;                                     /* Timestamp.                                           */
+    const  CPU_CHAR    *MsgPtr;                                 /* Event id (see Note #3).                              */
+           CPU_INT32U   Arg;                                    /* Argument, if any.                                    */
+           CPU_INT16U   Err;                                    /* Error code.                                          */
+           CPU_INT08U   EP_Addr;                                /* EP addr, USBD_EP_ADDR_NONE if none.                  */
+           CPU_INT08U   IF_Nbr;                                 /* IF nbr,  USBD_IF_NBR_NONE  if none.                  */
+           CPU_INT08U   Flags;                                  /* Flags (USBD_DBG_TRACE_FLAG_xxx).                     */
+} USBD_DBG_TRACE_REC;
+
+
+typedef  struct  usbd_dbg_trace_ring {                          /* ----------------- TRACE EVENT RING ----------------- */
+    CPU_INT32U          Magic;                                  /* USBD_DBG_TRACE_MAGIC (see Note #4).                  */
+    CPU_INT08U          Ver;                                    /* USBD_DBG_TRACE_VER.                                  */
+    CPU_INT08U          RecSize;                                /* Size of a record, in octets.                         */
+    CPU_INT08U          PtrSize;                                /* Size of 'MsgPtr', in octets.                         */
+    CPU_INT08U          Rsvd;
+    CPU_INT32U          RecNbr;                                 /* Nbr of records in ring.                              */
+    CPU_INT32U          TsFreq;                                 /* Timestamp freq, in Hz (0 if unknown).                */
+    CPU_INT32U          SeqNext;                                /* Seq nbr of next event.                               */
+    USBD_DBG_TRACE_REC  RecTbl[USBD_CFG_DBG_TRACE_NBR_EVENTS];  /* Records (see Note #2).                               */
+} USBD_DBG_TRACE_RING;
+
+extern  USBD_DBG_TRACE_RING  USBD_DbgTraceRing;
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          TRAFFIC CAPTURE
+*
+* Note(s) : (1) If USBD_CFG_CAPTURE_EN is DEF_ENABLED, the stack records the following events in a RAM ring
+*               buffer, as pcap records of link type LINKTYPE_USBPCAP (see 'USBPcap capture format') :
+*
+*               (a) Setup packets, when received from the driver (USBD_EventSetup()).
+*
+*               (b) Transaction submissions to the driver. These records have no payload. They show when
+*                   each part of a transfer was handed to the device controller.
+*
+*               (c) Transfer completions, synchronous or asynchronous, successful or not. These records
+*                   carry the transfer status and the first USBD_CFG_CAPTURE_SNAP_LEN octets of payload.
+*
+*               Submissions and completions of the same URB share the same IRP id.
+*
+*           (2) Records are written from the point of view of the host : submissions are requests ('info'
+*               bit 0 cleared) and completions are responses ('info' bit 0 set).
+*
+*           (3) USBD_CaptureRd() returns the content of the ring as a byte stream. A pcap file is made of
+*               the file header returned by USBD_CaptureFileHdrGet() followed by the concatenation of all
+*               the data read from the ring, whatever the length of each read.
+*
+*           (4) Timestamps are derived from CPU_TS_Get32(). The capture must record at least one event per
+*               wrap-around period of the timestamp timer for the time base to stay continuous. If
+*               CPU_CFG_TS_TMR_EN is DEF_DISABLED, all the timestamps are zero.
+*********************************************************************************************************
+*/
+
+#define  USBD_CAPTURE_FILE_HDR_LEN                        24u   /* Len of pcap file hdr.                                */
+#define  USBD_CAPTURE_LINKTYPE_USBPCAP                   249u   /* LINKTYPE_USBPCAP.                                    */
+
 
 /*
 *********************************************************************************************************
@@ -1157,6 +1314,47 @@ typedef  struct  usbd_dev_stats {                               /* -------------
 } USBD_DBG_STATS_DEV;
 
 
+/*
+*********************************************************************************************************
+*                                       EP LATENCY HISTOGRAMS
+*
+* Note(s) : (1) Latencies are expressed in CPU timestamp ticks (see CPU_TS_TmrFreqGet()). Bin 0 counts the
+*               samples shorter than 2 ticks. Bin n counts the samples between 2^n and 2^(n + 1) - 1 ticks.
+*               The last bin also counts all the longer samples.
+*
+*           (2) Each completed URB adds one sample to each histogram :
+*
+*               (a) 'SubmitToDrv' : From the submission of the URB by the class to its first driver
+*                                   transaction. Includes the time spent waiting for an earlier URB.
+*
+*               (b) 'DrvToISR'    : From the first driver transaction to the driver's completion
+*                                   notification of the last transaction (USBD_EP_RxCmpl()/TxCmpl()).
+*
+*               (c) 'ISR_ToCmpl'  : From the driver's last completion notification to the execution of
+*                                   the asynchronous callback, or to the return of the synchronous call.
+*
+*               (d) 'Tot'         : URB lifetime, from submission to completion.
+*
+*               URBs that are aborted or that complete with an error are NOT sampled.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_DBG_STATS_LAT_EN == DEF_ENABLED)
+typedef  struct  usbd_dbg_stats_lat {                           /* ---------------- LATENCY HISTOGRAM ----------------- */
+    CPU_INT32U          BinTbl[USBD_CFG_DBG_STATS_LAT_NBR_BIN]; /* Nbr of samples per bin (see Note #1).                */
+    CPU_INT32U          Max;                                    /* Longest sample, in TS ticks.                         */
+} USBD_DBG_STATS_LAT;
+
+
+typedef  struct  usbd_dbg_stats_ep_lat {                        /* ---------------- EP LATENCY STATS ------------------ */
+    USBD_DBG_STATS_LAT  SubmitToDrv;                            /* URB submit  to drv start (see Note #2a).             */
+    USBD_DBG_STATS_LAT  DrvToISR;                               /* Drv start   to drv cmpl  (see Note #2b).             */
+    USBD_DBG_STATS_LAT  ISR_ToCmpl;                             /* Drv cmpl    to callback  (see Note #2c).             */
+    USBD_DBG_STATS_LAT  Tot;                                    /* URB lifetime             (see Note #2d).             */
+} USBD_DBG_STATS_EP_LAT;
+#endif
+
+
 typedef  struct  usbd_ep_stats {                                /* --------------------- EP STATS --------------------- */
     CPU_INT08U          Addr;                                   /* EP address.                                          */
 
@@ -1199,6 +1397,15 @@ typedef  struct  usbd_ep_stats {                                /* -------------
     USBD_DBG_STATS_CNT  DrvTxZLP_SuccessNbr;                    /* Nbr of successful call to drv's TxZLP().             */
     USBD_DBG_STATS_CNT  TxCmplNbr;                              /* Nbr of            call to TxCmpl().                  */
     USBD_DBG_STATS_CNT  TxCmplErrNbr;                           /* Nbr of successful call to TxCmpl().                  */
+
+#if (USBD_CFG_EP_DIRECT_CMPL_EN == DEF_ENABLED)
+    USBD_DBG_STATS_CNT  DirectCmplNbr;                          /* Nbr of xfer cmpl processed from ISR.                 */
+    USBD_DBG_STATS_CNT  DirectCmplDeferNbr;                     /* Nbr of xfer cmpl deferred to core task.              */
+#endif
+
+#if (USBD_CFG_DBG_STATS_LAT_EN == DEF_ENABLED)
+    USBD_DBG_STATS_EP_LAT  Lat;                                 /* Latency histograms (see USBD_EP_LatStatsGet()).      */
+#endif
 } USBD_DBG_STATS_EP;
 
 extern  USBD_DBG_STATS_DEV  USBD_DbgStatsDevTbl[USBD_CFG_MAX_NBR_DEV];
@@ -1264,6 +1471,56 @@ extern  USBD_DBG_STATS_EP   USBD_DbgStatsEP_Tbl[USBD_CFG_MAX_NBR_DEV][USBD_CFG_M
 #endif
 
 
+/*
+*********************************************************************************************************
+*                                          POOL USAGE STATS
+*
+* Note(s) : (1) Each static object pool of the stack (device, configuration, interface, alternate
+*               setting, interface group & endpoint information tables, open endpoints, extra URBs, core
+*               events) and each class control table registers a pool stats object with
+*               USBD_DbgStatsPoolReg(). Registered pools are reported in registration order by
+*               USBD_DbgStatsPoolGet().
+*
+*           (2) 'Used' is the number of objects currently allocated. Pools that are never freed (device,
+*               configuration, interface, ... tables, class control tables) only grow. 'UsedMax' is the
+*               high-water mark of 'Used' since the last reset of the stats.
+*
+*           (3) 'AllocFailCnt' counts the allocations refused because the pool was exhausted. For the
+*               extra URB pool, an allocation refused because the endpoint reached its quota (see
+*               USBD_EP_URB_QuotaSet()) is also counted. 'FailLocPtr' points to a string holding the
+*               file name & line number of the first refused allocation.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_DBG_STATS_POOL_EN == DEF_ENABLED)
+typedef  struct  usbd_dbg_stats_pool  USBD_DBG_STATS_POOL;
+
+struct  usbd_dbg_stats_pool {                                   /* ------------------- POOL STATS --------------------- */
+    const  CPU_CHAR             *NamePtr;                       /* Pool name.                                           */
+           CPU_INT32U            Size;                          /* Nbr of obj in pool.                                  */
+           CPU_INT32U            Used;                          /* Nbr of obj currently alloc'd (see Note #2).          */
+           CPU_INT32U            UsedMax;                       /* High-water mark of 'Used'.                           */
+           CPU_INT32U            AllocFailCnt;                  /* Nbr of refused alloc (see Note #3).                  */
+    const  CPU_CHAR             *FailLocPtr;                    /* Location of first refused alloc.                     */
+           USBD_DBG_STATS_POOL  *NextPtr;                       /* Next registered pool.                                */
+};
+
+#define  USBD_DBG_STATS_POOL_LINE_0(x)                              #x
+#define  USBD_DBG_STATS_POOL_LINE(x)                                USBD_DBG_STATS_POOL_LINE_0(x)
+#define  USBD_DBG_STATS_POOL_LOC                                    __FILE__ ":" USBD_DBG_STATS_POOL_LINE(__LINE__)
+
+#define  USBD_DBG_STATS_POOL_REG(p_pool, p_name, size)              USBD_DbgStatsPoolReg((p_pool), (p_name), (size))
+#define  USBD_DBG_STATS_POOL_ALLOC(p_pool)                          USBD_DbgStatsPoolAlloc((p_pool))
+#define  USBD_DBG_STATS_POOL_FREE(p_pool)                           USBD_DbgStatsPoolFree((p_pool))
+#define  USBD_DBG_STATS_POOL_FAIL(p_pool)                           USBD_DbgStatsPoolFail((p_pool), USBD_DBG_STATS_POOL_LOC)
+#else
+#define  USBD_DBG_STATS_POOL_REG(p_pool, p_name, size)
+#define  USBD_DBG_STATS_POOL_ALLOC(p_pool)
+#define  USBD_DBG_STATS_POOL_FREE(p_pool)
+#define  USBD_DBG_STATS_POOL_FAIL(p_pool)
+#endif
+
+
 /*
 *********************************************************************************************************
 *                                         FUNCTION PROTOTYPES
@@ -1359,6 +1616,13 @@ CPU_INT08U       USBD_IF_AltAdd          (       CPU_INT08U         dev_nbr,
                                           const  CPU_CHAR          *p_name,
                                                  USBD_ERR          *p_err);
 
+void             USBD_IF_AltProtocolSet  (       CPU_INT08U         dev_nbr,
+                                                 CPU_INT08U         cfg_nbr,
+                                                 CPU_INT08U         if_nbr,
+                                                 CPU_INT08U         if_alt_nbr,
+                                                 CPU_INT08U         class_protocol_code,
+                                                 USBD_ERR          *p_err);
+
 #if (USBD_CFG_MAX_NBR_IF_GRP > 0)
 CPU_INT08U       USBD_IF_Grp             (       CPU_INT08U         dev_nbr,
                                                  CPU_INT08U         cfg_nbr,
@@ -1467,6 +1731,25 @@ void             USBD_BulkTxAsync        (       CPU_INT08U         dev_nbr,
                                                  CPU_BOOLEAN        end,
                                                  USBD_ERR          *p_err);
 
+#if (USBD_CFG_EP_VEC_XFER_EN == DEF_ENABLED)
+void             USBD_BulkRxVecAsync     (       CPU_INT08U         dev_nbr,
+                                                 CPU_INT08U         ep_addr,
+                                                 USBD_BUF_SEG      *p_seg_tbl,
+                                                 CPU_INT08U         seg_nbr,
+                                                 USBD_ASYNC_FNCT    async_fnct,
+                                                 void              *p_async_arg,
+                                                 USBD_ERR          *p_err);
+
+void             USBD_BulkTxVecAsync     (       CPU_INT08U         dev_nbr,
+                                                 CPU_INT08U         ep_addr,
+                                                 USBD_BUF_SEG      *p_seg_tbl,
+                                                 CPU_INT08U         seg_nbr,
+                                                 USBD_ASYNC_FNCT    async_fnct,
+                                                 void              *p_async_arg,
+                                                 CPU_BOOLEAN        end,
+                                                 USBD_ERR          *p_err);
+#endif
+
                                                                 /* ------------ INTERRUPT TRANFER FUNCTIONS ----------- */
 CPU_INT08U       USBD_IntrAdd            (       CPU_INT08U         dev_nbr,
                                                  CPU_INT08U         cfg_nbr,
@@ -1509,6 +1792,25 @@ void             USBD_IntrTxAsync        (       CPU_INT08U         dev_nbr,
                                                  CPU_BOOLEAN        end,
                                                  USBD_ERR          *p_err);
 
+#if (USBD_CFG_EP_VEC_XFER_EN == DEF_ENABLED)
+void             USBD_IntrRxVecAsync     (       CPU_INT08U         dev_nbr,
+                                                 CPU_INT08U         ep_addr,
+                                                 USBD_BUF_SEG      *p_seg_tbl,
+                                                 CPU_INT08U         seg_nbr,
+                                                 USBD_ASYNC_FNCT    async_fnct,
+                                                 void              *p_async_arg,
+                                                 USBD_ERR          *p_err);
+
+void             USBD_IntrTxVecAsync     (       CPU_INT08U         dev_nbr,
+                                                 CPU_INT08U         ep_addr,
+                                                 USBD_BUF_SEG      *p_seg_tbl,
+                                                 CPU_INT08U         seg_nbr,
+                                                 USBD_ASYNC_FNCT    async_fnct,
+                                                 void              *p_async_arg,
+                                                 CPU_BOOLEAN        end,
+                                                 USBD_ERR          *p_err);
+#endif
+
 #if (USBD_CFG_EP_ISOC_EN == DEF_ENABLED)
                                                                 /* ----------- ISOCHRONOUS TRANFER FUNCTIONS ---------- */
 CPU_INT08U      USBD_IsocAdd             (       CPU_INT08U         dev_nbr,
@@ -1597,6 +1899,64 @@ CPU_INT08U       USBD_EP_MaxPhyNbrGet    (       CPU_INT08U         dev_nbr);
 
 CPU_INT08U       USBD_EP_MaxNbrOpenGet   (       CPU_INT08U         dev_nbr);
 
+#if (USBD_CFG_EP_DIRECT_CMPL_EN == DEF_ENABLED)
+void             USBD_EP_DirectCmplSet   (       CPU_INT08U         dev_nbr,
+                                                 CPU_INT08U         ep_addr,
+                                                 CPU_BOOLEAN        en,
+                                                 USBD_ERR          *p_err);
+#endif
+
+#if (USBD_CFG_MAX_NBR_URB_EXTRA > 0u)
+void             USBD_EP_URB_QuotaSet    (       CPU_INT08U         dev_nbr,
+                                                 CPU_INT08U         ep_addr,
+                                                 CPU_INT08U         nbr_rsvd,
+                                                 CPU_INT08U         nbr_max,
+                                                 USBD_ERR          *p_err);
+#endif
+
+#if ((USBD_CFG_DBG_STATS_EN     == DEF_ENABLED) && \
+     (USBD_CFG_DBG_STATS_LAT_EN == DEF_ENABLED))
+void             USBD_EP_LatStatsGet     (       CPU_INT08U              dev_nbr,
+                                                 CPU_INT08U              ep_addr,
+                                                 USBD_DBG_STATS_EP_LAT  *p_lat,
+                                                 CPU_BOOLEAN             reset,
+                                                 USBD_ERR               *p_err);
+#endif
+
+#if (USBD_CFG_CAPTURE_EN == DEF_ENABLED)                        /* ------------------ TRAFFIC CAPTURE ----------------- */
+void             USBD_CaptureEnSet       (       CPU_BOOLEAN        en);
+
+CPU_INT32U       USBD_CaptureFileHdrGet  (       CPU_INT08U        *p_buf,
+                                                 CPU_INT32U         buf_len,
+                                                 USBD_ERR          *p_err);
+
+CPU_INT32U       USBD_CaptureRd          (       CPU_INT08U        *p_buf,
+                                                 CPU_INT32U         buf_len,
+                                                 USBD_ERR          *p_err);
+
+CPU_INT32U       USBD_CaptureDropCntGet  (       void);
+#endif
+
+#if (USBD_CFG_DBG_STATS_POOL_EN == DEF_ENABLED)               /* ------------------ POOL USAGE STATS ---------------- */
+void             USBD_DbgStatsPoolReg    (       USBD_DBG_STATS_POOL  *p_pool,
+                                          const  CPU_CHAR             *p_name,
+                                                 CPU_INT32U            size);
+
+void             USBD_DbgStatsPoolAlloc  (       USBD_DBG_STATS_POOL  *p_pool);
+
+void             USBD_DbgStatsPoolFree   (       USBD_DBG_STATS_POOL  *p_pool);
+
+void             USBD_DbgStatsPoolFail   (       USBD_DBG_STATS_POOL  *p_pool,
+                                          const  CPU_CHAR             *p_loc);
+
+CPU_INT08U       USBD_DbgStatsPoolNbrGet (       void);
+
+void             USBD_DbgStatsPoolGet    (       CPU_INT08U            pool_ix,
+                                                 USBD_DBG_STATS_POOL  *p_stats,
+                                                 CPU_BOOLEAN           reset,
+                                                 USBD_ERR             *p_err);
+#endif
+
                                                                 /* -------------- DEVICE DRIVER CALLBACKS ------------- */
 void             USBD_EventConn          (       USBD_DRV          *p_drv);
 
@@ -1648,6 +2008,14 @@ void             USBD_Trace              (const  CPU_CHAR          *p_str);
 #error  "USBD_CFG_CTRL_REQ_TIMEOUT_mS illegally #define'd in 'usbd_cfg.h' [MUST be > 0 && <= 65535]"
 #endif
 
+#ifndef  USBD_CFG_CORE_TASK_PER_DEV_EN
+#error  "USBD_CFG_CORE_TASK_PER_DEV_EN not #define'd in 'usbd_cfg.h' [MUST be DEF_ENABLED || DEF_DISABLED]"
+
+#elif  ((USBD_CFG_CORE_TASK_PER_DEV_EN != DEF_ENABLED) && \
+        (USBD_CFG_CORE_TASK_PER_DEV_EN != DEF_DISABLED))
+#error  "USBD_CFG_CORE_TASK_PER_DEV_EN illegally #define'd in 'usbd_cfg.h' [MUST be DEF_ENABLED || DEF_DISABLED]"
+#endif
+
 #ifndef  USBD_CFG_MAX_NBR_DEV
 #error  "USBD_CFG_MAX_NBR_DEV not #define'd in 'usbd_cfg.h' [MUST be > 0]"
 
@@ -1705,6 +2073,46 @@ void             USBD_Trace              (const  CPU_CHAR          *p_str);
 #error  "USBD_CFG_MAX_NBR_URB_EXTRA not #define'd in 'usbd_cfg.h' [MUST be >= 0]"
 #endif
 
+#ifndef  USBD_CFG_EP_PRE_QUEUE_EN
+#error  "USBD_CFG_EP_PRE_QUEUE_EN not #define'd in 'usbd_cfg.h' [MUST be DEF_DISABLED || DEF_ENABLED]"
+
+#elif  ((USBD_CFG_EP_PRE_QUEUE_EN != DEF_DISABLED) && \
+        (USBD_CFG_EP_PRE_QUEUE_EN != DEF_ENABLED ))
+#error  "USBD_CFG_EP_PRE_QUEUE_EN illegally #define'd in 'usbd_cfg.h' [MUST be DEF_DISABLED || DEF_ENABLED]"
+#endif
+
+#ifndef  USBD_CFG_EP_DIRECT_CMPL_EN
+#error  "USBD_CFG_EP_DIRECT_CMPL_EN not #define'd in 'usbd_cfg.h' [MUST be DEF_DISABLED || DEF_ENABLED]"
+
+#elif  ((USBD_CFG_EP_DIRECT_CMPL_EN != DEF_DISABLED) && \
+        (USBD_CFG_EP_DIRECT_CMPL_EN != DEF_ENABLED ))
+#error  "USBD_CFG_EP_DIRECT_CMPL_EN illegally #define'd in 'usbd_cfg.h' [MUST be DEF_DISABLED || DEF_ENABLED]"
+#endif
+
+#ifndef  USBD_CFG_EP_VEC_XFER_EN
+#error  "USBD_CFG_EP_VEC_XFER_EN not #define'd in 'usbd_cfg.h' [MUST be DEF_DISABLED || DEF_ENABLED]"
+
+#elif  ((USBD_CFG_EP_VEC_XFER_EN != DEF_DISABLED) && \
+        (USBD_CFG_EP_VEC_XFER_EN != DEF_ENABLED ))
+#error  "USBD_CFG_EP_VEC_XFER_EN illegally #define'd in 'usbd_cfg.h' [MUST be DEF_DISABLED || DEF_ENABLED]"
+
+#elif   (USBD_CFG_EP_VEC_XFER_EN == DEF_ENABLED)
+#ifndef  USBD_CFG_EP_VEC_BUF_LEN
+#error  "USBD_CFG_EP_VEC_BUF_LEN not #define'd in 'usbd_cfg.h' [MUST be >= 8]"
+
+#elif   (USBD_CFG_EP_VEC_BUF_LEN < 8u)
+#error  "USBD_CFG_EP_VEC_BUF_LEN illegally #define'd in 'usbd_cfg.h' [MUST be >= 8]"
+#endif
+#endif
+
+#ifndef  USBD_CFG_EP_CMPL_COALESCE_EN
+#error  "USBD_CFG_EP_CMPL_COALESCE_EN not #define'd in 'usbd_cfg.h' [MUST be DEF_DISABLED || DEF_ENABLED]"
+
+#elif  ((USBD_CFG_EP_CMPL_COALESCE_EN != DEF_DISABLED) && \
+        (USBD_CFG_EP_CMPL_COALESCE_EN != DEF_ENABLED ))
+#error  "USBD_CFG_EP_CMPL_COALESCE_EN illegally #define'd in 'usbd_cfg.h' [MUST be DEF_DISABLED || DEF_ENABLED]"
+#endif
+
 #ifndef  USBD_CFG_MAX_NBR_STR
 #error  "USBD_CFG_MAX_NBR_STR not #define'd in 'usbd_cfg.h' [MUST be >= 0]"
 
@@ -1721,6 +2129,15 @@ void             USBD_Trace              (const  CPU_CHAR          *p_str);
 #elif  ((USBD_CFG_DBG_TRACE_EN != DEF_DISABLED) && \
         (USBD_CFG_DBG_TRACE_EN != DEF_ENABLED ))
 #error  "USBD_CFG_DBG_TRACE_EN illegally #define'd in 'usbd_cfg.h' [MUST be  DEF_DISABLED || DEF_ENABLED]"
+
+#elif   (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
+#ifndef  USBD_CFG_DBG_TRACE_BIN_EN
+#error  "USBD_CFG_DBG_TRACE_BIN_EN not #define'd in 'usbd_cfg.h' [MUST be DEF_DISABLED || DEF_ENABLED]"
+
+#elif  ((USBD_CFG_DBG_TRACE_BIN_EN != DEF_DISABLED) && \
+        (USBD_CFG_DBG_TRACE_BIN_EN != DEF_ENABLED ))
+#error  "USBD_CFG_DBG_TRACE_BIN_EN illegally #define'd in 'usbd_cfg.h' [MUST be DEF_DISABLED || DEF_ENABLED]"
+#endif
 #endif
 
 #ifndef  USBD_CFG_ERR_ARG_CHK_EXT_EN
@@ -1739,6 +2156,23 @@ void             USBD_Trace              (const  CPU_CHAR          *p_str);
 #error  "USBD_CFG_MS_OS_DESC_EN illegally #define'd in 'usbd_cfg.h' [MUST be DEF_DISABLED || DEF_ENABLED]"
 #endif
 
+#ifndef  USBD_CFG_DESC_CACHE_EN
+#error  "USBD_CFG_DESC_CACHE_EN not #define'd in 'usbd_cfg.h' [MUST be DEF_DISABLED || DEF_ENABLED]"
+
+#elif  ((USBD_CFG_DESC_CACHE_EN != DEF_DISABLED) && \
+        (USBD_CFG_DESC_CACHE_EN != DEF_ENABLED ))
+#error  "USBD_CFG_DESC_CACHE_EN illegally #define'd in 'usbd_cfg.h' [MUST be DEF_DISABLED || DEF_ENABLED]"
+
+#elif   (USBD_CFG_DESC_CACHE_EN == DEF_ENABLED)
+#ifndef  USBD_CFG_DESC_CACHE_BUF_LEN
+#error  "USBD_CFG_DESC_CACHE_BUF_LEN not #define'd in 'usbd_cfg.h' [MUST be >= 9 && <= 65534]"
+
+#elif  ((USBD_CFG_DESC_CACHE_BUF_LEN < 9u) || \
+        (USBD_CFG_DESC_CACHE_BUF_LEN >= DEF_INT_16U_MAX_VAL))
+#error  "USBD_CFG_DESC_CACHE_BUF_LEN illegally #define'd in 'usbd_cfg.h' [MUST be >= 9 && <= 65534]"
+#endif
+#endif
+
 #if     (USBD_CFG_DBG_TRACE_EN == DEF_ENABLED)
 #ifndef  USBD_CFG_DBG_TRACE_NBR_EVENTS
 #error  "USBD_CFG_DBG_TRACE_NBR_EVENTS not #define'd in 'usbd_cfg.h' [MUST be > 0]"
@@ -1748,6 +2182,60 @@ void             USBD_Trace              (const  CPU_CHAR          *p_str);
 #endif
 #endif
 
+#if     (USBD_CFG_DBG_STATS_EN == DEF_ENABLED)
+#ifndef  USBD_CFG_DBG_STATS_LAT_EN
+#error  "USBD_CFG_DBG_STATS_LAT_EN not #define'd in 'usbd_cfg.h' [MUST be DEF_DISABLED || DEF_ENABLED]"
+
+#elif  ((USBD_CFG_DBG_STATS_LAT_EN != DEF_DISABLED) && \
+        (USBD_CFG_DBG_STATS_LAT_EN != DEF_ENABLED ))
+#error  "USBD_CFG_DBG_STATS_LAT_EN illegally #define'd in 'usbd_cfg.h' [MUST be DEF_DISABLED || DEF_ENABLED]"
+
+#elif   (USBD_CFG_DBG_STATS_LAT_EN == DEF_ENABLED)
+#ifndef  USBD_CFG_DBG_STATS_LAT_NBR_BIN
+#error  "USBD_CFG_DBG_STATS_LAT_NBR_BIN not #define'd in 'usbd_cfg.h' [MUST be >= 1 && <= 32]"
+
+#elif  ((USBD_CFG_DBG_STATS_LAT_NBR_BIN <  1u) || \
+        (USBD_CFG_DBG_STATS_LAT_NBR_BIN > 32u))
+#error  "USBD_CFG_DBG_STATS_LAT_NBR_BIN illegally #define'd in 'usbd_cfg.h' [MUST be >= 1 && <= 32]"
+#endif
+
+#if     (CPU_CFG_TS_32_EN != DEF_ENABLED)
+#error  "CPU_CFG_TS_32_EN illegally #define'd in 'cpu_cfg.h' [MUST be DEF_ENABLED for EP latency stats]"
+#endif
+#endif
+#endif
+
+#ifndef  USBD_CFG_DBG_STATS_POOL_EN
+#error  "USBD_CFG_DBG_STATS_POOL_EN not #define'd in 'usbd_cfg.h' [MUST be DEF_DISABLED || DEF_ENABLED]"
+
+#elif  ((USBD_CFG_DBG_STATS_POOL_EN != DEF_DISABLED) && \
+        (USBD_CFG_DBG_STATS_POOL_EN != DEF_ENABLED ))
+#error  "USBD_CFG_DBG_STATS_POOL_EN illegally #define'd in 'usbd_cfg.h' [MUST be DEF_DISABLED || DEF_ENABLED]"
+#endif
+
+#ifndef  USBD_CFG_CAPTURE_EN
+#error  "USBD_CFG_CAPTURE_EN not #define'd in 'usbd_cfg.h' [MUST be DEF_DISABLED || DEF_ENABLED]"
+
+#elif  ((USBD_CFG_CAPTURE_EN != DEF_DISABLED) && \
+        (USBD_CFG_CAPTURE_EN != DEF_ENABLED ))
+#error  "USBD_CFG_CAPTURE_EN illegally #define'd in 'usbd_cfg.h' [MUST be DEF_DISABLED || DEF_ENABLED]"
+
+#elif   (USBD_CFG_CAPTURE_EN == DEF_ENABLED)
+#ifndef  USBD_CFG_CAPTURE_BUF_LEN
+#error  "USBD_CFG_CAPTURE_BUF_LEN not #define'd in 'usbd_cfg.h' [MUST be >= 128]"
+
+#elif   (USBD_CFG_CAPTURE_BUF_LEN < 128u)
+#error  "USBD_CFG_CAPTURE_BUF_LEN illegally #define'd in 'usbd_cfg.h' [MUST be >= 128]"
+#endif
+
+#ifndef  USBD_CFG_CAPTURE_SNAP_LEN
+#error  "USBD_CFG_CAPTURE_SNAP_LEN not #define'd in 'usbd_cfg.h' [MUST be >= 0 && <= 1024]"
+
+#elif   (USBD_CFG_CAPTURE_SNAP_LEN > 1024u)
+#error  "USBD_CFG_CAPTURE_SNAP_LEN illegally #define'd in 'usbd_cfg.h' [MUST be >= 0 && <= 1024]"
+#endif
+#endif
+
 
 /*
 *********************************************************************************************************
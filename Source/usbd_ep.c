@@ -44,6 +44,19 @@
 /*
 *********************************************************************************************************
 *                                            LOCAL DEFINES
+*
+* Note(s) : (1) The URB table of each device is split in two parts:
+*
+*               (a) The first USBD_CFG_MAX_NBR_EP_OPEN URBs are the 'main' URBs. The main URB at index 'n'
+*                   is owned by the endpoint allocated at index 'n' and is never shared.
+*
+*               (b) The remaining USBD_CFG_MAX_NBR_URB_EXTRA URBs are the 'extra' URBs. They are kept in
+*                   a free list shared amongst all endpoints of the device.
+*
+*           (2) A vectored transfer is split in transactions that never cross a segment boundary, except
+*               for a single packet whose data spans two or more segments. That packet is gathered into
+*               (IN) or scattered from (OUT) the endpoint's packet buffer, so that no short packet is
+*               sent or expected in the middle of the transfer.
 *********************************************************************************************************
 */
 
@@ -52,9 +65,50 @@
 
 #define  USBD_URB_MAX_NBR                      (USBD_CFG_MAX_NBR_URB_EXTRA + \
                                                 USBD_CFG_MAX_NBR_EP_OPEN)
+                                                                /* Ix of first extra URB in URB tbl (see Note #1).      */
+#define  USBD_URB_EXTRA_IX_START                 USBD_CFG_MAX_NBR_EP_OPEN
 
 #define  USBD_URB_FLAG_XFER_END                 DEF_BIT_00      /* Flag indicating if xfer requires a ZLP to complete.  */
 #define  USBD_URB_FLAG_EXTRA_URB                DEF_BIT_01      /* Flag indicating if the URB is an 'extra' URB.        */
+#define  USBD_URB_FLAG_VEC                      DEF_BIT_02      /* Flag indicating if the URB is a vectored xfer.       */
+#define  USBD_URB_FLAG_LAT_DRV                  DEF_BIT_03      /* Flag indicating if the URB reached the drv.          */
+
+#if ((USBD_CFG_DBG_STATS_EN     == DEF_ENABLED) && \
+     (USBD_CFG_DBG_STATS_LAT_EN == DEF_ENABLED))
+#define  USBD_EP_LAT_EN                         DEF_ENABLED
+#else
+#define  USBD_EP_LAT_EN                         DEF_DISABLED
+#endif
+
+                                                                /* ------- TRAFFIC CAPTURE (see 'usbd_core.h') -------- */
+#define  USBD_CAPTURE_PCAP_MAGIC                0xA1B2C3D4u     /* pcap file, microsecond timestamps.                   */
+#define  USBD_CAPTURE_PCAP_VER_MAJOR                     2u
+#define  USBD_CAPTURE_PCAP_VER_MINOR                     4u
+#define  USBD_CAPTURE_PCAP_SNAP_LEN                  65535u
+
+#define  USBD_CAPTURE_REC_HDR_LEN                       16u     /* Len of pcap rec hdr.                                 */
+#define  USBD_CAPTURE_USBPCAP_HDR_LEN                   27u     /* Len of USBPcap base hdr.                             */
+#define  USBD_CAPTURE_USBPCAP_HDR_LEN_MAX               51u     /* Len of USBPcap isoc hdr with one pkt desc.           */
+
+#define  USBD_CAPTURE_FNCT_CTRL                     0x0008u     /* URB_FUNCTION_CONTROL_TRANSFER.                       */
+#define  USBD_CAPTURE_FNCT_BULK                     0x0009u     /* URB_FUNCTION_BULK_OR_INTERRUPT_TRANSFER.             */
+#define  USBD_CAPTURE_FNCT_ISOC                     0x000Au     /* URB_FUNCTION_ISOCH_TRANSFER.                         */
+
+#define  USBD_CAPTURE_XFER_ISOC                          0u
+#define  USBD_CAPTURE_XFER_INTR                          1u
+#define  USBD_CAPTURE_XFER_CTRL                          2u
+#define  USBD_CAPTURE_XFER_BULK                          3u
+
+#define  USBD_CAPTURE_INFO_CMPL                 DEF_BIT_00      /* Record is a cmpl (PDO to FDO).                       */
+
+#define  USBD_CAPTURE_STAGE_SETUP                        0u
+#define  USBD_CAPTURE_STAGE_DATA                         1u
+#define  USBD_CAPTURE_STAGE_CMPL                         3u
+
+#define  USBD_CAPTURE_STATUS_SUCCESS            0x00000000u
+#define  USBD_CAPTURE_STATUS_XACT_ERR           0xC0000011u
+#define  USBD_CAPTURE_STATUS_TIMEOUT            0xC0006000u
+#define  USBD_CAPTURE_STATUS_CANCELED           0xC0010000u
 
 
 /*
@@ -95,6 +149,10 @@ typedef  enum  usbd_ep_state {
 *              another transaction. The remaining 6 bytes will only be queued when the previous (512
 *              bytes) transaction completes. The state of the endpoint will be changed to
 *              USBD_EP_XFER_TYPE_ASYNC_PARTIAL and other transfers could be queued after this one.
+*
+*          (2) If USBD_CFG_EP_PRE_QUEUE_EN is DEF_ENABLED, asynchronous transfers can still be queued while
+*              the endpoint is in the USBD_XFER_STATE_ASYNC_PARTIAL state. They are held by the core and
+*              submitted to the driver, in order, once the partial transfer completes.
 *********************************************************************************************************
 */
 
@@ -125,7 +183,13 @@ typedef  enum  usbd_urb_state {
 *
 * Note(s): (1) The 'Flags' field is used as a bitmap. The following bits are used:
 *
-*                   D7..2 Reserved (reset to zero)
+*                   D7..4 Reserved (reset to zero)
+*                   D3    Latency sampling:
+*                               If this bit is set, the URB reached the driver and its timestamps are
+*                               valid (see Note #3).
+*                   D2    Vectored transfer:
+*                               If this bit is set, 'BufPtr' points to a table of 'SegNbr' buffer segments
+*                               and 'BufLen' is the total length of the segments (see Note #2).
 *                   D1    End-of-transfer:
 *                               If this bit is set and transfer length is multiple of maximum packet
 *                               size, a zero-length packet is transferred to indicate a short transfer to
@@ -136,6 +200,14 @@ typedef  enum  usbd_urb_state {
 *                               indicates that this URB is 'reserved' to allow every endpoint to have at
 *                               least one URB available at any time.
 *
+*          (2) The segment fields track the position of the next transaction in a vectored transfer.
+*              'SegBufPtr' points to the buffer of the transaction in progress, either inside a segment or
+*              in the endpoint's packet buffer when the transaction straddles two segments.
+*
+*          (3) If USBD_CFG_DBG_STATS_LAT_EN is DEF_ENABLED, the URB timestamps the stages of its lifetime.
+*              They are sampled into the endpoint's latency histograms when the URB completes (see
+*              'usbd_core.h  EP LATENCY HISTOGRAMS').
+*
 *********************************************************************************************************
 */
 
@@ -150,12 +222,35 @@ typedef  struct  usbd_urb {
     void              *AsyncFnctArg;                            /* Asynchronous function argument.                      */
     USBD_ERR           Err;                                     /* Error passed to callback, if any.                    */
     struct  usbd_urb  *NextPtr;                                 /* Pointer to next     URB in list.                     */
+#if (USBD_CFG_EP_VEC_XFER_EN == DEF_ENABLED)                    /* See Note #2.                                         */
+    CPU_INT08U         SegNbr;                                  /* Nbr of buf segments.                                 */
+    CPU_INT08U         SegIx;                                   /* Ix of cur buf segment.                               */
+    CPU_INT32U         SegOffset;                               /* Offset in cur buf segment.                           */
+    CPU_INT08U        *SegBufPtr;                               /* Pointer to buf of cur transaction.                   */
+    CPU_BOOLEAN        SegStraddle;                             /* Flag indicating if cur transaction straddles segs.   */
+#endif
+#if (USBD_EP_LAT_EN == DEF_ENABLED)                             /* See Note #3.                                         */
+    CPU_TS32           TsSubmit;                                /* TS of URB submission.                                */
+    CPU_TS32           TsDrvStart;                              /* TS of first drv transaction.                         */
+    CPU_TS32           TsDrvCmpl;                               /* TS of last  drv cmpl notification.                   */
+#endif
 } USBD_URB;
 
 
 /*
 *********************************************************************************************************
 *                                         ENDPOINT DATA TYPE
+*
+* Note(s): (1) If USBD_CFG_EP_DIRECT_CMPL_EN is DEF_ENABLED, the endpoint tracks who currently owns it:
+*
+*              (a) 'LockHeld' is set while a task holds the endpoint OS lock.
+*
+*              (b) 'DirectCmplActive' is set while a transfer completion is processed from the driver's
+*                  ISR. The ISR then owns the endpoint in place of the OS lock.
+*
+*              (c) 'DirectCmplDeferCnt' is the number of completion events of this endpoint queued to the
+*                  core task. The ISR processes a completion only when no such event is queued, so that
+*                  completions are always processed in order.
 *********************************************************************************************************
 */
 
@@ -168,14 +263,56 @@ typedef  struct  usbd_ep {
     CPU_INT08U        Interval;                                 /* Interval.                                            */
     CPU_INT08U        TransPerFrame;                            /* Transaction per microframe (HS only).                */
     CPU_INT08U        Ix;                                       /* Allocation index.                                    */
-#if (USBD_CFG_MAX_NBR_URB_EXTRA > 0u)
     CPU_BOOLEAN       URB_MainAvail;                            /* Flag indicating if main URB associated to EP avail.  */
+#if (USBD_CFG_MAX_NBR_URB_EXTRA > 0u)
+    CPU_INT08U        URB_ExtraCnt;                             /* Nbr of extra URB currently used by EP.               */
+    CPU_INT08U        URB_ExtraRsvd;                            /* Nbr of extra URB reserved for EP.                    */
+    CPU_INT08U        URB_ExtraMax;                             /* Max nbr of extra URB EP can use at once.             */
 #endif
     USBD_URB         *URB_HeadPtr;                              /* USB request block head of the list.                  */
     USBD_URB         *URB_TailPtr;                              /* USB request block tail of the list.                  */
+#if (USBD_CFG_EP_PRE_QUEUE_EN == DEF_ENABLED)
+    USBD_URB         *URB_PendPtr;                              /* First URB in the list not yet submitted to drv.      */
+    CPU_INT08U        URB_SubmitCnt;                            /* Nbr of URB currently submitted to drv.               */
+    CPU_INT08U        URB_SubmitMax;                            /* Max nbr of URB drv can hold at once.                 */
+#endif
+#if (USBD_CFG_EP_DIRECT_CMPL_EN == DEF_ENABLED)                 /* See Note #1.                                         */
+    CPU_BOOLEAN       DirectCmplEn;                             /* Flag indicating if xfer cmpl is processed from ISR.  */
+    CPU_BOOLEAN       DirectCmplActive;                         /* Flag indicating if ISR is processing a xfer cmpl.    */
+    CPU_BOOLEAN       LockHeld;                                 /* Flag indicating if EP lock is held by a task.        */
+    CPU_INT16U        DirectCmplDeferCnt;                       /* Nbr of xfer cmpl events queued to core task.         */
+#endif
 } USBD_EP;
 
 
+/*
+*********************************************************************************************************
+*                                      TRAFFIC CAPTURE DATA TYPE
+*
+* Note(s): (1) 'Cnt' octets of records are stored in 'BufTbl', starting at index 'IxOut'. New records are
+*              written at index 'IxIn'.
+*
+*          (2) The capture time is kept as a number of seconds and a remainder of timestamp ticks, updated
+*              from the difference between consecutive CPU timestamps.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_CAPTURE_EN == DEF_ENABLED)
+typedef  struct  usbd_capture {
+    CPU_INT08U        BufTbl[USBD_CFG_CAPTURE_BUF_LEN];         /* Ring buf (see Note #1).                              */
+    CPU_INT32U        IxIn;                                     /* Ix of next octet written.                            */
+    CPU_INT32U        IxOut;                                    /* Ix of next octet read.                               */
+    CPU_INT32U        Cnt;                                      /* Nbr of octets in ring.                               */
+    CPU_INT32U        DropCnt;                                  /* Nbr of recs dropped.                                 */
+    CPU_BOOLEAN       En;                                       /* Flag indicating if capture is enabled.               */
+    CPU_INT32U        TsFreq;                                   /* TS clk freq (see Note #2).                           */
+    CPU_TS32          TsPrev;                                   /* TS of last rec.                                      */
+    CPU_INT32U        TsSec;                                    /* Capture time, in sec.                                */
+    CPU_INT32U        TsRem;                                    /* Capture time remainder, in TS ticks.                 */
+} USBD_CAPTURE;
+#endif
+
+
 /*
 *********************************************************************************************************
 *                                            LOCAL MACROS
@@ -207,6 +344,46 @@ typedef  struct  usbd_ep {
 #define  USBD_DBG_EP_ARG(msg, ep_addr, arg)
 #endif
 
+                                                                /* EP lock is taken directly from OS layer when ...     */
+                                                                /* ... direct cmpl is disabled.                         */
+#if (USBD_CFG_EP_DIRECT_CMPL_EN == DEF_DISABLED)
+#define  USBD_EP_LockAcquire(dev_nbr, ep_ix, timeout_ms, p_err)     USBD_OS_EP_LockAcquire((dev_nbr), (ep_ix), (timeout_ms), (p_err))
+#define  USBD_EP_LockRelease(dev_nbr, ep_ix)                        USBD_OS_EP_LockRelease((dev_nbr), (ep_ix))
+#endif
+
+                                                                /* URB lifetime timestamps (see 'USBD_URB  Note #3').   */
+#if (USBD_EP_LAT_EN == DEF_ENABLED)
+#define  USBD_URB_LAT_SUBMIT(p_urb)                                 {                                                               \
+                                                                        (p_urb)->TsSubmit = CPU_TS_Get32();                         \
+                                                                    }
+#define  USBD_URB_LAT_DRV_START(p_urb)                              {                                                               \
+                                                                        if (DEF_BIT_IS_CLR((p_urb)->Flags,                          \
+                                                                                            USBD_URB_FLAG_LAT_DRV) == DEF_YES) {    \
+                                                                            (p_urb)->TsDrvStart = CPU_TS_Get32();                   \
+                                                                            (p_urb)->TsDrvCmpl  = (p_urb)->TsDrvStart;              \
+                                                                            DEF_BIT_SET((p_urb)->Flags, USBD_URB_FLAG_LAT_DRV);     \
+                                                                        }                                                           \
+                                                                    }
+#define  USBD_EP_LAT_DRV_CMPL(p_ep)                                 {                                                               \
+                                                                        if ((p_ep)->URB_HeadPtr != (USBD_URB *)0) {                 \
+                                                                            (p_ep)->URB_HeadPtr->TsDrvCmpl = CPU_TS_Get32();        \
+                                                                        }                                                           \
+                                                                    }
+#else
+#define  USBD_URB_LAT_SUBMIT(p_urb)
+#define  USBD_URB_LAT_DRV_START(p_urb)
+#define  USBD_EP_LAT_DRV_CMPL(p_ep)
+#endif
+
+                                                                /* Traffic capture (see 'usbd_core.h').                 */
+#if (USBD_CFG_CAPTURE_EN == DEF_ENABLED)
+#define  USBD_EP_CAPTURE_SUBMIT(dev_nbr, p_ep, p_urb)               USBD_EP_CaptureXfer((dev_nbr), (p_ep), (p_urb), DEF_NO,  USBD_ERR_NONE)
+#define  USBD_EP_CAPTURE_CMPL(dev_nbr, p_ep, p_urb, err)            USBD_EP_CaptureXfer((dev_nbr), (p_ep), (p_urb), DEF_YES, (err))
+#else
+#define  USBD_EP_CAPTURE_SUBMIT(dev_nbr, p_ep, p_urb)
+#define  USBD_EP_CAPTURE_CMPL(dev_nbr, p_ep, p_urb, err)
+#endif
+
 
 /*
 *********************************************************************************************************
@@ -227,13 +404,28 @@ static  USBD_EP            *USBD_EP_TblPtrs[USBD_CFG_MAX_NBR_DEV][USBD_EP_MAX_NB
 static  CPU_INT08U          USBD_EP_OpenCtr[USBD_CFG_MAX_NBR_DEV];
 static  CPU_INT32U          USBD_EP_OpenBitMap[USBD_CFG_MAX_NBR_DEV];
 static  USBD_URB            USBD_URB_Tbl[USBD_CFG_MAX_NBR_DEV][USBD_URB_MAX_NBR];
-static  USBD_URB           *USBD_URB_TblPtr[USBD_CFG_MAX_NBR_DEV];
 #if (USBD_CFG_MAX_NBR_URB_EXTRA > 0u)
+static  USBD_URB           *USBD_URB_TblPtr[USBD_CFG_MAX_NBR_DEV];     /* Extra URB free list.                                 */
 static  CPU_INT08U          USBD_URB_ExtraCtr[USBD_CFG_MAX_NBR_DEV];   /* Nbr of extra URB currently used.                     */
+                                                                /* Nbr of extra URB reserved by all EPs.                */
+static  CPU_INT08U          USBD_URB_ExtraRsvdTot[USBD_CFG_MAX_NBR_DEV];
+                                                                /* Nbr of reserved extra URB not currently used.        */
+static  CPU_INT08U          USBD_URB_ExtraRsvdAvail[USBD_CFG_MAX_NBR_DEV];
+#endif
+#if (USBD_CFG_EP_VEC_XFER_EN == DEF_ENABLED)
+                                                                /* Straddle pkt buf of each EP (see Note #2).           */
+static  CPU_INT08U         *USBD_EP_VecBufTbl[USBD_CFG_MAX_NBR_DEV][USBD_CFG_MAX_NBR_EP_OPEN];
 #endif
 #if (USBD_CFG_DBG_STATS_EN == DEF_ENABLED)
         USBD_DBG_STATS_EP   USBD_DbgStatsEP_Tbl[USBD_CFG_MAX_NBR_DEV][USBD_CFG_MAX_NBR_EP_OPEN];
 #endif
+#if (USBD_CFG_CAPTURE_EN == DEF_ENABLED)
+static  USBD_CAPTURE        USBD_Capture;                       /* Traffic capture ring.                                */
+#endif
+#if (USBD_CFG_DBG_STATS_POOL_EN == DEF_ENABLED)
+static  USBD_DBG_STATS_POOL USBD_DbgStatsPoolEP;                /* Usage stats of open EP pool.                         */
+static  USBD_DBG_STATS_POOL USBD_DbgStatsPoolURB_Extra;         /* Usage stats of extra URB pool.                       */
+#endif
 
 
 /*
@@ -275,10 +467,50 @@ static  CPU_INT32U    USBD_EP_Tx                 (USBD_DRV         *p_drv,
                                                   CPU_BOOLEAN       end,
                                                   USBD_ERR         *p_err);
 
+#if (USBD_CFG_EP_VEC_XFER_EN == DEF_ENABLED)
+static  void          USBD_EP_VecXferAsync       (USBD_DRV         *p_drv,
+                                                  USBD_EP          *p_ep,
+                                                  USBD_BUF_SEG     *p_seg_tbl,
+                                                  CPU_INT08U        seg_nbr,
+                                                  USBD_ASYNC_FNCT   async_fnct,
+                                                  void             *p_async_arg,
+                                                  CPU_BOOLEAN       end,
+                                                  USBD_ERR         *p_err);
+#endif
+
+static  void          USBD_EP_XferAsyncCmpl      (USBD_DRV         *p_drv,
+                                                  USBD_EP          *p_ep,
+                                                  USBD_ERR          xfer_err);
+
+#if (USBD_CFG_EP_DIRECT_CMPL_EN == DEF_ENABLED)
+static  CPU_BOOLEAN   USBD_EP_XferDirectCmpl     (USBD_DRV         *p_drv,
+                                                  USBD_EP          *p_ep,
+                                                  USBD_ERR          xfer_err);
+
+static  void          USBD_EP_XferCmplDefer      (USBD_DRV         *p_drv,
+                                                  USBD_EP          *p_ep,
+                                                  USBD_ERR          xfer_err);
+
+static  void          USBD_EP_LockAcquire        (CPU_INT08U        dev_nbr,
+                                                  CPU_INT08U        ep_ix,
+                                                  CPU_INT16U        timeout_ms,
+                                                  USBD_ERR         *p_err);
+
+static  void          USBD_EP_LockRelease        (CPU_INT08U        dev_nbr,
+                                                  CPU_INT08U        ep_ix);
+#endif
+
 static  USBD_URB     *USBD_EP_URB_Abort          (USBD_DRV         *p_drv,
                                                   USBD_EP          *p_ep,
                                                   USBD_ERR         *p_err);
 
+#if (USBD_CFG_EP_PRE_QUEUE_EN == DEF_ENABLED)
+static  CPU_BOOLEAN   USBD_EP_URB_SubmitRdy      (USBD_EP          *p_ep);
+
+static  USBD_URB     *USBD_EP_URB_Submit         (USBD_DRV         *p_drv,
+                                                  USBD_EP          *p_ep);
+#endif
+
 static  USBD_URB     *USBD_URB_AsyncCmpl         (USBD_EP          *p_ep,
                                                   USBD_ERR          err);
 
@@ -299,6 +531,53 @@ static  void          USBD_URB_Queue             (USBD_EP          *p_ep,
 
 static  void          USBD_URB_Dequeue           (USBD_EP          *p_ep);
 
+#if (USBD_CFG_EP_VEC_XFER_EN == DEF_ENABLED)
+static  CPU_INT32U    USBD_URB_VecNextGet        (CPU_INT08U        dev_nbr,
+                                                  USBD_EP          *p_ep,
+                                                  USBD_URB         *p_urb);
+
+static  void          USBD_URB_VecCopy           (USBD_URB         *p_urb,
+                                                  CPU_INT08U       *p_buf,
+                                                  CPU_INT32U        len,
+                                                  CPU_BOOLEAN       gather);
+
+static  void          USBD_URB_VecAdvance        (USBD_URB         *p_urb,
+                                                  CPU_INT32U        len);
+#endif
+
+#if (USBD_EP_LAT_EN == DEF_ENABLED)
+static  void          USBD_EP_LatRecord          (CPU_INT08U        dev_nbr,
+                                                  USBD_EP          *p_ep,
+                                                  USBD_URB         *p_urb);
+
+static  void          USBD_EP_LatSampleAdd       (USBD_DBG_STATS_LAT  *p_hist,
+                                                  CPU_TS32             lat);
+#endif
+
+#if (USBD_CFG_CAPTURE_EN == DEF_ENABLED)
+static  void          USBD_EP_CaptureXfer        (CPU_INT08U        dev_nbr,
+                                                  USBD_EP          *p_ep,
+                                                  USBD_URB         *p_urb,
+                                                  CPU_BOOLEAN       cmpl,
+                                                  USBD_ERR          err);
+
+static  void          USBD_EP_CaptureRecPut      (CPU_INT08U        dev_nbr,
+                                                  CPU_INT08U        ep_addr,
+                                                  CPU_INT08U        xfer_type,
+                                                  CPU_BOOLEAN       cmpl,
+                                                  CPU_INT08U        stage,
+                                                  CPU_INT32U        irp_id,
+                                                  CPU_INT32U        status,
+                                                  CPU_INT08U       *p_data,
+                                                  CPU_INT32U        data_len);
+
+static  void          USBD_EP_CaptureCopy        (CPU_INT08U       *p_src,
+                                                  CPU_INT32U        len);
+
+static  void          USBD_EP_CaptureTsGet       (CPU_INT32U       *p_sec,
+                                                  CPU_INT32U       *p_us);
+#endif
+
 
 /*
 *********************************************************************************************************
@@ -398,17 +677,17 @@ CPU_INT32U  USBD_BulkRx (CPU_INT08U   dev_nbr,
         return (0u);
     }
 
-    USBD_OS_EP_LockAcquire(p_drv->DevNbr,
-                           p_ep->Ix,
-                           0u,
-                           p_err);
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
     if (*p_err != USBD_ERR_NONE) {
         return (0u);
     }
 
     if (p_ep->State != USBD_EP_STATE_OPEN) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_STATE;
         return (0u);
     }
@@ -416,8 +695,8 @@ CPU_INT32U  USBD_BulkRx (CPU_INT08U   dev_nbr,
                                                                 /* Chk EP attrib.                                       */
     if (((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_BULK) ||
         ((ep_addr      & USBD_EP_DIR_MASK)  != USBD_EP_DIR_OUT)) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_TYPE;
         return (0u);
     }
@@ -431,8 +710,8 @@ CPU_INT32U  USBD_BulkRx (CPU_INT08U   dev_nbr,
                                            timeout_ms,
                                            p_err);
 
-    USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                           p_ep->Ix);
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
 
     USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, BulkRxSyncSuccessNbr, (*p_err == USBD_ERR_NONE));
 
@@ -528,17 +807,17 @@ void  USBD_BulkRxAsync (CPU_INT08U        dev_nbr,
         return;
     }
 
-    USBD_OS_EP_LockAcquire(p_drv->DevNbr,
-                           p_ep->Ix,
-                           0u,
-                           p_err);
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
     if (*p_err != USBD_ERR_NONE) {
         return;
     }
 
     if (p_ep->State != USBD_EP_STATE_OPEN) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_STATE;
         return;
     }
@@ -546,8 +825,8 @@ void  USBD_BulkRxAsync (CPU_INT08U        dev_nbr,
                                                                 /* Chk EP attrib.                                       */
     if (((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_BULK) ||
         ((ep_addr      & USBD_EP_DIR_MASK)  != USBD_EP_DIR_OUT)) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_TYPE;
         return;
     }
@@ -561,8 +840,8 @@ void  USBD_BulkRxAsync (CPU_INT08U        dev_nbr,
                      0u,
                      p_err);
 
-    USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                           p_ep->Ix);
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
 
     USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, BulkRxAsyncSuccessNbr, (*p_err == USBD_ERR_NONE));
 }
@@ -658,25 +937,25 @@ CPU_INT32U  USBD_BulkTx (CPU_INT08U    dev_nbr,
         return (0u);
     }
 
-    USBD_OS_EP_LockAcquire(p_drv->DevNbr,
-                           p_ep->Ix,
-                           0u,
-                           p_err);
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
     if (*p_err != USBD_ERR_NONE) {
         return (0u);
     }
 
     if (p_ep->State != USBD_EP_STATE_OPEN) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_STATE;
         return (0u);
     }
                                                                 /* Chk EP attrib.                                       */
     if (((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_BULK) ||
         ((ep_addr      & USBD_EP_DIR_MASK)  != USBD_EP_DIR_IN)) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_TYPE;
         return (0u);
     }
@@ -691,8 +970,8 @@ CPU_INT32U  USBD_BulkTx (CPU_INT08U    dev_nbr,
                                            end,
                                            p_err);
 
-    USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                           p_ep->Ix);
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
 
     USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, BulkTxSyncSuccessNbr, (*p_err == USBD_ERR_NONE));
 
@@ -794,17 +1073,17 @@ void  USBD_BulkTxAsync (CPU_INT08U        dev_nbr,
         return;
     }
 
-    USBD_OS_EP_LockAcquire(p_drv->DevNbr,
-                           p_ep->Ix,
-                           0u,
-                           p_err);
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
     if (*p_err != USBD_ERR_NONE) {
         return;
     }
 
     if (p_ep->State != USBD_EP_STATE_OPEN) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_STATE;
         return;
     }
@@ -812,8 +1091,8 @@ void  USBD_BulkTxAsync (CPU_INT08U        dev_nbr,
                                                                 /* Chk EP attrib.                                       */
     if (((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_BULK) ||
         ((ep_addr      & USBD_EP_DIR_MASK)  != USBD_EP_DIR_IN)) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_TYPE;
         return;
     }
@@ -828,8 +1107,8 @@ void  USBD_BulkTxAsync (CPU_INT08U        dev_nbr,
                     end,
                     p_err);
 
-   USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                          p_ep->Ix);
+   USBD_EP_LockRelease(p_drv->DevNbr,
+                       p_ep->Ix);
 
    USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, BulkTxAsyncSuccessNbr, (*p_err == USBD_ERR_NONE));
 }
@@ -837,86 +1116,85 @@ void  USBD_BulkTxAsync (CPU_INT08U        dev_nbr,
 
 /*
 *********************************************************************************************************
-*********************************************************************************************************
-*                                    INTERRUPT TRANSFER FUNCTIONS
-*********************************************************************************************************
-*********************************************************************************************************
-*/
-
-/*
-*********************************************************************************************************
-*                                            USBD_IntrRx()
+*                                          USBD_BulkRxVecAsync()
 *
-* Description : Receive data on Interrupt OUT endpoint.
+* Description : Receive data on Bulk OUT endpoint asynchronously, into a table of buffer segments.
 *
-* Argument(s) : dev_nbr     Device number.
+* Argument(s) : dev_nbr         Device number.
 *
-*               ep_addr     Endpoint address.
+*               ep_addr         Endpoint address.
 *
-*               p_buf       Pointer to destination buffer to receive data (see Note #2).
+*               p_seg_tbl       Pointer to table of segments that will receive the data.
 *
-*               buf_len     Number of octets to receive.
+*               seg_nbr         Number of segments in 'p_seg_tbl'.
 *
-*               timeout_ms  Timeout in milliseconds.
+*               async_fnct      Function that will be invoked upon completion of receive operation.
 *
-*               p_err       Pointer to variable that will receive return error code from this function :
+*               p_async_arg     Pointer to argument that will be passed as parameter of 'async_fnct'.
 *
-*                               USBD_ERR_NONE               Data successfully received.
-*                               USBD_ERR_DEV_INVALID_NBR    Invalid device number.
-*                               USBD_ERR_DEV_INVALID_STATE  Transfer type only available if device is in
-*                                                           configured state.
-*                               USBD_ERR_EP_INVALID_ADDR    Invalid endpoint address.
-*                               USBD_ERR_EP_INVALID_STATE   Invalid endpoint state.
-*                               USBD_ERR_EP_INVALID_TYPE    Invalid endpoint type.
+*               p_err           Pointer to variable that will receive return error code from this function :
 *
-*                               - RETURNED BY USBD_OS_EP_LockAcquire() -
-*                               See USBD_OS_EP_LockAcquire() for additional return error codes.
+*                                   USBD_ERR_NONE               Data successfully received.
+*                                   USBD_ERR_NULL_PTR           Parameter 'async_fnct' is a null pointer.
+*                                   USBD_ERR_DEV_INVALID_NBR    Invalid device number.
+*                                   USBD_ERR_DEV_INVALID_STATE  Transfer type only available if device is in
+*                                                               configured state.
+*                                   USBD_ERR_EP_INVALID_ADDR    Invalid endpoint address.
+*                                   USBD_ERR_EP_INVALID_STATE   Invalid endpoint state.
+*                                   USBD_ERR_EP_INVALID_TYPE    Invalid endpoint type.
 *
-*                               - RETURNED BY USBD_EP_Rx() -
-*                               See USBD_EP_Rx() for additional return error codes.
+*                                   - RETURNED BY USBD_OS_EP_LockAcquire() -
+*                                   See USBD_OS_EP_LockAcquire() for additional return error codes.
 *
-* Return(s)   : Number of octets received, if NO error(s).
+*                                   - RETURNED BY USBD_EP_VecXferAsync() -
+*                                   See USBD_EP_VecXferAsync() for additional return error codes.
 *
-*               0,                         otherwise.
+* Return(s)   : none.
 *
-* Note(s)     : (1) This function SHOULD NOT be called from interrupt service routine (ISR).
+* Note(s)     : (1) The segments are transferred in order, as a single transfer. The segment table and
+*                   the segment buffers MUST remain valid until 'async_fnct' is called.
 *
-*               (2) Receive buffer must be at least aligned on a word.
+*               (2) 'async_fnct' is called with 'p_buf' set to 'p_seg_tbl' and 'buf_len' set to the
+*                   total length of the segments.
 *********************************************************************************************************
 */
 
-CPU_INT32U  USBD_IntrRx (CPU_INT08U   dev_nbr,
-                         CPU_INT08U   ep_addr,
-                         void        *p_buf,
-                         CPU_INT32U   buf_len,
-                         CPU_INT16U   timeout_ms,
-                         USBD_ERR    *p_err)
+#if (USBD_CFG_EP_VEC_XFER_EN == DEF_ENABLED)
+void  USBD_BulkRxVecAsync (CPU_INT08U        dev_nbr,
+                           CPU_INT08U        ep_addr,
+                           USBD_BUF_SEG     *p_seg_tbl,
+                           CPU_INT08U        seg_nbr,
+                           USBD_ASYNC_FNCT   async_fnct,
+                           void             *p_async_arg,
+                           USBD_ERR         *p_err)
 {
     USBD_EP         *p_ep;
     USBD_DRV        *p_drv;
     USBD_DEV_STATE   state;
-    CPU_INT32U       xfer_len;
     CPU_INT08U       ep_phy_nbr;
 
 
-    USBD_DBG_STATS_DEV_INC(dev_nbr, IntrRxSyncExecNbr);
-
 #if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)                /* ---------------- VALIDATE ARGUMENTS ---------------- */
     if (p_err == (USBD_ERR *)0) {                               /* Validate error ptr.                                  */
-        CPU_SW_EXCEPTION(0);
+        CPU_SW_EXCEPTION(;);
+    }
+
+    if (async_fnct == (USBD_ASYNC_FNCT)0) {
+       *p_err = USBD_ERR_NULL_PTR;
+        return;
     }
 #endif
 
     p_drv = USBD_DrvRefGet(dev_nbr);                            /* Get dev struct.                                      */
     if (p_drv == (USBD_DRV *)0) {
        *p_err = USBD_ERR_DEV_INVALID_NBR;
-        return (0u);
+        return;
     }
 
     state = USBD_DevStateGet(dev_nbr, p_err);
     if (state != USBD_DEV_STATE_CONFIGURED) {                   /* EP transfers are ONLY allowed in cfg'd state.        */
        *p_err = USBD_ERR_DEV_INVALID_STATE;
-        return (0u);
+        return;
     }
 
     ep_phy_nbr = USBD_EP_ADDR_TO_PHY(ep_addr);
@@ -924,71 +1202,71 @@ CPU_INT32U  USBD_IntrRx (CPU_INT08U   dev_nbr,
 
     if (p_ep == (USBD_EP *)0) {
        *p_err = USBD_ERR_EP_INVALID_ADDR;
-        return (0u);
+        return;
     }
 
-    USBD_OS_EP_LockAcquire(p_drv->DevNbr,
-                           p_ep->Ix,
-                           0u,
-                           p_err);
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
     if (*p_err != USBD_ERR_NONE) {
-        return (0u);
+        return;
     }
 
     if (p_ep->State != USBD_EP_STATE_OPEN) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_STATE;
-        return (0u);
+        return;
     }
+
                                                                 /* Chk EP attrib.                                       */
-    if (((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_INTR) ||
+    if (((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_BULK) ||
         ((ep_addr      & USBD_EP_DIR_MASK)  != USBD_EP_DIR_OUT)) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_TYPE;
-        return (0u);
+        return;
     }
 
-    xfer_len = USBD_EP_Rx(                 p_drv,
-                                           p_ep,
-                                           p_buf,
-                                           buf_len,
-                          (USBD_ASYNC_FNCT)0,
-                          (void          *)0,
-                                           timeout_ms,
-                                           p_err);
-
-    USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                           p_ep->Ix);
-
-    USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, IntrRxSyncSuccessNbr, (*p_err == USBD_ERR_NONE));
+    USBD_EP_VecXferAsync(p_drv,
+                         p_ep,
+                         p_seg_tbl,
+                         seg_nbr,
+                         async_fnct,
+                         p_async_arg,
+                         DEF_NO,
+                         p_err);
 
-    return (xfer_len);
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
 }
+#endif
 
 
 /*
 *********************************************************************************************************
-*                                         USBD_IntrRxAsync()
+*                                          USBD_BulkTxVecAsync()
 *
-* Description : Receive data on Interrupt OUT endpoint asynchronously.
+* Description : Send data on Bulk IN endpoint asynchronously, from a table of buffer segments.
 *
 * Argument(s) : dev_nbr         Device number.
 *
 *               ep_addr         Endpoint address.
 *
-*               p_buf           Pointer to destination buffer to receive data (see Note #1).
+*               p_seg_tbl       Pointer to table of segments holding the data to transmit.
 *
-*               buf_len         Number of octets to receive.
+*               seg_nbr         Number of segments in 'p_seg_tbl'.
 *
-*               async_fnct      Function that will be invoked upon completion of receive operation.
+*               async_fnct      Function that will be invoked upon completion of transmit operation.
 *
 *               p_async_arg     Pointer to argument that will be passed as parameter of 'async_fnct'.
 *
+*               end             End-of-transfer flag (see Note #3).
+*
 *               p_err           Pointer to variable that will receive return error code from this function :
 *
-*                                   USBD_ERR_NONE               Data successfully received.
+*                                   USBD_ERR_NONE               Data successfully transmitted.
 *                                   USBD_ERR_NULL_PTR           Parameter 'async_fnct' is a null pointer.
 *                                   USBD_ERR_DEV_INVALID_NBR    Invalid device number.
 *                                   USBD_ERR_DEV_INVALID_STATE  Transfer type only available if device is in
@@ -1000,31 +1278,38 @@ CPU_INT32U  USBD_IntrRx (CPU_INT08U   dev_nbr,
 *                                   - RETURNED BY USBD_OS_EP_LockAcquire() -
 *                                   See USBD_OS_EP_LockAcquire() for additional return error codes.
 *
-*                                   - RETURNED BY USBD_EP_Rx() -
-*                                   See USBD_EP_Rx() for additional return error codes.
+*                                   - RETURNED BY USBD_EP_VecXferAsync() -
+*                                   See USBD_EP_VecXferAsync() for additional return error codes.
 *
 * Return(s)   : none.
 *
-* Note(s)     : (1) Receive buffer must be at least aligned on a word.
+* Note(s)     : (1) The segments are transferred in order, as a single transfer. The segment table and
+*                   the segment buffers MUST remain valid until 'async_fnct' is called.
+*
+*               (2) 'async_fnct' is called with 'p_buf' set to 'p_seg_tbl' and 'buf_len' set to the
+*                   total length of the segments.
+*
+*               (3) If end-of-transfer is set and the total transfer length is multiple of maximum packet
+*                   size, a zero-length packet is transferred to indicate a short transfer to the host.
 *********************************************************************************************************
 */
 
-void  USBD_IntrRxAsync (CPU_INT08U        dev_nbr,
-                        CPU_INT08U        ep_addr,
-                        void             *p_buf,
-                        CPU_INT32U        buf_len,
-                        USBD_ASYNC_FNCT   async_fnct,
-                        void             *p_async_arg,
-                        USBD_ERR         *p_err)
+#if (USBD_CFG_EP_VEC_XFER_EN == DEF_ENABLED)
+void  USBD_BulkTxVecAsync (CPU_INT08U        dev_nbr,
+                           CPU_INT08U        ep_addr,
+                           USBD_BUF_SEG     *p_seg_tbl,
+                           CPU_INT08U        seg_nbr,
+                           USBD_ASYNC_FNCT   async_fnct,
+                           void             *p_async_arg,
+                           CPU_BOOLEAN       end,
+                           USBD_ERR         *p_err)
 {
     USBD_EP         *p_ep;
     USBD_DRV        *p_drv;
-    CPU_INT08U       ep_phy_nbr;
     USBD_DEV_STATE   state;
+    CPU_INT08U       ep_phy_nbr;
 
 
-    USBD_DBG_STATS_DEV_INC(dev_nbr, IntrRxAsyncExecNbr);
-
 #if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)                /* ---------------- VALIDATE ARGUMENTS ---------------- */
     if (p_err == (USBD_ERR *)0) {                               /* Validate error ptr.                                  */
         CPU_SW_EXCEPTION(;);
@@ -1056,66 +1341,72 @@ void  USBD_IntrRxAsync (CPU_INT08U        dev_nbr,
         return;
     }
 
-    USBD_OS_EP_LockAcquire(p_drv->DevNbr,
-                           p_ep->Ix,
-                           0u,
-                           p_err);
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
     if (*p_err != USBD_ERR_NONE) {
         return;
     }
 
     if (p_ep->State != USBD_EP_STATE_OPEN) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_STATE;
         return;
     }
+
                                                                 /* Chk EP attrib.                                       */
-    if (((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_INTR) ||
-        ((ep_addr      & USBD_EP_DIR_MASK)  != USBD_EP_DIR_OUT)) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+    if (((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_BULK) ||
+        ((ep_addr      & USBD_EP_DIR_MASK)  != USBD_EP_DIR_IN)) {
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_TYPE;
         return;
     }
 
-    (void)USBD_EP_Rx(p_drv,                                     /* Call generic EP rx fnct.                             */
-                     p_ep,
-                     p_buf,
-                     buf_len,
-                     async_fnct,
-                     p_async_arg,
-                     0u,
-                     p_err);
-
-    USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                           p_ep->Ix);
+    USBD_EP_VecXferAsync(p_drv,
+                         p_ep,
+                         p_seg_tbl,
+                         seg_nbr,
+                         async_fnct,
+                         p_async_arg,
+                         end,
+                         p_err);
 
-    USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, IntrRxAsyncSuccessNbr, (*p_err == USBD_ERR_NONE));
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
 }
+#endif
 
 
 /*
 *********************************************************************************************************
-*                                          USBD_EP_IntrTx()
+*********************************************************************************************************
+*                                    INTERRUPT TRANSFER FUNCTIONS
+*********************************************************************************************************
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                            USBD_IntrRx()
 *
-* Description : Send data on Interrupt IN endpoint.
+* Description : Receive data on Interrupt OUT endpoint.
 *
 * Argument(s) : dev_nbr     Device number.
 *
 *               ep_addr     Endpoint address.
 *
-*               p_buf       Pointer to buffer of data that will be transmitted (see Note #2).
+*               p_buf       Pointer to destination buffer to receive data (see Note #2).
 *
-*               buf_len     Number of octets to transmit.
+*               buf_len     Number of octets to receive.
 *
 *               timeout_ms  Timeout in milliseconds.
 *
-*               end         End-of-transfer flag (see Note #3).
-*
 *               p_err       Pointer to variable that will receive return error code from this function :
 *
-*                               USBD_ERR_NONE               Data successfully transmitted.
+*                               USBD_ERR_NONE               Data successfully received.
 *                               USBD_ERR_DEV_INVALID_NBR    Invalid device number.
 *                               USBD_ERR_DEV_INVALID_STATE  Transfer type only available if device is in
 *                                                           configured state.
@@ -1126,38 +1417,34 @@ void  USBD_IntrRxAsync (CPU_INT08U        dev_nbr,
 *                               - RETURNED BY USBD_OS_EP_LockAcquire() -
 *                               See USBD_OS_EP_LockAcquire() for additional return error codes.
 *
-*                               - RETURNED BY USBD_EP_Tx() -
-*                               See USBD_EP_Tx() for additional return error codes.
+*                               - RETURNED BY USBD_EP_Rx() -
+*                               See USBD_EP_Rx() for additional return error codes.
 *
-* Return(s)   : Number of octets transmitted, if NO error(s).
+* Return(s)   : Number of octets received, if NO error(s).
 *
-*               0,                            otherwise.
+*               0,                         otherwise.
 *
 * Note(s)     : (1) This function SHOULD NOT be called from interrupt service routine (ISR).
 *
-*               (2) Transmit buffer must be at least aligned on a word.
-*
-*               (3) If end-of-transfer is set and transfer length is multiple of maximum packet size,
-*                   a zero-length packet is transferred to indicate a short transfer to the host.
+*               (2) Receive buffer must be at least aligned on a word.
 *********************************************************************************************************
 */
 
-CPU_INT32U  USBD_IntrTx (CPU_INT08U    dev_nbr,
-                         CPU_INT08U    ep_addr,
-                         void         *p_buf,
-                         CPU_INT32U    buf_len,
-                         CPU_INT16U    timeout_ms,
-                         CPU_BOOLEAN   end,
-                         USBD_ERR     *p_err)
+CPU_INT32U  USBD_IntrRx (CPU_INT08U   dev_nbr,
+                         CPU_INT08U   ep_addr,
+                         void        *p_buf,
+                         CPU_INT32U   buf_len,
+                         CPU_INT16U   timeout_ms,
+                         USBD_ERR    *p_err)
 {
     USBD_EP         *p_ep;
     USBD_DRV        *p_drv;
-    CPU_INT08U       ep_phy_nbr;
-    CPU_INT32U       xfer_len;
     USBD_DEV_STATE   state;
+    CPU_INT32U       xfer_len;
+    CPU_INT08U       ep_phy_nbr;
 
 
-    USBD_DBG_STATS_DEV_INC(dev_nbr, IntrTxSyncExecNbr);
+    USBD_DBG_STATS_DEV_INC(dev_nbr, IntrRxSyncExecNbr);
 
 #if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)                /* ---------------- VALIDATE ARGUMENTS ---------------- */
     if (p_err == (USBD_ERR *)0) {                               /* Validate error ptr.                                  */
@@ -1185,43 +1472,42 @@ CPU_INT32U  USBD_IntrTx (CPU_INT08U    dev_nbr,
         return (0u);
     }
 
-    USBD_OS_EP_LockAcquire(p_drv->DevNbr,
-                           p_ep->Ix,
-                           0u,
-                           p_err);
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
     if (*p_err != USBD_ERR_NONE) {
         return (0u);
     }
 
     if (p_ep->State != USBD_EP_STATE_OPEN) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_STATE;
         return (0u);
     }
                                                                 /* Chk EP attrib.                                       */
     if (((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_INTR) ||
-        ((ep_addr      & USBD_EP_DIR_MASK)  != USBD_EP_DIR_IN)) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+        ((ep_addr      & USBD_EP_DIR_MASK)  != USBD_EP_DIR_OUT)) {
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_TYPE;
         return (0u);
     }
 
-    xfer_len = USBD_EP_Tx(                 p_drv,
+    xfer_len = USBD_EP_Rx(                 p_drv,
                                            p_ep,
                                            p_buf,
                                            buf_len,
                           (USBD_ASYNC_FNCT)0,
                           (void          *)0,
                                            timeout_ms,
-                                           end,
                                            p_err);
 
-    USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                           p_ep->Ix);
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
 
-    USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, IntrTxSyncSuccessNbr, (*p_err == USBD_ERR_NONE));
+    USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, IntrRxSyncSuccessNbr, (*p_err == USBD_ERR_NONE));
 
     return (xfer_len);
 }
@@ -1229,27 +1515,25 @@ CPU_INT32U  USBD_IntrTx (CPU_INT08U    dev_nbr,
 
 /*
 *********************************************************************************************************
-*                                         USBD_IntrTxAsync()
+*                                         USBD_IntrRxAsync()
 *
-* Description : Send data on Interrupt IN endpoint asynchronously.
+* Description : Receive data on Interrupt OUT endpoint asynchronously.
 *
 * Argument(s) : dev_nbr         Device number.
 *
 *               ep_addr         Endpoint address.
 *
-*               p_buf           Pointer to buffer of data that will be transmitted (see Note #1).
+*               p_buf           Pointer to destination buffer to receive data (see Note #1).
 *
-*               buf_len         Number of octets to transmit.
+*               buf_len         Number of octets to receive.
 *
-*               async_fnct      Function that will be invoked upon completion of transmit operation.
+*               async_fnct      Function that will be invoked upon completion of receive operation.
 *
 *               p_async_arg     Pointer to argument that will be passed as parameter of 'async_fnct'.
 *
-*               end             End-of-transfer flag (see Note #2).
-*
 *               p_err           Pointer to variable that will receive return error code from this function :
 *
-*                                   USBD_ERR_NONE               Data successfully transmitted.
+*                                   USBD_ERR_NONE               Data successfully received.
 *                                   USBD_ERR_NULL_PTR           Parameter 'async_fnct' is a null pointer.
 *                                   USBD_ERR_DEV_INVALID_NBR    Invalid device number.
 *                                   USBD_ERR_DEV_INVALID_STATE  Transfer type only available if device is in
@@ -1261,25 +1545,21 @@ CPU_INT32U  USBD_IntrTx (CPU_INT08U    dev_nbr,
 *                                   - RETURNED BY USBD_OS_EP_LockAcquire() -
 *                                   See USBD_OS_EP_LockAcquire() for additional return error codes.
 *
-*                                   - RETURNED BY USBD_EP_Tx() -
-*                                   See USBD_EP_Tx() for additional return error codes.
+*                                   - RETURNED BY USBD_EP_Rx() -
+*                                   See USBD_EP_Rx() for additional return error codes.
 *
 * Return(s)   : none.
 *
-* Note(s)     : (1) Transmit buffer must be at least aligned on a word.
-*
-*               (2) If end-of-transfer is set and transfer length is multiple of maximum packet size,
-*                   a zero-length packet is transferred to indicate a short transfer to the host.
+* Note(s)     : (1) Receive buffer must be at least aligned on a word.
 *********************************************************************************************************
 */
 
-void  USBD_IntrTxAsync (CPU_INT08U        dev_nbr,
+void  USBD_IntrRxAsync (CPU_INT08U        dev_nbr,
                         CPU_INT08U        ep_addr,
                         void             *p_buf,
                         CPU_INT32U        buf_len,
                         USBD_ASYNC_FNCT   async_fnct,
                         void             *p_async_arg,
-                        CPU_BOOLEAN       end,
                         USBD_ERR         *p_err)
 {
     USBD_EP         *p_ep;
@@ -1288,7 +1568,7 @@ void  USBD_IntrTxAsync (CPU_INT08U        dev_nbr,
     USBD_DEV_STATE   state;
 
 
-    USBD_DBG_STATS_DEV_INC(dev_nbr, IntrTxAsyncExecNbr);
+    USBD_DBG_STATS_DEV_INC(dev_nbr, IntrRxAsyncExecNbr);
 
 #if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)                /* ---------------- VALIDATE ARGUMENTS ---------------- */
     if (p_err == (USBD_ERR *)0) {                               /* Validate error ptr.                                  */
@@ -1321,125 +1601,125 @@ void  USBD_IntrTxAsync (CPU_INT08U        dev_nbr,
         return;
     }
 
-    USBD_OS_EP_LockAcquire(p_drv->DevNbr,
-                           p_ep->Ix,
-                           0u,
-                           p_err);
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
     if (*p_err != USBD_ERR_NONE) {
         return;
     }
 
     if (p_ep->State != USBD_EP_STATE_OPEN) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_STATE;
         return;
     }
                                                                 /* Chk EP attrib.                                       */
     if (((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_INTR) ||
-        ((ep_addr      & USBD_EP_DIR_MASK)  != USBD_EP_DIR_IN)) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+        ((ep_addr      & USBD_EP_DIR_MASK)  != USBD_EP_DIR_OUT)) {
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_TYPE;
         return;
     }
 
-    (void)USBD_EP_Tx(p_drv,
+    (void)USBD_EP_Rx(p_drv,                                     /* Call generic EP rx fnct.                             */
                      p_ep,
                      p_buf,
                      buf_len,
                      async_fnct,
                      p_async_arg,
                      0u,
-                     end,
                      p_err);
 
-    USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                           p_ep->Ix);
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
 
-    USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, IntrTxAsyncSuccessNbr, (*p_err == USBD_ERR_NONE));
+    USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, IntrRxAsyncSuccessNbr, (*p_err == USBD_ERR_NONE));
 }
 
 
 /*
 *********************************************************************************************************
-*                                         USBD_IsocRxAsync()
+*                                          USBD_EP_IntrTx()
 *
-* Description : Receive data on isochronous OUT endpoint asynchronously.
+* Description : Send data on Interrupt IN endpoint.
 *
-* Argument(s) : dev_nbr         Device number.
+* Argument(s) : dev_nbr     Device number.
 *
-*               ep_addr         Endpoint address.
+*               ep_addr     Endpoint address.
 *
-*               p_buf           Pointer to destination buffer to receive data (see Note #1).
+*               p_buf       Pointer to buffer of data that will be transmitted (see Note #2).
 *
-*               buf_len         Number of octets to receive.
+*               buf_len     Number of octets to transmit.
 *
-*               async_fnct      Function that will be invoked upon completion of receive operation.
+*               timeout_ms  Timeout in milliseconds.
 *
-*               p_async_arg     Pointer to argument that will be passed as parameter of 'async_fnct'.
+*               end         End-of-transfer flag (see Note #3).
 *
-*               p_err           Pointer to variable that will receive return error code from this function :
+*               p_err       Pointer to variable that will receive return error code from this function :
 *
-*                                   USBD_ERR_NONE               Data successfully received.
-*                                   USBD_ERR_NULL_PTR           Parameter 'async_fnct' is a null pointer.
-*                                   USBD_ERR_DEV_INVALID_NBR    Invalid device number.
-*                                   USBD_ERR_DEV_INVALID_STATE  Transfer type only available if device is in
-*                                                               configured state.
-*                                   USBD_ERR_EP_INVALID_ADDR    Invalid endpoint address.
-*                                   USBD_ERR_EP_INVALID_STATE   Invalid endpoint state.
-*                                   USBD_ERR_EP_INVALID_TYPE    Invalid endpoint type.
+*                               USBD_ERR_NONE               Data successfully transmitted.
+*                               USBD_ERR_DEV_INVALID_NBR    Invalid device number.
+*                               USBD_ERR_DEV_INVALID_STATE  Transfer type only available if device is in
+*                                                           configured state.
+*                               USBD_ERR_EP_INVALID_ADDR    Invalid endpoint address.
+*                               USBD_ERR_EP_INVALID_STATE   Invalid endpoint state.
+*                               USBD_ERR_EP_INVALID_TYPE    Invalid endpoint type.
 *
-*                                   - RETURNED BY USBD_OS_EP_LockAcquire() -
-*                                   See USBD_OS_EP_LockAcquire() for additional return error codes.
+*                               - RETURNED BY USBD_OS_EP_LockAcquire() -
+*                               See USBD_OS_EP_LockAcquire() for additional return error codes.
 *
-*                                   - RETURNED BY USBD_EP_Rx() -
-*                                   See USBD_EP_Rx() for additional return error codes.
+*                               - RETURNED BY USBD_EP_Tx() -
+*                               See USBD_EP_Tx() for additional return error codes.
 *
-* Return(s)   : none.
+* Return(s)   : Number of octets transmitted, if NO error(s).
 *
-* Note(s)     : (1) Receive buffer must be at least aligned on a word.
+*               0,                            otherwise.
+*
+* Note(s)     : (1) This function SHOULD NOT be called from interrupt service routine (ISR).
+*
+*               (2) Transmit buffer must be at least aligned on a word.
+*
+*               (3) If end-of-transfer is set and transfer length is multiple of maximum packet size,
+*                   a zero-length packet is transferred to indicate a short transfer to the host.
 *********************************************************************************************************
 */
 
-#if (USBD_CFG_EP_ISOC_EN == DEF_ENABLED)
-void  USBD_IsocRxAsync (CPU_INT08U        dev_nbr,
-                        CPU_INT08U        ep_addr,
-                        void             *p_buf,
-                        CPU_INT32U        buf_len,
-                        USBD_ASYNC_FNCT   async_fnct,
-                        void             *p_async_arg,
-                        USBD_ERR         *p_err)
+CPU_INT32U  USBD_IntrTx (CPU_INT08U    dev_nbr,
+                         CPU_INT08U    ep_addr,
+                         void         *p_buf,
+                         CPU_INT32U    buf_len,
+                         CPU_INT16U    timeout_ms,
+                         CPU_BOOLEAN   end,
+                         USBD_ERR     *p_err)
 {
     USBD_EP         *p_ep;
     USBD_DRV        *p_drv;
-    USBD_DEV_STATE   state;
     CPU_INT08U       ep_phy_nbr;
+    CPU_INT32U       xfer_len;
+    USBD_DEV_STATE   state;
 
 
-    USBD_DBG_STATS_DEV_INC(dev_nbr, IsocRxAsyncExecNbr);
+    USBD_DBG_STATS_DEV_INC(dev_nbr, IntrTxSyncExecNbr);
 
 #if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)                /* ---------------- VALIDATE ARGUMENTS ---------------- */
     if (p_err == (USBD_ERR *)0) {                               /* Validate error ptr.                                  */
-        CPU_SW_EXCEPTION(;);
-    }
-
-    if (async_fnct == (USBD_ASYNC_FNCT)0) {
-       *p_err = USBD_ERR_NULL_PTR;
-        return;
+        CPU_SW_EXCEPTION(0);
     }
 #endif
 
     p_drv = USBD_DrvRefGet(dev_nbr);                            /* Get dev struct.                                      */
     if (p_drv == (USBD_DRV *)0) {
        *p_err = USBD_ERR_DEV_INVALID_NBR;
-        return;
+        return (0u);
     }
 
     state = USBD_DevStateGet(dev_nbr, p_err);
     if (state != USBD_DEV_STATE_CONFIGURED) {                   /* EP transfers are ONLY allowed in cfg'd state.        */
        *p_err = USBD_ERR_DEV_INVALID_STATE;
-        return;
+        return (0u);
     }
 
     ep_phy_nbr = USBD_EP_ADDR_TO_PHY(ep_addr);
@@ -1447,54 +1727,56 @@ void  USBD_IsocRxAsync (CPU_INT08U        dev_nbr,
 
     if (p_ep == (USBD_EP *)0) {
        *p_err = USBD_ERR_EP_INVALID_ADDR;
-        return;
+        return (0u);
     }
 
-    USBD_OS_EP_LockAcquire(p_drv->DevNbr,
-                           p_ep->Ix,
-                           0u,
-                           p_err);
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
     if (*p_err != USBD_ERR_NONE) {
-        return;
+        return (0u);
     }
 
     if (p_ep->State != USBD_EP_STATE_OPEN) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_STATE;
-        return;
+        return (0u);
     }
                                                                 /* Chk EP attrib.                                       */
-    if (((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_ISOC) ||
-        ((ep_addr      & USBD_EP_DIR_MASK)  != USBD_EP_DIR_OUT)) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+    if (((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_INTR) ||
+        ((ep_addr      & USBD_EP_DIR_MASK)  != USBD_EP_DIR_IN)) {
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_TYPE;
-        return;
+        return (0u);
     }
 
-    (void)USBD_EP_Rx(p_drv,                                     /* Call generic EP rx fnct.                             */
-                     p_ep,
-                     p_buf,
-                     buf_len,
-                     async_fnct,
-                     p_async_arg,
-                     0u,
-                     p_err);
+    xfer_len = USBD_EP_Tx(                 p_drv,
+                                           p_ep,
+                                           p_buf,
+                                           buf_len,
+                          (USBD_ASYNC_FNCT)0,
+                          (void          *)0,
+                                           timeout_ms,
+                                           end,
+                                           p_err);
 
-    USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                           p_ep->Ix);
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
 
-    USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, IsocRxAsyncSuccessNbr, (*p_err == USBD_ERR_NONE));
+    USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, IntrTxSyncSuccessNbr, (*p_err == USBD_ERR_NONE));
+
+    return (xfer_len);
 }
-#endif
 
 
 /*
 *********************************************************************************************************
-*                                         USBD_IsocTxAsync()
+*                                         USBD_IntrTxAsync()
 *
-* Description : Send data on isochronous IN endpoint asynchronously.
+* Description : Send data on Interrupt IN endpoint asynchronously.
 *
 * Argument(s) : dev_nbr         Device number.
 *
@@ -1507,7 +1789,9 @@ void  USBD_IsocRxAsync (CPU_INT08U        dev_nbr,
 *               async_fnct      Function that will be invoked upon completion of transmit operation.
 *
 *               p_async_arg     Pointer to argument that will be passed as parameter of 'async_fnct'.
-**
+*
+*               end             End-of-transfer flag (see Note #2).
+*
 *               p_err           Pointer to variable that will receive return error code from this function :
 *
 *                                   USBD_ERR_NONE               Data successfully transmitted.
@@ -1528,25 +1812,28 @@ void  USBD_IsocRxAsync (CPU_INT08U        dev_nbr,
 * Return(s)   : none.
 *
 * Note(s)     : (1) Transmit buffer must be at least aligned on a word.
+*
+*               (2) If end-of-transfer is set and transfer length is multiple of maximum packet size,
+*                   a zero-length packet is transferred to indicate a short transfer to the host.
 *********************************************************************************************************
 */
 
-#if (USBD_CFG_EP_ISOC_EN == DEF_ENABLED)
-void  USBD_IsocTxAsync (CPU_INT08U        dev_nbr,
+void  USBD_IntrTxAsync (CPU_INT08U        dev_nbr,
                         CPU_INT08U        ep_addr,
                         void             *p_buf,
                         CPU_INT32U        buf_len,
                         USBD_ASYNC_FNCT   async_fnct,
                         void             *p_async_arg,
+                        CPU_BOOLEAN       end,
                         USBD_ERR         *p_err)
 {
     USBD_EP         *p_ep;
     USBD_DRV        *p_drv;
-    USBD_DEV_STATE   state;
     CPU_INT08U       ep_phy_nbr;
+    USBD_DEV_STATE   state;
 
 
-    USBD_DBG_STATS_DEV_INC(dev_nbr, IsocTxAsyncExecNbr);
+    USBD_DBG_STATS_DEV_INC(dev_nbr, IntrTxAsyncExecNbr);
 
 #if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)                /* ---------------- VALIDATE ARGUMENTS ---------------- */
     if (p_err == (USBD_ERR *)0) {                               /* Validate error ptr.                                  */
@@ -1579,25 +1866,25 @@ void  USBD_IsocTxAsync (CPU_INT08U        dev_nbr,
         return;
     }
 
-    USBD_OS_EP_LockAcquire(p_drv->DevNbr,
-                           p_ep->Ix,
-                           0u,
-                           p_err);
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
     if (*p_err != USBD_ERR_NONE) {
         return;
     }
 
     if (p_ep->State != USBD_EP_STATE_OPEN) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_STATE;
         return;
     }
                                                                 /* Chk EP attrib.                                       */
-    if (((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_ISOC) ||
+    if (((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_INTR) ||
         ((ep_addr      & USBD_EP_DIR_MASK)  != USBD_EP_DIR_IN)) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_TYPE;
         return;
     }
@@ -1609,410 +1896,562 @@ void  USBD_IsocTxAsync (CPU_INT08U        dev_nbr,
                      async_fnct,
                      p_async_arg,
                      0u,
-                     DEF_NO,
+                     end,
                      p_err);
 
-    USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                           p_ep->Ix);
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
 
-    USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, IsocTxAsyncSuccessNbr, (*p_err == USBD_ERR_NONE));
+    USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, IntrTxAsyncSuccessNbr, (*p_err == USBD_ERR_NONE));
 }
-#endif
 
 
 /*
 *********************************************************************************************************
-*                                         USBD_CtrlTxStatus()
+*                                          USBD_IntrRxVecAsync()
 *
-* Description : Handle status stage from host on control (EP0) IN endpoint.
+* Description : Receive data on Interrupt OUT endpoint asynchronously, into a table of buffer segments.
 *
-* Argument(s) : dev_nbr     Device number.
+* Argument(s) : dev_nbr         Device number.
 *
-*               timeout_ms  Timeout in milliseconds.
+*               ep_addr         Endpoint address.
 *
-*               p_err       Pointer to variable that will receive return error code from this function :
+*               p_seg_tbl       Pointer to table of segments that will receive the data.
 *
-*                               USBD_ERR_NONE               Status stage successfully completed.
-*                               USBD_ERR_DEV_INVALID_STATE  Transfer type only available if device is in
-*                                                           default/addressed/configured state.
+*               seg_nbr         Number of segments in 'p_seg_tbl'.
 *
-*                               - RETURNED BY USBD_DevStateGet() -
-*                               See USBD_DevStateGet() for additional return error codes.
+*               async_fnct      Function that will be invoked upon completion of receive operation.
 *
-*                               - RETURNED BY USBD_EP_TxZLP() -
-*                               See USBD_EP_TxZLP() for additional return error codes.
+*               p_async_arg     Pointer to argument that will be passed as parameter of 'async_fnct'.
+*
+*               p_err           Pointer to variable that will receive return error code from this function :
+*
+*                                   USBD_ERR_NONE               Data successfully received.
+*                                   USBD_ERR_NULL_PTR           Parameter 'async_fnct' is a null pointer.
+*                                   USBD_ERR_DEV_INVALID_NBR    Invalid device number.
+*                                   USBD_ERR_DEV_INVALID_STATE  Transfer type only available if device is in
+*                                                               configured state.
+*                                   USBD_ERR_EP_INVALID_ADDR    Invalid endpoint address.
+*                                   USBD_ERR_EP_INVALID_STATE   Invalid endpoint state.
+*                                   USBD_ERR_EP_INVALID_TYPE    Invalid endpoint type.
+*
+*                                   - RETURNED BY USBD_OS_EP_LockAcquire() -
+*                                   See USBD_OS_EP_LockAcquire() for additional return error codes.
+*
+*                                   - RETURNED BY USBD_EP_VecXferAsync() -
+*                                   See USBD_EP_VecXferAsync() for additional return error codes.
 *
 * Return(s)   : none.
 *
-* Note(s)     : none.
+* Note(s)     : (1) The segments are transferred in order, as a single transfer. The segment table and
+*                   the segment buffers MUST remain valid until 'async_fnct' is called.
+*
+*               (2) 'async_fnct' is called with 'p_buf' set to 'p_seg_tbl' and 'buf_len' set to the
+*                   total length of the segments.
 *********************************************************************************************************
 */
 
-void  USBD_CtrlTxStatus (CPU_INT08U   dev_nbr,
-                         CPU_INT16U   timeout_ms,
-                         USBD_ERR    *p_err)
+#if (USBD_CFG_EP_VEC_XFER_EN == DEF_ENABLED)
+void  USBD_IntrRxVecAsync (CPU_INT08U        dev_nbr,
+                           CPU_INT08U        ep_addr,
+                           USBD_BUF_SEG     *p_seg_tbl,
+                           CPU_INT08U        seg_nbr,
+                           USBD_ASYNC_FNCT   async_fnct,
+                           void             *p_async_arg,
+                           USBD_ERR         *p_err)
 {
-    USBD_DEV_STATE  state;
+    USBD_EP         *p_ep;
+    USBD_DRV        *p_drv;
+    USBD_DEV_STATE   state;
+    CPU_INT08U       ep_phy_nbr;
 
 
-    USBD_DBG_STATS_DEV_INC(dev_nbr, CtrlTxStatusExecNbr);
+#if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)                /* ---------------- VALIDATE ARGUMENTS ---------------- */
+    if (p_err == (USBD_ERR *)0) {                               /* Validate error ptr.                                  */
+        CPU_SW_EXCEPTION(;);
+    }
+
+    if (async_fnct == (USBD_ASYNC_FNCT)0) {
+       *p_err = USBD_ERR_NULL_PTR;
+        return;
+    }
+#endif
+
+    p_drv = USBD_DrvRefGet(dev_nbr);                            /* Get dev struct.                                      */
+    if (p_drv == (USBD_DRV *)0) {
+       *p_err = USBD_ERR_DEV_INVALID_NBR;
+        return;
+    }
 
     state = USBD_DevStateGet(dev_nbr, p_err);
+    if (state != USBD_DEV_STATE_CONFIGURED) {                   /* EP transfers are ONLY allowed in cfg'd state.        */
+       *p_err = USBD_ERR_DEV_INVALID_STATE;
+        return;
+    }
+
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(ep_addr);
+    p_ep       = USBD_EP_TblPtrs[dev_nbr][ep_phy_nbr];
+
+    if (p_ep == (USBD_EP *)0) {
+       *p_err = USBD_ERR_EP_INVALID_ADDR;
+        return;
+    }
+
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
     if (*p_err != USBD_ERR_NONE) {
         return;
     }
 
-    if ((state != USBD_DEV_STATE_DEFAULT)    &&
-        (state != USBD_DEV_STATE_ADDRESSED)  &&
-        (state != USBD_DEV_STATE_CONFIGURED)) {
-       *p_err  = USBD_ERR_DEV_INVALID_STATE;
+    if (p_ep->State != USBD_EP_STATE_OPEN) {
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
+       *p_err = USBD_ERR_EP_INVALID_STATE;
         return;
     }
 
-    USBD_EP_TxZLP(dev_nbr,
-                  USBD_EP_ADDR_CTRL_IN,
-                  timeout_ms,
-                  p_err);
-    USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, CtrlTxStatusSuccessNbr, (*p_err == USBD_ERR_NONE));
+                                                                /* Chk EP attrib.                                       */
+    if (((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_INTR) ||
+        ((ep_addr      & USBD_EP_DIR_MASK)  != USBD_EP_DIR_OUT)) {
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
+       *p_err = USBD_ERR_EP_INVALID_TYPE;
+        return;
+    }
+
+    USBD_EP_VecXferAsync(p_drv,
+                         p_ep,
+                         p_seg_tbl,
+                         seg_nbr,
+                         async_fnct,
+                         p_async_arg,
+                         DEF_NO,
+                         p_err);
+
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
 }
+#endif
 
 
 /*
 *********************************************************************************************************
-*                                            USBD_CtrlRx()
+*                                          USBD_IntrTxVecAsync()
 *
-* Description : Receive data on Control OUT endpoint.
+* Description : Send data on Interrupt IN endpoint asynchronously, from a table of buffer segments.
 *
-* Argument(s) : dev_nbr     Device number.
+* Argument(s) : dev_nbr         Device number.
 *
-*               p_buf       Pointer to destination buffer to receive data.
+*               ep_addr         Endpoint address.
 *
-*               buf_len     Number of octets to receive.
+*               p_seg_tbl       Pointer to table of segments holding the data to transmit.
 *
-*               timeout_ms  Timeout in milliseconds.
+*               seg_nbr         Number of segments in 'p_seg_tbl'.
 *
-*               p_err       Pointer to variable that will receive return error code from this function :
+*               async_fnct      Function that will be invoked upon completion of transmit operation.
 *
-*                               USBD_ERR_NONE               Data successfully received.
-*                               USBD_ERR_DEV_INVALID_NBR    Invalid device number.
-*                               USBD_ERR_DEV_INVALID_STATE  Transfer type only available if device is in
-*                                                           default/addressed/configured state.
-*                               USBD_ERR_EP_INVALID_ADDR    Invalid endpoint address.
-*                               USBD_ERR_EP_INVALID_STATE   Invalid endpoint state.
-*                               USBD_ERR_EP_INVALID_TYPE    Invalid endpoint type.
+*               p_async_arg     Pointer to argument that will be passed as parameter of 'async_fnct'.
 *
-*                               - RETURNED BY USBD_OS_EP_LockAcquire() -
-*                               See USBD_OS_EP_LockAcquire() for additional return error codes.
+*               end             End-of-transfer flag (see Note #3).
 *
-*                               - RETURNED BY USBD_EP_Rx() -
-*                               See USBD_EP_Rx() for additional return error codes.
+*               p_err           Pointer to variable that will receive return error code from this function :
 *
-* Return(s)   : Number of octets received, if NO error(s).
+*                                   USBD_ERR_NONE               Data successfully transmitted.
+*                                   USBD_ERR_NULL_PTR           Parameter 'async_fnct' is a null pointer.
+*                                   USBD_ERR_DEV_INVALID_NBR    Invalid device number.
+*                                   USBD_ERR_DEV_INVALID_STATE  Transfer type only available if device is in
+*                                                               configured state.
+*                                   USBD_ERR_EP_INVALID_ADDR    Invalid endpoint address.
+*                                   USBD_ERR_EP_INVALID_STATE   Invalid endpoint state.
+*                                   USBD_ERR_EP_INVALID_TYPE    Invalid endpoint type.
 *
-*               0,                         otherwise.
+*                                   - RETURNED BY USBD_OS_EP_LockAcquire() -
+*                                   See USBD_OS_EP_LockAcquire() for additional return error codes.
 *
-* Note(s)     : none.
+*                                   - RETURNED BY USBD_EP_VecXferAsync() -
+*                                   See USBD_EP_VecXferAsync() for additional return error codes.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) The segments are transferred in order, as a single transfer. The segment table and
+*                   the segment buffers MUST remain valid until 'async_fnct' is called.
+*
+*               (2) 'async_fnct' is called with 'p_buf' set to 'p_seg_tbl' and 'buf_len' set to the
+*                   total length of the segments.
+*
+*               (3) If end-of-transfer is set and the total transfer length is multiple of maximum packet
+*                   size, a zero-length packet is transferred to indicate a short transfer to the host.
 *********************************************************************************************************
 */
 
-CPU_INT32U  USBD_CtrlRx (CPU_INT08U    dev_nbr,
-                         void         *p_buf,
-                         CPU_INT32U    buf_len,
-                         CPU_INT16U    timeout_ms,
-                         USBD_ERR     *p_err)
+#if (USBD_CFG_EP_VEC_XFER_EN == DEF_ENABLED)
+void  USBD_IntrTxVecAsync (CPU_INT08U        dev_nbr,
+                           CPU_INT08U        ep_addr,
+                           USBD_BUF_SEG     *p_seg_tbl,
+                           CPU_INT08U        seg_nbr,
+                           USBD_ASYNC_FNCT   async_fnct,
+                           void             *p_async_arg,
+                           CPU_BOOLEAN       end,
+                           USBD_ERR         *p_err)
 {
-    USBD_DRV        *p_drv;
     USBD_EP         *p_ep;
-    CPU_INT08U       ep_phy_nbr;
+    USBD_DRV        *p_drv;
     USBD_DEV_STATE   state;
-    CPU_INT32U       xfer_len;
-
+    CPU_INT08U       ep_phy_nbr;
 
-    USBD_DBG_STATS_DEV_INC(dev_nbr, CtrlRxSyncExecNbr);
 
 #if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)                /* ---------------- VALIDATE ARGUMENTS ---------------- */
     if (p_err == (USBD_ERR *)0) {                               /* Validate error ptr.                                  */
-        CPU_SW_EXCEPTION(0);
+        CPU_SW_EXCEPTION(;);
+    }
+
+    if (async_fnct == (USBD_ASYNC_FNCT)0) {
+       *p_err = USBD_ERR_NULL_PTR;
+        return;
     }
 #endif
 
     p_drv = USBD_DrvRefGet(dev_nbr);                            /* Get dev struct.                                      */
     if (p_drv == (USBD_DRV *)0) {
        *p_err = USBD_ERR_DEV_INVALID_NBR;
-        return (0u);
+        return;
     }
 
     state = USBD_DevStateGet(dev_nbr, p_err);
-    if ((state != USBD_DEV_STATE_DEFAULT)   &&
-        (state != USBD_DEV_STATE_ADDRESSED) &&
-        (state != USBD_DEV_STATE_CONFIGURED)) {
+    if (state != USBD_DEV_STATE_CONFIGURED) {                   /* EP transfers are ONLY allowed in cfg'd state.        */
        *p_err = USBD_ERR_DEV_INVALID_STATE;
-        return (0u);
+        return;
     }
 
-    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(USBD_EP_ADDR_CTRL_OUT);
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(ep_addr);
     p_ep       = USBD_EP_TblPtrs[dev_nbr][ep_phy_nbr];
 
     if (p_ep == (USBD_EP *)0) {
        *p_err = USBD_ERR_EP_INVALID_ADDR;
-        return (0u);
+        return;
     }
 
-    USBD_OS_EP_LockAcquire(p_drv->DevNbr,
-                           p_ep->Ix,
-                           0u,
-                           p_err);
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
     if (*p_err != USBD_ERR_NONE) {
-        return (0u);
+        return;
     }
 
     if (p_ep->State != USBD_EP_STATE_OPEN) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_STATE;
-        return (0u);
+        return;
     }
+
                                                                 /* Chk EP attrib.                                       */
-    if ((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_CTRL) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+    if (((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_INTR) ||
+        ((ep_addr      & USBD_EP_DIR_MASK)  != USBD_EP_DIR_IN)) {
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_TYPE;
-        return (0u);
+        return;
     }
 
-    xfer_len = USBD_EP_Rx(                 p_drv,
-                                           p_ep,
-                                           p_buf,
-                                           buf_len,
-                          (USBD_ASYNC_FNCT)0,
-                          (void          *)0,
-                                           timeout_ms,
-                                           p_err);
+    USBD_EP_VecXferAsync(p_drv,
+                         p_ep,
+                         p_seg_tbl,
+                         seg_nbr,
+                         async_fnct,
+                         p_async_arg,
+                         end,
+                         p_err);
 
-    USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                           p_ep->Ix);
-
-    USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, CtrlRxSyncSuccessNbr, (*p_err == USBD_ERR_NONE));
-
-    return (xfer_len);
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
 }
+#endif
 
 
 /*
 *********************************************************************************************************
-*                                            USBD_CtrlTx()
+*                                         USBD_IsocRxAsync()
 *
-* Description : Send data on Control IN endpoint.
+* Description : Receive data on isochronous OUT endpoint asynchronously.
 *
-* Argument(s) : dev_nbr     Device number.
+* Argument(s) : dev_nbr         Device number.
 *
-*               p_buf       Pointer to buffer of data that will be sent.
+*               ep_addr         Endpoint address.
 *
-*               buf_len     Number of octets to transmit.
+*               p_buf           Pointer to destination buffer to receive data (see Note #1).
 *
-*               timeout_ms  Timeout in milliseconds.
+*               buf_len         Number of octets to receive.
 *
-*               end         End-of-transfer flag (see Note #1).
+*               async_fnct      Function that will be invoked upon completion of receive operation.
 *
-*               p_err       Pointer to variable that will receive return error code from this function :
+*               p_async_arg     Pointer to argument that will be passed as parameter of 'async_fnct'.
 *
-*                               USBD_ERR_NONE               Data successfully transmitted.
-*                               USBD_ERR_DEV_INVALID_NBR    Invalid device number.
-*                               USBD_ERR_DEV_INVALID_STATE  Transfer type only available if device is in
-*                                                           configured state.
-*                               USBD_ERR_INVALID_ARG        Invalid argument(s): 'buf_len'.
-*                               USBD_ERR_EP_INVALID_ADDR    Invalid endpoint address.
-*                               USBD_ERR_EP_INVALID_STATE   Invalid endpoint state.
-*                               USBD_ERR_EP_INVALID_TYPE    Invalid endpoint type.
+*               p_err           Pointer to variable that will receive return error code from this function :
 *
-*                               - RETURNED BY USBD_OS_EP_LockAcquire() -
-*                               See USBD_OS_EP_LockAcquire() for additional return error codes.
+*                                   USBD_ERR_NONE               Data successfully received.
+*                                   USBD_ERR_NULL_PTR           Parameter 'async_fnct' is a null pointer.
+*                                   USBD_ERR_DEV_INVALID_NBR    Invalid device number.
+*                                   USBD_ERR_DEV_INVALID_STATE  Transfer type only available if device is in
+*                                                               configured state.
+*                                   USBD_ERR_EP_INVALID_ADDR    Invalid endpoint address.
+*                                   USBD_ERR_EP_INVALID_STATE   Invalid endpoint state.
+*                                   USBD_ERR_EP_INVALID_TYPE    Invalid endpoint type.
 *
-*                               - RETURNED BY USBD_EP_Tx() -
-*                               See USBD_EP_Tx() for additional return error codes.
+*                                   - RETURNED BY USBD_OS_EP_LockAcquire() -
+*                                   See USBD_OS_EP_LockAcquire() for additional return error codes.
 *
-* Return(s)   : Number of octets transmitted, if NO error(s).
+*                                   - RETURNED BY USBD_EP_Rx() -
+*                                   See USBD_EP_Rx() for additional return error codes.
 *
-*               0,                            otherwise.
+* Return(s)   : none.
 *
-* Note(s)     : (1) If end-of-transfer is set and transfer length is multiple of maximum packet size,
-*                   a zero-length packet is transferred to indicate a short transfer to the host.
+* Note(s)     : (1) Receive buffer must be at least aligned on a word.
 *********************************************************************************************************
 */
 
-CPU_INT32U  USBD_CtrlTx (CPU_INT08U    dev_nbr,
-                         void         *p_buf,
-                         CPU_INT32U    buf_len,
-                         CPU_INT16U    timeout_ms,
-                         CPU_BOOLEAN   end,
-                         USBD_ERR     *p_err)
+#if (USBD_CFG_EP_ISOC_EN == DEF_ENABLED)
+void  USBD_IsocRxAsync (CPU_INT08U        dev_nbr,
+                        CPU_INT08U        ep_addr,
+                        void             *p_buf,
+                        CPU_INT32U        buf_len,
+                        USBD_ASYNC_FNCT   async_fnct,
+                        void             *p_async_arg,
+                        USBD_ERR         *p_err)
 {
-    USBD_DRV        *p_drv;
     USBD_EP         *p_ep;
-    CPU_INT08U       ep_phy_nbr;
+    USBD_DRV        *p_drv;
     USBD_DEV_STATE   state;
-    CPU_INT32U       xfer_len;
+    CPU_INT08U       ep_phy_nbr;
 
 
-    USBD_DBG_STATS_DEV_INC(dev_nbr, CtrlTxSyncExecNbr);
+    USBD_DBG_STATS_DEV_INC(dev_nbr, IsocRxAsyncExecNbr);
 
 #if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)                /* ---------------- VALIDATE ARGUMENTS ---------------- */
     if (p_err == (USBD_ERR *)0) {                               /* Validate error ptr.                                  */
-        CPU_SW_EXCEPTION(0);
+        CPU_SW_EXCEPTION(;);
+    }
+
+    if (async_fnct == (USBD_ASYNC_FNCT)0) {
+       *p_err = USBD_ERR_NULL_PTR;
+        return;
     }
 #endif
 
     p_drv = USBD_DrvRefGet(dev_nbr);                            /* Get dev struct.                                      */
     if (p_drv == (USBD_DRV *)0) {
        *p_err = USBD_ERR_DEV_INVALID_NBR;
-        return (0u);
+        return;
     }
 
     state = USBD_DevStateGet(dev_nbr, p_err);
-    if ((state != USBD_DEV_STATE_DEFAULT)   &&
-        (state != USBD_DEV_STATE_ADDRESSED) &&
-        (state != USBD_DEV_STATE_CONFIGURED)) {
+    if (state != USBD_DEV_STATE_CONFIGURED) {                   /* EP transfers are ONLY allowed in cfg'd state.        */
        *p_err = USBD_ERR_DEV_INVALID_STATE;
-        return (0u);
-    }
-
-    if (buf_len == 0u) {
-       *p_err = USBD_ERR_INVALID_ARG;
-        return (0u);
+        return;
     }
 
-    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(USBD_EP_ADDR_CTRL_IN);
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(ep_addr);
     p_ep       = USBD_EP_TblPtrs[dev_nbr][ep_phy_nbr];
 
     if (p_ep == (USBD_EP *)0) {
        *p_err = USBD_ERR_EP_INVALID_ADDR;
-        return (0u);
+        return;
     }
 
-    USBD_OS_EP_LockAcquire(p_drv->DevNbr,
-                           p_ep->Ix,
-                           0u,
-                           p_err);
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
     if (*p_err != USBD_ERR_NONE) {
-        return (0u);
+        return;
     }
 
     if (p_ep->State != USBD_EP_STATE_OPEN) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_STATE;
-        return (0u);
+        return;
     }
                                                                 /* Chk EP attrib.                                       */
-    if ((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_CTRL) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+    if (((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_ISOC) ||
+        ((ep_addr      & USBD_EP_DIR_MASK)  != USBD_EP_DIR_OUT)) {
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_TYPE;
-        return (0u);
+        return;
     }
 
-    xfer_len = USBD_EP_Tx(                 p_drv,
-                                           p_ep,
-                                           p_buf,
-                                           buf_len,
-                          (USBD_ASYNC_FNCT)0,
-                          (void          *)0,
-                                           timeout_ms,
-                                           end,
-                                           p_err);
-
-    USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                           p_ep->Ix);
-
-    USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, CtrlTxSyncSuccessNbr, (*p_err == USBD_ERR_NONE));
-
-    return (xfer_len);
+    (void)USBD_EP_Rx(p_drv,                                     /* Call generic EP rx fnct.                             */
+                     p_ep,
+                     p_buf,
+                     buf_len,
+                     async_fnct,
+                     p_async_arg,
+                     0u,
+                     p_err);
+
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
+
+    USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, IsocRxAsyncSuccessNbr, (*p_err == USBD_ERR_NONE));
 }
+#endif
 
 
 /*
 *********************************************************************************************************
-*                                         USBD_CtrlRxStatus()
+*                                         USBD_IsocTxAsync()
 *
-* Description : Handle status stage from host on control (EP0) OUT endpoint.
+* Description : Send data on isochronous IN endpoint asynchronously.
 *
-* Argument(s) : dev_nbr     Device number.
+* Argument(s) : dev_nbr         Device number.
 *
-*               timeout_ms  Timeout in milliseconds.
+*               ep_addr         Endpoint address.
 *
-*               p_err       Pointer to variable that will receive return error code from this function :
+*               p_buf           Pointer to buffer of data that will be transmitted (see Note #1).
 *
-*                               USBD_ERR_NONE               Status stage successfully completed.
-*                               USBD_ERR_DEV_INVALID_STATE  Transfer type only available if device is in
-*                                                           default/addressed/configured state.
+*               buf_len         Number of octets to transmit.
 *
-*                               - RETURNED BY USBD_DevStateGet() -
-*                               See USBD_DevStateGet() for additional return error codes.
+*               async_fnct      Function that will be invoked upon completion of transmit operation.
 *
-*                               - RETURNED BY USBD_EP_RxZLP() -
-*                               See USBD_EP_RxZLP() for additional return error codes.
+*               p_async_arg     Pointer to argument that will be passed as parameter of 'async_fnct'.
+**
+*               p_err           Pointer to variable that will receive return error code from this function :
+*
+*                                   USBD_ERR_NONE               Data successfully transmitted.
+*                                   USBD_ERR_NULL_PTR           Parameter 'async_fnct' is a null pointer.
+*                                   USBD_ERR_DEV_INVALID_NBR    Invalid device number.
+*                                   USBD_ERR_DEV_INVALID_STATE  Transfer type only available if device is in
+*                                                               configured state.
+*                                   USBD_ERR_EP_INVALID_ADDR    Invalid endpoint address.
+*                                   USBD_ERR_EP_INVALID_STATE   Invalid endpoint state.
+*                                   USBD_ERR_EP_INVALID_TYPE    Invalid endpoint type.
+*
+*                                   - RETURNED BY USBD_OS_EP_LockAcquire() -
+*                                   See USBD_OS_EP_LockAcquire() for additional return error codes.
+*
+*                                   - RETURNED BY USBD_EP_Tx() -
+*                                   See USBD_EP_Tx() for additional return error codes.
 *
 * Return(s)   : none.
 *
-* Note(s)     : none.
+* Note(s)     : (1) Transmit buffer must be at least aligned on a word.
 *********************************************************************************************************
 */
 
-void  USBD_CtrlRxStatus (CPU_INT08U   dev_nbr,
-                         CPU_INT16U   timeout_ms,
-                         USBD_ERR    *p_err)
+#if (USBD_CFG_EP_ISOC_EN == DEF_ENABLED)
+void  USBD_IsocTxAsync (CPU_INT08U        dev_nbr,
+                        CPU_INT08U        ep_addr,
+                        void             *p_buf,
+                        CPU_INT32U        buf_len,
+                        USBD_ASYNC_FNCT   async_fnct,
+                        void             *p_async_arg,
+                        USBD_ERR         *p_err)
 {
-    USBD_DEV_STATE  state;
+    USBD_EP         *p_ep;
+    USBD_DRV        *p_drv;
+    USBD_DEV_STATE   state;
+    CPU_INT08U       ep_phy_nbr;
 
 
-    USBD_DBG_STATS_DEV_INC(dev_nbr, CtrlRxStatusExecNbr);
+    USBD_DBG_STATS_DEV_INC(dev_nbr, IsocTxAsyncExecNbr);
+
+#if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)                /* ---------------- VALIDATE ARGUMENTS ---------------- */
+    if (p_err == (USBD_ERR *)0) {                               /* Validate error ptr.                                  */
+        CPU_SW_EXCEPTION(;);
+    }
+
+    if (async_fnct == (USBD_ASYNC_FNCT)0) {
+       *p_err = USBD_ERR_NULL_PTR;
+        return;
+    }
+#endif
+
+    p_drv = USBD_DrvRefGet(dev_nbr);                            /* Get dev struct.                                      */
+    if (p_drv == (USBD_DRV *)0) {
+       *p_err = USBD_ERR_DEV_INVALID_NBR;
+        return;
+    }
 
     state = USBD_DevStateGet(dev_nbr, p_err);
+    if (state != USBD_DEV_STATE_CONFIGURED) {                   /* EP transfers are ONLY allowed in cfg'd state.        */
+       *p_err = USBD_ERR_DEV_INVALID_STATE;
+        return;
+    }
+
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(ep_addr);
+    p_ep       = USBD_EP_TblPtrs[dev_nbr][ep_phy_nbr];
+
+    if (p_ep == (USBD_EP *)0) {
+       *p_err = USBD_ERR_EP_INVALID_ADDR;
+        return;
+    }
+
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
     if (*p_err != USBD_ERR_NONE) {
         return;
     }
 
-    if ((state != USBD_DEV_STATE_DEFAULT)   &&
-        (state != USBD_DEV_STATE_ADDRESSED) &&
-        (state != USBD_DEV_STATE_CONFIGURED)) {
-       *p_err  = USBD_ERR_DEV_INVALID_STATE;
+    if (p_ep->State != USBD_EP_STATE_OPEN) {
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
+       *p_err = USBD_ERR_EP_INVALID_STATE;
+        return;
+    }
+                                                                /* Chk EP attrib.                                       */
+    if (((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_ISOC) ||
+        ((ep_addr      & USBD_EP_DIR_MASK)  != USBD_EP_DIR_IN)) {
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
+       *p_err = USBD_ERR_EP_INVALID_TYPE;
         return;
     }
 
-    USBD_EP_RxZLP(dev_nbr,
-                  USBD_EP_ADDR_CTRL_OUT,
-                  timeout_ms,
-                  p_err);
+    (void)USBD_EP_Tx(p_drv,
+                     p_ep,
+                     p_buf,
+                     buf_len,
+                     async_fnct,
+                     p_async_arg,
+                     0u,
+                     DEF_NO,
+                     p_err);
 
-    USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, CtrlRxStatusSuccessNbr, (*p_err == USBD_ERR_NONE));
-}
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
 
+    USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, IsocTxAsyncSuccessNbr, (*p_err == USBD_ERR_NONE));
+}
+#endif
 
-/*
-*********************************************************************************************************
-*********************************************************************************************************
-*                                     CONTROL ENDPOINT FUNCTIONS
-*********************************************************************************************************
-*********************************************************************************************************
-*/
 
 /*
 *********************************************************************************************************
-*                                           USBD_CtrlOpen()
+*                                         USBD_CtrlTxStatus()
 *
-* Description : Open control endpoints.
+* Description : Handle status stage from host on control (EP0) IN endpoint.
 *
-* Argument(s) : dev_nbr         Device number.
+* Argument(s) : dev_nbr     Device number.
 *
-*               max_pkt_size    Maximum packet size.
+*               timeout_ms  Timeout in milliseconds.
 *
-*               p_err           Pointer to variable that will receive return error code from this function :
+*               p_err       Pointer to variable that will receive return error code from this function :
 *
-*                                   USBD_ERR_NONE               Control endpoint successfully opened.
-*                                   USBD_ERR_DEV_INVALID_NBR    Invalid device number.
+*                               USBD_ERR_NONE               Status stage successfully completed.
+*                               USBD_ERR_DEV_INVALID_STATE  Transfer type only available if device is in
+*                                                           default/addressed/configured state.
 *
-*                                   - RETURNED BY USBD_EP_Open() -
-*                                   See USBD_EP_Open() for additional return error codes.
+*                               - RETURNED BY USBD_DevStateGet() -
+*                               See USBD_DevStateGet() for additional return error codes.
+*
+*                               - RETURNED BY USBD_EP_TxZLP() -
+*                               See USBD_EP_TxZLP() for additional return error codes.
 *
 * Return(s)   : none.
 *
@@ -2020,210 +2459,371 @@ void  USBD_CtrlRxStatus (CPU_INT08U   dev_nbr,
 *********************************************************************************************************
 */
 
-void  USBD_CtrlOpen (CPU_INT08U   dev_nbr,
-                     CPU_INT16U   max_pkt_size,
-                     USBD_ERR    *p_err)
+void  USBD_CtrlTxStatus (CPU_INT08U   dev_nbr,
+                         CPU_INT16U   timeout_ms,
+                         USBD_ERR    *p_err)
 {
-    USBD_DRV  *p_drv;
-    USBD_ERR   local_err;
+    USBD_DEV_STATE  state;
 
 
-    p_drv = USBD_DrvRefGet(dev_nbr);                            /* Get dev struct.                                      */
-    if (p_drv == (USBD_DRV *)0) {
-       *p_err = USBD_ERR_DEV_INVALID_NBR;
-        return;
-    }
+    USBD_DBG_STATS_DEV_INC(dev_nbr, CtrlTxStatusExecNbr);
 
-    USBD_EP_Open(p_drv,
-                 USBD_EP_ADDR_CTRL_IN,
-                 max_pkt_size,
-                 USBD_EP_TYPE_CTRL,
-                 0u,
-                 p_err);
+    state = USBD_DevStateGet(dev_nbr, p_err);
     if (*p_err != USBD_ERR_NONE) {
         return;
     }
 
-    USBD_EP_Open(p_drv,
-                 USBD_EP_ADDR_CTRL_OUT,
-                 max_pkt_size,
-                 USBD_EP_TYPE_CTRL,
-                 0u,
-                 p_err);
-    if (*p_err != USBD_ERR_NONE) {
-        USBD_EP_Close(p_drv, USBD_EP_ADDR_CTRL_IN,  &local_err);
+    if ((state != USBD_DEV_STATE_DEFAULT)    &&
+        (state != USBD_DEV_STATE_ADDRESSED)  &&
+        (state != USBD_DEV_STATE_CONFIGURED)) {
+       *p_err  = USBD_ERR_DEV_INVALID_STATE;
         return;
     }
 
-   *p_err = USBD_ERR_NONE;
+    USBD_EP_TxZLP(dev_nbr,
+                  USBD_EP_ADDR_CTRL_IN,
+                  timeout_ms,
+                  p_err);
+    USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, CtrlTxStatusSuccessNbr, (*p_err == USBD_ERR_NONE));
 }
 
 
 /*
 *********************************************************************************************************
-*                                          USBD_CtrlClose()
+*                                            USBD_CtrlRx()
 *
-* Description : Close control endpoint.
+* Description : Receive data on Control OUT endpoint.
 *
 * Argument(s) : dev_nbr     Device number.
 *
+*               p_buf       Pointer to destination buffer to receive data.
+*
+*               buf_len     Number of octets to receive.
+*
+*               timeout_ms  Timeout in milliseconds.
+*
 *               p_err       Pointer to variable that will receive return error code from this function :
 *
-*                               USBD_ERR_NONE               Control endpoint successfully closed.
+*                               USBD_ERR_NONE               Data successfully received.
 *                               USBD_ERR_DEV_INVALID_NBR    Invalid device number.
+*                               USBD_ERR_DEV_INVALID_STATE  Transfer type only available if device is in
+*                                                           default/addressed/configured state.
+*                               USBD_ERR_EP_INVALID_ADDR    Invalid endpoint address.
+*                               USBD_ERR_EP_INVALID_STATE   Invalid endpoint state.
+*                               USBD_ERR_EP_INVALID_TYPE    Invalid endpoint type.
 *
-*                               - RETURNED BY USBD_EP_Close() -
-*                               See USBD_EP_Close() for additional return error codes.
+*                               - RETURNED BY USBD_OS_EP_LockAcquire() -
+*                               See USBD_OS_EP_LockAcquire() for additional return error codes.
 *
-* Return(s)   : none.
+*                               - RETURNED BY USBD_EP_Rx() -
+*                               See USBD_EP_Rx() for additional return error codes.
+*
+* Return(s)   : Number of octets received, if NO error(s).
+*
+*               0,                         otherwise.
 *
 * Note(s)     : none.
 *********************************************************************************************************
 */
 
-void  USBD_CtrlClose (CPU_INT08U   dev_nbr,
-                      USBD_ERR    *p_err)
+CPU_INT32U  USBD_CtrlRx (CPU_INT08U    dev_nbr,
+                         void         *p_buf,
+                         CPU_INT32U    buf_len,
+                         CPU_INT16U    timeout_ms,
+                         USBD_ERR     *p_err)
 {
-    USBD_DRV  *p_drv;
-    USBD_ERR   err_in;
-    USBD_ERR   err_out;
+    USBD_DRV        *p_drv;
+    USBD_EP         *p_ep;
+    CPU_INT08U       ep_phy_nbr;
+    USBD_DEV_STATE   state;
+    CPU_INT32U       xfer_len;
+
+
+    USBD_DBG_STATS_DEV_INC(dev_nbr, CtrlRxSyncExecNbr);
 
+#if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)                /* ---------------- VALIDATE ARGUMENTS ---------------- */
+    if (p_err == (USBD_ERR *)0) {                               /* Validate error ptr.                                  */
+        CPU_SW_EXCEPTION(0);
+    }
+#endif
 
     p_drv = USBD_DrvRefGet(dev_nbr);                            /* Get dev struct.                                      */
     if (p_drv == (USBD_DRV *)0) {
        *p_err = USBD_ERR_DEV_INVALID_NBR;
-        return;
+        return (0u);
     }
 
-    USBD_EP_Close(p_drv, USBD_EP_ADDR_CTRL_IN,  &err_in);
-    USBD_EP_Close(p_drv, USBD_EP_ADDR_CTRL_OUT, &err_out);
-
-    if (err_in != USBD_ERR_NONE) {
-       *p_err = err_in;
-    } else {
-       *p_err = err_out;
+    state = USBD_DevStateGet(dev_nbr, p_err);
+    if ((state != USBD_DEV_STATE_DEFAULT)   &&
+        (state != USBD_DEV_STATE_ADDRESSED) &&
+        (state != USBD_DEV_STATE_CONFIGURED)) {
+       *p_err = USBD_ERR_DEV_INVALID_STATE;
+        return (0u);
+    }
+
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(USBD_EP_ADDR_CTRL_OUT);
+    p_ep       = USBD_EP_TblPtrs[dev_nbr][ep_phy_nbr];
+
+    if (p_ep == (USBD_EP *)0) {
+       *p_err = USBD_ERR_EP_INVALID_ADDR;
+        return (0u);
+    }
+
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return (0u);
+    }
+
+    if (p_ep->State != USBD_EP_STATE_OPEN) {
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
+       *p_err = USBD_ERR_EP_INVALID_STATE;
+        return (0u);
+    }
+                                                                /* Chk EP attrib.                                       */
+    if ((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_CTRL) {
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
+       *p_err = USBD_ERR_EP_INVALID_TYPE;
+        return (0u);
     }
+
+    xfer_len = USBD_EP_Rx(                 p_drv,
+                                           p_ep,
+                                           p_buf,
+                                           buf_len,
+                          (USBD_ASYNC_FNCT)0,
+                          (void          *)0,
+                                           timeout_ms,
+                                           p_err);
+
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
+
+    USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, CtrlRxSyncSuccessNbr, (*p_err == USBD_ERR_NONE));
+
+    return (xfer_len);
 }
 
 
 /*
 *********************************************************************************************************
-*                                          USBD_CtrlStall()
+*                                            USBD_CtrlTx()
 *
-* Description : Stall control endpoint.
+* Description : Send data on Control IN endpoint.
 *
 * Argument(s) : dev_nbr     Device number.
 *
+*               p_buf       Pointer to buffer of data that will be sent.
+*
+*               buf_len     Number of octets to transmit.
+*
+*               timeout_ms  Timeout in milliseconds.
+*
+*               end         End-of-transfer flag (see Note #1).
+*
 *               p_err       Pointer to variable that will receive return error code from this function :
 *
-*                               USBD_ERR_NONE               Control endpoint successfully stalled.
+*                               USBD_ERR_NONE               Data successfully transmitted.
 *                               USBD_ERR_DEV_INVALID_NBR    Invalid device number.
+*                               USBD_ERR_DEV_INVALID_STATE  Transfer type only available if device is in
+*                                                           configured state.
+*                               USBD_ERR_INVALID_ARG        Invalid argument(s): 'buf_len'.
 *                               USBD_ERR_EP_INVALID_ADDR    Invalid endpoint address.
 *                               USBD_ERR_EP_INVALID_STATE   Invalid endpoint state.
-*                               USBD_ERR_EP_STALL           Device driver stall endpoint failed.
+*                               USBD_ERR_EP_INVALID_TYPE    Invalid endpoint type.
 *
 *                               - RETURNED BY USBD_OS_EP_LockAcquire() -
 *                               See USBD_OS_EP_LockAcquire() for additional return error codes.
 *
-* Return(s)   : none.
+*                               - RETURNED BY USBD_EP_Tx() -
+*                               See USBD_EP_Tx() for additional return error codes.
 *
-* Note(s)     : None.
+* Return(s)   : Number of octets transmitted, if NO error(s).
+*
+*               0,                            otherwise.
+*
+* Note(s)     : (1) If end-of-transfer is set and transfer length is multiple of maximum packet size,
+*                   a zero-length packet is transferred to indicate a short transfer to the host.
 *********************************************************************************************************
 */
 
-void  USBD_CtrlStall (CPU_INT08U   dev_nbr,
-                      USBD_ERR    *p_err)
+CPU_INT32U  USBD_CtrlTx (CPU_INT08U    dev_nbr,
+                         void         *p_buf,
+                         CPU_INT32U    buf_len,
+                         CPU_INT16U    timeout_ms,
+                         CPU_BOOLEAN   end,
+                         USBD_ERR     *p_err)
 {
-    USBD_EP       *p_ep_out;
-    USBD_EP       *p_ep_in;
-    USBD_DRV      *p_drv;
-    USBD_DRV_API  *p_drv_api;
-    CPU_INT08U     ep_phy_nbr;
-    CPU_BOOLEAN    stall_in;
-    CPU_BOOLEAN    stall_out;
+    USBD_DRV        *p_drv;
+    USBD_EP         *p_ep;
+    CPU_INT08U       ep_phy_nbr;
+    USBD_DEV_STATE   state;
+    CPU_INT32U       xfer_len;
+
+
+    USBD_DBG_STATS_DEV_INC(dev_nbr, CtrlTxSyncExecNbr);
 
+#if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)                /* ---------------- VALIDATE ARGUMENTS ---------------- */
+    if (p_err == (USBD_ERR *)0) {                               /* Validate error ptr.                                  */
+        CPU_SW_EXCEPTION(0);
+    }
+#endif
 
     p_drv = USBD_DrvRefGet(dev_nbr);                            /* Get dev struct.                                      */
     if (p_drv == (USBD_DRV *)0) {
        *p_err = USBD_ERR_DEV_INVALID_NBR;
-        return;
+        return (0u);
+    }
+
+    state = USBD_DevStateGet(dev_nbr, p_err);
+    if ((state != USBD_DEV_STATE_DEFAULT)   &&
+        (state != USBD_DEV_STATE_ADDRESSED) &&
+        (state != USBD_DEV_STATE_CONFIGURED)) {
+       *p_err = USBD_ERR_DEV_INVALID_STATE;
+        return (0u);
+    }
+
+    if (buf_len == 0u) {
+       *p_err = USBD_ERR_INVALID_ARG;
+        return (0u);
     }
 
-    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(USBD_EP_ADDR_CTRL_OUT);
-    p_ep_out   = USBD_EP_TblPtrs[dev_nbr][ep_phy_nbr];
     ep_phy_nbr = USBD_EP_ADDR_TO_PHY(USBD_EP_ADDR_CTRL_IN);
-    p_ep_in    = USBD_EP_TblPtrs[dev_nbr][ep_phy_nbr];
+    p_ep       = USBD_EP_TblPtrs[dev_nbr][ep_phy_nbr];
 
-    if ((p_ep_out == (USBD_EP *)0) ||
-        (p_ep_in  == (USBD_EP *)0)) {
+    if (p_ep == (USBD_EP *)0) {
        *p_err = USBD_ERR_EP_INVALID_ADDR;
-        return;
+        return (0u);
     }
 
-    USBD_OS_EP_LockAcquire(p_drv->DevNbr,
-                           p_ep_out->Ix,
-                           0u,
-                           p_err);
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
     if (*p_err != USBD_ERR_NONE) {
-        return;
+        return (0u);
     }
 
-    USBD_OS_EP_LockAcquire(p_drv->DevNbr,
-                           p_ep_in->Ix,
-                           0u,
-                           p_err);
-    if (*p_err != USBD_ERR_NONE) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep_out->Ix);
-        return;
+    if (p_ep->State != USBD_EP_STATE_OPEN) {
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
+       *p_err = USBD_ERR_EP_INVALID_STATE;
+        return (0u);
+    }
+                                                                /* Chk EP attrib.                                       */
+    if ((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_CTRL) {
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
+       *p_err = USBD_ERR_EP_INVALID_TYPE;
+        return (0u);
     }
 
-    if ((p_ep_out->State == USBD_EP_STATE_OPEN) &&
-        (p_ep_in->State  == USBD_EP_STATE_OPEN)) {
+    xfer_len = USBD_EP_Tx(                 p_drv,
+                                           p_ep,
+                                           p_buf,
+                                           buf_len,
+                          (USBD_ASYNC_FNCT)0,
+                          (void          *)0,
+                                           timeout_ms,
+                                           end,
+                                           p_err);
 
-        p_drv_api = p_drv->API_Ptr;                             /* Get dev drv API struct.                              */
-        stall_in = p_drv_api->EP_Stall(p_drv,
-                                       USBD_EP_ADDR_CTRL_IN,
-                                       DEF_SET);
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
 
-        stall_out = p_drv_api->EP_Stall(p_drv,
-                                        USBD_EP_ADDR_CTRL_OUT,
-                                        DEF_SET);
+    USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, CtrlTxSyncSuccessNbr, (*p_err == USBD_ERR_NONE));
 
-        if ((stall_in  == DEF_FAIL) ||
-            (stall_out == DEF_FAIL)) {
-           *p_err = USBD_ERR_EP_STALL;
-        } else {
-           *p_err = USBD_ERR_NONE;
-        }
+    return (xfer_len);
+}
 
-    } else {
-       *p_err = USBD_ERR_EP_INVALID_STATE;
+
+/*
+*********************************************************************************************************
+*                                         USBD_CtrlRxStatus()
+*
+* Description : Handle status stage from host on control (EP0) OUT endpoint.
+*
+* Argument(s) : dev_nbr     Device number.
+*
+*               timeout_ms  Timeout in milliseconds.
+*
+*               p_err       Pointer to variable that will receive return error code from this function :
+*
+*                               USBD_ERR_NONE               Status stage successfully completed.
+*                               USBD_ERR_DEV_INVALID_STATE  Transfer type only available if device is in
+*                                                           default/addressed/configured state.
+*
+*                               - RETURNED BY USBD_DevStateGet() -
+*                               See USBD_DevStateGet() for additional return error codes.
+*
+*                               - RETURNED BY USBD_EP_RxZLP() -
+*                               See USBD_EP_RxZLP() for additional return error codes.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_CtrlRxStatus (CPU_INT08U   dev_nbr,
+                         CPU_INT16U   timeout_ms,
+                         USBD_ERR    *p_err)
+{
+    USBD_DEV_STATE  state;
+
+
+    USBD_DBG_STATS_DEV_INC(dev_nbr, CtrlRxStatusExecNbr);
+
+    state = USBD_DevStateGet(dev_nbr, p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    if ((state != USBD_DEV_STATE_DEFAULT)   &&
+        (state != USBD_DEV_STATE_ADDRESSED) &&
+        (state != USBD_DEV_STATE_CONFIGURED)) {
+       *p_err  = USBD_ERR_DEV_INVALID_STATE;
+        return;
     }
 
-    USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                           p_ep_in->Ix);
+    USBD_EP_RxZLP(dev_nbr,
+                  USBD_EP_ADDR_CTRL_OUT,
+                  timeout_ms,
+                  p_err);
 
-    USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                           p_ep_out->Ix);
+    USBD_DBG_STATS_DEV_INC_IF_TRUE(dev_nbr, CtrlRxStatusSuccessNbr, (*p_err == USBD_ERR_NONE));
 }
 
 
 /*
 *********************************************************************************************************
 *********************************************************************************************************
-*                                     GENERAL ENDPOINT FUNCTIONS
+*                                     CONTROL ENDPOINT FUNCTIONS
 *********************************************************************************************************
 *********************************************************************************************************
 */
 
 /*
 *********************************************************************************************************
-*                                           USBD_EP_Init()
+*                                           USBD_CtrlOpen()
 *
-* Description : Initialize endpoint structures.
+* Description : Open control endpoints.
 *
-* Argument(s) : none.
+* Argument(s) : dev_nbr         Device number.
+*
+*               max_pkt_size    Maximum packet size.
+*
+*               p_err           Pointer to variable that will receive return error code from this function :
+*
+*                                   USBD_ERR_NONE               Control endpoint successfully opened.
+*                                   USBD_ERR_DEV_INVALID_NBR    Invalid device number.
+*
+*                                   - RETURNED BY USBD_EP_Open() -
+*                                   See USBD_EP_Open() for additional return error codes.
 *
 * Return(s)   : none.
 *
@@ -2231,36 +2831,265 @@ void  USBD_CtrlStall (CPU_INT08U   dev_nbr,
 *********************************************************************************************************
 */
 
-void  USBD_EP_Init (void)
+void  USBD_CtrlOpen (CPU_INT08U   dev_nbr,
+                     CPU_INT16U   max_pkt_size,
+                     USBD_ERR    *p_err)
 {
-    USBD_EP     *p_ep;
-    USBD_URB    *p_urb;
-    CPU_INT08U   ep_ix;
-    CPU_INT08U   dev_nbr;
-    CPU_INT16U   urb_ix;
+    USBD_DRV  *p_drv;
+    USBD_ERR   local_err;
 
 
-    for (dev_nbr = 0u; dev_nbr < USBD_CFG_MAX_NBR_DEV; dev_nbr++) {
-        for (ep_ix = 0u; ep_ix < USBD_EP_MAX_NBR; ep_ix++) {
-            if (ep_ix < USBD_CFG_MAX_NBR_EP_OPEN) {
-                p_ep                = &USBD_EP_Tbl[dev_nbr][ep_ix];
-                p_ep->Addr          =  USBD_EP_ADDR_NONE;
+    p_drv = USBD_DrvRefGet(dev_nbr);                            /* Get dev struct.                                      */
+    if (p_drv == (USBD_DRV *)0) {
+       *p_err = USBD_ERR_DEV_INVALID_NBR;
+        return;
+    }
+
+    USBD_EP_Open(p_drv,
+                 USBD_EP_ADDR_CTRL_IN,
+                 max_pkt_size,
+                 USBD_EP_TYPE_CTRL,
+                 0u,
+                 p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    USBD_EP_Open(p_drv,
+                 USBD_EP_ADDR_CTRL_OUT,
+                 max_pkt_size,
+                 USBD_EP_TYPE_CTRL,
+                 0u,
+                 p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        USBD_EP_Close(p_drv, USBD_EP_ADDR_CTRL_IN,  &local_err);
+        return;
+    }
+
+   *p_err = USBD_ERR_NONE;
+}
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_CtrlClose()
+*
+* Description : Close control endpoint.
+*
+* Argument(s) : dev_nbr     Device number.
+*
+*               p_err       Pointer to variable that will receive return error code from this function :
+*
+*                               USBD_ERR_NONE               Control endpoint successfully closed.
+*                               USBD_ERR_DEV_INVALID_NBR    Invalid device number.
+*
+*                               - RETURNED BY USBD_EP_Close() -
+*                               See USBD_EP_Close() for additional return error codes.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_CtrlClose (CPU_INT08U   dev_nbr,
+                      USBD_ERR    *p_err)
+{
+    USBD_DRV  *p_drv;
+    USBD_ERR   err_in;
+    USBD_ERR   err_out;
+
+
+    p_drv = USBD_DrvRefGet(dev_nbr);                            /* Get dev struct.                                      */
+    if (p_drv == (USBD_DRV *)0) {
+       *p_err = USBD_ERR_DEV_INVALID_NBR;
+        return;
+    }
+
+    USBD_EP_Close(p_drv, USBD_EP_ADDR_CTRL_IN,  &err_in);
+    USBD_EP_Close(p_drv, USBD_EP_ADDR_CTRL_OUT, &err_out);
+
+    if (err_in != USBD_ERR_NONE) {
+       *p_err = err_in;
+    } else {
+       *p_err = err_out;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_CtrlStall()
+*
+* Description : Stall control endpoint.
+*
+* Argument(s) : dev_nbr     Device number.
+*
+*               p_err       Pointer to variable that will receive return error code from this function :
+*
+*                               USBD_ERR_NONE               Control endpoint successfully stalled.
+*                               USBD_ERR_DEV_INVALID_NBR    Invalid device number.
+*                               USBD_ERR_EP_INVALID_ADDR    Invalid endpoint address.
+*                               USBD_ERR_EP_INVALID_STATE   Invalid endpoint state.
+*                               USBD_ERR_EP_STALL           Device driver stall endpoint failed.
+*
+*                               - RETURNED BY USBD_OS_EP_LockAcquire() -
+*                               See USBD_OS_EP_LockAcquire() for additional return error codes.
+*
+* Return(s)   : none.
+*
+* Note(s)     : None.
+*********************************************************************************************************
+*/
+
+void  USBD_CtrlStall (CPU_INT08U   dev_nbr,
+                      USBD_ERR    *p_err)
+{
+    USBD_EP       *p_ep_out;
+    USBD_EP       *p_ep_in;
+    USBD_DRV      *p_drv;
+    USBD_DRV_API  *p_drv_api;
+    CPU_INT08U     ep_phy_nbr;
+    CPU_BOOLEAN    stall_in;
+    CPU_BOOLEAN    stall_out;
+
+
+    p_drv = USBD_DrvRefGet(dev_nbr);                            /* Get dev struct.                                      */
+    if (p_drv == (USBD_DRV *)0) {
+       *p_err = USBD_ERR_DEV_INVALID_NBR;
+        return;
+    }
+
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(USBD_EP_ADDR_CTRL_OUT);
+    p_ep_out   = USBD_EP_TblPtrs[dev_nbr][ep_phy_nbr];
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(USBD_EP_ADDR_CTRL_IN);
+    p_ep_in    = USBD_EP_TblPtrs[dev_nbr][ep_phy_nbr];
+
+    if ((p_ep_out == (USBD_EP *)0) ||
+        (p_ep_in  == (USBD_EP *)0)) {
+       *p_err = USBD_ERR_EP_INVALID_ADDR;
+        return;
+    }
+
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep_out->Ix,
+                        0u,
+                        p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep_in->Ix,
+                        0u,
+                        p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep_out->Ix);
+        return;
+    }
+
+    if ((p_ep_out->State == USBD_EP_STATE_OPEN) &&
+        (p_ep_in->State  == USBD_EP_STATE_OPEN)) {
+
+        p_drv_api = p_drv->API_Ptr;                             /* Get dev drv API struct.                              */
+        stall_in = p_drv_api->EP_Stall(p_drv,
+                                       USBD_EP_ADDR_CTRL_IN,
+                                       DEF_SET);
+
+        stall_out = p_drv_api->EP_Stall(p_drv,
+                                        USBD_EP_ADDR_CTRL_OUT,
+                                        DEF_SET);
+
+        if ((stall_in  == DEF_FAIL) ||
+            (stall_out == DEF_FAIL)) {
+           *p_err = USBD_ERR_EP_STALL;
+        } else {
+           *p_err = USBD_ERR_NONE;
+        }
+
+    } else {
+       *p_err = USBD_ERR_EP_INVALID_STATE;
+    }
+
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep_in->Ix);
+
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep_out->Ix);
+}
+
+
+/*
+*********************************************************************************************************
+*********************************************************************************************************
+*                                     GENERAL ENDPOINT FUNCTIONS
+*********************************************************************************************************
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                           USBD_EP_Init()
+*
+* Description : Initialize endpoint structures.
+*
+* Argument(s) : none.
+*
+* Return(s)   : none.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+void  USBD_EP_Init (void)
+{
+    USBD_EP     *p_ep;
+    USBD_URB    *p_urb;
+    CPU_INT08U   ep_ix;
+    CPU_INT08U   dev_nbr;
+    CPU_INT16U   urb_ix;
+
+
+    for (dev_nbr = 0u; dev_nbr < USBD_CFG_MAX_NBR_DEV; dev_nbr++) {
+        for (ep_ix = 0u; ep_ix < USBD_EP_MAX_NBR; ep_ix++) {
+            if (ep_ix < USBD_CFG_MAX_NBR_EP_OPEN) {
+                p_ep                = &USBD_EP_Tbl[dev_nbr][ep_ix];
+                p_ep->Addr          =  USBD_EP_ADDR_NONE;
                 p_ep->Attrib        =  DEF_BIT_NONE;
                 p_ep->MaxPktSize    =  0u;
                 p_ep->Interval      =  0u;
                 p_ep->Ix            =  0u;
-#if (USBD_CFG_MAX_NBR_URB_EXTRA > 0u)
                 p_ep->URB_MainAvail =  DEF_YES;
+#if (USBD_CFG_MAX_NBR_URB_EXTRA > 0u)
+                p_ep->URB_ExtraCnt  =  0u;
+                p_ep->URB_ExtraRsvd =  0u;
+                p_ep->URB_ExtraMax  =  USBD_CFG_MAX_NBR_URB_EXTRA;
 #endif
                 p_ep->URB_HeadPtr   = (USBD_URB *)0;
                 p_ep->URB_TailPtr   = (USBD_URB *)0;
+#if (USBD_CFG_EP_PRE_QUEUE_EN == DEF_ENABLED)
+                p_ep->URB_PendPtr   = (USBD_URB *)0;
+                p_ep->URB_SubmitCnt =  0u;
+                p_ep->URB_SubmitMax =  1u;
+#endif
+#if (USBD_CFG_EP_DIRECT_CMPL_EN == DEF_ENABLED)
+                p_ep->DirectCmplEn       = DEF_DISABLED;
+                p_ep->DirectCmplActive   = DEF_NO;
+                p_ep->LockHeld           = DEF_NO;
+                p_ep->DirectCmplDeferCnt = 0u;
+#endif
 
                 USBD_DBG_STATS_EP_RESET(dev_nbr, ep_ix);
             }
             USBD_EP_TblPtrs[dev_nbr][ep_ix] = (USBD_EP *)0;
         }
 
-        USBD_URB_TblPtr[dev_nbr] = &USBD_URB_Tbl[dev_nbr][0];
+#if (USBD_CFG_EP_VEC_XFER_EN == DEF_ENABLED)
+        for (ep_ix = 0u; ep_ix < USBD_CFG_MAX_NBR_EP_OPEN; ep_ix++) {
+            USBD_EP_VecBufTbl[dev_nbr][ep_ix] = (CPU_INT08U *)0;
+        }
+#endif
 
         for (urb_ix = 0u; urb_ix < USBD_URB_MAX_NBR; urb_ix++) {
             p_urb               = &USBD_URB_Tbl[dev_nbr][urb_ix];
@@ -2273,7 +3102,9 @@ void  USBD_EP_Init (void)
             p_urb->AsyncFnct    = (USBD_ASYNC_FNCT)0;
             p_urb->AsyncFnctArg = (void          *)0;
             p_urb->Err          =  USBD_ERR_NONE;
-            if (urb_ix < (USBD_URB_MAX_NBR - 1)) {
+                                                                /* Only extra URBs are linked in free list.             */
+            if ((urb_ix >= USBD_URB_EXTRA_IX_START) &&
+                (urb_ix <  (USBD_URB_MAX_NBR - 1))) {
                 p_urb->NextPtr  = &USBD_URB_Tbl[dev_nbr][urb_ix + 1];
             } else {
                 p_urb->NextPtr  = (USBD_URB      *)0;
@@ -2283,9 +3114,25 @@ void  USBD_EP_Init (void)
         USBD_EP_OpenCtr[dev_nbr]    = 0u;
         USBD_EP_OpenBitMap[dev_nbr] = DEF_INT_32_MASK;
 #if (USBD_CFG_MAX_NBR_URB_EXTRA > 0u)
-        USBD_URB_ExtraCtr[dev_nbr]  = 0u;
+        USBD_URB_TblPtr[dev_nbr]         = &USBD_URB_Tbl[dev_nbr][USBD_URB_EXTRA_IX_START];
+        USBD_URB_ExtraCtr[dev_nbr]       =  0u;
+        USBD_URB_ExtraRsvdTot[dev_nbr]   =  0u;
+        USBD_URB_ExtraRsvdAvail[dev_nbr] =  0u;
 #endif
     }
+
+#if (USBD_CFG_CAPTURE_EN == DEF_ENABLED)
+    Mem_Clr((void     *)&USBD_Capture,                          /* Init capture ring.                                   */
+            (CPU_SIZE_T) sizeof(USBD_Capture));
+    USBD_Capture.En = DEF_ENABLED;
+#endif
+
+    USBD_DBG_STATS_POOL_REG(&USBD_DbgStatsPoolEP,
+                            "Open EP",
+                            USBD_CFG_MAX_NBR_DEV * USBD_CFG_MAX_NBR_EP_OPEN);
+    USBD_DBG_STATS_POOL_REG(&USBD_DbgStatsPoolURB_Extra,
+                            "Extra URB",
+                            USBD_CFG_MAX_NBR_DEV * USBD_CFG_MAX_NBR_URB_EXTRA);
 }
 
 
@@ -2293,7 +3140,7 @@ void  USBD_EP_Init (void)
 *********************************************************************************************************
 *                                      USBD_EP_XferAsyncProcess()
 *
-* Description : Read/write data asynchronously from/to non-control endpoints.
+* Description : Process an asynchronous transfer completion event queued to the core task.
 *
 * Argument(s) : p_drv       Pointer to device driver structure.
 *               ----        Argument checked by caller.
@@ -2304,16 +3151,9 @@ void  USBD_EP_Init (void)
 *
 * Return(s)   : none.
 *
-* Note(s)     : (1) A USB device driver can notify the core about the Tx transfer completion using
-*                   USBD_EP_TxCmpl() or USBD_EP_TxCmplExt(). The latter function allows to report a
-*                   specific error code whereas USBD_EP_TxCmpl() reports only a successful transfer.
-*                   In the case of an asynchronous transfer, the error code reported by the USB device
-*                   driver must be tested. In case of an error condition, the asynchronous transfer
-*                   is marked as completed and the associated callback is called by the core task.
-*
-*               (2) This condition covers also the case where the transfer length is multiple of the
-*                   maximum packet size. In that case, host sends a zero-length packet considered as
-*                   a short packet for the condition.
+* Note(s)     : (1) Once the completion is processed and its callback executed, the driver's ISR can
+*                   process the following completions of the endpoint directly, if enabled (see
+*                   'ENDPOINT DATA TYPE Note #1c').
 *********************************************************************************************************
 */
 
@@ -2321,16 +3161,11 @@ void  USBD_EP_XferAsyncProcess (USBD_DRV    *p_drv,
                                 CPU_INT08U   ep_addr,
                                 USBD_ERR     xfer_err)
 {
-    CPU_INT08U     ep_phy_nbr;
-    USBD_EP       *p_ep;
-    USBD_DRV_API  *p_drv_api;
-    CPU_BOOLEAN    ep_dir_in;
-    USBD_ERR       local_err;
-    USBD_URB      *p_urb;
-    USBD_URB      *p_urb_cmpl;
-    CPU_INT08U    *p_buf_cur;
-    CPU_INT32U     xfer_len;
-    CPU_INT32U     xfer_rem;
+    CPU_INT08U   ep_phy_nbr;
+    USBD_EP     *p_ep;
+#if (USBD_CFG_EP_DIRECT_CMPL_EN == DEF_ENABLED)
+    CPU_SR_ALLOC();
+#endif
 
 
     ep_phy_nbr = USBD_EP_ADDR_TO_PHY(ep_addr);
@@ -2339,119 +3174,16 @@ void  USBD_EP_XferAsyncProcess (USBD_DRV    *p_drv,
         return;
     }
 
-    p_drv_api = p_drv->API_Ptr;
-    ep_dir_in = USBD_EP_IS_IN(p_ep->Addr);
-
-    USBD_OS_EP_LockAcquire(p_drv->DevNbr,
-                           p_ep->Ix,
-                           0u,
-                          &local_err);
-    if (local_err != USBD_ERR_NONE) {
-        return;
-    }
-
-    if (p_ep->XferState == USBD_XFER_STATE_NONE) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
-        return;
-    }
+    USBD_EP_XferAsyncCmpl(p_drv, p_ep, xfer_err);
 
-    p_urb = p_ep->URB_HeadPtr;
-    if (p_urb == (USBD_URB *)0) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
-        USBD_DBG_EP("USBD_EP_Process(): no URB to process", ep_addr);
-        return;
+#if (USBD_CFG_EP_DIRECT_CMPL_EN == DEF_ENABLED)
+    CPU_CRITICAL_ENTER();                                       /* See Note #1.                                         */
+    if (p_ep->DirectCmplDeferCnt > 0u) {
+        p_ep->DirectCmplDeferCnt--;
     }
-
-    if ((p_urb->State == USBD_URB_STATE_IDLE) ||
-        (p_urb->State == USBD_URB_STATE_XFER_SYNC)) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
-        USBD_DBG_EP("USBD_EP_Process(): incorrect URB state", ep_addr);
-        return;
-    }
-
-    p_urb_cmpl = (USBD_URB *)0;
-    if (xfer_err == USBD_ERR_NONE) {                            /* See Note #1.                                         */
-        xfer_rem   =  p_urb->BufLen - p_urb->XferLen;
-        p_buf_cur  = &p_urb->BufPtr[p_urb->XferLen];
-
-        if (ep_dir_in == DEF_YES) {                             /* ------------------- IN TRANSFER -------------------- */
-            if (xfer_rem > 0u) {                                /* Another transaction must be done.                    */
-                USBD_EP_TxAsyncProcess(p_drv,
-                                       p_ep,
-                                       p_urb,
-                                       p_buf_cur,
-                                       xfer_rem,
-                                      &local_err);
-                if (local_err != USBD_ERR_NONE) {
-                    p_urb_cmpl = USBD_URB_AsyncCmpl(p_ep, local_err);
-                }
-            } else if ((DEF_BIT_IS_SET(p_urb->Flags, USBD_URB_FLAG_XFER_END) == DEF_YES) &&
-                       (p_urb->XferLen % p_ep->MaxPktSize                    == 0u)      &&
-                       (p_urb->XferLen                                       != 0u)) {
-                                                                /* $$$$ This case should be tested more thoroughly.     */
-                                                                /* Send ZLP if needed, at end of xfer.                  */
-                DEF_BIT_CLR(p_urb->Flags, USBD_URB_FLAG_XFER_END);
-
-                USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, DrvTxZLP_Nbr);
-
-                p_drv_api->EP_TxZLP(p_drv, p_ep->Addr, &local_err);
-                if (local_err != USBD_ERR_NONE) {
-                    p_urb_cmpl = USBD_URB_AsyncCmpl(p_ep, local_err);
-                }
-                USBD_DBG_STATS_EP_INC_IF_TRUE(p_drv->DevNbr, p_ep->Ix, DrvTxZLP_Nbr, (local_err == USBD_ERR_NONE));
-            } else {                                            /* Xfer is completed.                                   */
-                p_urb_cmpl = USBD_URB_AsyncCmpl(p_ep, USBD_ERR_NONE);
-            }
-        } else {                                                /* ------------------- OUT TRANSFER ------------------- */
-            USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, DrvRxNbr);
-
-            xfer_len = p_drv_api->EP_Rx(p_drv,
-                                        p_ep->Addr,
-                                        p_buf_cur,
-                                        p_urb->NextXferLen,
-                                       &local_err);
-            if (local_err != USBD_ERR_NONE) {
-                p_urb_cmpl = USBD_URB_AsyncCmpl(p_ep, local_err);
-            } else {
-                USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, DrvRxSuccessNbr);
-
-                p_urb->XferLen += xfer_len;
-
-                if ((xfer_len       == 0u)                 ||   /* Rx'd a ZLP.                                          */
-                    (xfer_len       <  p_urb->NextXferLen) ||   /* Rx'd a short pkt (see Note #2).                      */
-                    (p_urb->XferLen == p_urb->BufLen)) {        /* All bytes rx'd.                                      */
-                                                                /* Xfer finished.                                       */
-                    p_urb_cmpl = USBD_URB_AsyncCmpl(p_ep, USBD_ERR_NONE);
-                } else {
-                    p_buf_cur = &p_urb->BufPtr[p_urb->XferLen]; /* Xfer not finished.                                   */
-                    xfer_len  =  p_urb->BufLen - p_urb->XferLen;
-
-                    USBD_EP_RxStartAsyncProcess(p_drv,
-                                                p_ep,
-                                                p_urb,
-                                                p_buf_cur,
-                                                xfer_len,
-                                               &local_err);
-                    if (local_err != USBD_ERR_NONE) {
-                        p_urb_cmpl = USBD_URB_AsyncCmpl(p_ep, local_err);
-                    }
-                }
-            }
-        }
-    } else {
-        p_urb_cmpl = USBD_URB_AsyncCmpl(p_ep, xfer_err);
-    }
-
-    USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                           p_ep->Ix);
-
-    if (p_urb_cmpl != (USBD_URB *)0) {
-        USBD_URB_AsyncEnd(p_drv->DevNbr, p_ep, p_urb_cmpl);     /* Execute callback and free aborted URB(s), if any.    */
-    }
-}
+    CPU_CRITICAL_EXIT();
+#endif
+}
 
 
 /*
@@ -2506,6 +3238,9 @@ void  USBD_EP_Open (USBD_DRV    *p_drv,
     CPU_INT08U     ep_phy_nbr;
     CPU_INT08U     dev_nbr;
     CPU_INT08U     transaction_frame;
+#if (USBD_CFG_EP_PRE_QUEUE_EN == DEF_ENABLED)
+    CPU_INT08U     urb_submit_max;
+#endif
     CPU_SR_ALLOC();
 
 
@@ -2528,6 +3263,7 @@ void  USBD_EP_Open (USBD_DRV    *p_drv,
     CPU_CRITICAL_ENTER();
     if (USBD_EP_OpenCtr[dev_nbr] == USBD_CFG_MAX_NBR_EP_OPEN) {
         CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_POOL_FAIL(&USBD_DbgStatsPoolEP);
        *p_err = USBD_ERR_EP_NONE_AVAIL;
         return;
     }
@@ -2537,6 +3273,8 @@ void  USBD_EP_Open (USBD_DRV    *p_drv,
     USBD_EP_OpenCtr[dev_nbr]++;
     CPU_CRITICAL_EXIT();
 
+    USBD_DBG_STATS_POOL_ALLOC(&USBD_DbgStatsPoolEP);
+
     ep_ix = USBD_EP_MAX_NBR - 1u - ep_bit;
 
     USBD_OS_EP_SignalCreate(p_drv->DevNbr, ep_ix, p_err);
@@ -2563,6 +3301,16 @@ void  USBD_EP_Open (USBD_DRV    *p_drv,
         goto end_lock_signal_clean;
     }
 
+#if (USBD_CFG_EP_PRE_QUEUE_EN == DEF_ENABLED)
+    urb_submit_max = 1u;                                        /* Drv w/o xfer Q is given one URB at a time.           */
+    if (p_drv_api->EP_QueueDepthGet != (void *)0) {
+        urb_submit_max = p_drv_api->EP_QueueDepthGet(p_drv, ep_addr);
+        if (urb_submit_max == 0u) {
+            urb_submit_max = 1u;
+        }
+    }
+#endif
+
     p_ep = &USBD_EP_Tbl[dev_nbr][ep_ix];
 
     CPU_CRITICAL_ENTER();
@@ -2573,6 +3321,17 @@ void  USBD_EP_Open (USBD_DRV    *p_drv,
     p_ep->State      = USBD_EP_STATE_OPEN;
     p_ep->XferState  = USBD_XFER_STATE_NONE;
     p_ep->Ix         = ep_ix;
+#if (USBD_CFG_EP_PRE_QUEUE_EN == DEF_ENABLED)
+    p_ep->URB_PendPtr   = (USBD_URB *)0;
+    p_ep->URB_SubmitCnt =  0u;
+    p_ep->URB_SubmitMax =  urb_submit_max;
+#endif
+#if (USBD_CFG_EP_DIRECT_CMPL_EN == DEF_ENABLED)
+    p_ep->DirectCmplEn       = DEF_DISABLED;                    /* Direct cmpl must be re-enabled after each open.      */
+    p_ep->DirectCmplActive   = DEF_NO;
+    p_ep->LockHeld           = DEF_NO;
+    p_ep->DirectCmplDeferCnt = 0u;
+#endif
 
     USBD_EP_TblPtrs[dev_nbr][ep_phy_nbr] = p_ep;
     CPU_CRITICAL_EXIT();
@@ -2603,6 +3362,8 @@ end_clean:
     USBD_EP_OpenCtr[dev_nbr] -= 1u;
     CPU_CRITICAL_EXIT();
 
+    USBD_DBG_STATS_POOL_FREE(&USBD_DbgStatsPoolEP);
+
     USBD_DBG_EP_ERR("EP Open", ep_addr, *p_err);
 
     return;
@@ -2760,10 +3521,10 @@ void  USBD_EP_Abort (CPU_INT08U   dev_nbr,
         return;
     }
 
-    USBD_OS_EP_LockAcquire(p_drv->DevNbr,
-                           p_ep->Ix,
-                           0u,
-                           p_err);
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
     if (*p_err != USBD_ERR_NONE) {
         return;
     }
@@ -2772,8 +3533,8 @@ void  USBD_EP_Abort (CPU_INT08U   dev_nbr,
 
     if ((p_ep->State != USBD_EP_STATE_OPEN) &&
         (p_ep->State != USBD_EP_STATE_STALL)) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_EP_INVALID_STATE;
         return;
     }
@@ -2784,8 +3545,8 @@ void  USBD_EP_Abort (CPU_INT08U   dev_nbr,
 
     USBD_DBG_STATS_EP_INC_IF_TRUE(dev_nbr, p_ep->Ix, EP_AbortSuccessNbr, (*p_err == USBD_ERR_NONE));
 
-    USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                           p_ep->Ix);
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
 
     if (p_urb_head_aborted != (USBD_URB *)0) {
         USBD_URB_AsyncEnd(dev_nbr, p_ep, p_urb_head_aborted);   /* Execute callback and free aborted URB(s), if any.    */
@@ -2849,17 +3610,17 @@ void  USBD_EP_Close (USBD_DRV    *p_drv,
         return;
     }
 
-    USBD_OS_EP_LockAcquire(p_drv->DevNbr,
-                           p_ep->Ix,
-                           0u,
-                           p_err);
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
     if (*p_err != USBD_ERR_NONE) {
         return;
     }
 
     if (p_ep->State == USBD_EP_STATE_CLOSE) {
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
        *p_err = USBD_ERR_NONE;
         return;
     }
@@ -2877,8 +3638,19 @@ void  USBD_EP_Close (USBD_DRV    *p_drv,
     CPU_CRITICAL_ENTER();
     DEF_BIT_SET(USBD_EP_OpenBitMap[dev_nbr], DEF_BIT32(ep_bit));
     USBD_EP_OpenCtr[dev_nbr]--;
+#if (USBD_CFG_MAX_NBR_URB_EXTRA > 0u)
+                                                                /* Release extra URB rsvd by EP not currently used.     */
+    if (p_ep->URB_ExtraCnt < p_ep->URB_ExtraRsvd) {
+        USBD_URB_ExtraRsvdAvail[dev_nbr] -= (p_ep->URB_ExtraRsvd - p_ep->URB_ExtraCnt);
+    }
+    USBD_URB_ExtraRsvdTot[dev_nbr] -= p_ep->URB_ExtraRsvd;
+    p_ep->URB_ExtraRsvd             = 0u;                       /* Rsvd extra URB still used become unreserved.         */
+    p_ep->URB_ExtraMax              = USBD_CFG_MAX_NBR_URB_EXTRA;
+#endif
     CPU_CRITICAL_EXIT();
 
+    USBD_DBG_STATS_POOL_FREE(&USBD_DbgStatsPoolEP);
+
     p_drv->API_Ptr->EP_Close(p_drv, ep_addr);
 
     p_ep->XferState = USBD_XFER_STATE_NONE;
@@ -2886,8 +3658,8 @@ void  USBD_EP_Close (USBD_DRV    *p_drv,
 
     USBD_DBG_STATS_EP_INC_IF_TRUE(dev_nbr, p_ep->Ix, EP_CloseSuccessNbr, (*p_err == USBD_ERR_NONE));
 
-    USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                           p_ep->Ix);
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
 
     USBD_OS_EP_SignalDel(p_drv->DevNbr, p_ep->Ix);
     USBD_OS_EP_LockDel  (p_drv->DevNbr, p_ep->Ix);
@@ -2962,10 +3734,10 @@ void  USBD_EP_Stall (CPU_INT08U    dev_nbr,
         return;
     }
 
-    USBD_OS_EP_LockAcquire(p_drv->DevNbr,
-                           p_ep->Ix,
-                           0u,
-                           p_err);
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
     if (*p_err != USBD_ERR_NONE) {
         return;
     }
@@ -3013,8 +3785,8 @@ void  USBD_EP_Stall (CPU_INT08U    dev_nbr,
              break;
     }
 
-    USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                           p_ep->Ix);
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
 
     if (p_urb_head_aborted != (USBD_URB *)0) {
         USBD_URB_AsyncEnd(dev_nbr, p_ep, p_urb_head_aborted);   /* Execute callback and free aborted URB(s), if any.    */
@@ -3087,124 +3859,494 @@ CPU_BOOLEAN  USBD_EP_IsStalled (CPU_INT08U   dev_nbr,
 
 /*
 *********************************************************************************************************
-*                                          USBD_EP_RxCmpl()
+*                                       USBD_EP_DirectCmplSet()
 *
-* Description : Notify USB stack that packet receive has completed.
+* Description : Enable or disable direct completion of asynchronous transfers on non-control endpoint.
 *
-* Argument(s) : p_drv       Pointer to device driver structure.
+* Argument(s) : dev_nbr     Device number.
 *
-*               ep_log_nbr  Endpoint logical number.
+*               ep_addr     Endpoint address.
+*
+*               en          Direct completion state :
+*
+*                               DEF_ENABLED     Process transfer completions from the driver's ISR.
+*                               DEF_DISABLED    Process transfer completions from the core task.
+*
+*               p_err       Pointer to variable that will receive return error code from this function :
+*
+*                               USBD_ERR_NONE               Direct completion state successfully set.
+*                               USBD_ERR_DEV_INVALID_NBR    Invalid device number.
+*                               USBD_ERR_EP_INVALID_ADDR    Invalid endpoint address.
+*                               USBD_ERR_EP_INVALID_TYPE    Invalid endpoint type.
+*                               USBD_ERR_EP_IO_PENDING      Transfer in progress on this endpoint.
+*
+*                               - RETURNED BY USBD_OS_EP_LockAcquire() -
+*                               See USBD_OS_EP_LockAcquire() for additional return error codes.
 *
 * Return(s)   : none.
 *
-* Note(s)     : none.
+* Note(s)     : (1) When direct completion is enabled, the asynchronous transfers of the endpoint are
+*                   completed from the driver's ISR, bypassing the core task queue. The next transaction
+*                   of a transfer is started, and the transfer callback is executed, from the ISR context.
+*                   A completion is still deferred to the core task if a task is using the endpoint when
+*                   the ISR occurs (see USBD_EP_XferDirectCmpl() Note #1).
+*
+*               (2) The callback of an endpoint with direct completion enabled :
+*
+*                   (a) MUST NOT block and MUST NOT call any synchronous transfer function.
+*
+*                   (b) MAY queue a new asynchronous transfer on the same endpoint.
+*
+*                   (c) MUST NOT queue a transfer on another endpoint. The other endpoint's OS lock cannot
+*                       be acquired from an ISR.
+*
+*               (3) The driver's transfer functions ('EP_Rx()', 'EP_RxStart()', 'EP_Tx()', 'EP_TxStart()'
+*                   and 'EP_TxZLP()') MUST be callable from the ISR context.
+*
+*               (4) The endpoint MUST be idle when the direct completion state is changed. Direct
+*                   completion is disabled each time the endpoint is opened.
 *********************************************************************************************************
 */
 
-void  USBD_EP_RxCmpl (USBD_DRV    *p_drv,
-                      CPU_INT08U   ep_log_nbr)
+#if (USBD_CFG_EP_DIRECT_CMPL_EN == DEF_ENABLED)
+void  USBD_EP_DirectCmplSet (CPU_INT08U    dev_nbr,
+                             CPU_INT08U    ep_addr,
+                             CPU_BOOLEAN   en,
+                             USBD_ERR     *p_err)
 {
+    USBD_DRV    *p_drv;
     USBD_EP     *p_ep;
     CPU_INT08U   ep_phy_nbr;
-    USBD_ERR     err;
+    CPU_SR_ALLOC();
 
 
-#if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)
+#if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)                /* ---------------- VALIDATE ARGUMENTS ---------------- */
+    if (p_err == (USBD_ERR *)0) {                               /* Validate error ptr.                                  */
+        CPU_SW_EXCEPTION(;);
+    }
+#endif
+
+    p_drv = USBD_DrvRefGet(dev_nbr);                            /* Get dev struct.                                      */
     if (p_drv == (USBD_DRV *)0) {
+       *p_err = USBD_ERR_DEV_INVALID_NBR;
         return;
     }
-#endif
 
-    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(USBD_EP_LOG_TO_ADDR_OUT(ep_log_nbr));
-    p_ep       = USBD_EP_TblPtrs[p_drv->DevNbr][ep_phy_nbr];
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(ep_addr);
+    p_ep       = USBD_EP_TblPtrs[dev_nbr][ep_phy_nbr];
 
     if (p_ep == (USBD_EP *)0) {
-        USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, RxCmplErrNbr);
+       *p_err = USBD_ERR_EP_INVALID_ADDR;
         return;
     }
 
-    USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, RxCmplNbr);
+    if ((p_ep->Attrib & USBD_EP_TYPE_MASK) == USBD_EP_TYPE_CTRL) {
+       *p_err = USBD_ERR_EP_INVALID_TYPE;
+        return;
+    }
 
-    if (p_ep->XferState == USBD_XFER_STATE_SYNC) {
-        USBD_OS_EP_SignalPost(p_drv->DevNbr, p_ep->Ix, &err);
-    } else if ((p_ep->XferState == USBD_XFER_STATE_ASYNC) ||
-               (p_ep->XferState == USBD_XFER_STATE_ASYNC_PARTIAL)) {
-        USBD_EventEP(p_drv, p_ep->Addr, USBD_ERR_NONE);
-    } else {
-        USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, RxCmplErrNbr);
-        USBD_DBG_EP("USBD_EP_RxCmpl(): incorrect XferState", p_ep->Addr);
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    if (p_ep->XferState != USBD_XFER_STATE_NONE) {              /* See Note #4.                                         */
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
+       *p_err = USBD_ERR_EP_IO_PENDING;
+        return;
     }
+
+    CPU_CRITICAL_ENTER();
+    p_ep->DirectCmplEn       = (en == DEF_ENABLED) ? DEF_ENABLED : DEF_DISABLED;
+    p_ep->DirectCmplDeferCnt =  0u;
+    CPU_CRITICAL_EXIT();
+
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
+
+    USBD_DBG_EP_ARG("EP DirectCmplSet", ep_addr, en);
+
+   *p_err = USBD_ERR_NONE;
 }
+#endif
 
 
 /*
 *********************************************************************************************************
-*                                          USBD_EP_TxCmpl()
+*                                       USBD_EP_URB_QuotaSet()
 *
-* Description : Notify USB stack that packet transmit has completed.
+* Description : Set the extra URB quota of a non-control endpoint.
 *
-* Argument(s) : p_drv       Pointer to device driver structure.
+* Argument(s) : dev_nbr     Device number.
 *
-*               ep_log_nbr  Endpoint logical number.
+*               ep_addr     Endpoint address.
+*
+*               nbr_rsvd    Number of extra URBs reserved for the endpoint (see Note #1).
+*
+*               nbr_max     Maximum number of extra URBs the endpoint can use at once (see Note #2).
+*
+*               p_err       Pointer to variable that will receive return error code from this function :
+*
+*                               USBD_ERR_NONE               Extra URB quota successfully set.
+*                               USBD_ERR_INVALID_ARG        Invalid argument(s).
+*                               USBD_ERR_DEV_INVALID_NBR    Invalid device number.
+*                               USBD_ERR_EP_INVALID_ADDR    Invalid endpoint address.
+*                               USBD_ERR_EP_INVALID_TYPE    Invalid endpoint type.
+*                               USBD_ERR_EP_IO_PENDING      Endpoint is using extra URB(s).
+*                               USBD_ERR_EP_QUEUING         Not enough unreserved extra URBs available.
+*
+*                               - RETURNED BY USBD_OS_EP_LockAcquire() -
+*                               See USBD_OS_EP_LockAcquire() for additional return error codes.
 *
 * Return(s)   : none.
 *
-* Note(s)     : none.
+* Note(s)     : (1) Reserved extra URBs can only be used by this endpoint. The sum of the reservations
+*                   of all the endpoints of a device can NOT exceed USBD_CFG_MAX_NBR_URB_EXTRA.
+*
+*               (2) Limiting the number of extra URBs an endpoint can use prevents a busy endpoint from
+*                   starving the other endpoints of the device. 'nbr_max' MUST be greater than or equal
+*                   to 'nbr_rsvd'.
+*
+*               (3) By default, an endpoint has no reserved extra URB and can use up to
+*                   USBD_CFG_MAX_NBR_URB_EXTRA extra URBs. The default quota is restored each time the
+*                   endpoint is closed.
 *********************************************************************************************************
 */
 
-void  USBD_EP_TxCmpl (USBD_DRV    *p_drv,
-                      CPU_INT08U   ep_log_nbr)
+#if (USBD_CFG_MAX_NBR_URB_EXTRA > 0u)
+void  USBD_EP_URB_QuotaSet (CPU_INT08U    dev_nbr,
+                            CPU_INT08U    ep_addr,
+                            CPU_INT08U    nbr_rsvd,
+                            CPU_INT08U    nbr_max,
+                            USBD_ERR     *p_err)
 {
+    USBD_DRV    *p_drv;
     USBD_EP     *p_ep;
     CPU_INT08U   ep_phy_nbr;
-    USBD_ERR     err;
+    CPU_INT08U   nbr_unrsvd;
+    CPU_INT16U   rsvd_tot;
+    CPU_SR_ALLOC();
 
 
-#if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)
-    if (p_drv == (USBD_DRV *)0) {
+#if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)                /* ---------------- VALIDATE ARGUMENTS ---------------- */
+    if (p_err == (USBD_ERR *)0) {                               /* Validate error ptr.                                  */
+        CPU_SW_EXCEPTION(;);
+    }
+
+    if ((nbr_rsvd > nbr_max) ||                                 /* See Note #2.                                         */
+        (nbr_max  > USBD_CFG_MAX_NBR_URB_EXTRA)) {
+       *p_err = USBD_ERR_INVALID_ARG;
         return;
     }
 #endif
 
-    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(USBD_EP_LOG_TO_ADDR_IN(ep_log_nbr));
-    p_ep       = USBD_EP_TblPtrs[p_drv->DevNbr][ep_phy_nbr];
+    p_drv = USBD_DrvRefGet(dev_nbr);                            /* Get dev struct.                                      */
+    if (p_drv == (USBD_DRV *)0) {
+       *p_err = USBD_ERR_DEV_INVALID_NBR;
+        return;
+    }
+
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(ep_addr);
+    p_ep       = USBD_EP_TblPtrs[dev_nbr][ep_phy_nbr];
 
     if (p_ep == (USBD_EP *)0) {
-        USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, TxCmplErrNbr);
+       *p_err = USBD_ERR_EP_INVALID_ADDR;
         return;
     }
 
-    USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, TxCmplNbr);
+    if ((p_ep->Attrib & USBD_EP_TYPE_MASK) == USBD_EP_TYPE_CTRL) {
+       *p_err = USBD_ERR_EP_INVALID_TYPE;
+        return;
+    }
 
-    if (p_ep->XferState == USBD_XFER_STATE_SYNC) {
-        USBD_OS_EP_SignalPost(p_drv->DevNbr, p_ep->Ix, &err);
-    } else if ((p_ep->XferState == USBD_XFER_STATE_ASYNC) ||
-               (p_ep->XferState == USBD_XFER_STATE_ASYNC_PARTIAL)) {
-        USBD_EventEP(p_drv, p_ep->Addr, USBD_ERR_NONE);
-    } else {
-        USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, TxCmplErrNbr);
-        USBD_DBG_EP("USBD_EP_TxCmpl(): incorrect XferState", p_ep->Addr);
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    CPU_CRITICAL_ENTER();
+    if (p_ep->URB_ExtraCnt != 0u) {
+        CPU_CRITICAL_EXIT();
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
+       *p_err = USBD_ERR_EP_IO_PENDING;
+        return;
+    }
+
+    rsvd_tot = (CPU_INT16U)USBD_URB_ExtraRsvdTot[dev_nbr] - p_ep->URB_ExtraRsvd + nbr_rsvd;
+    if (rsvd_tot > USBD_CFG_MAX_NBR_URB_EXTRA) {                /* See Note #1.                                         */
+        CPU_CRITICAL_EXIT();
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
+       *p_err = USBD_ERR_INVALID_ARG;
+        return;
     }
+                                                                /* Nbr of free extra URBs not rsvd by any EP.           */
+    nbr_unrsvd = USBD_CFG_MAX_NBR_URB_EXTRA - USBD_URB_ExtraCtr[dev_nbr] - USBD_URB_ExtraRsvdAvail[dev_nbr];
+    if ((nbr_rsvd   >  p_ep->URB_ExtraRsvd) &&                  /* New rsvd URBs must currently be free.                */
+        (nbr_unrsvd < (nbr_rsvd - p_ep->URB_ExtraRsvd))) {
+        CPU_CRITICAL_EXIT();
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
+       *p_err = USBD_ERR_EP_QUEUING;
+        return;
+    }
+
+    USBD_URB_ExtraRsvdTot[dev_nbr]   -= p_ep->URB_ExtraRsvd;
+    USBD_URB_ExtraRsvdAvail[dev_nbr] -= p_ep->URB_ExtraRsvd;
+    USBD_URB_ExtraRsvdTot[dev_nbr]   += nbr_rsvd;
+    USBD_URB_ExtraRsvdAvail[dev_nbr] += nbr_rsvd;
+    p_ep->URB_ExtraRsvd               = nbr_rsvd;
+    p_ep->URB_ExtraMax                = nbr_max;
+    CPU_CRITICAL_EXIT();
+
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
+
+    USBD_DBG_EP_ARG("EP URB QuotaSet", ep_addr, nbr_rsvd);
+
+   *p_err = USBD_ERR_NONE;
 }
+#endif
 
 
 /*
 *********************************************************************************************************
-*                                         USBD_EP_TxCmplExt()
+*                                        USBD_EP_LatStatsGet()
 *
-* Description : Notify USB stack that packet transmit has completed (see Note #1).
+* Description : Get a snapshot of the latency histograms of an endpoint.
 *
-* Argument(s) : p_drv       Pointer to device driver structure.
+* Argument(s) : dev_nbr     Device number.
 *
-*               ep_log_nbr  Endpoint logical number.
+*               ep_addr     Endpoint address.
 *
-*               err         Error code returned by the USB driver.
+*               p_lat       Pointer to variable that will receive the latency histograms.
 *
-* Return(s)   : none.
+*               reset       Flag indicating if the histograms are cleared once copied :
 *
-* Note(s)     : (1) This function is an alternative to the function USBD_EP_TxCmpl() so that a USB device
-*                   driver can return to the core an error code upon the Tx transfer completion.
+*                               DEF_YES     Clear   histograms.
+*                               DEF_NO      Keep    histograms.
+*
+*               p_err       Pointer to variable that will receive return error code from this function :
+*
+*                               USBD_ERR_NONE               Latency histograms successfully copied.
+*                               USBD_ERR_NULL_PTR           Null pointer passed to 'p_lat'.
+*                               USBD_ERR_DEV_INVALID_NBR    Invalid device number.
+*                               USBD_ERR_EP_INVALID_ADDR    Invalid endpoint address.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) The histograms are copied, and optionally cleared, within a critical section. A
+*                   sample is never split between the snapshot and the histograms that remain. The
+*                   endpoint lock is NOT acquired, so that the function can be called at any time without
+*                   disturbing the transfers in progress.
+*
+*               (2) See 'usbd_core.h  EP LATENCY HISTOGRAMS' for the definition of the histograms.
+*********************************************************************************************************
+*/
+
+#if (USBD_EP_LAT_EN == DEF_ENABLED)
+void  USBD_EP_LatStatsGet (CPU_INT08U              dev_nbr,
+                           CPU_INT08U              ep_addr,
+                           USBD_DBG_STATS_EP_LAT  *p_lat,
+                           CPU_BOOLEAN             reset,
+                           USBD_ERR               *p_err)
+{
+    USBD_DRV               *p_drv;
+    USBD_EP                *p_ep;
+    USBD_DBG_STATS_EP_LAT  *p_lat_ep;
+    CPU_INT08U              ep_phy_nbr;
+    CPU_SR_ALLOC();
+
+
+#if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)                /* ---------------- VALIDATE ARGUMENTS ---------------- */
+    if (p_err == (USBD_ERR *)0) {                               /* Validate error ptr.                                  */
+        CPU_SW_EXCEPTION(;);
+    }
+
+    if (p_lat == (USBD_DBG_STATS_EP_LAT *)0) {
+       *p_err = USBD_ERR_NULL_PTR;
+        return;
+    }
+#endif
+
+    p_drv = USBD_DrvRefGet(dev_nbr);                            /* Get dev struct.                                      */
+    if (p_drv == (USBD_DRV *)0) {
+       *p_err = USBD_ERR_DEV_INVALID_NBR;
+        return;
+    }
+
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(ep_addr);
+    p_ep       = USBD_EP_TblPtrs[dev_nbr][ep_phy_nbr];
+
+    if (p_ep == (USBD_EP *)0) {
+       *p_err = USBD_ERR_EP_INVALID_ADDR;
+        return;
+    }
+
+    p_lat_ep = &USBD_DbgStatsEP_Tbl[dev_nbr][p_ep->Ix].Lat;
+
+    CPU_CRITICAL_ENTER();                                       /* See Note #1.                                         */
+    Mem_Copy((void     *)p_lat,
+             (void     *)p_lat_ep,
+             (CPU_SIZE_T)sizeof(USBD_DBG_STATS_EP_LAT));
+    if (reset == DEF_YES) {
+        Mem_Clr((void     *)p_lat_ep,
+                (CPU_SIZE_T)sizeof(USBD_DBG_STATS_EP_LAT));
+    }
+    CPU_CRITICAL_EXIT();
+
+   *p_err = USBD_ERR_NONE;
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_EP_RxCmpl()
+*
+* Description : Notify USB stack that packet receive has completed (see Note #1).
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+*               ep_log_nbr  Endpoint logical number.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) If direct completion is enabled on the endpoint, an asynchronous transfer completion
+*                   may be processed from this function (see USBD_EP_DirectCmplSet()).
+*********************************************************************************************************
+*/
+
+void  USBD_EP_RxCmpl (USBD_DRV    *p_drv,
+                      CPU_INT08U   ep_log_nbr)
+{
+    USBD_EP     *p_ep;
+    CPU_INT08U   ep_phy_nbr;
+    USBD_ERR     err;
+
+
+#if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)
+    if (p_drv == (USBD_DRV *)0) {
+        return;
+    }
+#endif
+
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(USBD_EP_LOG_TO_ADDR_OUT(ep_log_nbr));
+    p_ep       = USBD_EP_TblPtrs[p_drv->DevNbr][ep_phy_nbr];
+
+    if (p_ep == (USBD_EP *)0) {
+        USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, RxCmplErrNbr);
+        return;
+    }
+
+    USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, RxCmplNbr);
+    USBD_EP_LAT_DRV_CMPL(p_ep);
+
+    if (p_ep->XferState == USBD_XFER_STATE_SYNC) {
+        USBD_OS_EP_SignalPost(p_drv->DevNbr, p_ep->Ix, &err);
+    } else if ((p_ep->XferState == USBD_XFER_STATE_ASYNC) ||
+               (p_ep->XferState == USBD_XFER_STATE_ASYNC_PARTIAL)) {
+#if (USBD_CFG_EP_DIRECT_CMPL_EN == DEF_ENABLED)
+        if (USBD_EP_XferDirectCmpl(p_drv, p_ep, USBD_ERR_NONE) == DEF_NO) {
+            USBD_EP_XferCmplDefer(p_drv, p_ep, USBD_ERR_NONE);  /* Cmpl not processed from ISR, defer to core task.     */
+        }
+#else
+        USBD_EventEP(p_drv, p_ep->Addr, USBD_ERR_NONE);
+#endif
+    } else {
+        USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, RxCmplErrNbr);
+        USBD_DBG_EP("USBD_EP_RxCmpl(): incorrect XferState", p_ep->Addr);
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_EP_TxCmpl()
+*
+* Description : Notify USB stack that packet transmit has completed (see Note #1).
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+*               ep_log_nbr  Endpoint logical number.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) If direct completion is enabled on the endpoint, an asynchronous transfer completion
+*                   may be processed from this function (see USBD_EP_DirectCmplSet()).
+*********************************************************************************************************
+*/
+
+void  USBD_EP_TxCmpl (USBD_DRV    *p_drv,
+                      CPU_INT08U   ep_log_nbr)
+{
+    USBD_EP     *p_ep;
+    CPU_INT08U   ep_phy_nbr;
+    USBD_ERR     err;
+
+
+#if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)
+    if (p_drv == (USBD_DRV *)0) {
+        return;
+    }
+#endif
+
+    ep_phy_nbr = USBD_EP_ADDR_TO_PHY(USBD_EP_LOG_TO_ADDR_IN(ep_log_nbr));
+    p_ep       = USBD_EP_TblPtrs[p_drv->DevNbr][ep_phy_nbr];
+
+    if (p_ep == (USBD_EP *)0) {
+        USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, TxCmplErrNbr);
+        return;
+    }
+
+    USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, TxCmplNbr);
+    USBD_EP_LAT_DRV_CMPL(p_ep);
+
+    if (p_ep->XferState == USBD_XFER_STATE_SYNC) {
+        USBD_OS_EP_SignalPost(p_drv->DevNbr, p_ep->Ix, &err);
+    } else if ((p_ep->XferState == USBD_XFER_STATE_ASYNC) ||
+               (p_ep->XferState == USBD_XFER_STATE_ASYNC_PARTIAL)) {
+#if (USBD_CFG_EP_DIRECT_CMPL_EN == DEF_ENABLED)
+        if (USBD_EP_XferDirectCmpl(p_drv, p_ep, USBD_ERR_NONE) == DEF_NO) {
+            USBD_EP_XferCmplDefer(p_drv, p_ep, USBD_ERR_NONE);  /* Cmpl not processed from ISR, defer to core task.     */
+        }
+#else
+        USBD_EventEP(p_drv, p_ep->Addr, USBD_ERR_NONE);
+#endif
+    } else {
+        USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, TxCmplErrNbr);
+        USBD_DBG_EP("USBD_EP_TxCmpl(): incorrect XferState", p_ep->Addr);
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_EP_TxCmplExt()
+*
+* Description : Notify USB stack that packet transmit has completed (see Note #1).
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+*               ep_log_nbr  Endpoint logical number.
+*
+*               err         Error code returned by the USB driver.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) This function is an alternative to the function USBD_EP_TxCmpl() so that a USB device
+*                   driver can return to the core an error code upon the Tx transfer completion.
+*
+*               (2) If direct completion is enabled on the endpoint, an asynchronous transfer completion
+*                   may be processed from this function (see USBD_EP_DirectCmplSet()).
 *********************************************************************************************************
 */
 
@@ -3232,6 +4374,7 @@ void  USBD_EP_TxCmplExt (USBD_DRV    *p_drv,
     }
 
     USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, TxCmplNbr);
+    USBD_EP_LAT_DRV_CMPL(p_ep);
 
     if (p_ep->XferState == USBD_XFER_STATE_SYNC) {
         USBD_OS_EP_SignalAbort(p_drv->DevNbr, p_ep->Ix, &local_err);
@@ -3240,7 +4383,13 @@ void  USBD_EP_TxCmplExt (USBD_DRV    *p_drv,
         }
     } else if ((p_ep->XferState == USBD_XFER_STATE_ASYNC) ||
                (p_ep->XferState == USBD_XFER_STATE_ASYNC_PARTIAL)) {
+#if (USBD_CFG_EP_DIRECT_CMPL_EN == DEF_ENABLED)
+        if (USBD_EP_XferDirectCmpl(p_drv, p_ep, xfer_err) == DEF_NO) {
+            USBD_EP_XferCmplDefer(p_drv, p_ep, xfer_err);       /* Cmpl not processed from ISR, defer to core task.     */
+        }
+#else
         USBD_EventEP(p_drv, p_ep->Addr, xfer_err);
+#endif
     } else {
         USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, TxCmplErrNbr);
         USBD_DBG_EP("USBD_EP_TxCmplExt(): incorrect XferState", p_ep->Addr);
@@ -3314,10 +4463,10 @@ void  USBD_EP_TxZLP (CPU_INT08U   dev_nbr,
         return;
     }
 
-    USBD_OS_EP_LockAcquire(p_drv->DevNbr,
-                           p_ep->Ix,
-                           0u,
-                           p_err);
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
     if (*p_err != USBD_ERR_NONE) {
         return;
     }
@@ -3357,15 +4506,15 @@ void  USBD_EP_TxZLP (CPU_INT08U   dev_nbr,
     if (*p_err == USBD_ERR_NONE) {
         USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, DrvTxZLP_SuccessNbr);
 
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,                   /* Unlock before pending on completion.                 */
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,                      /* Unlock before pending on completion.                 */
+                            p_ep->Ix);
 
         USBD_OS_EP_SignalPend(dev_nbr, p_ep->Ix, timeout_ms, p_err);
 
-        USBD_OS_EP_LockAcquire(p_drv->DevNbr,                   /* Re-lock EP after xfer completion.                    */
-                               p_ep->Ix,
-                               0u,
-                              &local_err);
+        USBD_EP_LockAcquire(p_drv->DevNbr,                      /* Re-lock EP after xfer completion.                    */
+                            p_ep->Ix,
+                            0u,
+                           &local_err);
         if (local_err != USBD_ERR_NONE) {
            *p_err = USBD_ERR_OS_FAIL;
 
@@ -3375,6 +4524,8 @@ void  USBD_EP_TxZLP (CPU_INT08U   dev_nbr,
         }
     }
 
+    USBD_EP_CAPTURE_CMPL(dev_nbr, p_ep, p_urb, *p_err);
+
     USBD_URB_Dequeue(p_ep);
 
     USBD_URB_Free(dev_nbr, p_ep, p_urb);
@@ -3382,8 +4533,8 @@ void  USBD_EP_TxZLP (CPU_INT08U   dev_nbr,
     USBD_DBG_STATS_EP_INC_IF_TRUE(dev_nbr, p_ep->Ix, TxZLP_SuccessNbr, (*p_err == USBD_ERR_NONE));
 
 lock_release:
-    USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                           p_ep->Ix);
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
 }
 
 
@@ -3456,10 +4607,10 @@ void  USBD_EP_RxZLP (CPU_INT08U   dev_nbr,
         return;
     }
 
-    USBD_OS_EP_LockAcquire(p_drv->DevNbr,
-                           p_ep->Ix,
-                           0u,
-                           p_err);
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                        p_err);
     if (*p_err != USBD_ERR_NONE) {
         return;
     }
@@ -3501,15 +4652,15 @@ void  USBD_EP_RxZLP (CPU_INT08U   dev_nbr,
     if (*p_err == USBD_ERR_NONE) {
         USBD_DBG_STATS_EP_INC(dev_nbr, p_ep->Ix, DrvRxStartSuccessNbr);
 
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,                   /* Unlock before pending on completion.                 */
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,                      /* Unlock before pending on completion.                 */
+                            p_ep->Ix);
 
         USBD_OS_EP_SignalPend(dev_nbr, p_ep->Ix, timeout_ms, p_err);
 
-        USBD_OS_EP_LockAcquire(p_drv->DevNbr,                   /* Re-lock EP after xfer completion.                    */
-                               p_ep->Ix,
-                               0u,
-                              &local_err);
+        USBD_EP_LockAcquire(p_drv->DevNbr,                      /* Re-lock EP after xfer completion.                    */
+                            p_ep->Ix,
+                            0u,
+                           &local_err);
         if ((*p_err    == USBD_ERR_NONE) &&
             (local_err == USBD_ERR_NONE)) {
             USBD_DBG_STATS_EP_INC(dev_nbr, p_ep->Ix, DrvRxZLP_Nbr);
@@ -3529,6 +4680,8 @@ void  USBD_EP_RxZLP (CPU_INT08U   dev_nbr,
         }
     }
 
+    USBD_EP_CAPTURE_CMPL(dev_nbr, p_ep, p_urb, *p_err);
+
     USBD_URB_Dequeue(p_ep);
 
     USBD_URB_Free(dev_nbr, p_ep, p_urb);
@@ -3536,111 +4689,395 @@ void  USBD_EP_RxZLP (CPU_INT08U   dev_nbr,
     USBD_DBG_STATS_EP_INC_IF_TRUE(dev_nbr, p_ep->Ix, RxZLP_SuccessNbr, (*p_err == USBD_ERR_NONE));
 
 lock_release:
-    USBD_OS_EP_LockRelease(p_drv->DevNbr,
-                           p_ep->Ix);
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
 }
 
 
 /*
 *********************************************************************************************************
 *********************************************************************************************************
-*                                           LOCAL FUNCTIONS
+*                                        TRAFFIC CAPTURE FUNCTIONS
 *********************************************************************************************************
 *********************************************************************************************************
 */
 
 /*
 *********************************************************************************************************
-*                                     USBD_EP_RxStartAsyncProcess()
+*                                       USBD_EP_CaptureSetup()
 *
-* Description : Process driver's asynchronous RxStart operation.
+* Description : Record a setup packet in the capture ring.
 *
-* Argument(s) : p_drv       Pointer to device driver structure.
+* Argument(s) : dev_nbr     Device number.
 *
-*               p_ep        Pointer to endpoint on which data will be received.
+*               p_setup     Pointer to setup packet (8 octets).
+*               -------     Argument validated by caller.
 *
-*               p_urb       Pointer to USB request block.
+* Return(s)   : none.
 *
-*               p_buf_cur   Pointer to source buffer to receive data.
+* Note(s)     : (1) This function is called from the driver's ISR, through USBD_EventSetup().
 *
-*               len         Number of octets to receive.
+*               (2) The endpoint address recorded reflects the direction of the data stage, as done by
+*                   USBPcap.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_CAPTURE_EN == DEF_ENABLED)
+void  USBD_EP_CaptureSetup (CPU_INT08U   dev_nbr,
+                            CPU_INT08U  *p_setup)
+{
+    CPU_INT08U  ep_addr;
+
+
+    if (DEF_BIT_IS_SET(p_setup[0u], USBD_REQ_DIR_BIT) == DEF_YES) {
+        ep_addr = USBD_EP_ADDR_CTRL_IN;                         /* See Note #2.                                         */
+    } else {
+        ep_addr = USBD_EP_ADDR_CTRL_OUT;
+    }
+
+    USBD_EP_CaptureRecPut(dev_nbr,
+                          ep_addr,
+                          USBD_CAPTURE_XFER_CTRL,
+                          DEF_NO,
+                          USBD_CAPTURE_STAGE_SETUP,
+                          0u,
+                          USBD_CAPTURE_STATUS_SUCCESS,
+                          p_setup,
+                          8u);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_CaptureEnSet()
 *
-*               p_err       Pointer to variable that will receive return error code from this function :
+* Description : Enable or disable traffic capture.
 *
-*                               USBD_ERR_NONE               Receive successfully configured.
+* Argument(s) : en          Capture state :
 *
-*                               - RETURNED BY 'p_drv_api->EP_RxStart()' -
-*                               See specific driver(s) 'p_drv_api->EP_RxStart()' for additional return error codes.
+*                               DEF_ENABLED     Record events (default).
+*                               DEF_DISABLED    Stop recording events. Data already in the ring can
+*                                               still be read.
 *
 * Return(s)   : none.
 *
-* Note(s)     : (1) Endpoint must be locked when calling this function.
+* Note(s)     : none.
 *********************************************************************************************************
 */
 
-static  void  USBD_EP_RxStartAsyncProcess (USBD_DRV    *p_drv,
-                                           USBD_EP     *p_ep,
-                                           USBD_URB    *p_urb,
-                                           CPU_INT08U  *p_buf_cur,
-                                           CPU_INT32U   len,
-                                           USBD_ERR    *p_err)
+#if (USBD_CFG_CAPTURE_EN == DEF_ENABLED)
+void  USBD_CaptureEnSet (CPU_BOOLEAN  en)
 {
-    USBD_DRV_API  *p_drv_api;
     CPU_SR_ALLOC();
 
 
-    p_drv_api = p_drv->API_Ptr;                                 /* Get dev drv API struct.                              */
-
-    USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, DrvRxStartNbr);
-    p_urb->NextXferLen = p_drv_api->EP_RxStart(p_drv,
-                                               p_ep->Addr,
-                                               p_buf_cur,
-                                               len,
-                                               p_err);
-    if (*p_err != USBD_ERR_NONE) {
-        return;
-    }
-
-    USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, DrvRxStartSuccessNbr);
-
-    if (p_urb->NextXferLen != len) {
-        CPU_CRITICAL_ENTER();
-        p_ep->XferState = USBD_XFER_STATE_ASYNC_PARTIAL;        /* Xfer will have to be done in many transactions.      */
-        CPU_CRITICAL_EXIT();
-    }
+    CPU_CRITICAL_ENTER();
+    USBD_Capture.En = en;
+    CPU_CRITICAL_EXIT();
 }
+#endif
 
 
 /*
 *********************************************************************************************************
-*                                       USBD_EP_TxAsyncProcess()
+*                                      USBD_CaptureFileHdrGet()
 *
-* Description : Process driver's asynchronous Tx operation.
-*
-* Argument(s) : p_drv       Pointer to device driver structure.
-*
-*               p_ep        Pointer to endpoint on which data will be transmitted.
-*
-*               p_urb       Pointer to USB request block.
+* Description : Get the pcap file header that precedes the records read from the capture ring.
 *
-*               p_buf_cur   Pointer to source buffer to transmit data.
+* Argument(s) : p_buf       Pointer to buffer that receives the file header.
 *
-*               len         Number of octets to transmit.
+*               buf_len     Buffer length, in octets.
 *
-*               p_err       Pointer to variable that will receive return error code from this function :
+*               p_err       Pointer to variable that will receive the return error code from this function :
 *
-*                               USBD_ERR_NONE               Transmit successfully configured.
-*                               USBD_ERR_TX                 Generic Tx error.
+*                               USBD_ERR_NONE           File header successfully copied.
+*                               USBD_ERR_NULL_PTR       Argument 'p_buf' passed a NULL pointer.
+*                               USBD_ERR_INVALID_ARG    Buffer shorter than USBD_CAPTURE_FILE_HDR_LEN.
 *
-*                               - RETURNED BY 'p_drv_api->EP_Tx()' -
-*                               See specific driver(s) 'p_drv_api->EP_Tx()' for additional return error codes.
+* Return(s)   : Length of file header, if NO error(s).
 *
-*                               - RETURNED BY 'p_drv_api->EP_TxStart()' -
-*                               See specific driver(s) 'p_drv_api->EP_TxStart()' for additional return error codes.
+*               0,                     otherwise.
+*
+* Note(s)     : (1) All fields are written in little-endian order. pcap readers detect the byte order from
+*                   the magic number.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_CAPTURE_EN == DEF_ENABLED)
+CPU_INT32U  USBD_CaptureFileHdrGet (CPU_INT08U  *p_buf,
+                                    CPU_INT32U   buf_len,
+                                    USBD_ERR    *p_err)
+{
+#if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)                /* ---------------- VALIDATE ARGUMENTS ---------------- */
+    if (p_err == (USBD_ERR *)0) {                               /* Validate error ptr.                                  */
+        CPU_SW_EXCEPTION(0);
+    }
+
+    if (p_buf == (CPU_INT08U *)0) {
+       *p_err = USBD_ERR_NULL_PTR;
+        return (0u);
+    }
+#endif
+
+    if (buf_len < USBD_CAPTURE_FILE_HDR_LEN) {
+       *p_err = USBD_ERR_INVALID_ARG;
+        return (0u);
+    }
+                                                                /* See Note #1.                                         */
+    MEM_VAL_SET_INT32U_LITTLE(&p_buf[ 0u], USBD_CAPTURE_PCAP_MAGIC);
+    MEM_VAL_SET_INT16U_LITTLE(&p_buf[ 4u], USBD_CAPTURE_PCAP_VER_MAJOR);
+    MEM_VAL_SET_INT16U_LITTLE(&p_buf[ 6u], USBD_CAPTURE_PCAP_VER_MINOR);
+    MEM_VAL_SET_INT32U_LITTLE(&p_buf[ 8u], 0u);                 /* Time zone offset.                                    */
+    MEM_VAL_SET_INT32U_LITTLE(&p_buf[12u], 0u);                 /* Timestamp accuracy.                                  */
+    MEM_VAL_SET_INT32U_LITTLE(&p_buf[16u], USBD_CAPTURE_PCAP_SNAP_LEN);
+    MEM_VAL_SET_INT32U_LITTLE(&p_buf[20u], USBD_CAPTURE_LINKTYPE_USBPCAP);
+
+   *p_err = USBD_ERR_NONE;
+
+    return (USBD_CAPTURE_FILE_HDR_LEN);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_CaptureRd()
+*
+* Description : Read and remove data from the capture ring.
+*
+* Argument(s) : p_buf       Pointer to buffer that receives the data.
+*
+*               buf_len     Buffer length, in octets.
+*
+*               p_err       Pointer to variable that will receive the return error code from this function :
+*
+*                               USBD_ERR_NONE           Data successfully read, or ring empty.
+*                               USBD_ERR_NULL_PTR       Argument 'p_buf' passed a NULL pointer.
+*
+* Return(s)   : Number of octets read.
+*
+* Note(s)     : (1) The data read may end in the middle of a record. The record continues at the beginning
+*                   of the next read (see 'usbd_core.h  TRAFFIC CAPTURE  Note #3').
+*
+*               (2) Records are only written to the free space of the ring. The data is copied out of the
+*                   ring with interrupts enabled, and the space is released once copied. Only one task
+*                   may read the ring at a time.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_CAPTURE_EN == DEF_ENABLED)
+CPU_INT32U  USBD_CaptureRd (CPU_INT08U  *p_buf,
+                            CPU_INT32U   buf_len,
+                            USBD_ERR    *p_err)
+{
+    CPU_INT32U  ix_out;
+    CPU_INT32U  rd_len;
+    CPU_INT32U  copy_len;
+    CPU_SR_ALLOC();
+
+
+#if (USBD_CFG_ERR_ARG_CHK_EXT_EN == DEF_ENABLED)                /* ---------------- VALIDATE ARGUMENTS ---------------- */
+    if (p_err == (USBD_ERR *)0) {                               /* Validate error ptr.                                  */
+        CPU_SW_EXCEPTION(0);
+    }
+
+    if ((p_buf   == (CPU_INT08U *)0) &&
+        (buf_len != 0u)) {
+       *p_err = USBD_ERR_NULL_PTR;
+        return (0u);
+    }
+#endif
+
+    CPU_CRITICAL_ENTER();
+    ix_out = USBD_Capture.IxOut;
+    rd_len = USBD_Capture.Cnt;
+    CPU_CRITICAL_EXIT();
+
+    if (rd_len > buf_len) {
+        rd_len = buf_len;
+    }
+                                                                /* Copy data out of ring (see Note #2).                 */
+    copy_len = DEF_MIN(rd_len, USBD_CFG_CAPTURE_BUF_LEN - ix_out);
+    Mem_Copy((void     *)&p_buf[0u],
+             (void     *)&USBD_Capture.BufTbl[ix_out],
+             (CPU_SIZE_T) copy_len);
+    if (copy_len < rd_len) {
+        Mem_Copy((void     *)&p_buf[copy_len],
+                 (void     *)&USBD_Capture.BufTbl[0u],
+                 (CPU_SIZE_T)(rd_len - copy_len));
+    }
+
+    CPU_CRITICAL_ENTER();                                       /* Release space.                                       */
+    USBD_Capture.IxOut  = (ix_out + rd_len) % USBD_CFG_CAPTURE_BUF_LEN;
+    USBD_Capture.Cnt   -=  rd_len;
+    CPU_CRITICAL_EXIT();
+
+   *p_err = USBD_ERR_NONE;
+
+    return (rd_len);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_CaptureDropCntGet()
+*
+* Description : Get the number of records dropped because the capture ring was full.
+*
+* Argument(s) : none.
+*
+* Return(s)   : Number of records dropped since initialization.
+*
+* Note(s)     : none.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_CAPTURE_EN == DEF_ENABLED)
+CPU_INT32U  USBD_CaptureDropCntGet (void)
+{
+    CPU_INT32U  drop_cnt;
+    CPU_SR_ALLOC();
+
+
+    CPU_CRITICAL_ENTER();
+    drop_cnt = USBD_Capture.DropCnt;
+    CPU_CRITICAL_EXIT();
+
+    return (drop_cnt);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*********************************************************************************************************
+*                                           LOCAL FUNCTIONS
+*********************************************************************************************************
+*********************************************************************************************************
+*/
+
+/*
+*********************************************************************************************************
+*                                     USBD_EP_RxStartAsyncProcess()
+*
+* Description : Process driver's asynchronous RxStart operation.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+*               p_ep        Pointer to endpoint on which data will be received.
+*
+*               p_urb       Pointer to USB request block.
+*
+*               p_buf_cur   Pointer to source buffer to receive data.
+*
+*               len         Number of octets to receive.
+*
+*               p_err       Pointer to variable that will receive return error code from this function :
+*
+*                               USBD_ERR_NONE               Receive successfully configured.
+*
+*                               - RETURNED BY 'p_drv_api->EP_RxStart()' -
+*                               See specific driver(s) 'p_drv_api->EP_RxStart()' for additional return error codes.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Endpoint must be locked when calling this function.
+*
+*               (2) For a vectored transfer, 'p_buf_cur' and 'len' are ignored. The buffer and length of
+*                   the next transaction are computed from the URB's segments.
+*
+*               (3) A transaction that uses the endpoint's packet buffer is always handled as a partial
+*                   transfer, so that no other URB is submitted to the driver while the buffer is in use.
+*********************************************************************************************************
+*/
+
+static  void  USBD_EP_RxStartAsyncProcess (USBD_DRV    *p_drv,
+                                           USBD_EP     *p_ep,
+                                           USBD_URB    *p_urb,
+                                           CPU_INT08U  *p_buf_cur,
+                                           CPU_INT32U   len,
+                                           USBD_ERR    *p_err)
+{
+    USBD_DRV_API  *p_drv_api;
+    CPU_INT32U     xfer_rem;
+    CPU_BOOLEAN    straddle;
+    CPU_SR_ALLOC();
+
+
+    p_drv_api = p_drv->API_Ptr;                                 /* Get dev drv API struct.                              */
+    xfer_rem  = len;
+    straddle  = DEF_NO;
+
+#if (USBD_CFG_EP_VEC_XFER_EN == DEF_ENABLED)
+    if (DEF_BIT_IS_SET(p_urb->Flags, USBD_URB_FLAG_VEC) == DEF_YES) {
+        xfer_rem  = p_urb->BufLen - p_urb->XferLen;             /* See Note #2.                                         */
+        len       = USBD_URB_VecNextGet(p_drv->DevNbr, p_ep, p_urb);
+        p_buf_cur = p_urb->SegBufPtr;
+        straddle  = p_urb->SegStraddle;                         /* See Note #3.                                         */
+    }
+#endif
+
+    USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, DrvRxStartNbr);
+    USBD_URB_LAT_DRV_START(p_urb);
+    USBD_EP_CAPTURE_SUBMIT(p_drv->DevNbr, p_ep, p_urb);
+    p_urb->NextXferLen = p_drv_api->EP_RxStart(p_drv,
+                                               p_ep->Addr,
+                                               p_buf_cur,
+                                               len,
+                                               p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, DrvRxStartSuccessNbr);
+
+    if ((p_urb->NextXferLen != xfer_rem) ||
+        (straddle           == DEF_YES)) {
+        CPU_CRITICAL_ENTER();
+        p_ep->XferState = USBD_XFER_STATE_ASYNC_PARTIAL;        /* Xfer will have to be done in many transactions.      */
+        CPU_CRITICAL_EXIT();
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_EP_TxAsyncProcess()
+*
+* Description : Process driver's asynchronous Tx operation.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*
+*               p_ep        Pointer to endpoint on which data will be transmitted.
+*
+*               p_urb       Pointer to USB request block.
+*
+*               p_buf_cur   Pointer to source buffer to transmit data.
+*
+*               len         Number of octets to transmit.
+*
+*               p_err       Pointer to variable that will receive return error code from this function :
+*
+*                               USBD_ERR_NONE               Transmit successfully configured.
+*                               USBD_ERR_TX                 Generic Tx error.
+*
+*                               - RETURNED BY 'p_drv_api->EP_Tx()' -
+*                               See specific driver(s) 'p_drv_api->EP_Tx()' for additional return error codes.
+*
+*                               - RETURNED BY 'p_drv_api->EP_TxStart()' -
+*                               See specific driver(s) 'p_drv_api->EP_TxStart()' for additional return error codes.
 *
 * Return(s)   : none.
 *
 * Note(s)     : (1) Endpoint must be locked when calling this function.
+*
+*               (2) For a vectored transfer, 'p_buf_cur' and 'len' are ignored. The buffer and length of
+*                   the next transaction are computed from the URB's segments.
+*
+*               (3) A transaction that uses the endpoint's packet buffer is always handled as a partial
+*                   transfer, so that no other URB is submitted to the driver while the buffer is in use.
 *********************************************************************************************************
 */
 
@@ -3652,11 +5089,26 @@ static  void  USBD_EP_TxAsyncProcess (USBD_DRV    *p_drv,
                                       USBD_ERR    *p_err)
 {
     USBD_DRV_API  *p_drv_api;
+    CPU_INT32U     xfer_rem;
+    CPU_BOOLEAN    straddle;
 
 
     p_drv_api = p_drv->API_Ptr;                                 /* Get dev drv API struct.                              */
+    xfer_rem  = len;
+    straddle  = DEF_NO;
+
+#if (USBD_CFG_EP_VEC_XFER_EN == DEF_ENABLED)
+    if (DEF_BIT_IS_SET(p_urb->Flags, USBD_URB_FLAG_VEC) == DEF_YES) {
+        xfer_rem  = p_urb->BufLen - p_urb->XferLen;             /* See Note #2.                                         */
+        len       = USBD_URB_VecNextGet(p_drv->DevNbr, p_ep, p_urb);
+        p_buf_cur = p_urb->SegBufPtr;
+        straddle  = p_urb->SegStraddle;                         /* See Note #3.                                         */
+    }
+#endif
 
     USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, DrvTxNbr);
+    USBD_URB_LAT_DRV_START(p_urb);
+    USBD_EP_CAPTURE_SUBMIT(p_drv->DevNbr, p_ep, p_urb);
 
     p_urb->NextXferLen = p_drv_api->EP_Tx(p_drv,
                                           p_ep->Addr,
@@ -3667,7 +5119,8 @@ static  void  USBD_EP_TxAsyncProcess (USBD_DRV    *p_drv,
         return;
     }
 
-    if (p_urb->NextXferLen == len) {                            /* Xfer can be done is a single transaction.            */
+    if ((p_urb->NextXferLen == xfer_rem) &&                     /* Xfer can be done is a single transaction.            */
+        (straddle           == DEF_NO)) {
         p_ep->XferState = USBD_XFER_STATE_ASYNC;
     } else if ((p_ep->Attrib & USBD_EP_TYPE_MASK) != USBD_EP_TYPE_ISOC) {
         p_ep->XferState = USBD_XFER_STATE_ASYNC_PARTIAL;        /* Xfer will have to be done in many transactions.      */
@@ -3686,6 +5139,11 @@ static  void  USBD_EP_TxAsyncProcess (USBD_DRV    *p_drv,
                           p_err);
     if (*p_err == USBD_ERR_NONE) {
         p_urb->XferLen     += p_urb->NextXferLen;               /* Error not accounted on total xfer len.               */
+#if (USBD_CFG_EP_VEC_XFER_EN == DEF_ENABLED)
+        if (DEF_BIT_IS_SET(p_urb->Flags, USBD_URB_FLAG_VEC) == DEF_YES) {
+            USBD_URB_VecAdvance(p_urb, p_urb->NextXferLen);
+        }
+#endif
         p_urb->NextXferLen  = 0u;
         USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, DrvTxStartSuccessNbr);
     }
@@ -3756,6 +5214,11 @@ static  void  USBD_EP_TxAsyncProcess (USBD_DRV    *p_drv,
 *               (4) This condition covers also the case where the transfer length is multiple of the
 *                   maximum packet size. In that case, host sends a zero-length packet considered as
 *                   a short packet for the condition.
+*
+*               (5) If USBD_CFG_EP_PRE_QUEUE_EN is DEF_ENABLED, an asynchronous URB that cannot be
+*                   submitted to the driver right away is held in the endpoint's URB list. It will be
+*                   submitted by USBD_EP_XferAsyncProcess() and any submission error will be reported
+*                   through the URB's callback.
 *********************************************************************************************************
 */
 
@@ -3792,8 +5255,12 @@ static  CPU_INT32U  USBD_EP_Rx (USBD_DRV         *p_drv,
         }
     } else {
         USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, RxAsyncExecNbr);
+#if (USBD_CFG_EP_PRE_QUEUE_EN == DEF_ENABLED)
+        if (p_ep->XferState == USBD_XFER_STATE_SYNC) {          /* Partial xfer does not block queuing (see Note #5).   */
+#else
         if ((p_ep->XferState != USBD_XFER_STATE_NONE) &&
             (p_ep->XferState != USBD_XFER_STATE_ASYNC)) {
+#endif
            *p_err = USBD_ERR_EP_IO_PENDING;
             return (0u);
         }
@@ -3815,6 +5282,18 @@ static  CPU_INT32U  USBD_EP_Rx (USBD_DRV         *p_drv,
 
     if (async_fnct != (USBD_ASYNC_FNCT)0) {                     /* -------------------- ASYNC XFER -------------------- */
         p_urb->State    = USBD_URB_STATE_XFER_ASYNC;
+#if (USBD_CFG_EP_PRE_QUEUE_EN == DEF_ENABLED)
+        if ((p_ep->URB_PendPtr           != (USBD_URB *)0) ||   /* Hold URB if drv cannot take it now (see Note #5).    */
+            (USBD_EP_URB_SubmitRdy(p_ep) == DEF_NO)) {
+            if (p_ep->URB_PendPtr == (USBD_URB *)0) {
+                p_ep->URB_PendPtr = p_urb;
+            }
+            USBD_URB_Queue(p_ep, p_urb);
+            USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, RxAsyncSuccessNbr);
+           *p_err = USBD_ERR_NONE;
+            return (0u);
+        }
+#endif
         prev_xfer_state = p_ep->XferState;                      /* Keep prev XferState, to restore in case of err.      */
         p_ep->XferState = USBD_XFER_STATE_ASYNC;                /* Set XferState before submitting the xfer.            */
 
@@ -3826,6 +5305,9 @@ static  CPU_INT32U  USBD_EP_Rx (USBD_DRV         *p_drv,
                                     p_err);
         if (*p_err == USBD_ERR_NONE) {
             USBD_URB_Queue(p_ep, p_urb);                        /* If no err, queue URB.                                */
+#if (USBD_CFG_EP_PRE_QUEUE_EN == DEF_ENABLED)
+            p_ep->URB_SubmitCnt++;
+#endif
             USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, RxAsyncSuccessNbr);
         } else {
             p_ep->XferState = prev_xfer_state;                  /* If an err occured, restore prev XferState.           */
@@ -3850,6 +5332,8 @@ static  CPU_INT32U  USBD_EP_Rx (USBD_DRV         *p_drv,
         p_buf_cur = &p_urb->BufPtr[p_urb->XferLen];
 
         USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, DrvRxStartNbr);
+        USBD_URB_LAT_DRV_START(p_urb);
+        USBD_EP_CAPTURE_SUBMIT(p_drv->DevNbr, p_ep, p_urb);
         p_urb->NextXferLen = p_drv_api->EP_RxStart(p_drv,
                                                    p_ep->Addr,
                                                    p_buf_cur,
@@ -3860,15 +5344,15 @@ static  CPU_INT32U  USBD_EP_Rx (USBD_DRV         *p_drv,
         }
         USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, DrvRxStartSuccessNbr);
 
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,                   /* Unlock before pending on completion. See Note #3.    */
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,                      /* Unlock before pending on completion. See Note #3.    */
+                            p_ep->Ix);
 
         USBD_OS_EP_SignalPend(p_drv->DevNbr, p_ep->Ix, timeout_ms, p_err);
 
-        USBD_OS_EP_LockAcquire(p_drv->DevNbr,                   /* Re-lock EP after xfer completion. See Note #3.       */
-                               p_ep->Ix,
-                               0u,
-                              &local_err);
+        USBD_EP_LockAcquire(p_drv->DevNbr,                      /* Re-lock EP after xfer completion. See Note #3.       */
+                            p_ep->Ix,
+                            0u,
+                           &local_err);
 
         if (*p_err == USBD_ERR_OS_TIMEOUT) {
             p_drv_api->EP_Abort(p_drv, p_ep->Addr);
@@ -3908,6 +5392,13 @@ static  CPU_INT32U  USBD_EP_Rx (USBD_DRV         *p_drv,
 
     xfer_tot = p_urb->XferLen;
 
+#if (USBD_EP_LAT_EN == DEF_ENABLED)
+    if (*p_err == USBD_ERR_NONE) {
+        USBD_EP_LatRecord(p_drv->DevNbr, p_ep, p_urb);
+    }
+#endif
+    USBD_EP_CAPTURE_CMPL(p_drv->DevNbr, p_ep, p_urb, *p_err);
+
     USBD_URB_Dequeue(p_ep);
 
     USBD_URB_Free(p_drv->DevNbr, p_ep, p_urb);
@@ -3983,6 +5474,11 @@ static  CPU_INT32U  USBD_EP_Rx (USBD_DRV         *p_drv,
 *                   completion to be able to abort. Since the endpoint is already locked when this
 *                   function is called (see callers functions), it releases the lock before pending and
 *                   re-locks once the transfer completes.
+*
+*               (5) If USBD_CFG_EP_PRE_QUEUE_EN is DEF_ENABLED, an asynchronous URB that cannot be
+*                   submitted to the driver right away is held in the endpoint's URB list. It will be
+*                   submitted by USBD_EP_XferAsyncProcess() and any submission error will be reported
+*                   through the URB's callback.
 *********************************************************************************************************
 */
 
@@ -4020,8 +5516,12 @@ static  CPU_INT32U  USBD_EP_Tx (USBD_DRV         *p_drv,
         }
     } else {
         USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, TxAsyncExecNbr);
+#if (USBD_CFG_EP_PRE_QUEUE_EN == DEF_ENABLED)
+        if (p_ep->XferState == USBD_XFER_STATE_SYNC) {          /* Partial xfer does not block queuing (see Note #5).   */
+#else
         if ((p_ep->XferState != USBD_XFER_STATE_NONE) &&
             (p_ep->XferState != USBD_XFER_STATE_ASYNC)) {
+#endif
            *p_err = USBD_ERR_EP_IO_PENDING;
             return (0u);
         }
@@ -4050,6 +5550,18 @@ static  CPU_INT32U  USBD_EP_Tx (USBD_DRV         *p_drv,
 
     if (async_fnct != (USBD_ASYNC_FNCT)0) {                     /* -------------------- ASYNC XFER -------------------- */
         p_urb->State    = USBD_URB_STATE_XFER_ASYNC;
+#if (USBD_CFG_EP_PRE_QUEUE_EN == DEF_ENABLED)
+        if ((p_ep->URB_PendPtr           != (USBD_URB *)0) ||   /* Hold URB if drv cannot take it now (see Note #5).    */
+            (USBD_EP_URB_SubmitRdy(p_ep) == DEF_NO)) {
+            if (p_ep->URB_PendPtr == (USBD_URB *)0) {
+                p_ep->URB_PendPtr = p_urb;
+            }
+            USBD_URB_Queue(p_ep, p_urb);
+            USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, TxAsyncSuccessNbr);
+           *p_err = USBD_ERR_NONE;
+            return (0u);
+        }
+#endif
         prev_xfer_state = p_ep->XferState;                      /* Keep prev XferState, to restore in case of err.      */
         p_ep->XferState = USBD_XFER_STATE_ASYNC;                /* Set XferState before submitting the xfer.            */
 
@@ -4061,6 +5573,9 @@ static  CPU_INT32U  USBD_EP_Tx (USBD_DRV         *p_drv,
                                p_err);
         if (*p_err == USBD_ERR_NONE) {
             USBD_URB_Queue(p_ep, p_urb);                        /* If no err, queue URB.                                */
+#if (USBD_CFG_EP_PRE_QUEUE_EN == DEF_ENABLED)
+            p_ep->URB_SubmitCnt++;
+#endif
             USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, TxAsyncSuccessNbr);
         } else {
             p_ep->XferState = prev_xfer_state;                  /* If an err occured, restore prev XferState.           */
@@ -4091,6 +5606,8 @@ static  CPU_INT32U  USBD_EP_Tx (USBD_DRV         *p_drv,
         }
 
         USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, DrvTxNbr);
+        USBD_URB_LAT_DRV_START(p_urb);
+        USBD_EP_CAPTURE_SUBMIT(p_drv->DevNbr, p_ep, p_urb);
         p_urb->NextXferLen = p_drv_api->EP_Tx(p_drv,
                                               p_ep->Addr,
                                               p_buf_cur,
@@ -4113,15 +5630,15 @@ static  CPU_INT32U  USBD_EP_Tx (USBD_DRV         *p_drv,
         }
         USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, DrvTxStartSuccessNbr);
 
-        USBD_OS_EP_LockRelease(p_drv->DevNbr,                   /* Unlock before pending on completion. See Note #4.    */
-                               p_ep->Ix);
+        USBD_EP_LockRelease(p_drv->DevNbr,                      /* Unlock before pending on completion. See Note #4.    */
+                            p_ep->Ix);
 
         USBD_OS_EP_SignalPend(p_drv->DevNbr, p_ep->Ix, timeout_ms, p_err);
 
-        USBD_OS_EP_LockAcquire(p_drv->DevNbr,                   /* Re-lock EP after xfer completion. See Note #4.       */
-                               p_ep->Ix,
-                               0u,
-                              &local_err);
+        USBD_EP_LockAcquire(p_drv->DevNbr,                      /* Re-lock EP after xfer completion. See Note #4.       */
+                            p_ep->Ix,
+                            0u,
+                           &local_err);
 
         if (*p_err == USBD_ERR_OS_TIMEOUT) {
             p_drv_api->EP_Abort(p_drv, p_ep->Addr);
@@ -4152,21 +5669,28 @@ static  CPU_INT32U  USBD_EP_Tx (USBD_DRV         *p_drv,
         if (*p_err == USBD_ERR_NONE) {
             USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, DrvTxZLP_SuccessNbr);
 
-            USBD_OS_EP_LockRelease(p_drv->DevNbr,               /* Unlock before pending on completion. See Note #4.    */
-                                   p_ep->Ix);
+            USBD_EP_LockRelease(p_drv->DevNbr,                  /* Unlock before pending on completion. See Note #4.    */
+                                p_ep->Ix);
 
             USBD_OS_EP_SignalPend(p_drv->DevNbr, p_ep->Ix, timeout_ms, p_err);
 
-            USBD_OS_EP_LockAcquire(p_drv->DevNbr,               /* Re-lock EP after xfer completion. See Note #4.       */
-                                   p_ep->Ix,
-                                   0u,
-                                  &local_err);
+            USBD_EP_LockAcquire(p_drv->DevNbr,                  /* Re-lock EP after xfer completion. See Note #4.       */
+                                p_ep->Ix,
+                                0u,
+                               &local_err);
             if (local_err != USBD_ERR_NONE) {
                *p_err = USBD_ERR_OS_FAIL;
             }
         }
     }
 
+#if (USBD_EP_LAT_EN == DEF_ENABLED)
+    if (*p_err == USBD_ERR_NONE) {
+        USBD_EP_LatRecord(p_drv->DevNbr, p_ep, p_urb);
+    }
+#endif
+    USBD_EP_CAPTURE_CMPL(p_drv->DevNbr, p_ep, p_urb, *p_err);
+
     USBD_URB_Dequeue(p_ep);
 
     USBD_URB_Free(p_drv->DevNbr, p_ep, p_urb);
@@ -4179,144 +5703,1447 @@ static  CPU_INT32U  USBD_EP_Tx (USBD_DRV         *p_drv,
 
 /*
 *********************************************************************************************************
-*                                        USBD_EP_URB_Abort()
+*                                        USBD_EP_VecXferAsync()
 *
-* Description : Aborts endpoint's URB(s). Does not free the URB(s), see Note #1.
+* Description : Queue a vectored asynchronous transfer on a bulk or interrupt endpoint.
 *
-* Argument(s) : p_drv       Pointer to device driver structure.
-*               ----        Argument checked by caller.
+* Argument(s) : p_drv           Pointer to device driver structure.
+*               -----           Argument checked by caller.
 *
-*               p_ep        Pointer to endpoint on which data will be sent.
-*               ----        Argument checked by caller.
-
-*               p_err       Pointer to variable that will receive return error code from this function :
-*               ----        Argument checked by caller.
+*               p_ep            Pointer to endpoint on which data will be transferred.
+*               ----            Argument checked by caller.
 *
-*                               USBD_ERR_NONE               URB successfully aborted.
-*                               USBD_ERR_EP_ABORT           Device driver abort endpoint failed.
+*               p_seg_tbl       Pointer to table of buffer segments.
 *
-*                               - RETURNED BY USBD_OS_EP_SignalAbort() -
-*                               See USBD_OS_EP_SignalAbort() for additional return error codes.
+*               seg_nbr         Number of segments in 'p_seg_tbl'.
 *
-* Return(s)   : Pointer to head of completed URB list, if asynchronous transfer in progress.
+*               async_fnct      Function that will be invoked upon completion of the transfer.
+*               ----------      Argument checked by caller.
 *
-*               Pointer to NULL,                       otherwise.
+*               p_async_arg     Pointer to argument that will be passed as parameter of 'async_fnct'.
 *
-* Note(s)     : (1) If a synchronous transfer was in progress, a single URB was aborted and must be
-*                   freed by calling  USBD_URB_Free(). If an asynchronous transfer was in progress, it
-*                   is possible that multiple URBs were aborted and must be freed by calling
-*                   USBD_URB_AsyncEnd() with the pointer to the head of the aborted URB(s) list returned
-*                   by this function as a parameter.
+*               end             End-of-transfer flag (IN endpoint only).
 *
-*               (2) Endpoint must be locked when calling this function.
-*********************************************************************************************************
-*/
-
-static  USBD_URB  *USBD_EP_URB_Abort (USBD_DRV  *p_drv,
+*               p_err           Pointer to variable that will receive return error code from this function :
+*               -----           Argument checked by caller.
+*
+*                                   USBD_ERR_NONE               Transfer successfully queued.
+*                                   USBD_ERR_NULL_PTR           Null pointer passed as argument.
+*                                   USBD_ERR_INVALID_ARG        Invalid number of segments.
+*                                   USBD_ERR_ALLOC              Endpoint packet buffer could not be allocated.
+*                                   USBD_ERR_EP_IO_PENDING      Transfer already in progress on endpoint.
+*
+*                                   - RETURNED BY USBD_URB_Get() -
+*                                   See USBD_URB_Get() for additional return error codes.
+*
+*                                   - RETURNED BY USBD_EP_TxAsyncProcess() -
+*                                   See USBD_EP_TxAsyncProcess() for additional return error codes.
+*
+*                                   - RETURNED BY USBD_EP_RxStartAsyncProcess() -
+*                                   See USBD_EP_RxStartAsyncProcess() for additional return error codes.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Endpoint must be locked when calling this function.
+*
+*               (2) The endpoint's packet buffer is allocated from the heap the first time a vectored
+*                   transfer is queued on the endpoint and reused afterwards (see 'usbd_cfg.h
+*                   USB DEVICE INTERFACES CONFIGURATION  Note #4').
+*
+*               (3) See USBD_EP_Rx() Note #5 and USBD_EP_Tx() Note #5.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_EP_VEC_XFER_EN == DEF_ENABLED)
+static  void  USBD_EP_VecXferAsync (USBD_DRV         *p_drv,
+                                    USBD_EP          *p_ep,
+                                    USBD_BUF_SEG     *p_seg_tbl,
+                                    CPU_INT08U        seg_nbr,
+                                    USBD_ASYNC_FNCT   async_fnct,
+                                    void             *p_async_arg,
+                                    CPU_BOOLEAN       end,
+                                    USBD_ERR         *p_err)
+{
+    USBD_URB         *p_urb;
+    USBD_XFER_STATE   prev_xfer_state;
+    CPU_BOOLEAN       ep_dir_in;
+    CPU_INT32U        buf_len;
+    CPU_INT08U        seg_ix;
+    LIB_ERR           err_lib;
+
+
+    if (p_seg_tbl == (USBD_BUF_SEG *)0) {
+       *p_err = USBD_ERR_NULL_PTR;
+        return;
+    }
+
+    if (seg_nbr == 0u) {
+       *p_err = USBD_ERR_INVALID_ARG;
+        return;
+    }
+
+    buf_len = 0u;                                               /* Compute total xfer len.                              */
+    for (seg_ix = 0u; seg_ix < seg_nbr; seg_ix++) {
+        if ((p_seg_tbl[seg_ix].BufLen !=         0u) &&
+            (p_seg_tbl[seg_ix].BufPtr == (void *)0)) {
+           *p_err = USBD_ERR_NULL_PTR;
+            return;
+        }
+        buf_len += p_seg_tbl[seg_ix].BufLen;
+    }
+
+    ep_dir_in = USBD_EP_IS_IN(p_ep->Addr);
+    if (ep_dir_in == DEF_YES) {
+        USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, TxAsyncExecNbr);
+    } else {
+        USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, RxAsyncExecNbr);
+    }
+
+#if (USBD_CFG_EP_PRE_QUEUE_EN == DEF_ENABLED)
+    if (p_ep->XferState == USBD_XFER_STATE_SYNC) {              /* See Note #3.                                         */
+#else
+    if ((p_ep->XferState != USBD_XFER_STATE_NONE) &&
+        (p_ep->XferState != USBD_XFER_STATE_ASYNC)) {
+#endif
+       *p_err = USBD_ERR_EP_IO_PENDING;
+        return;
+    }
+
+    if (p_ep->MaxPktSize > USBD_CFG_EP_VEC_BUF_LEN) {           /* Pkt buf must hold a full pkt.                        */
+       *p_err = USBD_ERR_ALLOC;
+        return;
+    }
+                                                                /* Alloc EP pkt buf on first use (see Note #2).         */
+    if (USBD_EP_VecBufTbl[p_drv->DevNbr][p_ep->Ix] == (CPU_INT08U *)0) {
+        USBD_EP_VecBufTbl[p_drv->DevNbr][p_ep->Ix] = (CPU_INT08U *)Mem_HeapAlloc(              USBD_CFG_EP_VEC_BUF_LEN,
+                                                                                               USBD_CFG_BUF_ALIGN_OCTETS,
+                                                                                 (CPU_SIZE_T *)DEF_NULL,
+                                                                                              &err_lib);
+        if (err_lib != LIB_MEM_ERR_NONE) {
+           *p_err = USBD_ERR_ALLOC;
+            return;
+        }
+    }
+
+    p_urb = USBD_URB_Get(p_drv->DevNbr, p_ep, p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    p_urb->BufPtr       = (CPU_INT08U *)p_seg_tbl;              /* Init 'p_urb' fields.                                 */
+    p_urb->BufLen       =  buf_len;
+    p_urb->XferLen      =  0u;
+    p_urb->NextXferLen  =  0u;
+    p_urb->AsyncFnct    =  async_fnct;
+    p_urb->AsyncFnctArg =  p_async_arg;
+    p_urb->Err          =  USBD_ERR_NONE;
+    p_urb->NextPtr      = (USBD_URB *)0;
+    p_urb->SegNbr       =  seg_nbr;
+    p_urb->SegIx        =  0u;
+    p_urb->SegOffset    =  0u;
+    p_urb->SegBufPtr    = (CPU_INT08U *)0;
+    p_urb->SegStraddle  =  DEF_NO;
+    p_urb->State        =  USBD_URB_STATE_XFER_ASYNC;
+    DEF_BIT_SET(p_urb->Flags, USBD_URB_FLAG_VEC);
+    if ((ep_dir_in == DEF_YES) &&
+        (end       == DEF_YES)) {
+        DEF_BIT_SET(p_urb->Flags, USBD_URB_FLAG_XFER_END);
+    }
+
+#if (USBD_CFG_EP_PRE_QUEUE_EN == DEF_ENABLED)
+    if ((p_ep->URB_PendPtr           != (USBD_URB *)0) ||       /* Hold URB if drv cannot take it now.                  */
+        (USBD_EP_URB_SubmitRdy(p_ep) == DEF_NO)) {
+        if (p_ep->URB_PendPtr == (USBD_URB *)0) {
+            p_ep->URB_PendPtr = p_urb;
+        }
+        USBD_URB_Queue(p_ep, p_urb);
+       *p_err = USBD_ERR_NONE;
+        return;
+    }
+#endif
+
+    prev_xfer_state = p_ep->XferState;                          /* Keep prev XferState, to restore in case of err.      */
+    p_ep->XferState = USBD_XFER_STATE_ASYNC;                    /* Set XferState before submitting the xfer.            */
+
+    if (ep_dir_in == DEF_YES) {
+        USBD_EP_TxAsyncProcess(p_drv,                           /* Buf and len computed from segs.                      */
+                               p_ep,
+                               p_urb,
+                               (CPU_INT08U *)0,
+                               0u,
+                               p_err);
+    } else {
+        USBD_EP_RxStartAsyncProcess(p_drv,
+                                    p_ep,
+                                    p_urb,
+                                    (CPU_INT08U *)0,
+                                    0u,
+                                    p_err);
+    }
+
+    if (*p_err == USBD_ERR_NONE) {
+        USBD_URB_Queue(p_ep, p_urb);                            /* If no err, queue URB.                                */
+#if (USBD_CFG_EP_PRE_QUEUE_EN == DEF_ENABLED)
+        p_ep->URB_SubmitCnt++;
+#endif
+        if (ep_dir_in == DEF_YES) {
+            USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, TxAsyncSuccessNbr);
+        } else {
+            USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, RxAsyncSuccessNbr);
+        }
+    } else {
+        p_ep->XferState = prev_xfer_state;                      /* If an err occured, restore prev XferState.           */
+        USBD_URB_Free(p_drv->DevNbr, p_ep, p_urb);              /* Free URB.                                            */
+    }
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_EP_XferAsyncCmpl()
+*
+* Description : Read/write data asynchronously from/to non-control endpoints.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*               ----        Argument checked by caller.
+*
+*               p_ep        Pointer to endpoint structure.
+*               ----        Argument checked by caller.
+*
+*               xfer_err    Error code returned by the USB device driver.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) A USB device driver can notify the core about the Tx transfer completion using
+*                   USBD_EP_TxCmpl() or USBD_EP_TxCmplExt(). The latter function allows to report a
+*                   specific error code whereas USBD_EP_TxCmpl() reports only a successful transfer.
+*                   In the case of an asynchronous transfer, the error code reported by the USB device
+*                   driver must be tested. In case of an error condition, the asynchronous transfer
+*                   is marked as completed and the associated callback is called by the core task, or
+*                   from the driver's ISR if the completion is processed directly.
+*
+*               (2) This condition covers also the case where the transfer length is multiple of the
+*                   maximum packet size. In that case, host sends a zero-length packet considered as
+*                   a short packet for the condition.
+*
+*               (3) When pre-queuing is enabled, the URB(s) following the head URB may already be in the
+*                   controller and the bus keeps moving while this function runs. URB(s) held by the core
+*                   are submitted here, before the completion callback is executed.
+*********************************************************************************************************
+*/
+
+static  void  USBD_EP_XferAsyncCmpl (USBD_DRV  *p_drv,
+                                    USBD_EP   *p_ep,
+                                    USBD_ERR   xfer_err)
+{
+    USBD_DRV_API  *p_drv_api;
+    CPU_BOOLEAN    ep_dir_in;
+    USBD_ERR       local_err;
+    USBD_URB      *p_urb;
+    USBD_URB      *p_urb_cmpl;
+#if (USBD_CFG_EP_PRE_QUEUE_EN == DEF_ENABLED)
+    USBD_URB      *p_urb_err;
+#endif
+    CPU_INT08U    *p_buf_cur;
+    CPU_INT32U     xfer_len;
+    CPU_INT32U     xfer_rem;
+
+
+    p_drv_api = p_drv->API_Ptr;
+    ep_dir_in = USBD_EP_IS_IN(p_ep->Addr);
+
+    USBD_EP_LockAcquire(p_drv->DevNbr,
+                        p_ep->Ix,
+                        0u,
+                       &local_err);
+    if (local_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    if (p_ep->XferState == USBD_XFER_STATE_NONE) {
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
+        return;
+    }
+
+    p_urb = p_ep->URB_HeadPtr;
+    if (p_urb == (USBD_URB *)0) {
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
+        USBD_DBG_EP("USBD_EP_Process(): no URB to process", p_ep->Addr);
+        return;
+    }
+
+    if ((p_urb->State == USBD_URB_STATE_IDLE) ||
+        (p_urb->State == USBD_URB_STATE_XFER_SYNC)) {
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
+        USBD_DBG_EP("USBD_EP_Process(): incorrect URB state", p_ep->Addr);
+        return;
+    }
+
+#if (USBD_CFG_EP_PRE_QUEUE_EN == DEF_ENABLED)
+    if (p_urb == p_ep->URB_PendPtr) {                           /* Head URB not submitted to drv yet.                   */
+        USBD_EP_LockRelease(p_drv->DevNbr,
+                            p_ep->Ix);
+        USBD_DBG_EP("USBD_EP_Process(): URB not submitted", p_ep->Addr);
+        return;
+    }
+#endif
+
+    p_urb_cmpl = (USBD_URB *)0;
+    if (xfer_err == USBD_ERR_NONE) {                            /* See Note #1.                                         */
+        xfer_rem   =  p_urb->BufLen - p_urb->XferLen;
+        p_buf_cur  = &p_urb->BufPtr[p_urb->XferLen];
+
+        if (ep_dir_in == DEF_YES) {                             /* ------------------- IN TRANSFER -------------------- */
+            if (xfer_rem > 0u) {                                /* Another transaction must be done.                    */
+                USBD_EP_TxAsyncProcess(p_drv,
+                                       p_ep,
+                                       p_urb,
+                                       p_buf_cur,
+                                       xfer_rem,
+                                      &local_err);
+                if (local_err != USBD_ERR_NONE) {
+                    p_urb_cmpl = USBD_URB_AsyncCmpl(p_ep, local_err);
+                }
+            } else if ((DEF_BIT_IS_SET(p_urb->Flags, USBD_URB_FLAG_XFER_END) == DEF_YES) &&
+                       (p_urb->XferLen % p_ep->MaxPktSize                    == 0u)      &&
+                       (p_urb->XferLen                                       != 0u)) {
+                                                                /* $$$$ This case should be tested more thoroughly.     */
+                                                                /* Send ZLP if needed, at end of xfer.                  */
+                DEF_BIT_CLR(p_urb->Flags, USBD_URB_FLAG_XFER_END);
+
+                USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, DrvTxZLP_Nbr);
+
+                p_drv_api->EP_TxZLP(p_drv, p_ep->Addr, &local_err);
+                if (local_err != USBD_ERR_NONE) {
+                    p_urb_cmpl = USBD_URB_AsyncCmpl(p_ep, local_err);
+                }
+                USBD_DBG_STATS_EP_INC_IF_TRUE(p_drv->DevNbr, p_ep->Ix, DrvTxZLP_Nbr, (local_err == USBD_ERR_NONE));
+            } else {                                            /* Xfer is completed.                                   */
+                p_urb_cmpl = USBD_URB_AsyncCmpl(p_ep, USBD_ERR_NONE);
+            }
+        } else {                                                /* ------------------- OUT TRANSFER ------------------- */
+            USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, DrvRxNbr);
+#if (USBD_CFG_EP_VEC_XFER_EN == DEF_ENABLED)
+            if (DEF_BIT_IS_SET(p_urb->Flags, USBD_URB_FLAG_VEC) == DEF_YES) {
+                p_buf_cur = p_urb->SegBufPtr;                   /* Vectored xfer rx'd in its own transaction buf.       */
+            }
+#endif
+
+            xfer_len = p_drv_api->EP_Rx(p_drv,
+                                        p_ep->Addr,
+                                        p_buf_cur,
+                                        p_urb->NextXferLen,
+                                       &local_err);
+            if (local_err != USBD_ERR_NONE) {
+                p_urb_cmpl = USBD_URB_AsyncCmpl(p_ep, local_err);
+            } else {
+                USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, DrvRxSuccessNbr);
+
+#if (USBD_CFG_EP_VEC_XFER_EN == DEF_ENABLED)
+                if (DEF_BIT_IS_SET(p_urb->Flags, USBD_URB_FLAG_VEC) == DEF_YES) {
+                    if (xfer_len > p_urb->NextXferLen) {        /* Never scatter more than what was expected.           */
+                        xfer_len = p_urb->NextXferLen;
+                    }
+                    if (p_urb->SegStraddle == DEF_YES) {        /* Scatter straddle pkt into segs.                      */
+                        USBD_URB_VecCopy(p_urb, p_buf_cur, xfer_len, DEF_NO);
+                    }
+                    USBD_URB_VecAdvance(p_urb, xfer_len);
+                }
+#endif
+
+                p_urb->XferLen += xfer_len;
+
+                if ((xfer_len       == 0u)                 ||   /* Rx'd a ZLP.                                          */
+                    (xfer_len       <  p_urb->NextXferLen) ||   /* Rx'd a short pkt (see Note #2).                      */
+                    (p_urb->XferLen == p_urb->BufLen)) {        /* All bytes rx'd.                                      */
+                                                                /* Xfer finished.                                       */
+                    p_urb_cmpl = USBD_URB_AsyncCmpl(p_ep, USBD_ERR_NONE);
+                } else {
+                    p_buf_cur = &p_urb->BufPtr[p_urb->XferLen]; /* Xfer not finished.                                   */
+                    xfer_len  =  p_urb->BufLen - p_urb->XferLen;
+
+                    USBD_EP_RxStartAsyncProcess(p_drv,
+                                                p_ep,
+                                                p_urb,
+                                                p_buf_cur,
+                                                xfer_len,
+                                               &local_err);
+                    if (local_err != USBD_ERR_NONE) {
+                        p_urb_cmpl = USBD_URB_AsyncCmpl(p_ep, local_err);
+                    }
+                }
+            }
+        }
+    } else {
+        p_urb_cmpl = USBD_URB_AsyncCmpl(p_ep, xfer_err);
+    }
+
+#if (USBD_CFG_EP_PRE_QUEUE_EN == DEF_ENABLED)
+    p_urb_err = USBD_EP_URB_Submit(p_drv, p_ep);                /* Submit held URB(s) if drv has room (see Note #3).    */
+    if (p_urb_cmpl == (USBD_URB *)0) {
+        p_urb_cmpl = p_urb_err;
+    } else {
+        p_urb_cmpl->NextPtr = p_urb_err;                        /* Callbacks are executed in URB queuing order.         */
+    }
+#endif
+
+    USBD_EP_LockRelease(p_drv->DevNbr,
+                        p_ep->Ix);
+
+    if (p_urb_cmpl != (USBD_URB *)0) {
+        USBD_URB_AsyncEnd(p_drv->DevNbr, p_ep, p_urb_cmpl);     /* Execute callback and free aborted URB(s), if any.    */
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                      USBD_EP_XferDirectCmpl()
+*
+* Description : Process an asynchronous transfer completion from the driver's ISR.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*               ----        Argument checked by caller.
+*
+*               p_ep        Pointer to endpoint structure.
+*               ----        Argument checked by caller.
+*
+*               xfer_err    Error code returned by the USB device driver.
+*
+* Return(s)   : DEF_YES, if the completion has been processed.
+*
+*               DEF_NO,  if the completion must be queued to the core task.
+*
+* Note(s)     : (1) The completion is deferred to the core task if:
+*
+*                   (a) Direct completion is not enabled on the endpoint.
+*
+*                   (b) A task currently holds the endpoint lock. The ISR cannot pend on the lock and the
+*                       task may be in the middle of updating the endpoint's URB list.
+*
+*                   (c) A previous completion of this endpoint is still queued to the core task.
+*
+*                   (d) The ISR is already processing a completion of this endpoint. This happens if the
+*                       driver notifies a completion from a transfer submitted by a direct callback.
+*
+*               (2) The ISR owns the endpoint while the completion is processed, including the callback
+*                   execution. The callback can queue a new transfer on the same endpoint without taking
+*                   the endpoint OS lock (see USBD_EP_LockAcquire()).
+*
+*               (3) This function relies on the ISR not running at the same time as a task. Tasks that hold
+*                   the endpoint lock cannot run before it returns, and no task can observe the endpoint
+*                   owned by the ISR (see USBD_EP_LockAcquire() Note #1). Direct completion is therefore
+*                   restricted to single-core, ISR-based ports (see 'usbd_cfg.h' Note #2c).
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_EP_DIRECT_CMPL_EN == DEF_ENABLED)
+static  CPU_BOOLEAN  USBD_EP_XferDirectCmpl (USBD_DRV  *p_drv,
+                                             USBD_EP   *p_ep,
+                                             USBD_ERR   xfer_err)
+{
+    CPU_SR_ALLOC();
+
+
+    CPU_CRITICAL_ENTER();
+    if (p_ep->DirectCmplEn == DEF_DISABLED) {                   /* See Note #1a.                                        */
+        CPU_CRITICAL_EXIT();
+        return (DEF_NO);
+    }
+
+    if ((p_ep->LockHeld           == DEF_YES) ||                /* See Note #1b.                                        */
+        (p_ep->DirectCmplDeferCnt >  0u)      ||                /* See Note #1c.                                        */
+        (p_ep->DirectCmplActive   == DEF_YES)) {                /* See Note #1d.                                        */
+        p_ep->DirectCmplDeferCnt++;
+        CPU_CRITICAL_EXIT();
+        USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, DirectCmplDeferNbr);
+        return (DEF_NO);
+    }
+
+    p_ep->DirectCmplActive = DEF_YES;                           /* ISR owns EP (see Note #2).                           */
+    CPU_CRITICAL_EXIT();
+
+    USBD_DBG_STATS_EP_INC(p_drv->DevNbr, p_ep->Ix, DirectCmplNbr);
+
+    USBD_EP_XferAsyncCmpl(p_drv, p_ep, xfer_err);
+
+    CPU_CRITICAL_ENTER();
+    p_ep->DirectCmplActive = DEF_NO;
+    CPU_CRITICAL_EXIT();
+
+    return (DEF_YES);
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_EP_XferCmplDefer()
+*
+* Description : Queue an asynchronous transfer completion that was not processed from the driver's ISR to
+*               the core task.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*               ----        Argument checked by caller.
+*
+*               p_ep        Pointer to endpoint structure.
+*               ----        Argument checked by caller.
+*
+*               xfer_err    Error code returned by the USB device driver.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) USBD_EP_XferDirectCmpl() counts the completion in 'DirectCmplDeferCnt' when direct
+*                   completion is enabled on the endpoint. If no core event is available, the completion
+*                   is dropped and never reaches USBD_EP_XferAsyncProcess(), so the count is undone here.
+*                   Otherwise, direct completion would stay disabled on the endpoint until it is reopened.
+*********************************************************************************************************
+*/
+
+static  void  USBD_EP_XferCmplDefer (USBD_DRV  *p_drv,
+                                     USBD_EP   *p_ep,
+                                     USBD_ERR   xfer_err)
+{
+    CPU_BOOLEAN  queued;
+    CPU_SR_ALLOC();
+
+
+    queued = USBD_EventEP(p_drv, p_ep->Addr, xfer_err);
+    if (queued == DEF_OK) {
+        return;
+    }
+
+    CPU_CRITICAL_ENTER();                                       /* See Note #1.                                         */
+    if ((p_ep->DirectCmplEn       == DEF_ENABLED) &&
+        (p_ep->DirectCmplDeferCnt >  0u)) {
+        p_ep->DirectCmplDeferCnt--;
+    }
+    CPU_CRITICAL_EXIT();
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_EP_LockAcquire()
+*
+* Description : Acquire endpoint lock.
+*
+* Argument(s) : dev_nbr     Device number.
+*               -------     Argument checked by caller.
+*
+*               ep_ix       Endpoint index.
+*               -----       Argument checked by caller.
+*
+*               timeout_ms  Lock wait timeout in milliseconds.
+*
+*               p_err       Pointer to variable that will receive return error code from this function :
+*
+*                               USBD_ERR_NONE   Endpoint lock successfully acquired.
+*
+*                               - RETURNED BY USBD_OS_EP_LockAcquire() -
+*                               See USBD_OS_EP_LockAcquire() for additional return error codes.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) If the endpoint is owned by the ISR processing a direct completion, the caller runs
+*                   from that completion's callback, since no task can run until the ISR returns (see
+*                   USBD_EP_XferDirectCmpl() Note #3). The OS lock is not taken (see
+*                   USBD_EP_XferDirectCmpl() Note #2).
+*
+*               (2) The flag is cleared before the OS lock is released, so that it is never cleared after
+*                   another task has acquired the lock.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_EP_DIRECT_CMPL_EN == DEF_ENABLED)
+static  void  USBD_EP_LockAcquire (CPU_INT08U   dev_nbr,
+                                   CPU_INT08U   ep_ix,
+                                   CPU_INT16U   timeout_ms,
+                                   USBD_ERR    *p_err)
+{
+    USBD_EP  *p_ep;
+    CPU_SR_ALLOC();
+
+
+    p_ep = &USBD_EP_Tbl[dev_nbr][ep_ix];
+    if (p_ep->DirectCmplActive == DEF_YES) {                    /* See Note #1.                                         */
+       *p_err = USBD_ERR_NONE;
+        return;
+    }
+
+    USBD_OS_EP_LockAcquire(dev_nbr,
+                           ep_ix,
+                           timeout_ms,
+                           p_err);
+    if (*p_err != USBD_ERR_NONE) {
+        return;
+    }
+
+    CPU_CRITICAL_ENTER();
+    p_ep->LockHeld = DEF_YES;
+    CPU_CRITICAL_EXIT();
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_EP_LockRelease()
+*
+* Description : Release endpoint lock.
+*
+* Argument(s) : dev_nbr     Device number.
+*               -------     Argument checked by caller.
+*
+*               ep_ix       Endpoint index.
+*               -----       Argument checked by caller.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) See USBD_EP_LockAcquire() Note #1.
+*
+*               (2) See USBD_EP_LockAcquire() Note #2.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_EP_DIRECT_CMPL_EN == DEF_ENABLED)
+static  void  USBD_EP_LockRelease (CPU_INT08U  dev_nbr,
+                                   CPU_INT08U  ep_ix)
+{
+    USBD_EP  *p_ep;
+    CPU_SR_ALLOC();
+
+
+    p_ep = &USBD_EP_Tbl[dev_nbr][ep_ix];
+    if (p_ep->DirectCmplActive == DEF_YES) {                    /* See Note #1.                                         */
+        return;
+    }
+
+    CPU_CRITICAL_ENTER();                                       /* See Note #2.                                         */
+    p_ep->LockHeld = DEF_NO;
+    CPU_CRITICAL_EXIT();
+
+    USBD_OS_EP_LockRelease(dev_nbr, ep_ix);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_EP_URB_Abort()
+*
+* Description : Aborts endpoint's URB(s). Does not free the URB(s), see Note #1.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*               ----        Argument checked by caller.
+*
+*               p_ep        Pointer to endpoint on which data will be sent.
+*               ----        Argument checked by caller.
+
+*               p_err       Pointer to variable that will receive return error code from this function :
+*               ----        Argument checked by caller.
+*
+*                               USBD_ERR_NONE               URB successfully aborted.
+*                               USBD_ERR_EP_ABORT           Device driver abort endpoint failed.
+*
+*                               - RETURNED BY USBD_OS_EP_SignalAbort() -
+*                               See USBD_OS_EP_SignalAbort() for additional return error codes.
+*
+* Return(s)   : Pointer to head of completed URB list, if asynchronous transfer in progress.
+*
+*               Pointer to NULL,                       otherwise.
+*
+* Note(s)     : (1) If a synchronous transfer was in progress, a single URB was aborted and must be
+*                   freed by calling  USBD_URB_Free(). If an asynchronous transfer was in progress, it
+*                   is possible that multiple URBs were aborted and must be freed by calling
+*                   USBD_URB_AsyncEnd() with the pointer to the head of the aborted URB(s) list returned
+*                   by this function as a parameter.
+*
+*               (2) Endpoint must be locked when calling this function.
+*********************************************************************************************************
+*/
+
+static  USBD_URB  *USBD_EP_URB_Abort (USBD_DRV  *p_drv,
                                       USBD_EP   *p_ep,
                                       USBD_ERR  *p_err)
 {
-    USBD_DRV_API  *p_drv_api;
-    CPU_BOOLEAN    abort_ok;
-    USBD_URB      *p_urb_head;
-    USBD_URB      *p_urb;
-    USBD_URB      *p_urb_cur;
+    USBD_DRV_API  *p_drv_api;
+    CPU_BOOLEAN    abort_ok;
+    USBD_URB      *p_urb_head;
+    USBD_URB      *p_urb;
+    USBD_URB      *p_urb_cur;
+
+
+    p_drv_api  =  p_drv->API_Ptr;                               /* Get dev drv API struct.                              */
+    p_urb_head = (USBD_URB *)0;
+    p_urb_cur  = (USBD_URB *)0;
+
+    switch (p_ep->XferState) {
+        case USBD_XFER_STATE_NONE:
+             abort_ok = DEF_OK;
+             break;
+
+
+        case USBD_XFER_STATE_ASYNC:
+        case USBD_XFER_STATE_ASYNC_PARTIAL:
+             p_urb = p_ep->URB_HeadPtr;
+             while(p_urb != (USBD_URB *)0) {
+                 p_urb = USBD_URB_AsyncCmpl(p_ep, USBD_ERR_EP_ABORT);
+                 if (p_urb_head == (USBD_URB *)0) {
+                     p_urb_head = p_urb;
+                 } else {
+                     p_urb_cur->NextPtr = p_urb;
+                 }
+                 p_urb_cur = p_urb;
+             }
+             abort_ok = p_drv->API_Ptr->EP_Abort(p_drv, p_ep->Addr); /* Call drv's abort fnct.                               */
+             break;
+
+
+        case USBD_XFER_STATE_SYNC:
+             USBD_OS_EP_SignalAbort(p_drv->DevNbr, p_ep->Ix, p_err);
+
+             abort_ok = p_drv_api->EP_Abort(p_drv, p_ep->Addr);
+             break;
+
+
+        default:
+             abort_ok = DEF_FAIL;
+             break;
+    }
+
+    if (abort_ok == DEF_OK) {
+       *p_err = USBD_ERR_NONE;
+    } else {
+       *p_err = USBD_ERR_EP_ABORT;
+    }
+
+    return (p_urb_head);                                        /* See Note #1.                                         */
+}
+
+
+/*
+*********************************************************************************************************
+*                                       USBD_EP_URB_SubmitRdy()
+*
+* Description : Check if another asynchronous URB can be submitted to the driver.
+*
+* Argument(s) : p_ep        Pointer to endpoint structure.
+*               ----        Argument checked by caller.
+*
+* Return(s)   : DEF_YES, if the driver can take another URB on this endpoint.
+*
+*               DEF_NO,  otherwise.
+*
+* Note(s)     : (1) Endpoint must be locked when calling this function.
+*
+*               (2) No URB can be submitted behind a partial transfer (see 'TRANSFER STATES Note #1').
+*
+*               (3) A submitted IN URB that still requires a zero-length packet at the end of the
+*                   transfer acts as a barrier. The ZLP is sent from USBD_EP_XferAsyncProcess() once the
+*                   data is transferred, and the data of the next URB must not reach the bus before it.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_EP_PRE_QUEUE_EN == DEF_ENABLED)
+static  CPU_BOOLEAN  USBD_EP_URB_SubmitRdy (USBD_EP  *p_ep)
+{
+    USBD_URB    *p_urb;
+    CPU_INT08U   urb_ix;
+
+
+    if (p_ep->URB_SubmitCnt == 0u) {
+        return (DEF_YES);
+    }
+
+    if ((p_ep->URB_SubmitCnt >= p_ep->URB_SubmitMax) ||
+        (p_ep->XferState     == USBD_XFER_STATE_ASYNC_PARTIAL)) {
+        return (DEF_NO);                                        /* See Note #2.                                         */
+    }
+
+    if (USBD_EP_IS_IN(p_ep->Addr) == DEF_NO) {
+        return (DEF_YES);
+    }
+
+    p_urb = p_ep->URB_HeadPtr;                                  /* Chk if a submitted URB requires a ZLP (see Note #3). */
+    for (urb_ix = 0u; urb_ix < p_ep->URB_SubmitCnt; urb_ix++) {
+        if ((DEF_BIT_IS_SET(p_urb->Flags, USBD_URB_FLAG_XFER_END) == DEF_YES) &&
+            (p_urb->BufLen                                        != 0u)      &&
+            (p_urb->BufLen % p_ep->MaxPktSize                     == 0u)) {
+            return (DEF_NO);
+        }
+        p_urb = p_urb->NextPtr;
+    }
+
+    return (DEF_YES);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_EP_URB_Submit()
+*
+* Description : Submit URB(s) held by the core to the driver, as long as the driver can take them.
+*
+* Argument(s) : p_drv       Pointer to device driver structure.
+*               ----        Argument checked by caller.
+*
+*               p_ep        Pointer to endpoint structure.
+*               ----        Argument checked by caller.
+*
+* Return(s)   : Pointer to head of the list of URB(s) that could not be submitted, if any.
+*
+*               Pointer to NULL,                                                otherwise.
+*
+* Note(s)     : (1) Endpoint must be locked when calling this function.
+*
+*               (2) URB(s) that could not be submitted are removed from the endpoint's URB list and must
+*                   be completed by calling USBD_URB_AsyncEnd() once the endpoint is unlocked.
+*
+*               (3) Once every submitted URB has completed, a partial transfer is over and the endpoint
+*                   can go back to the USBD_XFER_STATE_ASYNC state.
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_EP_PRE_QUEUE_EN == DEF_ENABLED)
+static  USBD_URB  *USBD_EP_URB_Submit (USBD_DRV  *p_drv,
+                                       USBD_EP   *p_ep)
+{
+    USBD_URB         *p_urb;
+    USBD_URB         *p_urb_prev;
+    USBD_URB         *p_urb_err_head;
+    USBD_URB         *p_urb_err_tail;
+    USBD_XFER_STATE   prev_xfer_state;
+    USBD_ERR          err;
+
+
+    p_urb_err_head = (USBD_URB *)0;
+    p_urb_err_tail = (USBD_URB *)0;
+
+    if ((p_ep->URB_SubmitCnt == 0u) &&                          /* See Note #3.                                         */
+        (p_ep->URB_PendPtr   != (USBD_URB *)0)) {
+        p_ep->XferState = USBD_XFER_STATE_ASYNC;
+    }
+
+    while ((p_ep->URB_PendPtr           != (USBD_URB *)0) &&
+           (USBD_EP_URB_SubmitRdy(p_ep) == DEF_YES)) {
+        p_urb           = p_ep->URB_PendPtr;
+        prev_xfer_state = p_ep->XferState;
+
+        if (USBD_EP_IS_IN(p_ep->Addr) == DEF_YES) {
+            USBD_EP_TxAsyncProcess(p_drv,
+                                   p_ep,
+                                   p_urb,
+                                   p_urb->BufPtr,
+                                   p_urb->BufLen,
+                                  &err);
+        } else {
+            USBD_EP_RxStartAsyncProcess(p_drv,
+                                        p_ep,
+                                        p_urb,
+                                        p_urb->BufPtr,
+                                        p_urb->BufLen,
+                                       &err);
+        }
+
+        p_ep->URB_PendPtr = p_urb->NextPtr;
+        if (err == USBD_ERR_NONE) {
+            p_ep->URB_SubmitCnt++;
+            continue;
+        }
+                                                                /* ------- REMOVE URB FROM EP LIST (see Note #2) ------ */
+        p_ep->XferState = prev_xfer_state;
+        if (p_urb == p_ep->URB_HeadPtr) {
+            USBD_URB_Dequeue(p_ep);
+        } else {
+            p_urb_prev = p_ep->URB_HeadPtr;
+            while (p_urb_prev->NextPtr != p_urb) {
+                p_urb_prev = p_urb_prev->NextPtr;
+            }
+            p_urb_prev->NextPtr = p_urb->NextPtr;
+            if (p_ep->URB_TailPtr == p_urb) {
+                p_ep->URB_TailPtr = p_urb_prev;
+            }
+        }
+
+        p_urb->Err     =  err;
+        p_urb->NextPtr = (USBD_URB *)0;
+        if (p_urb_err_head == (USBD_URB *)0) {
+            p_urb_err_head = p_urb;
+        } else {
+            p_urb_err_tail->NextPtr = p_urb;
+        }
+        p_urb_err_tail = p_urb;
+    }
+
+    return (p_urb_err_head);
+}
+#endif
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_URB_AsyncCmpl()
+*
+* Description : Notify URB completion to asynchronous callback.
+*
+* Argument(s) : p_ep        Pointer to endpoint on which transfer has completed.
+*               ----        Argument checked by caller.
+*
+*               err         Error associated with transfer.
+*
+* Return(s)   : Pointer to completed URB, if any.
+*
+*               Pointer to NULL,          otherwise.
+*
+* Note(s)     : (1) Endpoint must be locked when calling this function.
+*
+*               (2) Endpoint must have an asynchronous transfer in progress.
+*********************************************************************************************************
+*/
+
+static  USBD_URB  *USBD_URB_AsyncCmpl (USBD_EP   *p_ep,
+                                       USBD_ERR   err)
+{
+    USBD_URB  *p_urb;
+
+
+    p_urb = p_ep->URB_HeadPtr;                                  /* Get head URB for EP.                                 */
+    if (p_urb == (USBD_URB *)0) {
+        return (p_urb);
+    }
+
+#if (USBD_CFG_EP_PRE_QUEUE_EN == DEF_ENABLED)
+    if (p_urb == p_ep->URB_PendPtr) {                           /* URB was never submitted to drv.                      */
+        p_ep->URB_PendPtr = p_urb->NextPtr;
+    } else if (p_ep->URB_SubmitCnt > 0u) {
+        p_ep->URB_SubmitCnt--;
+    }
+#endif
+
+    USBD_URB_Dequeue(p_ep);                                     /* Dequeue first URB from EP.                           */
+
+    p_urb->Err     =  err;                                      /* Set err for curr URB.                                */
+    p_urb->NextPtr = (USBD_URB *)0;                             /* Remove links with 'p_ep' URB linked list.            */
+
+    return (p_urb);
+}
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_URB_AsyncEnd()
+*
+* Description : Execute callback associated with each USB request block in the linked list and free them.
+*
+* Argument(s) : dev_nbr     Device number.
+*               -------     Argument checked by caller.
+*
+*               p_ep        Pointer to endpoint structure.
+*               ----        Argument checked by caller.
+*
+*               p_urb_head  Pointer to head of USB request block linked list.
+*               -----       Argument checked by caller.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Endpoint must NOT be locked when calling this function.
+*********************************************************************************************************
+*/
+
+static  void  USBD_URB_AsyncEnd (CPU_INT08U   dev_nbr,
+                                 USBD_EP     *p_ep,
+                                 USBD_URB    *p_urb_head)
+{
+    USBD_URB         *p_urb_cur;
+    USBD_URB         *p_urb_next;
+    void             *p_buf;
+    CPU_INT32U        buf_len;
+    CPU_INT32U        xfer_len;
+    USBD_ASYNC_FNCT   async_fnct;
+    void             *p_async_arg;
+    USBD_ERR          err;
+
+
+    p_urb_cur = p_urb_head;
+    while (p_urb_cur != (USBD_URB *)0) {                        /* Iterate through linked list.                         */
+        p_buf       = (void *)p_urb_cur->BufPtr;
+        buf_len     =  p_urb_cur->BufLen;
+        xfer_len    =  p_urb_cur->XferLen;
+        async_fnct  =  p_urb_cur->AsyncFnct;
+        p_async_arg =  p_urb_cur->AsyncFnctArg;
+        err         =  p_urb_cur->Err;
+        p_urb_next  =  p_urb_cur->NextPtr;
+
+#if (USBD_EP_LAT_EN == DEF_ENABLED)
+        if (err == USBD_ERR_NONE) {
+            USBD_EP_LatRecord(dev_nbr, p_ep, p_urb_cur);
+        }
+#endif
+        USBD_EP_CAPTURE_CMPL(dev_nbr, p_ep, p_urb_cur, err);
+
+        USBD_URB_Free(dev_nbr, p_ep, p_urb_cur);                /* Free URB to pool.                                    */
+
+        async_fnct(dev_nbr,                                     /* Execute callback fnct.                               */
+                   p_ep->Addr,
+                   p_buf,
+                   buf_len,
+                   xfer_len,
+                   p_async_arg,
+                   err);
+
+        p_urb_cur = p_urb_next;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                           USBD_URB_Free()
+*
+* Description : Free URB to URB pool.
+*
+* Argument(s) : dev_nbr     Device number.
+*               -------     Argument checked by caller.
+*
+*               p_ep        Pointer to endpoint structure.
+*               ----        Argument checked by caller.
+*
+*               p_urb       Pointer to USB request block.
+*               -----       Argument checked by caller.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) The main URB of an endpoint is returned without entering a critical section. The
+*                   'URB_MainAvail' flag is only cleared by USBD_URB_Get(), once the endpoint's main URB
+*                   has been returned.
+*
+*               (2) An extra URB freed while the endpoint uses fewer extra URBs than it has reserved is
+*                   returned to the endpoint's reservation.
+*********************************************************************************************************
+*/
+
+static  void  USBD_URB_Free (CPU_INT08U   dev_nbr,
+                             USBD_EP     *p_ep,
+                             USBD_URB    *p_urb)
+{
+#if (USBD_CFG_MAX_NBR_URB_EXTRA > 0u)
+    CPU_SR_ALLOC();
+#endif
 
 
-    p_drv_api  =  p_drv->API_Ptr;                               /* Get dev drv API struct.                              */
-    p_urb_head = (USBD_URB *)0;
-    p_urb_cur  = (USBD_URB *)0;
+    p_urb->State = USBD_URB_STATE_IDLE;
 
-    switch (p_ep->XferState) {
-        case USBD_XFER_STATE_NONE:
-             abort_ok = DEF_OK;
-             break;
+#if (USBD_CFG_MAX_NBR_URB_EXTRA > 0u)
+    if (DEF_BIT_IS_SET(p_urb->Flags, USBD_URB_FLAG_EXTRA_URB)) {
+        CPU_CRITICAL_ENTER();                                   /* Return extra URB to dev's shared free list.          */
+        p_urb->NextPtr           = USBD_URB_TblPtr[dev_nbr];
+        USBD_URB_TblPtr[dev_nbr] = p_urb;
+
+        USBD_URB_ExtraCtr[dev_nbr]--;
+        p_ep->URB_ExtraCnt--;
+        if (p_ep->URB_ExtraCnt < p_ep->URB_ExtraRsvd) {         /* See Note #2.                                         */
+            USBD_URB_ExtraRsvdAvail[dev_nbr]++;
+        }
+        CPU_CRITICAL_EXIT();
 
+        USBD_DBG_STATS_POOL_FREE(&USBD_DbgStatsPoolURB_Extra);
+        return;
+    }
+#else
+    (void)dev_nbr;
+#endif
 
-        case USBD_XFER_STATE_ASYNC:
-        case USBD_XFER_STATE_ASYNC_PARTIAL:
-             p_urb = p_ep->URB_HeadPtr;
-             while(p_urb != (USBD_URB *)0) {
-                 p_urb = USBD_URB_AsyncCmpl(p_ep, USBD_ERR_EP_ABORT);
-                 if (p_urb_head == (USBD_URB *)0) {
-                     p_urb_head = p_urb;
-                 } else {
-                     p_urb_cur->NextPtr = p_urb;
-                 }
-                 p_urb_cur = p_urb;
-             }
-             abort_ok = p_drv->API_Ptr->EP_Abort(p_drv, p_ep->Addr); /* Call drv's abort fnct.                               */
-             break;
+    p_urb->NextPtr      = (USBD_URB *)0;
+    p_ep->URB_MainAvail =  DEF_YES;                             /* See Note #1.                                         */
+}
 
 
-        case USBD_XFER_STATE_SYNC:
-             USBD_OS_EP_SignalAbort(p_drv->DevNbr, p_ep->Ix, p_err);
+/*
+*********************************************************************************************************
+*                                           USBD_URB_Get()
+*
+* Description : Get URB from URB pool.
+*
+* Argument(s) : dev_nbr     Device number.
+*               -------     Argument checked by caller.
+*
+*               p_ep        Pointer to endpoint structure.
+*               ----        Argument checked by caller.
+*
+*               p_err       Pointer to variable that will receive return error code from this function :
+*               ----        Argument checked by caller.
+*
+*                               USBD_ERR_NONE               URB successfully returned.
+*                               USBD_ERR_EP_QUEUING         No URB available in the pool.
+*
+* Return(s)   : Pointer to USB request block, if NO error(s).
+*
+*               Pointer to NULL,              otherwise.
+*
+* Note(s)     : (1) This function MUST be called with the endpoint's lock held, or from the ISR owning
+*                   the endpoint (see USBD_EP_XferDirectCmpl()).
+*
+*               (2) Each endpoint owns a main URB (see 'LOCAL DEFINES  Note #1a'). Since only the
+*                   endpoint's owner can take it, the main URB is obtained without entering a critical
+*                   section.
+*
+*               (3) Extra URBs are taken from the device's shared free list, within the endpoint's quota
+*                   (see USBD_EP_URB_QuotaSet()) :
+*
+*                   (a) The endpoint can NOT use more than 'URB_ExtraMax' extra URBs at once.
+*
+*                   (b) While the endpoint uses fewer extra URBs than it has reserved, the URB is taken
+*                       from the endpoint's reservation.
+*
+*                   (c) Otherwise, the URB is taken only if the number of free extra URBs exceeds the
+*                       number of extra URBs reserved by all endpoints and not currently used.
+*
+*               (4) The main URB of an endpoint is returned by USBD_URB_AsyncEnd() after the endpoint's
+*                   lock is released. A transfer queued in between requires an extra URB.
+*
+*               (5) A URB refused to an endpoint is accounted as a refused allocation of the extra URB
+*                   pool, even if USBD_CFG_MAX_NBR_URB_EXTRA is 0 or if the endpoint reached its quota.
+*********************************************************************************************************
+*/
 
-             abort_ok = p_drv_api->EP_Abort(p_drv, p_ep->Addr);
-             break;
+static  USBD_URB  *USBD_URB_Get (CPU_INT08U   dev_nbr,
+                                 USBD_EP     *p_ep,
+                                 USBD_ERR    *p_err)
+{
+    USBD_URB     *p_urb;
+#if (USBD_CFG_MAX_NBR_URB_EXTRA > 0u)
+    CPU_BOOLEAN   urb_avail;
+    CPU_SR_ALLOC();
+#endif
 
 
-        default:
-             abort_ok = DEF_FAIL;
-             break;
+    if (p_ep->URB_MainAvail == DEF_YES) {                       /* See Note #2.                                         */
+        p_ep->URB_MainAvail = DEF_NO;
+
+        p_urb          = &USBD_URB_Tbl[dev_nbr][p_ep->Ix];
+        p_urb->NextPtr = (USBD_URB *)0;
+        p_urb->Flags   =  0u;
+       *p_err          =  USBD_ERR_NONE;
+
+        USBD_URB_LAT_SUBMIT(p_urb);
+
+        return (p_urb);
     }
 
-    if (abort_ok == DEF_OK) {
-       *p_err = USBD_ERR_NONE;
+#if (USBD_CFG_MAX_NBR_URB_EXTRA > 0u)
+    urb_avail = DEF_NO;
+    p_urb     = (USBD_URB *)0;
+
+    CPU_CRITICAL_ENTER();
+    if ((p_ep->URB_ExtraCnt     <  p_ep->URB_ExtraMax) &&       /* See Note #3a.                                        */
+        (USBD_URB_TblPtr[dev_nbr] != (USBD_URB *)0)) {
+
+        if (p_ep->URB_ExtraCnt < p_ep->URB_ExtraRsvd) {         /* See Note #3b.                                        */
+            USBD_URB_ExtraRsvdAvail[dev_nbr]--;
+            urb_avail = DEF_YES;
+                                                                /* See Note #3c.                                        */
+        } else if ((CPU_INT08U)(USBD_CFG_MAX_NBR_URB_EXTRA - USBD_URB_ExtraCtr[dev_nbr]) >
+                                USBD_URB_ExtraRsvdAvail[dev_nbr]) {
+            urb_avail = DEF_YES;
+        }
+    }
+
+    if (urb_avail == DEF_YES) {
+        p_urb                    = USBD_URB_TblPtr[dev_nbr];
+        USBD_URB_TblPtr[dev_nbr] = p_urb->NextPtr;
+
+        USBD_URB_ExtraCtr[dev_nbr]++;
+        p_ep->URB_ExtraCnt++;
+    }
+    CPU_CRITICAL_EXIT();
+
+    if (p_urb != (USBD_URB *)0) {
+        p_urb->NextPtr = (USBD_URB *)0;
+        p_urb->Flags   =  USBD_URB_FLAG_EXTRA_URB;
+       *p_err          =  USBD_ERR_NONE;
+
+        USBD_DBG_STATS_POOL_ALLOC(&USBD_DbgStatsPoolURB_Extra);
+        USBD_URB_LAT_SUBMIT(p_urb);
+
+        return (p_urb);
+    }
+#endif
+
+    USBD_DBG_STATS_POOL_FAIL(&USBD_DbgStatsPoolURB_Extra);      /* See Note #5.                                         */
+   *p_err = USBD_ERR_EP_QUEUING;
+
+    return ((USBD_URB *)0);
+}
+
+
+/*
+*********************************************************************************************************
+*                                          USBD_URB_Queue()
+*
+* Description : Queue USB request block into endpoint.
+*
+* Argument(s) : p_ep        Pointer to endpoint structure.
+*               ----        Argument checked by caller.
+*
+*               p_urb       Pointer to USB request block.
+*               -----       Argument checked by caller.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Endpoint must be locked when calling this function.
+*********************************************************************************************************
+*/
+
+static  void  USBD_URB_Queue (USBD_EP   *p_ep,
+                              USBD_URB  *p_urb)
+{
+    p_urb->NextPtr = (USBD_URB *)0;
+
+
+    if (p_ep->URB_TailPtr == (USBD_URB *)0) {                   /* Q is empty.                                          */
+        p_ep->URB_HeadPtr = p_urb;
+        p_ep->URB_TailPtr = p_urb;
+    } else {                                                    /* Q is not empty.                                      */
+        p_ep->URB_TailPtr->NextPtr = p_urb;
+        p_ep->URB_TailPtr          = p_urb;
+    }
+
+    return;
+}
+
+
+/*
+*********************************************************************************************************
+*                                         USBD_URB_Dequeue()
+*
+* Description : Dequeue head USB request block from endpoint.
+*
+* Argument(s) : p_ep        Pointer to endpoint structure.
+*               ----        Argument checked by caller.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Endpoint must be locked when calling this function.
+*********************************************************************************************************
+*/
+
+static  void  USBD_URB_Dequeue (USBD_EP  *p_ep)
+{
+    USBD_URB  *p_urb;
+
+
+    p_urb = p_ep->URB_HeadPtr;
+    if (p_urb == (USBD_URB *)0) {
+        return;
+    }
+
+    if (p_urb->NextPtr == (USBD_URB *)0) {                      /* Only one URB is queued.                              */
+        p_ep->URB_HeadPtr = (USBD_URB *)0;
+        p_ep->URB_TailPtr = (USBD_URB *)0;
+        p_ep->XferState   =  USBD_XFER_STATE_NONE;
     } else {
-       *p_err = USBD_ERR_EP_ABORT;
+        p_ep->URB_HeadPtr = p_urb->NextPtr;
+    }
+}
+
+
+/*
+*********************************************************************************************************
+*                                        USBD_URB_VecNextGet()
+*
+* Description : Compute the buffer and length of the next transaction of a vectored transfer.
+*
+* Argument(s) : dev_nbr     Device number.
+*               -------     Argument checked by caller.
+*
+*               p_ep        Pointer to endpoint structure.
+*               ----        Argument checked by caller.
+*
+*               p_urb       Pointer to USB request block.
+*               -----       Argument checked by caller.
+*
+* Return(s)   : Length of the next transaction. The buffer is returned in 'p_urb->SegBufPtr'.
+*
+* Note(s)     : (1) Endpoint must be locked when calling this function.
+*
+*               (2) The next transaction is done directly in the current segment if :
+*
+*                   (a) It is the last segment. The remaining data of the segment ends the transfer.
+*
+*                   (b) At least one packet remains in the segment. The transaction is limited to a
+*                       multiple of the maximum packet size, so that no short packet is transferred
+*                       before the end of the transfer.
+*
+*               (3) Otherwise, the next packet straddles two or more segments and is transferred through
+*                   the endpoint's packet buffer. For an IN transfer, the data is gathered in the buffer
+*                   here. For an OUT transfer, it is scattered by USBD_EP_XferAsyncCmpl().
+*********************************************************************************************************
+*/
+
+#if (USBD_CFG_EP_VEC_XFER_EN == DEF_ENABLED)
+static  CPU_INT32U  USBD_URB_VecNextGet (CPU_INT08U   dev_nbr,
+                                         USBD_EP     *p_ep,
+                                         USBD_URB    *p_urb)
+{
+    USBD_BUF_SEG  *p_seg;
+    CPU_INT32U     seg_rem;
+    CPU_INT32U     xfer_rem;
+    CPU_INT32U     len;
+    CPU_INT08U     seg_ix_last;
+
+
+    seg_ix_last = p_urb->SegNbr - 1u;
+    p_seg       = (USBD_BUF_SEG *)p_urb->BufPtr;
+    seg_rem     = p_seg[p_urb->SegIx].BufLen - p_urb->SegOffset;
+
+    while ((seg_rem      == 0u) &&                              /* Skip empty segs.                                     */
+           (p_urb->SegIx <  seg_ix_last)) {
+        p_urb->SegIx++;
+        p_urb->SegOffset = 0u;
+        seg_rem          = p_seg[p_urb->SegIx].BufLen;
     }
 
-    return (p_urb_head);                                        /* See Note #1.                                         */
+    if ((p_urb->SegIx == seg_ix_last) ||                        /* See Note #2.                                         */
+        (seg_rem      >= p_ep->MaxPktSize)) {
+        len = seg_rem;
+        if (p_urb->SegIx != seg_ix_last) {
+            len -= (seg_rem % p_ep->MaxPktSize);
+        }
+        p_urb->SegBufPtr   = &((CPU_INT08U *)p_seg[p_urb->SegIx].BufPtr)[p_urb->SegOffset];
+        p_urb->SegStraddle =  DEF_NO;
+    } else {                                                    /* See Note #3.                                         */
+        xfer_rem           = p_urb->BufLen - p_urb->XferLen;
+        len                = DEF_MIN(xfer_rem, p_ep->MaxPktSize);
+        p_urb->SegBufPtr   = USBD_EP_VecBufTbl[dev_nbr][p_ep->Ix];
+        p_urb->SegStraddle = DEF_YES;
+
+        if (USBD_EP_IS_IN(p_ep->Addr) == DEF_YES) {
+            USBD_URB_VecCopy(p_urb, p_urb->SegBufPtr, len, DEF_YES);
+        }
+    }
+
+    return (len);
 }
+#endif
 
 
 /*
 *********************************************************************************************************
-*                                         USBD_URB_AsyncCmpl()
+*                                          USBD_URB_VecCopy()
 *
-* Description : Notify URB completion to asynchronous callback.
+* Description : Copy data between the segments of a vectored transfer and a contiguous buffer, starting at
+*               the current position of the transfer.
 *
-* Argument(s) : p_ep        Pointer to endpoint on which transfer has completed.
-*               ----        Argument checked by caller.
+* Argument(s) : p_urb       Pointer to USB request block.
+*               -----       Argument checked by caller.
 *
-*               err         Error associated with transfer.
+*               p_buf       Pointer to contiguous buffer.
+*               -----       Argument checked by caller.
 *
-* Return(s)   : Pointer to completed URB, if any.
+*               len         Number of octets to copy.
 *
-*               Pointer to NULL,          otherwise.
+*               gather      Copy direction :
 *
-* Note(s)     : (1) Endpoint must be locked when calling this function.
+*                               DEF_YES     Copy from the segments to 'p_buf'.
+*                               DEF_NO      Copy from 'p_buf' to the segments.
 *
-*               (2) Endpoint must have an asynchronous transfer in progress.
+* Return(s)   : none.
+*
+* Note(s)     : (1) 'len' MUST NOT exceed the number of octets remaining in the transfer. The position of
+*                   the transfer is not modified (see USBD_URB_VecAdvance()).
 *********************************************************************************************************
 */
 
-static  USBD_URB  *USBD_URB_AsyncCmpl (USBD_EP   *p_ep,
-                                       USBD_ERR   err)
+#if (USBD_CFG_EP_VEC_XFER_EN == DEF_ENABLED)
+static  void  USBD_URB_VecCopy (USBD_URB     *p_urb,
+                                CPU_INT08U   *p_buf,
+                                CPU_INT32U    len,
+                                CPU_BOOLEAN   gather)
 {
-    USBD_URB  *p_urb;
+    USBD_BUF_SEG  *p_seg;
+    CPU_INT08U    *p_seg_buf;
+    CPU_INT32U     seg_offset;
+    CPU_INT32U     copy_len;
+    CPU_INT08U     seg_ix;
 
 
-    p_urb = p_ep->URB_HeadPtr;                                  /* Get head URB for EP.                                 */
-    if (p_urb == (USBD_URB *)0) {
-        return (p_urb);
+    p_seg      = (USBD_BUF_SEG *)p_urb->BufPtr;
+    seg_ix     = p_urb->SegIx;
+    seg_offset = p_urb->SegOffset;
+
+    while (len > 0u) {
+        copy_len  =  DEF_MIN(p_seg[seg_ix].BufLen - seg_offset, len);
+        p_seg_buf = &((CPU_INT08U *)p_seg[seg_ix].BufPtr)[seg_offset];
+
+        if (gather == DEF_YES) {
+            Mem_Copy((void *)p_buf,     (void *)p_seg_buf, copy_len);
+        } else {
+            Mem_Copy((void *)p_seg_buf, (void *)p_buf,     copy_len);
+        }
+
+        p_buf      += copy_len;
+        len        -= copy_len;
+        seg_offset  = 0u;
+        seg_ix++;
     }
+}
+#endif
 
-    USBD_URB_Dequeue(p_ep);                                     /* Dequeue first URB from EP.                           */
 
-    p_urb->Err     =  err;                                      /* Set err for curr URB.                                */
-    p_urb->NextPtr = (USBD_URB *)0;                             /* Remove links with 'p_ep' URB linked list.            */
+/*
+*********************************************************************************************************
+*                                        USBD_URB_VecAdvance()
+*
+* Description : Move the current position of a vectored transfer forward.
+*
+* Argument(s) : p_urb       Pointer to USB request block.
+*               -----       Argument checked by caller.
+*
+*               len         Number of octets transferred.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) The position never moves past the end of the last segment.
+*********************************************************************************************************
+*/
 
-    return (p_urb);
+#if (USBD_CFG_EP_VEC_XFER_EN == DEF_ENABLED)
+static  void  USBD_URB_VecAdvance (USBD_URB    *p_urb,
+                                   CPU_INT32U   len)
+{
+    USBD_BUF_SEG  *p_seg;
+    CPU_INT32U     seg_rem;
+
+
+    p_seg = (USBD_BUF_SEG *)p_urb->BufPtr;
+
+    while (len > 0u) {
+        seg_rem = p_seg[p_urb->SegIx].BufLen - p_urb->SegOffset;
+        if ((len          <  seg_rem) ||
+            (p_urb->SegIx == (p_urb->SegNbr - 1u))) {           /* See Note #1.                                         */
+            p_urb->SegOffset += DEF_MIN(len, seg_rem);
+            len               = 0u;
+        } else {
+            len              -= seg_rem;
+            p_urb->SegOffset  = 0u;
+            p_urb->SegIx++;
+        }
+    }
 }
+#endif
 
 
 /*
 *********************************************************************************************************
-*                                          USBD_URB_AsyncEnd()
+*                                         USBD_EP_LatRecord()
 *
-* Description : Execute callback associated with each USB request block in the linked list and free them.
+* Description : Sample the lifetime of a completed URB into the endpoint's latency histograms.
 *
 * Argument(s) : dev_nbr     Device number.
 *               -------     Argument checked by caller.
@@ -4324,62 +7151,101 @@ static  USBD_URB  *USBD_URB_AsyncCmpl (USBD_EP   *p_ep,
 *               p_ep        Pointer to endpoint structure.
 *               ----        Argument checked by caller.
 *
-*               p_urb_head  Pointer to head of USB request block linked list.
+*               p_urb       Pointer to completed USB request block.
 *               -----       Argument checked by caller.
 *
 * Return(s)   : none.
 *
-* Note(s)     : (1) Endpoint must NOT be locked when calling this function.
+* Note(s)     : (1) A URB that never reached the driver has no valid driver timestamps and is not sampled.
+*
+*               (2) The timestamps are unsigned. Their differences remain correct when the timestamp
+*                   counter wraps around, as long as each stage lasts less than a full counter period.
+*
+*               (3) The histograms are updated within a critical section, so that USBD_EP_LatStatsGet()
+*                   always returns a consistent snapshot.
 *********************************************************************************************************
 */
 
-static  void  USBD_URB_AsyncEnd (CPU_INT08U   dev_nbr,
+#if (USBD_EP_LAT_EN == DEF_ENABLED)
+static  void  USBD_EP_LatRecord (CPU_INT08U   dev_nbr,
                                  USBD_EP     *p_ep,
-                                 USBD_URB    *p_urb_head)
+                                 USBD_URB    *p_urb)
 {
-    USBD_URB         *p_urb_cur;
-    USBD_URB         *p_urb_next;
-    void             *p_buf;
-    CPU_INT32U        buf_len;
-    CPU_INT32U        xfer_len;
-    USBD_ASYNC_FNCT   async_fnct;
-    void             *p_async_arg;
-    USBD_ERR          err;
+    USBD_DBG_STATS_EP_LAT  *p_lat;
+    CPU_TS32                ts_cmpl;
+    CPU_SR_ALLOC();
 
 
-    p_urb_cur = p_urb_head;
-    while (p_urb_cur != (USBD_URB *)0) {                        /* Iterate through linked list.                         */
-        p_buf       = (void *)p_urb_cur->BufPtr;
-        buf_len     =  p_urb_cur->BufLen;
-        xfer_len    =  p_urb_cur->XferLen;
-        async_fnct  =  p_urb_cur->AsyncFnct;
-        p_async_arg =  p_urb_cur->AsyncFnctArg;
-        err         =  p_urb_cur->Err;
-        p_urb_next  =  p_urb_cur->NextPtr;
+    if (DEF_BIT_IS_CLR(p_urb->Flags, USBD_URB_FLAG_LAT_DRV) == DEF_YES) {
+        return;                                                 /* See Note #1.                                         */
+    }
 
-        USBD_URB_Free(dev_nbr, p_ep, p_urb_cur);                /* Free URB to pool.                                    */
+    ts_cmpl = CPU_TS_Get32();
+    p_lat   = &USBD_DbgStatsEP_Tbl[dev_nbr][p_ep->Ix].Lat;
+                                                                /* See Note #2.                                         */
+    CPU_CRITICAL_ENTER();                                       /* See Note #3.                                         */
+    USBD_EP_LatSampleAdd(&p_lat->SubmitToDrv, p_urb->TsDrvStart - p_urb->TsSubmit);
+    USBD_EP_LatSampleAdd(&p_lat->DrvToISR,    p_urb->TsDrvCmpl  - p_urb->TsDrvStart);
+    USBD_EP_LatSampleAdd(&p_lat->ISR_ToCmpl,  ts_cmpl           - p_urb->TsDrvCmpl);
+    USBD_EP_LatSampleAdd(&p_lat->Tot,         ts_cmpl           - p_urb->TsSubmit);
+    CPU_CRITICAL_EXIT();
+}
+#endif
 
-        async_fnct(dev_nbr,                                     /* Execute callback fnct.                               */
-                   p_ep->Addr,
-                   p_buf,
-                   buf_len,
-                   xfer_len,
-                   p_async_arg,
-                   err);
 
-        p_urb_cur = p_urb_next;
+/*
+*********************************************************************************************************
+*                                       USBD_EP_LatSampleAdd()
+*
+* Description : Add a sample to a latency histogram.
+*
+* Argument(s) : p_hist      Pointer to latency histogram.
+*               ------      Argument checked by caller.
+*
+*               lat         Latency, in CPU timestamp ticks.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) The bin index is the position of the most significant bit set in the latency (see
+*                   'usbd_core.h  EP LATENCY HISTOGRAMS  Note #1').
+*
+*               (2) Bin counters saturate instead of wrapping around.
+*********************************************************************************************************
+*/
+
+#if (USBD_EP_LAT_EN == DEF_ENABLED)
+static  void  USBD_EP_LatSampleAdd (USBD_DBG_STATS_LAT  *p_hist,
+                                    CPU_TS32             lat)
+{
+    CPU_INT08U  bin_ix;
+
+
+    bin_ix = 0u;
+    if (lat > 1u) {                                             /* See Note #1.                                         */
+        bin_ix = (CPU_INT08U)(31u - CPU_CntLeadZeros32(lat));
+        if (bin_ix >= USBD_CFG_DBG_STATS_LAT_NBR_BIN) {
+            bin_ix  = USBD_CFG_DBG_STATS_LAT_NBR_BIN - 1u;
+        }
+    }
+
+    if (p_hist->BinTbl[bin_ix] != DEF_INT_32U_MAX_VAL) {        /* See Note #2.                                         */
+        p_hist->BinTbl[bin_ix]++;
+    }
+
+    if (lat > p_hist->Max) {
+        p_hist->Max = lat;
     }
 }
+#endif
 
 
 /*
 *********************************************************************************************************
-*                                           USBD_URB_Free()
+*                                        USBD_EP_CaptureXfer()
 *
-* Description : Free URB to URB pool.
+* Description : Record a transaction submission or a transfer completion in the capture ring.
 *
 * Argument(s) : dev_nbr     Device number.
-*               -------     Argument checked by caller.
 *
 *               p_ep        Pointer to endpoint structure.
 *               ----        Argument checked by caller.
@@ -4387,186 +7253,340 @@ static  void  USBD_URB_AsyncEnd (CPU_INT08U   dev_nbr,
 *               p_urb       Pointer to USB request block.
 *               -----       Argument checked by caller.
 *
+*               cmpl        Indicates if the record is a completion (DEF_YES) or a submission (DEF_NO).
+*
+*               err         Transfer error, for completions.
+*
 * Return(s)   : none.
 *
-* Note(s)     : none.
+* Note(s)     : (1) Submissions carry no payload (see 'usbd_core.h  TRAFFIC CAPTURE  Note #1b').
+*
+*               (2) The payload of vectored transfers is spread across several buffers and is not recorded.
 *********************************************************************************************************
 */
 
-static  void  USBD_URB_Free (CPU_INT08U   dev_nbr,
-                             USBD_EP     *p_ep,
-                             USBD_URB    *p_urb)
+#if (USBD_CFG_CAPTURE_EN == DEF_ENABLED)
+static  void  USBD_EP_CaptureXfer (CPU_INT08U    dev_nbr,
+                                   USBD_EP      *p_ep,
+                                   USBD_URB     *p_urb,
+                                   CPU_BOOLEAN   cmpl,
+                                   USBD_ERR      err)
 {
-    CPU_SR_ALLOC();
+    CPU_INT08U   xfer_type;
+    CPU_INT08U   stage;
+    CPU_INT32U   status;
+    CPU_INT08U  *p_data;
+    CPU_INT32U   data_len;
 
 
-    CPU_CRITICAL_ENTER();
-    p_urb->State             = USBD_URB_STATE_IDLE;
-    p_urb->NextPtr           = USBD_URB_TblPtr[dev_nbr];
-    USBD_URB_TblPtr[dev_nbr] = p_urb;
+    switch (p_ep->Attrib & USBD_EP_TYPE_MASK) {
+        case USBD_EP_TYPE_CTRL:
+             xfer_type = USBD_CAPTURE_XFER_CTRL;
+             break;
 
-#if (USBD_CFG_MAX_NBR_URB_EXTRA > 0u)
-    if (DEF_BIT_IS_SET(p_urb->Flags, USBD_URB_FLAG_EXTRA_URB)) {
-                                                                /* If the URB freed is an 'extra' URB, dec ctr.         */
-        USBD_URB_ExtraCtr[dev_nbr]--;
-    } else {
-        p_ep->URB_MainAvail = DEF_YES;
+        case USBD_EP_TYPE_ISOC:
+             xfer_type = USBD_CAPTURE_XFER_ISOC;
+             break;
+
+        case USBD_EP_TYPE_INTR:
+             xfer_type = USBD_CAPTURE_XFER_INTR;
+             break;
+
+        case USBD_EP_TYPE_BULK:
+        default:
+             xfer_type = USBD_CAPTURE_XFER_BULK;
+             break;
     }
-#else
-    (void)p_ep;
+
+    if (cmpl == DEF_NO) {                                       /* See Note #1.                                         */
+        stage    = USBD_CAPTURE_STAGE_DATA;
+        status   = USBD_CAPTURE_STATUS_SUCCESS;
+        p_data   = (CPU_INT08U *)0;
+        data_len = 0u;
+    } else {
+        stage    = USBD_CAPTURE_STAGE_CMPL;
+        p_data   = p_urb->BufPtr;
+        data_len = p_urb->XferLen;
+#if (USBD_CFG_EP_VEC_XFER_EN == DEF_ENABLED)
+        if (DEF_BIT_IS_SET(p_urb->Flags, USBD_URB_FLAG_VEC) == DEF_YES) {
+            p_data = (CPU_INT08U *)0;                           /* See Note #2.                                         */
+        }
 #endif
-    CPU_CRITICAL_EXIT();
+
+        switch (err) {
+            case USBD_ERR_NONE:
+                 status = USBD_CAPTURE_STATUS_SUCCESS;
+                 break;
+
+            case USBD_ERR_OS_ABORT:
+            case USBD_ERR_EP_ABORT:
+                 status = USBD_CAPTURE_STATUS_CANCELED;
+                 break;
+
+            case USBD_ERR_OS_TIMEOUT:
+                 status = USBD_CAPTURE_STATUS_TIMEOUT;
+                 break;
+
+            default:
+                 status = USBD_CAPTURE_STATUS_XACT_ERR;
+                 break;
+        }
+    }
+
+    USBD_EP_CaptureRecPut(dev_nbr,
+                          p_ep->Addr,
+                          xfer_type,
+                          cmpl,
+                          stage,
+                          (CPU_INT32U)(CPU_ADDR)p_urb,
+                          status,
+                          p_data,
+                          data_len);
 }
+#endif
 
 
 /*
 *********************************************************************************************************
-*                                           USBD_URB_Get()
+*                                       USBD_EP_CaptureRecPut()
 *
-* Description : Get URB from URB pool.
+* Description : Write a pcap record in the capture ring.
 *
 * Argument(s) : dev_nbr     Device number.
-*               -------     Argument checked by caller.
 *
-*               p_ep        Pointer to endpoint structure.
-*               ----        Argument checked by caller.
+*               ep_addr     Endpoint address.
 *
-*               p_err       Pointer to variable that will receive return error code from this function :
-*               ----        Argument checked by caller.
+*               xfer_type   USBPcap transfer type (USBD_CAPTURE_XFER_xxx).
 *
-*                               USBD_ERR_NONE               URB successfully returned.
-*                               USBD_ERR_EP_QUEUING         No URB available in the pool.
+*               cmpl        Indicates if the record is a completion (DEF_YES) or a request (DEF_NO).
 *
-* Return(s)   : Pointer to USB request block, if NO error(s).
+*               stage       Control transfer stage (USBD_CAPTURE_STAGE_xxx), control transfers only.
 *
-*               Pointer to NULL,              otherwise.
+*               irp_id      IRP id of the record.
 *
-* Note(s)     : none.
+*               status      USBPcap status of the transfer (USBD_CAPTURE_STATUS_xxx).
+*
+*               p_data      Pointer to payload, NULL if none is recorded.
+*
+*               data_len    Payload length, in octets.
+*
+* Return(s)   : none.
+*
+* Note(s)     : (1) Record layout (all fields little-endian) :
+*
+*                   (a) pcap record header    : seconds (4), microseconds (4), captured length (4),
+*                                               original length (4).
+*                   (b) USBPcap header        : header length (2), IRP id (8), status (4), URB function (2),
+*                                               info (1), bus (2), device (2), endpoint (1), transfer
+*                                               type (1), data length (4).
+*                   (c) Control transfers     : stage (1).
+*                       Isochronous transfers : start frame (4), number of packets (4), error count (4),
+*                                               and one packet descriptor : offset (4), length (4),
+*                                               status (4).
+*                   (d) Payload, truncated to USBD_CFG_CAPTURE_SNAP_LEN octets.
+*
+*               (2) The device number is recorded as the device address, on bus 0.
+*
+*               (3) The timestamp is taken within the critical section so that the records are stored in
+*                   chronological order.
+*
+*               (4) A record that does not fit in the free space of the ring is dropped, so that records
+*                   not yet read are never overwritten.
 *********************************************************************************************************
 */
 
-static  USBD_URB  *USBD_URB_Get (CPU_INT08U   dev_nbr,
-                                 USBD_EP     *p_ep,
-                                 USBD_ERR    *p_err)
+#if (USBD_CFG_CAPTURE_EN == DEF_ENABLED)
+static  void  USBD_EP_CaptureRecPut (CPU_INT08U    dev_nbr,
+                                     CPU_INT08U    ep_addr,
+                                     CPU_INT08U    xfer_type,
+                                     CPU_BOOLEAN   cmpl,
+                                     CPU_INT08U    stage,
+                                     CPU_INT32U    irp_id,
+                                     CPU_INT32U    status,
+                                     CPU_INT08U   *p_data,
+                                     CPU_INT32U    data_len)
 {
-    CPU_BOOLEAN  ep_empty;
-    USBD_URB  *p_urb;
+    CPU_INT08U   hdr[USBD_CAPTURE_REC_HDR_LEN + USBD_CAPTURE_USBPCAP_HDR_LEN_MAX];
+    CPU_INT08U  *p_hdr;
+    CPU_INT16U   usbpcap_hdr_len;
+    CPU_INT32U   cap_len;
+    CPU_INT32U   rec_len;
+    CPU_INT32U   ts_sec;
+    CPU_INT32U   ts_us;
     CPU_SR_ALLOC();
 
 
-    CPU_CRITICAL_ENTER();
-    ep_empty = ((p_ep->URB_HeadPtr == (USBD_URB *)0) && (p_ep->URB_TailPtr == (USBD_URB *)0)) ? DEF_YES : DEF_NO;
+    switch (xfer_type) {
+        case USBD_CAPTURE_XFER_CTRL:
+             usbpcap_hdr_len = USBD_CAPTURE_USBPCAP_HDR_LEN + 1u;
+             break;
 
-#if (USBD_CFG_MAX_NBR_URB_EXTRA > 0u)
-                                                                /* Check if EP is empty, if enough URB rem or if main...*/
-                                                                /* ...URB avail.                                        */
-    if ((ep_empty                   == DEF_YES) ||
-        (USBD_URB_ExtraCtr[dev_nbr] <  USBD_CFG_MAX_NBR_URB_EXTRA) ||
-        (p_ep->URB_MainAvail        == DEF_YES)) {
-#else
-    if (ep_empty == DEF_YES) {                                  /* Check if EP is empty.                                */
-#endif
+        case USBD_CAPTURE_XFER_ISOC:
+             usbpcap_hdr_len = USBD_CAPTURE_USBPCAP_HDR_LEN + 24u;
+             break;
 
-        p_urb = USBD_URB_TblPtr[dev_nbr];
-        if (p_urb != (USBD_URB *)0) {
-            USBD_URB_TblPtr[dev_nbr] = p_urb->NextPtr;
+        default:
+             usbpcap_hdr_len = USBD_CAPTURE_USBPCAP_HDR_LEN;
+             break;
+    }
 
-            p_urb->NextPtr = (USBD_URB *)0;
-            p_urb->Flags   =  0u;
-#if (USBD_CFG_MAX_NBR_URB_EXTRA > 0u)
-            if ((ep_empty            == DEF_NO) &&
-                (p_ep->URB_MainAvail == DEF_NO)) {
-                                                                /* If the EP already has an URB in progress, inc ...    */
-                USBD_URB_ExtraCtr[dev_nbr]++;                   /* ... ctr and mark the URB as an 'extra' URB.          */
-                DEF_BIT_SET(p_urb->Flags, USBD_URB_FLAG_EXTRA_URB);
-            } else if (p_ep->URB_MainAvail == DEF_YES) {
-                p_ep->URB_MainAvail = DEF_NO;
-            }
-#endif
-           *p_err = USBD_ERR_NONE;
-        } else {
-           *p_err =  USBD_ERR_EP_QUEUING;
-            p_urb = (USBD_URB *)0;
-        }
+    cap_len = 0u;
+    if (p_data != (CPU_INT08U *)0) {
+        cap_len = DEF_MIN(data_len, USBD_CFG_CAPTURE_SNAP_LEN);
+    }
+    rec_len = USBD_CAPTURE_REC_HDR_LEN + usbpcap_hdr_len + cap_len;
+
+                                                                /* ------------- BUILD USBPCAP HDR (Note #1b) --------- */
+    p_hdr = &hdr[USBD_CAPTURE_REC_HDR_LEN];
+    MEM_VAL_SET_INT16U_LITTLE(&p_hdr[ 0u], usbpcap_hdr_len);
+    MEM_VAL_SET_INT32U_LITTLE(&p_hdr[ 2u], irp_id);
+    MEM_VAL_SET_INT32U_LITTLE(&p_hdr[ 6u], 0u);
+    MEM_VAL_SET_INT32U_LITTLE(&p_hdr[10u], status);
+    if (xfer_type == USBD_CAPTURE_XFER_CTRL) {
+        MEM_VAL_SET_INT16U_LITTLE(&p_hdr[14u], USBD_CAPTURE_FNCT_CTRL);
+    } else if (xfer_type == USBD_CAPTURE_XFER_ISOC) {
+        MEM_VAL_SET_INT16U_LITTLE(&p_hdr[14u], USBD_CAPTURE_FNCT_ISOC);
+    } else {
+        MEM_VAL_SET_INT16U_LITTLE(&p_hdr[14u], USBD_CAPTURE_FNCT_BULK);
+    }
+    p_hdr[16u] = (cmpl == DEF_YES) ? USBD_CAPTURE_INFO_CMPL : 0u;
+    MEM_VAL_SET_INT16U_LITTLE(&p_hdr[17u], 0u);                 /* See Note #2.                                         */
+    MEM_VAL_SET_INT16U_LITTLE(&p_hdr[19u], (CPU_INT16U)dev_nbr);
+    p_hdr[21u] = ep_addr;
+    p_hdr[22u] = xfer_type;
+    MEM_VAL_SET_INT32U_LITTLE(&p_hdr[23u], data_len);
+
+    if (xfer_type == USBD_CAPTURE_XFER_CTRL) {                  /* See Note #1c.                                        */
+        p_hdr[27u] = stage;
+    } else if (xfer_type == USBD_CAPTURE_XFER_ISOC) {
+        MEM_VAL_SET_INT32U_LITTLE(&p_hdr[27u], 0u);
+        MEM_VAL_SET_INT32U_LITTLE(&p_hdr[31u], 1u);
+        MEM_VAL_SET_INT32U_LITTLE(&p_hdr[35u], (status == USBD_CAPTURE_STATUS_SUCCESS) ? 0u : 1u);
+        MEM_VAL_SET_INT32U_LITTLE(&p_hdr[39u], 0u);
+        MEM_VAL_SET_INT32U_LITTLE(&p_hdr[43u], data_len);
+        MEM_VAL_SET_INT32U_LITTLE(&p_hdr[47u], status);
     } else {
+        ;
+    }
+
+    CPU_CRITICAL_ENTER();
+    if (USBD_Capture.En == DEF_DISABLED) {
+        CPU_CRITICAL_EXIT();
+        return;
+    }
 
-       *p_err =  USBD_ERR_EP_QUEUING;
-        p_urb = (USBD_URB *)0;
+    if (rec_len > (USBD_CFG_CAPTURE_BUF_LEN - USBD_Capture.Cnt)) {
+        USBD_Capture.DropCnt++;                                 /* See Note #4.                                         */
+        CPU_CRITICAL_EXIT();
+        return;
     }
-    CPU_CRITICAL_EXIT();
 
-    return (p_urb);
+    USBD_EP_CaptureTsGet(&ts_sec, &ts_us);                      /* See Note #3.                                         */
+                                                                /* ------------- BUILD PCAP REC HDR (Note #1a) -------- */
+    MEM_VAL_SET_INT32U_LITTLE(&hdr[ 0u], ts_sec);
+    MEM_VAL_SET_INT32U_LITTLE(&hdr[ 4u], ts_us);
+    MEM_VAL_SET_INT32U_LITTLE(&hdr[ 8u], usbpcap_hdr_len + cap_len);
+    MEM_VAL_SET_INT32U_LITTLE(&hdr[12u], usbpcap_hdr_len + data_len);
+
+    USBD_EP_CaptureCopy(&hdr[0u], USBD_CAPTURE_REC_HDR_LEN + usbpcap_hdr_len);
+    if (cap_len > 0u) {
+        USBD_EP_CaptureCopy(p_data, cap_len);
+    }
+    USBD_Capture.Cnt += rec_len;
+    CPU_CRITICAL_EXIT();
 }
+#endif
 
 
 /*
 *********************************************************************************************************
-*                                          USBD_URB_Queue()
+*                                        USBD_EP_CaptureCopy()
 *
-* Description : Queue USB request block into endpoint.
+* Description : Copy data at the write index of the capture ring.
 *
-* Argument(s) : p_ep        Pointer to endpoint structure.
-*               ----        Argument checked by caller.
+* Argument(s) : p_src       Pointer to data.
 *
-*               p_urb       Pointer to USB request block.
-*               -----       Argument checked by caller.
+*               len         Data length, in octets.
 *
 * Return(s)   : none.
 *
-* Note(s)     : (1) Endpoint must be locked when calling this function.
+* Note(s)     : (1) This function MUST be called within a critical section, with enough free space in the
+*                   ring. The caller accounts for the data copied.
 *********************************************************************************************************
 */
 
-static  void  USBD_URB_Queue (USBD_EP   *p_ep,
-                              USBD_URB  *p_urb)
+#if (USBD_CFG_CAPTURE_EN == DEF_ENABLED)
+static  void  USBD_EP_CaptureCopy (CPU_INT08U  *p_src,
+                                   CPU_INT32U   len)
 {
-    p_urb->NextPtr = (USBD_URB *)0;
+    CPU_INT32U  copy_len;
 
 
-    if (p_ep->URB_TailPtr == (USBD_URB *)0) {                   /* Q is empty.                                          */
-        p_ep->URB_HeadPtr = p_urb;
-        p_ep->URB_TailPtr = p_urb;
-    } else {                                                    /* Q is not empty.                                      */
-        p_ep->URB_TailPtr->NextPtr = p_urb;
-        p_ep->URB_TailPtr          = p_urb;
+    copy_len = DEF_MIN(len, USBD_CFG_CAPTURE_BUF_LEN - USBD_Capture.IxIn);
+    Mem_Copy((void     *)&USBD_Capture.BufTbl[USBD_Capture.IxIn],
+             (void     *)&p_src[0u],
+             (CPU_SIZE_T) copy_len);
+    if (copy_len < len) {                                       /* Wrap around end of ring.                             */
+        Mem_Copy((void     *)&USBD_Capture.BufTbl[0u],
+                 (void     *)&p_src[copy_len],
+                 (CPU_SIZE_T)(len - copy_len));
     }
 
-    return;
+    USBD_Capture.IxIn = (USBD_Capture.IxIn + len) % USBD_CFG_CAPTURE_BUF_LEN;
 }
+#endif
 
 
 /*
 *********************************************************************************************************
-*                                         USBD_URB_Dequeue()
+*                                       USBD_EP_CaptureTsGet()
 *
-* Description : Dequeue head USB request block from endpoint.
+* Description : Get the capture timestamp of the current record.
 *
-* Argument(s) : p_ep        Pointer to endpoint structure.
-*               ----        Argument checked by caller.
+* Argument(s) : p_sec       Pointer to variable that will receive the seconds.
+*
+*               p_us        Pointer to variable that will receive the microseconds.
 *
 * Return(s)   : none.
 *
-* Note(s)     : (1) Endpoint must be locked when calling this function.
+* Note(s)     : (1) This function MUST be called within a critical section.
+*
+*               (2) The CPU timestamp is converted into a running time base, so that the capture time does
+*                   not wrap around with the 32-bit timestamp (see 'usbd_core.h  TRAFFIC CAPTURE  Note #4').
 *********************************************************************************************************
 */
 
-static  void  USBD_URB_Dequeue (USBD_EP  *p_ep)
+#if (USBD_CFG_CAPTURE_EN == DEF_ENABLED)
+static  void  USBD_EP_CaptureTsGet (CPU_INT32U  *p_sec,
+                                    CPU_INT32U  *p_us)
 {
-    USBD_URB  *p_urb;
-
-
-    p_urb = p_ep->URB_HeadPtr;
-    if (p_urb == (USBD_URB *)0) {
-        return;
-    }
-
-    if (p_urb->NextPtr == (USBD_URB *)0) {                      /* Only one URB is queued.                              */
-        p_ep->URB_HeadPtr = (USBD_URB *)0;
-        p_ep->URB_TailPtr = (USBD_URB *)0;
-        p_ep->XferState   =  USBD_XFER_STATE_NONE;
-    } else {
-        p_ep->URB_HeadPtr = p_urb->NextPtr;
+#if (CPU_CFG_TS_TMR_EN == DEF_ENABLED)
+    CPU_TS32    ts;
+    CPU_INT64U  ticks;
+    CPU_ERR     err;
+
+
+    if (USBD_Capture.TsFreq == 0u) {                            /* Get TS clk freq on first use.                        */
+        USBD_Capture.TsFreq = (CPU_INT32U)CPU_TS_TmrFreqGet(&err);
+        USBD_Capture.TsPrev =  CPU_TS_Get32();
+        if (USBD_Capture.TsFreq == 0u) {
+           *p_sec = 0u;
+           *p_us  = 0u;
+            return;
+        }
     }
-}
 
+    ts                   = CPU_TS_Get32();                      /* See Note #2.                                         */
+    ticks                = (CPU_INT64U)USBD_Capture.TsRem + (CPU_TS32)(ts - USBD_Capture.TsPrev);
+    USBD_Capture.TsPrev  =  ts;
+    USBD_Capture.TsSec  += (CPU_INT32U)(ticks / USBD_Capture.TsFreq);
+    USBD_Capture.TsRem   = (CPU_INT32U)(ticks % USBD_Capture.TsFreq);
 
+   *p_sec = USBD_Capture.TsSec;
+   *p_us  = (CPU_INT32U)(((CPU_INT64U)USBD_Capture.TsRem * 1000000u) / USBD_Capture.TsFreq);
+#else
+   *p_sec = 0u;
+   *p_us  = 0u;
+#endif
+}
+#endif
@@ -85,14 +85,16 @@
                                                                 /* ------------ DEVICE INTERNAL FUNCTIONS  ------------ */
 USBD_DRV  *USBD_DrvRefGet          (CPU_INT08U   dev_nbr);
 
-void       USBD_CoreTaskHandler    (void);
+void       USBD_CoreTaskHandler    (CPU_INT08U   task_ix);
 
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 void       USBD_DbgTaskHandler     (void);
+#endif
 
                                                                 /* ------------ ENDPOINT INTERNAL FUNCTIONS ----------- */
 void       USBD_EP_Init            (void);
 
-void       USBD_EventEP            (USBD_DRV    *p_drv,
+CPU_BOOLEAN  USBD_EventEP          (USBD_DRV    *p_drv,
                                     CPU_INT08U   ep_addr,
                                     USBD_ERR     err);
 
@@ -129,6 +131,11 @@ void       USBD_EP_XferAsyncProcess(USBD_DRV    *p_drv,
                                     CPU_INT08U   ep_addr,
                                     USBD_ERR     xfer_err);
 
+#if (USBD_CFG_CAPTURE_EN == DEF_ENABLED)
+void       USBD_EP_CaptureSetup    (CPU_INT08U   dev_nbr,
+                                    CPU_INT08U  *p_setup);
+#endif
+
 
 /*
 *********************************************************************************************************
@@ -174,13 +181,17 @@ void   USBD_OS_EP_LockAcquire (CPU_INT08U   dev_nbr,
 void   USBD_OS_EP_LockRelease (CPU_INT08U   dev_nbr,
                                CPU_INT08U   ep_ix);
 
+#if (USBD_DBG_TRACE_TASK_EN == DEF_ENABLED)
 void   USBD_OS_DbgEventRdy    (void);
 void   USBD_OS_DbgEventWait   (void);
+#endif
 
-void  *USBD_OS_CoreEventGet   (CPU_INT32U   timeout_ms,
+void  *USBD_OS_CoreEventGet   (CPU_INT08U   task_ix,
+                               CPU_INT32U   timeout_ms,
                                USBD_ERR    *p_err);
 
-void   USBD_OS_CoreEventPut   (void        *p_event);
+void   USBD_OS_CoreEventPut   (CPU_INT08U   task_ix,
+                               void        *p_event);
 
 
 /*